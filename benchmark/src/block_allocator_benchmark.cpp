@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+#include <jiffy/storage/block_memory_manager.h>
+#include <jiffy/utils/logger.h>
+#include <jiffy/utils/time_utils.h>
+
+using namespace ::jiffy::storage;
+using namespace ::jiffy::utils;
+
+/**
+ * @brief Allocate and free objects from a block, keeping a window of live objects per thread
+ * @return Allocations per second over all threads
+ */
+static double allocation_throughput(const std::string &allocator,
+                                    size_t num_threads,
+                                    size_t min_size,
+                                    size_t max_size,
+                                    size_t num_ops,
+                                    size_t window) {
+  block_memory_manager manager(static_cast<size_t>(1) << 34, "DRAM", nullptr, allocator);
+  std::vector<std::thread> workers;
+  auto start = time_utils::now_us();
+  for (size_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&manager, t, min_size, max_size, num_ops, window] {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<size_t> dist(min_size, max_size);
+      std::vector<std::pair<void *, size_t>> live(window, {nullptr, 0});
+      for (size_t i = 0; i < num_ops; ++i) {
+        auto &slot = live[gen() % window];
+        if (slot.first != nullptr) {
+          manager.mb_free(slot.first, slot.second);
+        }
+        slot.second = dist(gen);
+        slot.first = manager.mb_malloc(slot.second);
+      }
+      for (auto &slot : live) {
+        if (slot.first != nullptr) {
+          manager.mb_free(slot.first, slot.second);
+        }
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+  auto elapsed = time_utils::now_us() - start;
+  if (manager.mb_used() != 0) {
+    LOG(log_level::error) << allocator << " leaked " << manager.mb_used() << " bytes";
+  }
+  return static_cast<double>(num_threads * num_ops) * 1E6 / elapsed;
+}
+
+int main() {
+  size_t num_ops = 1000000;
+  size_t window = 65536;
+  std::vector<size_t> thread_counts = {1, 2, 4, 8};
+  std::vector<std::pair<size_t, size_t>> size_ranges = {{8, 64}, {64, 512}, {512, 4096}};
+  LOG(log_level::info) << "num-ops: " << num_ops << " per thread";
+  LOG(log_level::info) << "window: " << window << " live objects per thread";
+
+  for (const auto &range : size_ranges) {
+    LOG(log_level::info) << "===== " << range.first << "-" << range.second << "B objects ======";
+    for (auto num_threads : thread_counts) {
+      auto heap = allocation_throughput("default", num_threads, range.first, range.second, num_ops, window);
+      auto slab = allocation_throughput("slab", num_threads, range.first, range.second, num_ops, window);
+      LOG(log_level::info) << "\t" << num_threads << " threads: heap manager " << heap / 1E6 << " Mops/s, slab "
+                           << slab / 1E6 << " Mops/s (" << slab / heap << "x)";
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,138 @@
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <jiffy/storage/block_memory_manager.h>
+#include <jiffy/storage/block_memory_allocator.h>
+#include <jiffy/storage/file/file_block.h>
+#include <jiffy/storage/fifoqueue/string_array.h>
+#include <jiffy/utils/logger.h>
+#include <jiffy/utils/time_utils.h>
+
+using namespace ::jiffy::storage;
+using namespace ::jiffy::utils;
+
+/**
+ * @brief Counter of data TLB read misses of the calling thread, if the kernel permits it
+ */
+class tlb_miss_counter {
+ public:
+  tlb_miss_counter() {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  ~tlb_miss_counter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  void start() {
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  /**
+   * @brief Stop counting
+   * @return Number of misses since start(), -1 if the counter is not available
+   */
+  long long stop() {
+    if (fd_ < 0) {
+      return -1;
+    }
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    long long count = 0;
+    if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+      return -1;
+    }
+    return count;
+  }
+
+ private:
+  int fd_;
+};
+
+/**
+ * @brief Run reads at the given offsets, logging latency and TLB misses per read
+ */
+template<typename F>
+static void measure(const std::string &name, const std::vector<std::size_t> &offsets, F &&f) {
+  tlb_miss_counter counter;
+  std::size_t checksum = 0;
+  counter.start();
+  auto start = time_utils::now_us();
+  for (auto offset : offsets) {
+    checksum += f(offset);
+  }
+  auto elapsed = time_utils::now_us() - start;
+  auto misses = counter.stop();
+  LOG(log_level::info) << "\t" << name << ": " << elapsed * 1E3 / offsets.size() << " ns/read, "
+                       << (misses < 0 ? std::string("n/a") : std::to_string(static_cast<double>(misses) / offsets.size()))
+                       << " dTLB misses/read (checksum " << checksum << ")";
+}
+
+int main(int argc, char **argv) {
+  std::size_t capacity = argc > 1 ? std::stoull(argv[1]) : 134217728;
+  std::size_t num_reads = 10000000;
+  std::size_t item_size = 100;
+  LOG(log_level::info) << "capacity: " << capacity;
+  LOG(log_level::info) << "num-reads: " << num_reads;
+
+  for (const auto &huge_pages : {"none", "transparent", "explicit"}) {
+    LOG(log_level::info) << "===== huge pages: " << huge_pages << " ======";
+    std::mt19937_64 gen(0);
+    {
+      // Random 64B reads over a file block written in full
+      block_memory_manager manager(capacity, "DRAM", nullptr, "default", huge_pages);
+      file_block file(capacity, block_memory_allocator<char>(&manager));
+      std::string chunk(4096, 'x');
+      for (std::size_t offset = 0; offset + chunk.size() <= capacity; offset += chunk.size()) {
+        file.write(chunk, offset);
+      }
+      std::vector<std::size_t> offsets(num_reads);
+      for (auto &offset : offsets) {
+        offset = gen() % (capacity - 64);
+      }
+      measure("file_block read", offsets, [&](std::size_t offset) {
+        return static_cast<std::size_t>(file.read_span(offset, 64).second.data[0]);
+      });
+    }
+    {
+      // Random element reads over a full fifo queue block
+      block_memory_manager manager(capacity, "DRAM", nullptr, "default", huge_pages);
+      string_array queue(capacity, block_memory_allocator<char>(&manager));
+      std::string item(item_size, 'x');
+      std::vector<std::size_t> elements;
+      while (true) {
+        auto offset = queue.size();
+        if (!queue.push_back(item).first) {
+          break;
+        }
+        elements.push_back(offset);
+      }
+      std::vector<std::size_t> offsets(num_reads);
+      for (auto &offset : offsets) {
+        offset = elements[gen() % elements.size()];
+      }
+      measure("string_array at", offsets, [&](std::size_t offset) {
+        return queue.at_span(offset).second.size;
+      });
+    }
+  }
+  return 0;
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 #include <thread>
 #include <boost/program_options.hpp>
@@ -28,7 +29,8 @@ class hash_table_benchmark {
         clients_(clients),
         workers_(num_clients),
         throughput_(num_clients),
-        latency_(num_clients) {
+        latency_(num_clients),
+        latencies_(num_clients) {
   }
 
   virtual ~hash_table_benchmark() = default;
@@ -47,6 +49,19 @@ class hash_table_benchmark {
     return std::make_pair(throughput, latency / num_clients_);
   }
 
+  double p99() {
+    std::vector<uint64_t> latencies;
+    for (const auto &l : latencies_) {
+      latencies.insert(latencies.end(), l.begin(), l.end());
+    }
+    if (latencies.empty()) {
+      return 0;
+    }
+    auto it = latencies.begin() + static_cast<std::ptrdiff_t>(latencies.size() * 99 / 100);
+    std::nth_element(latencies.begin(), it, latencies.end());
+    return (double) *it;
+  }
+
  protected:
   std::string data_;
   size_t num_clients_;
@@ -55,6 +70,7 @@ class hash_table_benchmark {
   std::vector<std::thread> workers_;
   std::vector<double> throughput_;
   std::vector<double> latency_;
+  std::vector<std::vector<uint64_t>> latencies_;
 };
 
 class put_benchmark : public hash_table_benchmark {
@@ -68,6 +84,7 @@ class put_benchmark : public hash_table_benchmark {
   void run() override {
     for (size_t i = 0; i < num_clients_; ++i) {
       workers_[i] = std::thread([i, this]() {
+        latencies_[i].reserve(num_ops_);
         auto bench_begin = time_utils::now_us();
         uint64_t tot_time = 0, t0, t1 = bench_begin;
         size_t j;
@@ -76,6 +93,7 @@ class put_benchmark : public hash_table_benchmark {
           clients_[i]->put(std::to_string(j) + "_" + std::to_string(i), data_);
           t1 = time_utils::now_us();
           tot_time += (t1 - t0);
+          latencies_[i].push_back(t1 - t0);
         }
         latency_[i] = (double) tot_time / (double) j;
         throughput_[i] = j * 1E6 / (t1 - bench_begin);
@@ -98,6 +116,7 @@ class get_benchmark : public hash_table_benchmark {
         for (size_t j = 0; j < num_ops_; ++j) {
           clients_[i]->put(std::to_string(j) + "_" + std::to_string(i), data_);
         }
+        latencies_[i].reserve(num_ops_);
         auto bench_begin = time_utils::now_us();
         uint64_t tot_time = 0, t0, t1 = bench_begin;
         size_t j;
@@ -106,6 +125,7 @@ class get_benchmark : public hash_table_benchmark {
           clients_[i]->get(std::to_string(j) + "_" + std::to_string(i));
           t1 = time_utils::now_us();
           tot_time += (t1 - t0);
+          latencies_[i].push_back(t1 - t0);
         }
         latency_[i] = (double) tot_time / (double) j;
         throughput_[i] = (double) j * 1E6 / (double) (t1 - bench_begin);
@@ -128,6 +148,7 @@ class remove_benchmark : public hash_table_benchmark {
         for (size_t j = 0; j < num_ops_; ++j) {
           clients_[i]->put(std::to_string(j) + "_" + std::to_string(i), data_);
         }
+        latencies_[i].reserve(num_ops_);
         auto bench_begin = time_utils::now_us();
         uint64_t tot_time = 0, t0, t1 = bench_begin;
         size_t j;
@@ -136,6 +157,7 @@ class remove_benchmark : public hash_table_benchmark {
           clients_[i]->remove(std::to_string(j) + "_" + std::to_string(i));
           t1 = time_utils::now_us();
           tot_time += (t1 - t0);
+          latencies_[i].push_back(t1 - t0);
         }
         latency_[i] = (double) tot_time / (double) j;
         throughput_[i] = (double) j * 1E6 / (double) (t1 - bench_begin);
@@ -193,14 +215,16 @@ int main() {
       }
       benchmark->run();
       auto result = benchmark->wait();
+      auto p99 = benchmark->p99();
       client.remove(path);
-      LOG(log_level::info) << op_type << " " << num_clients << " " << result.second << " " << result.first;
+      LOG(log_level::info) << op_type << " " << num_clients << " " << result.second << " " << p99 << " " << result.first;
       LOG(log_level::info) << "===== " << op_type << " ======";
       LOG(log_level::info) << "\t" << num_ops << " requests completed in " << ((double) num_ops / result.first)
                            << " us";
       LOG(log_level::info) << "\t" << num_clients << " parallel clients";
       LOG(log_level::info) << "\t" << data_size << " payload";
       LOG(log_level::info) << "\tAverage latency: " << result.second;
+      LOG(log_level::info) << "\tp99 latency: " << p99;
       LOG(log_level::info) << "\tThroughput: " << result.first << " requests per microsecond";
     }
   }
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <vector>
+#include <random>
+#include <string>
+#include <jiffy/storage/hashtable/hash_slot.h>
+#include <jiffy/utils/hash_utils.h>
+#include <jiffy/utils/logger.h>
+#include <jiffy/utils/time_utils.h>
+
+using namespace ::jiffy::storage;
+using namespace ::jiffy::utils;
+
+/* Hash function used by the hash table index before hash_utils::hash64 */
+static std::size_t byte_loop_hash(const char *buf, std::size_t len) {
+  std::size_t result = 0;
+  for (size_t i = 0; i < len; i++) {
+    result = static_cast<uint8_t>(buf[i]) + (result * 31);
+  }
+  return result;
+}
+
+template<typename F>
+static double ns_per_key(const std::vector<std::string> &keys, size_t num_rounds, F &&f) {
+  uint64_t sink = 0;
+  auto start = time_utils::now_ns();
+  for (size_t r = 0; r < num_rounds; ++r) {
+    for (const auto &key : keys) {
+      sink += f(key.data(), key.size());
+    }
+  }
+  auto elapsed = time_utils::now_ns() - start;
+  // Keep the compiler from discarding the hash computations
+  if (sink == 42) LOG(log_level::trace) << sink;
+  return static_cast<double>(elapsed) / (num_rounds * keys.size());
+}
+
+int main() {
+  size_t num_keys = 4096;
+  size_t total_bytes = 64 * 1024 * 1024;
+  std::vector<size_t> key_sizes = {16, 32, 64, 128, 256, 512, 1024};
+  LOG(log_level::info) << "num-keys: " << num_keys;
+  LOG(log_level::info) << "clmul-supported: " << hash_slot::clmul_supported();
+
+  std::mt19937 gen(0);
+  for (auto key_size : key_sizes) {
+    std::vector<std::string> keys(num_keys);
+    for (auto &key : keys) {
+      key.resize(key_size);
+      for (auto &c : key) c = static_cast<char>(gen());
+    }
+    size_t num_rounds = std::max<size_t>(1, total_bytes / (num_keys * key_size));
+
+    LOG(log_level::info) << "===== " << key_size << "B keys ======";
+    LOG(log_level::info) << "\tbyte loop hash: " << ns_per_key(keys, num_rounds, byte_loop_hash) << " ns/key";
+    LOG(log_level::info) << "\thash64: " << ns_per_key(keys, num_rounds, [](const char *buf, size_t len) {
+      return hash_utils::hash64(buf, len);
+    }) << " ns/key";
+    LOG(log_level::info) << "\tcrc16 bytewise: " << ns_per_key(keys, num_rounds, hash_slot::crc16_bytewise)
+                         << " ns/key";
+    LOG(log_level::info) << "\tcrc16 slice8: " << ns_per_key(keys, num_rounds, hash_slot::crc16_slice8)
+                         << " ns/key";
+    if (hash_slot::clmul_supported()) {
+      LOG(log_level::info) << "\tcrc16 clmul: " << ns_per_key(keys, num_rounds, hash_slot::crc16_clmul)
+                           << " ns/key";
+    }
+    LOG(log_level::info) << "\tcrc16 dispatched: " << ns_per_key(keys, num_rounds, hash_slot::crc16) << " ns/key";
+  }
+  return 0;
+}
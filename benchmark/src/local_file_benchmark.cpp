@@ -0,0 +1,139 @@
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include <jiffy/storage/file/local_file.h>
+#include <jiffy/utils/logger.h>
+#include <jiffy/utils/time_utils.h>
+
+using namespace ::jiffy::persistent;
+using namespace ::jiffy::storage;
+using namespace ::jiffy::utils;
+
+/* file_partition::write_ls before local_file: a new stream per call */
+static void stream_write(const std::string &path, std::size_t offset, const std::string &data) {
+  std::ofstream out(path, std::ios::in | std::ios::out);
+  out.seekp(offset, std::ios::beg);
+  out << data;
+  out.close();
+}
+
+/* file_partition::read_ls before local_file: a new stream and a temporary buffer per call */
+static std::string stream_read(const std::string &path, std::size_t offset, std::size_t size) {
+  std::ifstream in(path, std::ios::in);
+  in.seekg(0, std::ios::end);
+  in.seekg(offset, std::ios::beg);
+  char *ret = new char[size];
+  in.read(ret, size);
+  std::string ret_str(ret, size);
+  delete[] ret;
+  return ret_str;
+}
+
+/**
+ * @brief Run operations at the given offsets
+ * @return Throughput in MB per second
+ */
+template<typename F>
+static double throughput(const std::vector<std::size_t> &offsets, std::size_t io_size, F &&f) {
+  auto start = time_utils::now_us();
+  for (auto offset : offsets) {
+    f(offset);
+  }
+  auto elapsed = time_utils::now_us() - start;
+  return static_cast<double>(offsets.size() * io_size) / elapsed;
+}
+
+/**
+ * @brief Issue reads without waiting for each one, keeping a number of them queued
+ * @param file Local file
+ * @param path File path
+ * @param offsets Read offsets
+ * @param io_size Read size
+ * @param depth Maximum number of queued reads
+ */
+static void async_reads(local_file &file, const std::string &path, const std::vector<std::size_t> &offsets,
+                        std::size_t io_size, std::size_t depth) {
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::size_t queued = 0;
+  for (auto offset : offsets) {
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv.wait(lock, [&] { return queued < depth; });
+      ++queued;
+    }
+    file.read(path, offset, io_size, [&](int, std::string &) {
+      std::lock_guard<std::mutex> lock(mtx);
+      --queued;
+      cv.notify_one();
+    });
+  }
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock, [&] { return queued == 0; });
+}
+
+int main(int argc, char **argv) {
+  std::string path = argc > 1 ? argv[1] : "/tmp/local_file_bench";
+  std::size_t file_size = static_cast<std::size_t>(1) << 30;
+  LOG(log_level::info) << "path: " << path;
+  LOG(log_level::info) << "file-size: " << file_size;
+  {
+    std::ofstream out(path, std::ios::binary);
+    std::string chunk(1 << 20, 'x');
+    for (std::size_t written = 0; written < file_size; written += chunk.size()) {
+      out.write(chunk.data(), chunk.size());
+    }
+  }
+
+  std::mt19937_64 gen(0);
+  // Random 4KB at 4KB aligned offsets, and sequential 1MB over the whole file
+  std::vector<std::pair<std::string, std::pair<std::size_t, std::vector<std::size_t>>>> workloads;
+  std::vector<std::size_t> random_offsets(100000);
+  for (auto &offset : random_offsets) {
+    offset = (gen() % (file_size / 4096)) * 4096;
+  }
+  workloads.push_back({"random 4KB", {4096, random_offsets}});
+  std::vector<std::size_t> sequential_offsets;
+  for (std::size_t offset = 0; offset < file_size; offset += 1 << 20) {
+    sequential_offsets.push_back(offset);
+  }
+  workloads.push_back({"sequential 1MB", {1 << 20, sequential_offsets}});
+
+  for (const auto &workload : workloads) {
+    auto io_size = workload.second.first;
+    const auto &offsets = workload.second.second;
+    std::string data(io_size, 'y');
+    std::string read_data;
+    LOG(log_level::info) << "===== " << workload.first << " ======";
+    LOG(log_level::info) << "\tstream write: " << throughput(offsets, io_size, [&](std::size_t offset) {
+      stream_write(path, offset, data);
+    }) << " MB/s";
+    LOG(log_level::info) << "\tstream read: " << throughput(offsets, io_size, [&](std::size_t offset) {
+      read_data = stream_read(path, offset, io_size);
+    }) << " MB/s";
+    for (const auto &engine_name : {"thread_pool", "io_uring"}) {
+      auto engine = io_engine::create(engine_name);
+      local_file file(engine);
+      std::string name = "local_file[" + engine->name() + "]";
+      LOG(log_level::info) << "\t" << name << " write: " << throughput(offsets, io_size, [&](std::size_t offset) {
+        file.write(path, offset, data);
+      }) << " MB/s";
+      LOG(log_level::info) << "\t" << name << " read: " << throughput(offsets, io_size, [&](std::size_t offset) {
+        file.read(path, offset, io_size, read_data);
+      }) << " MB/s";
+      auto start = time_utils::now_us();
+      async_reads(file, path, offsets, io_size, 64);
+      auto elapsed = time_utils::now_us() - start;
+      LOG(log_level::info) << "\t" << name << " async read (64 queued): "
+                           << static_cast<double>(offsets.size() * io_size) / elapsed << " MB/s";
+      file.close();
+    }
+  }
+  std::remove(path.c_str());
+  return 0;
+}
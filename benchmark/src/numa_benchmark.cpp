@@ -0,0 +1,70 @@
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <jiffy/storage/block_memory_manager.h>
+#include <jiffy/storage/block_memory_allocator.h>
+#include <jiffy/storage/file/file_block.h>
+#include <jiffy/utils/logger.h>
+#include <jiffy/utils/numa_utils.h>
+#include <jiffy/utils/time_utils.h>
+
+using namespace ::jiffy::storage;
+using namespace ::jiffy::utils;
+
+/**
+ * @brief Fill a file block whose memory prefers one NUMA node, then read it from a thread pinned to
+ * another node, logging latency of random reads and bandwidth of a sequential scan
+ */
+static void run(int cpu_node, int mem_node, std::size_t capacity, std::size_t num_reads) {
+  if (numa_utils::set_self_node_affinity(cpu_node) != 0) {
+    LOG(log_level::warn) << "Could not pin to NUMA node " << cpu_node;
+  }
+  block_memory_manager manager(capacity, "DRAM", nullptr, "default", "none", mem_node);
+  file_block file(capacity, block_memory_allocator<char>(&manager));
+  std::string chunk(4096, 'x');
+  for (std::size_t offset = 0; offset + chunk.size() <= capacity; offset += chunk.size()) {
+    file.write(chunk, offset);
+  }
+
+  std::mt19937_64 gen(0);
+  std::vector<std::size_t> offsets(num_reads);
+  for (auto &offset : offsets) {
+    offset = gen() % (capacity - 64);
+  }
+  std::size_t checksum = 0;
+  auto start = time_utils::now_us();
+  for (auto offset : offsets) {
+    checksum += static_cast<std::size_t>(file.read_span(offset, 64).second.data[0]);
+  }
+  auto random_us = time_utils::now_us() - start;
+
+  start = time_utils::now_us();
+  auto data = reinterpret_cast<const std::uint64_t *>(file.data());
+  for (std::size_t i = 0; i < capacity / sizeof(std::uint64_t); ++i) {
+    checksum += data[i];
+  }
+  auto scan_us = time_utils::now_us() - start;
+
+  LOG(log_level::info) << "\tcpu node " << cpu_node << ", memory node " << mem_node << ": "
+                       << random_us * 1E3 / num_reads << " ns/read, "
+                       << capacity / (1024.0 * 1024.0) / (scan_us / 1E6) << " MB/s scan (checksum " << checksum << ")";
+}
+
+int main(int argc, char **argv) {
+  std::size_t capacity = argc > 1 ? std::stoull(argv[1]) : 134217728;
+  std::size_t num_reads = 10000000;
+  auto nodes = numa_utils::nodes();
+  LOG(log_level::info) << "capacity: " << capacity;
+  LOG(log_level::info) << "num-reads: " << num_reads;
+  LOG(log_level::info) << "numa-nodes: " << nodes.size();
+
+  for (auto cpu_node : nodes) {
+    for (auto mem_node : nodes) {
+      // Run on a fresh thread, so that pinning does not leak into the next run
+      std::thread t(run, cpu_node, mem_node, capacity, num_reads);
+      t.join();
+    }
+  }
+  return 0;
+}
@@ -10,6 +10,8 @@ option(BUILD_PYTHON_CLIENT "Build Python Client" ON)
 option(BUILD_JAVA_CLIENT "Build Java Client" ON)
 option(BUILD_MEMKIND_SUPPORT "Build support for memkind" ON)
 option(BUILD_S3_SUPPORT "Build support for S3 as external store" OFF)
+option(BUILD_IO_URING_SUPPORT "Build support for io_uring asynchronous I/O" ON)
+option(BUILD_COMPRESSION_SUPPORT "Build support for LZ4/Zstd compressed persistence" ON)
 option(USE_SYSTEM_BOOST "Use system boost libraries" ON)
 option(USE_SYSTEM_THRIFT "Use system thrift library" ON)
 option(USE_SYSTEM_AWSSDK "Use system AWS SDK" ON)
@@ -19,12 +21,15 @@ option(USE_SYSTEM_CURL "Use system Curl" ON)
 option(USE_SYSTEM_LIBEVENT "Use system libevent" ON)
 option(USE_SYSTEM_OPENSSL "Use system OpenSSL" ON)
 option(USE_SYSTEM_ZLIB "Use system Zlib" ON)
+option(USE_SYSTEM_LZ4 "Use system LZ4" ON)
+option(USE_SYSTEM_ZSTD "Use system Zstd" ON)
 option(BUILD_BENCHMARKS "Build benchmarks" OFF)
 option(GENERATE_THRIFT "Generate thrift files" OFF)
 
 # Exception for Darwin
 if (${CMAKE_SYSTEM_NAME} MATCHES "Darwin")
   set(BUILD_MEMKIND_SUPPORT "OFF")
+  set(BUILD_IO_URING_SUPPORT "OFF")
 endif()
 
 message(STATUS "----------------------------------------------------------")
@@ -37,6 +42,8 @@ message(STATUS "  Build Python client:                    ${BUILD_PYTHON_CLIENT}
 message(STATUS "  Build Java client:                      ${BUILD_JAVA_CLIENT}")
 message(STATUS "  Build memkind support:                  ${BUILD_MEMKIND_SUPPORT}")
 message(STATUS "  Build S3 support:                       ${BUILD_S3_SUPPORT}")
+message(STATUS "  Build io_uring support:                 ${BUILD_IO_URING_SUPPORT}")
+message(STATUS "  Build compression support:              ${BUILD_COMPRESSION_SUPPORT}")
 message(STATUS "  Build benchmarks:                       ${BUILD_BENCHMARKS}")
 message(STATUS "  Build unit tests:                       ${BUILD_TESTS}")
 message(STATUS "  Build documentation:                    ${BUILD_DOC}")
@@ -48,5 +55,7 @@ message(STATUS "  Use system Curl:                        ${USE_SYSTEM_CURL}")
 message(STATUS "  Use system libevent:                    ${USE_SYSTEM_LIBEVENT}")
 message(STATUS "  Use system OpenSSL:                     ${USE_SYSTEM_OPENSSL}")
 message(STATUS "  Use system Zlib:                        ${USE_SYSTEM_ZLIB}")
+message(STATUS "  Use system LZ4:                         ${USE_SYSTEM_LZ4}")
+message(STATUS "  Use system Zstd:                        ${USE_SYSTEM_ZSTD}")
 message(STATUS "  Generate thrift files:                  ${GENERATE_THRIFT}")
 message(STATUS "----------------------------------------------------------")
@@ -47,6 +47,26 @@ else()
   set(HEAP_MANAGER_LIBRARY ${JEMALLOC_LIBRARY})
 endif ()
 
+# io_uring, used through the kernel interface directly
+if (BUILD_IO_URING_SUPPORT)
+  include(CheckIncludeFile)
+  check_include_file(linux/io_uring.h HAVE_LINUX_IO_URING_H)
+  if (HAVE_LINUX_IO_URING_H)
+    add_definitions(-DIO_URING_IN_USE)
+  else ()
+    message(STATUS "linux/io_uring.h not found, disk I/O uses the thread pool engine")
+  endif ()
+endif ()
+
+# LZ4 and Zstd, for compressed persistence formats
+if (BUILD_COMPRESSION_SUPPORT)
+  include(Lz4External)
+  include(ZstdExternal)
+  add_definitions(-DCOMPRESSION_IN_USE)
+  set(COMPRESSION_EP lz4_ep zstd_ep)
+  set(COMPRESSION_LIBRARY ${LZ4_LIBRARY} ${ZSTD_LIBRARY})
+endif ()
+
 # If testing is enabled
 if (BUILD_TESTS)
 	# Catch2
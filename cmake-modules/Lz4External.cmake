@@ -0,0 +1,50 @@
+# LZ4 external project
+# target:
+#  - lz4_ep
+# defines:
+#  - LZ4_HOME
+#  - LZ4_INCLUDE_DIR
+#  - LZ4_LIBRARY
+
+set(LZ4_VERSION "1.9.2")
+set(LZ4_BUILD ON)
+
+if (DEFINED ENV{LZ4_ROOT} AND EXISTS $ENV{LZ4_ROOT})
+  set(LZ4_ROOT_DIR "$ENV{LZ4_ROOT}")
+  set(USE_SYSTEM_LZ4 ON)
+endif ()
+
+if (USE_SYSTEM_LZ4)
+  find_path(LZ4_INCLUDE_DIR lz4.h HINTS ${LZ4_ROOT_DIR}/include)
+  find_library(LZ4_LIBRARY NAMES lz4 HINTS ${LZ4_ROOT_DIR}/lib)
+  if (LZ4_INCLUDE_DIR AND LZ4_LIBRARY)
+    set(LZ4_BUILD OFF)
+    get_filename_component(LZ4_HOME ${LZ4_INCLUDE_DIR} DIRECTORY)
+    add_custom_target(lz4_ep)
+  else ()
+    message(STATUS "${Red}Could not use system LZ4, will download and build${ColorReset}")
+  endif ()
+endif ()
+
+if (LZ4_BUILD)
+  set(LZ4_PREFIX "${PROJECT_BINARY_DIR}/external/lz4_ep")
+  set(LZ4_HOME "${LZ4_PREFIX}")
+  set(LZ4_INCLUDE_DIR "${LZ4_PREFIX}/include")
+  set(LZ4_STATIC_LIB_NAME "${CMAKE_STATIC_LIBRARY_PREFIX}lz4")
+  set(LZ4_LIBRARY "${LZ4_PREFIX}/lib/${LZ4_STATIC_LIB_NAME}${CMAKE_STATIC_LIBRARY_SUFFIX}")
+  ExternalProject_Add(lz4_ep
+          URL https://github.com/lz4/lz4/archive/v${LZ4_VERSION}.tar.gz
+          BUILD_IN_SOURCE 1
+          PREFIX ${LZ4_PREFIX}
+          CONFIGURE_COMMAND ""
+          BUILD_COMMAND make -C lib liblz4.a CC=${CMAKE_C_COMPILER} CFLAGS=-O3\ -fPIC
+          INSTALL_COMMAND make -C lib install PREFIX=${LZ4_PREFIX} BUILD_SHARED=no
+          LOG_DOWNLOAD ON
+          LOG_CONFIGURE ON
+          LOG_BUILD ON
+          LOG_INSTALL ON)
+endif ()
+
+include_directories(SYSTEM ${LZ4_INCLUDE_DIR})
+message(STATUS "LZ4 include dir: ${LZ4_INCLUDE_DIR}")
+message(STATUS "LZ4 library: ${LZ4_LIBRARY}")
@@ -0,0 +1,50 @@
+# Zstd external project
+# target:
+#  - zstd_ep
+# defines:
+#  - ZSTD_HOME
+#  - ZSTD_INCLUDE_DIR
+#  - ZSTD_LIBRARY
+
+set(ZSTD_VERSION "1.4.5")
+set(ZSTD_BUILD ON)
+
+if (DEFINED ENV{ZSTD_ROOT} AND EXISTS $ENV{ZSTD_ROOT})
+  set(ZSTD_ROOT_DIR "$ENV{ZSTD_ROOT}")
+  set(USE_SYSTEM_ZSTD ON)
+endif ()
+
+if (USE_SYSTEM_ZSTD)
+  find_path(ZSTD_INCLUDE_DIR zstd.h HINTS ${ZSTD_ROOT_DIR}/include)
+  find_library(ZSTD_LIBRARY NAMES zstd HINTS ${ZSTD_ROOT_DIR}/lib)
+  if (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+    set(ZSTD_BUILD OFF)
+    get_filename_component(ZSTD_HOME ${ZSTD_INCLUDE_DIR} DIRECTORY)
+    add_custom_target(zstd_ep)
+  else ()
+    message(STATUS "${Red}Could not use system Zstd, will download and build${ColorReset}")
+  endif ()
+endif ()
+
+if (ZSTD_BUILD)
+  set(ZSTD_PREFIX "${PROJECT_BINARY_DIR}/external/zstd_ep")
+  set(ZSTD_HOME "${ZSTD_PREFIX}")
+  set(ZSTD_INCLUDE_DIR "${ZSTD_PREFIX}/include")
+  set(ZSTD_STATIC_LIB_NAME "${CMAKE_STATIC_LIBRARY_PREFIX}zstd")
+  set(ZSTD_LIBRARY "${ZSTD_PREFIX}/lib/${ZSTD_STATIC_LIB_NAME}${CMAKE_STATIC_LIBRARY_SUFFIX}")
+  ExternalProject_Add(zstd_ep
+          URL https://github.com/facebook/zstd/archive/v${ZSTD_VERSION}.tar.gz
+          BUILD_IN_SOURCE 1
+          PREFIX ${ZSTD_PREFIX}
+          CONFIGURE_COMMAND ""
+          BUILD_COMMAND make -C lib libzstd.a CC=${CMAKE_C_COMPILER} CFLAGS=-O3\ -fPIC
+          INSTALL_COMMAND make -C lib install-static install-includes PREFIX=${ZSTD_PREFIX}
+          LOG_DOWNLOAD ON
+          LOG_CONFIGURE ON
+          LOG_BUILD ON
+          LOG_INSTALL ON)
+endif ()
+
+include_directories(SYSTEM ${ZSTD_INCLUDE_DIR})
+message(STATUS "Zstd include dir: ${ZSTD_INCLUDE_DIR}")
+message(STATUS "Zstd library: ${ZSTD_LIBRARY}")
@@ -29,6 +29,10 @@ int main(int argc, char const *argv[])
     opts.add_options()  
     ("pmem", bpo::value<std::string>(), "Run the benchmark under PMEM mode. Usage: '-pmem=PMEM_ADDRESS'.")
     ("dram", "Run the benchmark under DRAM mode. Usage: '-dram'.")
+    ("index", bpo::value<std::string>(), "Hash table index to benchmark, 'unordered_map' or 'open_addressing'. Usage: '-index=INDEX'. Runs both by default.")
+    ("single_allocation", bpo::value<bool>(), "Store key and value in one allocation. Usage: '-single_allocation=BOOL'. Runs both by default.")
+    ("key_size", bpo::value<int>(), "Key size in bytes, keys shorter than 24 bytes are stored inline. Usage: '-key_size=SIZE'.")
+    ("data_size", bpo::value<int>(), "Value size in bytes. Usage: '-data_size=SIZE'.")
     ("help", "This benchmark only runs by block.");
 
     try {
@@ -39,22 +43,27 @@ int main(int argc, char const *argv[])
         return 0;
     }
     
-    if (vm.size() > 1 || vm.empty()) {
-        std::cout << "Please use one option. See '-help' for more information. \n";
-    }
     if (vm.count("help")) {
         std::cout << opts << std::endl;   
+        return 0;
     }
-    
-    else if (vm.count("dram")) {
-        std::string memory_mode = "DRAM";
-        std::string pmem_path = "";
-        void* mem_kind = mem_utils::init_kind(memory_mode, pmem_path);
+
+    std::string memory_mode = "DRAM";
+    std::string pmem_path = "";
+    if (vm.count("pmem")) {
+        memory_mode = "PMEM";
+        pmem_path = vm["pmem"].as<std::string>();
     }
-    else if (vm.count("pmem")) {
-        std::string memory_mode = "PMEM";
-        std::string pmem_path = vm["pmem"].as<std::string>();
-        void* mem_kind = mem_utils::init_kind(memory_mode, pmem_path);
+    void* mem_kind = mem_utils::init_kind(memory_mode, pmem_path);
+
+    std::vector<std::string> indexes = {"unordered_map", "open_addressing"};
+    if (vm.count("index")) {
+        indexes = {vm["index"].as<std::string>()};
+    }
+
+    std::vector<bool> single_allocations = {false, true};
+    if (vm.count("single_allocation")) {
+        single_allocations = {vm["single_allocation"].as<bool>()};
     }
 
     std::string address = "127.0.0.1";
@@ -63,7 +72,8 @@ int main(int argc, char const *argv[])
     int num_blocks = 1;
     int chain_length = 1;
     int num_ops = 100000;
-    int data_size = 1024;
+    int data_size = vm.count("data_size") ? vm["data_size"].as<int>() : 1024;
+    int key_size = vm.count("key_size") ? vm["key_size"].as<int>() : 8;
     
     std::string path = "/tmp";
     std::string backing_path = "local://tmp";
@@ -75,62 +85,75 @@ int main(int argc, char const *argv[])
     LOG(log_level::info) << "chain-length: " << chain_length;
     LOG(log_level::info) << "num-ops: " << num_ops;
     LOG(log_level::info) << "data-size: " << data_size;
+    LOG(log_level::info) << "key-size: " << key_size;
     LOG(log_level::info) << "path: " << path;
     LOG(log_level::info) << "backing-path: " << backing_path;
+    LOG(log_level::info) << "memory-mode: " << memory_mode;
 
-    size_t capacity = 134217728;
-    block_memory_manager manager(capacity, memory_mode, mem_kind);
-    hash_table_partition block(&manager);
-    block.slot_range(0, hash_slot::MAX);
-
-    auto bench_begin = time_utils::now_us();
-    uint64_t tot_time = 0;
     std::string data_ (data_size, 'x');
-
+    std::vector<std::string> keys;
+    keys.reserve(static_cast<size_t>(num_ops));
     for (int i = 0; i < num_ops; ++i) {
-        response resp;
-        block.put(resp, {"put", std::to_string(i), data_});
+        auto key = std::to_string(i);
+        if (key.size() < static_cast<size_t>(key_size)) {
+            key.insert(0, static_cast<size_t>(key_size) - key.size(), '0');
+        }
+        keys.push_back(key);
     }
-	auto bench_end = time_utils::now_us();
-	tot_time = bench_end - bench_begin;
-	LOG(log_level::info) << "===== " << "hash_table_put" << " ======";
-	LOG(log_level::info) << "total_time: " << tot_time;
-	LOG(log_level::info) << "\t" << num_ops << " requests completed in " << tot_time
-											<< " us";
-	LOG(log_level::info) << "\t" << data_size << " payload";
-	LOG(log_level::info) << "\tThroughput: " << num_ops * 1E3 / tot_time << " requests per microsecond";
-
-    bench_begin = time_utils::now_us();
-    tot_time = 0;
 
-    for (int i = 0; i < num_ops; ++i) {
-        response resp;
-        block.get(resp, {"get", std::to_string(i)});
-    }
-	bench_end = time_utils::now_us();
-	tot_time = bench_end - bench_begin;
-	LOG(log_level::info) << "===== " << "hash_table_get" << " ======";
-	LOG(log_level::info) << "total_time: " << tot_time;
-	LOG(log_level::info) << "\t" << num_ops << " requests completed in " << tot_time
-											<< " us";
-	LOG(log_level::info) << "\t" << data_size << " payload";
-	LOG(log_level::info) << "\tThroughput: " << num_ops * 1E3 / tot_time << " requests per microsecond";
-  
-	bench_begin = time_utils::now_us();
-    tot_time = 0;
-
-	for (int i = 0; i < num_ops; ++i) {
-        response resp;
-        block.remove(resp, {"remove", std::to_string(i)});
+    auto report = [&](const std::string &op, const std::string &index, uint64_t tot_time) {
+        LOG(log_level::info) << "===== " << op << " (" << index << ") ======";
+        LOG(log_level::info) << "total_time: " << tot_time;
+        LOG(log_level::info) << "\t" << num_ops << " requests completed in " << tot_time << " us";
+        LOG(log_level::info) << "\t" << data_size << " payload";
+        LOG(log_level::info) << "\tThroughput: " << num_ops * 1E3 / tot_time << " requests per millisecond";
+    };
+
+    for (const auto &index_type : indexes) {
+      for (auto single_allocation : single_allocations) {
+        auto index = index_type + (single_allocation ? ", single allocation" : "");
+        size_t capacity = 134217728;
+        block_memory_manager manager(capacity, memory_mode, mem_kind);
+        property_map conf;
+        conf.set("hashtable.index", index_type);
+        conf.set("hashtable.single_allocation", single_allocation ? "true" : "false");
+        hash_table_partition block(&manager, backing_path, "0_65536", "regular", conf);
+        block.slot_range(0, hash_slot::MAX);
+
+        auto used_before = manager.mb_used();
+        auto bench_begin = time_utils::now_us();
+        for (int i = 0; i < num_ops; ++i) {
+            response resp;
+            block.put(resp, {"put", keys[i], data_});
+        }
+        report("hash_table_put", index, time_utils::now_us() - bench_begin);
+        // Block allocations only; the index itself stores sizeof(kv_pair_type) bytes per entry
+        LOG(log_level::info) << "\tBlock memory per entry: " << (manager.mb_used() - used_before) / num_ops
+                             << " bytes (+" << sizeof(kv_pair_type) << " bytes in the index)";
+
+        bench_begin = time_utils::now_us();
+        for (int i = 0; i < num_ops; ++i) {
+            response resp;
+            block.get(resp, {"get", keys[i]});
+        }
+        report("hash_table_get", index, time_utils::now_us() - bench_begin);
+
+        // Misses walk the whole probe sequence / bucket chain
+        bench_begin = time_utils::now_us();
+        for (int i = 0; i < num_ops; ++i) {
+            response resp;
+            block.exists(resp, {"exists", keys[i] + "_"});
+        }
+        report("hash_table_exists_miss", index, time_utils::now_us() - bench_begin);
+
+        bench_begin = time_utils::now_us();
+        for (int i = 0; i < num_ops; ++i) {
+            response resp;
+            block.remove(resp, {"remove", keys[i]});
+        }
+        report("hash_table_remove", index, time_utils::now_us() - bench_begin);
+      }
     }
-  
-	bench_end = time_utils::now_us();
-	tot_time = bench_end - bench_begin;
-	LOG(log_level::info) << "===== " << "hash_table_remove" << " ======";
-	LOG(log_level::info) << "total_time: " << tot_time;
-	LOG(log_level::info) << "\t" << num_ops << " requests completed in " << tot_time
-											<< " us";
-	LOG(log_level::info) << "\t" << data_size << " payload";
-	LOG(log_level::info) << "\tThroughput: " << num_ops * 1E3 / tot_time << " requests per microsecond";
-	
-}
\ No newline at end of file
+
+    return 0;
+}
@@ -1,12 +1,15 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
+#include <sys/stat.h>
 #include "jiffy/utils/time_utils.h"
 #include "jiffy/utils/signal_handling.h"
 #include "jiffy/utils/logger.h"
 #include "jiffy/utils/cmd_parse.h"
 #include "jiffy/storage/hashtable/hash_table_partition.h"
 #include "jiffy/storage/hashtable/hash_slot.h"
+#include "jiffy/persistent/persistent_store.h"
 #include "benchmark_utils.h"
 
 using namespace jiffy::storage;
@@ -24,6 +27,23 @@ std::string to_padded_string(size_t num, size_t padding) {
   return result;
 }
 
+// Bytes of the local image at a persistent path, data and offset files included
+std::size_t image_size(const std::string &path) {
+  auto decomposed = persistent_store::decompose_path(path);
+  std::size_t bytes = 0;
+  for (const auto &file: {decomposed.second, decomposed.second + "_offset"}) {
+    struct stat st{};
+    if (stat(file.c_str(), &st) == 0) {
+      bytes += static_cast<std::size_t>(st.st_size);
+    }
+  }
+  return bytes;
+}
+
+double gb_per_sec(std::size_t bytes, uint64_t elapsed_ms) {
+  return elapsed_ms == 0 ? 0.0 : static_cast<double>(bytes) / 1e9 / (static_cast<double>(elapsed_ms) / 1e3);
+}
+
 int main(int argc, char **argv) {
   signal_handling::install_error_handler(SIGABRT, SIGFPE, SIGSEGV, SIGILL, SIGTRAP);
 
@@ -53,20 +73,17 @@ int main(int argc, char **argv) {
     std::cerr << parser.help_msg() << std::endl;
     return -1;
   }
-  std::shared_ptr<serde> fmt{};
-  if (format == "csv") {
-    LOG(log_level::info) << "Serialization/deserialization format: csv";
-    fmt = std::make_shared<csv_serde>();
-  } else if (format == "binary") {
-    LOG(log_level::info) << "Serialization/deserialization format: binary";
-    fmt = std::make_shared<binary_serde>();
-  } else {
+  if (format != "csv" && format != "binary" && format != "binary_lz4" && format != "binary_zstd"
+      && format != "indexed") {
     LOG(log_level::error) << "Unknown Serialization/deserialization format " << format << "; terminating...";
     return -1;
   }
+  LOG(log_level::info) << "Serialization/deserialization format: " << format;
+  property_map conf;
+  conf.set("hashtable.serializer", format);
 
   block_memory_manager manager;
-  hash_table_partition block(&manager);
+  hash_table_partition block(&manager, "local://tmp", "0_65536", "regular", conf);
   block.slot_range(0, hash_slot::MAX);
 
   if (mode == "write") {
@@ -83,14 +100,16 @@ int main(int argc, char **argv) {
     auto t0 = time_utils::now_ms();
     block.sync(path);
     auto t1 = time_utils::now_ms();
-    LOG(log_level::info) << "Persisted to " << path << " in " << (t1 - t0) << " ms";
+    LOG(log_level::info) << "Persisted to " << path << " in " << (t1 - t0) << " ms ("
+                         << gb_per_sec(image_size(path), t1 - t0) << " GB/s)";
   } else if (mode == "read") {
     // Load phase
     LOG(log_level::info) << "Loading data from " << path << "...";
     auto t0 = time_utils::now_ms();
     block.load(path);
     auto t1 = time_utils::now_ms();
-    LOG(log_level::info) << "Loaded " << block.size() << " keys from " << path << " in " << (t1 - t0) << " ms";
+    LOG(log_level::info) << "Loaded " << block.size() << " keys from " << path << " in " << (t1 - t0) << " ms ("
+                         << gb_per_sec(image_size(path), t1 - t0) << " GB/s)";
   } else {
     LOG(log_level::error) << "Unknown benchmark mode: " << mode;
   }
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <sys/stat.h>
+#include "jiffy/utils/time_utils.h"
+#include "jiffy/utils/signal_handling.h"
+#include "jiffy/utils/logger.h"
+#include "jiffy/utils/cmd_parse.h"
+#include "jiffy/storage/block_memory_manager.h"
+#include "jiffy/storage/serde/serde_all.h"
+
+using namespace jiffy::storage;
+using namespace jiffy::persistent;
+using namespace jiffy::utils;
+
+// Bytes of an image on disk, data and offset files included
+std::size_t image_size(const std::string &path) {
+  std::size_t bytes = 0;
+  for (const auto &file: {path, path + "_offset"}) {
+    struct stat st{};
+    if (stat(file.c_str(), &st) == 0) {
+      bytes += static_cast<std::size_t>(st.st_size);
+    }
+  }
+  return bytes;
+}
+
+double gb_per_sec(std::size_t bytes, uint64_t elapsed_us) {
+  return elapsed_us == 0 ? 0.0 : static_cast<double>(bytes) / 1e3 / static_cast<double>(elapsed_us);
+}
+
+// Text over a small alphabet, compressible roughly like typical payloads
+std::string random_value(std::mt19937 &gen, std::size_t size) {
+  static const char alphabet[] = "abcdefghijklmnop";
+  std::uniform_int_distribution<int> dist(0, sizeof(alphabet) - 2);
+  std::string value(size, '\0');
+  for (auto &c: value) {
+    c = alphabet[dist(gen)];
+  }
+  return value;
+}
+
+std::shared_ptr<serde> make_serde(const std::string &format, const block_memory_allocator<uint8_t> &allocator) {
+  if (format == "binary_lz4") {
+    return std::make_shared<binary_serde>(allocator, codec::make("lz4"));
+  } else if (format == "binary_zstd") {
+    return std::make_shared<binary_serde>(allocator, codec::make("zstd"));
+  } else if (format == "indexed") {
+    return std::make_shared<indexed_serde>(allocator);
+  }
+  return std::make_shared<binary_serde>(allocator);
+}
+
+int main(int argc, char **argv) {
+  signal_handling::install_error_handler(SIGABRT, SIGFPE, SIGSEGV, SIGILL, SIGTRAP);
+
+  cmd_options opts;
+  opts.add(cmd_option("num-items", 'n', false).set_default("100000").set_description("Number of items per data structure"));
+  opts.add(cmd_option("value-size", 'v', false).set_default("1000").set_description("Size of each item"));
+  opts.add(cmd_option("path", 'p', false).set_default("/tmp/serde_bench").set_description("Local path prefix of the images"));
+
+  cmd_parser parser(argc, argv, opts);
+  if (parser.get_flag("help")) {
+    std::cerr << parser.help_msg() << std::endl;
+    return 0;
+  }
+
+  size_t num_items;
+  size_t value_size;
+  std::string path;
+  try {
+    num_items = static_cast<size_t>(parser.get_long("num-items"));
+    value_size = static_cast<size_t>(parser.get_long("value-size"));
+    path = parser.get("path");
+  } catch (cmd_parse_exception &ex) {
+    std::cerr << "Could not parse command line args: " << ex.what() << std::endl;
+    std::cerr << parser.help_msg() << std::endl;
+    return -1;
+  }
+
+  // Room for the four data structures plus one loaded copy
+  auto capacity = 6 * num_items * (value_size + 64);
+  block_memory_manager manager(capacity);
+  block_memory_allocator<uint8_t> binary_allocator(&manager);
+  block_memory_allocator<char> char_allocator(&manager);
+  std::mt19937 gen(0);
+
+  LOG(log_level::info) << "Generating " << num_items << " items of " << value_size << " bytes...";
+  hash_table_type table;
+  table.reserve(num_items);
+  string_array queue(num_items * (value_size + 8), char_allocator);
+  file_block file(num_items * value_size, char_allocator);
+  shared_log_block log_block(num_items * value_size, char_allocator);
+  shared_log_serde_type log{&log_block, {}, 0};
+  for (size_t i = 0; i < num_items; i++) {
+    auto value = random_value(gen, value_size);
+    std::ostringstream key;
+    key << std::setw(22) << std::setfill('0') << i;
+    table.emplace(binary(key.str(), binary_allocator), binary(value, binary_allocator));
+    queue.push_back(value);
+    file.write(value, i * value_size);
+    log_block.write(value, i * value_size);
+    log.log_info.push_back({static_cast<int>(i * value_size), static_cast<int>(value_size)});
+  }
+
+  std::cout << std::left << std::setw(12) << "type" << std::setw(14) << "format" << std::setw(14) << "bytes"
+            << std::setw(14) << "stored" << std::setw(8) << "ratio" << std::setw(14) << "write GB/s"
+            << "read GB/s" << std::endl;
+  for (const std::string type: {"hash_table", "fifo_queue", "file", "shared_log"}) {
+    std::size_t raw_bytes = 0;
+    for (const std::string format: {"binary", "binary_lz4", "binary_zstd", "indexed"}) {
+      auto ser = make_serde(format, binary_allocator);
+      auto image = path + "_" + type + "_" + format;
+      uint64_t write_us = 0;
+      uint64_t read_us = 0;
+      if (type == "hash_table") {
+        auto t0 = time_utils::now_us();
+        ser->serialize(table, image);
+        write_us = time_utils::now_us() - t0;
+        hash_table_type loaded;
+        t0 = time_utils::now_us();
+        ser->deserialize(loaded, image);
+        read_us = time_utils::now_us() - t0;
+      } else if (type == "fifo_queue") {
+        auto t0 = time_utils::now_us();
+        ser->serialize(queue, image);
+        write_us = time_utils::now_us() - t0;
+        string_array loaded(queue.max_offset(), char_allocator);
+        t0 = time_utils::now_us();
+        ser->deserialize(loaded, image);
+        read_us = time_utils::now_us() - t0;
+      } else if (type == "file") {
+        auto t0 = time_utils::now_us();
+        ser->serialize(file, image);
+        write_us = time_utils::now_us() - t0;
+        file_block loaded(file.size(), char_allocator);
+        t0 = time_utils::now_us();
+        ser->deserialize(loaded, image);
+        read_us = time_utils::now_us() - t0;
+      } else {
+        auto t0 = time_utils::now_us();
+        ser->serialize(log, image);
+        write_us = time_utils::now_us() - t0;
+        shared_log_block loaded_block(num_items * value_size, char_allocator);
+        shared_log_serde_type loaded{&loaded_block, {}, 0};
+        t0 = time_utils::now_us();
+        ser->deserialize(loaded, image);
+        read_us = time_utils::now_us() - t0;
+      }
+      auto stored_bytes = image_size(image);
+      if (format == "binary") {
+        raw_bytes = stored_bytes;
+      }
+      std::cout << std::left << std::setw(12) << type << std::setw(14) << format << std::setw(14) << raw_bytes
+                << std::setw(14) << stored_bytes << std::setw(8) << std::setprecision(3)
+                << static_cast<double>(raw_bytes) / std::max<std::size_t>(stored_bytes, 1)
+                << std::setw(14) << gb_per_sec(raw_bytes, write_us) << gb_per_sec(raw_bytes, read_us) << std::endl;
+      std::remove(image.c_str());
+      std::remove((image + "_offset").c_str());
+    }
+  }
+  return 0;
+}
@@ -120,12 +120,47 @@ const std::vector<replica_chain> &ds_file_node::data_blocks() const {
 void ds_file_node::sync(const std::string &backing_path,
                         const std::shared_ptr<storage::storage_management_ops> &storage) {
   std::unique_lock<std::mutex> lock(mtx_);
+  std::vector<std::pair<std::string, std::string>> tails;
   for (const auto &block: dstatus_.data_blocks()) {
     std::string block_backing_path = backing_path;
     utils::directory_utils::push_path_element(block_backing_path, block.name);
     if (block.mode == storage_mode::in_memory || block.mode == storage_mode::in_memory_grace)
-      storage->sync(block.tail(), block_backing_path);
+      tails.emplace_back(block.tail(), block_backing_path);
   }
+  // Freeze all partitions before capturing any, so that the snapshots of the data structure form a
+  // single point in time; syncs only capture the partitions and persist them in the background
+  std::vector<std::string> frozen;
+  auto thaw_all = [&frozen, &storage] {
+    for (const auto &tail: frozen) {
+      try {
+        storage->thaw_partition(tail);
+      } catch (std::exception &e) {
+        LOG(log_level::warn) << "Could not thaw " << tail << ", its freeze expires: " << e.what();
+      }
+    }
+    frozen.clear();
+  };
+  if (tails.size() > 1) {
+    try {
+      for (const auto &tail: tails) {
+        storage->freeze_partition(tail.first);
+        frozen.push_back(tail.first);
+      }
+    } catch (std::exception &e) {
+      LOG(log_level::warn) << "Could not freeze all partitions of " << name() << ", syncing them one by one: "
+                           << e.what();
+      thaw_all();
+    }
+  }
+  try {
+    for (const auto &tail: tails) {
+      storage->sync(tail.first, tail.second);
+    }
+  } catch (...) {
+    thaw_all();
+    throw;
+  }
+  thaw_all();
 }
 
 void ds_file_node::dump(std::vector<std::string> &cleared_blocks,
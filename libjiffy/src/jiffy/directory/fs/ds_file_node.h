@@ -200,6 +200,7 @@ class ds_file_node : public ds_node {
 
   /**
    * @brief Write all dirty blocks back to persistent storage
+   * Blocks are frozen together while they are captured, so that the data structure is persisted as one unit
    * @param backing_path File backing path
    * @param storage Storage
    */
@@ -0,0 +1,269 @@
+#include "async_stream.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace jiffy {
+namespace persistent {
+
+/* Chunk size of the file streams */
+static const std::size_t STREAM_CHUNK_SIZE = 1UL << 20;
+
+/* Maximum number of chunks in flight per file stream */
+static const std::size_t STREAM_MAX_CHUNKS = 4;
+
+async_write_buf::async_write_buf(std::shared_ptr<io_engine> engine, std::size_t chunk_size, std::size_t max_chunks)
+    : engine_(std::move(engine)),
+      chunk_size_(chunk_size),
+      max_chunks_(max_chunks),
+      fd_(-1),
+      offset_(0),
+      num_in_flight_(0),
+      error_(0) {}
+
+async_write_buf::~async_write_buf() {
+  close();
+}
+
+bool async_write_buf::open(const std::string &path) {
+  close();
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    return false;
+  }
+  offset_ = 0;
+  error_ = 0;
+  chunk_.reset(new std::vector<char>(chunk_size_));
+  setp(chunk_->data(), chunk_->data() + chunk_size_);
+  return true;
+}
+
+bool async_write_buf::close() {
+  if (fd_ < 0) {
+    return true;
+  }
+  bool ok = sync() == 0;
+  ::close(fd_);
+  fd_ = -1;
+  chunk_.reset();
+  free_chunks_.clear();
+  setp(nullptr, nullptr);
+  return ok;
+}
+
+async_write_buf::int_type async_write_buf::overflow(int_type c) {
+  if (fd_ < 0) {
+    return traits_type::eof();
+  }
+  submit_chunk();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+int async_write_buf::sync() {
+  if (fd_ < 0) {
+    return 0;
+  }
+  if (pptr() != pbase()) {
+    submit_chunk();
+  }
+  std::unique_lock<std::mutex> lock(mtx_);
+  cv_.wait(lock, [this] { return num_in_flight_ == 0; });
+  return error_ == 0 ? 0 : -1;
+}
+
+async_write_buf::pos_type async_write_buf::seekoff(off_type off,
+                                                   std::ios_base::seekdir dir,
+                                                   std::ios_base::openmode which) {
+  // Only reports the position, for tellp()
+  if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out) || fd_ < 0) {
+    return pos_type(off_type(-1));
+  }
+  return pos_type(static_cast<off_type>(offset_ + (pptr() - pbase())));
+}
+
+void async_write_buf::submit_chunk() {
+  auto size = static_cast<std::size_t>(pptr() - pbase());
+  std::vector<io_request> batch;
+  if (size > 0) {
+    auto data = chunk_.release();
+    batch.push_back(io_request{io_op::write, fd_, data->data(), size, offset_, [this, data, size](std::int64_t n) {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (n < 0 && error_ == 0) {
+        error_ = static_cast<int>(-n);
+      } else if (n >= 0 && static_cast<std::size_t>(n) < size && error_ == 0) {
+        error_ = EIO;
+      }
+      free_chunks_.emplace_back(data);
+      --num_in_flight_;
+      cv_.notify_all();
+    }});
+    offset_ += size;
+  }
+  std::unique_lock<std::mutex> lock(mtx_);
+  if (!batch.empty()) {
+    ++num_in_flight_;
+    lock.unlock();
+    engine_->submit(batch);
+    lock.lock();
+  }
+  if (chunk_ == nullptr) {
+    if (free_chunks_.empty() && num_in_flight_ < max_chunks_) {
+      chunk_.reset(new std::vector<char>(chunk_size_));
+    } else {
+      cv_.wait(lock, [this] { return !free_chunks_.empty(); });
+      chunk_ = std::move(free_chunks_.back());
+      free_chunks_.pop_back();
+    }
+  }
+  setp(chunk_->data(), chunk_->data() + chunk_size_);
+}
+
+async_read_buf::async_read_buf(std::shared_ptr<io_engine> engine, std::size_t chunk_size, std::size_t max_chunks)
+    : engine_(std::move(engine)),
+      chunk_size_(chunk_size),
+      max_chunks_(max_chunks),
+      fd_(-1),
+      next_offset_(0),
+      eof_(false) {}
+
+async_read_buf::~async_read_buf() {
+  close();
+}
+
+bool async_read_buf::open(const std::string &path) {
+  close();
+  fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    return false;
+  }
+  next_offset_ = 0;
+  eof_ = false;
+  read_ahead();
+  return true;
+}
+
+void async_read_buf::close() {
+  if (fd_ < 0) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this] {
+      for (const auto &c: chunks_) {
+        if (!c->done) {
+          return false;
+        }
+      }
+      return true;
+    });
+  }
+  chunks_.clear();
+  ::close(fd_);
+  fd_ = -1;
+  setg(nullptr, nullptr, nullptr);
+}
+
+async_read_buf::int_type async_read_buf::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  if (fd_ < 0) {
+    return traits_type::eof();
+  }
+  // The front chunk is consumed once the get area is exhausted
+  if (eback() != nullptr && !chunks_.empty()) {
+    chunks_.pop_front();
+    setg(nullptr, nullptr, nullptr);
+  }
+  read_ahead();
+  if (chunks_.empty()) {
+    return traits_type::eof();
+  }
+  auto &c = *chunks_.front();
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [&c] { return c.done; });
+  }
+  if (c.result <= 0) {
+    // Read error or end of file; later chunks cannot hold data
+    eof_ = true;
+    return traits_type::eof();
+  }
+  setg(c.data.data(), c.data.data(), c.data.data() + c.result);
+  return traits_type::to_int_type(*gptr());
+}
+
+async_read_buf::pos_type async_read_buf::seekoff(off_type off,
+                                                 std::ios_base::seekdir dir,
+                                                 std::ios_base::openmode which) {
+  // Only reports the position, for tellg()
+  if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::in) || fd_ < 0) {
+    return pos_type(off_type(-1));
+  }
+  if (eback() == nullptr || chunks_.empty()) {
+    return pos_type(static_cast<off_type>(chunks_.empty() ? next_offset_ : chunks_.front()->offset));
+  }
+  return pos_type(static_cast<off_type>(chunks_.front()->offset + (gptr() - eback())));
+}
+
+void async_read_buf::read_ahead() {
+  std::vector<io_request> batch;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (const auto &c: chunks_) {
+      if (c->done && c->result >= 0 && static_cast<std::size_t>(c->result) < chunk_size_) {
+        eof_ = true;
+      }
+    }
+    while (!eof_ && chunks_.size() < max_chunks_) {
+      std::unique_ptr<chunk> c(new chunk{std::vector<char>(chunk_size_), next_offset_, 0, false});
+      auto cp = c.get();
+      batch.push_back(io_request{io_op::read, fd_, cp->data.data(), chunk_size_, next_offset_, [this, cp](std::int64_t n) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        cp->result = n;
+        cp->done = true;
+        cv_.notify_all();
+      }});
+      chunks_.push_back(std::move(c));
+      next_offset_ += chunk_size_;
+    }
+  }
+  if (!batch.empty()) {
+    engine_->submit(batch);
+  }
+}
+
+async_ofstream::async_ofstream(const std::string &path)
+    : std::ostream(nullptr),
+      buf_(io_engine::instance(), STREAM_CHUNK_SIZE, STREAM_MAX_CHUNKS) {
+  rdbuf(&buf_);
+  if (!buf_.open(path)) {
+    setstate(std::ios_base::failbit);
+  }
+}
+
+void async_ofstream::close() {
+  if (!buf_.close()) {
+    setstate(std::ios_base::badbit);
+  }
+}
+
+async_ifstream::async_ifstream(const std::string &path)
+    : std::istream(nullptr),
+      buf_(io_engine::instance(), STREAM_CHUNK_SIZE, STREAM_MAX_CHUNKS) {
+  rdbuf(&buf_);
+  if (!buf_.open(path)) {
+    setstate(std::ios_base::failbit);
+  }
+}
+
+void async_ifstream::close() {
+  buf_.close();
+}
+
+}
+}
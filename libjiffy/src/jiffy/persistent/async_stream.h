@@ -0,0 +1,204 @@
+#ifndef JIFFY_ASYNC_STREAM_H
+#define JIFFY_ASYNC_STREAM_H
+
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "io_engine.h"
+
+namespace jiffy {
+namespace persistent {
+
+/**
+ * @brief Stream buffer writing a file through an I/O engine.
+ *
+ * Data is gathered in chunks; a full chunk is submitted as an asynchronous write and the next one
+ * is filled while it is in flight, so serialization overlaps with the disk. Writers only wait when
+ * the maximum number of chunks is in flight, or on sync.
+ */
+class async_write_buf : public std::streambuf {
+ public:
+  /**
+   * @brief Constructor
+   * @param engine I/O engine
+   * @param chunk_size Chunk size
+   * @param max_chunks Maximum number of chunks in flight
+   */
+  async_write_buf(std::shared_ptr<io_engine> engine, std::size_t chunk_size, std::size_t max_chunks);
+
+  /**
+   * @brief Destructor, closes the file
+   */
+  ~async_write_buf() override;
+
+  /**
+   * @brief Create or truncate a file and open it
+   * @param path File path
+   * @return Bool value, true if the file was opened
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief Write out buffered data and close the file
+   * @return Bool value, true if all data was written
+   */
+  bool close();
+
+ protected:
+  int_type overflow(int_type c) override;
+
+  int sync() override;
+
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+ private:
+  /**
+   * @brief Submit the current chunk and start filling a free one
+   */
+  void submit_chunk();
+
+  /* I/O engine */
+  std::shared_ptr<io_engine> engine_;
+  /* Chunk size */
+  std::size_t chunk_size_;
+  /* Maximum number of chunks in flight */
+  std::size_t max_chunks_;
+  /* File descriptor, -1 if closed */
+  int fd_;
+  /* File offset of the current chunk */
+  std::uint64_t offset_;
+  /* Chunk being filled */
+  std::unique_ptr<std::vector<char>> chunk_;
+  /* Chunks that can be reused */
+  std::vector<std::unique_ptr<std::vector<char>>> free_chunks_;
+  /* Number of chunks in flight */
+  std::size_t num_in_flight_;
+  /* First write error, 0 if none */
+  int error_;
+  /* Mutex for chunks in flight */
+  std::mutex mtx_;
+  /* Signalled when a chunk completes */
+  std::condition_variable cv_;
+};
+
+/**
+ * @brief Stream buffer reading a file through an I/O engine.
+ *
+ * Chunks following the one being read are requested ahead of time, so deserialization overlaps
+ * with the disk.
+ */
+class async_read_buf : public std::streambuf {
+ public:
+  /**
+   * @brief Constructor
+   * @param engine I/O engine
+   * @param chunk_size Chunk size
+   * @param max_chunks Maximum number of chunks read ahead
+   */
+  async_read_buf(std::shared_ptr<io_engine> engine, std::size_t chunk_size, std::size_t max_chunks);
+
+  /**
+   * @brief Destructor, closes the file
+   */
+  ~async_read_buf() override;
+
+  /**
+   * @brief Open a file
+   * @param path File path
+   * @return Bool value, true if the file was opened
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief Close the file, waiting for reads in flight
+   */
+  void close();
+
+ protected:
+  int_type underflow() override;
+
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+ private:
+  /* Chunk read from the file */
+  struct chunk {
+    std::vector<char> data;
+    std::uint64_t offset;
+    /* Bytes read, or -errno */
+    std::int64_t result;
+    bool done;
+  };
+
+  /**
+   * @brief Request chunks until the maximum number is read ahead or the end of the file is reached
+   */
+  void read_ahead();
+
+  /* I/O engine */
+  std::shared_ptr<io_engine> engine_;
+  /* Chunk size */
+  std::size_t chunk_size_;
+  /* Maximum number of chunks read ahead */
+  std::size_t max_chunks_;
+  /* File descriptor, -1 if closed */
+  int fd_;
+  /* File offset of the next chunk to request */
+  std::uint64_t next_offset_;
+  /* True once a chunk came back short */
+  bool eof_;
+  /* Requested chunks in file order, the front one is being read */
+  std::deque<std::unique_ptr<chunk>> chunks_;
+  /* Mutex for chunk completion */
+  std::mutex mtx_;
+  /* Signalled when a chunk completes */
+  std::condition_variable cv_;
+};
+
+/* Output file stream writing through the process wide I/O engine */
+class async_ofstream : public std::ostream {
+ public:
+  /**
+   * @brief Constructor, creates or truncates the file
+   * @param path File path
+   */
+  explicit async_ofstream(const std::string &path);
+
+  /**
+   * @brief Write out buffered data and close the file
+   */
+  void close();
+
+ private:
+  /* Stream buffer */
+  async_write_buf buf_;
+};
+
+/* Input file stream reading through the process wide I/O engine */
+class async_ifstream : public std::istream {
+ public:
+  /**
+   * @brief Constructor
+   * @param path File path
+   */
+  explicit async_ifstream(const std::string &path);
+
+  /**
+   * @brief Close the file
+   */
+  void close();
+
+ private:
+  /* Stream buffer */
+  async_read_buf buf_;
+};
+
+}
+}
+
+#endif //JIFFY_ASYNC_STREAM_H
@@ -0,0 +1,446 @@
+#include "compression.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "jiffy/utils/logger.h"
+#ifdef COMPRESSION_IN_USE
+#include <lz4.h>
+#include <zstd.h>
+#endif
+
+namespace jiffy {
+namespace persistent {
+
+using namespace utils;
+
+/* Marks the start of a compressed file */
+static const std::uint32_t COMPRESSED_MAGIC = 0x5a59464a;
+
+/* File header layout: magic, codec id */
+static const std::size_t HEADER_SIZE = 2 * sizeof(std::uint32_t);
+
+/* Frame header layout: raw size, stored size */
+static const std::size_t FRAME_HEADER_SIZE = 2 * sizeof(std::uint32_t);
+
+/* Uncompressed bytes per frame */
+static const std::size_t COMPRESSED_CHUNK_SIZE = 1UL << 20;
+
+/* Codec identifiers */
+static const std::uint32_t LZ4_CODEC_ID = 1;
+static const std::uint32_t ZSTD_CODEC_ID = 2;
+
+#ifdef COMPRESSION_IN_USE
+/* LZ4 codec, favours speed */
+class lz4_codec : public codec {
+ public:
+  std::uint32_t id() const override {
+    return LZ4_CODEC_ID;
+  }
+
+  std::string name() const override {
+    return "lz4";
+  }
+
+  void compress(const char *src, std::size_t size, std::string &dst) const override {
+    dst.resize(static_cast<std::size_t>(LZ4_compressBound(static_cast<int>(size))));
+    auto n = LZ4_compress_default(src, &dst[0], static_cast<int>(size), static_cast<int>(dst.size()));
+    if (n <= 0) {
+      throw std::runtime_error("LZ4 compression failed");
+    }
+    dst.resize(static_cast<std::size_t>(n));
+  }
+
+  void decompress(const char *src, std::size_t size, char *dst, std::size_t raw_size) const override {
+    auto n = LZ4_decompress_safe(src, dst, static_cast<int>(size), static_cast<int>(raw_size));
+    if (n < 0 || static_cast<std::size_t>(n) != raw_size) {
+      throw std::runtime_error("LZ4 decompression failed");
+    }
+  }
+};
+
+/* Zstd codec, favours compression ratio */
+class zstd_codec : public codec {
+ public:
+  std::uint32_t id() const override {
+    return ZSTD_CODEC_ID;
+  }
+
+  std::string name() const override {
+    return "zstd";
+  }
+
+  void compress(const char *src, std::size_t size, std::string &dst) const override {
+    dst.resize(ZSTD_compressBound(size));
+    // Level 1 keeps compression from becoming the bottleneck of a sync
+    auto n = ZSTD_compress(&dst[0], dst.size(), src, size, 1);
+    if (ZSTD_isError(n)) {
+      throw std::runtime_error(std::string("Zstd compression failed: ") + ZSTD_getErrorName(n));
+    }
+    dst.resize(n);
+  }
+
+  void decompress(const char *src, std::size_t size, char *dst, std::size_t raw_size) const override {
+    auto n = ZSTD_decompress(dst, raw_size, src, size);
+    if (ZSTD_isError(n) || n != raw_size) {
+      throw std::runtime_error("Zstd decompression failed");
+    }
+  }
+};
+#endif
+
+std::shared_ptr<codec> codec::make(const std::string &name) {
+#ifdef COMPRESSION_IN_USE
+  if (name == "lz4") {
+    return std::make_shared<lz4_codec>();
+  } else if (name == "zstd") {
+    return std::make_shared<zstd_codec>();
+  }
+  throw std::invalid_argument("No such codec " + name);
+#else
+  throw std::invalid_argument("Built without compression support, no codec " + name);
+#endif
+}
+
+std::shared_ptr<codec> codec::from_id(std::uint32_t id) {
+  switch (id) {
+    case LZ4_CODEC_ID:return make("lz4");
+    case ZSTD_CODEC_ID:return make("zstd");
+    default:throw std::runtime_error("Unknown codec " + std::to_string(id));
+  }
+}
+
+/* Compression threads shared by all compressed writers, so that concurrent writers do not add threads */
+class compression_pool {
+ public:
+  /**
+   * @brief Constructor
+   * @param num_threads Number of threads
+   */
+  explicit compression_pool(std::size_t num_threads) : stop_(false) {
+    for (std::size_t i = 0; i < num_threads; ++i) {
+      workers_.emplace_back([this] {
+        while (true) {
+          std::packaged_task<std::string()> task;
+          {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+              return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  /**
+   * @brief Destructor, completes queued tasks first
+   */
+  ~compression_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker: workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * @brief Queue a task
+   * @param task Task
+   * @return Future of the task result
+   */
+  std::future<std::string> submit(std::packaged_task<std::string()> task) {
+    auto result = task.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      queue_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+    return result;
+  }
+
+  /**
+   * @brief Fetch the pool shared by all writers
+   * @return Pool
+   */
+  static compression_pool &instance() {
+    // Never destroyed, writers may still compress during process exit
+    static auto *pool = new compression_pool(std::max(std::thread::hardware_concurrency(), 1U));
+    return *pool;
+  }
+
+ private:
+  /* Queued tasks */
+  std::deque<std::packaged_task<std::string()>> queue_;
+  /* Queue mutex */
+  std::mutex mtx_;
+  /* Signalled when tasks are queued or the pool stops */
+  std::condition_variable cv_;
+  /* Stop flag */
+  bool stop_;
+  /* Worker threads */
+  std::vector<std::thread> workers_;
+};
+
+compressed_write_buf::compressed_write_buf(std::shared_ptr<codec> c, std::size_t chunk_size, std::size_t max_chunks)
+    : codec_(std::move(c)),
+      chunk_size_(chunk_size),
+      max_chunks_(max_chunks),
+      offset_(0),
+      failed_(false) {}
+
+compressed_write_buf::~compressed_write_buf() {
+  close();
+}
+
+bool compressed_write_buf::open(const std::string &path) {
+  close();
+  std::unique_ptr<async_ofstream> out(new async_ofstream(path));
+  if (!*out) {
+    return false;
+  }
+  std::uint32_t header[2] = {COMPRESSED_MAGIC, codec_->id()};
+  out->write(reinterpret_cast<const char *>(header), HEADER_SIZE);
+  out_ = std::move(out);
+  offset_ = 0;
+  failed_ = false;
+  chunk_.resize(chunk_size_);
+  setp(chunk_.data(), chunk_.data() + chunk_size_);
+  return true;
+}
+
+bool compressed_write_buf::close() {
+  if (out_ == nullptr) {
+    return true;
+  }
+  bool ok = sync() == 0;
+  out_->close();
+  ok = ok && !out_->bad();
+  out_.reset();
+  chunk_.clear();
+  chunk_.shrink_to_fit();
+  setp(nullptr, nullptr);
+  return ok;
+}
+
+compressed_write_buf::int_type compressed_write_buf::overflow(int_type c) {
+  if (out_ == nullptr) {
+    return traits_type::eof();
+  }
+  submit_chunk();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+int compressed_write_buf::sync() {
+  if (out_ == nullptr) {
+    return 0;
+  }
+  if (pptr() != pbase()) {
+    submit_chunk();
+  }
+  while (!frames_.empty()) {
+    write_frame();
+  }
+  out_->flush();
+  return failed_ || !*out_ ? -1 : 0;
+}
+
+compressed_write_buf::pos_type compressed_write_buf::seekoff(off_type off,
+                                                             std::ios_base::seekdir dir,
+                                                             std::ios_base::openmode which) {
+  // Only reports the uncompressed position, for tellp()
+  if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out) || out_ == nullptr) {
+    return pos_type(off_type(-1));
+  }
+  return pos_type(static_cast<off_type>(offset_ + (pptr() - pbase())));
+}
+
+void compressed_write_buf::submit_chunk() {
+  auto size = static_cast<std::size_t>(pptr() - pbase());
+  if (size > 0) {
+    chunk_.resize(size);
+    auto c = codec_;
+    frames_.push_back(compression_pool::instance().submit(std::packaged_task<std::string()>(
+        [c, raw = std::move(chunk_)] {
+      std::string payload;
+      c->compress(raw.data(), raw.size(), payload);
+      bool stored_raw = payload.size() >= raw.size();
+      std::uint32_t header[2] = {static_cast<std::uint32_t>(raw.size()),
+                                 static_cast<std::uint32_t>(stored_raw ? raw.size() : payload.size())};
+      std::string frame(reinterpret_cast<const char *>(header), FRAME_HEADER_SIZE);
+      if (stored_raw) {
+        frame.append(raw.data(), raw.size());
+      } else {
+        frame.append(payload);
+      }
+      return frame;
+    })));
+    offset_ += size;
+    if (frames_.size() >= max_chunks_) {
+      write_frame();
+    }
+  }
+  chunk_ = std::vector<char>(chunk_size_);
+  setp(chunk_.data(), chunk_.data() + chunk_size_);
+}
+
+void compressed_write_buf::write_frame() {
+  auto f = std::move(frames_.front());
+  frames_.pop_front();
+  try {
+    auto frame = f.get();
+    out_->write(frame.data(), frame.size());
+  } catch (std::exception &e) {
+    LOG(log_level::error) << "Failed to compress frame: " << e.what();
+    failed_ = true;
+  }
+}
+
+bool compressed_read_buf::open(const std::string &path) {
+  close();
+  mapped_file in(path);
+  if (!in.is_open()) {
+    return false;
+  }
+  std::uint32_t header[2] = {0, 0};
+  if (in.size() >= HEADER_SIZE) {
+    std::memcpy(header, in.data(), HEADER_SIZE);
+  }
+  if (header[0] != COMPRESSED_MAGIC) {
+    throw std::runtime_error(path + " is not a compressed file");
+  }
+  auto c = codec::from_id(header[1]);
+
+  // Locate the frames; a frame cut short by a crash ends the file
+  struct frame {
+    const char *src;
+    std::size_t stored_size;
+    std::size_t raw_offset;
+    std::size_t raw_size;
+  };
+  std::vector<frame> frames;
+  std::size_t pos = HEADER_SIZE;
+  std::size_t raw_size = 0;
+  while (in.size() - pos >= FRAME_HEADER_SIZE) {
+    std::uint32_t sizes[2];
+    std::memcpy(sizes, in.data() + pos, FRAME_HEADER_SIZE);
+    if (in.size() - pos - FRAME_HEADER_SIZE < sizes[1] || sizes[1] > sizes[0]) {
+      LOG(log_level::warn) << "Ignoring truncated frame at offset " << pos << " of " << path;
+      break;
+    }
+    frames.push_back(frame{in.data() + pos + FRAME_HEADER_SIZE, sizes[1], raw_size, sizes[0]});
+    raw_size += sizes[0];
+    pos += FRAME_HEADER_SIZE + sizes[1];
+  }
+
+  // Frames are independent, so they are decompressed on several threads
+  data_.resize(raw_size);
+  auto num_threads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1U), frames.size());
+  num_threads = std::max<std::size_t>(num_threads, 1);
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto decompress = [&](std::size_t t) {
+    try {
+      for (auto i = t; i < frames.size(); i += num_threads) {
+        const auto &f = frames[i];
+        if (f.stored_size == f.raw_size) {
+          std::memcpy(data_.data() + f.raw_offset, f.src, f.raw_size);
+        } else {
+          c->decompress(f.src, f.stored_size, data_.data() + f.raw_offset, f.raw_size);
+        }
+      }
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < num_threads; ++t) {
+    workers.emplace_back(decompress, t);
+  }
+  decompress(0);
+  for (auto &w: workers) {
+    w.join();
+  }
+  for (const auto &e: errors) {
+    if (e != nullptr) {
+      data_.clear();
+      std::rethrow_exception(e);
+    }
+  }
+  setg(data_.data(), data_.data(), data_.data() + data_.size());
+  return true;
+}
+
+void compressed_read_buf::close() {
+  data_.clear();
+  data_.shrink_to_fit();
+  setg(nullptr, nullptr, nullptr);
+}
+
+const char *compressed_read_buf::data() const {
+  return data_.data();
+}
+
+std::size_t compressed_read_buf::size() const {
+  return data_.size();
+}
+
+compressed_read_buf::pos_type compressed_read_buf::seekoff(off_type off,
+                                                           std::ios_base::seekdir dir,
+                                                           std::ios_base::openmode which) {
+  // Only reports the position, for tellg()
+  if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::in)) {
+    return pos_type(off_type(-1));
+  }
+  return pos_type(static_cast<off_type>(gptr() - eback()));
+}
+
+compressed_ofstream::compressed_ofstream(const std::string &path, std::shared_ptr<codec> c)
+    : std::ostream(nullptr),
+      buf_(std::move(c), COMPRESSED_CHUNK_SIZE, std::max(std::thread::hardware_concurrency(), 1U)) {
+  rdbuf(&buf_);
+  if (!buf_.open(path)) {
+    setstate(std::ios_base::failbit);
+  }
+}
+
+void compressed_ofstream::close() {
+  if (!buf_.close()) {
+    setstate(std::ios_base::badbit);
+  }
+}
+
+compressed_ifstream::compressed_ifstream(const std::string &path) : std::istream(nullptr) {
+  rdbuf(&buf_);
+  if (!buf_.open(path)) {
+    setstate(std::ios_base::failbit);
+  }
+}
+
+void compressed_ifstream::close() {
+  buf_.close();
+}
+
+const char *compressed_ifstream::data() const {
+  return buf_.data();
+}
+
+std::size_t compressed_ifstream::size() const {
+  return buf_.size();
+}
+
+}
+}
@@ -0,0 +1,241 @@
+#ifndef JIFFY_COMPRESSION_H
+#define JIFFY_COMPRESSION_H
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "async_stream.h"
+#include "mapped_file.h"
+
+namespace jiffy {
+namespace persistent {
+
+/**
+ * @brief Block compression codec.
+ *
+ * Compressed files start with a header naming the codec, followed by independently compressed frames:
+ * [magic][codec id] ([raw size][stored size][payload])*. A frame whose stored size equals its raw size
+ * holds the raw bytes, for data that does not compress.
+ */
+class codec {
+ public:
+  virtual ~codec() = default;
+
+  /**
+   * @brief Fetch the codec identifier recorded in file headers
+   * @return Codec identifier
+   */
+  virtual std::uint32_t id() const = 0;
+
+  /**
+   * @brief Fetch the codec name
+   * @return Codec name
+   */
+  virtual std::string name() const = 0;
+
+  /**
+   * @brief Compress a buffer
+   * @param src Source bytes
+   * @param size Number of source bytes
+   * @param dst Destination, resized to the compressed size
+   */
+  virtual void compress(const char *src, std::size_t size, std::string &dst) const = 0;
+
+  /**
+   * @brief Decompress a buffer
+   * @param src Compressed bytes
+   * @param size Number of compressed bytes
+   * @param dst Destination
+   * @param raw_size Number of bytes the source decompresses to
+   */
+  virtual void decompress(const char *src, std::size_t size, char *dst, std::size_t raw_size) const = 0;
+
+  /**
+   * @brief Make a codec by name
+   * @param name Codec name, "lz4" or "zstd"
+   * @return Codec
+   */
+  static std::shared_ptr<codec> make(const std::string &name);
+
+  /**
+   * @brief Make the codec recorded in a file header
+   * @param id Codec identifier
+   * @return Codec
+   */
+  static std::shared_ptr<codec> from_id(std::uint32_t id);
+};
+
+/**
+ * @brief Stream buffer writing a compressed file.
+ *
+ * Data is gathered in chunks; full chunks are compressed on a pool of threads shared by all writers and
+ * the resulting frames are written in order through an asynchronous file stream, so compression of several
+ * chunks overlaps with serialization and the disk.
+ */
+class compressed_write_buf : public std::streambuf {
+ public:
+  /**
+   * @brief Constructor
+   * @param c Codec
+   * @param chunk_size Chunk size
+   * @param max_chunks Maximum number of chunks being compressed
+   */
+  compressed_write_buf(std::shared_ptr<codec> c, std::size_t chunk_size, std::size_t max_chunks);
+
+  /**
+   * @brief Destructor, closes the file
+   */
+  ~compressed_write_buf() override;
+
+  /**
+   * @brief Create or truncate a file, open it and write the header
+   * @param path File path
+   * @return Bool value, true if the file was opened
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief Write out buffered data and close the file
+   * @return Bool value, true if all data was written
+   */
+  bool close();
+
+ protected:
+  int_type overflow(int_type c) override;
+
+  int sync() override;
+
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+ private:
+  /**
+   * @brief Hand the current chunk to the compression threads and start filling a new one
+   */
+  void submit_chunk();
+
+  /**
+   * @brief Wait for the oldest chunk being compressed and write its frame
+   */
+  void write_frame();
+
+  /* Codec */
+  std::shared_ptr<codec> codec_;
+  /* Chunk size */
+  std::size_t chunk_size_;
+  /* Maximum number of chunks being compressed */
+  std::size_t max_chunks_;
+  /* Compressed file, null if closed */
+  std::unique_ptr<async_ofstream> out_;
+  /* Number of uncompressed bytes of submitted chunks */
+  std::uint64_t offset_;
+  /* Chunk being filled */
+  std::vector<char> chunk_;
+  /* Frames being compressed, in file order */
+  std::deque<std::future<std::string>> frames_;
+  /* Bool value, true if compression or writing failed */
+  bool failed_;
+};
+
+/**
+ * @brief Stream buffer reading a compressed file.
+ *
+ * The file is mapped and its frames are decompressed on several threads into one buffer when the file
+ * is opened.
+ */
+class compressed_read_buf : public std::streambuf {
+ public:
+  compressed_read_buf() = default;
+
+  /**
+   * @brief Open and decompress a file
+   * @param path File path
+   * @return Bool value, true if the file was opened
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief Release the decompressed data
+   */
+  void close();
+
+  /**
+   * @brief Fetch the decompressed data
+   * @return Decompressed data
+   */
+  const char *data() const;
+
+  /**
+   * @brief Fetch the decompressed size
+   * @return Decompressed size
+   */
+  std::size_t size() const;
+
+ protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+ private:
+  /* Decompressed data */
+  std::vector<char> data_;
+};
+
+/* Output file stream writing a compressed file */
+class compressed_ofstream : public std::ostream {
+ public:
+  /**
+   * @brief Constructor, creates or truncates the file
+   * @param path File path
+   * @param c Codec
+   */
+  compressed_ofstream(const std::string &path, std::shared_ptr<codec> c);
+
+  /**
+   * @brief Write out buffered data and close the file
+   */
+  void close();
+
+ private:
+  /* Stream buffer */
+  compressed_write_buf buf_;
+};
+
+/* Input file stream reading a compressed file */
+class compressed_ifstream : public std::istream {
+ public:
+  /**
+   * @brief Constructor
+   * @param path File path
+   */
+  explicit compressed_ifstream(const std::string &path);
+
+  /**
+   * @brief Close the file
+   */
+  void close();
+
+  /**
+   * @brief Fetch the decompressed contents, for loaders that parse records in place
+   * @return Decompressed contents
+   */
+  const char *data() const;
+
+  /**
+   * @brief Fetch the decompressed size
+   * @return Decompressed size
+   */
+  std::size_t size() const;
+
+ private:
+  /* Stream buffer */
+  compressed_read_buf buf_;
+};
+
+}
+}
+
+#endif //JIFFY_COMPRESSION_H
@@ -0,0 +1,86 @@
+#include "crc32c.h"
+#include <cstring>
+
+namespace jiffy {
+namespace persistent {
+
+/* Reflected CRC32C polynomial */
+static const std::uint32_t CRC32C_POLY = 0x82f63b78;
+
+/* Slicing-by-8 lookup tables */
+struct crc32c_tables {
+  std::uint32_t t[8][256];
+
+  crc32c_tables() {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t crc = i;
+      for (int j = 0; j < 8; ++j) {
+        crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+      }
+      t[0][i] = crc;
+    }
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      for (int k = 1; k < 8; ++k) {
+        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+      }
+    }
+  }
+};
+
+static std::uint32_t crc32c_software(std::uint32_t crc, const unsigned char *p, std::size_t size) {
+  static const crc32c_tables tables;
+  const auto &t = tables.t;
+  while (size >= 8) {
+    std::uint32_t lo;
+    std::uint32_t hi;
+    std::memcpy(&lo, p, 4);
+    std::memcpy(&hi, p + 4, 4);
+    lo ^= crc;
+    crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+        ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    p += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+__attribute__((target("sse4.2")))
+static std::uint32_t crc32c_hardware(std::uint32_t crc, const unsigned char *p, std::size_t size) {
+  std::uint64_t crc64 = crc;
+  while (size >= 8) {
+    std::uint64_t word;
+    std::memcpy(&word, p, 8);
+    crc64 = __builtin_ia32_crc32di(crc64, word);
+    p += 8;
+    size -= 8;
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+  while (size-- > 0) {
+    crc = __builtin_ia32_crc32qi(crc, *p++);
+  }
+  return crc;
+}
+
+static bool has_sse42() {
+  static const bool supported = __builtin_cpu_supports("sse4.2");
+  return supported;
+}
+#endif
+
+std::uint32_t crc32c(std::uint32_t crc, const char *data, std::size_t size) {
+  auto p = reinterpret_cast<const unsigned char *>(data);
+  crc = ~crc;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  if (has_sse42()) {
+    return ~crc32c_hardware(crc, p, size);
+  }
+#endif
+  return ~crc32c_software(crc, p, size);
+}
+
+}
+}
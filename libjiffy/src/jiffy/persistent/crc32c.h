@@ -0,0 +1,22 @@
+#ifndef JIFFY_CRC32C_H
+#define JIFFY_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace jiffy {
+namespace persistent {
+
+/**
+ * @brief Extend a CRC32C (Castagnoli) checksum, using the SSE4.2 crc32 instruction when the CPU has it
+ * @param crc Checksum of the preceding bytes, 0 to start a new checksum
+ * @param data Bytes
+ * @param size Number of bytes
+ * @return Checksum of the preceding bytes followed by data
+ */
+std::uint32_t crc32c(std::uint32_t crc, const char *data, std::size_t size);
+
+}
+}
+
+#endif //JIFFY_CRC32C_H
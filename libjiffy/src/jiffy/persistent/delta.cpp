@@ -0,0 +1,185 @@
+#include "delta.h"
+#include <algorithm>
+
+namespace jiffy {
+namespace persistent {
+
+/* Marks the start of an encoded delta */
+static const std::uint32_t DELTA_MAGIC = 0x544c444a;
+
+/* Largest item accepted when decoding, guards against reading garbage lengths */
+static const std::uint64_t MAX_DELTA_ITEM_SIZE = 1ULL << 32;
+
+template<typename T>
+static void write_value(std::ostream &out, T value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool read_value(std::istream &in, T &value) {
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+  return static_cast<std::size_t>(in.gcount()) == sizeof(T);
+}
+
+/* Identifier of the record holding the write-ahead log segment of a delta, never a unit identifier */
+static const std::uint64_t LOG_SEGMENT_RECORD_ID = UINT64_MAX;
+
+void set_log_segment(delta &d, std::uint64_t segment) {
+  if (segment == 0) {
+    return;
+  }
+  d.push_back(delta_record{LOG_SEGMENT_RECORD_ID, {std::to_string(segment)}});
+}
+
+std::uint64_t take_log_segment(delta &d) {
+  std::uint64_t segment = 0;
+  auto it = std::remove_if(d.begin(), d.end(), [&segment](const delta_record &r) {
+    if (r.id != LOG_SEGMENT_RECORD_ID || r.items.size() != 1) {
+      return false;
+    }
+    segment = std::max<std::uint64_t>(segment, std::stoull(r.items[0]));
+    return true;
+  });
+  d.erase(it, d.end());
+  return segment;
+}
+
+std::size_t delta_size(const delta &d) {
+  std::size_t size = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+  for (const auto &r: d) {
+    size += 2 * sizeof(std::uint64_t);
+    for (const auto &item: r.items) {
+      size += sizeof(std::uint64_t) + item.size();
+    }
+  }
+  return size;
+}
+
+void encode_delta(std::ostream &out, const delta &d) {
+  write_value(out, DELTA_MAGIC);
+  write_value(out, static_cast<std::uint64_t>(d.size()));
+  for (const auto &r: d) {
+    write_value(out, r.id);
+    write_value(out, static_cast<std::uint64_t>(r.items.size()));
+    for (const auto &item: r.items) {
+      write_value(out, static_cast<std::uint64_t>(item.size()));
+      out.write(item.data(), item.size());
+    }
+  }
+}
+
+bool decode_delta(std::istream &in, delta &d) {
+  std::uint32_t magic;
+  std::uint64_t num_records;
+  if (!read_value(in, magic) || magic != DELTA_MAGIC || !read_value(in, num_records)) {
+    return false;
+  }
+  d.clear();
+  for (std::uint64_t i = 0; i < num_records; ++i) {
+    delta_record r;
+    std::uint64_t num_items;
+    if (!read_value(in, r.id) || !read_value(in, num_items)) {
+      return false;
+    }
+    for (std::uint64_t j = 0; j < num_items; ++j) {
+      std::uint64_t size;
+      if (!read_value(in, size) || size > MAX_DELTA_ITEM_SIZE) {
+        return false;
+      }
+      std::string item(size, '\0');
+      in.read(&item[0], static_cast<std::streamsize>(size));
+      if (static_cast<std::uint64_t>(in.gcount()) != size) {
+        return false;
+      }
+      r.items.push_back(std::move(item));
+    }
+    d.push_back(std::move(r));
+  }
+  return true;
+}
+
+dirty_set::dirty_set(std::size_t num_units) : num_units_(num_units), all_(false) {}
+
+void dirty_set::add(std::size_t unit) {
+  if (all_) {
+    return;
+  }
+  if (unit >= num_units_) {
+    add_all();
+    return;
+  }
+  if (flags_.empty()) {
+    flags_.resize(num_units_, false);
+  }
+  if (!flags_[unit]) {
+    flags_[unit] = true;
+    units_.push_back(unit);
+  }
+}
+
+void dirty_set::add_range(std::size_t begin, std::size_t end) {
+  end = std::min(end, num_units_);
+  for (auto unit = begin; unit < end && !all_; ++unit) {
+    add(unit);
+  }
+}
+
+void dirty_set::add_all() {
+  all_ = true;
+  flags_.clear();
+  units_.clear();
+}
+
+bool dirty_set::all() const {
+  return all_;
+}
+
+bool dirty_set::empty() const {
+  return !all_ && units_.empty();
+}
+
+const std::vector<std::size_t> &dirty_set::units() const {
+  return units_;
+}
+
+void dirty_set::clear() {
+  for (auto unit: units_) {
+    flags_[unit] = false;
+  }
+  units_.clear();
+  all_ = false;
+}
+
+delta_log::delta_log(std::size_t max_deltas, double max_ratio)
+    : num_deltas_(0), delta_bytes_(0), max_deltas_(max_deltas), max_ratio_(max_ratio) {}
+
+bool delta_log::can_append(const std::string &path, std::size_t delta_bytes, std::size_t base_bytes) const {
+  return has_base(path) && num_deltas_ < max_deltas_
+      && static_cast<double>(delta_bytes_ + delta_bytes) <= max_ratio_ * static_cast<double>(base_bytes);
+}
+
+std::size_t delta_log::append(std::size_t delta_bytes) {
+  delta_bytes_ += delta_bytes;
+  return ++num_deltas_;
+}
+
+void delta_log::reset(const std::string &path, std::size_t num_deltas, std::size_t delta_bytes) {
+  path_ = path;
+  num_deltas_ = num_deltas;
+  delta_bytes_ = delta_bytes;
+}
+
+void delta_log::clear() {
+  reset("");
+}
+
+std::size_t delta_log::num_deltas() const {
+  return num_deltas_;
+}
+
+bool delta_log::has_base(const std::string &path) const {
+  return !path_.empty() && path == path_;
+}
+
+}
+}
@@ -0,0 +1,203 @@
+#ifndef JIFFY_DELTA_H
+#define JIFFY_DELTA_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace jiffy {
+namespace persistent {
+
+/**
+ * Changed unit of a partition, e.g. a hash slot, a file page or a run of appended items.
+ * Replaying a record replaces the unit with the record items.
+ */
+struct delta_record {
+  /* Unit identifier */
+  std::uint64_t id;
+  /* Contents of the unit, the layout depends on the data structure */
+  std::vector<std::string> items;
+};
+
+/* Changes of a partition since its previous sync */
+typedef std::vector<delta_record> delta;
+
+/**
+ * @brief Record the last write-ahead log segment whose commands a delta holds
+ * @param d Delta
+ * @param segment Segment number, 0 to record none
+ */
+void set_log_segment(delta &d, std::uint64_t segment);
+
+/**
+ * @brief Remove the write-ahead log segment recorded in a delta, so that only changed units remain
+ * @param d Delta
+ * @return Segment number, 0 if none was recorded
+ */
+std::uint64_t take_log_segment(delta &d);
+
+/**
+ * @brief Fetch the encoded size of a delta
+ * @param d Delta
+ * @return Encoded size
+ */
+std::size_t delta_size(const delta &d);
+
+/**
+ * @brief Encode a delta
+ * @param out Output stream
+ * @param d Delta
+ */
+void encode_delta(std::ostream &out, const delta &d);
+
+/**
+ * @brief Decode a delta
+ * @param in Input stream
+ * @param d Delta
+ * @return Bool value, false if the stream does not hold a complete delta
+ */
+bool decode_delta(std::istream &in, delta &d);
+
+/**
+ * @brief Set of dirty units out of a fixed number of units.
+ *
+ * Marking a unit out of range, or all units, makes the whole partition dirty so that the next sync
+ * writes a full image.
+ */
+class dirty_set {
+ public:
+  /**
+   * @brief Constructor
+   * @param num_units Number of units
+   */
+  explicit dirty_set(std::size_t num_units = 0);
+
+  /**
+   * @brief Mark a unit dirty
+   * @param unit Unit
+   */
+  void add(std::size_t unit);
+
+  /**
+   * @brief Mark units [begin, end) dirty, units out of range are ignored
+   * @param begin Begin unit
+   * @param end End unit
+   */
+  void add_range(std::size_t begin, std::size_t end);
+
+  /**
+   * @brief Mark all units dirty
+   */
+  void add_all();
+
+  /**
+   * @brief Check if all units are dirty
+   * @return Bool value, true if all units are dirty
+   */
+  bool all() const;
+
+  /**
+   * @brief Check if no unit is dirty
+   * @return Bool value, true if no unit is dirty
+   */
+  bool empty() const;
+
+  /**
+   * @brief Fetch the dirty units, in the order they were first marked; meaningless if all() holds
+   * @return Dirty units
+   */
+  const std::vector<std::size_t> &units() const;
+
+  /**
+   * @brief Mark all units clean
+   */
+  void clear();
+
+ private:
+  /* Number of units */
+  std::size_t num_units_;
+  /* Dirty flag of each unit, allocated on first use */
+  std::vector<bool> flags_;
+  /* Dirty units */
+  std::vector<std::size_t> units_;
+  /* Bool value, true if all units are dirty */
+  bool all_;
+};
+
+/**
+ * @brief Bookkeeping of the delta files that extend the base image of a partition.
+ *
+ * Deltas are only appended to the base image the partition last wrote or loaded. A sync writes a
+ * full image instead once the number of deltas or their total size relative to the partition
+ * reaches its limit, so that loading never replays an unbounded chain.
+ */
+class delta_log {
+ public:
+  /**
+   * @brief Constructor
+   * @param max_deltas Maximum number of deltas per base image
+   * @param max_ratio Maximum total size of the deltas, as a fraction of the partition size
+   */
+  explicit delta_log(std::size_t max_deltas = 16, double max_ratio = 0.5);
+
+  /**
+   * @brief Check if a delta can be appended or the base image should be rewritten
+   * @param path Persistent store path of the sync
+   * @param delta_bytes Encoded size of the delta
+   * @param base_bytes Size of the partition
+   * @return Bool value, true if the delta can be appended
+   */
+  bool can_append(const std::string &path, std::size_t delta_bytes, std::size_t base_bytes) const;
+
+  /**
+   * @brief Record an appended delta
+   * @param delta_bytes Encoded size of the delta
+   * @return Sequence number of the delta
+   */
+  std::size_t append(std::size_t delta_bytes);
+
+  /**
+   * @brief Reset after the base image was written or loaded
+   * @param path Persistent store path of the base image
+   * @param num_deltas Number of deltas that extend the base image
+   * @param delta_bytes Total size of the deltas
+   */
+  void reset(const std::string &path, std::size_t num_deltas = 0, std::size_t delta_bytes = 0);
+
+  /**
+   * @brief Forget the base image, the next sync writes a full image
+   */
+  void clear();
+
+  /**
+   * @brief Fetch the number of deltas that extend the base image
+   * @return Number of deltas
+   */
+  std::size_t num_deltas() const;
+
+  /**
+   * @brief Check if the base image was written to or loaded from a path
+   * @param path Persistent store path
+   * @return Bool value, true if the base image is at the path
+   */
+  bool has_base(const std::string &path) const;
+
+ private:
+  /* Persistent store path of the base image, empty if none */
+  std::string path_;
+  /* Number of deltas */
+  std::size_t num_deltas_;
+  /* Total size of the deltas */
+  std::size_t delta_bytes_;
+  /* Maximum number of deltas */
+  std::size_t max_deltas_;
+  /* Maximum total size of the deltas relative to the partition size */
+  double max_ratio_;
+};
+
+}
+}
+
+#endif //JIFFY_DELTA_H
@@ -0,0 +1,308 @@
+#include "indexed_file.h"
+#include "crc32c.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+namespace jiffy {
+namespace persistent {
+
+/* Marks an indexed file */
+static const std::uint32_t INDEXED_MAGIC = 0x5844494a;
+
+/* Current format version */
+static const std::uint32_t INDEXED_VERSION = 1;
+
+/* Flag set for files with an index in key order */
+static const std::uint32_t INDEXED_SORTED = 1;
+
+/* Minimum number of chunks verified by each thread */
+static const std::size_t CHUNKS_PER_THREAD = 256;
+
+static_assert(sizeof(indexed_file_header) == 88, "Indexed file header must not be padded");
+static_assert(sizeof(indexed_file_entry) == 24, "Indexed file entry must not be padded");
+
+const std::size_t indexed_file_writer::DEFAULT_CHUNK_SIZE;
+const std::size_t indexed_file::npos;
+
+indexed_file_writer::indexed_file_writer(const std::string &path,
+                                         indexed_layout layout,
+                                         bool sorted,
+                                         std::size_t chunk_size)
+    : path_(path),
+      out_(path, std::ios::binary | std::ios::trunc),
+      header_(),
+      chunk_crc_(0),
+      chunk_fill_(0),
+      metadata_crc_(0),
+      open_(static_cast<bool>(out_)) {
+  header_.version = INDEXED_VERSION;
+  header_.layout = static_cast<std::uint32_t>(layout);
+  header_.flags = sorted ? INDEXED_SORTED : 0;
+  header_.chunk_size = static_cast<std::uint32_t>(chunk_size);
+  // Zeroed until close, so a partially written file is rejected
+  out_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+}
+
+indexed_file_writer::~indexed_file_writer() {
+  close();
+}
+
+bool indexed_file_writer::is_open() const {
+  return open_;
+}
+
+void indexed_file_writer::set_aux(std::size_t i, std::uint64_t value) {
+  header_.aux[i] = value;
+}
+
+void indexed_file_writer::add(const char *key, std::size_t key_size, const char *value, std::size_t value_size) {
+  entries_.push_back(indexed_file_entry{header_.data_size, key_size, value_size});
+  if (header_.flags & INDEXED_SORTED) {
+    keys_.emplace_back(key, key_size);
+  }
+  write_data(key, key_size);
+  write_data(value, value_size);
+}
+
+bool indexed_file_writer::close() {
+  if (!open_) {
+    return false;
+  }
+  open_ = false;
+  if (chunk_fill_ > 0) {
+    checksums_.push_back(chunk_crc_);
+  }
+  header_.num_records = entries_.size();
+  header_.table_offset = sizeof(header_) + header_.data_size;
+  header_.checksum_offset = header_.table_offset + entries_.size() * sizeof(indexed_file_entry);
+  header_.index_offset = header_.checksum_offset + checksums_.size() * sizeof(std::uint32_t);
+  header_.num_chunks = static_cast<std::uint32_t>(checksums_.size());
+  write_metadata(reinterpret_cast<const char *>(entries_.data()), entries_.size() * sizeof(indexed_file_entry));
+  write_metadata(reinterpret_cast<const char *>(checksums_.data()), checksums_.size() * sizeof(std::uint32_t));
+  if (header_.flags & INDEXED_SORTED) {
+    std::vector<std::uint64_t> index(keys_.size());
+    std::iota(index.begin(), index.end(), 0);
+    std::sort(index.begin(), index.end(), [this](std::uint64_t a, std::uint64_t b) {
+      return keys_[a] < keys_[b];
+    });
+    write_metadata(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(std::uint64_t));
+  }
+  header_.magic = INDEXED_MAGIC;
+  header_.metadata_crc = metadata_crc_;
+  header_.header_crc = crc32c(0, reinterpret_cast<const char *>(&header_), offsetof(indexed_file_header, header_crc));
+  out_.flush();
+  out_.seekp(0, std::ios::beg);
+  out_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+  out_.close();
+  entries_.clear();
+  keys_.clear();
+  checksums_.clear();
+  return !out_.fail();
+}
+
+std::uint64_t indexed_file_writer::data_size() const {
+  return header_.data_size;
+}
+
+void indexed_file_writer::write_data(const char *data, std::size_t size) {
+  out_.write(data, size);
+  header_.data_size += size;
+  while (size > 0) {
+    auto n = std::min<std::size_t>(size, header_.chunk_size - chunk_fill_);
+    chunk_crc_ = crc32c(chunk_crc_, data, n);
+    chunk_fill_ += n;
+    data += n;
+    size -= n;
+    if (chunk_fill_ == header_.chunk_size) {
+      checksums_.push_back(chunk_crc_);
+      chunk_crc_ = 0;
+      chunk_fill_ = 0;
+    }
+  }
+}
+
+void indexed_file_writer::write_metadata(const char *data, std::size_t size) {
+  out_.write(data, size);
+  metadata_crc_ = crc32c(metadata_crc_, data, size);
+}
+
+indexed_file::indexed_file(const std::string &path, bool sequential)
+    : path_(path), file_(path, sequential), header_() {
+  if (!file_.is_open()) {
+    return;
+  }
+  if (file_.size() < sizeof(header_)) {
+    throw std::runtime_error(path + " is not an indexed file");
+  }
+  std::memcpy(&header_, file_.data(), sizeof(header_));
+  if (header_.magic != INDEXED_MAGIC
+      || header_.header_crc != crc32c(0, file_.data(), offsetof(indexed_file_header, header_crc))) {
+    throw std::runtime_error(path + " is not an indexed file or was not completely written");
+  }
+  if (header_.version != INDEXED_VERSION) {
+    throw std::runtime_error("Unsupported version " + std::to_string(header_.version) + " of " + path);
+  }
+  std::uint64_t index_size = sorted() ? header_.num_records * sizeof(std::uint64_t) : 0;
+  if (header_.chunk_size == 0
+      || header_.table_offset != sizeof(header_) + header_.data_size
+      || header_.checksum_offset != header_.table_offset + header_.num_records * sizeof(indexed_file_entry)
+      || header_.num_chunks != (header_.data_size + header_.chunk_size - 1) / header_.chunk_size
+      || header_.index_offset != header_.checksum_offset + header_.num_chunks * sizeof(std::uint32_t)
+      || header_.index_offset + index_size != file_.size()) {
+    throw std::runtime_error("Corrupt header in " + path);
+  }
+  auto metadata = file_.data() + header_.table_offset;
+  if (crc32c(0, metadata, file_.size() - header_.table_offset) != header_.metadata_crc) {
+    throw std::runtime_error("Checksum mismatch in the tables of " + path);
+  }
+  verified_.reset(new std::atomic<bool>[header_.num_chunks]);
+  for (std::size_t c = 0; c < header_.num_chunks; ++c) {
+    verified_[c].store(false, std::memory_order_relaxed);
+  }
+}
+
+bool indexed_file::is_open() const {
+  return file_.is_open();
+}
+
+indexed_layout indexed_file::layout() const {
+  return static_cast<indexed_layout>(header_.layout);
+}
+
+bool indexed_file::sorted() const {
+  return (header_.flags & INDEXED_SORTED) != 0;
+}
+
+std::size_t indexed_file::num_records() const {
+  return static_cast<std::size_t>(header_.num_records);
+}
+
+std::uint64_t indexed_file::data_size() const {
+  return header_.data_size;
+}
+
+std::uint64_t indexed_file::aux(std::size_t i) const {
+  return header_.aux[i];
+}
+
+indexed_file::record indexed_file::get(std::size_t i) const {
+  auto e = entry(i);
+  verify_range(e.offset, e.key_size + e.value_size);
+  auto key = file_.data() + sizeof(header_) + e.offset;
+  return record{key, static_cast<std::size_t>(e.key_size), key + e.key_size, static_cast<std::size_t>(e.value_size)};
+}
+
+std::uint64_t indexed_file::value_offset(std::size_t i) const {
+  auto e = entry(i);
+  return sizeof(header_) + e.offset + e.key_size;
+}
+
+std::size_t indexed_file::find(const char *key, std::size_t key_size) const {
+  if (!sorted()) {
+    throw std::logic_error(path_ + " has no key index");
+  }
+  auto index = file_.data() + header_.index_offset;
+  std::size_t lo = 0;
+  std::size_t hi = num_records();
+  while (lo < hi) {
+    auto mid = lo + (hi - lo) / 2;
+    std::uint64_t i;
+    std::memcpy(&i, index + mid * sizeof(std::uint64_t), sizeof(i));
+    auto e = entry(static_cast<std::size_t>(i));
+    verify_range(e.offset, e.key_size);
+    auto probe = file_.data() + sizeof(header_) + e.offset;
+    auto cmp = std::memcmp(probe, key, std::min<std::size_t>(e.key_size, key_size));
+    if (cmp == 0) {
+      if (e.key_size == key_size) {
+        return static_cast<std::size_t>(i);
+      }
+      cmp = e.key_size < key_size ? -1 : 1;
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return npos;
+}
+
+std::size_t indexed_file::find(const std::string &key) const {
+  return find(key.data(), key.size());
+}
+
+void indexed_file::verify() const {
+  std::size_t num_chunks = header_.num_chunks;
+  auto num_threads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1U),
+                                           (num_chunks + CHUNKS_PER_THREAD - 1) / CHUNKS_PER_THREAD);
+  num_threads = std::max<std::size_t>(num_threads, 1);
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto check = [&](std::size_t t) {
+    try {
+      for (auto c = t; c < num_chunks; c += num_threads) {
+        verify_chunk(c);
+      }
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < num_threads; ++t) {
+    workers.emplace_back(check, t);
+  }
+  check(0);
+  for (auto &w: workers) {
+    w.join();
+  }
+  for (const auto &e: errors) {
+    if (e != nullptr) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
+void indexed_file::verify_range(std::uint64_t offset, std::uint64_t size) const {
+  if (size == 0) {
+    return;
+  }
+  auto first = offset / header_.chunk_size;
+  auto last = (offset + size - 1) / header_.chunk_size;
+  for (auto c = first; c <= last; ++c) {
+    verify_chunk(static_cast<std::size_t>(c));
+  }
+}
+
+void indexed_file::verify_chunk(std::size_t chunk) const {
+  if (verified_[chunk].load(std::memory_order_acquire)) {
+    return;
+  }
+  std::uint64_t begin = static_cast<std::uint64_t>(chunk) * header_.chunk_size;
+  auto size = std::min<std::uint64_t>(header_.chunk_size, header_.data_size - begin);
+  std::uint32_t expected;
+  std::memcpy(&expected, file_.data() + header_.checksum_offset + chunk * sizeof(std::uint32_t), sizeof(expected));
+  if (crc32c(0, file_.data() + sizeof(header_) + begin, size) != expected) {
+    throw std::runtime_error("Checksum mismatch in chunk " + std::to_string(chunk) + " of " + path_);
+  }
+  verified_[chunk].store(true, std::memory_order_release);
+}
+
+indexed_file_entry indexed_file::entry(std::size_t i) const {
+  if (i >= num_records()) {
+    throw std::out_of_range("No record " + std::to_string(i) + " in " + path_);
+  }
+  indexed_file_entry e{};
+  std::memcpy(&e, file_.data() + header_.table_offset + i * sizeof(indexed_file_entry), sizeof(e));
+  if (e.offset > header_.data_size || e.key_size > header_.data_size - e.offset
+      || e.value_size > header_.data_size - e.offset - e.key_size) {
+    throw std::runtime_error("Corrupt record " + std::to_string(i) + " in " + path_);
+  }
+  return e;
+}
+
+}
+}
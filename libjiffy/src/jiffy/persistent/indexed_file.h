@@ -0,0 +1,310 @@
+#ifndef JIFFY_INDEXED_FILE_H
+#define JIFFY_INDEXED_FILE_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+namespace jiffy {
+namespace persistent {
+
+/* Data structure stored in an indexed file */
+enum class indexed_layout : std::uint32_t {
+  hash_table = 1,
+  fifo_queue = 2,
+  file = 3,
+  shared_log = 4
+};
+
+/**
+ * @brief Header of an indexed file.
+ *
+ * An indexed file holds a sequence of key value records in one file:
+ * [header][data][record table][chunk checksums][index]. The data section holds every record's key
+ * followed by its value; the record table has one fixed-width entry per record locating it in the data
+ * section; the data section is checksummed with CRC32C in fixed-size chunks; the trailing index lists
+ * the record numbers in key order for files written sorted. The header is written last, so a file cut
+ * short by a crash has no valid header.
+ */
+struct indexed_file_header {
+  /* Marks an indexed file */
+  std::uint32_t magic;
+  /* Format version */
+  std::uint32_t version;
+  /* Data structure layout */
+  std::uint32_t layout;
+  /* Flags, bit 0 set if the file has an index in key order */
+  std::uint32_t flags;
+  /* Number of records */
+  std::uint64_t num_records;
+  /* Data section size */
+  std::uint64_t data_size;
+  /* Record table file offset */
+  std::uint64_t table_offset;
+  /* Chunk checksum file offset */
+  std::uint64_t checksum_offset;
+  /* Index file offset */
+  std::uint64_t index_offset;
+  /* Layout specific values */
+  std::uint64_t aux[2];
+  /* Data section bytes per checksum */
+  std::uint32_t chunk_size;
+  /* Number of chunks */
+  std::uint32_t num_chunks;
+  /* Checksum of the record table, chunk checksums and index */
+  std::uint32_t metadata_crc;
+  /* Checksum of the header up to this field */
+  std::uint32_t header_crc;
+};
+
+/* Record table entry */
+struct indexed_file_entry {
+  /* Key offset in the data section, the value follows the key */
+  std::uint64_t offset;
+  /* Key size */
+  std::uint64_t key_size;
+  /* Value size */
+  std::uint64_t value_size;
+};
+
+/**
+ * @brief Writer of an indexed file.
+ * Records are streamed to the data section as they are added; tables and the header are written on close.
+ */
+class indexed_file_writer {
+ public:
+  /* Default data section bytes per checksum */
+  static const std::size_t DEFAULT_CHUNK_SIZE = 65536;
+
+  /**
+   * @brief Constructor, creates or truncates the file
+   * @param path File path
+   * @param layout Data structure layout
+   * @param sorted Bool value, true to write an index of the records in key order
+   * @param chunk_size Data section bytes per checksum
+   */
+  indexed_file_writer(const std::string &path,
+                      indexed_layout layout,
+                      bool sorted,
+                      std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+  /**
+   * @brief Destructor, closes the file
+   */
+  ~indexed_file_writer();
+
+  indexed_file_writer(const indexed_file_writer &) = delete;
+  indexed_file_writer &operator=(const indexed_file_writer &) = delete;
+
+  /**
+   * @brief Check if the file was created
+   * @return Bool value, true if the file is open
+   */
+  bool is_open() const;
+
+  /**
+   * @brief Set a layout specific value
+   * @param i Value number, 0 or 1
+   * @param value Value
+   */
+  void set_aux(std::size_t i, std::uint64_t value);
+
+  /**
+   * @brief Append a record
+   * @param key Key
+   * @param key_size Key size
+   * @param value Value
+   * @param value_size Value size
+   */
+  void add(const char *key, std::size_t key_size, const char *value, std::size_t value_size);
+
+  /**
+   * @brief Write the tables and the header and close the file
+   * @return Bool value, true if the whole file was written
+   */
+  bool close();
+
+  /**
+   * @brief Fetch the number of bytes of the data section written so far
+   * @return Data section size
+   */
+  std::uint64_t data_size() const;
+
+ private:
+  /**
+   * @brief Write bytes of the data section, checksumming them
+   * @param data Bytes
+   * @param size Number of bytes
+   */
+  void write_data(const char *data, std::size_t size);
+
+  /**
+   * @brief Write bytes after the data section, checksumming them
+   * @param data Bytes
+   * @param size Number of bytes
+   */
+  void write_metadata(const char *data, std::size_t size);
+
+  /* File path */
+  std::string path_;
+  /* File stream */
+  std::ofstream out_;
+  /* Header, completed on close */
+  indexed_file_header header_;
+  /* Record table */
+  std::vector<indexed_file_entry> entries_;
+  /* Keys, kept to build the index of sorted files */
+  std::vector<std::string> keys_;
+  /* Checksums of complete chunks */
+  std::vector<std::uint32_t> checksums_;
+  /* Checksum of the chunk being written */
+  std::uint32_t chunk_crc_;
+  /* Bytes of the chunk being written */
+  std::size_t chunk_fill_;
+  /* Checksum of the metadata written so far */
+  std::uint32_t metadata_crc_;
+  /* Bool value, true if the file is open */
+  bool open_;
+};
+
+/**
+ * @brief Read-only view of an indexed file.
+ *
+ * The file is mapped and its header and tables are validated when it is opened; records are read in
+ * place and each chunk of the data section is checked against its checksum the first time a record in
+ * it is read, so a point lookup only touches the chunks it needs. Lookups by key binary search the index
+ * of sorted files.
+ */
+class indexed_file {
+ public:
+  /* Record located in the mapped file */
+  struct record {
+    const char *key;
+    std::size_t key_size;
+    const char *value;
+    std::size_t value_size;
+  };
+
+  /* Record number returned for missing keys */
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+  /**
+   * @brief Constructor, maps the file and validates its header and tables
+   * @param path File path
+   * @param sequential Bool value, true if the whole file is read front to back, false for point lookups
+   */
+  explicit indexed_file(const std::string &path, bool sequential = false);
+
+  indexed_file(const indexed_file &) = delete;
+  indexed_file &operator=(const indexed_file &) = delete;
+
+  /**
+   * @brief Check if the file exists
+   * @return Bool value, false if the file could not be opened
+   */
+  bool is_open() const;
+
+  /**
+   * @brief Fetch the data structure layout
+   * @return Layout
+   */
+  indexed_layout layout() const;
+
+  /**
+   * @brief Check if the file has an index in key order
+   * @return Bool value, true if lookups by key are supported
+   */
+  bool sorted() const;
+
+  /**
+   * @brief Fetch the number of records
+   * @return Number of records
+   */
+  std::size_t num_records() const;
+
+  /**
+   * @brief Fetch the data section size
+   * @return Data section size
+   */
+  std::uint64_t data_size() const;
+
+  /**
+   * @brief Fetch a layout specific value
+   * @param i Value number, 0 or 1
+   * @return Value
+   */
+  std::uint64_t aux(std::size_t i) const;
+
+  /**
+   * @brief Fetch a record, verifying the chunks it spans
+   * @param i Record number
+   * @return Record
+   */
+  record get(std::size_t i) const;
+
+  /**
+   * @brief Fetch the file offset of the value of a record
+   * @param i Record number
+   * @return Value file offset
+   */
+  std::uint64_t value_offset(std::size_t i) const;
+
+  /**
+   * @brief Look up a key in a sorted file
+   * @param key Key
+   * @param key_size Key size
+   * @return Record number, npos if the key is missing
+   */
+  std::size_t find(const char *key, std::size_t key_size) const;
+
+  /**
+   * @brief Look up a key in a sorted file
+   * @param key Key
+   * @return Record number, npos if the key is missing
+   */
+  std::size_t find(const std::string &key) const;
+
+  /**
+   * @brief Verify every chunk of the data section, on several threads
+   */
+  void verify() const;
+
+ private:
+  /**
+   * @brief Verify the chunks spanning a range of the data section
+   * @param offset Range offset in the data section
+   * @param size Range size
+   */
+  void verify_range(std::uint64_t offset, std::uint64_t size) const;
+
+  /**
+   * @brief Verify a chunk of the data section
+   * @param chunk Chunk number
+   */
+  void verify_chunk(std::size_t chunk) const;
+
+  /**
+   * @brief Fetch the record table entry of a record
+   * @param i Record number
+   * @return Record table entry
+   */
+  indexed_file_entry entry(std::size_t i) const;
+
+  /* File path */
+  std::string path_;
+  /* Mapped file */
+  mapped_file file_;
+  /* Validated header */
+  indexed_file_header header_;
+  /* Bool values, true for chunks that matched their checksum */
+  std::unique_ptr<std::atomic<bool>[]> verified_;
+};
+
+}
+}
+
+#endif //JIFFY_INDEXED_FILE_H
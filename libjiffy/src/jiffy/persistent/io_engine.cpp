@@ -0,0 +1,379 @@
+#include "io_engine.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <unistd.h>
+#include "jiffy/utils/logger.h"
+
+#ifdef IO_URING_IN_USE
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace jiffy {
+namespace persistent {
+
+using namespace utils;
+
+/* Largest transfer issued at once, longer requests are split */
+static const std::size_t MAX_TRANSFER_SIZE = 1UL << 30;
+
+/**
+ * @brief Run the callback of a request, logging instead of propagating its exceptions, since an
+ * exception escaping an engine thread would terminate the server
+ * @param req Request
+ * @param result Number of bytes transferred, or negative errno
+ */
+static void run_callback(io_request &req, std::int64_t result) {
+  try {
+    req.callback(result);
+  } catch (std::exception &e) {
+    LOG(log_level::error) << "I/O request callback failed: " << e.what();
+  } catch (...) {
+    LOG(log_level::error) << "I/O request callback failed";
+  }
+}
+
+std::int64_t io_engine::transfer(const io_request &req) {
+  std::size_t done = 0;
+  while (done < req.size) {
+    auto len = std::min(req.size - done, MAX_TRANSFER_SIZE);
+    auto off = static_cast<off_t>(req.offset + done);
+    auto n = req.op == io_op::read ? ::pread(req.fd, req.buf + done, len, off)
+                                   : ::pwrite(req.fd, req.buf + done, len, off);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return -errno;
+    }
+    if (n == 0) {
+      break;
+    }
+    done += static_cast<std::size_t>(n);
+  }
+  return static_cast<std::int64_t>(done);
+}
+
+std::int64_t io_engine::run(io_op op, int fd, char *buf, std::size_t size, std::uint64_t offset) {
+  auto result = std::make_shared<std::promise<std::int64_t>>();
+  auto future = result->get_future();
+  std::vector<io_request> batch(1);
+  batch[0] = io_request{op, fd, buf, size, offset, [result](std::int64_t n) { result->set_value(n); }};
+  submit(batch);
+  return future.get();
+}
+
+/* Engine configuration used by instance() */
+static std::mutex instance_mtx;
+static std::string instance_engine = "auto";
+static std::size_t instance_num_threads = 4;
+static std::size_t instance_queue_depth = 256;
+
+std::shared_ptr<io_engine> io_engine::create(const std::string &engine,
+                                             std::size_t num_threads,
+                                             std::size_t queue_depth) {
+  if (engine != "auto" && engine != "io_uring" && engine != "thread_pool") {
+    throw std::invalid_argument("No such I/O engine " + engine);
+  }
+  if (engine != "thread_pool") {
+#ifdef IO_URING_IN_USE
+    try {
+      return std::make_shared<uring_io_engine>(queue_depth);
+    } catch (std::exception &e) {
+      LOG(log_level::info) << "io_uring unavailable (" << e.what() << "), using the thread pool I/O engine";
+    }
+#else
+    LOG(log_level::info) << "Built without io_uring support, using the thread pool I/O engine";
+#endif
+  }
+  return std::make_shared<thread_pool_io_engine>(std::max<std::size_t>(num_threads, 1));
+}
+
+void io_engine::configure(const std::string &engine, std::size_t num_threads, std::size_t queue_depth) {
+  std::lock_guard<std::mutex> lock(instance_mtx);
+  instance_engine = engine;
+  instance_num_threads = num_threads;
+  instance_queue_depth = queue_depth;
+}
+
+std::shared_ptr<io_engine> io_engine::instance() {
+  static std::shared_ptr<io_engine> engine;
+  std::lock_guard<std::mutex> lock(instance_mtx);
+  if (engine == nullptr) {
+    engine = create(instance_engine, instance_num_threads, instance_queue_depth);
+  }
+  return engine;
+}
+
+thread_pool_io_engine::thread_pool_io_engine(std::size_t num_threads) : stop_(false) {
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    workers_.emplace_back([this] {
+      while (true) {
+        io_request req;
+        {
+          std::unique_lock<std::mutex> lock(mtx_);
+          cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+          if (queue_.empty()) {
+            return;
+          }
+          req = std::move(queue_.front());
+          queue_.pop_front();
+        }
+        run_callback(req, transfer(req));
+      }
+    });
+  }
+}
+
+thread_pool_io_engine::~thread_pool_io_engine() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &worker: workers_) {
+    worker.join();
+  }
+}
+
+void thread_pool_io_engine::submit(std::vector<io_request> &batch) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto &req: batch) {
+      queue_.push_back(std::move(req));
+    }
+  }
+  if (batch.size() == 1) {
+    cv_.notify_one();
+  } else {
+    cv_.notify_all();
+  }
+  batch.clear();
+}
+
+std::string thread_pool_io_engine::name() const {
+  return "thread_pool";
+}
+
+#ifdef IO_URING_IN_USE
+
+/* Completion of the request that stops the completion thread */
+static const std::uint64_t STOP_USER_DATA = 0;
+
+static int io_uring_setup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+uring_io_engine::uring_io_engine(std::size_t queue_depth)
+    : sq_ring_(MAP_FAILED),
+      cq_ring_(MAP_FAILED),
+      sqes_(MAP_FAILED),
+      num_in_flight_(0),
+      num_pending_(0) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  ring_fd_ = io_uring_setup(static_cast<unsigned>(std::max<std::size_t>(queue_depth, 1)), &params);
+  if (ring_fd_ < 0) {
+    throw std::runtime_error(std::string("io_uring_setup: ") + std::strerror(errno));
+  }
+  // IORING_OP_READ and IORING_OP_WRITE came with the same kernel release as this feature
+  if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+    ::close(ring_fd_);
+    throw std::runtime_error("io_uring lacks IORING_OP_READ and IORING_OP_WRITE");
+  }
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ = sq_ring_;
+  } else if (sq_ring_ != MAP_FAILED) {
+    cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_CQ_RING);
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  if (cq_ring_ != MAP_FAILED) {
+    sqes_ = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                   IORING_OFF_SQES);
+  }
+  if (sqes_ == MAP_FAILED) {
+    auto error = errno;
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      ::munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      ::munmap(sq_ring_, sq_ring_size_);
+    }
+    ::close(ring_fd_);
+    throw std::runtime_error(std::string("io_uring mmap: ") + std::strerror(error));
+  }
+  auto sq = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_entries_ = params.sq_entries;
+  sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  // The completion queue holds at least as many entries as the submission queue, so it cannot overflow
+  queue_depth_ = std::min<std::size_t>(std::max<std::size_t>(queue_depth, 1), params.sq_entries);
+  completion_thread_ = std::thread(&uring_io_engine::complete, this);
+}
+
+uring_io_engine::~uring_io_engine() {
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    idle_cv_.wait(lock, [this] { return num_pending_ == 0; });
+    // The submission queue is empty once the engine is idle
+    auto tail = *sq_tail_;
+    auto idx = tail & sq_mask_;
+    auto sqe = static_cast<io_uring_sqe *>(sqes_) + idx;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = STOP_USER_DATA;
+    sq_array_[idx] = idx;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    while (io_uring_enter(ring_fd_, 1, 0, 0) < 0 && errno == EINTR) {
+    }
+  }
+  completion_thread_.join();
+  ::munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_) {
+    ::munmap(cq_ring_, cq_ring_size_);
+  }
+  ::munmap(sq_ring_, sq_ring_size_);
+  ::close(ring_fd_);
+}
+
+void uring_io_engine::submit(std::vector<io_request> &batch) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  for (auto &req: batch) {
+    backlog_.push_back(new in_flight{std::move(req), 0});
+  }
+  num_pending_ += batch.size();
+  batch.clear();
+  submit_locked();
+}
+
+std::string uring_io_engine::name() const {
+  return "io_uring";
+}
+
+void uring_io_engine::submit_locked() {
+  auto tail = *sq_tail_;
+  auto head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  while (!backlog_.empty() && num_in_flight_ < queue_depth_ && tail - head < sq_entries_) {
+    auto f = backlog_.front();
+    backlog_.pop_front();
+    auto idx = tail & sq_mask_;
+    auto sqe = static_cast<io_uring_sqe *>(sqes_) + idx;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = f->req.op == io_op::read ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->fd = f->req.fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(f->req.buf + f->done);
+    sqe->len = static_cast<std::uint32_t>(std::min(f->req.size - f->done, MAX_TRANSFER_SIZE));
+    sqe->off = f->req.offset + f->done;
+    sqe->user_data = reinterpret_cast<std::uint64_t>(f);
+    sq_array_[idx] = idx;
+    ++tail;
+    ++num_in_flight_;
+  }
+  // Also submits entries a failed earlier submission left in the queue
+  auto to_submit = tail - head;
+  if (to_submit == 0) {
+    return;
+  }
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+  while (to_submit > 0) {
+    auto n = io_uring_enter(ring_fd_, to_submit, 0, 0);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+      continue;
+    }
+    if (n < 0) {
+      throw std::runtime_error(std::string("io_uring_enter: ") + std::strerror(errno));
+    }
+    to_submit -= static_cast<unsigned>(n);
+  }
+}
+
+void uring_io_engine::complete() {
+  bool stop = false;
+  std::vector<std::pair<in_flight *, std::int64_t>> completed;
+  std::vector<in_flight *> resubmit;
+  while (!stop) {
+    if (io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+      LOG(log_level::error) << "io_uring_enter: " << std::strerror(errno);
+    }
+    {
+      // Requests were filled in under the mutex, which also orders them for the completion thread
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto head = *cq_head_;
+      auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head) {
+        auto cqe = static_cast<io_uring_cqe *>(cqes_) + (head & cq_mask_);
+        if (cqe->user_data == STOP_USER_DATA) {
+          stop = true;
+          continue;
+        }
+        --num_in_flight_;
+        auto f = reinterpret_cast<in_flight *>(cqe->user_data);
+        auto res = cqe->res;
+        if (res == -EINTR || res == -EAGAIN) {
+          resubmit.push_back(f);
+        } else if (res < 0) {
+          completed.emplace_back(f, res);
+        } else {
+          f->done += static_cast<std::size_t>(res);
+          if (res == 0 || f->done == f->req.size) {
+            completed.emplace_back(f, static_cast<std::int64_t>(f->done));
+          } else {
+            // Short transfer, issue the rest
+            resubmit.push_back(f);
+          }
+        }
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      for (auto it = resubmit.rbegin(); it != resubmit.rend(); ++it) {
+        backlog_.push_front(*it);
+      }
+      try {
+        submit_locked();
+      } catch (std::exception &e) {
+        // Entries left in the submission queue go out with the next submission
+        LOG(log_level::error) << e.what();
+      }
+    }
+    resubmit.clear();
+    for (auto &c: completed) {
+      run_callback(c.first->req, c.second);
+      delete c.first;
+    }
+    if (!completed.empty()) {
+      std::lock_guard<std::mutex> lock(mtx_);
+      num_pending_ -= completed.size();
+      if (num_pending_ == 0) {
+        idle_cv_.notify_all();
+      }
+    }
+    completed.clear();
+  }
+}
+
+#endif
+
+}
+}
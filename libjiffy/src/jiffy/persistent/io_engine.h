@@ -0,0 +1,221 @@
+#ifndef JIFFY_IO_ENGINE_H
+#define JIFFY_IO_ENGINE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jiffy {
+namespace persistent {
+
+/* I/O operation */
+enum class io_op : uint8_t {
+  read = 0,
+  write = 1
+};
+
+/**
+ * I/O request
+ * A read completes once size bytes are read or the file ends, a write once all size bytes are written
+ */
+struct io_request {
+  /* Operation */
+  io_op op;
+  /* File descriptor */
+  int fd;
+  /* Buffer, must stay valid until the request completes */
+  char *buf;
+  /* Number of bytes to transfer */
+  std::size_t size;
+  /* File offset */
+  std::uint64_t offset;
+  /* Called with the number of bytes transferred, or -errno on failure */
+  std::function<void(std::int64_t)> callback;
+};
+
+/**
+ * @brief Asynchronous engine for positional file reads and writes.
+ *
+ * Requests are submitted in batches and complete on the engine's completion threads, which run the
+ * request callbacks; callbacks may submit further requests but must not wait for them. The io_uring
+ * engine hands each batch to the kernel with a single system call; the thread pool engine serves
+ * requests with pread/pwrite and is used where io_uring is unavailable.
+ */
+class io_engine {
+ public:
+  virtual ~io_engine() = default;
+
+  /**
+   * @brief Submit a batch of requests, never blocks
+   * @param batch Requests, moved from
+   */
+  virtual void submit(std::vector<io_request> &batch) = 0;
+
+  /**
+   * @brief Fetch engine name
+   * @return Either io_uring or thread_pool
+   */
+  virtual std::string name() const = 0;
+
+  /**
+   * @brief Submit a request and wait for it to complete
+   * Must not be called from a request callback
+   * @param op Operation
+   * @param fd File descriptor
+   * @param buf Buffer
+   * @param size Number of bytes to transfer
+   * @param offset File offset
+   * @return Number of bytes transferred, or -errno on failure
+   */
+  std::int64_t run(io_op op, int fd, char *buf, std::size_t size, std::uint64_t offset);
+
+  /**
+   * @brief Transfer a request on the calling thread with pread/pwrite, without running its callback
+   * @param req Request
+   * @return Number of bytes transferred, or -errno on failure
+   */
+  static std::int64_t transfer(const io_request &req);
+
+  /**
+   * @brief Create an engine
+   * @param engine Engine name, either auto, io_uring or thread_pool; auto picks io_uring if the kernel supports it
+   * @param num_threads Number of threads of the thread pool engine
+   * @param queue_depth Maximum number of requests the io_uring engine keeps in the kernel
+   * @return Engine
+   */
+  static std::shared_ptr<io_engine> create(const std::string &engine,
+                                           std::size_t num_threads = 4,
+                                           std::size_t queue_depth = 256);
+
+  /**
+   * @brief Configure the engine returned by instance(), before its first use
+   * @param engine Engine name, either auto, io_uring or thread_pool
+   * @param num_threads Number of threads of the thread pool engine
+   * @param queue_depth Maximum number of requests the io_uring engine keeps in the kernel
+   */
+  static void configure(const std::string &engine, std::size_t num_threads, std::size_t queue_depth);
+
+  /**
+   * @brief Fetch the process wide engine, created on first use
+   * @return Engine
+   */
+  static std::shared_ptr<io_engine> instance();
+};
+
+/* Engine serving requests with pread/pwrite on a thread pool */
+class thread_pool_io_engine : public io_engine {
+ public:
+  /**
+   * @brief Constructor
+   * @param num_threads Number of threads
+   */
+  explicit thread_pool_io_engine(std::size_t num_threads);
+
+  /**
+   * @brief Destructor, completes queued requests first
+   */
+  ~thread_pool_io_engine() override;
+
+  void submit(std::vector<io_request> &batch) override;
+
+  std::string name() const override;
+
+ private:
+  /* Queued requests */
+  std::deque<io_request> queue_;
+  /* Queue mutex */
+  std::mutex mtx_;
+  /* Signalled when requests are queued or the engine stops */
+  std::condition_variable cv_;
+  /* Stop flag */
+  bool stop_;
+  /* Worker threads */
+  std::vector<std::thread> workers_;
+};
+
+#ifdef IO_URING_IN_USE
+
+/* Engine submitting requests to an io_uring instance, with a single completion thread */
+class uring_io_engine : public io_engine {
+ public:
+  /**
+   * @brief Constructor, throws if io_uring is unavailable
+   * @param queue_depth Maximum number of requests kept in the kernel, further requests wait in a backlog
+   */
+  explicit uring_io_engine(std::size_t queue_depth);
+
+  /**
+   * @brief Destructor, completes submitted requests first
+   */
+  ~uring_io_engine() override;
+
+  void submit(std::vector<io_request> &batch) override;
+
+  std::string name() const override;
+
+ private:
+  /* Request with the number of bytes transferred so far */
+  struct in_flight {
+    io_request req;
+    std::size_t done;
+  };
+
+  /**
+   * @brief Move requests from the backlog into the submission queue and submit them, mutex must be held
+   */
+  void submit_locked();
+
+  /**
+   * @brief Reap completions until the engine stops
+   */
+  void complete();
+
+  /* Ring descriptor */
+  int ring_fd_;
+  /* Submission and completion ring mappings */
+  void *sq_ring_;
+  std::size_t sq_ring_size_;
+  void *cq_ring_;
+  std::size_t cq_ring_size_;
+  /* Submission queue entries mapping */
+  void *sqes_;
+  std::size_t sqes_size_;
+  /* Submission ring fields */
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned sq_entries_;
+  unsigned sq_mask_;
+  unsigned *sq_array_;
+  /* Completion ring fields */
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned cq_mask_;
+  void *cqes_;
+  /* Maximum number of requests in the kernel */
+  std::size_t queue_depth_;
+  /* Number of requests in the kernel */
+  std::size_t num_in_flight_;
+  /* Number of submitted requests whose callbacks have not returned yet */
+  std::size_t num_pending_;
+  /* Requests waiting for room in the kernel */
+  std::deque<in_flight *> backlog_;
+  /* Submission mutex */
+  std::mutex mtx_;
+  /* Signalled when the engine is idle */
+  std::condition_variable idle_cv_;
+  /* Completion thread */
+  std::thread completion_thread_;
+};
+
+#endif
+
+}
+}
+
+#endif //JIFFY_IO_ENGINE_H
@@ -0,0 +1,64 @@
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace jiffy {
+namespace persistent {
+
+mapped_file::mapped_file(const std::string &path, bool sequential) : data_(nullptr), size_(0), open_(false) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    auto error = errno;
+    ::close(fd);
+    throw std::runtime_error("Failed to stat " + path + ": " + std::strerror(error));
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ > 0) {
+    auto addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      auto error = errno;
+      ::close(fd);
+      throw std::runtime_error("Failed to map " + path + ": " + std::strerror(error));
+    }
+    data_ = static_cast<char *>(addr);
+    if (sequential) {
+      ::madvise(data_, size_, MADV_SEQUENTIAL);
+      ::madvise(data_, size_, MADV_WILLNEED);
+    } else {
+      ::madvise(data_, size_, MADV_RANDOM);
+    }
+  }
+  // The mapping stays valid once the descriptor is closed
+  ::close(fd);
+  open_ = true;
+}
+
+mapped_file::~mapped_file() {
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+  }
+}
+
+bool mapped_file::is_open() const {
+  return open_;
+}
+
+const char *mapped_file::data() const {
+  return data_;
+}
+
+std::size_t mapped_file::size() const {
+  return size_;
+}
+
+}
+}
@@ -0,0 +1,63 @@
+#ifndef JIFFY_MAPPED_FILE_H
+#define JIFFY_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace jiffy {
+namespace persistent {
+
+/**
+ * @brief Read-only memory mapping of a whole local file.
+ * Loaders parse records in place instead of copying them through a stream buffer; the mapping is
+ * advised for sequential access so that the kernel reads ahead, or for random access when it serves
+ * point lookups.
+ */
+class mapped_file {
+ public:
+  /**
+   * @brief Constructor, maps the file
+   * @param path File path
+   * @param sequential Bool value, true if the file is read front to back, false for point lookups
+   */
+  explicit mapped_file(const std::string &path, bool sequential = true);
+
+  /**
+   * @brief Destructor, unmaps the file
+   */
+  ~mapped_file();
+
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+
+  /**
+   * @brief Check if the file was mapped
+   * @return Bool value, false if the file could not be opened
+   */
+  bool is_open() const;
+
+  /**
+   * @brief Fetch the file contents
+   * @return File contents, null for an empty file
+   */
+  const char *data() const;
+
+  /**
+   * @brief Fetch the file size
+   * @return File size
+   */
+  std::size_t size() const;
+
+ private:
+  /* Mapped contents */
+  char *data_;
+  /* File size */
+  std::size_t size_;
+  /* Bool value, true if the file was opened */
+  bool open_;
+};
+
+}
+}
+
+#endif //JIFFY_MAPPED_FILE_H
@@ -0,0 +1,619 @@
+#include "object_store.h"
+#include "crc32c.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <exception>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include "jiffy/utils/directory_utils.h"
+#include "jiffy/utils/logger.h"
+#ifdef S3_EXTERNAL
+#include <aws/core/Aws.h>
+#include <aws/core/utils/stream/PreallocatedStreamBuf.h>
+#include <aws/s3/S3Client.h>
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/CompletedMultipartUpload.h>
+#include <aws/s3/model/CompletedPart.h>
+#include <aws/s3/model/CopyObjectRequest.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
+#include <aws/s3/model/DeleteObjectRequest.h>
+#include <aws/s3/model/GetObjectRequest.h>
+#include <aws/s3/model/HeadObjectRequest.h>
+#include <aws/s3/model/PutObjectRequest.h>
+#include <aws/s3/model/UploadPartCopyRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
+#endif
+
+namespace jiffy {
+namespace persistent {
+
+using namespace utils;
+
+/* Maximum number of parts of a multipart upload */
+static const std::size_t MAX_PARTS = 10000;
+
+/* Client configuration used by instance() */
+static std::mutex instance_mtx;
+static std::string instance_endpoint;
+static std::size_t instance_part_size = 8388608;
+static std::size_t instance_num_threads = 8;
+static std::string instance_staging_dir = "/tmp";
+
+void object_client::configure(const std::string &endpoint,
+                              std::size_t part_size,
+                              std::size_t num_threads,
+                              const std::string &staging_dir) {
+  std::lock_guard<std::mutex> lock(instance_mtx);
+  instance_endpoint = endpoint;
+  instance_part_size = part_size;
+  instance_num_threads = std::max<std::size_t>(num_threads, 1);
+  instance_staging_dir = staging_dir;
+}
+
+std::shared_ptr<object_client> object_client::instance(const std::string &uri) {
+#ifdef S3_EXTERNAL
+  static std::shared_ptr<object_client> s3_client;
+  std::lock_guard<std::mutex> lock(instance_mtx);
+  if (uri == "s3") {
+    if (s3_client == nullptr) {
+      s3_client = std::make_shared<s3_object_client>(instance_endpoint, instance_num_threads);
+    }
+    return s3_client;
+  }
+#endif
+  throw std::invalid_argument("No object store client for " + uri);
+}
+
+std::size_t object_client::part_size() {
+  std::lock_guard<std::mutex> lock(instance_mtx);
+  return instance_part_size;
+}
+
+std::size_t object_client::num_threads() {
+  std::lock_guard<std::mutex> lock(instance_mtx);
+  return instance_num_threads;
+}
+
+std::string object_client::staging_dir() {
+  std::lock_guard<std::mutex> lock(instance_mtx);
+  return instance_staging_dir;
+}
+
+/**
+ * @brief Read a range of a file, retrying short reads
+ * @param fd File descriptor
+ * @param dst Destination
+ * @param size Range size
+ * @param offset Range offset
+ * @return Bool value, true if the whole range was read
+ */
+static bool pread_full(int fd, char *dst, std::size_t size, std::uint64_t offset) {
+  while (size > 0) {
+    auto n = ::pread(fd, dst, size, static_cast<off_t>(offset));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    dst += n;
+    size -= static_cast<std::size_t>(n);
+    offset += static_cast<std::uint64_t>(n);
+  }
+  return true;
+}
+
+/**
+ * @brief Write a range of a file, retrying short writes
+ * @param fd File descriptor
+ * @param src Source
+ * @param size Range size
+ * @param offset Range offset
+ * @return Bool value, true if the whole range was written
+ */
+static bool pwrite_full(int fd, const char *src, std::size_t size, std::uint64_t offset) {
+  while (size > 0) {
+    auto n = ::pwrite(fd, src, size, static_cast<off_t>(offset));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    src += n;
+    size -= static_cast<std::size_t>(n);
+    offset += static_cast<std::uint64_t>(n);
+  }
+  return true;
+}
+
+fs_object_client::fs_object_client(const std::string &root)
+    : root_(root), last_upload_(0), num_parts_(0), num_reads_(0) {
+  directory_utils::create_directory(root_);
+}
+
+void fs_object_client::put_object(const std::string &bucket,
+                                  const std::string &key,
+                                  const char *data,
+                                  std::size_t size) {
+  write_file(object_path(bucket, key), data, size);
+}
+
+std::string fs_object_client::create_multipart_upload(const std::string &, const std::string &) {
+  auto upload_id = std::to_string(::getpid()) + "_" + std::to_string(++last_upload_);
+  directory_utils::create_directory(upload_path(upload_id));
+  return upload_id;
+}
+
+std::string fs_object_client::upload_part(const std::string &,
+                                          const std::string &,
+                                          const std::string &upload_id,
+                                          std::size_t part_number,
+                                          const char *data,
+                                          std::size_t size) {
+  write_file(upload_path(upload_id) + "/" + std::to_string(part_number), data, size);
+  ++num_parts_;
+  // Like an ETag, the tag identifies the part contents
+  return std::to_string(crc32c(0, data, size));
+}
+
+void fs_object_client::complete_multipart_upload(const std::string &bucket,
+                                                 const std::string &key,
+                                                 const std::string &upload_id,
+                                                 const std::vector<std::string> &tags) {
+  auto path = object_path(bucket, key);
+  directory_utils::create_directory(directory_utils::get_parent_path(path));
+  auto tmp_path = path + ".upload_" + upload_id;
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    std::string part;
+    for (std::size_t i = 0; i < tags.size(); ++i) {
+      auto part_path = upload_path(upload_id) + "/" + std::to_string(i + 1);
+      std::ifstream in(part_path, std::ios::binary | std::ios::ate);
+      if (!in) {
+        throw std::runtime_error("Missing part " + std::to_string(i + 1) + " of upload " + upload_id);
+      }
+      part.resize(static_cast<std::size_t>(in.tellg()));
+      in.seekg(0, std::ios::beg);
+      in.read(&part[0], part.size());
+      if (std::to_string(crc32c(0, part.data(), part.size())) != tags[i]) {
+        throw std::runtime_error("Tag mismatch for part " + std::to_string(i + 1) + " of upload " + upload_id);
+      }
+      out.write(part.data(), part.size());
+    }
+    out.close();
+    if (out.fail()) {
+      throw std::runtime_error("Error in writing " + path);
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Error in renaming " + path);
+  }
+  abort_multipart_upload(bucket, key, upload_id);
+}
+
+void fs_object_client::abort_multipart_upload(const std::string &, const std::string &, const std::string &upload_id) {
+  auto dir_path = upload_path(upload_id);
+  auto dir = ::opendir(dir_path.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  while (auto entry = ::readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..") {
+      std::remove((dir_path + "/" + name).c_str());
+    }
+  }
+  ::closedir(dir);
+  ::rmdir(dir_path.c_str());
+}
+
+bool fs_object_client::head_object(const std::string &bucket, const std::string &key, std::uint64_t &size) {
+  struct stat st{};
+  if (::stat(object_path(bucket, key).c_str(), &st) != 0) {
+    return false;
+  }
+  size = static_cast<std::uint64_t>(st.st_size);
+  return true;
+}
+
+void fs_object_client::get_range(const std::string &bucket,
+                                 const std::string &key,
+                                 std::uint64_t offset,
+                                 std::size_t size,
+                                 char *dst) {
+  auto path = object_path(bucket, key);
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Error in opening " + path + ": " + std::strerror(errno));
+  }
+  bool ok = pread_full(fd, dst, size, offset);
+  ::close(fd);
+  if (!ok) {
+    throw std::runtime_error("Error in reading " + std::to_string(size) + " bytes at offset " + std::to_string(offset)
+                                 + " of " + path);
+  }
+  ++num_reads_;
+}
+
+void fs_object_client::delete_object(const std::string &bucket, const std::string &key) {
+  std::remove(object_path(bucket, key).c_str());
+}
+
+void fs_object_client::copy_object(const std::string &bucket, const std::string &src_key, const std::string &dst_key) {
+  auto src_path = object_path(bucket, src_key);
+  auto path = object_path(bucket, dst_key);
+  std::ifstream in(src_path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("No object " + src_path);
+  }
+  auto tmp_path = path + ".copy_" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    out << in.rdbuf();
+    out.close();
+    if (out.fail()) {
+      throw std::runtime_error("Error in writing " + path);
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Error in renaming " + path);
+  }
+}
+
+std::size_t fs_object_client::num_parts_uploaded() const {
+  return num_parts_.load();
+}
+
+std::size_t fs_object_client::num_range_reads() const {
+  return num_reads_.load();
+}
+
+std::string fs_object_client::object_path(const std::string &bucket, const std::string &key) const {
+  return root_ + "/" + bucket + "/" + key;
+}
+
+std::string fs_object_client::upload_path(const std::string &upload_id) const {
+  return root_ + "/.uploads/" + upload_id;
+}
+
+void fs_object_client::write_file(const std::string &path, const char *data, std::size_t size) {
+  directory_utils::create_directory(directory_utils::get_parent_path(path));
+  auto tmp_path = path + ".tmp_" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    out.write(data, size);
+    out.close();
+    if (out.fail()) {
+      throw std::runtime_error("Error in writing " + path);
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Error in renaming " + path);
+  }
+}
+
+object_transfer::object_transfer(std::shared_ptr<object_client> client, std::size_t part_size, std::size_t num_threads)
+    : client_(std::move(client)), part_size_(part_size), num_threads_(std::max<std::size_t>(num_threads, 1)) {}
+
+template<typename Task>
+void object_transfer::for_each_part(std::size_t num_parts, Task task) {
+  auto num_threads = std::min(num_threads_, num_parts);
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> failed(false);
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto run = [&](std::size_t t) {
+    try {
+      std::size_t i;
+      while (!failed.load() && (i = next++) < num_parts) {
+        task(t, i);
+      }
+    } catch (...) {
+      errors[t] = std::current_exception();
+      failed = true;
+    }
+  };
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < num_threads; ++t) {
+    workers.emplace_back(run, t);
+  }
+  if (num_threads > 0) {
+    run(0);
+  }
+  for (auto &w: workers) {
+    w.join();
+  }
+  for (const auto &e: errors) {
+    if (e != nullptr) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
+std::uint64_t object_transfer::upload(const std::string &path, const std::string &bucket, const std::string &key) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Error in opening " + path + ": " + std::strerror(errno));
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Error in reading " + path + ": " + std::strerror(errno));
+  }
+  auto size = static_cast<std::uint64_t>(st.st_size);
+  if (size <= part_size_) {
+    std::vector<char> data(static_cast<std::size_t>(size));
+    bool ok = pread_full(fd, data.data(), data.size(), 0);
+    ::close(fd);
+    if (!ok) {
+      throw std::runtime_error("Error in reading " + path);
+    }
+    client_->put_object(bucket, key, data.data(), data.size());
+    return size;
+  }
+
+  // Parts grow for very large files, which would otherwise exceed the part limit
+  auto part_size = std::max<std::uint64_t>(part_size_, (size + MAX_PARTS - 1) / MAX_PARTS);
+  auto num_parts = static_cast<std::size_t>((size + part_size - 1) / part_size);
+  std::string upload_id;
+  try {
+    upload_id = client_->create_multipart_upload(bucket, key);
+    std::vector<std::string> tags(num_parts);
+    std::vector<std::vector<char>> buffers(std::min(num_threads_, num_parts));
+    for_each_part(num_parts, [&](std::size_t t, std::size_t i) {
+      auto offset = i * part_size;
+      auto len = static_cast<std::size_t>(std::min<std::uint64_t>(part_size, size - offset));
+      auto &buf = buffers[t];
+      buf.resize(len);
+      if (!pread_full(fd, buf.data(), len, offset)) {
+        throw std::runtime_error("Error in reading " + path);
+      }
+      tags[i] = client_->upload_part(bucket, key, upload_id, i + 1, buf.data(), len);
+    });
+    client_->complete_multipart_upload(bucket, key, upload_id, tags);
+  } catch (...) {
+    ::close(fd);
+    if (!upload_id.empty()) {
+      try {
+        client_->abort_multipart_upload(bucket, key, upload_id);
+      } catch (std::exception &e) {
+        LOG(log_level::warn) << "Failed to abort upload of " << bucket << "/" << key << ": " << e.what();
+      }
+    }
+    throw;
+  }
+  ::close(fd);
+  return size;
+}
+
+bool object_transfer::download(const std::string &bucket, const std::string &key, const std::string &path) {
+  std::uint64_t size = 0;
+  if (!client_->head_object(bucket, key, size)) {
+    return false;
+  }
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Error in creating " + path + ": " + std::strerror(errno));
+  }
+  auto num_parts = static_cast<std::size_t>((size + part_size_ - 1) / part_size_);
+  std::vector<std::vector<char>> buffers(std::min(num_threads_, num_parts));
+  try {
+    for_each_part(num_parts, [&](std::size_t t, std::size_t i) {
+      auto offset = static_cast<std::uint64_t>(i) * part_size_;
+      auto len = static_cast<std::size_t>(std::min<std::uint64_t>(part_size_, size - offset));
+      auto &buf = buffers[t];
+      buf.resize(len);
+      client_->get_range(bucket, key, offset, len, buf.data());
+      if (!pwrite_full(fd, buf.data(), len, offset)) {
+        throw std::runtime_error("Error in writing " + path);
+      }
+    });
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+  return true;
+}
+
+std::shared_ptr<object_client> object_transfer::client() const {
+  return client_;
+}
+
+#ifdef S3_EXTERNAL
+/* Largest object S3 copies in a single request */
+static const std::uint64_t MAX_COPY_SIZE = 5ULL << 30;
+
+struct s3_object_client::impl {
+  /* SDK options */
+  Aws::SDKOptions options;
+  /* SDK client, safe to share between threads */
+  std::unique_ptr<Aws::S3::S3Client> client;
+};
+
+/**
+ * @brief Throw if a request failed
+ * @param outcome Request outcome
+ * @param op Operation name
+ * @param bucket Bucket name
+ * @param key Object key
+ */
+template<typename Outcome>
+static void check_outcome(const Outcome &outcome, const std::string &op, const std::string &bucket,
+                          const std::string &key) {
+  if (!outcome.IsSuccess()) {
+    LOG(log_level::error) << "S3 " << op << " error: " << outcome.GetError().GetExceptionName() << " "
+                          << outcome.GetError().GetMessage();
+    throw std::runtime_error("Error in S3 " + op + " of " + bucket + "/" + key);
+  }
+}
+
+s3_object_client::s3_object_client(const std::string &endpoint, std::size_t max_connections) : impl_(new impl) {
+  impl_->options.loggingOptions.logLevel = Aws::Utils::Logging::LogLevel::Warn;
+  Aws::InitAPI(impl_->options);
+  Aws::Client::ClientConfiguration config;
+  config.maxConnections = static_cast<unsigned>(max_connections);
+  bool virtual_addressing = true;
+  if (!endpoint.empty()) {
+    config.endpointOverride = endpoint.c_str();
+    if (endpoint.compare(0, 7, "http://") == 0) {
+      config.scheme = Aws::Http::Scheme::HTTP;
+    }
+    // S3-compatible services generally expect path-style bucket addressing
+    virtual_addressing = false;
+  }
+  impl_->client.reset(new Aws::S3::S3Client(config, Aws::Client::AWSAuthV4Signer::PayloadSigningPolicy::Never,
+                                            virtual_addressing));
+}
+
+s3_object_client::~s3_object_client() {
+  impl_->client.reset();
+  Aws::ShutdownAPI(impl_->options);
+}
+
+void s3_object_client::put_object(const std::string &bucket,
+                                  const std::string &key,
+                                  const char *data,
+                                  std::size_t size) {
+  Aws::S3::Model::PutObjectRequest request;
+  request.WithBucket(bucket.c_str()).WithKey(key.c_str());
+  // The body reads the caller's buffer in place
+  Aws::Utils::Stream::PreallocatedStreamBuf buf(reinterpret_cast<unsigned char *>(const_cast<char *>(data)), size);
+  request.SetBody(Aws::MakeShared<Aws::IOStream>("ObjectBody", &buf));
+  request.SetContentLength(static_cast<long long>(size));
+  check_outcome(impl_->client->PutObject(request), "PutObject", bucket, key);
+}
+
+std::string s3_object_client::create_multipart_upload(const std::string &bucket, const std::string &key) {
+  Aws::S3::Model::CreateMultipartUploadRequest request;
+  request.WithBucket(bucket.c_str()).WithKey(key.c_str());
+  auto outcome = impl_->client->CreateMultipartUpload(request);
+  check_outcome(outcome, "CreateMultipartUpload", bucket, key);
+  return outcome.GetResult().GetUploadId().c_str();
+}
+
+std::string s3_object_client::upload_part(const std::string &bucket,
+                                          const std::string &key,
+                                          const std::string &upload_id,
+                                          std::size_t part_number,
+                                          const char *data,
+                                          std::size_t size) {
+  Aws::S3::Model::UploadPartRequest request;
+  request.WithBucket(bucket.c_str()).WithKey(key.c_str()).WithUploadId(upload_id.c_str())
+      .WithPartNumber(static_cast<int>(part_number));
+  Aws::Utils::Stream::PreallocatedStreamBuf buf(reinterpret_cast<unsigned char *>(const_cast<char *>(data)), size);
+  request.SetBody(Aws::MakeShared<Aws::IOStream>("PartBody", &buf));
+  request.SetContentLength(static_cast<long long>(size));
+  auto outcome = impl_->client->UploadPart(request);
+  check_outcome(outcome, "UploadPart", bucket, key);
+  return outcome.GetResult().GetETag().c_str();
+}
+
+void s3_object_client::complete_multipart_upload(const std::string &bucket,
+                                                 const std::string &key,
+                                                 const std::string &upload_id,
+                                                 const std::vector<std::string> &tags) {
+  Aws::S3::Model::CompletedMultipartUpload upload;
+  for (std::size_t i = 0; i < tags.size(); ++i) {
+    upload.AddParts(Aws::S3::Model::CompletedPart().WithETag(tags[i].c_str()).WithPartNumber(static_cast<int>(i + 1)));
+  }
+  Aws::S3::Model::CompleteMultipartUploadRequest request;
+  request.WithBucket(bucket.c_str()).WithKey(key.c_str()).WithUploadId(upload_id.c_str()).WithMultipartUpload(upload);
+  check_outcome(impl_->client->CompleteMultipartUpload(request), "CompleteMultipartUpload", bucket, key);
+}
+
+void s3_object_client::abort_multipart_upload(const std::string &bucket,
+                                              const std::string &key,
+                                              const std::string &upload_id) {
+  Aws::S3::Model::AbortMultipartUploadRequest request;
+  request.WithBucket(bucket.c_str()).WithKey(key.c_str()).WithUploadId(upload_id.c_str());
+  check_outcome(impl_->client->AbortMultipartUpload(request), "AbortMultipartUpload", bucket, key);
+}
+
+bool s3_object_client::head_object(const std::string &bucket, const std::string &key, std::uint64_t &size) {
+  Aws::S3::Model::HeadObjectRequest request;
+  request.WithBucket(bucket.c_str()).WithKey(key.c_str());
+  auto outcome = impl_->client->HeadObject(request);
+  if (!outcome.IsSuccess()) {
+    if (outcome.GetError().GetResponseCode() == Aws::Http::HttpResponseCode::NOT_FOUND) {
+      return false;
+    }
+    check_outcome(outcome, "HeadObject", bucket, key);
+  }
+  size = static_cast<std::uint64_t>(outcome.GetResult().GetContentLength());
+  return true;
+}
+
+void s3_object_client::get_range(const std::string &bucket,
+                                 const std::string &key,
+                                 std::uint64_t offset,
+                                 std::size_t size,
+                                 char *dst) {
+  if (size == 0) {
+    return;
+  }
+  Aws::S3::Model::GetObjectRequest request;
+  auto range = "bytes=" + std::to_string(offset) + "-" + std::to_string(offset + size - 1);
+  request.WithBucket(bucket.c_str()).WithKey(key.c_str()).WithRange(range.c_str());
+  auto outcome = impl_->client->GetObject(request);
+  check_outcome(outcome, "GetObject", bucket, key);
+  auto &body = outcome.GetResult().GetBody();
+  body.read(dst, static_cast<std::streamsize>(size));
+  if (static_cast<std::size_t>(body.gcount()) != size) {
+    throw std::runtime_error("Short read of " + range + " of " + bucket + "/" + key);
+  }
+}
+
+void s3_object_client::delete_object(const std::string &bucket, const std::string &key) {
+  Aws::S3::Model::DeleteObjectRequest request;
+  request.WithBucket(bucket.c_str()).WithKey(key.c_str());
+  check_outcome(impl_->client->DeleteObject(request), "DeleteObject", bucket, key);
+}
+
+void s3_object_client::copy_object(const std::string &bucket, const std::string &src_key, const std::string &dst_key) {
+  std::uint64_t size = 0;
+  if (!head_object(bucket, src_key, size)) {
+    throw std::runtime_error("No object " + bucket + "/" + src_key);
+  }
+  auto source = bucket + "/" + src_key;
+  if (size <= MAX_COPY_SIZE) {
+    Aws::S3::Model::CopyObjectRequest request;
+    request.WithBucket(bucket.c_str()).WithKey(dst_key.c_str()).WithCopySource(source.c_str());
+    check_outcome(impl_->client->CopyObject(request), "CopyObject", bucket, dst_key);
+    return;
+  }
+  // Larger objects are copied part by part, still without leaving the object store
+  auto upload_id = create_multipart_upload(bucket, dst_key);
+  try {
+    std::vector<std::string> tags;
+    for (std::uint64_t offset = 0; offset < size; offset += MAX_COPY_SIZE) {
+      auto last = std::min<std::uint64_t>(offset + MAX_COPY_SIZE, size) - 1;
+      auto range = "bytes=" + std::to_string(offset) + "-" + std::to_string(last);
+      Aws::S3::Model::UploadPartCopyRequest request;
+      request.WithBucket(bucket.c_str()).WithKey(dst_key.c_str()).WithUploadId(upload_id.c_str())
+          .WithCopySource(source.c_str()).WithCopySourceRange(range.c_str())
+          .WithPartNumber(static_cast<int>(tags.size() + 1));
+      auto outcome = impl_->client->UploadPartCopy(request);
+      check_outcome(outcome, "UploadPartCopy", bucket, dst_key);
+      tags.emplace_back(outcome.GetResult().GetCopyPartResult().GetETag().c_str());
+    }
+    complete_multipart_upload(bucket, dst_key, upload_id, tags);
+  } catch (...) {
+    abort_multipart_upload(bucket, dst_key, upload_id);
+    throw;
+  }
+}
+#endif
+
+}
+}
@@ -0,0 +1,358 @@
+#ifndef JIFFY_OBJECT_STORE_H
+#define JIFFY_OBJECT_STORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jiffy {
+namespace persistent {
+
+/**
+ * @brief Client of an object store with multipart uploads and ranged reads.
+ *
+ * Implementations must be safe to call from several threads at once, so that one client serves all
+ * parallel transfers of a process.
+ */
+class object_client {
+ public:
+  virtual ~object_client() = default;
+
+  /**
+   * @brief Store a whole object
+   * @param bucket Bucket name
+   * @param key Object key
+   * @param data Object contents
+   * @param size Object size
+   */
+  virtual void put_object(const std::string &bucket, const std::string &key, const char *data, std::size_t size) = 0;
+
+  /**
+   * @brief Start a multipart upload
+   * @param bucket Bucket name
+   * @param key Object key
+   * @return Upload identifier
+   */
+  virtual std::string create_multipart_upload(const std::string &bucket, const std::string &key) = 0;
+
+  /**
+   * @brief Upload a part of a multipart upload
+   * @param bucket Bucket name
+   * @param key Object key
+   * @param upload_id Upload identifier
+   * @param part_number Part number, parts are numbered from 1
+   * @param data Part contents
+   * @param size Part size
+   * @return Part tag, passed back on completion
+   */
+  virtual std::string upload_part(const std::string &bucket,
+                                  const std::string &key,
+                                  const std::string &upload_id,
+                                  std::size_t part_number,
+                                  const char *data,
+                                  std::size_t size) = 0;
+
+  /**
+   * @brief Complete a multipart upload, making the object visible
+   * @param bucket Bucket name
+   * @param key Object key
+   * @param upload_id Upload identifier
+   * @param tags Part tags in part order
+   */
+  virtual void complete_multipart_upload(const std::string &bucket,
+                                         const std::string &key,
+                                         const std::string &upload_id,
+                                         const std::vector<std::string> &tags) = 0;
+
+  /**
+   * @brief Abort a multipart upload, dropping its parts
+   * @param bucket Bucket name
+   * @param key Object key
+   * @param upload_id Upload identifier
+   */
+  virtual void abort_multipart_upload(const std::string &bucket,
+                                      const std::string &key,
+                                      const std::string &upload_id) = 0;
+
+  /**
+   * @brief Fetch the size of an object
+   * @param bucket Bucket name
+   * @param key Object key
+   * @param size Object size
+   * @return Bool value, false if the object does not exist
+   */
+  virtual bool head_object(const std::string &bucket, const std::string &key, std::uint64_t &size) = 0;
+
+  /**
+   * @brief Read a byte range of an object
+   * @param bucket Bucket name
+   * @param key Object key
+   * @param offset Range offset
+   * @param size Range size
+   * @param dst Destination
+   */
+  virtual void get_range(const std::string &bucket,
+                         const std::string &key,
+                         std::uint64_t offset,
+                         std::size_t size,
+                         char *dst) = 0;
+
+  /**
+   * @brief Delete an object
+   * @param bucket Bucket name
+   * @param key Object key
+   */
+  virtual void delete_object(const std::string &bucket, const std::string &key) = 0;
+
+  /**
+   * @brief Copy an object within a bucket, without transferring its contents
+   * @param bucket Bucket name
+   * @param src_key Source object key
+   * @param dst_key Destination object key
+   */
+  virtual void copy_object(const std::string &bucket, const std::string &src_key, const std::string &dst_key) = 0;
+
+  /**
+   * @brief Configure the clients and transfers returned by instance(), before their first use
+   * @param endpoint Endpoint of an S3-compatible service, empty for AWS
+   * @param part_size Bytes per uploaded part and per ranged read
+   * @param num_threads Number of parts transferred at once
+   * @param staging_dir Local directory holding images while they are transferred
+   */
+  static void configure(const std::string &endpoint,
+                        std::size_t part_size,
+                        std::size_t num_threads,
+                        const std::string &staging_dir);
+
+  /**
+   * @brief Fetch the process-wide client of an object store
+   * @param uri Object store URI, "s3"
+   * @return Client
+   */
+  static std::shared_ptr<object_client> instance(const std::string &uri);
+
+  /**
+   * @brief Fetch the configured part size
+   * @return Bytes per part
+   */
+  static std::size_t part_size();
+
+  /**
+   * @brief Fetch the configured number of transfer threads
+   * @return Number of threads
+   */
+  static std::size_t num_threads();
+
+  /**
+   * @brief Fetch the configured staging directory
+   * @return Staging directory
+   */
+  static std::string staging_dir();
+};
+
+/**
+ * @brief Object store emulated on a local directory.
+ * Buckets are subdirectories of the root, objects are files and the parts of multipart uploads are kept
+ * in a hidden directory until the upload completes.
+ */
+class fs_object_client : public object_client {
+ public:
+  /**
+   * @brief Constructor
+   * @param root Root directory
+   */
+  explicit fs_object_client(const std::string &root);
+
+  void put_object(const std::string &bucket, const std::string &key, const char *data, std::size_t size) override;
+
+  std::string create_multipart_upload(const std::string &bucket, const std::string &key) override;
+
+  std::string upload_part(const std::string &bucket,
+                          const std::string &key,
+                          const std::string &upload_id,
+                          std::size_t part_number,
+                          const char *data,
+                          std::size_t size) override;
+
+  void complete_multipart_upload(const std::string &bucket,
+                                 const std::string &key,
+                                 const std::string &upload_id,
+                                 const std::vector<std::string> &tags) override;
+
+  void abort_multipart_upload(const std::string &bucket, const std::string &key, const std::string &upload_id) override;
+
+  bool head_object(const std::string &bucket, const std::string &key, std::uint64_t &size) override;
+
+  void get_range(const std::string &bucket,
+                 const std::string &key,
+                 std::uint64_t offset,
+                 std::size_t size,
+                 char *dst) override;
+
+  void delete_object(const std::string &bucket, const std::string &key) override;
+
+  void copy_object(const std::string &bucket, const std::string &src_key, const std::string &dst_key) override;
+
+  /**
+   * @brief Fetch the number of parts uploaded so far
+   * @return Number of parts
+   */
+  std::size_t num_parts_uploaded() const;
+
+  /**
+   * @brief Fetch the number of ranged reads so far
+   * @return Number of ranged reads
+   */
+  std::size_t num_range_reads() const;
+
+ private:
+  /**
+   * @brief Fetch the file of an object
+   * @param bucket Bucket name
+   * @param key Object key
+   * @return File path
+   */
+  std::string object_path(const std::string &bucket, const std::string &key) const;
+
+  /**
+   * @brief Fetch the directory holding the parts of an upload
+   * @param upload_id Upload identifier
+   * @return Directory path
+   */
+  std::string upload_path(const std::string &upload_id) const;
+
+  /**
+   * @brief Write a file and rename it into place
+   * @param path File path
+   * @param data Contents
+   * @param size Size
+   */
+  static void write_file(const std::string &path, const char *data, std::size_t size);
+
+  /* Root directory */
+  std::string root_;
+  /* Last upload identifier */
+  std::atomic<std::uint64_t> last_upload_;
+  /* Number of parts uploaded */
+  std::atomic<std::size_t> num_parts_;
+  /* Number of ranged reads */
+  std::atomic<std::size_t> num_reads_;
+};
+
+/**
+ * @brief Parallel transfer of local files to and from an object store.
+ *
+ * Files larger than one part are uploaded as multipart uploads whose parts are read and sent by several
+ * threads at once; objects are downloaded with ranged reads issued by several threads, each written at
+ * its offset of the local file. Memory use is bounded by one part per thread.
+ */
+class object_transfer {
+ public:
+  /**
+   * @brief Constructor
+   * @param client Object store client
+   * @param part_size Bytes per part and per ranged read
+   * @param num_threads Number of parts transferred at once
+   */
+  object_transfer(std::shared_ptr<object_client> client, std::size_t part_size, std::size_t num_threads);
+
+  /**
+   * @brief Upload a local file
+   * @param path Local file path
+   * @param bucket Bucket name
+   * @param key Object key
+   * @return Number of bytes uploaded
+   */
+  std::uint64_t upload(const std::string &path, const std::string &bucket, const std::string &key);
+
+  /**
+   * @brief Download an object into a local file
+   * @param bucket Bucket name
+   * @param key Object key
+   * @param path Local file path
+   * @return Bool value, false if the object does not exist
+   */
+  bool download(const std::string &bucket, const std::string &key, const std::string &path);
+
+  /**
+   * @brief Fetch the client
+   * @return Client
+   */
+  std::shared_ptr<object_client> client() const;
+
+ private:
+  /**
+   * @brief Run a task for every part on the transfer threads, rethrowing the first failure
+   * @param num_parts Number of parts
+   * @param task Called with the thread number and each part number, both from 0
+   */
+  template<typename Task>
+  void for_each_part(std::size_t num_parts, Task task);
+
+  /* Client */
+  std::shared_ptr<object_client> client_;
+  /* Bytes per part */
+  std::size_t part_size_;
+  /* Number of parts transferred at once */
+  std::size_t num_threads_;
+};
+
+#ifdef S3_EXTERNAL
+/**
+ * @brief Object store client for S3 and S3-compatible services.
+ * A single SDK client is shared by all threads, so connections are reused across transfers.
+ */
+class s3_object_client : public object_client {
+ public:
+  /**
+   * @brief Constructor
+   * @param endpoint Endpoint of an S3-compatible service, empty for AWS
+   * @param max_connections Maximum number of connections
+   */
+  s3_object_client(const std::string &endpoint, std::size_t max_connections);
+
+  ~s3_object_client() override;
+
+  void put_object(const std::string &bucket, const std::string &key, const char *data, std::size_t size) override;
+
+  std::string create_multipart_upload(const std::string &bucket, const std::string &key) override;
+
+  std::string upload_part(const std::string &bucket,
+                          const std::string &key,
+                          const std::string &upload_id,
+                          std::size_t part_number,
+                          const char *data,
+                          std::size_t size) override;
+
+  void complete_multipart_upload(const std::string &bucket,
+                                 const std::string &key,
+                                 const std::string &upload_id,
+                                 const std::vector<std::string> &tags) override;
+
+  void abort_multipart_upload(const std::string &bucket, const std::string &key, const std::string &upload_id) override;
+
+  bool head_object(const std::string &bucket, const std::string &key, std::uint64_t &size) override;
+
+  void get_range(const std::string &bucket,
+                 const std::string &key,
+                 std::uint64_t offset,
+                 std::size_t size,
+                 char *dst) override;
+
+  void delete_object(const std::string &bucket, const std::string &key) override;
+
+  void copy_object(const std::string &bucket, const std::string &src_key, const std::string &dst_key) override;
+
+ private:
+  /* SDK client, opaque so that the SDK headers stay out of this header */
+  struct impl;
+  std::unique_ptr<impl> impl_;
+};
+#endif
+
+}
+}
+
+#endif //JIFFY_OBJECT_STORE_H
@@ -1,41 +1,331 @@
 #include "persistent_service.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <sstream>
+#include <unistd.h>
 
 namespace jiffy {
 namespace persistent {
 
 using namespace utils;
 
+std::pair<std::size_t, std::size_t> persistent_service::replay_deltas(const std::string &in_path,
+                                                                      const std::function<void(const delta &)> &apply,
+                                                                      std::uint64_t *log_segment) {
+  std::size_t num_deltas = 0;
+  std::size_t delta_bytes = 0;
+  std::uint64_t max_segment = 0;
+  delta d;
+  while (read_delta(in_path, num_deltas + 1, d)) {
+    delta_bytes += delta_size(d);
+    max_segment = std::max(max_segment, take_log_segment(d));
+    apply(d);
+    ++num_deltas;
+  }
+  if (log_segment != nullptr) {
+    *log_segment = max_segment;
+  }
+  return std::make_pair(num_deltas, delta_bytes);
+}
+
+bool persistent_service::recover_base(const std::string &path) {
+  if (!find_staged_base(path)) {
+    return false;
+  }
+  // The staged image was complete, so the deltas it folds in are stale
+  remove_deltas(path);
+  promote_base(path);
+  LOG(log_level::info) << "Recovered staged base image of " << path;
+  return true;
+}
+
+std::string persistent_service::staged_base_path(const std::string &path) {
+  return path + ".next";
+}
+
+std::string persistent_service::delta_path(const std::string &path, std::size_t seq) {
+  return path + "_delta_" + std::to_string(seq);
+}
+
+/* Suffixes of the files written by serializers for an image, the image itself first */
+static const char *const IMAGE_FILE_SUFFIXES[] = {"", "_offset"};
+static const std::size_t NUM_IMAGE_FILE_SUFFIXES = sizeof(IMAGE_FILE_SUFFIXES) / sizeof(IMAGE_FILE_SUFFIXES[0]);
+
+/* Suffixes of the files of a base image: its image files, then the write-ahead log segment it holds */
+static const char *const BASE_FILE_SUFFIXES[] = {"", "_offset", "_wal"};
+static const std::size_t NUM_BASE_FILE_SUFFIXES = sizeof(BASE_FILE_SUFFIXES) / sizeof(BASE_FILE_SUFFIXES[0]);
+
+/* Suffix of the file or object holding the write-ahead log segment of an image */
+static const char *const LOG_SEGMENT_SUFFIX = "_wal";
+
+/**
+ * @brief Rename a file and its companion files, the file itself last
+ * @param from Current path
+ * @param to New path
+ * @param suffixes Suffixes of the files, the file itself first
+ * @param num_suffixes Number of suffixes
+ */
+static void rename_files(const std::string &from, const std::string &to, const char *const *suffixes,
+                         std::size_t num_suffixes) {
+  // Companion files go first, so that a file is only visible once its companions are in place
+  for (std::size_t i = num_suffixes; i-- > 0;) {
+    auto from_path = from + suffixes[i];
+    auto to_path = to + suffixes[i];
+    if (std::rename(from_path.c_str(), to_path.c_str()) != 0 && (i == 0 || errno != ENOENT)) {
+      throw std::runtime_error("Error in renaming " + from_path + " to " + to_path);
+    }
+  }
+}
+
 local_store_impl::local_store_impl(std::shared_ptr<storage::serde> ser) : persistent_service(std::move(ser)) {}
 
+void local_store_impl::rename_image(const std::string &from, const std::string &to) {
+  rename_files(from, to, IMAGE_FILE_SUFFIXES, NUM_IMAGE_FILE_SUFFIXES);
+}
+
+bool local_store_impl::find_staged_base(const std::string &path) {
+  auto staged = staged_base_path(path);
+  if (std::ifstream(staged).good()) {
+    return true;
+  }
+  for (auto suffix: BASE_FILE_SUFFIXES) {
+    std::remove((staged + suffix).c_str());
+    std::remove((staged + ".write" + suffix).c_str());
+  }
+  return false;
+}
+
+void local_store_impl::write_log_segment(const std::string &path, std::uint64_t log_segment) {
+  auto segment_path = path + LOG_SEGMENT_SUFFIX;
+  if (log_segment == 0) {
+    std::remove(segment_path.c_str());
+    return;
+  }
+  auto tmp_path = segment_path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::trunc);
+    out << log_segment;
+    out.close();
+    if (out.fail()) {
+      throw std::runtime_error("Error in writing " + segment_path);
+    }
+  }
+  if (std::rename(tmp_path.c_str(), segment_path.c_str()) != 0) {
+    throw std::runtime_error("Error in renaming " + segment_path);
+  }
+}
+
+std::uint64_t local_store_impl::read_log_segment(const std::string &path) {
+  std::ifstream in(path + LOG_SEGMENT_SUFFIX);
+  std::uint64_t log_segment = 0;
+  in >> log_segment;
+  return in.fail() ? 0 : log_segment;
+}
+
+void local_store_impl::promote_base(const std::string &path) {
+  rename_files(staged_base_path(path), path, BASE_FILE_SUFFIXES, NUM_BASE_FILE_SUFFIXES);
+}
+
+void local_store_impl::write_delta(const delta &d, const std::string &out_path, std::size_t seq) {
+  auto path = delta_path(out_path, seq);
+  auto tmp_path = path + ".tmp";
+  async_ofstream out(tmp_path);
+  encode_delta(out, d);
+  out.close();
+  if (!out.good()) {
+    throw std::runtime_error("Error in writing delta file " + path);
+  }
+  // A delta is either complete or absent, so a crash mid-write never truncates a replay
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Error in renaming delta file " + path);
+  }
+}
+
+bool local_store_impl::read_delta(const std::string &in_path, std::size_t seq, delta &d) {
+  auto path = delta_path(in_path, seq);
+  async_ifstream in(path);
+  if (in.fail()) {
+    return false;
+  }
+  if (!decode_delta(in, d)) {
+    throw std::runtime_error("Corrupt delta file " + path);
+  }
+  return true;
+}
+
+void local_store_impl::remove_deltas(const std::string &path) {
+  // Deltas are numbered without gaps
+  for (std::size_t seq = 1; std::remove(delta_path(path, seq).c_str()) == 0; ++seq);
+}
+
 std::string local_store_impl::URI() {
   return "local";
 }
 
-#ifdef S3_EXTERNAL
+object_store_impl::object_store_impl(std::shared_ptr<storage::serde> ser,
+                                     std::shared_ptr<object_client> client,
+                                     std::string uri,
+                                     std::size_t part_size,
+                                     std::size_t num_threads)
+    : persistent_service(std::move(ser)),
+      transfer_(std::move(client), part_size, num_threads),
+      uri_(std::move(uri)),
+      staging_dir_(object_client::staging_dir()) {
+  directory_utils::create_directory(staging_dir_);
+}
+
+object_store_impl::staging_files::~staging_files() {
+  for (auto suffix: IMAGE_FILE_SUFFIXES) {
+    std::remove((path_ + suffix).c_str());
+  }
+}
 
-s3_store_impl::s3_store_impl(std::shared_ptr<storage::serde> ser) : persistent_service(std::move(ser)), options_{} {
-  options_.loggingOptions.logLevel = Aws::Utils::Logging::LogLevel::Warn;
-  Aws::InitAPI(options_);
+std::string object_store_impl::staging_path() {
+  static std::atomic<std::size_t> last_id(0);
+  return staging_dir_ + "/jiffy_staging_" + std::to_string(::getpid()) + "_" + std::to_string(++last_id);
 }
 
-s3_store_impl::~s3_store_impl() {
-  Aws::ShutdownAPI(options_);
+void object_store_impl::upload(const std::string &path, const std::string &out_path) {
+  auto path_elements = extract_path_elements(out_path);
+  // Companion files go first, so that a visible image is always complete
+  for (std::size_t i = NUM_IMAGE_FILE_SUFFIXES; i-- > 0;) {
+    auto local_path = path + IMAGE_FILE_SUFFIXES[i];
+    auto key = path_elements.second + IMAGE_FILE_SUFFIXES[i];
+    if (std::ifstream(local_path).good()) {
+      transfer_.upload(local_path, path_elements.first, key);
+    } else if (i > 0) {
+      // Drop a companion left by an image written with another serializer
+      transfer_.client()->delete_object(path_elements.first, key);
+    } else {
+      throw std::runtime_error("Serializer wrote no image for " + out_path);
+    }
+  }
 }
 
-std::pair<std::string, std::string> s3_store_impl::extract_path_elements(const std::string &s3_path) {
-  utils::directory_utils::check_path(s3_path);
+void object_store_impl::download(const std::string &in_path, const std::string &path) {
+  auto path_elements = extract_path_elements(in_path);
+  if (!transfer_.download(path_elements.first, path_elements.second, path)) {
+    throw std::runtime_error("No object " + in_path + " in " + uri_);
+  }
+  for (std::size_t i = 1; i < NUM_IMAGE_FILE_SUFFIXES; ++i) {
+    transfer_.download(path_elements.first, path_elements.second + IMAGE_FILE_SUFFIXES[i], path + IMAGE_FILE_SUFFIXES[i]);
+  }
+}
 
-  auto bucket_end = std::find(s3_path.begin() + 1, s3_path.end(), '/');
-  std::string bucket_name = std::string(s3_path.begin() + 1, bucket_end);
-  std::string key = (bucket_end == s3_path.end()) ? std::string() : std::string(bucket_end + 1, s3_path.end());
+std::pair<std::string, std::string> object_store_impl::extract_path_elements(const std::string &path) {
+  utils::directory_utils::check_path(path);
+  auto bucket_end = std::find(path.begin() + 1, path.end(), '/');
+  std::string bucket_name = std::string(path.begin() + 1, bucket_end);
+  std::string key = (bucket_end == path.end()) ? std::string() : std::string(bucket_end + 1, path.end());
   return std::make_pair(bucket_name, key);
 }
 
-std::string s3_store_impl::URI() {
-  return "s3";
+void object_store_impl::write_delta(const delta &d, const std::string &out_path, std::size_t seq) {
+  auto path_elements = extract_path_elements(delta_path(out_path, seq));
+  std::ostringstream out;
+  encode_delta(out, d);
+  auto data = out.str();
+  // Deltas are small, a single request stores them atomically
+  transfer_.client()->put_object(path_elements.first, path_elements.second, data.data(), data.size());
+}
+
+bool object_store_impl::read_delta(const std::string &in_path, std::size_t seq, delta &d) {
+  auto path_elements = extract_path_elements(delta_path(in_path, seq));
+  auto client = transfer_.client();
+  std::uint64_t size = 0;
+  if (!client->head_object(path_elements.first, path_elements.second, size)) {
+    return false;
+  }
+  std::string data(static_cast<std::size_t>(size), '\0');
+  client->get_range(path_elements.first, path_elements.second, 0, data.size(), &data[0]);
+  std::istringstream in(data);
+  if (!decode_delta(in, d)) {
+    throw std::runtime_error("Corrupt delta object " + delta_path(in_path, seq));
+  }
+  return true;
 }
 
-#endif
+void object_store_impl::remove_deltas(const std::string &path) {
+  auto client = transfer_.client();
+  for (std::size_t seq = 1;; ++seq) {
+    auto path_elements = extract_path_elements(delta_path(path, seq));
+    std::uint64_t size;
+    if (!client->head_object(path_elements.first, path_elements.second, size)) {
+      break;
+    }
+    client->delete_object(path_elements.first, path_elements.second);
+  }
+}
+
+bool object_store_impl::find_staged_base(const std::string &path) {
+  auto path_elements = extract_path_elements(staged_base_path(path));
+  auto client = transfer_.client();
+  std::uint64_t size;
+  if (client->head_object(path_elements.first, path_elements.second, size)) {
+    return true;
+  }
+  for (std::size_t i = 1; i < NUM_BASE_FILE_SUFFIXES; ++i) {
+    auto key = path_elements.second + BASE_FILE_SUFFIXES[i];
+    if (client->head_object(path_elements.first, key, size)) {
+      client->delete_object(path_elements.first, key);
+    }
+  }
+  return false;
+}
+
+void object_store_impl::write_log_segment(const std::string &path, std::uint64_t log_segment) {
+  auto path_elements = extract_path_elements(path + LOG_SEGMENT_SUFFIX);
+  if (log_segment == 0) {
+    transfer_.client()->delete_object(path_elements.first, path_elements.second);
+    return;
+  }
+  auto data = std::to_string(log_segment);
+  transfer_.client()->put_object(path_elements.first, path_elements.second, data.data(), data.size());
+}
+
+std::uint64_t object_store_impl::read_log_segment(const std::string &path) {
+  auto path_elements = extract_path_elements(path + LOG_SEGMENT_SUFFIX);
+  auto client = transfer_.client();
+  std::uint64_t size = 0;
+  if (!client->head_object(path_elements.first, path_elements.second, size) || size == 0) {
+    return 0;
+  }
+  std::string data(static_cast<std::size_t>(size), '\0');
+  client->get_range(path_elements.first, path_elements.second, 0, data.size(), &data[0]);
+  return std::stoull(data);
+}
+
+void object_store_impl::promote_base(const std::string &path) {
+  auto path_elements = extract_path_elements(path);
+  auto staged_key = extract_path_elements(staged_base_path(path)).second;
+  auto client = transfer_.client();
+  // Copies stay within the object store; companions go first, like uploads
+  for (std::size_t i = NUM_BASE_FILE_SUFFIXES; i-- > 0;) {
+    std::uint64_t size;
+    auto from = staged_key + BASE_FILE_SUFFIXES[i];
+    auto to = path_elements.second + BASE_FILE_SUFFIXES[i];
+    if (client->head_object(path_elements.first, from, size)) {
+      client->copy_object(path_elements.first, from, to);
+    } else if (i > 0) {
+      // Staged companions outlive the staged image, so a missing one was never written
+      client->delete_object(path_elements.first, to);
+    }
+  }
+  // The staged image goes first, so that left-over companions are never mistaken for a complete image
+  for (std::size_t i = 0; i < NUM_BASE_FILE_SUFFIXES; ++i) {
+    std::uint64_t size;
+    auto key = staged_key + BASE_FILE_SUFFIXES[i];
+    if (client->head_object(path_elements.first, key, size)) {
+      client->delete_object(path_elements.first, key);
+    }
+  }
+}
+
+std::string object_store_impl::URI() {
+  return uri_;
+}
 
 }
 }
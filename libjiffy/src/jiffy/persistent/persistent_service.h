@@ -1,8 +1,12 @@
 #ifndef JIFFY_PERSISTENT_SERVICE_H
 #define JIFFY_PERSISTENT_SERVICE_H
 
+#include <cstdint>
+#include <functional>
 #include <string>
 
+#include "jiffy/persistent/delta.h"
+#include "jiffy/persistent/object_store.h"
 #include "jiffy/storage/hashtable/hash_table_defs.h"
 #include "jiffy/storage/file/file_defs.h"
 #include "jiffy/storage/fifoqueue/fifo_queue_defs.h"
@@ -12,16 +16,6 @@
 #include "jiffy/utils/logger.h"
 #include "jiffy/utils/directory_utils.h"
 
-#ifdef S3_EXTERNAL
-#include <aws/core/Aws.h>
-#include <aws/core/utils/stream/SimpleStreamBuf.h>
-#include <aws/core/utils/logging/DefaultLogSystem.h>
-#include <aws/core/utils/logging/AWSLogging.h>
-#include <aws/s3/S3Client.h>
-#include <aws/s3/model/PutObjectRequest.h>
-#include <aws/s3/model/GetObjectRequest.h>
-#include <aws/s3/model/DeleteObjectRequest.h>
-#endif
 
 namespace jiffy {
 namespace persistent {
@@ -62,6 +56,106 @@ class persistent_service {
     return virtual_read(in_path, table);
   }
 
+  /**
+   * @brief Write a delta file next to a base image
+   * @param d Delta
+   * @param out_path Persistent store path of the base image
+   * @param seq Delta sequence number, deltas of a base image are numbered from 1
+   */
+  virtual void write_delta(const delta &d, const ::std::string &out_path, ::std::size_t seq) = 0;
+
+  /**
+   * @brief Read a delta file of a base image
+   * @param in_path Persistent store path of the base image
+   * @param seq Delta sequence number
+   * @param d Delta
+   * @return Bool value, false if the delta file does not exist
+   */
+  virtual bool read_delta(const ::std::string &in_path, ::std::size_t seq, delta &d) = 0;
+
+  /**
+   * @brief Remove the delta files of a base image, once the base image was rewritten
+   * @param path Persistent store path of the base image
+   */
+  virtual void remove_deltas(const ::std::string &path) = 0;
+
+  /**
+   * @brief Replay the delta files of a base image in sequence order
+   * @param in_path Persistent store path of the base image
+   * @param apply Called with each delta
+   * @param log_segment If set, receives the last write-ahead log segment the deltas hold, 0 if none
+   * @return Pair of number of deltas and their total encoded size
+   */
+  ::std::pair<::std::size_t, ::std::size_t> replay_deltas(const ::std::string &in_path,
+                                                          const ::std::function<void(const delta &)> &apply,
+                                                          ::std::uint64_t *log_segment = nullptr);
+
+  /**
+   * @brief Replace a base image and drop its deltas.
+   * The new image is staged next to the base image and its deltas are removed only once it is complete,
+   * so a crash at any point leaves either the old base image with its deltas or the new one without them.
+   * @param table Data structure
+   * @param out_path Persistent store path of the base image
+   * @param log_segment Last write-ahead log segment whose commands the image holds, 0 if none
+   */
+  template<typename Datatype>
+  void write_base(const Datatype &table, const ::std::string &out_path, ::std::uint64_t log_segment = 0) {
+    auto staged_path = staged_base_path(out_path);
+    write_log_segment(staged_path, log_segment);
+    write(table, staged_path);
+    remove_deltas(out_path);
+    promote_base(out_path);
+  }
+
+  /**
+   * @brief Record the last write-ahead log segment whose commands an image holds
+   * @param path Persistent store path of the image
+   * @param log_segment Segment number, 0 to record none
+   */
+  virtual void write_log_segment(const ::std::string &path, ::std::uint64_t log_segment) = 0;
+
+  /**
+   * @brief Fetch the last write-ahead log segment whose commands an image holds
+   * @param path Persistent store path of the image
+   * @return Segment number, 0 if none was recorded
+   */
+  virtual ::std::uint64_t read_log_segment(const ::std::string &path) = 0;
+
+  /**
+   * @brief Finish a base image replacement interrupted by a crash, before the base image is read
+   * @param path Persistent store path of the base image
+   * @return Bool value, true if a staged base image took the place of the base image
+   */
+  bool recover_base(const ::std::string &path);
+
+  /**
+   * @brief Check for a complete staged base image, removing the pieces of an incomplete one
+   * @param path Persistent store path of the base image
+   * @return Bool value, true if a complete staged base image exists
+   */
+  virtual bool find_staged_base(const ::std::string &path) = 0;
+
+  /**
+   * @brief Move a complete staged base image into the place of the base image
+   * @param path Persistent store path of the base image
+   */
+  virtual void promote_base(const ::std::string &path) = 0;
+
+  /**
+   * @brief Fetch the path a base image is staged at
+   * @param path Persistent store path of the base image
+   * @return Staged base image path
+   */
+  static ::std::string staged_base_path(const ::std::string &path);
+
+  /**
+   * @brief Fetch the path of a delta file
+   * @param path Persistent store path of the base image
+   * @param seq Delta sequence number
+   * @return Delta file path
+   */
+  static ::std::string delta_path(const ::std::string &path, ::std::size_t seq);
+
   /**
    * @brief Fetch URI
    * @return URI
@@ -265,9 +359,10 @@ class local_store_impl : public persistent_service {
     size_t found = out_path.find_last_of("/\\");
     auto dir = out_path.substr(0, found);
     directory_utils::create_directory(dir);
-    std::shared_ptr<std::ofstream> out(new ::std::ofstream(out_path));
-    serde()->serialize<Datatype>(table, out_path);
-    out->close();
+    // The serializer writes through the asynchronous I/O engine, to files renamed into place once complete
+    auto tmp_path = out_path + ".write";
+    serde()->serialize<Datatype>(table, tmp_path);
+    rename_image(tmp_path, out_path);
   }
 
   /**
@@ -277,128 +372,230 @@ class local_store_impl : public persistent_service {
    */
   template<typename Datatype>
   void read_impl(const ::std::string &in_path, Datatype &table) {
-    auto in = ::std::make_shared<::std::ifstream>(in_path.c_str(), ::std::fstream::in);
+    // The deserializer reads ahead through the asynchronous I/O engine, or maps binary images directly
     serde()->deserialize<Datatype>(table, in_path);
-    in->close();
   }
 
  public:
   /**
-   * @brief Fetch URI
-   * @return URI string
+   * @brief Write a delta file, renamed into place once complete
+   * @param d Delta
+   * @param out_path Persistent store path of the base image
+   * @param seq Delta sequence number
    */
+  void write_delta(const delta &d, const ::std::string &out_path, ::std::size_t seq) override;
 
-  ::std::string URI() override;
-};
+  /**
+   * @brief Read a delta file
+   * @param in_path Persistent store path of the base image
+   * @param seq Delta sequence number
+   * @param d Delta
+   * @return Bool value, false if the delta file does not exist
+   */
+  bool read_delta(const ::std::string &in_path, ::std::size_t seq, delta &d) override;
 
-using local_store = derived_persistent<local_store_impl>;
+  /**
+   * @brief Remove the delta files of a base image
+   * @param path Persistent store path of the base image
+   */
+  void remove_deltas(const ::std::string &path) override;
 
-#ifdef S3_EXTERNAL
+  /**
+   * @brief Check for a complete staged base image, removing the pieces of an incomplete one
+   * @param path Persistent store path of the base image
+   * @return Bool value, true if a complete staged base image exists
+   */
+  bool find_staged_base(const ::std::string &path) override;
 
-/* s3_store class, inherited from persistent_service class */
-class s3_store_impl : public persistent_service {
- public:
+  /**
+   * @brief Write the log segment file of an image, renamed into place once complete
+   * @param path Persistent store path of the image
+   * @param log_segment Segment number, 0 to remove the file
+   */
+  void write_log_segment(const ::std::string &path, ::std::uint64_t log_segment) override;
 
   /**
-   * @brief Destructor
+   * @brief Read the log segment file of an image
+   * @param path Persistent store path of the image
+   * @return Segment number, 0 if the file does not exist
    */
+  ::std::uint64_t read_log_segment(const ::std::string &path) override;
 
-  ~s3_store_impl();
- protected:
+  /**
+   * @brief Rename a complete staged base image into the place of the base image
+   * @param path Persistent store path of the base image
+   */
+  void promote_base(const ::std::string &path) override;
 
+  /**
+   * @brief Fetch URI
+   * @return URI string
+   */
+
+  ::std::string URI() override;
+
+ private:
+  /**
+   * @brief Rename an image and its companion files, the image itself last
+   * @param from Current image path
+   * @param to New image path
+   */
+  static void rename_image(const ::std::string &from, const ::std::string &to);
+};
+
+using local_store = derived_persistent<local_store_impl>;
+
+/**
+ * @brief Object store, inherited from persistent_service.
+ * Images are serialized to a local staging file and transferred in parts by several threads; persistent
+ * store paths are of the form /bucket/key.
+ */
+class object_store_impl : public persistent_service {
+ protected:
   /**
    * @brief Constructor
    * @param ser Custom serializer/deserializer
+   * @param client Object store client, shared by all stores of the process
+   * @param uri Object store URI
+   * @param part_size Bytes per part and per ranged read
+   * @param num_threads Number of parts transferred at once
    */
-
-  s3_store_impl(::std::shared_ptr<storage::serde> ser);
+  object_store_impl(::std::shared_ptr<storage::serde> ser,
+                    ::std::shared_ptr<object_client> client,
+                    ::std::string uri,
+                    ::std::size_t part_size = object_client::part_size(),
+                    ::std::size_t num_threads = object_client::num_threads());
 
   /**
-   * @brief Write data from hash table to persistent storage
-   * @param table Hash table
+   * @brief Write data from data structure to the object store
+   * @param table Data structure
    * @param out_path Output persistent storage path
    */
-  
   template<typename Datatype>
   void write_impl(const Datatype &table, const ::std::string &out_path) {
-    auto path_elements = extract_path_elements(out_path);
-    auto bucket_name = path_elements.first.c_str();
-    auto key = path_elements.second.c_str();
-
-    Aws::Client::ClientConfiguration client_config;
-    Aws::S3::S3Client s3_client(client_config);
-
-    Aws::S3::Model::PutObjectRequest object_request;
-    object_request.WithBucket(bucket_name).WithKey(key);
-
-    Aws::Utils::Stream::SimpleStreamBuf sbuf;
-    auto out = Aws::MakeShared<Aws::IOStream>("StreamBuf", &sbuf);
-    serde()->serialize<Datatype>(table, out_path);
-    out->seekg(0, ::std::ios_base::beg);
-
-    object_request.SetBody(out);
-    auto put_object_outcome = s3_client.PutObject(object_request);
-    if (put_object_outcome.IsSuccess()) {
-      LOG(log_level::info) << "Successfully wrote table to " << out_path;
-    } else {
-      LOG(log_level::error) << "S3 PutObject error: " << put_object_outcome.GetError().GetExceptionName() << " " <<
-                            put_object_outcome.GetError().GetMessage();
-      throw ::std::runtime_error("Error in writing data to S3");
-    }
+    staging_files staged(staging_path());
+    serde()->serialize<Datatype>(table, staged.path());
+    upload(staged.path(), out_path);
+    LOG(log_level::info) << "Successfully wrote table to " << out_path;
   }
 
   /**
-   * @brief Read data from persistent storage to hash table
+   * @brief Read data from the object store to data structure
    * @param in_path Input persistent storage path
-   * @param table Hash table
+   * @param table Data structure
    */
-
   template<typename Datatype>
   void read_impl(const ::std::string &in_path, Datatype &table) {
-    auto path_elements = extract_path_elements(in_path);
-    auto bucket_name = path_elements.first.c_str();
-    auto key = path_elements.second.c_str();
-
-    Aws::S3::S3Client s3_client;
-
-    Aws::S3::Model::GetObjectRequest object_request;
-    object_request.WithBucket(bucket_name).WithKey(key);
-
-    auto get_object_outcome = s3_client.GetObject(object_request);
-
-    if (get_object_outcome.IsSuccess()) {
-      Aws::OFStream local_file;
-      auto in = ::std::make_shared<Aws::IOStream>(get_object_outcome.GetResult().GetBody().rdbuf());
-      serde()->deserialize<Datatype>(table, in_path);
-      LOG(log_level::info) << "Successfully read table from " << in_path;
-    } else {
-      LOG(log_level::error) << "S3 GetObject error: " << get_object_outcome.GetError().GetExceptionName() << " " <<
-                            get_object_outcome.GetError().GetMessage();
-      throw ::std::runtime_error("Error in reading data from S3");
-    }
+    staging_files staged(staging_path());
+    download(in_path, staged.path());
+    serde()->deserialize<Datatype>(table, staged.path());
+    LOG(log_level::info) << "Successfully read table from " << in_path;
   }
+
  public:
+  /**
+   * @brief Write a delta object
+   * @param d Delta
+   * @param out_path Persistent store path of the base image
+   * @param seq Delta sequence number
+   */
+  void write_delta(const delta &d, const ::std::string &out_path, ::std::size_t seq) override;
+
+  /**
+   * @brief Read a delta object
+   * @param in_path Persistent store path of the base image
+   * @param seq Delta sequence number
+   * @param d Delta
+   * @return Bool value, false if the delta object does not exist
+   */
+  bool read_delta(const ::std::string &in_path, ::std::size_t seq, delta &d) override;
+
+  /**
+   * @brief Remove the delta objects of a base image
+   * @param path Persistent store path of the base image
+   */
+  void remove_deltas(const ::std::string &path) override;
+
+  /**
+   * @brief Check for a complete staged base image, removing the pieces of an incomplete one
+   * @param path Persistent store path of the base image
+   * @return Bool value, true if a complete staged base image exists
+   */
+  bool find_staged_base(const ::std::string &path) override;
+
+  /**
+   * @brief Write the log segment object of an image
+   * @param path Persistent store path of the image
+   * @param log_segment Segment number, 0 to delete the object
+   */
+  void write_log_segment(const ::std::string &path, ::std::uint64_t log_segment) override;
+
+  /**
+   * @brief Read the log segment object of an image
+   * @param path Persistent store path of the image
+   * @return Segment number, 0 if the object does not exist
+   */
+  ::std::uint64_t read_log_segment(const ::std::string &path) override;
+
+  /**
+   * @brief Copy a complete staged base image into the place of the base image and delete it
+   * @param path Persistent store path of the base image
+   */
+  void promote_base(const ::std::string &path) override;
+
   /**
    * @brief Fetch URI
    * @return URI string
    */
-
   ::std::string URI() override;
+
  private:
+  /* Staging file of an image and its companion files, removed on destruction */
+  class staging_files {
+   public:
+    explicit staging_files(::std::string path) : path_(::std::move(path)) {}
+    ~staging_files();
+    const ::std::string &path() const { return path_; }
+   private:
+    ::std::string path_;
+  };
+
+  /**
+   * @brief Fetch a new staging file path
+   * @return Staging file path
+   */
+  ::std::string staging_path();
+
+  /**
+   * @brief Upload a serialized image and its companion files
+   * @param path Staging file path
+   * @param out_path Output persistent storage path
+   */
+  void upload(const ::std::string &path, const ::std::string &out_path);
+
+  /**
+   * @brief Download an image and its companion files
+   * @param in_path Input persistent storage path
+   * @param path Staging file path
+   */
+  void download(const ::std::string &in_path, const ::std::string &path);
+
   /**
    * @brief Extract path element
-   * @param s3_path s3 path
+   * @param path Persistent store path
    * @return Pair of bucket name and key
    */
+  static ::std::pair<::std::string, ::std::string> extract_path_elements(const ::std::string &path);
 
-  ::std::pair<::std::string, ::std::string> extract_path_elements(const ::std::string &s3_path);
-  /* AWS SDK options */
-  Aws::SDKOptions options_;
+  /* Parallel transfers through the shared client */
+  object_transfer transfer_;
+  /* Object store URI */
+  ::std::string uri_;
+  /* Local directory holding staging files */
+  ::std::string staging_dir_;
 };
 
-using s3_store = derived_persistent<s3_store_impl>;
-
-#endif
+using object_store = derived_persistent<object_store_impl>;
 
 }
 }
@@ -11,7 +11,7 @@ std::shared_ptr<persistent_service> persistent_store::instance(const std::string
   }
 #ifdef S3_EXTERNAL
   else if (uri == "s3") {
-    return std::make_shared<s3_store>(std::move(ser));
+    return std::make_shared<object_store>(std::move(ser), object_client::instance(uri), uri);
   }
 #endif
   return nullptr;
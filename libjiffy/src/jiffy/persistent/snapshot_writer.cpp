@@ -0,0 +1,148 @@
+#include "snapshot_writer.h"
+#include <algorithm>
+#include "jiffy/utils/logger.h"
+
+namespace jiffy {
+namespace persistent {
+
+using namespace utils;
+
+void snapshot_status::fail(std::exception_ptr error) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (error_ == nullptr) {
+    error_ = std::move(error);
+  }
+  failed_ = true;
+}
+
+std::exception_ptr snapshot_status::take_error() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto error = error_;
+  error_ = nullptr;
+  return error;
+}
+
+bool snapshot_status::take_failure() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto failed = failed_;
+  failed_ = false;
+  return failed;
+}
+
+void snapshot_status::add(std::uint64_t ticket) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  last_ticket_ = std::max(last_ticket_, ticket);
+}
+
+std::uint64_t snapshot_status::last_ticket() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return last_ticket_;
+}
+
+snapshot_writer::snapshot_writer(std::size_t rate_limit)
+    : rate_limit_(rate_limit),
+      available_at_(clock_type::now()),
+      last_ticket_(0),
+      done_ticket_(0),
+      stop_(false) {
+  worker_ = std::thread([this] { run(); });
+}
+
+snapshot_writer::~snapshot_writer() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+std::uint64_t snapshot_writer::submit(const std::shared_ptr<snapshot_status> &status,
+                                      std::size_t bytes,
+                                      job_type job) {
+  std::uint64_t ticket;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ticket = ++last_ticket_;
+    // Recorded before the job can complete, so that waiting on the status never misses it
+    status->add(ticket);
+    queue_.push_back(entry{ticket, status, bytes, std::move(job)});
+  }
+  cv_.notify_all();
+  return ticket;
+}
+
+void snapshot_writer::wait(std::uint64_t ticket) {
+  std::unique_lock<std::mutex> lock(mtx_);
+  done_cv_.wait(lock, [this, ticket] { return done_ticket_ >= ticket; });
+}
+
+void snapshot_writer::wait_all() {
+  std::uint64_t ticket;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ticket = last_ticket_;
+  }
+  wait(ticket);
+}
+
+std::size_t snapshot_writer::rate_limit() const {
+  return rate_limit_;
+}
+
+void snapshot_writer::run() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      break;
+    }
+    // Queued jobs are flushed at full speed once the writer stops
+    auto now = clock_type::now();
+    if (rate_limit_ > 0 && !stop_ && now < available_at_) {
+      cv_.wait_until(lock, available_at_);
+      continue;
+    }
+    auto e = std::move(queue_.front());
+    queue_.pop_front();
+    if (rate_limit_ > 0) {
+      auto duration = std::chrono::duration<double>(static_cast<double>(e.bytes) / rate_limit_);
+      available_at_ = std::max(now, available_at_) + std::chrono::duration_cast<clock_type::duration>(duration);
+    }
+    lock.unlock();
+    try {
+      e.job();
+    } catch (std::exception &ex) {
+      LOG(log_level::error) << "Snapshot failed: " << ex.what();
+      e.status->fail(std::current_exception());
+    } catch (...) {
+      e.status->fail(std::current_exception());
+    }
+    lock.lock();
+    done_ticket_ = e.ticket;
+    done_cv_.notify_all();
+  }
+}
+
+/* Writer configuration used by instance() */
+static std::mutex instance_mtx;
+static std::size_t instance_rate_limit = 0;
+
+void snapshot_writer::configure(std::size_t rate_limit) {
+  std::lock_guard<std::mutex> lock(instance_mtx);
+  instance_rate_limit = rate_limit;
+}
+
+std::shared_ptr<snapshot_writer> snapshot_writer::instance() {
+  static std::shared_ptr<snapshot_writer> writer;
+  std::lock_guard<std::mutex> lock(instance_mtx);
+  if (writer == nullptr) {
+    writer = std::make_shared<snapshot_writer>(instance_rate_limit);
+  }
+  return writer;
+}
+
+}
+}
@@ -0,0 +1,174 @@
+#ifndef JIFFY_SNAPSHOT_WRITER_H
+#define JIFFY_SNAPSHOT_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace jiffy {
+namespace persistent {
+
+/**
+ * @brief Outcome of the snapshot jobs of one partition.
+ *
+ * Shared between the partition and its jobs, so that a job can report a failure even if the
+ * partition is gone by the time it runs.
+ */
+class snapshot_status {
+ public:
+  /**
+   * @brief Record a failed job
+   * @param error Error of the job
+   */
+  void fail(std::exception_ptr error);
+
+  /**
+   * @brief Fetch and clear the first error recorded since the previous call
+   * @return Error, null if no job failed
+   */
+  std::exception_ptr take_error();
+
+  /**
+   * @brief Check and clear whether a job failed since the previous call; the next snapshot then has to
+   * write a full image since the deltas on the persistent store may have a gap
+   * @return Bool value, true if a job failed
+   */
+  bool take_failure();
+
+  /**
+   * @brief Record a job handed to the snapshot writer
+   * @param ticket Ticket of the job
+   */
+  void add(std::uint64_t ticket);
+
+  /**
+   * @brief Fetch the ticket of the latest job
+   * @return Ticket, 0 if none
+   */
+  std::uint64_t last_ticket() const;
+
+ private:
+  /* Mutex */
+  mutable std::mutex mtx_;
+  /* First error not fetched yet */
+  std::exception_ptr error_;
+  /* Bool value, true if a job failed since the previous take_failure() */
+  bool failed_ = false;
+  /* Ticket of the latest job */
+  std::uint64_t last_ticket_ = 0;
+};
+
+/**
+ * @brief Background writer of partition snapshots.
+ *
+ * Partitions capture their data while briefly frozen and hand the persistent store writes to the
+ * writer as self contained jobs, so that commands keep running while the snapshot is serialized.
+ * Jobs run one at a time in submission order, hence a delta is never written before the base image
+ * it extends. Writes are paced to a byte rate so that snapshots do not saturate the disk or network
+ * link shared with foreground traffic.
+ */
+class snapshot_writer {
+ public:
+  /* Snapshot job, must not refer to the partition that submitted it */
+  typedef std::function<void()> job_type;
+
+  /**
+   * @brief Constructor
+   * @param rate_limit Maximum number of bytes written per second, 0 for no limit
+   */
+  explicit snapshot_writer(std::size_t rate_limit = 0);
+
+  /**
+   * @brief Destructor, runs queued jobs first
+   */
+  ~snapshot_writer();
+
+  snapshot_writer(const snapshot_writer &) = delete;
+  snapshot_writer &operator=(const snapshot_writer &) = delete;
+
+  /**
+   * @brief Queue a job
+   * @param status Status of the submitting partition, records the ticket and any error of the job
+   * @param bytes Number of bytes the job writes, for pacing
+   * @param job Job
+   * @return Ticket of the job
+   */
+  std::uint64_t submit(const std::shared_ptr<snapshot_status> &status, std::size_t bytes, job_type job);
+
+  /**
+   * @brief Wait for the jobs up to a ticket to complete
+   * @param ticket Ticket
+   */
+  void wait(std::uint64_t ticket);
+
+  /**
+   * @brief Wait for all jobs queued so far to complete
+   */
+  void wait_all();
+
+  /**
+   * @brief Fetch the rate limit
+   * @return Maximum number of bytes written per second, 0 for no limit
+   */
+  std::size_t rate_limit() const;
+
+  /**
+   * @brief Configure the writer returned by instance(), before its first use
+   * @param rate_limit Maximum number of bytes written per second, 0 for no limit
+   */
+  static void configure(std::size_t rate_limit);
+
+  /**
+   * @brief Fetch the process wide writer, created on first use
+   * @return Writer
+   */
+  static std::shared_ptr<snapshot_writer> instance();
+
+ private:
+  typedef std::chrono::steady_clock clock_type;
+
+  /* Queued job */
+  struct entry {
+    std::uint64_t ticket;
+    std::shared_ptr<snapshot_status> status;
+    std::size_t bytes;
+    job_type job;
+  };
+
+  /**
+   * @brief Run queued jobs until stopped
+   */
+  void run();
+
+  /* Maximum number of bytes written per second */
+  std::size_t rate_limit_;
+  /* Time the writer is free to start the next job under the rate limit */
+  clock_type::time_point available_at_;
+  /* Queued jobs */
+  std::deque<entry> queue_;
+  /* Ticket of the latest queued job */
+  std::uint64_t last_ticket_;
+  /* Ticket of the latest completed job */
+  std::uint64_t done_ticket_;
+  /* Mutex */
+  std::mutex mtx_;
+  /* Signalled when jobs are queued or the writer stops */
+  std::condition_variable cv_;
+  /* Signalled when a job completes */
+  std::condition_variable done_cv_;
+  /* Stop flag */
+  bool stop_;
+  /* Writer thread */
+  std::thread worker_;
+};
+
+}
+}
+
+#endif //JIFFY_SNAPSHOT_WRITER_H
@@ -0,0 +1,130 @@
+#include "task_queue.h"
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+#include "jiffy/utils/logger.h"
+
+namespace jiffy {
+namespace persistent {
+
+using namespace utils;
+
+/* Thread pool running the tasks of all queues */
+class task_pool {
+ public:
+  /**
+   * @brief Constructor
+   * @param num_threads Number of threads
+   */
+  explicit task_pool(std::size_t num_threads) : stop_(false) {
+    for (std::size_t i = 0; i < num_threads; ++i) {
+      workers_.emplace_back([this] {
+        while (true) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+              return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  /**
+   * @brief Destructor, completes queued tasks first
+   */
+  ~task_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker: workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * @brief Queue a task
+   * @param task Task
+   */
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      queue_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  /**
+   * @brief Fetch the pool shared by all queues
+   * @return Pool
+   */
+  static task_pool &instance() {
+    // Never destroyed, queues of partitions may still run tasks during process exit
+    static auto *pool = new task_pool(std::max(std::thread::hardware_concurrency(), 1U));
+    return *pool;
+  }
+
+ private:
+  /* Queued tasks */
+  std::deque<std::function<void()>> queue_;
+  /* Queue mutex */
+  std::mutex mtx_;
+  /* Signalled when tasks are queued or the pool stops */
+  std::condition_variable cv_;
+  /* Stop flag */
+  bool stop_;
+  /* Worker threads */
+  std::vector<std::thread> workers_;
+};
+
+task_queue::~task_queue() {
+  wait();
+}
+
+void task_queue::submit(task_type task) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  tasks_.push_back(std::move(task));
+  if (!running_) {
+    running_ = true;
+    task_pool::instance().submit([this] { run_next(); });
+  }
+}
+
+void task_queue::wait() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  cv_.wait(lock, [this] { return !running_; });
+}
+
+void task_queue::run_next() {
+  task_type task;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    task = std::move(tasks_.front());
+  }
+  try {
+    task();
+  } catch (std::exception &e) {
+    LOG(log_level::error) << "Task failed: " << e.what();
+  }
+  std::lock_guard<std::mutex> lock(mtx_);
+  tasks_.pop_front();
+  if (tasks_.empty()) {
+    running_ = false;
+    cv_.notify_all();
+    return;
+  }
+  // One task at a time, so that a busy queue does not hold a pool thread from other queues
+  task_pool::instance().submit([this] { run_next(); });
+}
+
+}
+}
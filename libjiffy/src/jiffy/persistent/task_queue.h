@@ -0,0 +1,64 @@
+#ifndef JIFFY_TASK_QUEUE_H
+#define JIFFY_TASK_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace jiffy {
+namespace persistent {
+
+/**
+ * @brief Serial queue of blocking tasks, such as disk I/O that must not run on a server thread.
+ *
+ * Tasks of one queue run one at a time in submission order, on a thread pool shared by all queues,
+ * so that tasks of different queues run concurrently. Exceptions thrown by a task are logged.
+ */
+class task_queue {
+ public:
+  /* Task */
+  typedef std::function<void()> task_type;
+
+  task_queue() = default;
+
+  /**
+   * @brief Destructor, waits for queued tasks
+   */
+  ~task_queue();
+
+  task_queue(const task_queue &) = delete;
+  task_queue &operator=(const task_queue &) = delete;
+
+  /**
+   * @brief Queue a task, never blocks
+   * @param task Task
+   */
+  void submit(task_type task);
+
+  /**
+   * @brief Wait for queued tasks to finish
+   * Must not be called from a task of the queue
+   */
+  void wait();
+
+ private:
+  /**
+   * @brief Run the oldest task on the pool, then hand the next one to the pool
+   */
+  void run_next();
+
+  /* Queued tasks, the front one is running if running_ is set */
+  std::deque<task_type> tasks_;
+  /* Queue mutex */
+  std::mutex mtx_;
+  /* Signalled when the queue drains */
+  std::condition_variable cv_;
+  /* Bool value, true while a task of the queue is on the pool */
+  bool running_ = false;
+};
+
+}
+}
+
+#endif //JIFFY_TASK_QUEUE_H
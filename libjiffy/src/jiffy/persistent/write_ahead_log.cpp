@@ -0,0 +1,466 @@
+#include "write_ahead_log.h"
+#include "crc32c.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include "jiffy/utils/directory_utils.h"
+#include "jiffy/utils/logger.h"
+
+namespace jiffy {
+namespace persistent {
+
+using namespace utils;
+
+/* Size of a record header: payload size and payload checksum */
+static const std::size_t RECORD_HEADER_SIZE = 2 * sizeof(std::uint32_t);
+
+/* Separates the escaped log name from the segment number in segment file names */
+static const char *const WAL_SUFFIX = ".wal.";
+
+/* Log configuration */
+static std::mutex config_mtx;
+static std::string config_dir = "/tmp/jiffy_wal";
+static std::size_t config_fsync_delay_us = 0;
+static std::size_t config_fsync_batch_bytes = 1048576;
+
+/**
+ * @brief Run the callbacks of durable records, logging the exceptions they throw
+ * @param callbacks Callbacks
+ */
+static void run_callbacks(std::vector<write_ahead_log::callback_type> &callbacks) {
+  for (auto &callback: callbacks) {
+    try {
+      callback();
+    } catch (std::exception &e) {
+      LOG(log_level::error) << "Write-ahead log callback failed: " << e.what();
+    } catch (...) {
+      LOG(log_level::error) << "Write-ahead log callback failed";
+    }
+  }
+  callbacks.clear();
+}
+
+/**
+ * @brief Process-wide thread that makes the records of all logs durable.
+ * Logs register on creation; appends signal the flusher, which syncs every log with pending records.
+ */
+class log_flusher {
+ public:
+  log_flusher(std::size_t fsync_delay_us, std::size_t fsync_batch_bytes)
+      : fsync_delay_(std::chrono::microseconds(fsync_delay_us)),
+        fsync_batch_bytes_(fsync_batch_bytes),
+        pending_bytes_(0),
+        stop_(false) {
+    worker_ = std::thread([this] { run(); });
+  }
+
+  ~log_flusher() {
+    {
+      std::lock_guard<std::mutex> lock(signal_mtx_);
+      stop_ = true;
+    }
+    signal_cv_.notify_all();
+    worker_.join();
+  }
+
+  void add(write_ahead_log *log) {
+    std::lock_guard<std::mutex> lock(logs_mtx_);
+    logs_.push_back(log);
+  }
+
+  void remove(write_ahead_log *log) {
+    // Waits for a flush in progress, which may be using the log, and for the callbacks it made ready
+    std::lock_guard<std::mutex> lock(logs_mtx_);
+    std::lock_guard<std::mutex> callbacks_lock(callbacks_mtx_);
+    logs_.erase(std::remove(logs_.begin(), logs_.end(), log), logs_.end());
+  }
+
+  void wait_callbacks() {
+    // The flusher holds the callbacks lock before it releases the logs lock
+    std::lock_guard<std::mutex> lock(logs_mtx_);
+    std::lock_guard<std::mutex> callbacks_lock(callbacks_mtx_);
+  }
+
+  void notify(std::size_t bytes) {
+    {
+      std::lock_guard<std::mutex> lock(signal_mtx_);
+      pending_bytes_ += bytes;
+    }
+    signal_cv_.notify_one();
+  }
+
+  static std::shared_ptr<log_flusher> instance() {
+    static std::shared_ptr<log_flusher> flusher;
+    std::lock_guard<std::mutex> lock(config_mtx);
+    if (flusher == nullptr) {
+      flusher = std::make_shared<log_flusher>(config_fsync_delay_us, config_fsync_batch_bytes);
+    }
+    return flusher;
+  }
+
+ private:
+  void run() {
+    std::unique_lock<std::mutex> lock(signal_mtx_);
+    while (true) {
+      signal_cv_.wait(lock, [this] { return stop_ || pending_bytes_ > 0; });
+      if (stop_ && pending_bytes_ == 0) {
+        break;
+      }
+      // Gather more records into the group, unless enough are pending already
+      if (fsync_delay_.count() > 0 && !stop_) {
+        signal_cv_.wait_for(lock, fsync_delay_, [this] { return stop_ || pending_bytes_ >= fsync_batch_bytes_; });
+      }
+      pending_bytes_ = 0;
+      lock.unlock();
+      std::unique_lock<std::mutex> callbacks_lock;
+      {
+        std::lock_guard<std::mutex> logs_lock(logs_mtx_);
+        for (auto log: logs_) {
+          log->flush(ready_);
+        }
+        callbacks_lock = std::unique_lock<std::mutex>(callbacks_mtx_);
+      }
+      // Logs can be added while callbacks run, e.g. by the commands they respond to
+      run_callbacks(ready_);
+      callbacks_lock.unlock();
+      lock.lock();
+    }
+  }
+
+  /* Time to wait for more records before syncing */
+  std::chrono::microseconds fsync_delay_;
+  /* Number of pending bytes that ends the wait early */
+  std::size_t fsync_batch_bytes_;
+  /* Mutex guarding the registered logs, held while flushing them */
+  std::mutex logs_mtx_;
+  /* Registered logs */
+  std::vector<write_ahead_log *> logs_;
+  /* Mutex held while running callbacks, so that removed logs outlive the callbacks they made ready */
+  std::mutex callbacks_mtx_;
+  /* Callbacks of the records made durable by the latest flush */
+  std::vector<write_ahead_log::callback_type> ready_;
+  /* Mutex guarding the pending byte count and stop flag */
+  std::mutex signal_mtx_;
+  /* Signalled on appends and on stop */
+  std::condition_variable signal_cv_;
+  /* Number of bytes appended since the previous flush */
+  std::size_t pending_bytes_;
+  /* Stop flag */
+  bool stop_;
+  /* Flusher thread */
+  std::thread worker_;
+};
+
+/**
+ * @brief Escape a log name into a file name
+ * @param name Log name
+ * @return File name
+ */
+static std::string escape_name(const std::string &name) {
+  static const char *hex = "0123456789abcdef";
+  std::string out;
+  for (auto c: name) {
+    if (std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-') {
+      out.push_back(c);
+    } else {
+      out.push_back('%');
+      out.push_back(hex[static_cast<unsigned char>(c) >> 4]);
+      out.push_back(hex[static_cast<unsigned char>(c) & 0xf]);
+    }
+  }
+  return out;
+}
+
+write_ahead_log::write_ahead_log(const std::string &dir, const std::string &name, std::uint64_t min_segment)
+    : dir_(dir), name_(name), prefix_(escape_name(name) + WAL_SUFFIX), last_lsn_(0), durable_lsn_(0), fd_(-1) {
+  directory_utils::create_directory(dir_);
+  auto existing = segments(dir_, prefix_);
+  segment_ = std::max<std::uint64_t>(existing.empty() ? 1 : existing.back() + 1, min_segment);
+  first_segment_ = segment_;
+  log_flusher::instance()->add(this);
+}
+
+write_ahead_log::~write_ahead_log() {
+  log_flusher::instance()->remove(this);
+  flush();
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+const std::string &write_ahead_log::name() const {
+  return name_;
+}
+
+std::uint64_t write_ahead_log::append(const record_type &r) {
+  std::string payload;
+  auto put_u32 = [&payload](std::size_t v) {
+    auto u = static_cast<std::uint32_t>(v);
+    payload.append(reinterpret_cast<const char *>(&u), sizeof(u));
+  };
+  put_u32(r.size());
+  for (const auto &arg: r) {
+    put_u32(arg.size());
+    payload.append(arg);
+  }
+  std::uint32_t header[2] = {static_cast<std::uint32_t>(payload.size()), crc32c(0, payload.data(), payload.size())};
+  std::uint64_t lsn;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    buffer_.append(reinterpret_cast<const char *>(header), sizeof(header));
+    buffer_.append(payload);
+    lsn = ++last_lsn_;
+  }
+  log_flusher::instance()->notify(sizeof(header) + payload.size());
+  return lsn;
+}
+
+void write_ahead_log::when_durable(std::uint64_t lsn, callback_type callback) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (lsn > durable_lsn_) {
+      waiters_.emplace_back(lsn, std::move(callback));
+      return;
+    }
+  }
+  callback();
+}
+
+void write_ahead_log::wait_durable(std::uint64_t lsn) {
+  std::unique_lock<std::mutex> lock(mtx_);
+  durable_cv_.wait(lock, [this, lsn] { return durable_lsn_ >= lsn; });
+}
+
+void write_ahead_log::flush() {
+  std::vector<callback_type> ready;
+  flush(ready);
+  run_callbacks(ready);
+  // Records the flusher made durable first may still have callbacks running
+  log_flusher::instance()->wait_callbacks();
+}
+
+void write_ahead_log::flush(std::vector<callback_type> &ready) {
+  std::lock_guard<std::mutex> flush_lock(flush_mtx_);
+  std::string data;
+  std::uint64_t lsn;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (last_lsn_ == durable_lsn_) {
+      return;
+    }
+    data.swap(buffer_);
+    lsn = last_lsn_;
+  }
+  std::size_t written = 0;
+  bool synced = false;
+  if (fd_ < 0) {
+    fd_ = ::open(segment_path(segment_).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ >= 0) {
+      // Make the new segment's directory entry durable as well
+      int dir_fd = ::open(dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+      }
+    }
+  }
+  if (fd_ >= 0) {
+    while (written < data.size()) {
+      auto n = ::write(fd_, data.data() + written, data.size() - written);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        break;
+      }
+      written += static_cast<std::size_t>(n);
+    }
+    synced = written == data.size() && ::fdatasync(fd_) == 0;
+  }
+  if (!synced) {
+    LOG(log_level::error) << "Failed to write write-ahead log " << segment_path(segment_) << ": "
+                          << std::strerror(errno);
+    // Keep the unwritten records for the next flush; waiters stay blocked until they are durable
+    std::lock_guard<std::mutex> lock(mtx_);
+    buffer_.insert(0, data, written, std::string::npos);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    durable_lsn_ = lsn;
+    while (!waiters_.empty() && waiters_.front().first <= lsn) {
+      ready.push_back(std::move(waiters_.front().second));
+      waiters_.pop_front();
+    }
+  }
+  durable_cv_.notify_all();
+}
+
+std::uint64_t write_ahead_log::rotate() {
+  flush();
+  std::lock_guard<std::mutex> flush_lock(flush_mtx_);
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  return segment_++;
+}
+
+std::uint64_t write_ahead_log::segment() const {
+  std::lock_guard<std::mutex> flush_lock(flush_mtx_);
+  return segment_;
+}
+
+std::size_t write_ahead_log::replay(const std::function<void(const record_type &)> &apply,
+                                    std::uint64_t covered_segment) {
+  std::size_t num_records = 0;
+  for (auto s: segments(dir_, prefix_)) {
+    if (s >= first_segment_) {
+      break;
+    }
+    auto path = segment_path(s);
+    if (s <= covered_segment) {
+      // A snapshot landed before the crash cut the segment, so replaying would apply its commands twice
+      std::remove(path.c_str());
+      continue;
+    }
+    std::string data;
+    {
+      std::ifstream in(path, std::ios::binary);
+      data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::size_t offset = 0;
+    bool torn = false;
+    record_type r;
+    while (offset < data.size()) {
+      std::uint32_t header[2];
+      if (data.size() - offset < RECORD_HEADER_SIZE) {
+        torn = true;
+        break;
+      }
+      std::memcpy(header, data.data() + offset, sizeof(header));
+      auto payload = data.data() + offset + RECORD_HEADER_SIZE;
+      if (data.size() - offset - RECORD_HEADER_SIZE < header[0] || crc32c(0, payload, header[0]) != header[1]) {
+        torn = true;
+        break;
+      }
+      // A record whose checksum matches was written whole, so its fields are well formed
+      std::size_t pos = 0;
+      auto get_u32 = [&]() {
+        std::uint32_t v;
+        std::memcpy(&v, payload + pos, sizeof(v));
+        pos += sizeof(v);
+        return v;
+      };
+      r.resize(get_u32());
+      for (auto &arg: r) {
+        auto size = get_u32();
+        arg.assign(payload + pos, size);
+        pos += size;
+      }
+      apply(r);
+      ++num_records;
+      offset += RECORD_HEADER_SIZE + header[0];
+    }
+    if (torn) {
+      // Records after a torn one never completed, nor did any later segment
+      LOG(log_level::warn) << "Write-ahead log " << path << " ends with a torn record at offset " << offset
+                           << ", discarding the rest of the log";
+      if (::truncate(path.c_str(), static_cast<off_t>(offset)) != 0) {
+        throw std::runtime_error("Error in truncating " + path + ": " + std::strerror(errno));
+      }
+      for (auto later: segments(dir_, prefix_)) {
+        if (later > s && later < first_segment_) {
+          std::remove(segment_path(later).c_str());
+        }
+      }
+      break;
+    }
+  }
+  return num_records;
+}
+
+void write_ahead_log::remove() {
+  std::vector<callback_type> ready;
+  {
+    std::lock_guard<std::mutex> flush_lock(flush_mtx_);
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      // The records are held by the image that replaces the log
+      buffer_.clear();
+      durable_lsn_ = last_lsn_;
+      for (auto &w: waiters_) {
+        ready.push_back(std::move(w.second));
+      }
+      waiters_.clear();
+    }
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+    for (auto s: segments(dir_, prefix_)) {
+      std::remove(segment_path(s).c_str());
+    }
+    ++segment_;
+  }
+  durable_cv_.notify_all();
+  run_callbacks(ready);
+}
+
+void write_ahead_log::configure(const std::string &dir, std::size_t fsync_delay_us, std::size_t fsync_batch_bytes) {
+  std::lock_guard<std::mutex> lock(config_mtx);
+  config_dir = dir;
+  config_fsync_delay_us = fsync_delay_us;
+  config_fsync_batch_bytes = fsync_batch_bytes;
+}
+
+void write_ahead_log::truncate(const std::string &dir, const std::string &name, std::uint64_t segment) {
+  auto prefix = escape_name(name) + WAL_SUFFIX;
+  for (auto s: segments(dir, prefix)) {
+    if (s <= segment) {
+      std::remove((dir + "/" + prefix + std::to_string(s)).c_str());
+    }
+  }
+}
+
+std::string write_ahead_log::directory() {
+  std::lock_guard<std::mutex> lock(config_mtx);
+  return config_dir;
+}
+
+std::string write_ahead_log::segment_path(std::uint64_t segment) const {
+  return dir_ + "/" + prefix_ + std::to_string(segment);
+}
+
+std::vector<std::uint64_t> write_ahead_log::segments(const std::string &dir_path, const std::string &prefix) {
+  std::vector<std::uint64_t> out;
+  auto dir = ::opendir(dir_path.c_str());
+  if (dir == nullptr) {
+    return out;
+  }
+  while (auto entry = ::readdir(dir)) {
+    std::string file_name = entry->d_name;
+    if (file_name.size() > prefix.size() && file_name.compare(0, prefix.size(), prefix) == 0
+        && std::all_of(file_name.begin() + prefix.size(), file_name.end(), [](char c) {
+          return std::isdigit(static_cast<unsigned char>(c));
+        })) {
+      out.push_back(std::stoull(file_name.substr(prefix.size())));
+    }
+  }
+  ::closedir(dir);
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+}
+}
@@ -0,0 +1,188 @@
+#ifndef JIFFY_WRITE_AHEAD_LOG_H
+#define JIFFY_WRITE_AHEAD_LOG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jiffy {
+namespace persistent {
+
+/**
+ * @brief Write-ahead log of the mutator commands of one partition, on local disk.
+ *
+ * Records are appended to an in-memory buffer and written with a single write and fdatasync by a
+ * process-wide flusher thread, which commits every record appended while the previous sync ran as one
+ * group. Each record carries its size and CRC32C, so replay stops cleanly at a record torn by a crash.
+ * The log is split into numbered segment files: a snapshot of the partition rotates the log to a new
+ * segment, and once the snapshot lands the segments it covers are removed.
+ */
+class write_ahead_log {
+ public:
+  /* Logged command */
+  typedef std::vector<std::string> record_type;
+  /* Called once a record is durable */
+  typedef std::function<void()> callback_type;
+
+  /**
+   * @brief Constructor, the log keeps the segments left by a previous instance until they are replayed
+   * and truncated
+   * @param dir Directory of the segment files
+   * @param name Log name, e.g. the partition's file path and name
+   * @param min_segment Lowest number of the segments this instance writes, so that they stay above the
+   * segments a snapshot already holds
+   */
+  write_ahead_log(const std::string &dir, const std::string &name, std::uint64_t min_segment = 1);
+
+  /**
+   * @brief Destructor, makes the appended records durable
+   */
+  ~write_ahead_log();
+
+  write_ahead_log(const write_ahead_log &) = delete;
+  write_ahead_log &operator=(const write_ahead_log &) = delete;
+
+  /**
+   * @brief Fetch the log name
+   * @return Log name
+   */
+  const std::string &name() const;
+
+  /**
+   * @brief Append a record, durable once the flusher commits it
+   * @param r Record
+   * @return Log sequence number of the record
+   */
+  std::uint64_t append(const record_type &r);
+
+  /**
+   * @brief Run a callback once a record is durable, on the calling thread if it already is and on the
+   * flusher thread otherwise; callbacks run without the flusher's locks held, but must not destroy a log
+   * @param lsn Log sequence number
+   * @param callback Callback
+   */
+  void when_durable(std::uint64_t lsn, callback_type callback);
+
+  /**
+   * @brief Wait for a record to be durable
+   * @param lsn Log sequence number
+   */
+  void wait_durable(std::uint64_t lsn);
+
+  /**
+   * @brief Write and sync the appended records, returning once the callbacks of all durable records ran;
+   * must not be called from a callback
+   */
+  void flush();
+
+  /**
+   * @brief Write and sync the appended records
+   * @param ready Receives the callbacks of the records made durable, for the caller to run
+   */
+  void flush(std::vector<callback_type> &ready);
+
+  /**
+   * @brief Seal the current segment, so that later records go to a new one; no record may be appended
+   * concurrently
+   * @return Number of the sealed segment
+   */
+  std::uint64_t rotate();
+
+  /**
+   * @brief Fetch the number of the current segment, the one the next rotate() seals
+   * @return Segment number
+   */
+  std::uint64_t segment() const;
+
+  /**
+   * @brief Replay the records of the segments left by a previous instance, in order; a torn record
+   * ends the replay and is cut from its segment
+   * @param apply Called with each record
+   * @param covered_segment Last segment whose records a snapshot already holds; it and earlier segments
+   * are removed instead of replayed
+   * @return Number of records replayed
+   */
+  std::size_t replay(const std::function<void(const record_type &)> &apply, std::uint64_t covered_segment = 0);
+
+  /**
+   * @brief Remove all segments, e.g. once the partition was dumped
+   */
+  void remove();
+
+  /**
+   * @brief Configure the log directory and the flusher, before the first log is created
+   * @param dir Directory of the segment files
+   * @param fsync_delay_us Microseconds the flusher waits for more records before syncing, 0 to sync
+   * as soon as the previous sync completes
+   * @param fsync_batch_bytes Number of appended bytes that ends the wait early
+   */
+  static void configure(const std::string &dir, std::size_t fsync_delay_us, std::size_t fsync_batch_bytes);
+
+  /**
+   * @brief Remove sealed segments of a log, once a snapshot holds their records; does not need the log
+   * to be open, so that snapshot jobs outliving the partition can call it
+   * @param dir Directory of the segment files
+   * @param name Log name
+   * @param segment Number of the last segment to remove
+   */
+  static void truncate(const std::string &dir, const std::string &name, std::uint64_t segment);
+
+  /**
+   * @brief Fetch the configured log directory
+   * @return Log directory
+   */
+  static std::string directory();
+
+ private:
+  /**
+   * @brief Fetch the path of a segment file
+   * @param segment Segment number
+   * @return Segment file path
+   */
+  std::string segment_path(std::uint64_t segment) const;
+
+  /**
+   * @brief List the segment files of a log
+   * @param dir Directory of the segment files
+   * @param prefix Segment file name prefix
+   * @return Segment numbers, in increasing order
+   */
+  static std::vector<std::uint64_t> segments(const std::string &dir, const std::string &prefix);
+
+  /* Directory of the segment files */
+  std::string dir_;
+  /* Log name */
+  std::string name_;
+  /* Segment file name prefix, the escaped log name */
+  std::string prefix_;
+  /* Mutex guarding the buffer, sequence numbers and waiters */
+  std::mutex mtx_;
+  /* Signalled when records become durable */
+  std::condition_variable durable_cv_;
+  /* Records appended but not written yet */
+  std::string buffer_;
+  /* Sequence number of the latest record */
+  std::uint64_t last_lsn_;
+  /* Sequence number of the latest durable record */
+  std::uint64_t durable_lsn_;
+  /* Callbacks waiting for records to be durable, in sequence number order */
+  std::deque<std::pair<std::uint64_t, callback_type>> waiters_;
+  /* Mutex serializing flushes, guards the segment file */
+  mutable std::mutex flush_mtx_;
+  /* Current segment file descriptor, -1 until the segment is created */
+  int fd_;
+  /* Current segment number */
+  std::uint64_t segment_;
+  /* First segment of this instance; earlier ones were left by a previous instance */
+  std::uint64_t first_segment_;
+};
+
+}
+}
+
+#endif //JIFFY_WRITE_AHEAD_LOG_H
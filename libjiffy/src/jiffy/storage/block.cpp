@@ -1,6 +1,7 @@
 #include "block.h"
 #include "partition_manager.h"
 #include "jiffy/utils/logger.h"
+#include "jiffy/utils/numa_utils.h"
 #include <iostream>
 
 namespace jiffy {
@@ -13,9 +14,12 @@ block::block(const std::string &id,
              const std::string memory_mode,
              void* mem_kind,
              const std::string &auto_scaling_host,
-             const int auto_scaling_port)
+             const int auto_scaling_port,
+             const std::string &allocator,
+             const std::string &huge_pages,
+             int numa_node)
     : id_(id),
-      manager_(capacity, memory_mode, mem_kind),
+      manager_(capacity, memory_mode, mem_kind, allocator, huge_pages, numa_node),
       impl_(partition_manager::build_partition(&manager_,
                                                "default",
                                                "local://tmp",
@@ -42,11 +46,17 @@ std::shared_ptr<chain_module> block::impl() {
   return impl_;
 }
 
+int block::numa_node() const {
+  return manager_.mb_numa_node();
+}
+
 void block::setup(const std::string &type,
                   const std::string &backing_path,
                   const std::string &name,
                   const std::string &metadata,
                   const utils::property_map &conf) {
+  // Partitions are set up by the management server, whose thread is not on the node of the block
+  numa_node_scope scope(manager_.mb_numa_node());
   impl_ = partition_manager::build_partition(&manager_,
                                              type,
                                              backing_path,
@@ -61,7 +71,10 @@ void block::setup(const std::string &type,
 }
 
 void block::destroy() {
-  LOG(log_level::info) << "Destroying partition " << impl_->name() << " on block " << id_;
+  auto stats = manager_.mb_stats();
+  LOG(log_level::info) << "Destroying partition " << impl_->name() << " on block " << id_ << " (used: "
+                       << stats.used << ", active: " << stats.active << ", dirty: " << stats.dirty
+                       << ", fragmentation: " << stats.fragmentation() << ")";
   std::string type = "default";
   std::string backing_path = "local://tmp";
   std::string name = "default";
@@ -69,7 +82,18 @@ void block::destroy() {
   std::string auto_scaling_host_ = "default";
   int auto_scaling_port_ = 0;
   utils::property_map conf;
+  std::weak_ptr<chain_module> old_impl = impl_;
+  // If the partition goes away with this reference, its objects are returned by the release at once
+  bool last_reference = impl_.use_count() == 1;
+  if (last_reference) {
+    manager_.mb_begin_release();
+  }
   impl_.reset();
+  if (old_impl.expired()) {
+    manager_.mb_release();
+  } else if (last_reference) {
+    manager_.mb_cancel_release();
+  }
   impl_ = partition_manager::build_partition(&manager_,
                                              type,
                                              backing_path,
@@ -91,6 +115,10 @@ size_t block::used() const {
   return manager_.mb_used();
 }
 
+block_memory_stats block::memory_stats() const {
+  return manager_.mb_stats();
+}
+
 block::operator bool() const noexcept {
   return impl_ != nullptr;
 }
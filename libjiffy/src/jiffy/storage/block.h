@@ -18,13 +18,19 @@ class block {
    * @param capacity The block memory capacity.
    * @param directory_host The directory host.
    * @param directory_port The directory port.
+   * @param allocator The block memory allocator, default, slab or arena.
+   * @param huge_pages Huge pages backing contiguous partition regions, none, transparent or explicit.
+   * @param numa_node NUMA node preferred for the mapped regions and dedicated arena of the block, -1 for no preference.
    */
   explicit block(const std::string &id,
         const size_t capacity = 134217728,
         const std::string memory_mode = "DRAM",
         void* mem_kind = nullptr,
         const std::string &auto_scaling_host = "127.0.0.1",
-        const int auto_scaling_port = 9095);
+        const int auto_scaling_port = 9095,
+        const std::string &allocator = "default",
+        const std::string &huge_pages = "none",
+        int numa_node = -1);
 
   /**
    * @brief Get memory block identifier.
@@ -44,8 +50,15 @@ class block {
    */
   explicit operator bool() const noexcept;
 
+  /**
+   * @brief Get the NUMA node preferred for the memory of the block.
+   * @return NUMA node, -1 for no preference.
+   */
+  int numa_node() const;
+
   /**
    * @brief Set the underlying partition implementation.
+   * Memory the partition allocates while it is built is taken from the NUMA node of the block.
    * @param type The type of the partition.
    * @param conf Configuration parameters for constructing the partition.
    */
@@ -57,6 +70,8 @@ class block {
 
   /**
    * @brief Destroy the underlying implementation.
+   * Slab chunks or the arena of the block are released at once if no one else references the
+   * implementation; the objects of the partition are then not freed one by one.
    */
   void destroy();
 
@@ -72,6 +87,12 @@ class block {
    */
   size_t used() const;
 
+  /**
+   * @brief Get the memory usage of the block, including the fragmentation of its arena.
+   * @return Memory usage.
+   */
+  block_memory_stats memory_stats() const;
+
   /**
    * @brief Checks if the block stores a non-null implementation.
    * @return True if the block stores a non-null implementation, false otherwise.
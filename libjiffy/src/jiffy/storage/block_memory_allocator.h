@@ -96,7 +96,12 @@ class block_memory_allocator {
   void deallocate(pointer p, size_type size) {
     if (p == nullptr)
       return;
-    manager_->mb_free(p, size);
+    manager_->mb_free(p, size * sizeof(T));
+  }
+
+  // return the block memory manager
+  block_memory_manager *manager() const {
+    return manager_;
   }
 
   template<typename U>
@@ -4,18 +4,192 @@
   #include <jemalloc/jemalloc.h>
 #endif
 #include <new>
+#include <stdexcept>
+#include <sys/mman.h>
 #include "block_memory_manager.h"
 #include "jiffy/utils/logger.h"
+#include "jiffy/utils/numa_utils.h"
 using namespace jiffy::utils;
 
 namespace jiffy {
 namespace storage {
 
-block_memory_manager::block_memory_manager(size_t capacity, const std::string memory_mode, void* mem_kind)
-    : capacity_(capacity), used_(0), memory_mode_(memory_mode), mem_kind_(mem_kind) {}
+#ifndef MEMKIND_IN_USE
+/**
+ * @brief Read a size statistic of an arena
+ * @param arena Arena index
+ * @param name Statistic name
+ * @return Statistic value, 0 if the heap manager does not collect it
+ */
+static size_t arena_stat(unsigned arena, const std::string &name) {
+  size_t value = 0;
+  size_t len = sizeof(value);
+  auto key = "stats.arenas." + std::to_string(arena) + "." + name;
+  if (mallctl(key.c_str(), &value, &len, nullptr, 0) != 0) {
+    return 0;
+  }
+  return value;
+}
+
+/* Extent hooks of the heap manager, wrapped by the hooks of arenas bound to a NUMA node */
+static extent_hooks_t *default_extent_hooks = nullptr;
+/* Extent hooks binding the extents of an arena to its NUMA node */
+static extent_hooks_t numa_extent_hooks;
+/* Mutex guarding the NUMA nodes of arenas */
+static std::mutex arena_nodes_mtx;
+/* NUMA nodes of the arenas bound to one, keyed by arena index */
+static std::unordered_map<unsigned, int> arena_nodes;
+
+/**
+ * @brief Allocate an extent with the default hooks and prefer the NUMA node of its arena for it
+ * Pages of an extent the arena already faulted in stay where they are
+ */
+static void *numa_extent_alloc(extent_hooks_t *, void *new_addr, size_t size, size_t alignment, bool *zero,
+                               bool *commit, unsigned arena_ind) {
+  auto ptr = default_extent_hooks->alloc(default_extent_hooks, new_addr, size, alignment, zero, commit, arena_ind);
+  if (ptr == nullptr) {
+    return nullptr;
+  }
+  int node = -1;
+  {
+    std::lock_guard<std::mutex> lock(arena_nodes_mtx);
+    auto it = arena_nodes.find(arena_ind);
+    if (it != arena_nodes.end()) {
+      node = it->second;
+    }
+  }
+  if (node >= 0) {
+    numa_utils::bind_memory(ptr, size, node);
+  }
+  return ptr;
+}
+
+/**
+ * @brief Bind the extents an arena allocates from now on to a NUMA node
+ * @param arena Arena index
+ * @param node Node identifier
+ * @return Bool value, true if the arena is bound
+ */
+static bool bind_arena(unsigned arena, int node) {
+  auto key = "arena." + std::to_string(arena) + ".extent_hooks";
+  static std::once_flag init;
+  std::call_once(init, [&key] {
+    size_t len = sizeof(default_extent_hooks);
+    if (mallctl(key.c_str(), &default_extent_hooks, &len, nullptr, 0) == 0 && default_extent_hooks != nullptr) {
+      numa_extent_hooks = *default_extent_hooks;
+      numa_extent_hooks.alloc = numa_extent_alloc;
+    }
+  });
+  if (default_extent_hooks == nullptr) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(arena_nodes_mtx);
+    arena_nodes[arena] = node;
+  }
+  auto hooks = &numa_extent_hooks;
+  if (mallctl(key.c_str(), nullptr, nullptr, &hooks, sizeof(hooks)) != 0) {
+    std::lock_guard<std::mutex> lock(arena_nodes_mtx);
+    arena_nodes.erase(arena);
+    return false;
+  }
+  return true;
+}
+#endif
+
+block_memory_manager::block_memory_manager(size_t capacity,
+                                           const std::string memory_mode,
+                                           void* mem_kind,
+                                           const std::string &allocator,
+                                           const std::string &huge_pages,
+                                           int numa_node)
+    : capacity_(capacity),
+      used_(0),
+      memory_mode_(memory_mode),
+      mem_kind_(mem_kind),
+      arena_(0),
+      arena_flags_(0),
+      releasing_(false),
+      huge_pages_(huge_pages),
+      num_huge_regions_(0),
+      numa_node_(numa_node) {
+  if (huge_pages != "none" && huge_pages != "transparent" && huge_pages != "explicit") {
+    throw std::invalid_argument("No such huge pages mode " + huge_pages);
+  }
+  if (memory_mode_ != "DRAM") {
+    huge_pages_ = "none";
+  }
+  if (allocator == "slab") {
+    slab_.reset(new slab_allocator(memory_mode, mem_kind));
+  } else if (allocator == "arena") {
+  #ifdef MEMKIND_IN_USE
+    LOG(log_level::warn) << "Dedicated arenas are not supported with memkind, using the default allocator";
+  #else
+    size_t len = sizeof(arena_);
+    if (mallctl("arenas.create", &arena_, &len, nullptr, 0) != 0) {
+      throw std::runtime_error("Could not create arena for memory block");
+    }
+    // Thread caches would hand objects of one block to another
+    arena_flags_ = MALLOCX_ARENA(arena_) | MALLOCX_TCACHE_NONE;
+    if (numa_node_ >= 0 && !bind_arena(arena_, numa_node_)) {
+      LOG(log_level::warn) << "Could not bind arena of memory block to NUMA node " << numa_node_;
+    }
+  #endif
+  }
+}
+
+block_memory_manager::~block_memory_manager() {
+  for (const auto &region: huge_regions_) {
+    munmap(region.first, region.second.first);
+  }
+  #ifndef MEMKIND_IN_USE
+    if (arena_flags_ != 0) {
+      auto key = "arena." + std::to_string(arena_) + ".destroy";
+      mallctl(key.c_str(), nullptr, nullptr, nullptr, 0);
+      std::lock_guard<std::mutex> lock(arena_nodes_mtx);
+      arena_nodes.erase(arena_);
+    }
+  #endif
+}
 
 void *block_memory_manager::mb_malloc(size_t size) {
-  if (used_.load() > capacity_) {
+  if (size >= HUGE_PAGE_SIZE && huge_pages_ != "none") {
+    if (!mb_reserve(size)) {
+      return nullptr;
+    }
+    auto ptr = map_huge(size);
+    if (ptr == nullptr) {
+      used_ -= size;
+    }
+    return ptr;
+  }
+  #ifndef MEMKIND_IN_USE
+    if (arena_flags_ != 0) {
+      // Accounts for the size class, which is what mb_free returns
+      auto usable = nallocx(size, arena_flags_);
+      if (usable == 0 || !mb_reserve(usable)) {
+        return nullptr;
+      }
+      auto ptr = mallocx(size, arena_flags_);
+      if (ptr == nullptr) {
+        used_ -= usable;
+      }
+      return ptr;
+    }
+  #endif
+  if (slab_ && size <= slab_allocator::MAX_SLAB_SIZE) {
+    // Accounts for the size class, which is what mb_free returns
+    auto class_size = slab_allocator::class_size(slab_allocator::size_class(size));
+    if (!mb_reserve(class_size)) {
+      return nullptr;
+    }
+    auto ptr = slab_->allocate(size);
+    if (ptr == nullptr) {
+      used_ -= class_size;
+    }
+    return ptr;
+  }
+  if (!mb_reserve(size)) {
     return nullptr;
   }
   #ifdef MEMKIND_IN_USE
@@ -25,26 +199,68 @@ void *block_memory_manager::mb_malloc(size_t size) {
     auto ptr = memkind_malloc((struct memkind*)mem_kind_, size);
   #else
     auto ptr = mallocx(size, 0);
-  #endif 
-  used_ += size;
+  #endif
+  if (ptr == nullptr) {
+    used_ -= size;
+  }
   return ptr;
 }
 
 void block_memory_manager::mb_free(void *ptr) {
+  auto huge_size = unmap_huge(ptr);
+  if (huge_size != 0) {
+    used_ -= huge_size;
+    return;
+  }
+  if (slab_) {
+    auto size = slab_->allocation_size(ptr);
+    if (size != 0) {
+      if (!releasing_.load(std::memory_order_acquire)) {
+        slab_->deallocate(ptr, size);
+      }
+      used_ -= size;
+      return;
+    }
+  }
   #ifdef MEMKIND_IN_USE
     auto size = memkind_malloc_usable_size((struct memkind*)mem_kind_, ptr);
     memkind_free((struct memkind*)mem_kind_, ptr);
-  #else 
+  #else
     auto size = sallocx(ptr, 0);
-    free(ptr);
+    if (arena_flags_ != 0 && releasing_.load(std::memory_order_acquire)) {
+      // Resetting the arena frees the object, without taking the arena lock for it
+    } else if (arena_flags_ != 0) {
+      dallocx(ptr, arena_flags_);
+    } else {
+      free(ptr);
+    }
   #endif
   used_ -= size;
 }
 
 void block_memory_manager::mb_free(void *ptr, size_t size) {
+  if (size >= HUGE_PAGE_SIZE && unmap_huge(ptr) != 0) {
+    used_ -= size;
+    return;
+  }
+  if (slab_ && size <= slab_allocator::MAX_SLAB_SIZE) {
+    // Releasing the chunks frees the object, without going through the thread cache
+    if (!releasing_.load(std::memory_order_acquire)) {
+      slab_->deallocate(ptr, size);
+    }
+    used_ -= slab_allocator::class_size(slab_allocator::size_class(size));
+    return;
+  }
   #ifdef MEMKIND_IN_USE
     memkind_free((struct memkind*)mem_kind_, ptr);
   #else
+    if (arena_flags_ != 0) {
+      if (!releasing_.load(std::memory_order_acquire)) {
+        sdallocx(ptr, size, arena_flags_);
+      }
+      used_ -= nallocx(size, arena_flags_);
+      return;
+    }
     free(ptr);
   #endif
   used_ -= size;
@@ -58,5 +274,157 @@ size_t block_memory_manager::mb_used() const {
   return used_.load();
 }
 
+void block_memory_manager::mb_release() {
+  if (slab_) {
+    slab_->release();
+  }
+  #ifndef MEMKIND_IN_USE
+    if (arena_flags_ != 0) {
+      // Discards every allocation of the arena and returns its pages in one call
+      auto key = "arena." + std::to_string(arena_) + ".reset";
+      if (mallctl(key.c_str(), nullptr, nullptr, nullptr, 0) != 0) {
+        LOG(log_level::warn) << "Could not reset arena " << arena_;
+        releasing_ = false;
+        return;
+      }
+      used_ = 0;
+    }
+  #endif
+  releasing_ = false;
+}
+
+void block_memory_manager::mb_begin_release() {
+  releasing_ = true;
+}
+
+void block_memory_manager::mb_cancel_release() {
+  releasing_ = false;
+}
+
+int block_memory_manager::mb_numa_node() const {
+  return numa_node_;
+}
+
+size_t block_memory_manager::mb_reserved() const {
+  return slab_ ? slab_->reserved() : 0;
+}
+
+block_memory_stats block_memory_manager::mb_stats() const {
+  block_memory_stats stats;
+  stats.used = used_.load();
+  stats.active = stats.used;
+  #ifndef MEMKIND_IN_USE
+    bool enabled = false;
+    size_t len = sizeof(enabled);
+    if (arena_flags_ != 0 && mallctl("config.stats", &enabled, &len, nullptr, 0) == 0 && enabled) {
+      // Statistics are snapshots, refreshed by advancing the epoch
+      uint64_t epoch = 1;
+      len = sizeof(epoch);
+      mallctl("epoch", &epoch, &len, &epoch, len);
+      size_t page = 0;
+      len = sizeof(page);
+      mallctl("arenas.page", &page, &len, nullptr, 0);
+      stats.active = arena_stat(arena_, "pactive") * page;
+      stats.dirty = arena_stat(arena_, "pdirty") * page;
+      stats.resident = arena_stat(arena_, "resident");
+    }
+  #endif
+  return stats;
+}
+
+bool block_memory_manager::mb_reserve(size_t size) {
+  auto used = used_.fetch_add(size);
+  if (used > capacity_ || size > capacity_ - used) {
+    used_ -= size;
+    return false;
+  }
+  return true;
+}
+
+void block_memory_manager::mb_unreserve(size_t size) {
+  used_ -= size;
+}
+
+void *block_memory_manager::mb_map(size_t size) {
+  if (memory_mode_ != "DRAM") {
+    return nullptr;
+  }
+  return map_region((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE, true);
+}
+
+void block_memory_manager::mb_unmap(void *ptr, size_t size) {
+  munmap(ptr, (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+}
+
+void *block_memory_manager::map_region(size_t len, bool lazy) {
+  if (huge_pages_ == "explicit") {
+    // Huge page mappings always reserve their pages from the pool, faulting them in lazily
+    auto ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      bind_region(ptr, len);
+      return ptr;
+    }
+    LOG(log_level::warn) << "Could not map " << len << " bytes of huge pages, using transparent huge pages";
+  }
+  // Over-allocate by one huge page and trim, so that the kernel can back the whole region with huge pages
+  auto flags = MAP_PRIVATE | MAP_ANONYMOUS | (lazy ? MAP_NORESERVE : 0);
+  auto raw = mmap(nullptr, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+  auto addr = reinterpret_cast<uintptr_t>(raw);
+  auto aligned = (addr + HUGE_PAGE_SIZE - 1) & ~(static_cast<uintptr_t>(HUGE_PAGE_SIZE) - 1);
+  if (aligned != addr) {
+    munmap(raw, aligned - addr);
+  }
+  munmap(reinterpret_cast<void *>(aligned + len), HUGE_PAGE_SIZE - (aligned - addr));
+  auto ptr = reinterpret_cast<void *>(aligned);
+  if (huge_pages_ != "none") {
+    madvise(ptr, len, MADV_HUGEPAGE);
+  }
+  bind_region(ptr, len);
+  return ptr;
+}
+
+void block_memory_manager::bind_region(void *ptr, size_t len) {
+  // Pages are placed when first touched, so the policy must be set before the region is written
+  if (numa_node_ >= 0 && numa_utils::bind_memory(ptr, len, numa_node_) != 0) {
+    LOG(log_level::warn) << "Could not bind memory block region to NUMA node " << numa_node_;
+  }
+}
+
+void *block_memory_manager::map_huge(size_t size) {
+  auto len = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  auto ptr = map_region(len, false);
+  if (ptr == nullptr) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(huge_mtx_);
+  huge_regions_.emplace(ptr, std::make_pair(len, size));
+  num_huge_regions_.fetch_add(1, std::memory_order_release);
+  return ptr;
+}
+
+size_t block_memory_manager::unmap_huge(void *ptr) {
+  // A region is mapped before it can be freed, so nothing freed while none is mapped is one
+  if (num_huge_regions_.load(std::memory_order_acquire) == 0
+      || reinterpret_cast<uintptr_t>(ptr) % HUGE_PAGE_SIZE != 0) {
+    return 0;
+  }
+  std::pair<size_t, size_t> region;
+  {
+    std::lock_guard<std::mutex> lock(huge_mtx_);
+    auto it = huge_regions_.find(ptr);
+    if (it == huge_regions_.end()) {
+      return 0;
+    }
+    region = it->second;
+    huge_regions_.erase(it);
+    num_huge_regions_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  munmap(ptr, region.first);
+  return region.second;
+}
+
+}
 }
-}
\ No newline at end of file
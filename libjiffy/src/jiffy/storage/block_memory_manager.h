@@ -4,8 +4,12 @@
 #include <cstdint>
 #include <cstddef>
 #include <atomic>
+#include <memory>
 #include <new>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include "slab_allocator.h"
 
 namespace jiffy {
 namespace storage {
@@ -14,28 +18,80 @@ struct memory_block_overflow : std::bad_alloc {
   using std::bad_alloc::bad_alloc;
 };
 
+/**
+ * @brief Memory usage of a block.
+ * Only blocks with a dedicated arena track the pages behind their allocations; for other blocks the
+ * active bytes equal the used bytes and the page counts are 0.
+ */
+struct block_memory_stats {
+  /* Bytes allocated to the block */
+  size_t used{0};
+  /* Bytes of the pages holding allocations, including free space between them */
+  size_t active{0};
+  /* Bytes of unused pages kept by the arena for reuse */
+  size_t dirty{0};
+  /* Bytes of physically resident pages of the arena */
+  size_t resident{0};
+
+  /**
+   * @brief Get the fraction of active memory that holds no allocation.
+   * @return Fragmentation, between 0 and 1.
+   */
+  double fragmentation() const {
+    return active > used ? static_cast<double>(active - used) / active : 0.0;
+  }
+};
+
 /**
  * @brief Memory allocator that tracks size internally.
  */
 class block_memory_manager {
  public:
+  /* Huge page size, allocations of at least this size are backed by huge pages if enabled */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
   /**
    * @brief Constructor.
    * @param capacity Maximum capacity of block.
+   * @param memory_mode Memory mode, DRAM or PMEM.
+   * @param mem_kind Memory kind.
+   * @param allocator Allocator, "slab" serves small allocations from size-class slabs owned by the block,
+   * "arena" allocates every object from a heap manager arena dedicated to the block, anything else
+   * allocates every object from the shared heap manager arenas.
+   * @param huge_pages Huge pages backing large contiguous regions in DRAM, "transparent" to map them
+   * with transparent huge pages, "explicit" to map them from the reserved huge page pool, falling back to
+   * transparent huge pages if the pool is exhausted, "none" to allocate them from the allocator.
+   * @param numa_node NUMA node preferred for the mapped regions and the dedicated arena of the block, -1 for
+   * no preference. Objects of the shared heap manager arenas, which also back the slabs, are placed by the
+   * thread that first touches them.
    */
   explicit block_memory_manager(size_t capacity = 134217728,
                                 const std::string memory_mode = "DRAM",
-                                void* mem_kind = nullptr);
+                                void* mem_kind = nullptr,
+                                const std::string &allocator = "default",
+                                const std::string &huge_pages = "none",
+                                int numa_node = -1);
+
+  /**
+   * @brief Destructor, destroys the arena and unmaps the huge page regions of the block.
+   */
+  ~block_memory_manager();
+
+  block_memory_manager(const block_memory_manager &) = delete;
+  block_memory_manager &operator=(const block_memory_manager &) = delete;
 
   /**
    * @brief Allocate memory.
+   * The bytes are reserved against the capacity before allocating, so concurrent allocations never
+   * exceed the capacity together.
    * @param size Number of bytes to allocate.
-   * @return Pointer to allocated memory, returns null if allocation fails.
+   * @return Pointer to allocated memory, returns null if allocation fails or the capacity is reached.
    */
   void *mb_malloc(size_t size);
 
   /**
    * @brief Free memory.
+   * Objects served from slabs are accounted with the size of their size class.
    * @param ptr Pointer to memory allocation.
    */
   void mb_free(void *ptr);
@@ -59,6 +115,74 @@ class block_memory_manager {
    */
   size_t mb_used() const;
 
+  /**
+   * @brief Release all slab chunks or the arena of the memory block at once.
+   * Must only be called when no data structure references memory of the block any more.
+   */
+  void mb_release();
+
+  /**
+   * @brief Mark the memory block for release, e.g. before destroying the data structures in it.
+   * Until mb_release or mb_cancel_release, frees of objects that the release returns at once are only
+   * accounted, instead of handing each object back to the heap manager.
+   */
+  void mb_begin_release();
+
+  /**
+   * @brief Clear the release mark if the block is not released after all.
+   * Objects freed while marked stay allocated until the next release.
+   */
+  void mb_cancel_release();
+
+  /**
+   * @brief Get number of bytes held in slab chunks, including free objects.
+   * @return Number of bytes held in slab chunks, 0 if slabs are not in use.
+   */
+  size_t mb_reserved() const;
+
+  /**
+   * @brief Account bytes against the capacity without allocating them, e.g. for memory mapped with
+   * mb_map once it is committed.
+   * Reservations are atomic, so concurrent reservations never exceed the capacity together.
+   * @param size Number of bytes.
+   * @return True if reserved, false if the capacity would be exceeded.
+   */
+  bool mb_reserve(size_t size);
+
+  /**
+   * @brief Return bytes reserved with mb_reserve.
+   * @param size Number of bytes.
+   */
+  void mb_unreserve(size_t size);
+
+  /**
+   * @brief Reserve address space for a region whose pages are only backed by memory once touched.
+   * The region is aligned to HUGE_PAGE_SIZE and backed by huge pages if enabled; it is not accounted
+   * against the capacity, callers account the parts they commit with mb_reserve.
+   * @param size Number of bytes.
+   * @return Pointer to the region, null if the memory mode cannot map regions or the mapping failed.
+   */
+  void *mb_map(size_t size);
+
+  /**
+   * @brief Unmap a region reserved with mb_map.
+   * @param ptr Pointer to the region.
+   * @param size Number of bytes passed to mb_map.
+   */
+  void mb_unmap(void *ptr, size_t size);
+
+  /**
+   * @brief Get the NUMA node preferred for the memory of the block.
+   * @return NUMA node, -1 for no preference.
+   */
+  int mb_numa_node() const;
+
+  /**
+   * @brief Get memory usage of the memory block, including the fragmentation of its arena.
+   * @return Memory usage.
+   */
+  block_memory_stats mb_stats() const;
+
   /**
    * @brief Check if two block memory managers are the same.
    * @param other Instance of other block memory manager.
@@ -78,10 +202,57 @@ class block_memory_manager {
   }
 
  private:
+  /**
+   * @brief Map a region aligned to HUGE_PAGE_SIZE, backed by huge pages if enabled.
+   * @param len Number of bytes, a multiple of HUGE_PAGE_SIZE.
+   * @param lazy True to not reserve swap space for the region, since only parts of it will be touched.
+   * @return Pointer to the region, null if it could not be mapped.
+   */
+  void *map_region(size_t len, bool lazy);
+
+  /**
+   * @brief Prefer the NUMA node of the block for a mapped region, if the block has one.
+   * @param ptr Pointer to the region.
+   * @param len Number of bytes.
+   */
+  void bind_region(void *ptr, size_t len);
+
+  /**
+   * @brief Map a region backed by huge pages.
+   * @param size Number of bytes.
+   * @return Pointer to the region, null if it could not be mapped.
+   */
+  void *map_huge(size_t size);
+
+  /**
+   * @brief Unmap a region backed by huge pages, if ptr is one.
+   * Takes no lock if no region is mapped or ptr is not huge page aligned, as regions always are.
+   * @param ptr Pointer to memory allocation.
+   * @return Number of bytes allocated for the region, 0 if ptr is not a huge page region.
+   */
+  size_t unmap_huge(void *ptr);
+
   size_t capacity_;
   std::atomic<size_t> used_;
   std::string memory_mode_;
   void* mem_kind_;
+  std::unique_ptr<slab_allocator> slab_;
+  /* Dedicated arena index */
+  unsigned arena_;
+  /* Heap manager flags selecting the dedicated arena, 0 if the block has none */
+  int arena_flags_;
+  /* Marked for release, frees of objects returned by the release are skipped */
+  std::atomic<bool> releasing_;
+  /* Huge pages mode */
+  std::string huge_pages_;
+  /* Mutex guarding the huge page regions */
+  std::mutex huge_mtx_;
+  /* Huge page regions, mapped size and allocated size keyed by address */
+  std::unordered_map<void *, std::pair<size_t, size_t>> huge_regions_;
+  /* Number of huge page regions, frees skip the mutex while there are none */
+  std::atomic<size_t> num_huge_regions_;
+  /* Preferred NUMA node, -1 for no preference */
+  int numa_node_;
 };
 
 }
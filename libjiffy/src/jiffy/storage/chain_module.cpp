@@ -18,6 +18,8 @@ chain_module::chain_module(block_memory_manager *manager,
       pending_(0) {}
 
 chain_module::~chain_module() {
+  // Durable callbacks respond through the chain module
+  close_log();
   next_->reset("nil");
   if (response_processor_.joinable())
     response_processor_.join();
@@ -79,13 +81,41 @@ void chain_module::request(sequence_id seq, const arg_list &args) {
     return;
   }
 
-  std::vector<std::string> result;
-  run_command(result, args);
+  // The response may borrow partition memory until it is sent
+  borrow_guard borrow(*this);
+  response_view result;
+  std::uint64_t lsn;
+  {
+    // Waits while a snapshot captures the partition
+    command_guard guard(*this);
+    // Commands waiting for disk I/O respond from the I/O engine once it completes; only the tail does
+    // this, since forwarding down the chain has to happen on this thread
+    if (is_tail() && run_command_async(args, [this, seq, args](const response &result) {
+      clients().respond_client(seq, result);
+      subscriptions().notify(args.front(), args[1]); // TODO: Fix
+      add_pending(seq, args);
+    })) {
+      return;
+    }
+    run_command_view(result, args);
+    lsn = take_log_lsn();
+    if (lsn != 0) {
+      // Responds once the command is durable in the write-ahead log; registered before the guard is
+      // released, since a snapshot may rotate the log
+      result.own();
+      when_logged(lsn, [this, seq, result, args] {
+        clients().respond_client(seq, result);
+        subscriptions().notify(args.front(), args[1]); // TODO: Fix
+      });
+    }
+  }
 
   auto cmd_name = args.front();
   if (is_tail()) {
-    clients().respond_client(seq, result);
-    subscriptions().notify(cmd_name, args[1]); // TODO: Fix
+    if (lsn == 0) {
+      clients().respond_client(seq, result);
+      subscriptions().notify(cmd_name, args[1]); // TODO: Fix
+    }
   } else {
     if (is_accessor(cmd_name)) {
       LOG(log_level::error) << "Invalid state: Accessor request on non-tail node";
@@ -108,12 +138,28 @@ void chain_module::chain_request(const sequence_id &seq, const arg_list &args) {
     return;
   }
 
-  std::vector<std::string> result;
-  run_command(result, args);
+  borrow_guard borrow(*this);
+  response_view result;
+  std::uint64_t lsn;
+  {
+    command_guard guard(*this);
+    run_command_view(result, args);
+    lsn = take_log_lsn();
+    if (lsn != 0) {
+      // The replicas hold the command, so only the client response waits for the write-ahead log
+      result.own();
+      when_logged(lsn, [this, seq, result, args] {
+        clients().respond_client(seq, result);
+        subscriptions().notify(args.front(), args[1]); // TODO: Fix
+      });
+    }
+  }
 
   if (is_tail()) {
-    clients().respond_client(seq, result);
-    subscriptions().notify(cmd_name, args[1]); // TODO: Fix
+    if (lsn == 0) {
+      clients().respond_client(seq, result);
+      subscriptions().notify(cmd_name, args[1]); // TODO: Fix
+    }
     ack(seq);
   } else {
     // Do not need a lock since this is the only thread handling chain requests
@@ -73,6 +73,43 @@ int64_t block_client::command_response_reader::recv_response(std::vector<std::st
   TMessageType mtype;
 
   this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  return read_response(out, mtype);
+}
+
+int64_t block_client::command_response_reader::recv_any(std::vector<std::string> &out) {
+  using namespace ::apache::thrift::protocol;
+  using namespace ::apache::thrift;
+  int32_t rseqid = 0;
+  std::string fname;
+  TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (fname != "run_command") {
+    return read_response(out, mtype);
+  }
+  out.clear();
+  if (mtype == T_EXCEPTION) {
+    TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    return -1;
+  }
+  block_request_service_run_command_presult result;
+  result.success = &out;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+  if (!result.__isset.success) {
+    out.clear();
+  }
+  return -1;
+}
+
+int64_t block_client::command_response_reader::read_response(std::vector<std::string> &out,
+                                                             ::apache::thrift::protocol::TMessageType mtype) {
+  using namespace ::apache::thrift::protocol;
+  using namespace ::apache::thrift;
   if (mtype == T_EXCEPTION) {
     TApplicationException x;
     x.read(this->iprot_);
@@ -31,7 +31,22 @@ class block_client {
 
     int64_t recv_response(std::vector<std::string> &out);
 
+    /**
+     * @brief Receive either a command response or a run command response, whichever arrives first
+     * @param out Response result to be returned, empty if the run command failed on the server
+     * @return Client sequence number of a command response, -1 for a run command response
+     */
+    int64_t recv_any(std::vector<std::string> &out);
+
    private:
+    /**
+     * @brief Read the rest of a command response after its message header
+     * @param out Response result to be returned
+     * @param mtype Message type
+     * @return Client sequence number
+     */
+    int64_t read_response(std::vector<std::string> &out, apache::thrift::protocol::TMessageType mtype);
+
     /* Thrift protocol */
     std::shared_ptr<apache::thrift::protocol::TProtocol> prot_;
     /* Thrift protocol */
@@ -1,4 +1,5 @@
 #include "data_structure_client.h"
+#include <algorithm>
 
 namespace jiffy {
 namespace storage {
@@ -7,12 +8,20 @@ data_structure_client::data_structure_client(std::shared_ptr<directory::director
                                              const std::string &path,
                                              const directory::data_status &status,
                                              int timeout_ms)
-    : fs_(std::move(fs)), path_(path), status_(status), timeout_ms_(timeout_ms) {
+    : fs_(std::move(fs)), path_(path), status_(status), timeout_ms_(timeout_ms), pipeline_depth_(16) {
 }
 
 directory::data_status &data_structure_client::status() {
   return status_;
 }
 
+void data_structure_client::set_pipeline_depth(std::size_t depth) {
+  pipeline_depth_ = std::max<std::size_t>(depth, 1);
+}
+
+std::size_t data_structure_client::pipeline_depth() const {
+  return pipeline_depth_;
+}
+
 }
 }
\ No newline at end of file
@@ -46,6 +46,20 @@ class data_structure_client {
 
   directory::data_status &status();
 
+  /**
+   * @brief Set the number of requests the pipelined operations keep in flight on each replica chain
+   * @param depth Pipeline depth, 1 for stop-and-wait
+   */
+
+  void set_pipeline_depth(std::size_t depth);
+
+  /**
+   * @brief Fetch the number of requests the pipelined operations keep in flight on each replica chain
+   * @return Pipeline depth
+   */
+
+  std::size_t pipeline_depth() const;
+
  protected:
 
   /**
@@ -65,6 +79,8 @@ class data_structure_client {
 
   /* Time out*/
   int timeout_ms_;
+  /* Number of requests pipelined operations keep in flight on each replica chain */
+  std::size_t pipeline_depth_;
 };
 
 }
@@ -2,6 +2,7 @@
 #include "jiffy/utils/string_utils.h"
 #include "jiffy/utils/logger.h"
 #include <algorithm>
+#include <deque>
 #include <thread>
 #include <utility>
 #include <jiffy/storage/fifoqueue/fifo_queue_partition.h>
@@ -59,6 +60,74 @@ void fifo_queue_client::enqueue(const std::string &item) {
   run_repeated(_return, args);
 }
 
+void fifo_queue_client::pipelined_enqueue(const std::vector<std::string> &items) {
+  std::size_t next = 0;
+  while (next < items.size()) {
+    // A partition that rejects an item rejects every later one, so the items
+    // that follow the first failure in flight can be resent after it in order
+    auto chain = blocks_[enqueue_partition_];
+    chain->set_window(pipeline_depth_);
+    std::deque<std::size_t> in_flight;
+    std::size_t failed = items.size();
+    std::vector<std::string> _return;
+    try {
+      while (next < items.size() && failed == items.size()) {
+        if (in_flight.size() >= pipeline_depth_) {
+          auto response = chain->recv_response();
+          if (response[0] != "!ok") {
+            failed = in_flight.front();
+            _return = std::move(response);
+            break;
+          }
+          in_flight.pop_front();
+        }
+        in_flight.push_back(next);
+        chain->send_command({"enqueue", items[next++]});
+      }
+      while (failed == items.size() && !in_flight.empty()) {
+        auto response = chain->recv_response();
+        if (response[0] != "!ok") {
+          failed = in_flight.front();
+          _return = std::move(response);
+          break;
+        }
+        in_flight.pop_front();
+      }
+      if (failed != items.size()) {
+        // Drain the responses of the rejected items
+        for (std::size_t k = 1; k < in_flight.size(); ++k) {
+          chain->recv_response();
+        }
+      }
+    } catch (std::exception &e) {
+      // The responses of the items in flight are lost with the connection; resend from the oldest
+      if (failed == items.size()) {
+        failed = in_flight.front();
+        _return.clear();
+      }
+      chain->reset();
+    }
+    chain->set_window(1);
+    if (failed == items.size()) {
+      break;
+    }
+    std::vector<std::string> args{"enqueue", items[failed]};
+    bool redo = _return.empty();
+    if (!redo) {
+      try {
+        handle_redirect(_return, args);
+      } catch (redo_error &e) {
+        redo = true;
+      }
+    }
+    if (redo) {
+      run_repeated(_return, args);
+    }
+    THROW_IF_NOT_OK(_return);
+    next = failed + 1;
+  }
+}
+
 void fifo_queue_client::dequeue() {
   std::vector<std::string> _return;
   std::vector<std::string> args{"dequeue"};
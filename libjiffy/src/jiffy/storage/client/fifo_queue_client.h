@@ -41,6 +41,12 @@ class fifo_queue_client : data_structure_client {
    */
   void enqueue(const std::string &item);
 
+  /**
+   * @brief Enqueue items in order, keeping up to the pipeline depth of requests in flight
+   * @param items New items
+   */
+  void pipelined_enqueue(const std::vector<std::string> &items);
+
   /**
    * @brief Dequeue item
    */
@@ -75,6 +81,10 @@ class fifo_queue_client : data_structure_client {
    * @return Dequeue result
    */
   std::string front();
+
+  using data_structure_client::set_pipeline_depth;
+  using data_structure_client::pipeline_depth;
+
  private:
   /**
    * @brief Handle command in redirect case
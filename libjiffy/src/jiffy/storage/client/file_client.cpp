@@ -67,7 +67,7 @@ int file_client::read(std::string &buf, size_t size) {
   return static_cast<int>(after_size - previous_size);
 }
 
-int file_client::write(const std::string &data) {
+bool file_client::allocate(std::size_t size) {
   std::size_t file_size = (last_partition_ + 1) * block_size_;
   std::vector<std::string> _return;
 
@@ -78,16 +78,16 @@ int file_client::write(const std::string &data) {
     num_chain_needed = cur_partition_ - last_partition_;
     file_size = (cur_partition_ + 1) * block_size_;
     remain_size = file_size - cur_partition_ * block_size_ - cur_offset_;
-    num_chain_needed += (data.size() - remain_size) / block_size_ + ((data.size() - remain_size) % block_size_ != 0);
+    num_chain_needed += (size - remain_size) / block_size_ + ((size - remain_size) % block_size_ != 0);
   } else {
     remain_size = file_size - cur_partition_ * block_size_ - cur_offset_;
-    if (remain_size < data.size()) {
-      num_chain_needed = (data.size() - remain_size) / block_size_ + ((data.size() - remain_size) % block_size_ != 0);
+    if (remain_size < size) {
+      num_chain_needed = (size - remain_size) / block_size_ + ((size - remain_size) % block_size_ != 0);
     }
   }
 
   if (num_chain_needed && !auto_scaling_) {
-    return -1;
+    return false;
   }
 
   // First allocate new blocks if needed
@@ -106,10 +106,17 @@ int file_client::write(const std::string &data) {
           blocks_.push_back(std::make_shared<replica_chain_client>(fs_, path_, chain, FILE_OPS));
         }
       } catch (std::exception &e) {
-        return -1;
+        return false;
       }
     }
   }
+  return true;
+}
+
+int file_client::write(const std::string &data) {
+  if (!allocate(data.size())) {
+    return -1;
+  }
   if (block_size_ - cur_offset_ == 0) {
     cur_partition_++;
     cur_offset_ = 0;
@@ -143,6 +150,56 @@ int file_client::write(const std::string &data) {
 
 }
 
+int file_client::pipelined_write(const std::vector<std::string> &data) {
+  std::size_t total_size = 0;
+  for (const auto &piece: data) {
+    total_size += piece.size();
+  }
+  if (!allocate(total_size)) {
+    return -1;
+  }
+  if (block_size_ - cur_offset_ == 0) {
+    cur_partition_++;
+    cur_offset_ = 0;
+  }
+  // Number of writes in flight on each partition
+  std::map<std::size_t, std::size_t> in_flight;
+  for (const auto &piece: data) {
+    std::size_t remaining_data = piece.size();
+    while (remaining_data > 0) {
+      auto id = block_id();
+      auto &count = in_flight[id];
+      if (count >= pipeline_depth_) {
+        blocks_[id]->recv_response();
+        count--;
+      }
+      std::string data_to_write =
+          piece.substr(piece.size() - remaining_data, std::min(remaining_data, block_size_ - cur_offset_));
+      std::vector<std::string>
+          args{"write", data_to_write, std::to_string(cur_offset_)};
+      blocks_[id]->set_window(pipeline_depth_);
+      blocks_[id]->send_command(args);
+      count++;
+      remaining_data -= data_to_write.size();
+      cur_offset_ += data_to_write.size();
+      update_last_offset();
+      if (cur_offset_ == block_size_ && cur_partition_ != last_partition_) {
+        cur_offset_ = 0;
+        cur_partition_++;
+        update_last_partition();
+      }
+    }
+  }
+
+  for (auto &count: in_flight) {
+    for (; count.second > 0; count.second--) {
+      blocks_[count.first]->recv_response();
+    }
+    blocks_[count.first]->set_window(1);
+  }
+  return static_cast<int>(total_size);
+}
+
 void file_client::refresh() {
   bool redo;
   do {
@@ -51,6 +51,14 @@ class file_client : public data_structure_client {
    */
   int write(const std::string &data);
 
+  /**
+   * @brief Write pieces of data to file one after another, keeping up to the pipeline depth of requests in flight
+   * on each partition
+   * @param data Pieces of data
+   * @return Number of bytes written, or -1 if blocks are insufficient
+   */
+  int pipelined_write(const std::vector<std::string> &data);
+
   /**
    * @brief Seek to a location of the file
    * @param offset File offset to seek
@@ -75,6 +83,13 @@ class file_client : public data_structure_client {
    */
   bool need_chain() const;
 
+  /**
+   * @brief Allocate the blocks needed to write data at the current offset
+   * @param size Size of the data
+   * @return Boolean, true if the blocks are allocated
+   */
+  bool allocate(std::size_t size);
+
   /**
    * @brief Fetch block identifier for specified operation
    * @param op Operation
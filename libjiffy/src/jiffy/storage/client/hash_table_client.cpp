@@ -2,14 +2,19 @@
 #include "jiffy/utils/string_utils.h"
 #include "jiffy/storage/hashtable/hash_slot.h"
 #include "jiffy/utils/logger.h"
+#include <deque>
 #include <thread>
 #include <cmath>
+#include <numeric>
 
 namespace jiffy {
 namespace storage {
 
 using namespace jiffy::utils;
 
+constexpr std::size_t hash_table_client::MAX_BATCH_ATTEMPTS;
+constexpr std::size_t hash_table_client::MAX_BACKOFF_SHIFT;
+
 hash_table_client::hash_table_client(std::shared_ptr<directory::directory_interface> fs,
                                      const std::string &path,
                                      const directory::data_status &status,
@@ -153,6 +158,415 @@ bool hash_table_client::exists(const std::string &key) {
   return _return[0] == "!ok";
 }
 
+std::vector<std::string> hash_table_client::mget(const std::vector<std::string> &keys,
+                                                std::vector<std::string> &values) {
+  auto responses = batch_command("get", keys, 1);
+  std::vector<std::string> status(responses.size());
+  values.assign(responses.size(), std::string());
+  for (std::size_t i = 0; i < responses.size(); ++i) {
+    status[i] = responses[i][0];
+    if (status[i] == "!ok") {
+      values[i] = responses[i][1];
+    }
+  }
+  return status;
+}
+
+std::vector<std::string> hash_table_client::mput(const std::vector<std::string> &keys,
+                                                const std::vector<std::string> &values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument("Number of keys and values do not match");
+  }
+  std::vector<std::string> args;
+  args.reserve(keys.size() * 2);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    args.push_back(keys[i]);
+    args.push_back(values[i]);
+  }
+  auto responses = batch_command("put", args, 2);
+  std::vector<std::string> status(responses.size());
+  for (std::size_t i = 0; i < responses.size(); ++i) {
+    status[i] = responses[i][0];
+  }
+  return status;
+}
+
+std::vector<std::string> hash_table_client::mupsert(const std::vector<std::string> &keys,
+                                                   const std::vector<std::string> &values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument("Number of keys and values do not match");
+  }
+  std::vector<std::string> args;
+  args.reserve(keys.size() * 2);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    args.push_back(keys[i]);
+    args.push_back(values[i]);
+  }
+  auto responses = batch_command("upsert", args, 2);
+  std::vector<std::string> status(responses.size());
+  for (std::size_t i = 0; i < responses.size(); ++i) {
+    status[i] = responses[i][0];
+  }
+  return status;
+}
+
+std::vector<std::string> hash_table_client::mremove(const std::vector<std::string> &keys) {
+  auto responses = batch_command("remove", keys, 1);
+  std::vector<std::string> status(responses.size());
+  for (std::size_t i = 0; i < responses.size(); ++i) {
+    status[i] = responses[i][0];
+  }
+  return status;
+}
+
+std::vector<std::string> hash_table_client::pipelined_get(const std::vector<std::string> &keys,
+                                                         std::vector<std::string> &values) {
+  auto responses = pipelined_command("get", keys, 1);
+  std::vector<std::string> status(responses.size());
+  values.assign(responses.size(), std::string());
+  for (std::size_t i = 0; i < responses.size(); ++i) {
+    status[i] = responses[i][0];
+    if (status[i] == "!ok") {
+      values[i] = responses[i][1];
+    }
+  }
+  return status;
+}
+
+std::vector<std::string> hash_table_client::pipelined_put(const std::vector<std::string> &keys,
+                                                         const std::vector<std::string> &values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument("Number of keys and values do not match");
+  }
+  std::vector<std::string> args;
+  args.reserve(keys.size() * 2);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    args.push_back(keys[i]);
+    args.push_back(values[i]);
+  }
+  auto responses = pipelined_command("put", args, 2);
+  std::vector<std::string> status(responses.size());
+  for (std::size_t i = 0; i < responses.size(); ++i) {
+    status[i] = responses[i][0];
+  }
+  return status;
+}
+
+std::vector<std::string> hash_table_client::pipelined_remove(const std::vector<std::string> &keys) {
+  auto responses = pipelined_command("remove", keys, 1);
+  std::vector<std::string> status(responses.size());
+  for (std::size_t i = 0; i < responses.size(); ++i) {
+    status[i] = responses[i][0];
+  }
+  return status;
+}
+
+bool hash_table_client::cas(const std::string &key, const std::string &expected, const std::string &value) {
+  std::vector<std::string> _return;
+  std::vector<std::string> args{"cas", key, expected, value};
+  bool redo;
+  do {
+    try {
+      _return = blocks_[block_id(key)]->run_command(args);
+      handle_redirect(_return, args);
+      redo = false;
+      redo_times_ = 0;
+    } catch (redo_error &e) {
+      redo = true;
+    }
+  } while (redo);
+  if (_return[0] == "!cas_failed") {
+    return false;
+  }
+  THROW_IF_NOT_OK(_return);
+  return true;
+}
+
+int64_t hash_table_client::incr(const std::string &key, int64_t delta) {
+  std::vector<std::string> _return;
+  std::vector<std::string> args{"incr", key, std::to_string(delta)};
+  bool redo;
+  do {
+    try {
+      _return = blocks_[block_id(key)]->run_command(args);
+      handle_redirect(_return, args);
+      redo = false;
+      redo_times_ = 0;
+    } catch (redo_error &e) {
+      redo = true;
+    }
+  } while (redo);
+  THROW_IF_NOT_OK(_return);
+  return std::stoll(_return[1]);
+}
+
+std::size_t hash_table_client::append(const std::string &key, const std::string &suffix) {
+  std::vector<std::string> _return;
+  std::vector<std::string> args{"append", key, suffix};
+  bool redo;
+  do {
+    try {
+      _return = blocks_[block_id(key)]->run_command(args);
+      handle_redirect(_return, args);
+      redo = false;
+      redo_times_ = 0;
+    } catch (redo_error &e) {
+      redo = true;
+    }
+  } while (redo);
+  THROW_IF_NOT_OK(_return);
+  return std::stoull(_return[1]);
+}
+
+/**
+ * @brief Parse the number of entries of a key response in a batch response
+ * @param batch_return Batch response
+ * @param pos Position of the count
+ * @param n Parsed count
+ * @return True if the count is a positive decimal integer whose entries are all in the batch response
+ */
+static bool parse_key_response_size(const std::vector<std::string> &batch_return, std::size_t pos, std::size_t &n) {
+  if (pos >= batch_return.size()) {
+    return false;
+  }
+  const auto &str = batch_return[pos];
+  if (str.empty() || str.size() > 19 || str.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  n = static_cast<std::size_t>(std::stoull(str));
+  return n > 0 && n <= batch_return.size() - pos - 1;
+}
+
+std::vector<std::vector<std::string>> hash_table_client::batch_command(const std::string &op,
+                                                                      const std::vector<std::string> &args,
+                                                                      std::size_t args_per_key) {
+  auto num_keys = args.size() / args_per_key;
+  std::vector<std::vector<std::string>> responses(num_keys);
+  std::vector<bool> resent(num_keys, false);
+  // Retries of each key after a connection failure, a malformed response or a full or busy partition
+  std::vector<std::size_t> attempts(num_keys, 0);
+  std::vector<std::size_t> pending(num_keys);
+  std::iota(pending.begin(), pending.end(), 0);
+  std::size_t backoff = 0;
+  while (!pending.empty()) {
+    std::map<std::size_t, std::vector<std::size_t>> groups;
+    for (auto i: pending) {
+      groups[block_id(args[i * args_per_key])].push_back(i);
+    }
+    pending.clear();
+
+    // Send all batches before receiving, so that partitions process them in parallel
+    std::map<std::size_t, bool> sent;
+    for (auto &group: groups) {
+      std::vector<std::string> batch_args;
+      batch_args.reserve(group.second.size() * args_per_key + 1);
+      batch_args.push_back("m" + op);
+      for (auto i: group.second) {
+        batch_args.insert(batch_args.end(),
+                          args.begin() + i * args_per_key,
+                          args.begin() + (i + 1) * args_per_key);
+      }
+      try {
+        blocks_.at(group.first)->send_command(batch_args);
+        sent[group.first] = true;
+      } catch (std::exception &e) {
+        sent[group.first] = false;
+      }
+    }
+    std::map<std::size_t, std::vector<std::string>> batch_returns;
+    for (auto &group: groups) {
+      auto &batch_return = batch_returns[group.first];
+      if (sent[group.first]) {
+        try {
+          batch_return = blocks_.at(group.first)->recv_response();
+        } catch (std::exception &e) {
+          batch_return.clear();
+        }
+      }
+    }
+
+    bool refresh_needed = false;
+    bool back_off = false;
+    // Retry a key unless it ran out of attempts, returns false if it did
+    auto retry = [&](std::size_t i) {
+      if (++attempts[i] > MAX_BATCH_ATTEMPTS) {
+        return false;
+      }
+      pending.push_back(i);
+      back_off = true;
+      return true;
+    };
+    for (auto &group: groups) {
+      auto &batch_return = batch_returns[group.first];
+      if (!batch_return.empty() && batch_return[0] == "!block_moved") {
+        // The whole partition moved, re-route the group against fresh blocks
+        refresh_needed = true;
+        pending.insert(pending.end(), group.second.begin(), group.second.end());
+        continue;
+      }
+      if (!batch_return.empty() && batch_return[0] != "!ok") {
+        for (auto i: group.second) {
+          responses[i] = {batch_return[0]};
+        }
+        continue;
+      }
+      // Validate the whole response first, so that a malformed one is retried as a whole
+      std::vector<std::pair<std::size_t, std::size_t>> key_ranges;
+      std::size_t pos = 1, n = 0;
+      while (!batch_return.empty() && key_ranges.size() < group.second.size()
+          && parse_key_response_size(batch_return, pos, n)) {
+        key_ranges.emplace_back(pos + 1, n);
+        pos += n + 1;
+      }
+      if (key_ranges.size() != group.second.size()) {
+        // Connection failure or malformed response; the connection may be out of sync, so reconnect
+        if (!batch_return.empty()) {
+          LOG(log_level::warn) << "Malformed response to " << op << " batch of " << group.second.size() << " keys";
+        }
+        refresh_needed = true;
+        for (auto i: group.second) {
+          resent[i] = true;
+          if (!retry(i)) {
+            throw std::runtime_error("Could not run " + op + " batch on " + path_ + " after "
+                                         + std::to_string(MAX_BATCH_ATTEMPTS) + " attempts");
+          }
+        }
+        continue;
+      }
+      for (std::size_t k = 0; k < group.second.size(); ++k) {
+        auto i = group.second[k];
+        auto begin = batch_return.begin() + key_ranges[k].first;
+        std::vector<std::string> key_return(begin, begin + key_ranges[k].second);
+        if (key_return[0] == "!block_moved") {
+          refresh_needed = true;
+          pending.push_back(i);
+          continue;
+        }
+        if ((key_return[0] == "!full" || key_return[0] == "!redo") && retry(i)) {
+          continue;
+        }
+        if (key_return[0] == "!exporting") {
+          std::vector<std::string> key_args{op};
+          key_args.insert(key_args.end(), args.begin() + i * args_per_key, args.begin() + (i + 1) * args_per_key);
+          try {
+            handle_redirect(key_return, key_args);
+          } catch (redo_error &e) {
+            if (retry(i)) {
+              continue;
+            }
+          }
+        }
+        if (resent[i] && op == "put" && key_return[0] == "!duplicate_key") {
+          key_return[0] = "!ok";
+        }
+        responses[i] = std::move(key_return);
+      }
+    }
+    if (refresh_needed) {
+      refresh();
+    }
+    if (back_off) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1 << std::min<std::size_t>(backoff++, MAX_BACKOFF_SHIFT)));
+    }
+  }
+  redo_times_ = 0;
+  return responses;
+}
+
+std::vector<std::vector<std::string>> hash_table_client::pipelined_command(const std::string &op,
+                                                                          const std::vector<std::string> &args,
+                                                                          std::size_t args_per_key) {
+  auto num_keys = args.size() / args_per_key;
+  std::vector<std::vector<std::string>> responses(num_keys);
+  std::vector<bool> resent(num_keys, false);
+  // Keys in flight on each chain, oldest first
+  std::map<std::shared_ptr<replica_chain_client>, std::deque<std::size_t>> in_flight;
+
+  // A failed connection loses the responses of every key in flight on it; they are resent afterwards
+  auto fail_chain = [&](const std::shared_ptr<replica_chain_client> &chain, std::deque<std::size_t> &keys) {
+    for (auto i: keys) {
+      resent[i] = true;
+    }
+    keys.clear();
+    chain->reset();
+  };
+  auto recv_oldest = [&](const std::shared_ptr<replica_chain_client> &chain, std::deque<std::size_t> &keys) {
+    try {
+      responses[keys.front()] = chain->recv_response();
+      keys.pop_front();
+    } catch (std::exception &e) {
+      fail_chain(chain, keys);
+    }
+  };
+
+  for (std::size_t i = 0; i < num_keys; ++i) {
+    std::vector<std::string> key_args{op};
+    key_args.insert(key_args.end(), args.begin() + i * args_per_key, args.begin() + (i + 1) * args_per_key);
+    auto chain = blocks_.at(block_id(args[i * args_per_key]));
+    auto &keys = in_flight[chain];
+    if (keys.size() >= pipeline_depth_) {
+      recv_oldest(chain, keys);
+    }
+    chain->set_window(pipeline_depth_);
+    keys.push_back(i);
+    try {
+      chain->send_command(key_args);
+    } catch (std::exception &e) {
+      fail_chain(chain, keys);
+    }
+  }
+  for (auto &chain: in_flight) {
+    while (!chain.second.empty()) {
+      recv_oldest(chain.first, chain.second);
+    }
+    chain.first->set_window(1);
+  }
+
+  // Keys whose partition moved or whose connection failed are resent against fresh blocks
+  bool refresh_needed = false;
+  for (auto &key_return: responses) {
+    if (key_return.empty() || key_return[0] == "!block_moved") {
+      key_return.clear();
+      refresh_needed = true;
+    }
+  }
+  if (refresh_needed) {
+    refresh();
+  }
+
+  // Complete keys that did not get a final response one at a time, as single key commands do
+  for (std::size_t i = 0; i < num_keys; ++i) {
+    auto &key_return = responses[i];
+    if (!key_return.empty() && key_return[0] == "!ok") {
+      continue;
+    }
+    std::vector<std::string> key_args{op};
+    key_args.insert(key_args.end(), args.begin() + i * args_per_key, args.begin() + (i + 1) * args_per_key);
+    bool redo = key_return.empty();
+    if (!redo) {
+      try {
+        handle_redirect(key_return, key_args);
+      } catch (redo_error &e) {
+        redo = true;
+      }
+    }
+    while (redo) {
+      try {
+        key_return = blocks_[block_id(args[i * args_per_key])]->run_command(key_args);
+        handle_redirect(key_return, key_args);
+        redo = false;
+      } catch (redo_error &e) {
+        redo = true;
+      }
+    }
+    redo_times_ = 0;
+    if (resent[i] && op == "put" && key_return[0] == "!duplicate_key") {
+      key_return[0] = "!ok";
+    }
+  }
+  return responses;
+}
+
 std::size_t hash_table_client::block_id(const std::string &key) {
   return static_cast<size_t>((*std::prev(blocks_.upper_bound(hash_slot::get(key)))).first);
 }
@@ -160,7 +574,8 @@ std::size_t hash_table_client::block_id(const std::string &key) {
 void hash_table_client::handle_redirect(std::vector<std::string> &_return, const std::vector<std::string> &args) {
   while (_return[0] == "!exporting") {
     auto args_copy = args;
-    if (args[0] == "update" || args[0] == "upsert") {
+    if (args[0] == "update" || args[0] == "upsert" || args[0] == "cas" || args[0] == "incr"
+        || args[0] == "append") {
       args_copy.emplace_back(_return[2]);
       args_copy.emplace_back(_return[3]);
     }
@@ -81,6 +81,85 @@ class hash_table_client : public data_structure_client {
    */
   bool exists(const std::string &key);
 
+  /**
+   * @brief Get values for multiple keys, sending one request per partition
+   * @param keys Keys
+   * @param values Values, empty for keys that could not be fetched
+   * @return Status for each key
+   */
+  std::vector<std::string> mget(const std::vector<std::string> &keys, std::vector<std::string> &values);
+
+  /**
+   * @brief Put multiple key value pairs, sending one request per partition
+   * @param keys Keys
+   * @param values Values
+   * @return Status for each key
+   */
+  std::vector<std::string> mput(const std::vector<std::string> &keys, const std::vector<std::string> &values);
+
+  /**
+   * @brief Put multiple key value pairs, updating existing keys, sending one request per partition
+   * @param keys Keys
+   * @param values Values
+   * @return Status for each key
+   */
+  std::vector<std::string> mupsert(const std::vector<std::string> &keys, const std::vector<std::string> &values);
+
+  /**
+   * @brief Remove multiple keys, sending one request per partition
+   * @param keys Keys
+   * @return Status for each key
+   */
+  std::vector<std::string> mremove(const std::vector<std::string> &keys);
+
+  /**
+   * @brief Get values for multiple keys, keeping up to the pipeline depth of requests in flight on each partition
+   * @param keys Keys
+   * @param values Values, empty for keys that could not be fetched
+   * @return Status for each key
+   */
+  std::vector<std::string> pipelined_get(const std::vector<std::string> &keys, std::vector<std::string> &values);
+
+  /**
+   * @brief Put multiple key value pairs, keeping up to the pipeline depth of requests in flight on each partition
+   * @param keys Keys
+   * @param values Values
+   * @return Status for each key
+   */
+  std::vector<std::string> pipelined_put(const std::vector<std::string> &keys, const std::vector<std::string> &values);
+
+  /**
+   * @brief Remove multiple keys, keeping up to the pipeline depth of requests in flight on each partition
+   * @param keys Keys
+   * @return Status for each key
+   */
+  std::vector<std::string> pipelined_remove(const std::vector<std::string> &keys);
+
+  /**
+   * @brief Atomically replace the value of a key if it equals the expected value
+   * @param key Key
+   * @param expected Expected value
+   * @param value New value
+   * @return True if the value was replaced, false if the current value differs
+   */
+  bool cas(const std::string &key, const std::string &expected, const std::string &value);
+
+  /**
+   * @brief Atomically add a delta to the decimal integer value of a key, a missing key counts as 0
+   * @param key Key
+   * @param delta Delta
+   * @return New value
+   */
+  int64_t incr(const std::string &key, int64_t delta = 1);
+
+  /**
+   * @brief Atomically append a suffix to the value of a key, a missing key counts as empty
+   * @param key Key
+   * @param suffix Suffix
+   * @return New value size
+   */
+  std::size_t append(const std::string &key, const std::string &suffix);
+
 
  private:
   /**
@@ -99,6 +178,42 @@ class hash_table_client : public data_structure_client {
 
   void handle_redirect(std::vector<std::string> &_return, const std::vector<std::string> &args) override;
 
+  /**
+   * @brief Run a single key command over a batch of keys
+   * Keys are grouped by partition and each group is sent as one batch command;
+   * all groups are sent before any response is read. Keys that were redirected
+   * are followed individually, keys whose partition moved are retried in the next round.
+   * Keys whose connection failed, whose response was malformed or whose partition was full or busy
+   * are retried with exponential backoff, up to MAX_BATCH_ATTEMPTS times; other errors are returned.
+   * @throw std::runtime_error if a connection still fails after MAX_BATCH_ATTEMPTS retries
+   * @param op Single key command name
+   * @param args Flattened arguments, args_per_key consecutive arguments per key starting with the key
+   * @param args_per_key Number of arguments per key
+   * @return Response for each key
+   */
+  std::vector<std::vector<std::string>> batch_command(const std::string &op,
+                                                      const std::vector<std::string> &args,
+                                                      std::size_t args_per_key);
+
+  /**
+   * @brief Run a single key command over a batch of keys, one request per key
+   * Requests are sent in key order, keeping up to the pipeline depth in flight on each partition.
+   * Once all requests in flight have been received, blocks are refreshed if a partition moved
+   * or a connection failed, and keys without a final response are completed one at a time.
+   * @param op Single key command name
+   * @param args Flattened arguments, args_per_key consecutive arguments per key starting with the key
+   * @param args_per_key Number of arguments per key
+   * @return Response for each key
+   */
+  std::vector<std::vector<std::string>> pipelined_command(const std::string &op,
+                                                          const std::vector<std::string> &args,
+                                                          std::size_t args_per_key);
+
+  /* Maximum number of retries of a key of a batch command */
+  static constexpr std::size_t MAX_BATCH_ATTEMPTS = 10;
+  /* Maximum backoff between batch command retries, as a power of two in milliseconds */
+  static constexpr std::size_t MAX_BACKOFF_SHIFT = 7;
+
   /* Redo times */
   std::size_t redo_times_ = 0;
 
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <thrift/transport/TTransportException.h>
 #include "replica_chain_client.h"
 #include "jiffy/utils/string_utils.h"
@@ -14,11 +15,9 @@ replica_chain_client::replica_chain_client(std::shared_ptr<directory::directory_
                                            const std::string &path,
                                            const directory::replica_chain &chain,
                                            const command_map &OPS,
-                                           int timeout_ms) : fs_(fs), path_(path), in_flight_(false), OPS_(OPS) {
+                                           int timeout_ms) : fs_(fs), path_(path), window_(1), OPS_(OPS) {
   seq_.client_id = -1;
   seq_.client_seq_no = 0;
-  accessor_ = false;
-  send_run_command_exception_ = false;
   connect(chain, timeout_ms);
   for (auto &op: OPS) {
     cmd_client_[op.first] = op.second.is_accessor() ? &tail_ : &head_;
@@ -51,55 +50,111 @@ void replica_chain_client::connect(const directory::replica_chain &chain, int ti
     tail_.connect(t.host, t.service_port, t.id, timeout_ms);
   }
   response_reader_ = tail_.get_command_response_reader(seq_.client_id);
-  in_flight_ = false;
+  in_flight_.clear();
+  early_responses_.clear();
+  early_run_responses_.clear();
+}
+
+void replica_chain_client::reset() {
+  in_flight_.clear();
+  early_responses_.clear();
+  early_run_responses_.clear();
+  disconnect();
+  try {
+    connect(chain_, timeout_ms_);
+  } catch (apache::thrift::transport::TTransportException &e) {
+    LOG(log_level::info) << "Error in connection to chain: " << e.what();
+    connect(fs_->resolve_failures(path_, chain_), timeout_ms_);
+  }
+}
+
+void replica_chain_client::set_window(std::size_t window) {
+  window_ = std::max<std::size_t>(window, 1);
+}
+
+std::size_t replica_chain_client::window() const {
+  return window_;
+}
+
+std::size_t replica_chain_client::in_flight() const {
+  return in_flight_.size();
 }
 
 void replica_chain_client::send_command(const std::vector<std::string> &args) {
-  if (in_flight_) {
-    throw std::length_error("Cannot have more than one request in-flight");
+  if (in_flight_.size() >= window_) {
+    throw std::length_error("Cannot have more than " + std::to_string(window_) + " requests in-flight");
   }
+  in_flight_request request{-1, false};
   if (OPS_[args[0]].is_accessor()) {
     try {
-      accessor_ = true;
       cmd_client_.at(args.front())->send_run_command(std::stoi(string_utils::split(chain_.tail(), ':').back()), args);
     } catch (std::exception &e) {
-      send_run_command_exception_ = true;
+      request.send_failed = true;
     }
   } else {
     cmd_client_.at(args.front())->command_request(seq_, args);
+    request.seq_no = seq_.client_seq_no;
   }
-  in_flight_ = true;
+  seq_.client_seq_no++;
+  in_flight_.push_back(request);
 }
 
 std::vector<std::string> replica_chain_client::recv_response() {
+  if (in_flight_.empty()) {
+    throw std::logic_error("No request in-flight");
+  }
+  auto request = in_flight_.front();
+  in_flight_.pop_front();
   std::vector<std::string> ret;
-  int64_t rseq;
-  if (accessor_) {
-    if (send_run_command_exception_) {
-      ret.emplace_back("!block_moved");
-    } else {
+  if (request.seq_no == -1) {
+    // Accessors run at the tail, which answers them in the order they were sent
+    if (!request.send_failed) {
       try {
-        tail_.recv_run_command(ret);
-      } catch (std::exception &e) {
-        if (!send_run_command_exception_) {
-          ret.emplace_back("!block_moved");
+        if (!early_run_responses_.empty()) {
+          ret = std::move(early_run_responses_.front());
+          early_run_responses_.pop_front();
+        } else {
+          while (!recv_next(ret, -1));
         }
+      } catch (std::exception &e) {
+        ret.clear();
       }
     }
-    send_run_command_exception_ = false;
-  } else {
-    rseq = response_reader_.recv_response(ret);
-    if (rseq != seq_.client_seq_no) {
-      throw std::logic_error(
-          "SEQ: Expected=" + std::to_string(seq_.client_seq_no) + " Received=" + std::to_string(rseq));
+    if (ret.empty()) {
+      ret.emplace_back("!block_moved");
     }
+    return ret;
   }
-  seq_.client_seq_no++;
-  in_flight_ = false;
-  accessor_ = false;
+  auto it = early_responses_.find(request.seq_no);
+  if (it != early_responses_.end()) {
+    ret = std::move(it->second);
+    early_responses_.erase(it);
+    return ret;
+  }
+  while (!recv_next(ret, request.seq_no));
   return ret;
 }
 
+bool replica_chain_client::recv_next(std::vector<std::string> &out, int64_t seq_no) {
+  std::vector<std::string> response;
+  auto rseq = response_reader_.recv_any(response);
+  if (rseq == seq_no) {
+    out = std::move(response);
+    return true;
+  }
+  if (rseq == -1) {
+    early_run_responses_.push_back(std::move(response));
+    return false;
+  }
+  for (const auto &request : in_flight_) {
+    if (request.seq_no == rseq) {
+      early_responses_.emplace(rseq, std::move(response));
+      return false;
+    }
+  }
+  throw std::logic_error("SEQ: Expected=" + std::to_string(seq_no) + " Received=" + std::to_string(rseq));
+}
+
 std::vector<std::string> replica_chain_client::run_command(const std::vector<std::string> &args) {
   std::vector<std::string> response;
   bool retry = false;
@@ -1,6 +1,7 @@
 #ifndef JIFFY_REPLICA_CHAIN_CLIENT_H
 #define JIFFY_REPLICA_CHAIN_CLIENT_H
 
+#include <deque>
 #include <map>
 #include "block_client.h"
 #include "jiffy/directory/client/directory_client.h"
@@ -47,6 +48,24 @@ class replica_chain_client {
 
   bool is_connected() const;
 
+  /**
+   * @brief Set the maximum number of requests in flight
+   * @param window Maximum number of requests sent and not yet received, 1 for stop-and-wait
+   */
+  void set_window(std::size_t window);
+
+  /**
+   * @brief Fetch the maximum number of requests in flight
+   * @return Maximum number of requests in flight
+   */
+  std::size_t window() const;
+
+  /**
+   * @brief Fetch the number of requests in flight
+   * @return Number of requests sent and not yet received
+   */
+  std::size_t in_flight() const;
+
   /**
    * @brief Send out command
    * For each command, we either save tail block client or
@@ -57,12 +76,20 @@ class replica_chain_client {
   void send_command(const std::vector<std::string> &args);
 
   /**
-   * @brief Receive response of command
-   * Check whether response equals client sequence number
+   * @brief Receive response of the oldest command in flight
+   * Command responses are matched by client sequence number and run command responses
+   * of accessors by arrival order; responses received ahead of the command are kept
+   * until the command's turn
    * @return Response
    */
   std::vector<std::string> recv_response();
 
+  /**
+   * @brief Drop all requests in flight by reconnecting to the chain
+   * Used after a failure leaves the responses of requests in flight unread
+   */
+  void reset();
+
   /**
    * @brief Run command, first send command to the correct block(head or tail)
    * Then receive the response
@@ -102,6 +129,23 @@ class replica_chain_client {
    */
 
   void disconnect();
+
+  /**
+   * @brief Receive the next response from the tail, keeping it if it belongs to another request
+   * @param out Response, set if it belongs to the request
+   * @param seq_no Client sequence number of the request, -1 for a run command accessor
+   * @return True if the response belongs to the request
+   */
+  bool recv_next(std::vector<std::string> &out, int64_t seq_no);
+
+  /* Request in flight */
+  struct in_flight_request {
+    /* Client sequence number, -1 for run command accessors */
+    int64_t seq_no;
+    /* Bool indicating if sending the run command failed */
+    bool send_failed;
+  };
+
   /* Directory client */
   std::shared_ptr<directory::directory_interface> fs_;
   /* File path */
@@ -119,16 +163,18 @@ class replica_chain_client {
   block_client::command_response_reader response_reader_;
   /* Clients for each commands */
   std::unordered_map<std::string, client_ref> cmd_client_;
-  /* Bool value, true if request is in flight */
-  bool in_flight_;
+  /* Requests in flight, oldest first */
+  std::deque<in_flight_request> in_flight_;
+  /* Maximum number of requests in flight */
+  std::size_t window_;
+  /* Command responses received ahead of their turn, by client sequence number */
+  std::map<int64_t, std::vector<std::string>> early_responses_;
+  /* Run command responses received ahead of their turn, in arrival order */
+  std::deque<std::vector<std::string>> early_run_responses_;
   /* Time out */
   int timeout_ms_;
   /* Operations for the data structure */
   command_map OPS_;
-  /* Bool indicating if the command is accessor type */
-  bool accessor_;
-  /* Bool indicating if send run command throws an exception */
-  bool send_run_command_exception_;
 };
 
 }
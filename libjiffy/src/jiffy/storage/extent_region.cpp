@@ -0,0 +1,187 @@
+#include "extent_region.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+
+namespace jiffy {
+namespace storage {
+
+/**
+ * @brief Check if a buffer only holds zeros
+ * @param data Buffer
+ * @param len Buffer length
+ * @return True if all bytes are zero
+ */
+static bool is_zero(const char *data, std::size_t len) {
+  return len == 0 || (data[0] == 0 && std::memcmp(data, data + 1, len - 1) == 0);
+}
+
+const std::size_t extent_region::EXTENT_SIZE;
+
+extent_region::extent_region(std::size_t size, block_memory_manager *manager)
+    : manager_(manager),
+      size_(size),
+      data_(nullptr),
+      mapped_(false),
+      extents_((size + EXTENT_SIZE - 1) / EXTENT_SIZE),
+      committed_(0) {
+  if (size_ == 0) {
+    return;
+  }
+  data_ = static_cast<char *>(manager_->mb_map(size_));
+  mapped_ = data_ != nullptr;
+  if (!mapped_) {
+    data_ = static_cast<char *>(manager_->mb_malloc(size_));
+    if (data_ == nullptr) {
+      if (manager_->mb_used() + size_ > manager_->mb_capacity()) {
+        throw memory_block_overflow();
+      }
+      throw std::bad_alloc();
+    }
+    for (auto &e: extents_) {
+      e.store(true);
+    }
+    committed_ = size_;
+  }
+}
+
+extent_region::~extent_region() {
+  if (data_ == nullptr) {
+    return;
+  }
+  if (mapped_) {
+    manager_->mb_unmap(data_, size_);
+    manager_->mb_unreserve(committed_);
+  } else {
+    manager_->mb_free(data_, size_);
+  }
+}
+
+char *extent_region::data() const {
+  return data_;
+}
+
+std::size_t extent_region::size() const {
+  return size_;
+}
+
+void extent_region::write(std::size_t offset, const char *src, std::size_t len) {
+  if (offset > size_ || len > size_ - offset) {
+    throw std::invalid_argument("Write exceeds region size");
+  }
+  auto end = offset + len;
+  while (offset < end) {
+    auto extent = offset / EXTENT_SIZE;
+    auto n = std::min(end, (extent + 1) * EXTENT_SIZE) - offset;
+    if (!extents_[extent].load(std::memory_order_acquire)) {
+      if (is_zero(src, n)) {
+        offset += n;
+        src += n;
+        continue;
+      }
+      commit_extent(extent);
+    } else if (n == extent_size(extent) && is_zero(src, n)) {
+      // Zeroing a whole extent returns its memory
+      release_extent(extent);
+      offset += n;
+      src += n;
+      continue;
+    }
+    std::memcpy(data_ + offset, src, n);
+    offset += n;
+    src += n;
+  }
+}
+
+void extent_region::commit(std::size_t offset, std::size_t len) {
+  if (offset > size_ || len > size_ - offset) {
+    throw std::invalid_argument("Commit exceeds region size");
+  }
+  if (len == 0) {
+    return;
+  }
+  for (auto extent = offset / EXTENT_SIZE; extent * EXTENT_SIZE < offset + len; ++extent) {
+    if (!extents_[extent].load(std::memory_order_acquire)) {
+      commit_extent(extent);
+    }
+  }
+}
+
+void extent_region::release(std::size_t offset, std::size_t len) {
+  if (offset > size_ || len > size_ - offset) {
+    throw std::invalid_argument("Release exceeds region size");
+  }
+  auto end = offset + len;
+  // The partial last extent is entirely within any range reaching the end of the region
+  auto last = end == size_ ? extents_.size() : end / EXTENT_SIZE;
+  for (auto extent = (offset + EXTENT_SIZE - 1) / EXTENT_SIZE; extent < last; ++extent) {
+    release_extent(extent);
+  }
+}
+
+void extent_region::clear() {
+  release(0, size_);
+}
+
+std::size_t extent_region::committed() const {
+  return committed_.load();
+}
+
+void extent_region::copy_from(const extent_region &other, std::size_t len) {
+  copy_from(other, 0, len);
+}
+
+void extent_region::copy_from(const extent_region &other, std::size_t offset, std::size_t len) {
+  auto end = std::min(offset + len, std::min(size_, other.size_));
+  while (offset < end) {
+    auto extent = offset / EXTENT_SIZE;
+    auto n = std::min(end, (extent + 1) * EXTENT_SIZE) - offset;
+    if (other.extents_[extent].load(std::memory_order_acquire)) {
+      write(offset, other.data_ + offset, n);
+    } else if (extents_[extent].load(std::memory_order_acquire)) {
+      std::memset(data_ + offset, 0, n);
+    }
+    offset += n;
+  }
+}
+
+std::size_t extent_region::extent_size(std::size_t extent) const {
+  return std::min(EXTENT_SIZE, size_ - extent * EXTENT_SIZE);
+}
+
+void extent_region::commit_extent(std::size_t extent) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (extents_[extent].load(std::memory_order_relaxed)) {
+    return;
+  }
+  auto size = extent_size(extent);
+  if (!manager_->mb_reserve(size)) {
+    throw memory_block_overflow();
+  }
+  committed_ += size;
+  extents_[extent].store(true, std::memory_order_release);
+}
+
+void extent_region::release_extent(std::size_t extent) {
+  auto ptr = data_ + extent * EXTENT_SIZE;
+  auto size = extent_size(extent);
+  if (!mapped_) {
+    std::memset(ptr, 0, size);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (!extents_[extent].load(std::memory_order_relaxed)) {
+    return;
+  }
+  // Dropped pages of a private anonymous mapping read as zeros on the next access
+  if (madvise(ptr, size, MADV_DONTNEED) != 0) {
+    std::memset(ptr, 0, size);
+  }
+  extents_[extent].store(false, std::memory_order_release);
+  committed_ -= size;
+  manager_->mb_unreserve(size);
+}
+
+}
+}
@@ -0,0 +1,150 @@
+#ifndef JIFFY_EXTENT_REGION_H
+#define JIFFY_EXTENT_REGION_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include "jiffy/storage/block_memory_manager.h"
+
+namespace jiffy {
+namespace storage {
+
+/**
+ * @brief Contiguous memory region whose memory is committed in extents on first write.
+ *
+ * The region reserves address space for its full size up front, so that it can be addressed and
+ * borrowed from like a single allocation, but only accounts an extent against the memory block, and
+ * only has the kernel back it with pages, once data is written to it. Extents that were never written
+ * read as zeros. Released extents are returned to the kernel and read as zeros again.
+ * Memory modes that cannot map regions lazily allocate the whole region up front instead, in which case
+ * every extent counts as committed.
+ */
+class extent_region {
+ public:
+  /* Extent size, the granularity at which memory is committed and released */
+  static const std::size_t EXTENT_SIZE = block_memory_manager::HUGE_PAGE_SIZE;
+
+  /**
+   * @brief Constructor
+   * @param size Region size
+   * @param manager Block memory manager accounting the committed extents
+   */
+  extent_region(std::size_t size, block_memory_manager *manager);
+
+  /**
+   * @brief Destructor, returns the region to the memory block
+   */
+  ~extent_region();
+
+  extent_region(const extent_region &) = delete;
+  extent_region &operator=(const extent_region &) = delete;
+
+  /**
+   * @brief Fetch data pointer
+   * @return Data pointer of the region
+   */
+  char *data() const;
+
+  /**
+   * @brief Fetch region size
+   * @return Size
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Write data, committing the extents it covers; zeros written to uncommitted extents are
+   * skipped since the extents already read as zeros, and extents overwritten with zeros entirely are
+   * released
+   * @param offset Write offset
+   * @param src Data
+   * @param len Data length
+   */
+  void write(std::size_t offset, const char *src, std::size_t len);
+
+  /**
+   * @brief Commit the extents covering a range
+   * @param offset Range offset
+   * @param len Range length
+   */
+  void commit(std::size_t offset, std::size_t len);
+
+  /**
+   * @brief Release the extents entirely within a range, zeroing their content
+   * @param offset Range offset
+   * @param len Range length
+   */
+  void release(std::size_t offset, std::size_t len);
+
+  /**
+   * @brief Release all extents, zeroing the region
+   */
+  void clear();
+
+  /**
+   * @brief Fetch the number of committed bytes
+   * @return Committed bytes
+   */
+  std::size_t committed() const;
+
+  /**
+   * @brief Copy the beginning of another region, only touching the extents committed in either region
+   * @param other Other region
+   * @param len Number of bytes to copy
+   */
+  void copy_from(const extent_region &other, std::size_t len);
+
+  /**
+   * @brief Copy a range of another region, only touching the extents committed in either region
+   * @param other Other region
+   * @param offset Range offset
+   * @param len Range length
+   */
+  void copy_from(const extent_region &other, std::size_t offset, std::size_t len);
+
+ private:
+  /**
+   * @brief Fetch the size of an extent, the last extent may be partial
+   * @param extent Extent index
+   * @return Extent size
+   */
+  std::size_t extent_size(std::size_t extent) const;
+
+  /**
+   * @brief Commit an extent
+   * @param extent Extent index
+   */
+  void commit_extent(std::size_t extent);
+
+  /**
+   * @brief Release an extent
+   * @param extent Extent index
+   */
+  void release_extent(std::size_t extent);
+
+  /* Block memory manager */
+  block_memory_manager *manager_;
+
+  /* Region size */
+  std::size_t size_;
+
+  /* Data pointer */
+  char *data_;
+
+  /* True if the region was mapped lazily, false if it was allocated up front */
+  bool mapped_;
+
+  /* Extent table, true for committed extents */
+  std::vector<std::atomic<bool>> extents_;
+
+  /* Number of committed bytes */
+  std::atomic<std::size_t> committed_;
+
+  /* Mutex serializing commits and releases */
+  std::mutex mtx_;
+};
+
+}
+}
+
+#endif //JIFFY_EXTENT_REGION_H
@@ -22,6 +22,11 @@ fifo_queue_partition::fifo_queue_partition(block_memory_manager *manager,
       scaling_up_(false),
       scaling_down_(false),
       dirty_(false),
+      synced_size_(0),
+      sync_base_(true),
+      base_begin_(0),
+      deltas_(conf.get_as<std::size_t>("fifoqueue.sync_max_deltas", 16),
+              conf.get_as<double>("fifoqueue.sync_delta_ratio", 0.5)),
       auto_scaling_host_(auto_scaling_host),
       auto_scaling_port_(auto_scaling_port),
       head_(0),
@@ -41,6 +46,12 @@ fifo_queue_partition::fifo_queue_partition(block_memory_manager *manager,
   ser_name_ = conf.get("fifoqueue.serializer", "csv");
   if (ser_name_ == "binary") {
     ser_ = std::make_shared<binary_serde>(binary_allocator_);
+  } else if (ser_name_ == "binary_lz4") {
+    ser_ = std::make_shared<binary_serde>(binary_allocator_, persistent::codec::make("lz4"));
+  } else if (ser_name_ == "binary_zstd") {
+    ser_ = std::make_shared<binary_serde>(binary_allocator_, persistent::codec::make("zstd"));
+  } else if (ser_name_ == "indexed") {
+    ser_ = std::make_shared<indexed_serde>(binary_allocator_);
   } else if (ser_name_ == "csv") {
     ser_ = std::make_shared<csv_serde>(binary_allocator_);
   } else {
@@ -48,6 +59,11 @@ fifo_queue_partition::fifo_queue_partition(block_memory_manager *manager,
   }
   auto_scale_ = conf.get_as<bool>("fifoqueue.auto_scale", true);
   periodicity_us_ = conf.get_as<std::size_t>("fifoqueue.periodicity", 100000);
+  // The *_ls commands address messages in place, which compressed and indexed files do not allow
+  if (ser_name_ == "csv" || ser_name_ == "binary") {
+    ls_store_ = std::shared_ptr<fifo_queue_segment_store>(
+        new fifo_queue_segment_store(ser_name_, conf.get_as<std::size_t>("fifoqueue.ls_segment_size", 16777216)));
+  }
   enqueue_start_time_ = time_utils::now_us();
   dequeue_start_time_ = time_utils::now_us();
 }
@@ -69,14 +85,14 @@ void fifo_queue_partition::enqueue(response &_return, const arg_list &args) {
     if (!auto_scale_) {
       enqueue_redirected_ = true;
       RETURN_ERR("!redirected_enqueue",
-                 std::to_string(enqueue_data_size_),
+                 std::to_string(enqueue_data_size_.load()),
                  std::to_string(enqueue_time_count_),
                  std::to_string(enqueue_start_data_size_));
     } else if (!next_target_str_.empty()) {
       enqueue_redirected_ = true;
       RETURN_ERR("!redirected_enqueue",
                  next_target_str_,
-                 std::to_string(enqueue_data_size_),
+                 std::to_string(enqueue_data_size_.load()),
                  std::to_string(enqueue_time_count_),
                  std::to_string(enqueue_start_data_size_));
     } else {
@@ -88,6 +104,13 @@ void fifo_queue_partition::enqueue(response &_return, const arg_list &args) {
 }
 
 void fifo_queue_partition::dequeue(response &_return, const arg_list &args) {
+  borrow_guard borrow(*this);
+  response_view view;
+  dequeue(view, args);
+  _return = view.to_response();
+}
+
+void fifo_queue_partition::dequeue(response_view &_return, const arg_list &args) {
   if (!(args.size() == 1 || (args.size() == 4 && args[3] == "!redirected"))) {
     RETURN_ERR("!args_error");
   }
@@ -98,13 +121,14 @@ void fifo_queue_partition::dequeue(response &_return, const arg_list &args) {
     dequeue_start_time_ = time_utils::now_us();
     dequeue_data_size_ += prev_data_size_;
   }
-  auto ret = partition_.at(head_);
+  auto ret = partition_.at_span(head_);
   if (ret.first) {
-    head_ += (string_array::METADATA_LEN + ret.second.size());
+    release_dequeued();
+    head_ += (string_array::METADATA_LEN + ret.second.size);
     head_index_++;
     update_read_head();
     update_read_head_index();
-    dequeue_data_size_ += ret.second.size();
+    dequeue_data_size_ += ret.second.size;
     RETURN_OK(ret.second);
   }
   if (ret.second == "!not_available") {
@@ -128,118 +152,26 @@ void fifo_queue_partition::dequeue(response &_return, const arg_list &args) {
 
 /* enqueue_ls() works on the index of queue elements on local storage, while enqueue() works on memory address. */
 void fifo_queue_partition::enqueue_ls(response &_return, const arg_list &args) {
-  if (args.size() != 2) {
-    RETURN_ERR("!args_error");
-  }
-  std::string file_path, line, data;
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path, name());
-  if (ser_name_ == "csv") {
-    std::ofstream out(file_path, std::ios::app);
-    if (out) {
-      data = args[1];
-      out << data << std::endl;
-      out.close();
-    } else {
-      RETURN_ERR("!fifo_queue_does_not_exist");
-    }
-    enqueue_data_size_ += args[1].size();
-    RETURN_OK();
-  } else if (ser_name_ == "binary") {
-    std::ofstream out(file_path, std::ios::app);
-    std::string offset_path = file_path;
-    offset_path.append("_offset");
-    std::ofstream offset_out(offset_path, std::ios::app);
-    if (out && offset_out) {
-      data = args[1];
-      std::size_t msg_size = data.size();
-      offset_out.write(reinterpret_cast<const char *>(&msg_size), sizeof(size_t));
-      out.write(reinterpret_cast<const char *>(data.data()), msg_size);
-      out.close();
-      offset_out.close();
-    } else {
-      RETURN_ERR("!fifo_queue_does_not_exist");
-    }
-    enqueue_data_size_ += args[1].size();
-    RETURN_OK();
-  }
+  run_ls(_return, args, ls_path());
 }
 
 void fifo_queue_partition::dequeue_ls(response &_return, const arg_list &args) {
-  if (args.size() != 1) {
-    RETURN_ERR("!args_error");
-  }
-  std::vector<std::string> v;
-  std::string file_path, line;
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path, name());
-  if (ser_name_ == "csv") {
-    std::ifstream in(file_path);
-    if (in) {
-      while (getline(in, line)) {
-        v.push_back(line);
-      }
-      in.close();
-    } else {
-      RETURN_ERR("!fifo_queue_does_not_exist");
-    }
-    if (v.size() == 0) {
-      RETURN_ERR("!queue_is_empty");
-    }
-    std::ofstream out(file_path);
-    for (std::size_t i = 1; i < v.size(); i++) {
-      out << v[i] << std::endl;
-    }
-    out.close();
-    head_index_++;
-    dequeue_data_size_ += v[0].size();
-    RETURN_OK(v[0]);
-  } else if (ser_name_ == "binary") {
-    std::ifstream in(file_path, std::ios::binary);
-    std::string offset_path = file_path;
-    offset_path.append("_offset");
-    std::ifstream offset_in(offset_path, std::ios::binary);
-    if (in && offset_in) {
-      while (in.peek() != EOF && offset_in.peek() != EOF) {
-        std::size_t msg_size;
-        offset_in.read(reinterpret_cast<char *>(&msg_size), sizeof(msg_size));
-        std::string msg;
-        msg.resize(msg_size);
-        in.read(&msg[0], msg_size);
-        v.push_back(msg);
-      }
-      in.close();
-      offset_in.close();
-    } else {
-      RETURN_ERR("!fifo_queue_does_not_exist");
-    }
-    if (v.size() == 0) {
-      RETURN_ERR("!queue_is_empty");
-    }
-    std::ofstream out(file_path, std::ios::binary);
-    std::ofstream offset_out(offset_path, std::ios::binary);
-    for (std::size_t i = 1; i < v.size(); i++) {
-      std::size_t msg_size = v[i].size();
-      offset_out.write(reinterpret_cast<const char *>(&msg_size), sizeof(size_t));
-      out.write(reinterpret_cast<const char *>(v[i].data()), msg_size);
-    }
-    out.flush();
-    offset_out.flush();
-    out.close();
-    offset_out.close();
-    head_index_++;
-    dequeue_data_size_ += v[0].size();
-    RETURN_OK(v[0]);
-  }
+  run_ls(_return, args, ls_path());
 }
 
 void fifo_queue_partition::read_next(response &_return, const arg_list &args) {
+  response_view view;
+  read_next(view, args);
+  _return = view.to_response();
+}
+
+void fifo_queue_partition::read_next(response_view &_return, const arg_list &args) {
   if (!(args.size() == 1 || (args.size() == 2 && args[1] == "!redirected"))) {
     RETURN_ERR("!args_error");
   }
-  auto ret = partition_.at(read_head_);
+  auto ret = partition_.at_span(read_head_);
   if (ret.first) {
-    read_head_ += (string_array::METADATA_LEN + ret.second.size());
+    read_head_ += (string_array::METADATA_LEN + ret.second.size);
     read_head_index_ += 1;
     RETURN_OK(ret.second);
   }
@@ -257,59 +189,63 @@ void fifo_queue_partition::read_next(response &_return, const arg_list &args) {
 }
 
 void fifo_queue_partition::read_next_ls(response &_return, const arg_list &args) {
-  if (args.size() != 1) {
+  run_ls(_return, args, ls_path());
+}
+
+void fifo_queue_partition::run_ls(response &_return, const arg_list &args, const std::string &path) {
+  auto cmd_id = command_id(args[0]);
+  if (cmd_id == fifo_queue_cmd_id::fq_enqueue_ls ? args.size() < 2
+                                                 : !(args.size() == 1 || (args.size() == 2 && std::stoul(args[1]) > 0))) {
     RETURN_ERR("!args_error");
   }
-  std::vector<std::string> v;
-  std::string file_path, line;
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path, name());
-  if (ser_name_ == "csv") {
-    std::ifstream in(file_path);
-    if (in) {
-      int count = read_head_index_ - head_index_;
-      while (count >= 0) {
-        count--;
-        getline(in, line);
-      }
-      in.close();
-      read_head_index_ += 1;
-      RETURN_OK(line);
-    } else {
-      RETURN_ERR("!fifo_queue_does_not_exist");
+  if (ls_store_ == nullptr) {
+    RETURN_ERR("!unsupported_serializer");
+  }
+  if (!ls_store_->open(path)) {
+    RETURN_ERR("!fifo_queue_does_not_exist");
+  }
+  if (cmd_id == fifo_queue_cmd_id::fq_enqueue_ls) {
+    ls_store_->enqueue(args, 1);
+    for (std::size_t i = 1; i < args.size(); ++i) {
+      enqueue_data_size_ += args[i].size();
     }
-  } else if (ser_name_ == "binary") {
-    std::ifstream in(file_path, std::ios::binary);
-    std::string offset_path = file_path;
-    offset_path.append("_offset");
-    std::ifstream offset_in(offset_path, std::ios::binary);
-    std::size_t offset = 0;
-    std::size_t msg_size = 0;
-    if (in && offset_in) {
-      int count = read_head_index_ - head_index_;
-      while (count >= 0) {
-        count--;
-        offset_in.read(reinterpret_cast<char *>(&msg_size), sizeof(msg_size));
-        in.seekg(offset, std::ios::beg);
-        offset += msg_size;
-      }
-      std::string msg;
-      msg.resize(msg_size);
-      in.read(&msg[0], msg_size);
-      in.close();
-      offset_in.close();
-      read_head_index_ += 1;
-      RETURN_OK(msg);
-    } else {
-      RETURN_ERR("!fifo_queue_does_not_exist");
+    RETURN_OK();
+  }
+  std::vector<std::string> msgs;
+  auto max_count = args.size() == 2 ? std::stoul(args[1]) : 1;
+  if (cmd_id == fifo_queue_cmd_id::fq_dequeue_ls) {
+    auto count = ls_store_->dequeue(max_count, msgs);
+    if (count == 0) {
+      RETURN_ERR("!queue_is_empty");
+    }
+    head_index_ += count;
+    for (const auto &msg: msgs) {
+      dequeue_data_size_ += msg.size();
+    }
+  } else {
+    auto count = ls_store_->read_next(max_count, msgs);
+    if (count == 0) {
+      RETURN_ERR("!msg_not_found");
     }
+    read_head_index_ += count;
+  }
+  _return.emplace_back("!ok");
+  for (auto &msg: msgs) {
+    _return.push_back(std::move(msg));
   }
 }
 
+std::string fifo_queue_partition::ls_path() const {
+  auto file_path = directory_utils::remove_uri(backing_path());
+  directory_utils::push_path_element(file_path, name());
+  return file_path;
+}
+
 void fifo_queue_partition::clear(response &_return, const arg_list &args) {
   if (args.size() != 1) {
     RETURN_ERR("!args_error");
   }
+  snapshot_copy_.preserve_all();
   clear_partition();
   RETURN_OK();
 }
@@ -328,13 +264,13 @@ void fifo_queue_partition::length(response &_return, const arg_list &args) {
       if (overload() && enqueue_redirected_) {
         RETURN_ERR("!redirected_length", next_target_str_);
       } else {
-        RETURN_OK(std::to_string(enqueue_data_size_));
+        RETURN_OK(std::to_string(enqueue_data_size_.load()));
       }
     case fifo_queue_size_type::tail_size:
       if (underload() && dequeue_redirected_) {
         RETURN_ERR("!redirected_length", next_target_str_);
       } else {
-        RETURN_OK(std::to_string(dequeue_data_size_));
+        RETURN_OK(std::to_string(dequeue_data_size_.load()));
       }
     default:throw std::logic_error("Undefined type for length operation");
   }
@@ -367,10 +303,16 @@ void fifo_queue_partition::out_rate(response &_return, const arg_list &args) {
 }
 
 void fifo_queue_partition::front(response &_return, const arg_list &args) {
+  response_view view;
+  front(view, args);
+  _return = view.to_response();
+}
+
+void fifo_queue_partition::front(response_view &_return, const arg_list &args) {
   if (!(args.size() == 1 || (args.size() == 2 && args[1] == "!redirected"))) {
     RETURN_ERR("!args_error");
   }
-  auto ret = partition_.at(head_);
+  auto ret = partition_.at_span(head_);
   if (ret.first) {
     RETURN_OK(ret.second);
   }
@@ -420,8 +362,55 @@ void fifo_queue_partition::run_command(response &_return, const arg_list &args)
       return;
     }
   }
+  after_command(cmd_name);
+}
+
+void fifo_queue_partition::run_command_view(response_view &_return, const arg_list &args) {
+  auto cmd_name = args[0];
+  switch (command_id(cmd_name)) {
+    case fifo_queue_cmd_id::fq_dequeue:update_rate();
+      dequeue(_return, args);
+      break;
+    case fifo_queue_cmd_id::fq_readnext:update_rate();
+      read_next(_return, args);
+      break;
+    case fifo_queue_cmd_id::fq_front:update_rate();
+      front(_return, args);
+      break;
+    default:partition::run_command_view(_return, args);
+      return;
+  }
+  after_command(cmd_name, &_return);
+}
+
+bool fifo_queue_partition::run_command_async(const arg_list &args, std::function<void(const response &)> done) {
+  auto cmd_name = args[0];
+  switch (command_id(cmd_name)) {
+    case fifo_queue_cmd_id::fq_enqueue_ls:
+    case fifo_queue_cmd_id::fq_dequeue_ls:
+    case fifo_queue_cmd_id::fq_readnext_ls:break;
+    default:return false;
+  }
+  update_rate();
+  // The next sync has to see the command even if it runs before the command reaches the disk
+  after_command(cmd_name);
+  auto path = ls_path();
+  ls_queue_.submit([this, args, path, done] {
+    response result;
+    run_ls(result, args, path);
+    done(result);
+  });
+  return true;
+}
+
+void fifo_queue_partition::after_command(const std::string &cmd_name, response_view *result) {
   if (is_mutator(cmd_name)) {
     dirty_ = true;
+    auto cmd_id = command_id(cmd_name);
+    if (cmd_id == fifo_queue_cmd_id::fq_enqueue_ls || cmd_id == fifo_queue_cmd_id::fq_dequeue_ls) {
+      // The *_ls commands change the base image underneath the deltas
+      sync_base_ = true;
+    }
   }
   if (auto_scale_ && is_mutator(cmd_name) && overload() && is_tail() && !scaling_up_ && !scaling_down_) {
     LOG(log_level::info) << "Overloaded partition: " << name() << " storage = " << storage_size() << " capacity = "
@@ -433,6 +422,9 @@ void fifo_queue_partition::run_command(response &_return, const arg_list &args)
       std::map<std::string, std::string> scale_conf;
       scale_conf.emplace(std::make_pair(std::string("type"), std::string("fifo_queue_add")));
       scale_conf.emplace(std::make_pair(std::string("next_partition_name"), dst_partition_name));
+      if (result != nullptr) {
+        result->own();
+      }
       auto scale = std::make_shared<auto_scaling::auto_scaling_client>(auto_scaling_host_, auto_scaling_port_);
       scale->auto_scaling(chain(), path(), scale_conf);
     } catch (std::exception &e) {
@@ -451,6 +443,9 @@ void fifo_queue_partition::run_command(response &_return, const arg_list &args)
       std::map<std::string, std::string> scale_conf;
       scale_conf.emplace(std::make_pair(std::string("type"), std::string("fifo_queue_delete")));
       scale_conf.emplace(std::make_pair(std::string("current_partition_name"), name()));
+      if (result != nullptr) {
+        result->own();
+      }
       auto scale = std::make_shared<auto_scaling::auto_scaling_client>(auto_scaling_host_, auto_scaling_port_);
       scale->auto_scaling(chain(), path(), scale_conf);
     } catch (std::exception &e) {
@@ -473,31 +468,90 @@ bool fifo_queue_partition::is_dirty() const {
 }
 
 void fifo_queue_partition::load(const std::string &path) {
+  // Snapshots of the path by any partition must land before it is read
+  persistent::snapshot_writer::instance()->wait_all();
   auto remote = persistent::persistent_store::instance(path, ser_);
   auto decomposed = persistent::persistent_store::decompose_path(path);
+  // A base image replaced up to a crash is either finished or left untouched
+  remote->recover_base(decomposed.second);
+  if (decomposed.first == "local" && ls_store_ != nullptr) {
+    // Fold *_ls segments into the file before reading it
+    ls_store_->flush(decomposed.second);
+  }
   remote->read<fifo_queue_type>(decomposed.second, partition_);
+  auto replayed = remote->replay_deltas(decomposed.second, [this](const persistent::delta &d) {
+    apply_delta(d);
+  });
+  deltas_.reset(path, replayed.first, replayed.second);
+  synced_size_ = partition_.size();
+  sync_base_ = false;
+  base_begin_ = 0;
 }
 
-bool fifo_queue_partition::sync(const std::string &path) {
+bool fifo_queue_partition::snapshot(const std::string &path) {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mtx_);
+  auto synced = capture_snapshot(path);
+  // A base image is copied one extent at a time while commands append to the queue
+  finish_snapshot();
+  return synced;
+}
+
+bool fifo_queue_partition::capture_snapshot(const std::string &path) {
+  freeze_guard freeze(*this);
+  if (!freeze.frozen()) {
+    LOG(log_level::warn) << "Commands on partition " << name() << " did not drain, skipping snapshot";
+    return false;
+  }
+  if (snapshot_failed()) {
+    dirty_ = true;
+    sync_base_ = true;
+  }
   if (dirty_) {
-    auto remote = persistent::persistent_store::instance(path, ser_);
-    auto decomposed = persistent::persistent_store::decompose_path(path);
-    remote->write<fifo_queue_type>(partition_, decomposed.second);
+    bool synced = true;
+    if (sync_base_) {
+      snapshot_base(path);
+    } else if (partition_.size() == synced_size_) {
+      // Dequeues do not change the persisted items
+      synced = false;
+    } else {
+      auto d = std::make_shared<persistent::delta>(make_delta());
+      auto delta_bytes = persistent::delta_size(*d);
+      if (deltas_.can_append(path, delta_bytes, partition_.size())) {
+        auto seq = deltas_.append(delta_bytes);
+        auto ser = ser_;
+        persist(delta_bytes, [ser, path, d, seq] {
+          auto remote = persistent::persistent_store::instance(path, ser);
+          auto decomposed = persistent::persistent_store::decompose_path(path);
+          remote->write_delta(*d, decomposed.second, seq);
+        });
+        synced_size_ = partition_.size();
+      } else {
+        snapshot_base(path);
+      }
+    }
     dirty_ = false;
-    return true;
+    return synced;
   }
   return false;
 }
 
+bool fifo_queue_partition::sync(const std::string &path) {
+  auto synced = snapshot(path);
+  wait_snapshots();
+  return synced;
+}
+
 bool fifo_queue_partition::dump(const std::string &path) {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mtx_);
+  wait_snapshots();
   bool flushed = false;
-  if (dirty_) {
-    auto remote = persistent::persistent_store::instance(path, ser_);
-    auto decomposed = persistent::persistent_store::decompose_path(path);
-    remote->write<fifo_queue_type>(partition_, decomposed.second);
+  // The *_ls commands only read the base image, so fold deltas into it as well
+  if (dirty_ || deltas_.num_deltas() > 0) {
+    write_base(path);
     flushed = true;
   }
   clear_partition();
+  deltas_.clear();
   next_->reset("nil");
   path_ = "";
   sub_map_.clear();
@@ -506,6 +560,69 @@ bool fifo_queue_partition::dump(const std::string &path) {
   return flushed;
 }
 
+persistent::delta fifo_queue_partition::make_delta() const {
+  // Released items are not in the base image, so records are identified by offsets relative to it
+  persistent::delta_record r{synced_size_ - base_begin_, {}};
+  auto offset = synced_size_;
+  while (offset < partition_.size()) {
+    auto item = partition_.at_span(offset).second;
+    r.items.emplace_back(item.data, item.size);
+    offset += string_array::METADATA_LEN + item.size;
+  }
+  persistent::delta d;
+  d.push_back(std::move(r));
+  return d;
+}
+
+void fifo_queue_partition::apply_delta(const persistent::delta &d) {
+  for (const auto &r: d) {
+    if (r.id != partition_.size()) {
+      throw std::runtime_error("Fifo queue delta does not extend the base image");
+    }
+    for (const auto &item: r.items) {
+      partition_.push_back(item);
+    }
+  }
+}
+
+void fifo_queue_partition::write_base(const std::string &path) {
+  auto remote = persistent::persistent_store::instance(path, ser_);
+  auto decomposed = persistent::persistent_store::decompose_path(path);
+  remote->write_base<fifo_queue_type>(partition_, decomposed.second);
+  if (decomposed.first == "local" && ls_store_ != nullptr) {
+    ls_store_->discard(decomposed.second);
+  }
+  deltas_.reset(path);
+  synced_size_ = partition_.size();
+  sync_base_ = false;
+  base_begin_ = partition_.begin_offset();
+}
+
+void fifo_queue_partition::snapshot_base(const std::string &path) {
+  auto snap = std::make_shared<data_snapshot<fifo_queue_type>>();
+  snap->data.reset(new fifo_queue_type(partition_.max_offset(), snap->build_allocator<char>()));
+  snap->data->copy_layout(partition_);
+  auto size = partition_.size();
+  deltas_.reset(path);
+  synced_size_ = size;
+  sync_base_ = false;
+  base_begin_ = partition_.begin_offset();
+  auto ser = ser_;
+  auto ls_store = ls_store_;
+  auto extent_size = extent_region::EXTENT_SIZE;
+  start_snapshot((size + extent_size - 1) / extent_size, [this, snap, size, extent_size](std::size_t extent) {
+    auto offset = extent * extent_size;
+    snap->data->copy_from(partition_, offset, std::min(extent_size, size - offset));
+  }, size, [ser, path, snap, ls_store] {
+    auto remote = persistent::persistent_store::instance(path, ser);
+    auto decomposed = persistent::persistent_store::decompose_path(path);
+    remote->write_base<fifo_queue_type>(*snap->data, decomposed.second);
+    if (decomposed.first == "local" && ls_store != nullptr) {
+      ls_store->discard(decomposed.second);
+    }
+  });
+}
+
 void fifo_queue_partition::forward_all() {
   for (auto it = partition_.begin(); it != partition_.end(); it++) {
     std::vector<std::string> ignore;
@@ -545,6 +662,9 @@ void fifo_queue_partition::update_rate() {
 
 void fifo_queue_partition::clear_partition() {
   partition_.clear();
+  synced_size_ = 0;
+  sync_base_ = true;
+  base_begin_ = 0;
   head_ = 0;
   scaling_up_ = false;
   scaling_down_ = false;
@@ -568,6 +688,20 @@ void fifo_queue_partition::clear_partition() {
   out_rate_ = 0;
 }
 
+void fifo_queue_partition::release_dequeued() {
+  auto extent_size = extent_region::EXTENT_SIZE;
+  if (head_ / extent_size == partition_.begin_offset() / extent_size || !sole_borrower()) {
+    return;
+  }
+  // A base image still being copied holds the released items
+  snapshot_copy_.preserve_bytes(0, head_, extent_size);
+  partition_.release_before(head_);
+  if (synced_size_ < head_) {
+    // Items that were never synced are gone, so the next delta would not extend the persisted queue
+    sync_base_ = true;
+  }
+}
+
 REGISTER_IMPLEMENTATION("fifoqueue", fifo_queue_partition);
 
 }
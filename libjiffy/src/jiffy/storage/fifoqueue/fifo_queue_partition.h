@@ -1,13 +1,17 @@
 #ifndef JIFFY_FIFO_QUEUE_SERVICE_SHARD_H
 #define JIFFY_FIFO_QUEUE_SERVICE_SHARD_H
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <jiffy/utils/property_map.h>
 #include "../serde/serde_all.h"
 #include "jiffy/storage/partition.h"
 #include "jiffy/persistent/persistent_service.h"
+#include "jiffy/persistent/task_queue.h"
 #include "jiffy/storage/chain_module.h"
 #include "fifo_queue_defs.h"
+#include "fifo_queue_segment_store.h"
 #include "jiffy/directory/directory_ops.h"
 #include "jiffy/utils/time_utils.h"
 
@@ -70,14 +74,21 @@ class fifo_queue_partition : public chain_module {
   void dequeue(response &_return, const arg_list &args);
 
   /**
-   * @brief Enqueue a new item to the fifo queue
-   * @param item New message
-   * @return Enqueue return status string
+   * @brief Dequeue an item from the fifo queue, borrowing it from partition memory
+   * @param _return Response
+   * @param args Arguments
+   */
+  void dequeue(response_view &_return, const arg_list &args);
+
+  /**
+   * @brief Enqueue one or more new items to the on-disk fifo queue
+   * @param _return Response
+   * @param args Arguments
    */
   void enqueue_ls(response &_return, const arg_list &args);
 
   /**
-   * @brief Dequeue an item from the fifo queue
+   * @brief Dequeue items from the on-disk fifo queue, one unless a count is given
    * @param _return Response
    * @param args Arguments
    */
@@ -90,8 +101,15 @@ class fifo_queue_partition : public chain_module {
    */
   void read_next(response &_return, const arg_list &args);
 
+  /**
+   * @brief Fetch an item without dequeue, borrowing it from partition memory
+   * @param _return Response
+   * @param args Arguments
+   */
+  void read_next(response_view &_return, const arg_list &args);
+
 /**
-   * @brief Fetch an item without dequeue
+   * @brief Fetch items from the on-disk fifo queue without dequeue, one unless a count is given
    * @param _return Response
    * @param args Arguments
    */
@@ -139,6 +157,13 @@ class fifo_queue_partition : public chain_module {
    */
   void front(response &_return, const arg_list &args);
 
+  /**
+   * @brief Fetch the item at the head of the queue, borrowing it from partition memory
+   * @param _return Response
+   * @param args Arguments
+   */
+  void front(response_view &_return, const arg_list &args);
+
   /**
    * @brief Run particular command on fifo queue partition
    * @param _return Response
@@ -146,6 +171,22 @@ class fifo_queue_partition : public chain_module {
    */
   void run_command(response &_return, const arg_list &args) override;
 
+  /**
+   * @brief Run particular command on fifo queue partition, borrowing items from partition memory
+   * @param _return Response
+   * @param args Arguments
+   */
+  void run_command_view(response_view &_return, const arg_list &args) override;
+
+  /**
+   * @brief Run the *_ls commands on a background task queue, since they wait for the disk
+   * The commands of the partition keep their order among themselves
+   * @param args Operation arguments
+   * @param done Called with the response on the task queue
+   * @return Bool value, true for the *_ls commands
+   */
+  bool run_command_async(const arg_list &args, std::function<void(const response &)> done) override;
+
   /**
    * @brief Atomically check dirty bit
    * @return Bool value, true if block is dirty
@@ -153,20 +194,29 @@ class fifo_queue_partition : public chain_module {
   bool is_dirty() const;
 
   /**
-   * @brief Load persistent data into the block
+   * @brief Load persistent data into the block, replaying the deltas of the base image
    * @param path Persistent storage path
    */
   void load(const std::string &path) override;
 
   /**
-   * @brief If dirty, synchronize persistent storage and block
+   * @brief If dirty, capture the block and persist it on the snapshot writer
+   * Only the items enqueued since the previous snapshot are written as a delta, unless the deltas
+   * outgrow fifoqueue.sync_max_deltas or fifoqueue.sync_delta_ratio
+   * @param path Persistent storage path
+   * @return Bool value, true if block successfully captured
+   */
+  bool snapshot(const std::string &path) override;
+
+  /**
+   * @brief If dirty, synchronize persistent storage and block, waiting for the snapshot to be written
    * @param path Persistent storage path
    * @return Bool value, true if block successfully synchronized
    */
   bool sync(const std::string &path) override;
 
   /**
-   * @brief Flush the block if dirty and clear the block
+   * @brief Flush the block as a single base image if dirty or extended by deltas and clear the block
    * @param path Persistent storage path
    * @return Bool value, true if block successfully dumped
    */
@@ -217,7 +267,7 @@ class fifo_queue_partition : public chain_module {
    */
   bool update_read_head_index() {
     if (read_head_index_ < head_index_) {
-      read_head_index_ = head_index_;
+      read_head_index_ = head_index_.load();
       return true;
     }
     return false;
@@ -228,20 +278,83 @@ class fifo_queue_partition : public chain_module {
    */
   void update_rate();
 
+  /**
+   * @brief Fetch the local path of the file the *_ls commands operate on
+   * @return File path
+   */
+  std::string ls_path() const;
+
+  /**
+   * @brief Run a *_ls command on the segment store
+   * @param _return Response
+   * @param args Arguments
+   * @param path File the command operates on
+   */
+  void run_ls(response &_return, const arg_list &args, const std::string &path);
+
+  /**
+   * @brief Mark partition dirty and trigger auto scaling after a command
+   * @param cmd_name Command name
+   * @param result Command result; borrowed items are copied before auto scaling starts
+   */
+  void after_command(const std::string &cmd_name, response_view *result = nullptr);
+
   /**
    * @brief Clear the partition
    */
   void clear_partition();
 
+  /**
+   * @brief Return the whole extents before the message at the head to the block, once the head has
+   * crossed an extent boundary and no other response may still borrow them
+   */
+  void release_dequeued();
+
+  /**
+   * @brief Collect the items enqueued since the previous sync
+   * @return Delta with one record, identified by the size of the queue read from the base image and the
+   * previous deltas, and holding the items
+   */
+  persistent::delta make_delta() const;
+
+  /**
+   * @brief Enqueue the items of a delta
+   * @param d Delta
+   */
+  void apply_delta(const persistent::delta &d);
+
+  /**
+   * @brief Write the whole block as the base image of a path and drop its deltas
+   * @param path Persistent storage path
+   */
+  void write_base(const std::string &path);
+
+  /**
+   * @brief Capture the queue while frozen, starting a base image or persisting a delta
+   * @param path Persistent storage path
+   * @return Bool value, true if queue successfully captured
+   */
+  bool capture_snapshot(const std::string &path);
+
+  /**
+   * @brief Start copying the queue one extent at a time, to be persisted as the base image of a path;
+   * enqueues only write past the copied bytes, so only clearing the queue has to preserve them
+   * @param path Persistent storage path
+   */
+  void snapshot_base(const std::string &path);
+
   /* Fifo queue partition */
   fifo_queue_type partition_;
 
   /* Custom serializer/deserializer */
   std::shared_ptr<serde> ser_;
 
-  /* Name of format, either binary or csv */
+  /* Name of format: csv, binary, binary_lz4, binary_zstd or indexed */
   std::string ser_name_;
 
+  /* Segmented on-disk queue for the *_ls commands, shared with snapshot jobs; null for compressed and indexed formats */
+  std::shared_ptr<fifo_queue_segment_store> ls_store_;
+
   /* Bool for overload partition */
   bool scaling_up_;
 
@@ -251,6 +364,18 @@ class fifo_queue_partition : public chain_module {
   /* Partition dirty bit */
   bool dirty_;
 
+  /* Size of the queue data up to the previous sync, later items go to the next delta */
+  std::size_t synced_size_;
+
+  /* Bool value, true if the next sync rewrites the base image */
+  bool sync_base_;
+
+  /* Offset of the first item of the base image, the items before it were released when it was written */
+  std::size_t base_begin_;
+
+  /* Deltas extending the base image */
+  persistent::delta_log deltas_;
+
   /* Bool value for auto scaling */
   bool auto_scale_;
 
@@ -266,14 +391,14 @@ class fifo_queue_partition : public chain_module {
   /* Head position of queue */
   std::size_t head_;
 
-  /* Head index of queue */
-  std::size_t head_index_;
+  /* Head index of queue, also advanced by the *_ls commands on the task queue */
+  std::atomic<std::size_t> head_index_;
 
   /* Head position for read next operation */
   std::size_t read_head_;
 
-  /* Head index for read next operation */
-  std::size_t read_head_index_;
+  /* Head index for read next operation, also advanced by the *_ls commands on the task queue */
+  std::atomic<std::size_t> read_head_index_;
 
   /* Boolean indicating whether enqueues are redirected to the next chain */
   bool enqueue_redirected_;
@@ -284,11 +409,11 @@ class fifo_queue_partition : public chain_module {
   /* Boolean indicating whether readnexts are redirected to the next chain */
   bool readnext_redirected_;
 
-  /* Number of elements inserted in the queue */
-  std::size_t enqueue_data_size_;
+  /* Number of elements inserted in the queue, also counted by the *_ls commands on the task queue */
+  std::atomic<std::size_t> enqueue_data_size_;
 
-  /* Number of elements removed from the queue */
-  std::size_t dequeue_data_size_;
+  /* Number of elements removed from the queue, also counted by the *_ls commands on the task queue */
+  std::atomic<std::size_t> dequeue_data_size_;
 
   /* Total number of elements from all of the previous partitions */
   std::size_t prev_data_size_;
@@ -326,6 +451,8 @@ class fifo_queue_partition : public chain_module {
   /* Periodicity for rate calculation in microseconds */
   std::size_t periodicity_us_;
 
+  /* Runs the *_ls commands of the tail, declared last so that they finish before other members are destroyed */
+  persistent::task_queue ls_queue_;
 };
 
 }
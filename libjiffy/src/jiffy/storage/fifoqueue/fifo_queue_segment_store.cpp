@@ -0,0 +1,331 @@
+#include "fifo_queue_segment_store.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace jiffy {
+namespace storage {
+
+/* Cursor file layout: head segment, head offset, head "_offset" file offset, tail segment */
+static const std::size_t CURSOR_FIELDS = 4;
+
+/**
+ * @brief Check if a file exists
+ * @param path File path
+ * @return Bool value, true if the file exists
+ */
+static bool file_exists(const std::string &path) {
+  std::ifstream in(path);
+  return in.good();
+}
+
+/**
+ * @brief Read a cursor file
+ * @param path Cursor file path
+ * @param fields Cursor fields
+ * @return Bool value, true if the cursor file exists and is complete
+ */
+static bool read_cursor_file(const std::string &path, std::uint64_t (&fields)[CURSOR_FIELDS]) {
+  std::ifstream in(path, std::ios::binary);
+  in.read(reinterpret_cast<char *>(fields), sizeof(fields));
+  return static_cast<bool>(in);
+}
+
+fifo_queue_segment_store::fifo_queue_segment_store(const std::string &format, std::size_t segment_size)
+    : format_(format),
+      segment_size_(segment_size),
+      tail_segment_(0),
+      tail_bytes_(0) {
+  if (format_ != "csv" && format_ != "binary") {
+    throw std::invalid_argument("No such segment store format " + format_);
+  }
+}
+
+bool fifo_queue_segment_store::open(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (path_ == path) {
+    return true;
+  }
+  return open_locked(path);
+}
+
+void fifo_queue_segment_store::enqueue(const std::vector<std::string> &msgs, std::size_t begin) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  bool new_segment = false;
+  for (auto i = begin; i < msgs.size(); ++i) {
+    std::size_t msg_size = msgs[i].size();
+    auto record_size = sizeof(size_t) + msg_size;
+    if (tail_segment_ == 0 || (tail_bytes_ > 0 && tail_bytes_ + record_size > segment_size_)) {
+      tail_out_.close();
+      ++tail_segment_;
+      tail_out_.clear();
+      tail_out_.open(segment_path(path_, tail_segment_), std::ios::binary | std::ios::trunc);
+      tail_bytes_ = 0;
+      new_segment = true;
+    }
+    tail_out_.write(reinterpret_cast<const char *>(&msg_size), sizeof(size_t));
+    tail_out_.write(msgs[i].data(), msg_size);
+    tail_bytes_ += record_size;
+  }
+  tail_out_.flush();
+  if (!tail_out_) {
+    throw std::runtime_error("Failed to append to " + segment_path(path_, tail_segment_));
+  }
+  if (new_segment) {
+    persist_cursor();
+  }
+}
+
+std::size_t fifo_queue_segment_store::dequeue(std::size_t max_count, std::vector<std::string> &msgs) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto first_segment = head_.segment;
+  std::size_t count = 0;
+  std::string msg;
+  while (count < max_count && read_message(head_, msg)) {
+    msgs.push_back(std::move(msg));
+    ++count;
+  }
+  if (count == 0 && head_.segment == first_segment) {
+    return 0;
+  }
+  persist_cursor();
+  // Segments the head moved past are fully consumed
+  for (auto segment = std::max<std::uint64_t>(first_segment, 1); segment < head_.segment; ++segment) {
+    std::remove(segment_path(path_, segment).c_str());
+  }
+  if (read_.segment < head_.segment || (read_.segment == head_.segment && read_.offset < head_.offset)) {
+    seek(read_, head_);
+  }
+  return count;
+}
+
+std::size_t fifo_queue_segment_store::read_next(std::size_t max_count, std::vector<std::string> &msgs) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  std::size_t count = 0;
+  std::string msg;
+  while (count < max_count && read_message(read_, msg)) {
+    msgs.push_back(std::move(msg));
+    ++count;
+  }
+  return count;
+}
+
+void fifo_queue_segment_store::flush(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (path_ != path) {
+    if (!file_exists(cursor_path(path)) || !open_locked(path)) {
+      return;
+    }
+  }
+  auto tmp_path = path + ".flush";
+  {
+    std::ofstream out(tmp_path, std::ios::binary);
+    std::ofstream offset_out;
+    if (format_ == "binary") {
+      offset_out.open(tmp_path + "_offset", std::ios::binary);
+    }
+    cursor c;
+    seek(c, head_);
+    std::string msg;
+    while (read_message(c, msg)) {
+      std::size_t msg_size = msg.size();
+      if (format_ == "csv") {
+        out.write(msg.data(), msg_size);
+        out.put('\n');
+      } else {
+        offset_out.write(reinterpret_cast<const char *>(&msg_size), sizeof(size_t));
+        out.write(msg.data(), msg_size);
+      }
+    }
+    out.flush();
+    offset_out.flush();
+    if (!out || (format_ == "binary" && !offset_out)) {
+      throw std::runtime_error("Failed to write " + tmp_path);
+    }
+  }
+  auto head_segment = head_.segment;
+  auto tail_segment = tail_segment_;
+  close_locked();
+  std::rename(tmp_path.c_str(), path.c_str());
+  if (format_ == "binary") {
+    std::rename((tmp_path + "_offset").c_str(), (path + "_offset").c_str());
+  }
+  for (auto segment = std::max<std::uint64_t>(head_segment, 1); segment <= tail_segment; ++segment) {
+    std::remove(segment_path(path, segment).c_str());
+  }
+  std::remove(cursor_path(path).c_str());
+}
+
+void fifo_queue_segment_store::discard(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  std::uint64_t head_segment = 0;
+  std::uint64_t tail_segment = 0;
+  if (path_ == path) {
+    head_segment = head_.segment;
+    tail_segment = tail_segment_;
+    close_locked();
+  } else {
+    std::uint64_t fields[CURSOR_FIELDS];
+    if (read_cursor_file(cursor_path(path), fields)) {
+      head_segment = fields[0];
+      tail_segment = fields[3];
+    }
+  }
+  while (file_exists(segment_path(path, tail_segment + 1))) {
+    ++tail_segment;
+  }
+  for (auto segment = std::max<std::uint64_t>(head_segment, 1); segment <= tail_segment; ++segment) {
+    std::remove(segment_path(path, segment).c_str());
+  }
+  std::remove(cursor_path(path).c_str());
+}
+
+std::string fifo_queue_segment_store::segment_path(const std::string &path, std::uint64_t segment) {
+  return path + "_segment_" + std::to_string(segment);
+}
+
+std::string fifo_queue_segment_store::cursor_path(const std::string &path) {
+  return path + "_cursor";
+}
+
+void fifo_queue_segment_store::close_locked() {
+  seek(head_, cursor());
+  seek(read_, cursor());
+  tail_out_.close();
+  cursor_out_.close();
+  path_.clear();
+  tail_segment_ = 0;
+  tail_bytes_ = 0;
+}
+
+bool fifo_queue_segment_store::open_locked(const std::string &path) {
+  close_locked();
+  // Create the queue file if it does not exist
+  {
+    std::ofstream out(path, std::ios::app);
+    if (!out) {
+      return false;
+    }
+  }
+  if (format_ == "binary") {
+    std::ofstream offset_out(path + "_offset", std::ios::app);
+    if (!offset_out) {
+      return false;
+    }
+  }
+  path_ = path;
+  std::uint64_t fields[CURSOR_FIELDS] = {0, 0, 0, 0};
+  if (!read_cursor_file(cursor_path(path_), fields)) {
+    std::fill(std::begin(fields), std::end(fields), 0);
+  }
+  head_.segment = fields[0];
+  head_.offset = fields[1];
+  head_.index_offset = fields[2];
+  tail_segment_ = fields[3];
+  // A segment may have been started after the cursor was last written
+  while (file_exists(segment_path(path_, tail_segment_ + 1))) {
+    ++tail_segment_;
+  }
+  if (tail_segment_ > 0) {
+    auto tail_path = segment_path(path_, tail_segment_);
+    std::ifstream tail_in(tail_path, std::ios::binary | std::ios::ate);
+    tail_bytes_ = tail_in ? static_cast<std::uint64_t>(tail_in.tellg()) : 0;
+    tail_out_.clear();
+    tail_out_.open(tail_path, std::ios::binary | std::ios::app);
+  }
+  seek(read_, head_);
+  {
+    std::ofstream create(cursor_path(path_), std::ios::binary | std::ios::app);
+  }
+  cursor_out_.clear();
+  cursor_out_.open(cursor_path(path_), std::ios::binary | std::ios::in | std::ios::out);
+  persist_cursor();
+  return true;
+}
+
+void fifo_queue_segment_store::seek(cursor &c, const cursor &from) {
+  c.segment = from.segment;
+  c.offset = from.offset;
+  c.index_offset = from.index_offset;
+  c.in.close();
+  c.index_in.close();
+  c.open_segment = UINT64_MAX;
+}
+
+bool fifo_queue_segment_store::read_message(cursor &c, std::string &msg) {
+  while (true) {
+    if (c.open_segment != c.segment) {
+      c.in.close();
+      c.index_in.close();
+      if (c.segment == 0) {
+        c.in.open(path_, std::ios::binary);
+        if (format_ == "binary") {
+          c.index_in.open(path_ + "_offset", std::ios::binary);
+        }
+      } else {
+        c.in.open(segment_path(path_, c.segment), std::ios::binary);
+      }
+      c.open_segment = c.segment;
+    }
+    if (read_in_segment(c, msg)) {
+      return true;
+    }
+    if (c.segment >= tail_segment_) {
+      return false;
+    }
+    ++c.segment;
+    c.offset = 0;
+    c.index_offset = 0;
+  }
+}
+
+bool fifo_queue_segment_store::read_in_segment(cursor &c, std::string &msg) {
+  c.in.clear();
+  c.in.seekg(static_cast<std::streamoff>(c.offset), std::ios::beg);
+  std::size_t msg_size = 0;
+  if (c.segment == 0 && format_ == "csv") {
+    // Only complete lines are messages
+    if (!std::getline(c.in, msg) || c.in.eof()) {
+      return false;
+    }
+    c.offset += msg.size() + 1;
+    return true;
+  }
+  if (c.segment == 0) {
+    c.index_in.clear();
+    c.index_in.seekg(static_cast<std::streamoff>(c.index_offset), std::ios::beg);
+    if (!c.index_in.read(reinterpret_cast<char *>(&msg_size), sizeof(msg_size))) {
+      return false;
+    }
+    msg.resize(msg_size);
+    if (!c.in.read(&msg[0], msg_size)) {
+      return false;
+    }
+    c.index_offset += sizeof(msg_size);
+    c.offset += msg_size;
+    return true;
+  }
+  if (!c.in.read(reinterpret_cast<char *>(&msg_size), sizeof(msg_size))) {
+    return false;
+  }
+  msg.resize(msg_size);
+  if (!c.in.read(&msg[0], msg_size)) {
+    return false;
+  }
+  c.offset += sizeof(msg_size) + msg_size;
+  return true;
+}
+
+void fifo_queue_segment_store::persist_cursor() {
+  std::uint64_t fields[CURSOR_FIELDS] = {head_.segment, head_.offset, head_.index_offset, tail_segment_};
+  cursor_out_.clear();
+  cursor_out_.seekp(0, std::ios::beg);
+  cursor_out_.write(reinterpret_cast<const char *>(fields), sizeof(fields));
+  cursor_out_.flush();
+  if (!cursor_out_) {
+    throw std::runtime_error("Failed to write " + cursor_path(path_));
+  }
+}
+
+}
+}
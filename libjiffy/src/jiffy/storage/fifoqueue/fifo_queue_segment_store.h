@@ -0,0 +1,184 @@
+#ifndef JIFFY_FIFO_QUEUE_SEGMENT_STORE_H
+#define JIFFY_FIFO_QUEUE_SEGMENT_STORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace jiffy {
+namespace storage {
+
+/**
+ * @brief Segmented on-disk queue behind the fifo queue *_ls commands.
+ *
+ * Segment 0 is the file written by syncing the partition, in the partition's serializer format
+ * (csv, or binary with its "_offset" file). Enqueued messages are appended to numbered segment files
+ * next to it ("<path>_segment_<n>"), each holding length-prefixed messages and rolling over to the
+ * next segment once it reaches the segment size. The head cursor is persisted in "<path>_cursor" on
+ * every dequeue, and segments are deleted as soon as the head moves past them, so enqueue, dequeue
+ * and read next only touch the messages they return.
+ */
+class fifo_queue_segment_store {
+ public:
+  /**
+   * @brief Constructor
+   * @param format Segment 0 format, either csv or binary
+   * @param segment_size Size at which a segment is closed and a new one started
+   */
+  fifo_queue_segment_store(const std::string &format, std::size_t segment_size);
+
+  fifo_queue_segment_store(const fifo_queue_segment_store &) = delete;
+  fifo_queue_segment_store &operator=(const fifo_queue_segment_store &) = delete;
+
+  /**
+   * @brief Open the store on a queue file, restoring the persisted cursors if it is not open on that file yet
+   * The queue file is created if it does not exist
+   * @param path Queue file path
+   * @return Bool value, false if the queue file could not be created
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief Append messages to the tail of the queue
+   * @param msgs Messages
+   * @param begin Index of the first message to append
+   */
+  void enqueue(const std::vector<std::string> &msgs, std::size_t begin = 0);
+
+  /**
+   * @brief Remove messages from the head of the queue
+   * @param max_count Maximum number of messages to remove
+   * @param msgs Removed messages are appended here
+   * @return Number of messages removed
+   */
+  std::size_t dequeue(std::size_t max_count, std::vector<std::string> &msgs);
+
+  /**
+   * @brief Read the messages following the last message read without removing them
+   * @param max_count Maximum number of messages to read
+   * @param msgs Messages read are appended here
+   * @return Number of messages read
+   */
+  std::size_t read_next(std::size_t max_count, std::vector<std::string> &msgs);
+
+  /**
+   * @brief Rewrite a queue file with the messages left in the queue and drop its segments
+   * @param path Queue file path
+   */
+  void flush(const std::string &path);
+
+  /**
+   * @brief Drop the segments and cursors of a queue file after the queue file was rewritten
+   * @param path Queue file path
+   */
+  void discard(const std::string &path);
+
+  /**
+   * @brief Fetch the path of a segment
+   * @param path Queue file path
+   * @param segment Segment number, at least 1
+   * @return Segment path
+   */
+  static std::string segment_path(const std::string &path, std::uint64_t segment);
+
+  /**
+   * @brief Fetch the cursor path of a queue file
+   * @param path Queue file path
+   * @return Cursor path
+   */
+  static std::string cursor_path(const std::string &path);
+
+ private:
+  /* Position in the queue, with the streams of the segment it points into */
+  struct cursor {
+    /* Segment number */
+    std::uint64_t segment = 0;
+    /* Message offset in the segment */
+    std::uint64_t offset = 0;
+    /* Size offset in the "_offset" file, for a binary segment 0 */
+    std::uint64_t index_offset = 0;
+    /* Segment the streams are open on */
+    std::uint64_t open_segment = UINT64_MAX;
+    /* Segment stream */
+    std::ifstream in;
+    /* "_offset" file stream, for a binary segment 0 */
+    std::ifstream index_in;
+  };
+
+  /**
+   * @brief Close files and reset cursors, mutex must be held
+   */
+  void close_locked();
+
+  /**
+   * @brief Open the store on a queue file, mutex must be held
+   * @param path Queue file path
+   * @return Bool value, false if the queue file could not be created
+   */
+  bool open_locked(const std::string &path);
+
+  /**
+   * @brief Move a cursor to the position of another one
+   * @param c Cursor
+   * @param from Cursor to copy the position from
+   */
+  static void seek(cursor &c, const cursor &from);
+
+  /**
+   * @brief Read the message at a cursor and advance it, moving on to the next segment at the end of one
+   * @param c Cursor
+   * @param msg Message
+   * @return Bool value, false if the cursor is at the tail of the queue
+   */
+  bool read_message(cursor &c, std::string &msg);
+
+  /**
+   * @brief Read the message at a cursor within its segment and advance it
+   * @param c Cursor
+   * @param msg Message
+   * @return Bool value, false if the cursor is at the end of its segment
+   */
+  bool read_in_segment(cursor &c, std::string &msg);
+
+  /**
+   * @brief Write the head cursor and tail segment to the cursor file
+   */
+  void persist_cursor();
+
+  /* Segment 0 format, either csv or binary */
+  std::string format_;
+
+  /* Segment size */
+  std::size_t segment_size_;
+
+  /* Queue file path, empty if not open */
+  std::string path_;
+
+  /* Dequeue cursor */
+  cursor head_;
+
+  /* Read next cursor */
+  cursor read_;
+
+  /* Segment enqueued messages are appended to, 0 if none was started */
+  std::uint64_t tail_segment_;
+
+  /* Size of the tail segment */
+  std::uint64_t tail_bytes_;
+
+  /* Tail segment append stream */
+  std::ofstream tail_out_;
+
+  /* Cursor file stream */
+  std::fstream cursor_out_;
+
+  /* Mutex */
+  std::mutex mtx_;
+};
+
+}
+}
+
+#endif //JIFFY_FIFO_QUEUE_SEGMENT_STORE_H
@@ -5,52 +5,53 @@ namespace jiffy {
 namespace storage {
 using namespace utils;
 
-string_array::string_array(std::size_t max_size, block_memory_allocator<char> alloc) : alloc_(alloc), max_(max_size) {
-  data_ = alloc_.allocate(max_);
+string_array::string_array(std::size_t max_size, block_memory_allocator<char> alloc)
+    : region_(std::make_shared<extent_region>(max_size, alloc.manager())), max_(max_size) {
+  data_ = region_->data();
   tail_ = 0;
   last_element_offset_ = 0;
   split_string_ = false;
 }
 
-string_array::~string_array() {
-  alloc_.deallocate(data_, max_);
-}
+string_array::~string_array() = default;
 
 string_array::string_array(const string_array &other) {
-  alloc_ = other.alloc_;
+  region_ = other.region_;
   max_ = other.max_;
   data_ = other.data_;
   tail_ = other.tail_;
   split_string_ = other.split_string_;
   last_element_offset_ = other.last_element_offset_;
+  begin_ = other.begin_;
 }
 
 string_array &string_array::operator=(const string_array &other) {
-  alloc_ = other.alloc_;
+  region_ = other.region_;
   max_ = other.max_;
   data_ = other.data_;
   tail_ = other.tail_;
   last_element_offset_ = other.last_element_offset_;
   split_string_ = other.split_string_;
+  begin_ = other.begin_;
   return *this;
 }
 
 bool string_array::operator==(const string_array &other) const {
-  return data_ == other.data_ && tail_ == other.tail_ && alloc_ == other.alloc_ && max_ == other.max_
+  return region_ == other.region_ && tail_ == other.tail_ && max_ == other.max_
       && last_element_offset_ == other.last_element_offset_
-      && split_string_ == other.split_string_;
+      && split_string_ == other.split_string_ && begin_ == other.begin_;
 }
 
 std::pair<bool, std::string> string_array::push_back(const std::string &item) {
   auto len = item.size();
   if (len + tail_ + METADATA_LEN <= max_ && !split_string_) { // Complete item will be written
     // Write length
-    std::memcpy(data_ + tail_, (char *) &len, METADATA_LEN);
+    region_->write(tail_, (char *) &len, METADATA_LEN);
     last_element_offset_ = tail_;
     tail_ += METADATA_LEN;
 
     // Write data
-    std::memcpy(data_ + tail_, item.c_str(), len);
+    region_->write(tail_, item.data(), len);
     tail_ += len;
     return std::make_pair(true, std::string("!success"));
   } else { // Item will not be written, full item will be returned
@@ -60,13 +61,18 @@ std::pair<bool, std::string> string_array::push_back(const std::string &item) {
 }
 
 const std::pair<bool, std::string> string_array::at(std::size_t offset) const {
+  auto ret = at_span(offset);
+  return std::make_pair(ret.first, std::string(ret.second.data, ret.second.size));
+}
+
+const std::pair<bool, byte_span> string_array::at_span(std::size_t offset) const {
   if (offset > last_element_offset_ || empty()) {
     if (split_string_)
-      return std::make_pair(false, "");
-    return std::make_pair(false, std::string("!not_available"));
+      return std::make_pair(false, borrow("", 0));
+    return std::make_pair(false, borrow("!not_available", 14));
   }
   auto len = *((std::size_t * )(data_ + offset));
-  return std::make_pair(true, std::string(data_ + offset + METADATA_LEN, len));
+  return std::make_pair(true, borrow(data_ + offset + METADATA_LEN, len));
 }
 
 std::size_t string_array::find_next(std::size_t offset) const {
@@ -87,8 +93,35 @@ std::size_t string_array::capacity() {
 }
 
 void string_array::clear() {
+  region_->clear();
   tail_ = 0;
   last_element_offset_ = 0;
+  begin_ = 0;
+}
+
+std::size_t string_array::committed() const {
+  return region_->committed();
+}
+
+void string_array::release_before(std::size_t offset) {
+  // Only extents entirely before the offset are released, the extent holding begin_ may now be one
+  auto extent_begin = begin_ / extent_region::EXTENT_SIZE * extent_region::EXTENT_SIZE;
+  region_->release(extent_begin, offset - extent_begin);
+  begin_ = offset;
+}
+
+std::size_t string_array::begin_offset() const {
+  return begin_;
+}
+
+void string_array::copy_layout(const string_array &other) {
+  begin_ = other.begin_;
+  tail_ = other.tail_;
+  last_element_offset_ = other.last_element_offset_;
+}
+
+void string_array::copy_from(const string_array &other, std::size_t offset, std::size_t len) {
+  region_->copy_from(*other.region_, offset, len);
 }
 
 bool string_array::empty() const {
@@ -96,7 +129,7 @@ bool string_array::empty() const {
 }
 
 string_array::iterator string_array::begin() {
-  return string_array::iterator(*this, 0);
+  return string_array::iterator(*this, begin_ < tail_ ? begin_ : max_);
 }
 
 string_array::iterator string_array::end() {
@@ -108,7 +141,7 @@ std::size_t string_array::max_offset() const {
 }
 
 string_array::const_iterator string_array::begin() const {
-  return string_array::const_iterator(*this, 0);
+  return string_array::const_iterator(*this, begin_ < tail_ ? begin_ : max_);
 }
 
 string_array::const_iterator string_array::end() const {
@@ -5,8 +5,11 @@
 #include <cstring>
 #include <vector>
 #include <map>
+#include <memory>
 #include <iterator>
 #include "jiffy/storage/block_memory_allocator.h"
+#include "jiffy/storage/extent_region.h"
+#include "jiffy/storage/response_view.h"
 
 namespace jiffy {
 namespace storage {
@@ -87,6 +90,13 @@ class string_array {
    */
   const std::pair<bool, std::string> at(std::size_t offset) const;
 
+  /**
+   * @brief Borrow string at offset without copying it
+   * @param offset Read offset
+   * @param Pair, a status boolean and the borrowed string
+   */
+  const std::pair<bool, byte_span> at_span(std::size_t offset) const;
+
   /**
    * @brief Find next string for the given offset string
    * @param offset Offset of the current string
@@ -113,10 +123,44 @@ class string_array {
   std::size_t capacity();
 
   /**
-   * @brief Clear the content of string array
+   * @brief Clear the content of string array, returning its memory to the block
    */
   void clear();
 
+  /**
+   * @brief Fetch the number of bytes of the string array backed by memory
+   * @return Committed bytes
+   */
+  std::size_t committed() const;
+
+  /**
+   * @brief Drop the strings before an offset, returning the whole extents they occupy to the block
+   * The strings are no longer iterated over; offsets of the remaining strings do not change.
+   * @param offset Offset of a string, at least begin_offset()
+   */
+  void release_before(std::size_t offset);
+
+  /**
+   * @brief Fetch the offset of the first string that was not dropped
+   * @return Begin offset
+   */
+  std::size_t begin_offset() const;
+
+  /**
+   * @brief Take the begin, tail and element offsets of another string array, whose bytes are then copied
+   * with copy_from()
+   * @param other Another string array
+   */
+  void copy_layout(const string_array &other);
+
+  /**
+   * @brief Copy a range of another string array's bytes, skipping the parts never written in either
+   * @param other Another string array
+   * @param offset Range offset
+   * @param len Range length
+   */
+  void copy_from(const string_array &other, std::size_t offset, std::size_t len);
+
   /**
    * @brief Check if string array is empty
    * @return Boolean, true if empty
@@ -166,12 +210,15 @@ class string_array {
   std::size_t num_elements() const;
 
  private:
-  /* Block memory allocator */
-  block_memory_allocator<char> alloc_;
+  /* Memory region, committed in extents as strings are pushed */
+  std::shared_ptr<extent_region> region_;
 
   /* Offset of the last element */
   std::size_t last_element_offset_;
 
+  /* Offset of the first string that was not dropped */
+  std::size_t begin_{};
+
   /* Maximum capacity */
   std::size_t max_{};
 
@@ -1,46 +1,50 @@
 #include "file_block.h"
+#include <algorithm>
 #include "jiffy/utils/logger.h"
 
 namespace jiffy {
 namespace storage {
 using namespace utils;
 
-file_block::file_block(std::size_t max_size, block_memory_allocator<char> alloc) : alloc_(alloc), max_(max_size) {
-  data_ = alloc_.allocate(max_);
+file_block::file_block(std::size_t max_size, block_memory_allocator<char> alloc)
+    : region_(std::make_shared<extent_region>(max_size, alloc.manager())), max_(max_size) {
+  data_ = region_->data();
 }
 
-file_block::~file_block() {
-  alloc_.deallocate(data_, max_);
-}
+file_block::~file_block() = default;
 
 file_block::file_block(const file_block &other) {
-  alloc_ = other.alloc_;
+  region_ = other.region_;
   max_ = other.max_;
   data_ = other.data_;
 }
 
 file_block &file_block::operator=(const file_block &other) {
-  alloc_ = other.alloc_;
+  region_ = other.region_;
   max_ = other.max_;
   data_ = other.data_;
   return *this;
 }
 
 bool file_block::operator==(const file_block &other) const {
-  return data_ == other.data_ && alloc_ == other.alloc_ && max_ == other.max_;
+  return region_ == other.region_ && max_ == other.max_;
 }
 
 std::pair<bool, std::string> file_block::write(const std::string &data, std::size_t offset) {
-  auto len = data.size();
-  std::memcpy(data_ + offset, data.c_str(), len);
+  region_->write(offset, data.data(), data.size());
   return std::make_pair(true, std::string("!success"));
 }
 
 const std::pair<bool, std::string> file_block::read(std::size_t offset, std::size_t size) const {
+  auto span = read_span(offset, size).second;
+  return std::make_pair(true, std::string(span.data, span.size));
+}
+
+const std::pair<bool, byte_span> file_block::read_span(std::size_t offset, std::size_t size) const {
   if (offset >= max_) {
     throw std::invalid_argument("Read offset exceeds partition capacity");
   }
-  return std::make_pair(true, std::string(data_ + offset, size));
+  return std::make_pair(true, borrow(data_ + offset, std::min(size, max_ - offset)));
 }
 
 std::size_t file_block::size() const {
@@ -48,15 +52,21 @@ std::size_t file_block::size() const {
 }
 
 void file_block::clear() {
-  for (std::size_t i = 0; i < max_; i++) {
-    data_[i] = 0;
-  }
+  region_->clear();
 }
 
 char *file_block::data() const {
   return data_;
 }
 
+std::size_t file_block::committed() const {
+  return region_->committed();
+}
+
+void file_block::copy_from(const file_block &other, std::size_t offset, std::size_t size) {
+  region_->copy_from(*other.region_, offset, size);
+}
+
 }
 }
 
@@ -5,8 +5,11 @@
 #include <cstring>
 #include <vector>
 #include <map>
+#include <memory>
 #include <iterator>
 #include "jiffy/storage/block_memory_allocator.h"
+#include "jiffy/storage/extent_region.h"
+#include "jiffy/storage/response_view.h"
 
 namespace jiffy {
 namespace storage {
@@ -82,6 +85,15 @@ class file_block {
 
   const std::pair<bool, std::string> read(std::size_t offset, std::size_t size) const;
 
+  /**
+   * @brief Borrow bytes at offset with given size, without copying them
+   * @param offset Read offset
+   * @param size Size to read, truncated to the end of the block
+   * @return Pair, a status boolean and the borrowed bytes
+   */
+
+  const std::pair<bool, byte_span> read_span(std::size_t offset, std::size_t size) const;
+
   /**
    * @brief Fetch total size of the block
    * @return Size
@@ -102,9 +114,25 @@ class file_block {
 
   char *data() const;
 
+  /**
+   * @brief Fetch the number of bytes of the block backed by memory
+   * @return Committed bytes
+   */
+
+  std::size_t committed() const;
+
+  /**
+   * @brief Copy a range of another block, skipping the parts never written in either block
+   * @param other Another block
+   * @param offset Range offset
+   * @param size Number of bytes to copy
+   */
+
+  void copy_from(const file_block &other, std::size_t offset, std::size_t size);
+
  private:
-  /* Block memory allocator */
-  block_memory_allocator<char> alloc_;
+  /* Memory region, committed in extents as it is written */
+  std::shared_ptr<extent_region> region_;
 
   /* Maximum capacity */
   std::size_t max_{};
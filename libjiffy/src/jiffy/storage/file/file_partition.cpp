@@ -4,6 +4,10 @@
 #include "jiffy/storage/file/file_ops.h"
 #include "jiffy/auto_scaling/auto_scaling_client.h"
 #include <jiffy/utils/directory_utils.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <future>
 #include <thread>
 
 namespace jiffy {
@@ -22,18 +26,38 @@ file_partition::file_partition(block_memory_manager *manager,
       partition_(manager->mb_capacity(), build_allocator<char>()),
       scaling_up_(false),
       dirty_(false),
+      page_size_(std::max<std::size_t>(conf.get_as<std::size_t>("file.sync_page_size", 65536), 1)),
+      dirty_pages_((partition_.size() + page_size_ - 1) / page_size_),
+      deltas_(conf.get_as<std::size_t>("file.sync_max_deltas", 16), conf.get_as<double>("file.sync_delta_ratio", 0.5)),
       block_allocated_(false),
       auto_scaling_host_(auto_scaling_host),
       auto_scaling_port_(auto_scaling_port) {
   ser_name_ = conf.get("file.serializer", "csv");
   if (ser_name_ == "binary") {
     ser_ = std::make_shared<binary_serde>(binary_allocator_);
+  } else if (ser_name_ == "binary_lz4") {
+    ser_ = std::make_shared<binary_serde>(binary_allocator_, persistent::codec::make("lz4"));
+  } else if (ser_name_ == "binary_zstd") {
+    ser_ = std::make_shared<binary_serde>(binary_allocator_, persistent::codec::make("zstd"));
+  } else if (ser_name_ == "indexed") {
+    ser_ = std::make_shared<indexed_serde>(binary_allocator_);
   } else if (ser_name_ == "csv") {
     ser_ = std::make_shared<csv_serde>(binary_allocator_);
   } else {
     throw std::invalid_argument("No such serializer/deserializer " + ser_name_);
   }
   auto_scale_ = conf.get_as<bool>("file.auto_scale", true);
+  // The *_ls commands read and write the file in place, which compressed and indexed files do not allow
+  if (ser_name_ == "csv" || ser_name_ == "binary") {
+    ls_file_ = std::make_shared<local_file>();
+  }
+}
+
+file_partition::~file_partition() {
+  // Snapshot jobs may keep the local file alive, pending *_ls commands must not outlive the partition
+  if (ls_file_ != nullptr) {
+    ls_file_->close();
+  }
 }
 
 void file_partition::write(response &_return, const arg_list &args) {
@@ -41,6 +65,9 @@ void file_partition::write(response &_return, const arg_list &args) {
     RETURN_ERR("!args_error");
   }
   auto off = std::stoi(args[2]);
+  if (off >= 0) {
+    snapshot_copy_.preserve_bytes(static_cast<std::size_t>(off), args[1].size(), extent_region::EXTENT_SIZE);
+  }
   auto ret = partition_.write(args[1], off);
   if (!ret.first) {
     throw std::logic_error("Write failed");
@@ -61,13 +88,19 @@ void file_partition::write(response &_return, const arg_list &args) {
 }
 
 void file_partition::read(response &_return, const arg_list &args) {
+  response_view view;
+  read(view, args);
+  _return = view.to_response();
+}
+
+void file_partition::read(response_view &_return, const arg_list &args) {
   if (args.size() != 3) {
     RETURN_ERR("!args_error");
   }
   auto pos = std::stoi(args[1]);
   auto size = std::stoi(args[2]);
   if (pos < 0) throw std::invalid_argument("read position invalid");
-  auto ret = partition_.read(static_cast<std::size_t>(pos), static_cast<std::size_t>(size));
+  auto ret = partition_.read_span(static_cast<std::size_t>(pos), static_cast<std::size_t>(size));
   if (ret.first) {
     RETURN_OK(ret.second);
   }
@@ -75,75 +108,113 @@ void file_partition::read(response &_return, const arg_list &args) {
 }
 
 void file_partition::write_ls(response &_return, const arg_list &args) {
+  wait_ls(_return, [&](std::function<void(const response &)> done) {
+    write_ls(args, done);
+  });
+}
+
+void file_partition::write_ls(const arg_list &args, const std::function<void(const response &)> &done) {
   if (args.size() != 5 && args.size() != 3) {
-    RETURN_ERR("!args_error");
+    done({"!args_error"});
+    return;
   }
-  std::string file_path, data;
-  int pos = std::stoi(args[2]);
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path,name());
-  std::ofstream out(file_path,std::ios::in|std::ios::out);
-  if (out) {
-    data = args[1];
-    out.seekp(pos, std::ios::beg);
-    out << data;
-    out.close();
-    if (args.size() == 5) {
-      int cache_block_size = std::stoi(args[3]);
-      int last_offset = std::stoi(args[4]) + args[1].size();
-      int start_offset = (int(pos)) / cache_block_size * cache_block_size;
-      int end_offset = (int(pos) + args[1].size() - 1) / cache_block_size * cache_block_size;
-      int num_of_blocks = (end_offset - start_offset) / cache_block_size + 1;
-      int size = std::min(last_offset - start_offset, cache_block_size * num_of_blocks);
-      std::string ret_str;
-      std::ifstream in(file_path,std::ios::in);
-      in.seekg(0, std::ios::end);
-      in.seekg(start_offset, std::ios::beg);
-      char *ret = new char[size];
-      in.read(ret,size);
-      ret_str = ret;
-      memset(ret,0,size);
-      delete[] ret;
-      RETURN_OK(ret_str);
-    }
-    RETURN_OK();  
+  if (ls_file_ == nullptr) {
+    done({"!unsupported_serializer"});
+    return;
   }
-  else {
-    RETURN_ERR("!file_does_not_exist");
+  int pos = std::stoi(args[2]);
+  if (pos < 0) throw std::invalid_argument("write position invalid");
+  auto file_path = ls_path();
+  if (args.size() == 3) {
+    ls_file_->write(file_path, static_cast<std::size_t>(pos), args[1], [done](int error) {
+      done(error == 0 ? response{"!ok"} : ls_error(error));
+    });
+    return;
   }
+  // Respond with the cache blocks the write touched
+  int cache_block_size = std::stoi(args[3]);
+  int last_offset = std::stoi(args[4]) + args[1].size();
+  int start_offset = (int(pos)) / cache_block_size * cache_block_size;
+  int end_offset = (int(pos) + args[1].size() - 1) / cache_block_size * cache_block_size;
+  int num_of_blocks = (end_offset - start_offset) / cache_block_size + 1;
+  int size = std::min(last_offset - start_offset, cache_block_size * num_of_blocks);
+  ls_file_->write(file_path, static_cast<std::size_t>(pos), args[1], [this, done, file_path, start_offset, size](int error) {
+    if (error != 0) {
+      done(ls_error(error));
+      return;
+    }
+    ls_file_->read(file_path, static_cast<std::size_t>(start_offset), static_cast<std::size_t>(size),
+                  [done](int error, std::string &data) {
+                    if (error != 0) {
+                      done(ls_error(error));
+                      return;
+                    }
+                    response result;
+                    result.emplace_back("!ok");
+                    result.push_back(std::move(data));
+                    done(result);
+                  });
+  });
 }
 
 void file_partition::read_ls(response &_return, const arg_list &args) {
+  wait_ls(_return, [&](std::function<void(const response &)> done) {
+    read_ls(args, done);
+  });
+}
+
+void file_partition::read_ls(const arg_list &args, const std::function<void(const response &)> &done) {
   if (args.size() != 3) {
-    RETURN_ERR("!args_error");
+    done({"!args_error"});
+    return;
+  }
+  if (ls_file_ == nullptr) {
+    done({"!unsupported_serializer"});
+    return;
   }
-  std::string file_path, ret_str;
   auto pos = std::stoi(args[1]);
   auto size = std::stoi(args[2]);
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path,name());
-  std::ifstream in(file_path,std::ios::in);
-  if (in) {
-    if (pos < 0) throw std::invalid_argument("read position invalid");
-    in.seekg(0, std::ios::end);
-    in.seekg(pos, std::ios::beg);
-    char *ret = new char[size];
-    in.read(ret,size);
-    ret_str = ret;
-    memset(ret,0,size);
-    delete[] ret;
-    RETURN_OK(ret_str);
-  }
-  else {
-    RETURN_ERR("file_does_not_exist");
+  if (pos < 0) throw std::invalid_argument("read position invalid");
+  ls_file_->read(ls_path(), static_cast<std::size_t>(pos), static_cast<std::size_t>(size),
+                [done](int error, std::string &data) {
+                  if (error != 0) {
+                    done(ls_error(error));
+                    return;
+                  }
+                  response result;
+                  result.emplace_back("!ok");
+                  result.push_back(std::move(data));
+                  done(result);
+                });
+}
+
+void file_partition::wait_ls(response &_return, const std::function<void(std::function<void(const response &)>)> &run) {
+  auto result = std::make_shared<std::promise<response>>();
+  auto future = result->get_future();
+  run([result](const response &resp) {
+    result->set_value(resp);
+  });
+  _return = future.get();
+}
+
+response file_partition::ls_error(int error) {
+  if (error == ENOENT) {
+    return {"!file_does_not_exist"};
   }
+  return {"!io_error", std::strerror(error)};
+}
 
+std::string file_partition::ls_path() const {
+  auto file_path = directory_utils::remove_uri(backing_path());
+  directory_utils::push_path_element(file_path, name());
+  return file_path;
 }
 
 void file_partition::clear(response &_return, const arg_list &args) {
   if (args.size() != 1) {
     RETURN_ERR("!args_error");
   }
+  snapshot_copy_.preserve_all();
   partition_.clear();
   scaling_up_ = false;
   dirty_ = false;
@@ -214,6 +285,28 @@ void file_partition::run_command(response &_return, const arg_list &args) {
   }
   if (is_mutator(cmd_name)) {
     dirty_ = true;
+    mark_dirty(args);
+  }
+}
+
+bool file_partition::run_command_async(const arg_list &args, std::function<void(const response &)> done) {
+  switch (command_id(args[0])) {
+    case file_cmd_id::file_write_ls:write_ls(args, done);
+      dirty_ = true;
+      mark_dirty(args);
+      return true;
+    case file_cmd_id::file_read_ls:read_ls(args, done);
+      return true;
+    default:return false;
+  }
+}
+
+void file_partition::run_command_view(response_view &_return, const arg_list &args) {
+  switch (command_id(args[0])) {
+    case file_cmd_id::file_read:read(_return, args);
+      break;
+    default:partition::run_command_view(_return, args);
+      break;
   }
 }
 
@@ -226,30 +319,83 @@ bool file_partition::is_dirty() const {
 }
 
 void file_partition::load(const std::string &path) {
+  // Snapshots of the path by any partition must land before it is read
+  persistent::snapshot_writer::instance()->wait_all();
   auto remote = persistent::persistent_store::instance(path, ser_);
   auto decomposed = persistent::persistent_store::decompose_path(path);
+  // A base image replaced up to a crash is either finished or left untouched
+  remote->recover_base(decomposed.second);
   remote->read<file_type>(decomposed.second, partition_);
+  auto replayed = remote->replay_deltas(decomposed.second, [this](const persistent::delta &d) {
+    apply_delta(d);
+  });
+  deltas_.reset(path, replayed.first, replayed.second);
+  dirty_pages_.clear();
 }
 
-bool file_partition::sync(const std::string &path) {
+bool file_partition::snapshot(const std::string &path) {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mtx_);
+  auto synced = capture_snapshot(path);
+  // A base image is copied one extent at a time while commands write other extents
+  finish_snapshot();
+  return synced;
+}
+
+bool file_partition::capture_snapshot(const std::string &path) {
+  freeze_guard freeze(*this);
+  if (!freeze.frozen()) {
+    LOG(log_level::warn) << "Commands on partition " << name() << " did not drain, skipping snapshot";
+    return false;
+  }
+  if (snapshot_failed()) {
+    dirty_ = true;
+    dirty_pages_.add_all();
+  }
   if (dirty_) {
-    auto remote = persistent::persistent_store::instance(path, ser_);
-    auto decomposed = persistent::persistent_store::decompose_path(path);
-    remote->write<file_type>(partition_, decomposed.second);
+    bool synced = true;
+    if (dirty_pages_.all()) {
+      snapshot_base(path);
+    } else if (dirty_pages_.empty()) {
+      synced = false;
+    } else {
+      auto d = std::make_shared<persistent::delta>(make_delta());
+      auto delta_bytes = persistent::delta_size(*d);
+      if (deltas_.can_append(path, delta_bytes, partition_.size())) {
+        auto seq = deltas_.append(delta_bytes);
+        auto ser = ser_;
+        persist(delta_bytes, [ser, path, d, seq] {
+          auto remote = persistent::persistent_store::instance(path, ser);
+          auto decomposed = persistent::persistent_store::decompose_path(path);
+          remote->write_delta(*d, decomposed.second, seq);
+        });
+      } else {
+        snapshot_base(path);
+      }
+    }
+    dirty_pages_.clear();
     dirty_ = false;
-    return true;
+    return synced;
   }
   return false;
 }
 
+bool file_partition::sync(const std::string &path) {
+  auto synced = snapshot(path);
+  wait_snapshots();
+  return synced;
+}
+
 bool file_partition::dump(const std::string &path) {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mtx_);
+  wait_snapshots();
   bool flushed = false;
-  if (dirty_) {
-    auto remote = persistent::persistent_store::instance(path, ser_);
-    auto decomposed = persistent::persistent_store::decompose_path(path);
-    remote->write<file_type>(partition_, decomposed.second);
+  // The *_ls commands only read the base image, so fold deltas into it as well
+  if (dirty_ || deltas_.num_deltas() > 0) {
+    write_base(path);
     flushed = true;
   }
+  dirty_pages_.clear();
+  deltas_.clear();
   partition_.clear();
   next_->reset("nil");
   path_ = "";
@@ -261,6 +407,76 @@ bool file_partition::dump(const std::string &path) {
   return flushed;
 }
 
+void file_partition::mark_dirty(const arg_list &args) {
+  switch (command_id(args[0])) {
+    case file_cmd_id::file_write:
+      if (args.size() >= 3 && !args[1].empty()) {
+        auto offset = static_cast<std::size_t>(std::max(std::stoi(args[2]), 0));
+        dirty_pages_.add_range(offset / page_size_, (offset + args[1].size() + page_size_ - 1) / page_size_);
+      }
+      break;
+    case file_cmd_id::file_update_partition:
+      break;
+    default:
+      // clear empties the whole file and write_ls changes the base image underneath the deltas
+      dirty_pages_.add_all();
+      break;
+  }
+}
+
+persistent::delta file_partition::make_delta() const {
+  persistent::delta d;
+  for (auto page: dirty_pages_.units()) {
+    auto offset = page * page_size_;
+    auto size = std::min(page_size_, partition_.size() - offset);
+    d.push_back(persistent::delta_record{page, {std::string(partition_.data() + offset, size)}});
+  }
+  return d;
+}
+
+void file_partition::apply_delta(const persistent::delta &d) {
+  for (const auto &r: d) {
+    auto offset = static_cast<std::size_t>(r.id) * page_size_;
+    if (!r.items.empty() && offset + r.items.front().size() <= partition_.size()) {
+      partition_.write(r.items.front(), offset);
+    }
+  }
+}
+
+void file_partition::write_base(const std::string &path) {
+  auto remote = persistent::persistent_store::instance(path, ser_);
+  auto decomposed = persistent::persistent_store::decompose_path(path);
+  remote->write_base<file_type>(partition_, decomposed.second);
+  // The file may have been replaced, reopen it on the next *_ls command
+  if (ls_file_ != nullptr) {
+    ls_file_->close();
+  }
+  deltas_.reset(path);
+}
+
+void file_partition::snapshot_base(const std::string &path) {
+  auto snap = std::make_shared<data_snapshot<file_type>>();
+  auto size = partition_.size();
+  snap->data.reset(new file_type(size, snap->build_allocator<char>()));
+  deltas_.reset(path);
+  auto ser = ser_;
+  auto ls_file = ls_file_;
+  auto extent_size = extent_region::EXTENT_SIZE;
+  // Only the parts of the file ever written are copied, the rest of the copy reads as zeros
+  start_snapshot((size + extent_size - 1) / extent_size, [this, snap, size, extent_size](std::size_t extent) {
+    auto offset = extent * extent_size;
+    snap->data->copy_from(partition_, offset, std::min(extent_size, size - offset));
+  }, size, [ser, path, snap, ls_file] {
+    auto remote = persistent::persistent_store::instance(path, ser);
+    auto decomposed = persistent::persistent_store::decompose_path(path);
+    remote->write_base<file_type>(*snap->data, decomposed.second);
+    // The file may have been replaced, reopen it on the next *_ls command
+    if (ls_file != nullptr) {
+      ls_file->close();
+    }
+  });
+}
+
 void file_partition::forward_all() {
   std::vector<std::string> result;
   run_command_on_next(result, {"write", std::string(partition_.data(), partition_.size())});
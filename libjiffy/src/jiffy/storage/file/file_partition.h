@@ -8,6 +8,7 @@
 #include "jiffy/persistent/persistent_service.h"
 #include "jiffy/storage/chain_module.h"
 #include "file_defs.h"
+#include "local_file.h"
 #include "jiffy/directory/directory_ops.h"
 
 namespace jiffy {
@@ -38,7 +39,7 @@ class file_partition : public chain_module {
   /**
    * @brief Virtual destructor
    */
-  ~file_partition() override = default;
+  ~file_partition() override;
 
   /**
    * @brief Fetch block size
@@ -60,6 +61,13 @@ class file_partition : public chain_module {
    */
   void read(response &_return, const arg_list &args);
 
+  /**
+   * @brief Read data from the file, borrowing it from partition memory
+   * @param _return Response
+   * @param args Arguments
+   */
+  void read(response_view &_return, const arg_list &args);
+
   /**
    * @brief Write data to the file
    * @param _return Response
@@ -67,6 +75,13 @@ class file_partition : public chain_module {
    */
   void write_ls(response &_return, const arg_list &args);
 
+  /**
+   * @brief Write data to the file asynchronously
+   * @param args Arguments
+   * @param done Called with the response once the write completes
+   */
+  void write_ls(const arg_list &args, const std::function<void(const response &)> &done);
+
   /**
    * @brief Read data from the file
    * @param _return Response
@@ -74,6 +89,13 @@ class file_partition : public chain_module {
    */
   void read_ls(response &_return, const arg_list &args);
 
+  /**
+   * @brief Read data from the file asynchronously
+   * @param args Arguments
+   * @param done Called with the response once the read completes
+   */
+  void read_ls(const arg_list &args, const std::function<void(const response &)> &done);
+
   /**
    * @brief Clear the file
    * @param _return Response
@@ -109,6 +131,21 @@ class file_partition : public chain_module {
    */
   void run_command(response &_return, const arg_list &args) override;
 
+  /**
+   * @brief Run command on file partition, borrowing read data from partition memory
+   * @param _return Response
+   * @param args Arguments
+   */
+  void run_command_view(response_view &_return, const arg_list &args) override;
+
+  /**
+   * @brief Run the *_ls commands on file partition asynchronously, completing them when their disk I/O finishes
+   * @param args Arguments
+   * @param done Called with the response once the command completes
+   * @return Bool value, false if the command does not run asynchronously
+   */
+  bool run_command_async(const arg_list &args, std::function<void(const response &)> done) override;
+
   /**
    * @brief Atomically check dirty bit
    * @return Bool value, true if block is dirty
@@ -116,20 +153,29 @@ class file_partition : public chain_module {
   bool is_dirty() const;
 
   /**
-   * @brief Load persistent data into the block
+   * @brief Load persistent data into the block, replaying the deltas of the base image
    * @param path Persistent storage path
    */
   void load(const std::string &path) override;
 
   /**
-   * @brief If dirty, synchronize persistent storage and block
+   * @brief If dirty, capture the block and persist it on the snapshot writer
+   * Only the pages of file.sync_page_size bytes written since the previous snapshot are written as a
+   * delta, unless the deltas outgrow file.sync_max_deltas or file.sync_delta_ratio
+   * @param path Persistent storage path
+   * @return Bool value, true if block successfully captured
+   */
+  bool snapshot(const std::string &path) override;
+
+  /**
+   * @brief If dirty, synchronize persistent storage and block, waiting for the snapshot to be written
    * @param path Persistent storage path
    * @return Bool value, true if block successfully synchronized
    */
   bool sync(const std::string &path) override;
 
   /**
-   * @brief Flush the block if dirty and clear the block
+   * @brief Flush the block as a single base image if dirty or extended by deltas and clear the block
    * @param path Persistent storage path
    * @return Bool value, true if block successfully dumped
    */
@@ -141,6 +187,62 @@ class file_partition : public chain_module {
   void forward_all() override;
 
  private:
+  /**
+   * @brief Mark the pages a mutator command touched dirty
+   * @param args Command arguments
+   */
+  void mark_dirty(const arg_list &args);
+
+  /**
+   * @brief Collect the dirty pages
+   * @return Delta with one record per dirty page, holding its data
+   */
+  persistent::delta make_delta() const;
+
+  /**
+   * @brief Write the pages of a delta
+   * @param d Delta
+   */
+  void apply_delta(const persistent::delta &d);
+
+  /**
+   * @brief Write the whole block as the base image of a path and drop its deltas
+   * @param path Persistent storage path
+   */
+  void write_base(const std::string &path);
+
+  /**
+   * @brief Capture the block while frozen, starting a base image or persisting a delta
+   * @param path Persistent storage path
+   * @return Bool value, true if block successfully captured
+   */
+  bool capture_snapshot(const std::string &path);
+
+  /**
+   * @brief Start copying the block one extent at a time, to be persisted as the base image of a path
+   * @param path Persistent storage path
+   */
+  void snapshot_base(const std::string &path);
+
+  /**
+   * @brief Fetch the local path of the file the *_ls commands operate on
+   * @return File path
+   */
+  std::string ls_path() const;
+
+  /**
+   * @brief Run an asynchronous *_ls command and wait for its response
+   * @param _return Response
+   * @param run Runs the command, given the completion callback
+   */
+  static void wait_ls(response &_return, const std::function<void(std::function<void(const response &)>)> &run);
+
+  /**
+   * @brief Fetch the response for a failed *_ls command
+   * @param error Errno value
+   * @return Response
+   */
+  static response ls_error(int error);
 
   /* File partition */
   file_type partition_;
@@ -148,15 +250,24 @@ class file_partition : public chain_module {
   /* Custom serializer/deserializer */
   std::shared_ptr<serde> ser_;
 
-  /* Name of format, either binary or csv */
+  /* Name of format: csv, binary, binary_lz4, binary_zstd or indexed */
   std::string ser_name_;
-  
+
   /* Bool for partition slot range splitting */
   bool scaling_up_;
 
   /* Partition dirty bit */
   bool dirty_;
 
+  /* Page size of the deltas */
+  std::size_t page_size_;
+
+  /* Pages written since the previous sync */
+  persistent::dirty_set dirty_pages_;
+
+  /* Deltas extending the base image */
+  persistent::delta_log deltas_;
+
   /* Bool to indicate if block is successfully allocated */
   bool block_allocated_;
 
@@ -171,6 +282,8 @@ class file_partition : public chain_module {
 
   std::vector<std::string> allocated_blocks_;
 
+  /* Local file for the *_ls commands, shared with snapshot jobs; null for compressed and indexed formats */
+  std::shared_ptr<local_file> ls_file_;
 };
 
 }
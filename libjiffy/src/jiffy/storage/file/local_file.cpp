@@ -0,0 +1,188 @@
+#include "local_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <future>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace jiffy {
+namespace storage {
+
+using namespace persistent;
+
+/* Maximum number of operations handed to the I/O engine at once */
+static const std::size_t MAX_BATCH_OPS = 64;
+
+local_file::local_file(std::shared_ptr<io_engine> engine) : engine_(std::move(engine)) {}
+
+local_file::~local_file() {
+  close();
+}
+
+void local_file::read(const std::string &path, std::size_t offset, std::size_t size, read_callback callback) {
+  std::unique_ptr<operation> op(new operation{io_op::read, path, offset, size, std::string(), std::move(callback),
+                                              nullptr});
+  enqueue(std::move(op));
+}
+
+void local_file::write(const std::string &path, std::size_t offset, std::string data, write_callback callback) {
+  auto size = data.size();
+  std::unique_ptr<operation> op(new operation{io_op::write, path, offset, size, std::move(data), nullptr,
+                                              std::move(callback)});
+  enqueue(std::move(op));
+}
+
+bool local_file::read(const std::string &path, std::size_t offset, std::size_t size, std::string &data) {
+  auto result = std::make_shared<std::promise<int>>();
+  auto future = result->get_future();
+  std::unique_ptr<operation> op(new operation{io_op::read, path, offset, size, std::string(),
+                                              [result, &data](int error, std::string &read_data) {
+                                                if (error == 0) {
+                                                  data.swap(read_data);
+                                                }
+                                                result->set_value(error);
+                                              }, nullptr});
+  enqueue(std::move(op), true);
+  auto error = future.get();
+  if (error == ENOENT) {
+    return false;
+  }
+  if (error != 0) {
+    throw std::runtime_error("Failed to read " + path + ": " + std::strerror(error));
+  }
+  return true;
+}
+
+bool local_file::write(const std::string &path, std::size_t offset, const std::string &data) {
+  auto result = std::make_shared<std::promise<int>>();
+  auto future = result->get_future();
+  std::unique_ptr<operation> op(new operation{io_op::write, path, offset, data.size(), data, nullptr,
+                                              [result](int error) {
+                                                result->set_value(error);
+                                              }});
+  enqueue(std::move(op), true);
+  auto error = future.get();
+  if (error == ENOENT) {
+    return false;
+  }
+  if (error != 0) {
+    throw std::runtime_error("Failed to write " + path + ": " + std::strerror(error));
+  }
+  return true;
+}
+
+void local_file::close() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  idle_cv_.wait(lock, [this] { return num_running_ == 0 && queue_.empty(); });
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  path_.clear();
+}
+
+void local_file::enqueue(std::unique_ptr<operation> op, bool run_inline) {
+  std::vector<io_request> batch;
+  std::vector<std::unique_ptr<operation>> failed;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    queue_.push_back(std::move(op));
+    if (num_running_ == 0) {
+      next_batch_locked(batch, failed);
+    }
+  }
+  for (auto &f: failed) {
+    finish(*f, ENOENT);
+  }
+  if (run_inline && batch.size() == 1) {
+    // Only this operation was queued; the caller blocks on it anyway, so skip the engine round trip
+    batch[0].callback(io_engine::transfer(batch[0]));
+    return;
+  }
+  if (!batch.empty()) {
+    engine_->submit(batch);
+  }
+}
+
+void local_file::next_batch_locked(std::vector<io_request> &batch, std::vector<std::unique_ptr<operation>> &failed) {
+  // The descriptor is only switched while no batch is running
+  while (!queue_.empty() && (fd_ < 0 || path_ != queue_.front()->path)) {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    path_ = queue_.front()->path;
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd_ < 0) {
+      path_.clear();
+      failed.push_back(std::move(queue_.front()));
+      queue_.pop_front();
+    }
+  }
+  std::vector<operation *> ops;
+  while (!queue_.empty() && queue_.front()->path == path_ && ops.size() < MAX_BATCH_OPS) {
+    auto op = queue_.front().get();
+    bool conflict = false;
+    for (auto other: ops) {
+      bool overlap = op->offset < other->offset + other->size && other->offset < op->offset + op->size;
+      if (overlap && (op->op == io_op::write || other->op == io_op::write)) {
+        conflict = true;
+        break;
+      }
+    }
+    if (conflict) {
+      break;
+    }
+    ops.push_back(queue_.front().release());
+    queue_.pop_front();
+  }
+  for (auto op: ops) {
+    if (op->op == io_op::read) {
+      op->data.resize(op->size);
+    }
+    batch.push_back(io_request{op->op, fd_, &op->data[0], op->size, op->offset, [this, op](std::int64_t n) {
+      complete(op, n);
+    }});
+  }
+  num_running_ = ops.size();
+  if (num_running_ == 0 && queue_.empty()) {
+    idle_cv_.notify_all();
+  }
+}
+
+void local_file::complete(operation *op, std::int64_t result) {
+  std::unique_ptr<operation> done(op);
+  if (result >= 0 && done->op == io_op::read) {
+    done->data.resize(static_cast<std::size_t>(result));
+  }
+  // Operations queued by the callback wait for the next batch
+  finish(*done, result < 0 ? static_cast<int>(-result) : 0);
+  std::vector<io_request> batch;
+  std::vector<std::unique_ptr<operation>> failed;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (--num_running_ == 0) {
+      next_batch_locked(batch, failed);
+    }
+  }
+  for (auto &f: failed) {
+    finish(*f, ENOENT);
+  }
+  if (!batch.empty()) {
+    engine_->submit(batch);
+  }
+}
+
+void local_file::finish(operation &op, int error) {
+  if (op.op == io_op::read) {
+    if (error != 0) {
+      op.data.clear();
+    }
+    op.on_read(error, op.data);
+  } else {
+    op.on_write(error);
+  }
+}
+
+}
+}
@@ -0,0 +1,159 @@
+#ifndef JIFFY_LOCAL_FILE_H
+#define JIFFY_LOCAL_FILE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "jiffy/persistent/io_engine.h"
+
+namespace jiffy {
+namespace storage {
+
+/**
+ * @brief Local file accessed through one cached descriptor with asynchronous positional I/O.
+ *
+ * The descriptor is opened on first access and kept until the file changes or the object is
+ * closed. Reads and writes are queued and handed to the I/O engine in batches: each batch takes
+ * queued operations in order for as long as none of them overlaps a write in the batch, so
+ * operations on the same bytes complete in the order they were issued. Data is read straight into
+ * the string handed to the callback. Waiting reads and writes that find nothing else queued skip
+ * the engine and run on the calling thread.
+ */
+class local_file {
+ public:
+  /* Called with 0 or an errno value, ENOENT if the file cannot be opened, and the data read */
+  typedef std::function<void(int, std::string &)> read_callback;
+  /* Called with 0 or an errno value, ENOENT if the file cannot be opened */
+  typedef std::function<void(int)> write_callback;
+
+  /**
+   * @brief Constructor
+   * @param engine I/O engine
+   */
+  explicit local_file(std::shared_ptr<persistent::io_engine> engine = persistent::io_engine::instance());
+
+  /**
+   * @brief Destructor, waits for queued operations and closes the descriptor
+   */
+  ~local_file();
+
+  local_file(const local_file &) = delete;
+  local_file &operator=(const local_file &) = delete;
+
+  /**
+   * @brief Read from the file asynchronously
+   * @param path File path, the descriptor is reopened if it differs from the cached one
+   * @param offset Read offset
+   * @param size Number of bytes to read
+   * @param callback Called on an I/O engine thread once the read completes, or right away if the file cannot be
+   * opened; the data is shorter than size if the file ends before offset + size
+   */
+  void read(const std::string &path, std::size_t offset, std::size_t size, read_callback callback);
+
+  /**
+   * @brief Write to the file asynchronously
+   * @param path File path, the descriptor is reopened if it differs from the cached one
+   * @param offset Write offset
+   * @param data Data to write
+   * @param callback Called on an I/O engine thread once the write completes, or right away if the file cannot be
+   * opened
+   */
+  void write(const std::string &path, std::size_t offset, std::string data, write_callback callback);
+
+  /**
+   * @brief Read from the file and wait for the data
+   * @param path File path, the descriptor is reopened if it differs from the cached one
+   * @param offset Read offset
+   * @param size Number of bytes to read
+   * @param data Data read, shorter than size if the file ends before offset + size
+   * @return Bool value, false if the file does not exist
+   */
+  bool read(const std::string &path, std::size_t offset, std::size_t size, std::string &data);
+
+  /**
+   * @brief Write to the file and wait for the write to complete
+   * @param path File path, the descriptor is reopened if it differs from the cached one
+   * @param offset Write offset
+   * @param data Data to write
+   * @return Bool value, false if the file does not exist
+   */
+  bool write(const std::string &path, std::size_t offset, const std::string &data);
+
+  /**
+   * @brief Wait for queued operations and close the descriptor, e.g. after the file was replaced
+   */
+  void close();
+
+ private:
+  /* Queued read or write */
+  struct operation {
+    persistent::io_op op;
+    std::string path;
+    std::size_t offset;
+    std::size_t size;
+    /* Data to write, or buffer to read into */
+    std::string data;
+    read_callback on_read;
+    write_callback on_write;
+  };
+
+  /**
+   * @brief Queue an operation, starting a batch if none is running
+   * @param op Operation
+   * @param run_inline Transfer on the calling thread if nothing else is queued or running, for callers that
+   * wait for the operation anyway
+   */
+  void enqueue(std::unique_ptr<operation> op, bool run_inline = false);
+
+  /**
+   * @brief Take the next batch off the queue, mutex must be held and no batch running
+   * @param batch Requests of the batch
+   * @param failed Operations on a file that does not exist
+   */
+  void next_batch_locked(std::vector<persistent::io_request> &batch, std::vector<std::unique_ptr<operation>> &failed);
+
+  /**
+   * @brief Complete an operation of the running batch and start the next batch once it is done
+   * @param op Operation
+   * @param result Number of bytes transferred, or -errno on failure
+   */
+  void complete(operation *op, std::int64_t result);
+
+  /**
+   * @brief Run the callback of an operation
+   * @param op Operation
+   * @param error 0 or an errno value
+   */
+  static void finish(operation &op, int error);
+
+  /* I/O engine */
+  std::shared_ptr<persistent::io_engine> engine_;
+
+  /* Path of the open file */
+  std::string path_;
+
+  /* Descriptor, -1 if closed */
+  int fd_ = -1;
+
+  /* Queued operations */
+  std::deque<std::unique_ptr<operation>> queue_;
+
+  /* Number of operations of the running batch that have not completed */
+  std::size_t num_running_ = 0;
+
+  /* Mutex */
+  std::mutex mtx_;
+
+  /* Signalled when the queue drains */
+  std::condition_variable idle_cv_;
+};
+
+}
+}
+
+#endif //JIFFY_LOCAL_FILE_H
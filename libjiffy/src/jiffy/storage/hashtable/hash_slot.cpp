@@ -1,6 +1,12 @@
 #include <cstdint>
+#include <cstring>
 #include "hash_slot.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JIFFY_CRC16_CLMUL 1
+#include <immintrin.h>
+#endif
+
 namespace jiffy {
 namespace storage {
 
@@ -39,5 +45,115 @@ const uint16_t hash_slot::crc16tab[256] = {
     0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
 };
 
+namespace {
+
+/* Slicing-by-8 tables: table[k][b] is the crc of byte b followed by k zero bytes */
+struct crc16_slice8_tables {
+  uint16_t table[8][256];
+
+  explicit crc16_slice8_tables(const uint16_t *base) {
+    std::memcpy(table[0], base, sizeof(table[0]));
+    for (int k = 1; k < 8; ++k) {
+      for (int b = 0; b < 256; ++b) {
+        uint16_t prev = table[k - 1][b];
+        table[k][b] = static_cast<uint16_t>((prev << 8) ^ table[0][prev >> 8]);
+      }
+    }
+  }
+};
+
+const crc16_slice8_tables &slice8_tables(const uint16_t *base) {
+  static const crc16_slice8_tables tables(base);
+  return tables;
+}
+
+/* x^n mod P for the CRC16 polynomial P = x^16 + x^12 + x^5 + 1 */
+uint64_t x_pow_mod(int n) {
+  uint32_t r = 1;
+  for (int i = 0; i < n; ++i) {
+    r <<= 1;
+    if (r & 0x10000) r ^= 0x11021;
+  }
+  return r;
+}
+
+}
+
+uint16_t hash_slot::crc16_bytewise(const char *buf, size_t len) {
+  size_t counter;
+  uint16_t crc = 0;
+  for (counter = 0; counter < len; counter++)
+    crc = (crc << 8) ^ crc16tab[((crc >> 8) ^ *buf++) & 0x00FF];
+  return crc;
+}
+
+static uint16_t crc16_slice8_update(uint16_t crc, const uint8_t *p, size_t len, const uint16_t (*t)[256]) {
+  while (len >= 8) {
+    crc = t[7][(crc >> 8) ^ p[0]] ^ t[6][(crc & 0xFF) ^ p[1]] ^ t[5][p[2]] ^ t[4][p[3]]
+        ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    p += 8;
+    len -= 8;
+  }
+  while (len--)
+    crc = (crc << 8) ^ t[0][((crc >> 8) ^ *p++) & 0x00FF];
+  return crc;
+}
+
+uint16_t hash_slot::crc16_slice8(const char *buf, size_t len) {
+  return crc16_slice8_update(0, reinterpret_cast<const uint8_t *>(buf), len, slice8_tables(crc16tab).table);
+}
+
+#ifdef JIFFY_CRC16_CLMUL
+/*
+ * Folds 16 byte blocks with carry-less multiplication. Each block is byte reversed so that the
+ * first message bit is the highest coefficient; acc * x^128 + next is then reduced as
+ * hi * (x^192 mod P) + lo * (x^128 mod P) + next, which stays congruent to the message modulo P.
+ * The crc of the remaining 128 bit residue and the tail is computed with the slicing tables.
+ */
+__attribute__((target("pclmul,ssse3")))
+static uint16_t crc16_clmul_impl(const uint8_t *p, size_t len, const uint16_t (*t)[256]) {
+  static const uint64_t k192 = x_pow_mod(192);
+  static const uint64_t k128 = x_pow_mod(128);
+  const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  const __m128i k = _mm_set_epi64x(static_cast<long long>(k192), static_cast<long long>(k128));
+  __m128i acc = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), reverse);
+  p += 16;
+  len -= 16;
+  while (len >= 16) {
+    __m128i next = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), reverse);
+    acc = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(acc, k, 0x11), _mm_clmulepi64_si128(acc, k, 0x00)),
+                        next);
+    p += 16;
+    len -= 16;
+  }
+  uint8_t residue[16];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(residue), _mm_shuffle_epi8(acc, reverse));
+  uint16_t crc = crc16_slice8_update(0, residue, sizeof(residue), t);
+  return crc16_slice8_update(crc, p, len, t);
+}
+#endif
+
+uint16_t hash_slot::crc16_clmul(const char *buf, size_t len) {
+  const auto &tables = slice8_tables(crc16tab);
+#ifdef JIFFY_CRC16_CLMUL
+  if (len >= 32)
+    return crc16_clmul_impl(reinterpret_cast<const uint8_t *>(buf), len, tables.table);
+#endif
+  return crc16_slice8_update(0, reinterpret_cast<const uint8_t *>(buf), len, tables.table);
+}
+
+bool hash_slot::clmul_supported() {
+#ifdef JIFFY_CRC16_CLMUL
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+#else
+  return false;
+#endif
+}
+
+hash_slot::crc16_fn hash_slot::select_crc16() {
+  return clmul_supported() ? &hash_slot::crc16_clmul : &hash_slot::crc16_slice8;
+}
+
 }
 }
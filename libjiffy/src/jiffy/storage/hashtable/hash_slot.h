@@ -44,6 +44,7 @@
 #ifndef JIFFY_HASH_SLOT_H
 #define JIFFY_HASH_SLOT_H
 
+#include <cstdint>
 #include <string>
 #include "jiffy/storage/types/binary.h"
 
@@ -62,16 +63,31 @@ class hash_slot {
   static int32_t get(const binary &key) {
     return crc16(reinterpret_cast<const char *>(key.data()), key.size());
   }
- private:
-  /* Hash function */
+
+  /* Hash function; dispatches to the fastest implementation supported by the CPU */
   static uint16_t crc16(const char *buf, size_t len) {
-    size_t counter;
-    uint16_t crc = 0;
-    for (counter = 0; counter < len; counter++)
-      crc = (crc << 8) ^ crc16tab[((crc >> 8) ^ *buf++) & 0x00FF];
-    return crc;
+    static const crc16_fn fn = select_crc16();
+    return fn(buf, len);
   }
 
+  /* Byte-at-a-time table driven implementation */
+  static uint16_t crc16_bytewise(const char *buf, size_t len);
+
+  /* Slicing-by-8 implementation */
+  static uint16_t crc16_slice8(const char *buf, size_t len);
+
+  /* Carry-less multiplication (PCLMULQDQ) folding implementation; only valid if clmul_supported() */
+  static uint16_t crc16_clmul(const char *buf, size_t len);
+
+  /* Check if the CPU supports the carry-less multiplication implementation */
+  static bool clmul_supported();
+
+ private:
+  typedef uint16_t (*crc16_fn)(const char *, size_t);
+
+  /* Pick crc16 implementation at runtime */
+  static crc16_fn select_crc16();
+
   /* Hash function table */
   static const uint16_t crc16tab[256];
 
@@ -1,11 +1,16 @@
 #ifndef JIFFY_KV_HASH_H
 #define JIFFY_KV_HASH_H
 
+#include <algorithm>
 #include <functional>
 #include "libcuckoo/cuckoohash_map.hh"
 #include "jiffy/storage/block_memory_allocator.h"
 #include "jiffy/storage/types/binary.h"
+#include "jiffy/utils/hash_utils.h"
+#include "open_hash_table.h"
+#include "hash_slot.h"
 #include <unordered_map>
+#include <vector>
 
 namespace jiffy {
 namespace storage {
@@ -25,11 +30,7 @@ typedef std::pair<const key_type, value_type> kv_pair_type;
 struct hash_type {
   template<typename KeyType>
   std::size_t operator()(const KeyType &k) const {
-    std::size_t result = 0;
-    for (size_t i = 0; i < k.size(); i++) {
-      result = k[i] + (result * 31);
-    }
-    return result;
+    return static_cast<std::size_t>(utils::hash_utils::hash64(k.data(), k.size()));
   }
 };
 
@@ -40,8 +41,327 @@ struct equal_type {
   }
 };
 
+// Hash table index implementations
+enum hash_table_index_type : uint8_t {
+  chained_index = 0,
+  open_addressing_index = 1
+};
+
+/* Hash table index, backed by either a node based std::unordered_map or an open addressing table.
+ * Entries are also bucketed by hash slot, so that a slot range can be visited or dropped
+ * without scanning the whole table */
+class hash_table_index {
+ public:
+  typedef std::unordered_map<key_type, value_type, hash_type, equal_type> chained_table_type;
+  typedef open_hash_table<key_type, value_type, hash_type, equal_type> open_table_type;
+
+  template<typename ChainedIt, typename OpenIt, typename Ref, typename Ptr>
+  class basic_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef kv_pair_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Ptr pointer;
+    typedef Ref reference;
+
+    basic_iterator() : open_(false) {}
+
+    explicit basic_iterator(ChainedIt it) : open_(false), chained_it_(it) {}
+
+    explicit basic_iterator(OpenIt it) : open_(true), open_it_(it) {}
+
+    template<typename OtherChainedIt, typename OtherOpenIt, typename OtherRef, typename OtherPtr>
+    basic_iterator(const basic_iterator<OtherChainedIt, OtherOpenIt, OtherRef, OtherPtr> &other)
+        : open_(other.open_), chained_it_(other.chained_it_), open_it_(other.open_it_) {}
+
+    Ref operator*() const {
+      return open_ ? *open_it_ : *chained_it_;
+    }
+
+    Ptr operator->() const {
+      return &(**this);
+    }
+
+    basic_iterator &operator++() {
+      if (open_) {
+        ++open_it_;
+      } else {
+        ++chained_it_;
+      }
+      return *this;
+    }
+
+    basic_iterator operator++(int) {
+      basic_iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const basic_iterator &other) const {
+      return open_ ? open_it_ == other.open_it_ : chained_it_ == other.chained_it_;
+    }
+
+    bool operator!=(const basic_iterator &other) const {
+      return !(*this == other);
+    }
+
+   private:
+    template<typename, typename, typename, typename> friend
+    class basic_iterator;
+    friend class hash_table_index;
+
+    /* Bool value, true if iterating the open addressing table */
+    bool open_;
+    /* Iterator into the chained table */
+    ChainedIt chained_it_;
+    /* Iterator into the open addressing table */
+    OpenIt open_it_;
+  };
+
+  typedef basic_iterator<chained_table_type::iterator,
+                         open_table_type::iterator,
+                         kv_pair_type &,
+                         kv_pair_type *> iterator;
+  typedef basic_iterator<chained_table_type::const_iterator,
+                         open_table_type::const_iterator,
+                         const kv_pair_type &,
+                         const kv_pair_type *> const_iterator;
+
+  /**
+   * @brief Constructor
+   * @param index_type Index implementation
+   */
+  explicit hash_table_index(hash_table_index_type index_type = chained_index)
+      : index_type_(index_type), open_generation_(0) {}
+
+  hash_table_index(const hash_table_index &other) = delete;
+
+  hash_table_index(hash_table_index &&other) = default;
+
+  hash_table_index &operator=(const hash_table_index &other) = delete;
+
+  hash_table_index &operator=(hash_table_index &&other) = default;
+
+  /**
+   * @brief Parse index implementation name
+   * @param name Index implementation name, "unordered_map" or "open_addressing"
+   * @return Index implementation
+   */
+  static hash_table_index_type index_type_from_name(const std::string &name) {
+    if (name == "unordered_map") {
+      return chained_index;
+    } else if (name == "open_addressing") {
+      return open_addressing_index;
+    }
+    throw std::invalid_argument("No such hash table index " + name);
+  }
+
+  /**
+   * @brief Fetch index implementation
+   * @return Index implementation
+   */
+  hash_table_index_type index_type() const {
+    return index_type_;
+  }
+
+  iterator begin() {
+    return is_open() ? iterator(open_.begin()) : iterator(chained_.begin());
+  }
+
+  iterator end() {
+    return is_open() ? iterator(open_.end()) : iterator(chained_.end());
+  }
+
+  const_iterator begin() const {
+    return is_open() ? const_iterator(open_.begin()) : const_iterator(chained_.begin());
+  }
+
+  const_iterator end() const {
+    return is_open() ? const_iterator(open_.end()) : const_iterator(chained_.end());
+  }
+
+  std::size_t size() const {
+    return is_open() ? open_.size() : chained_.size();
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  iterator find(const key_type &key) {
+    return is_open() ? iterator(open_.find(key)) : iterator(chained_.find(key));
+  }
+
+  const_iterator find(const key_type &key) const {
+    return is_open() ? const_iterator(open_.find(key)) : const_iterator(chained_.find(key));
+  }
+
+  std::size_t count(const key_type &key) const {
+    return is_open() ? open_.count(key) : chained_.count(key);
+  }
+
+  value_type &at(const key_type &key) {
+    return is_open() ? open_.at(key) : chained_.at(key);
+  }
+
+  const value_type &at(const key_type &key) const {
+    return is_open() ? open_.at(key) : chained_.at(key);
+  }
+
+  template<typename K, typename V>
+  std::pair<iterator, bool> emplace(K &&key, V &&value) {
+    std::pair<iterator, bool> ret;
+    if (is_open()) {
+      auto open_ret = open_.emplace(std::forward<K>(key), std::forward<V>(value));
+      ret = std::make_pair(iterator(open_ret.first), open_ret.second);
+    } else {
+      auto chained_ret = chained_.emplace(std::forward<K>(key), std::forward<V>(value));
+      ret = std::make_pair(iterator(chained_ret.first), chained_ret.second);
+    }
+    if (ret.second) {
+      if (is_open() && open_.generation() != open_generation_) {
+        // Entries moved, pointers in the slot buckets are stale
+        rebuild_slot_entries();
+      } else {
+        slot_bucket(hash_slot::get(ret.first->first)).push_back(&(*ret.first));
+      }
+    }
+    return ret;
+  }
+
+  template<typename K, typename V>
+  std::pair<iterator, bool> emplace(std::pair<K, V> &&entry) {
+    return emplace(std::move(entry.first), std::move(entry.second));
+  }
+
+  std::size_t erase(const key_type &key) {
+    auto it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    return 1;
+  }
+
+  iterator erase(const_iterator pos) {
+    remove_from_slot_bucket(hash_slot::get(pos->first), &(*pos));
+    return is_open() ? iterator(open_.erase(pos.open_it_)) : iterator(chained_.erase(pos.chained_it_));
+  }
+
+  void clear() {
+    chained_.clear();
+    open_.clear();
+    slot_entries_.clear();
+  }
+
+  /**
+   * @brief Visit entries whose hash slot is in [slot_begin, slot_end), in slot order
+   * @param slot_begin Begin slot
+   * @param slot_end End slot
+   * @param visit Visitor, called with each entry; returning false stops the visit
+   */
+  template<typename Visitor>
+  void visit_slot_range(int32_t slot_begin, int32_t slot_end, Visitor &&visit) const {
+    auto end = std::min(static_cast<std::size_t>(std::max(slot_end, 0)), slot_entries_.size());
+    for (auto slot = static_cast<std::size_t>(std::max(slot_begin, 0)); slot < end; ++slot) {
+      for (const auto *entry: slot_entries_[slot]) {
+        if (!visit(*entry)) {
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Erase all entries whose hash slot is in [slot_begin, slot_end)
+   * @param slot_begin Begin slot
+   * @param slot_end End slot
+   * @return Number of erased entries
+   */
+  std::size_t erase_slot_range(int32_t slot_begin, int32_t slot_end) {
+    std::size_t n_erased = 0;
+    auto end = std::min(static_cast<std::size_t>(std::max(slot_end, 0)), slot_entries_.size());
+    for (auto slot = static_cast<std::size_t>(std::max(slot_begin, 0)); slot < end; ++slot) {
+      std::vector<const kv_pair_type *> entries;
+      entries.swap(slot_entries_[slot]);
+      for (const auto *entry: entries) {
+        if (is_open()) {
+          open_.erase(open_.find(entry->first));
+        } else {
+          chained_.erase(chained_.find(entry->first));
+        }
+      }
+      n_erased += entries.size();
+    }
+    return n_erased;
+  }
+
+  void reserve(std::size_t count) {
+    if (is_open()) {
+      open_.reserve(count);
+    } else {
+      chained_.reserve(count);
+    }
+  }
+
+ private:
+  bool is_open() const {
+    return index_type_ == open_addressing_index;
+  }
+
+  /**
+   * @brief Fetch the bucket of a hash slot, allocating the buckets on first use
+   * @param slot Hash slot
+   * @return Entries of the hash slot
+   */
+  std::vector<const kv_pair_type *> &slot_bucket(int32_t slot) {
+    if (slot_entries_.empty()) {
+      slot_entries_.resize(hash_slot::MAX);
+    }
+    return slot_entries_[static_cast<std::size_t>(slot)];
+  }
+
+  /**
+   * @brief Remove an entry from the bucket of its hash slot
+   * @param slot Hash slot
+   * @param entry Entry
+   */
+  void remove_from_slot_bucket(int32_t slot, const kv_pair_type *entry) {
+    auto &bucket = slot_bucket(slot);
+    auto it = std::find(bucket.begin(), bucket.end(), entry);
+    if (it != bucket.end()) {
+      *it = bucket.back();
+      bucket.pop_back();
+    }
+  }
+
+  /**
+   * @brief Rebuild all slot buckets from the table
+   */
+  void rebuild_slot_entries() {
+    for (auto &bucket: slot_entries_) {
+      bucket.clear();
+    }
+    for (const auto &entry: *this) {
+      slot_bucket(hash_slot::get(entry.first)).push_back(&entry);
+    }
+    open_generation_ = open_.generation();
+  }
+
+  /* Index implementation */
+  hash_table_index_type index_type_;
+  /* Entries of each hash slot, empty until the first insert */
+  std::vector<std::vector<const kv_pair_type *>> slot_entries_;
+  /* Generation of the open addressing table the slot buckets were built against */
+  std::size_t open_generation_;
+  /* Chained table, used with chained_index */
+  chained_table_type chained_;
+  /* Open addressing table, used with open_addressing_index */
+  open_table_type open_;
+};
+
 // Hash table definitions
-typedef std::unordered_map<key_type, value_type, hash_type, equal_type> hash_table_type;
+typedef hash_table_index hash_table_type;
 
 }
 }
@@ -0,0 +1,512 @@
+#include "hash_table_log_store.h"
+#include "jiffy/utils/logger.h"
+#include <cstdio>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace jiffy {
+namespace storage {
+
+using namespace utils;
+
+/* Log record types */
+static const char PUT_RECORD = 'P';
+static const char REMOVE_RECORD = 'R';
+
+/* Log record layout: type, key size, key, value size, value */
+static const std::uint64_t RECORD_OVERHEAD = sizeof(char) + 2 * sizeof(std::size_t);
+
+hash_table_log_store::hash_table_log_store(const std::string &format,
+                                           double compaction_ratio,
+                                           std::size_t compaction_min_bytes)
+    : format_(format),
+      compaction_ratio_(compaction_ratio),
+      compaction_min_bytes_(compaction_min_bytes),
+      generation_(0),
+      base_bytes_(0),
+      log_bytes_(0),
+      dead_bytes_(0),
+      compaction_requested_(false),
+      stop_(false) {
+  if (format_ != "csv" && format_ != "binary" && format_ != "indexed") {
+    throw std::invalid_argument("No such log store format " + format_);
+  }
+}
+
+hash_table_log_store::~hash_table_log_store() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stop_ = true;
+  }
+  compaction_cv_.notify_all();
+  if (compaction_thread_.joinable()) {
+    compaction_thread_.join();
+  }
+}
+
+bool hash_table_log_store::open(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (path_ == path) {
+    return true;
+  }
+  if (!open_locked(path)) {
+    return false;
+  }
+  if (!compaction_thread_.joinable()) {
+    compaction_thread_ = std::thread(&hash_table_log_store::compaction_loop, this);
+  }
+  return true;
+}
+
+bool hash_table_log_store::exists(const std::string &key) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  location loc{};
+  return lookup(key, loc);
+}
+
+bool hash_table_log_store::get(const std::string &key, std::string &value) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  location loc{};
+  if (!lookup(key, loc)) {
+    return false;
+  }
+  read_locked(loc, value);
+  return true;
+}
+
+bool hash_table_log_store::put(const std::string &key, const std::string &value) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  location loc{};
+  if (lookup(key, loc)) {
+    return false;
+  }
+  append(PUT_RECORD, key, value);
+  return true;
+}
+
+bool hash_table_log_store::update(const std::string &key, const std::string &value) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  location loc{};
+  if (!lookup(key, loc)) {
+    return false;
+  }
+  append(PUT_RECORD, key, value);
+  return true;
+}
+
+void hash_table_log_store::upsert(const std::string &key, const std::string &value) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  append(PUT_RECORD, key, value);
+}
+
+bool hash_table_log_store::remove(const std::string &key) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  location loc{};
+  if (!lookup(key, loc)) {
+    return false;
+  }
+  append(REMOVE_RECORD, key, "");
+  return true;
+}
+
+void hash_table_log_store::compact() {
+  std::lock_guard<std::mutex> compaction_lock(compaction_mtx_);
+  std::string path;
+  index_type snapshot;
+  std::shared_ptr<persistent::indexed_file> base;
+  std::uint64_t generation;
+  std::uint64_t log_end;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (path_.empty() || log_bytes_ == 0) {
+      return;
+    }
+    path = path_;
+    snapshot = index_;
+    base = base_;
+    generation = generation_;
+    log_end = log_bytes_;
+  }
+
+  // Rewrite the live entries without holding the mutex; the files read here are only ever appended to
+  auto tmp_path = compact_path(path);
+  index_type compacted;
+  compacted.reserve(snapshot.size());
+  std::uint64_t offset = 0;
+  if (format_ == "indexed") {
+    // Base records that were not changed are copied from the mapping, changed keys from the log
+    persistent::indexed_file_writer out(tmp_path, persistent::indexed_layout::hash_table, true);
+    std::ifstream base_in;
+    std::ifstream log_in(log_path(path), std::ios::binary);
+    for (std::size_t i = 0; i < base->num_records(); ++i) {
+      auto r = base->get(i);
+      if (snapshot.find(std::string(r.key, r.key_size)) == snapshot.end()) {
+        out.add(r.key, r.key_size, r.value, r.value_size);
+      }
+    }
+    std::string value;
+    for (const auto &e: snapshot) {
+      if (!e.second.removed) {
+        read_value(base_in, log_in, e.second, value);
+        out.add(e.first.data(), e.first.size(), value.data(), value.size());
+      }
+    }
+    offset = out.data_size();
+    if (!out.close()) {
+      throw std::runtime_error("Failed to write " + tmp_path);
+    }
+  } else {
+    std::ifstream base_in(path, std::ios::binary);
+    std::ifstream log_in(log_path(path), std::ios::binary);
+    // The offset file is created first, so a rewritten base file never exists without it
+    std::ofstream offset_out;
+    if (format_ == "binary") {
+      offset_out.open(tmp_path + "_offset", std::ios::binary);
+    }
+    std::ofstream out(tmp_path, std::ios::binary);
+    std::string value;
+    for (const auto &e: snapshot) {
+      read_value(base_in, log_in, e.second, value);
+      if (format_ == "csv") {
+        out.write(e.first.data(), e.first.size());
+        out.put(',');
+        out.write(value.data(), value.size());
+        out.put('\n');
+        compacted.emplace(e.first, location{false, offset + e.first.size() + 1, value.size()});
+        offset += e.first.size() + value.size() + 2;
+      } else {
+        std::size_t key_size = e.first.size();
+        std::size_t value_size = value.size();
+        offset_out.write(reinterpret_cast<const char *>(&key_size), sizeof(size_t));
+        offset_out.write(e.first.data(), key_size);
+        offset_out.write(reinterpret_cast<const char *>(&value_size), sizeof(size_t));
+        out.write(value.data(), value_size);
+        compacted.emplace(e.first, location{false, offset, value.size()});
+        offset += value_size;
+      }
+    }
+    out.flush();
+    offset_out.flush();
+    if (!out || (format_ == "binary" && !offset_out)) {
+      throw std::runtime_error("Failed to write " + tmp_path);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (generation != generation_) {
+    // The store was discarded or reopened in the meantime
+    remove_compaction(path);
+    return;
+  }
+  // Records appended while rewriting stay in the log
+  std::string tail(log_bytes_ - log_end, '\0');
+  log_in_.clear();
+  log_in_.seekg(static_cast<std::streamoff>(log_end), std::ios::beg);
+  log_in_.read(&tail[0], tail.size());
+  base_in_.close();
+  log_in_.close();
+  log_out_.close();
+  // The offset file goes first and the base file last, so recover_compaction() can tell from the
+  // files left by a crash whether the new pair is complete
+  if (format_ == "binary") {
+    std::rename((tmp_path + "_offset").c_str(), (path + "_offset").c_str());
+  }
+  std::rename(tmp_path.c_str(), path.c_str());
+  // Replaying the old log over the new base file is harmless, so a crash before this rename loses nothing
+  auto tmp_log_path = compact_path(log_path(path));
+  {
+    std::ofstream log_out(tmp_log_path, std::ios::binary | std::ios::trunc);
+    log_out.write(tail.data(), tail.size());
+  }
+  std::rename(tmp_log_path.c_str(), log_path(path).c_str());
+  index_ = std::move(compacted);
+  base_bytes_ = offset;
+  dead_bytes_ = 0;
+  if (format_ == "indexed") {
+    base_ = std::make_shared<persistent::indexed_file>(path);
+  }
+  replay_log();
+  open_streams();
+}
+
+void hash_table_log_store::flush(const std::string &path) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (path_ != path) {
+      std::ifstream log(log_path(path));
+      if (!log || !open_locked(path)) {
+        return;
+      }
+    }
+  }
+  compact();
+}
+
+void hash_table_log_store::discard(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (path_ == path) {
+    close_locked();
+  }
+  std::remove(log_path(path).c_str());
+}
+
+std::string hash_table_log_store::log_path(const std::string &path) {
+  return path + "_log";
+}
+
+std::string hash_table_log_store::compact_path(const std::string &path) {
+  return path + ".compact";
+}
+
+void hash_table_log_store::recover_compaction(const std::string &path) {
+  auto tmp_path = compact_path(path);
+  std::remove(compact_path(log_path(path)).c_str());
+  if (format_ == "binary" && std::ifstream(tmp_path).good() && !std::ifstream(tmp_path + "_offset").good()) {
+    // The new offset file is already in place, only the base file that goes with it is left to move
+    LOG(log_level::info) << "Finishing interrupted compaction of " << path;
+    std::rename(tmp_path.c_str(), path.c_str());
+    return;
+  }
+  // Otherwise the base file was not replaced, so the old base file and log are intact
+  remove_compaction(path);
+}
+
+void hash_table_log_store::remove_compaction(const std::string &path) {
+  // The base file goes before the offset file, so a crash in between is never taken for a finished rename
+  auto tmp_path = compact_path(path);
+  std::remove(tmp_path.c_str());
+  std::remove((tmp_path + "_offset").c_str());
+}
+
+bool hash_table_log_store::open_locked(const std::string &path) {
+  close_locked();
+  recover_compaction(path);
+  path_ = path;
+  if (!scan_base()) {
+    close_locked();
+    return false;
+  }
+  replay_log();
+  open_streams();
+  return true;
+}
+
+void hash_table_log_store::close_locked() {
+  base_in_.close();
+  log_in_.close();
+  log_out_.close();
+  index_.clear();
+  base_.reset();
+  path_.clear();
+  base_bytes_ = 0;
+  log_bytes_ = 0;
+  dead_bytes_ = 0;
+  ++generation_;
+}
+
+void hash_table_log_store::open_streams() {
+  base_in_.clear();
+  base_in_.open(path_, std::ios::binary);
+  // Open the append stream first so that the log exists
+  log_out_.clear();
+  log_out_.open(log_path(path_), std::ios::binary | std::ios::app);
+  log_in_.clear();
+  log_in_.open(log_path(path_), std::ios::binary);
+}
+
+bool hash_table_log_store::scan_base() {
+  std::uint64_t offset = 0;
+  if (format_ == "indexed") {
+    // Only the header and tables are read, base keys are looked up in place
+    auto base = std::make_shared<persistent::indexed_file>(path_);
+    if (!base->is_open()) {
+      return false;
+    }
+    if (base->layout() != persistent::indexed_layout::hash_table || !base->sorted()) {
+      throw std::runtime_error(path_ + " is not an indexed hash table");
+    }
+    base_ = base;
+    offset = base->data_size();
+  } else if (format_ == "csv") {
+    std::ifstream in(path_, std::ios::binary);
+    if (!in) {
+      return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+      auto split_index = line.find(',');
+      if (split_index != std::string::npos) {
+        index_[line.substr(0, split_index)] = location{false, offset + split_index + 1, line.size() - split_index - 1};
+      }
+      offset += line.size() + 1;
+    }
+  } else {
+    std::ifstream in(path_, std::ios::binary);
+    std::ifstream offset_in(path_ + "_offset", std::ios::binary);
+    if (!in || !offset_in) {
+      return false;
+    }
+    std::size_t key_size = 0;
+    std::size_t value_size = 0;
+    std::string key;
+    while (offset_in.read(reinterpret_cast<char *>(&key_size), sizeof(key_size))) {
+      key.resize(key_size);
+      offset_in.read(&key[0], key_size);
+      offset_in.read(reinterpret_cast<char *>(&value_size), sizeof(value_size));
+      if (!offset_in) {
+        break;
+      }
+      index_[key] = location{false, offset, value_size};
+      offset += value_size;
+    }
+  }
+  base_bytes_ = offset;
+  return true;
+}
+
+void hash_table_log_store::replay_log() {
+  auto path = log_path(path_);
+  log_bytes_ = 0;
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return;
+  }
+  in.seekg(0, std::ios::end);
+  auto file_size = static_cast<std::uint64_t>(in.tellg());
+  in.seekg(0, std::ios::beg);
+  std::uint64_t offset = 0;
+  char op;
+  std::size_t key_size = 0;
+  std::size_t value_size = 0;
+  std::string key;
+  while (offset + RECORD_OVERHEAD <= file_size && in.get(op) && (op == PUT_RECORD || op == REMOVE_RECORD)) {
+    in.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
+    if (!in || offset + RECORD_OVERHEAD + key_size > file_size) {
+      break;
+    }
+    key.resize(key_size);
+    in.read(&key[0], key_size);
+    in.read(reinterpret_cast<char *>(&value_size), sizeof(value_size));
+    auto value_offset = offset + RECORD_OVERHEAD + key_size;
+    if (!in || value_offset + value_size > file_size) {
+      break;
+    }
+    apply(op, key, value_offset, value_size);
+    offset = value_offset + value_size;
+    in.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+  }
+  in.close();
+  if (offset < file_size) {
+    // Drop a record that was only partially written
+    LOG(log_level::warn) << "Truncating " << path << " from " << file_size << " to " << offset << " bytes";
+    if (truncate(path.c_str(), static_cast<off_t>(offset)) != 0) {
+      throw std::runtime_error("Failed to truncate " + path);
+    }
+  }
+  log_bytes_ = offset;
+}
+
+void hash_table_log_store::append(char op, const std::string &key, const std::string &value) {
+  std::size_t key_size = key.size();
+  std::size_t value_size = value.size();
+  log_out_.put(op);
+  log_out_.write(reinterpret_cast<const char *>(&key_size), sizeof(size_t));
+  log_out_.write(key.data(), key_size);
+  log_out_.write(reinterpret_cast<const char *>(&value_size), sizeof(size_t));
+  log_out_.write(value.data(), value_size);
+  log_out_.flush();
+  if (!log_out_) {
+    throw std::runtime_error("Failed to append to " + log_path(path_));
+  }
+  auto value_offset = log_bytes_ + RECORD_OVERHEAD + key_size;
+  log_bytes_ = value_offset + value_size;
+  apply(op, key, value_offset, value_size);
+  if (!compaction_requested_ && needs_compaction()) {
+    compaction_requested_ = true;
+    compaction_cv_.notify_one();
+  }
+}
+
+void hash_table_log_store::apply(char op, const std::string &key, std::uint64_t value_offset, std::uint64_t value_size) {
+  location loc{};
+  if (lookup(key, loc)) {
+    dead_bytes_ += RECORD_OVERHEAD + key.size() + loc.size;
+  }
+  if (op == PUT_RECORD) {
+    index_[key] = location{true, value_offset, value_size, false};
+  } else {
+    dead_bytes_ += RECORD_OVERHEAD + key.size();
+    if (base_ != nullptr && base_->find(key) != persistent::indexed_file::npos) {
+      // Hides the record of the base file
+      index_[key] = location{false, 0, 0, true};
+    } else {
+      index_.erase(key);
+    }
+  }
+}
+
+bool hash_table_log_store::lookup(const std::string &key, location &loc) const {
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    loc = it->second;
+    return !loc.removed;
+  }
+  if (base_ == nullptr) {
+    return false;
+  }
+  auto i = base_->find(key);
+  if (i == persistent::indexed_file::npos) {
+    return false;
+  }
+  loc = location{false, i, base_->get(i).value_size, false};
+  return true;
+}
+
+void hash_table_log_store::read_locked(const location &loc, std::string &value) {
+  if (!loc.in_log && base_ != nullptr) {
+    auto r = base_->get(static_cast<std::size_t>(loc.offset));
+    value.assign(r.value, r.value_size);
+    return;
+  }
+  read_value(base_in_, log_in_, loc, value);
+}
+
+void hash_table_log_store::read_value(std::ifstream &base,
+                                      std::ifstream &log,
+                                      const location &loc,
+                                      std::string &value) {
+  auto &in = loc.in_log ? log : base;
+  in.clear();
+  in.seekg(static_cast<std::streamoff>(loc.offset), std::ios::beg);
+  value.resize(loc.size);
+  in.read(&value[0], loc.size);
+  if (!in) {
+    throw std::runtime_error("Failed to read value at offset " + std::to_string(loc.offset));
+  }
+}
+
+bool hash_table_log_store::needs_compaction() const {
+  return !path_.empty() && log_bytes_ >= compaction_min_bytes_
+      && dead_bytes_ >= compaction_ratio_ * (base_bytes_ + log_bytes_);
+}
+
+void hash_table_log_store::compaction_loop() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (true) {
+    compaction_cv_.wait(lock, [this] { return stop_ || compaction_requested_; });
+    if (stop_) {
+      return;
+    }
+    compaction_requested_ = false;
+    lock.unlock();
+    try {
+      compact();
+    } catch (std::exception &e) {
+      LOG(log_level::error) << "Log store compaction failed: " << e.what();
+    }
+    lock.lock();
+  }
+}
+
+}
+}
@@ -0,0 +1,301 @@
+#ifndef JIFFY_HASH_TABLE_LOG_STORE_H
+#define JIFFY_HASH_TABLE_LOG_STORE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "jiffy/persistent/indexed_file.h"
+
+namespace jiffy {
+namespace storage {
+
+/**
+ * @brief Log-structured engine behind the hash table *_ls commands.
+ *
+ * The base file is the file written by dumping the partition, in the partition's serializer format
+ * (csv, binary with its "_offset" file, or indexed). Opening a csv or binary store scans the base file
+ * once to build an in-memory index from key to value location; an indexed base file is mapped instead
+ * and its keys are looked up by binary search of its key index, so the in-memory index only holds the
+ * keys changed since. From then on every mutation is appended to a log file next to the base file
+ * ("<path>_log") and only updates the index, and lookups read a single value at a known offset.
+ *
+ * Once overwritten and removed records take up enough of the files, a background thread compacts
+ * the store: it rewrites the live entries into a new base file in the serializer format and keeps
+ * only the records appended while it was doing so in the log. The log is replayed when the store is
+ * opened again, so no mutation is lost if the store is closed before compaction.
+ */
+class hash_table_log_store {
+ public:
+  /**
+   * @brief Constructor
+   * @param format Base file format: csv, binary or indexed
+   * @param compaction_ratio Fraction of the files taken up by dead records that triggers compaction
+   * @param compaction_min_bytes Log size below which no compaction is triggered
+   */
+  hash_table_log_store(const std::string &format, double compaction_ratio, std::size_t compaction_min_bytes);
+
+  /**
+   * @brief Destructor, stops the compaction thread and leaves the log in place
+   */
+  ~hash_table_log_store();
+
+  hash_table_log_store(const hash_table_log_store &) = delete;
+  hash_table_log_store &operator=(const hash_table_log_store &) = delete;
+
+  /**
+   * @brief Open the store on a base file, building the index if it is not open on that file yet
+   * @param path Base file path
+   * @return Bool value, false if the base file does not exist
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief Check if key exists
+   * @param key Key
+   * @return Bool value, true if key exists
+   */
+  bool exists(const std::string &key);
+
+  /**
+   * @brief Fetch the value of a key
+   * @param key Key
+   * @param value Value
+   * @return Bool value, true if key exists
+   */
+  bool get(const std::string &key, std::string &value);
+
+  /**
+   * @brief Insert a key that does not exist yet
+   * @param key Key
+   * @param value Value
+   * @return Bool value, false if key already exists
+   */
+  bool put(const std::string &key, const std::string &value);
+
+  /**
+   * @brief Update the value of an existing key
+   * @param key Key
+   * @param value Value
+   * @return Bool value, false if key does not exist
+   */
+  bool update(const std::string &key, const std::string &value);
+
+  /**
+   * @brief Insert a key or update its value
+   * @param key Key
+   * @param value Value
+   */
+  void upsert(const std::string &key, const std::string &value);
+
+  /**
+   * @brief Remove a key
+   * @param key Key
+   * @return Bool value, false if key does not exist
+   */
+  bool remove(const std::string &key);
+
+  /**
+   * @brief Fold the log into the base file
+   */
+  void compact();
+
+  /**
+   * @brief Fold the log of a base file into it so that the base file can be read directly
+   * @param path Base file path
+   */
+  void flush(const std::string &path);
+
+  /**
+   * @brief Drop the log of a base file after the base file was rewritten
+   * @param path Base file path
+   */
+  void discard(const std::string &path);
+
+  /**
+   * @brief Fetch the log path of a base file
+   * @param path Base file path
+   * @return Log path
+   */
+  static std::string log_path(const std::string &path);
+
+ private:
+  /* Location of a value */
+  struct location {
+    /* Bool value, true if the value is in the log, false if it is in the base file */
+    bool in_log;
+    /* Value offset, or record number in an indexed base file */
+    std::uint64_t offset;
+    /* Value size */
+    std::uint64_t size;
+    /* Bool value, true if the key was removed from an indexed base file */
+    bool removed;
+  };
+
+  typedef std::unordered_map<std::string, location> index_type;
+
+  /**
+   * @brief Build the index of a base file and replay its log, mutex must be held
+   * @param path Base file path
+   * @return Bool value, false if the base file does not exist
+   */
+  bool open_locked(const std::string &path);
+
+  /**
+   * @brief Finish or drop a compaction of a base file left behind by a crash, mutex must be held
+   * @param path Base file path
+   */
+  void recover_compaction(const std::string &path);
+
+  /**
+   * @brief Remove the files written by a compaction of a base file
+   * @param path Base file path
+   */
+  static void remove_compaction(const std::string &path);
+
+  /**
+   * @brief Fetch the path a compaction rewrites a file to
+   * @param path File path
+   * @return Compaction path
+   */
+  static std::string compact_path(const std::string &path);
+
+  /**
+   * @brief Close files and clear the index, mutex must be held
+   */
+  void close_locked();
+
+  /**
+   * @brief Open the file streams of the current base file, mutex must be held
+   */
+  void open_streams();
+
+  /**
+   * @brief Add the entries of the base file to the index
+   * @return Bool value, false if the base file does not exist
+   */
+  bool scan_base();
+
+  /**
+   * @brief Locate the value of a key in the index or the indexed base file, mutex must be held
+   * @param key Key
+   * @param loc Value location
+   * @return Bool value, true if key exists
+   */
+  bool lookup(const std::string &key, location &loc) const;
+
+  /**
+   * @brief Read a value of the current files, mutex must be held
+   * @param loc Value location
+   * @param value Value
+   */
+  void read_locked(const location &loc, std::string &value);
+
+  /**
+   * @brief Apply the log records to the index, truncating an incomplete trailing record
+   */
+  void replay_log();
+
+  /**
+   * @brief Append a record to the log and apply it to the index, mutex must be held
+   * @param op Record type
+   * @param key Key
+   * @param value Value
+   */
+  void append(char op, const std::string &key, const std::string &value);
+
+  /**
+   * @brief Apply a record to the index
+   * @param op Record type
+   * @param key Key
+   * @param value_offset Value offset in the log
+   * @param value_size Value size
+   */
+  void apply(char op, const std::string &key, std::uint64_t value_offset, std::uint64_t value_size);
+
+  /**
+   * @brief Read a value
+   * @param base Base file stream
+   * @param log Log stream
+   * @param loc Value location
+   * @param value Value
+   */
+  static void read_value(std::ifstream &base, std::ifstream &log, const location &loc, std::string &value);
+
+  /**
+   * @brief Check if enough of the files is dead records to compact, mutex must be held
+   * @return Bool value, true if the store should be compacted
+   */
+  bool needs_compaction() const;
+
+  /**
+   * @brief Compaction thread body
+   */
+  void compaction_loop();
+
+  /* Base file format: csv, binary or indexed */
+  std::string format_;
+
+  /* Fraction of dead records that triggers compaction */
+  double compaction_ratio_;
+
+  /* Minimum log size for compaction */
+  std::size_t compaction_min_bytes_;
+
+  /* Base file path, empty if not open */
+  std::string path_;
+
+  /* Incremented whenever the open files change, so compaction detects a reopened store */
+  std::uint64_t generation_;
+
+  /* Key to value location; only keys changed in the log for indexed base files */
+  index_type index_;
+
+  /* Mapped base file, null unless the format is indexed */
+  std::shared_ptr<persistent::indexed_file> base_;
+
+  /* Base file size */
+  std::uint64_t base_bytes_;
+
+  /* Log size */
+  std::uint64_t log_bytes_;
+
+  /* Approximate number of bytes taken up by overwritten and removed records */
+  std::uint64_t dead_bytes_;
+
+  /* Base file read stream */
+  std::ifstream base_in_;
+
+  /* Log read stream */
+  std::ifstream log_in_;
+
+  /* Log append stream */
+  std::ofstream log_out_;
+
+  /* Index and file mutex */
+  std::mutex mtx_;
+
+  /* Serializes compactions */
+  std::mutex compaction_mtx_;
+
+  /* Wakes the compaction thread */
+  std::condition_variable compaction_cv_;
+
+  /* Bool value, true if a compaction was requested */
+  bool compaction_requested_;
+
+  /* Bool value, true if the compaction thread should exit */
+  bool stop_;
+
+  /* Compaction thread, started when the store is first opened */
+  std::thread compaction_thread_;
+};
+
+}
+}
+
+#endif //JIFFY_HASH_TABLE_LOG_STORE_H
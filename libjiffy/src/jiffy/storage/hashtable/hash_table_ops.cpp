@@ -21,6 +21,13 @@ command_map HT_OPS = {{"exists", {command_type::accessor, 0}},
                       {"get_metadata", {command_type::accessor, 14}},
                       {"get_range_data", {command_type::accessor, 15}},
                       {"scale_put", {command_type::mutator, 16}},
-                      {"scale_remove", {command_type::mutator, 17}}};
+                      {"scale_remove", {command_type::mutator, 17}},
+                      {"mget", {command_type::accessor, 18}},
+                      {"mput", {command_type::mutator, 19}},
+                      {"mupsert", {command_type::mutator, 20}},
+                      {"mremove", {command_type::mutator, 21}},
+                      {"cas", {command_type::mutator, 22}},
+                      {"incr", {command_type::mutator, 23}},
+                      {"append", {command_type::mutator, 24}}};
 }
 }
\ No newline at end of file
@@ -30,7 +30,14 @@ enum hash_table_cmd_id: uint32_t {
   ht_get_metadata = 14,
   ht_get_range_data = 15,
   ht_scale_put = 16,
-  ht_scale_remove = 17
+  ht_scale_remove = 17,
+  ht_mget = 18,
+  ht_mput = 19,
+  ht_mupsert = 20,
+  ht_mremove = 21,
+  ht_cas = 22,
+  ht_incr = 23,
+  ht_append = 24
 };
 
 }
@@ -7,7 +7,10 @@
 #include "jiffy/persistent/persistent_store.h"
 #include "jiffy/storage/partition_manager.h"
 #include "jiffy/auto_scaling/auto_scaling_client.h"
+#include <cerrno>
 #include <chrono>
+#include <cstdlib>
+#include <limits>
 #include <thread>
 
 namespace jiffy {
@@ -26,6 +29,9 @@ hash_table_partition::hash_table_partition(block_memory_manager *manager,
       scaling_up_(false),
       scaling_down_(false),
       dirty_(false),
+      dirty_slots_(hash_slot::MAX),
+      deltas_(conf.get_as<std::size_t>("hashtable.sync_max_deltas", 16),
+              conf.get_as<double>("hashtable.sync_delta_ratio", 0.5)),
       export_slot_range_(0, -1),
       import_slot_range_(0, -1),
       auto_scaling_host_(auto_scaling_host),
@@ -33,14 +39,30 @@ hash_table_partition::hash_table_partition(block_memory_manager *manager,
   ser_name_ = conf.get("hashtable.serializer", "csv");
   if (ser_name_ == "binary") {
     ser_ = std::make_shared<binary_serde>(binary_allocator_);
+  } else if (ser_name_ == "binary_lz4") {
+    ser_ = std::make_shared<binary_serde>(binary_allocator_, persistent::codec::make("lz4"));
+  } else if (ser_name_ == "binary_zstd") {
+    ser_ = std::make_shared<binary_serde>(binary_allocator_, persistent::codec::make("zstd"));
+  } else if (ser_name_ == "indexed") {
+    ser_ = std::make_shared<indexed_serde>(binary_allocator_);
   } else if (ser_name_ == "csv") {
     ser_ = std::make_shared<csv_serde>(binary_allocator_);
   } else {
     throw std::invalid_argument("No such serializer/deserializer " + ser_name_);
   }
+  block_ = hash_table_type(hash_table_index::index_type_from_name(conf.get("hashtable.index", "unordered_map")));
+  single_allocation_ = conf.get_as<bool>("hashtable.single_allocation", false);
   threshold_hi_ = conf.get_as<double>("hashtable.capacity_threshold_hi", 0.95);
   threshold_lo_ = conf.get_as<double>("hashtable.capacity_threshold_lo", 0.05);
   auto_scale_ = conf.get_as<bool>("hashtable.auto_scale", true);
+  log_mode(conf.get("hashtable.wal", "none"));
+  // The *_ls commands address records in place, which compressed files do not allow
+  if (ser_name_ == "csv" || ser_name_ == "binary" || ser_name_ == "indexed") {
+    ls_store_ = std::shared_ptr<hash_table_log_store>(
+        new hash_table_log_store(ser_name_,
+                                 conf.get_as<double>("hashtable.ls_compaction_ratio", 0.5),
+                                 conf.get_as<std::size_t>("hashtable.ls_compaction_min_bytes", 1048576)));
+  }
   auto r = utils::string_utils::split(name_, '_');
   slot_range(std::stoi(r[0]), std::stoi(r[1]));
   temporary_data_manager_ = new block_memory_manager(HASH_TABLE_MAX_KEY_SIZE);
@@ -87,7 +109,7 @@ void hash_table_partition::put(response &_return, const arg_list &args) {
       if (storage_size() + args[1].size() + args[2].size() > storage_capacity()) {
         RETURN_ERR("!full");
       }
-      if (block_.emplace(make_binary(args[1]), make_binary(args[2])).second) {
+      if (block_.emplace(make_entry(args[1], args[2])).second) {
         if (remove_cache_.find(args[1]) != remove_cache_.end())
           remove_cache_.erase(args[1]);
         RETURN_OK();
@@ -113,10 +135,10 @@ void hash_table_partition::upsert(response &_return, const arg_list &args) {
         it->second = make_binary(args[2]);
         RETURN_OK(old_val);
       }
-      if (found && block_.emplace(make_binary(args[1]), make_binary(args[2])).second) {
+      if (found && block_.emplace(make_entry(args[1], args[2])).second) {
         RETURN_OK(args[4]);
       }
-      block_.emplace(make_binary(args[1]), make_binary(args[2]));
+      block_.emplace(make_entry(args[1], args[2]));
     END_CATCH_HANDLER;
     if (remove_cache_.find(args[1]) != remove_cache_.end())
       remove_cache_.erase(args[1]);
@@ -137,7 +159,7 @@ void hash_table_partition::upsert(response &_return, const arg_list &args) {
       if (metadata_ == "exporting" && in_export_slot_range(hash)) {
         RETURN_ERR("!exporting", export_target_str_, std::to_string(found), old_val);
       }
-      block_.emplace(make_binary(args[1]), make_binary(args[2]));
+      block_.emplace(make_entry(args[1], args[2]));
     END_CATCH_HANDLER;
     RETURN_OK();
   }
@@ -180,7 +202,7 @@ void hash_table_partition::update(response &_return, const arg_list &args) {
         it->second = make_binary(args[2]);
         RETURN_OK();
       }
-      if (found && block_.emplace(make_binary(args[1]), make_binary(args[2])).second) {
+      if (found && block_.emplace(make_entry(args[1], args[2])).second) {
         if (remove_cache_.find(args[1]) != remove_cache_.end())
           remove_cache_.erase(args[1]);
         RETURN_OK();
@@ -243,443 +265,276 @@ void hash_table_partition::remove(response &_return, const arg_list &args) {
   RETURN_ERR("!block_moved");
 }
 
-void hash_table_partition::exists_ls(response &_return, const arg_list &args) {
-  if (args.size() != 2) {
-    RETURN("!args_error");
-  }
-  std::string file_path, line, key, value;
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path,name());
-  if (ser_name_ == "csv") {
-    std::ifstream in(file_path);
-    if (in) {
-      while(getline(in,line)) {
-        int split_index = line.find(",");
-        key = line.substr(0,split_index);
-        if (key == args[1]) {
-          RETURN_OK();
-        }
-      }
-      in.close();
-      RETURN_ERR("!key_not_found");
-    }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
-    }
+/**
+ * @brief Append the response of a single key command to a batch response
+ * @param _return Batch response
+ * @param key_return Single key response
+ */
+static void append_batch_response(response &_return, const response &key_return) {
+  _return.emplace_back(std::to_string(key_return.size()));
+  _return.insert(_return.end(), key_return.begin(), key_return.end());
+}
+
+void hash_table_partition::mget(response &_return, const arg_list &args) {
+  if (args.size() < 2) {
+    RETURN_ERR("!args_error");
   }
-  else if (ser_name_ == "binary") {
-    std::string offset_path = file_path;
-    offset_path.append("_offset");
-    std::ifstream offset_in(offset_path,std::ios::binary);
-    std::size_t key_size = 0;
-    std::size_t value_size = 0;
-    if (offset_in) {
-      while (offset_in.peek() != EOF) {
-        offset_in.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
-        key.resize(key_size);
-        offset_in.read(&key[0], key_size);
-        offset_in.read(reinterpret_cast<char *>(&value_size), sizeof(value_size));
-        if (key == args[1]) {
-          offset_in.close();
-          RETURN_OK();
-        }
-      }
-      offset_in.close();
-      RETURN_ERR("!key_not_found");
-    }
-    else {
-      RETURN_ERR("!fifo_queue_does_not_exist");
-    }
+  _return.emplace_back("!ok");
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    response key_return;
+    get(key_return, {"get", args[i]});
+    append_batch_response(_return, key_return);
   }
 }
 
-void hash_table_partition::put_ls(response &_return, const arg_list &args) {
-  if (args.size() != 3) {
+void hash_table_partition::mput(response &_return, const arg_list &args) {
+  if (args.size() < 3 || args.size() % 2 != 1) {
     RETURN_ERR("!args_error");
   }
-  std::string file_path, line, key, value;
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path,name());
-  if (ser_name_ == "csv") {
-    std::ifstream in(file_path);
-    if (in) {
-      while(getline(in,line)) {
-        int split_index = line.find(",");
-        key = line.substr(0,split_index);
-        if (key == args[1]) {
-          in.close();
-          RETURN_ERR("!duplicate_key");
-        }
-      }
-      in.close();
-      std::ofstream out(file_path,std::ios::app);
-      out << args[1] << "," << args[2] << std::endl;
-      out.close();
-      RETURN_OK();
-    }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
-    }
-  }
-  else if (ser_name_ == "binary") {
-    std::string offset_path = file_path;
-    offset_path.append("_offset");
-    std::ifstream offset_in(offset_path,std::ios::binary);
-    std::size_t key_size = 0;
-    std::size_t value_size = 0;
-    if (offset_in) {
-      while (offset_in.peek() != EOF) {
-        offset_in.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
-        key.resize(key_size);
-        offset_in.read(&key[0], key_size);
-        offset_in.read(reinterpret_cast<char *>(&value_size), sizeof(value_size));
-        if (key == args[1]) {
-          offset_in.close();
-          RETURN_ERR("!duplicate_key");
-        }
-      }
-      offset_in.close();
-      std::ofstream out(file_path,std::ios::app);
-      std::ofstream offset_out(offset_path,std::ios::app);
-      key_size = args[1].size();
-      value_size = args[2].size();
-      offset_out.write(reinterpret_cast<const char *>(&key_size), sizeof(size_t));
-      offset_out.write(reinterpret_cast<const char *>(args[1].data()), key_size);
-      offset_out.write(reinterpret_cast<const char *>(&value_size), sizeof(size_t));
-      out.write(reinterpret_cast<const char *>(args[2].data()), value_size);
-      out.close();
-      offset_out.close();
-      RETURN_OK();
-    }
-    else {
-      RETURN_ERR("!fifo_queue_does_not_exist");
-    }
+  _return.emplace_back("!ok");
+  for (std::size_t i = 1; i < args.size(); i += 2) {
+    response key_return;
+    put(key_return, {"put", args[i], args[i + 1]});
+    append_batch_response(_return, key_return);
   }
 }
 
-void hash_table_partition::upsert_ls(response &_return, const arg_list &args) {
-  if (args.size() != 3) {
+void hash_table_partition::mupsert(response &_return, const arg_list &args) {
+  if (args.size() < 3 || args.size() % 2 != 1) {
     RETURN_ERR("!args_error");
   }
-  std::unordered_map<std::string,std::string> ht;
-  std::string file_path, line, key, value;
-  int key_exist = 0;
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path,name());
-  if (ser_name_ == "csv") {
-    std::ifstream in(file_path);
-    if (in) {
-      while(getline(in,line)) {
-        int split_index = line.find(",");
-        key = line.substr(0,split_index);
-        if (key == args[1]) {
-          key_exist = 1;
-          value = args[2];
-          ht.insert({key,value});
-          continue;
-        }
-        value = line.substr(split_index+1);
-        ht.insert({key,value});
-      }
-      in.close();
-    }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
-    }
-    if (key_exist == 0) {
-      ht.insert({args[1],args[2]});
-    }
-    std::ofstream out(file_path);
-    for (auto x: ht) {
-      out << (x.first) << "," << (x.second) << std::endl;
-    }
-    out.close();
-    RETURN_OK();
+  _return.emplace_back("!ok");
+  for (std::size_t i = 1; i < args.size(); i += 2) {
+    response key_return;
+    upsert(key_return, {"upsert", args[i], args[i + 1]});
+    append_batch_response(_return, key_return);
   }
-  else if (ser_name_ == "binary") {
-    std::ifstream in(file_path,std::ios::binary);
-    std::string offset_path = file_path;
-    offset_path.append("_offset");
-    std::ifstream offset_in(offset_path,std::ios::binary);
-    std::size_t key_size = 0;
-    std::size_t value_size = 0;
-    if (in && offset_in) {
-      while (offset_in.peek() != EOF) {
-        offset_in.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
-        key.resize(key_size);
-        offset_in.read(&key[0], key_size);
-        offset_in.read(reinterpret_cast<char *>(&value_size), sizeof(value_size));
-        if (key == args[1]) {
-          key_exist = 1;
-          in.read(&value[0], value_size);
-          ht.insert({key,args[2]});
-          continue;
-        }
-        value.resize(value_size);
-        in.read(&value[0], value_size);
-        ht.insert({key,value});
-      }
-      in.close();
-      offset_in.close();
-    }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
-    }
-    if (key_exist == 0) {
-      ht.insert({args[1],args[2]});
-    }
-    std::ofstream out(file_path,std::ios::binary);
-    std::ofstream offset_out(offset_path,std::ios::binary);
-    for (auto x: ht) {
-      key_size = x.first.size();
-      value_size = x.second.size();
-      offset_out.write(reinterpret_cast<const char *>(&key_size), sizeof(size_t));
-      offset_out.write(reinterpret_cast<const char *>(x.first.data()), key_size);
-      offset_out.write(reinterpret_cast<const char *>(&value_size), sizeof(size_t));
-      out.write(reinterpret_cast<const char *>(x.second.data()), value_size);
-    }
-    out.close();
-    offset_out.close();
-    RETURN_OK();
+}
+
+void hash_table_partition::mremove(response &_return, const arg_list &args) {
+  if (args.size() < 2) {
+    RETURN_ERR("!args_error");
+  }
+  _return.emplace_back("!ok");
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    response key_return;
+    remove(key_return, {"remove", args[i]});
+    append_batch_response(_return, key_return);
   }
-  
 }
 
-void hash_table_partition::get_ls(response &_return, const arg_list &args) {
-  if (args.size() != 2) {
-    RETURN("!args_error");
+/**
+ * @brief Parse a decimal 64-bit integer, rejecting trailing characters
+ * @param str String
+ * @param value Parsed value
+ * @return True if the whole string is a decimal integer within range
+ */
+static bool parse_int64(const std::string &str, int64_t &value) {
+  if (str.empty()) {
+    return false;
   }
-  std::string file_path, line, key, value;
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path,name());
-  if (ser_name_ == "csv") {
-    std::ifstream in(file_path);
-    if (in) {
-      while(getline(in,line)) {
-        int split_index = line.find(",");
-        key = line.substr(0,split_index);
-        if (key == args[1]) {
-          value = line.substr(split_index+1);
-          RETURN_OK(value);
-        }
-      }
-      in.close();
-      RETURN_ERR("!key_not_found");
+  errno = 0;
+  char *end = nullptr;
+  auto v = std::strtoll(str.c_str(), &end, 10);
+  if (errno != 0 || end != str.c_str() + str.size()) {
+    return false;
+  }
+  value = static_cast<int64_t>(v);
+  return true;
+}
+
+void hash_table_partition::cas(response &_return, const arg_list &args) {
+  read_modify_write(_return, args, 2, [&args](response &ret, const std::string *current, std::string &value) {
+    if (current == nullptr) {
+      ret = {"!key_not_found"};
+      return false;
     }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
+    if (*current != args[2]) {
+      ret = {"!cas_failed", *current};
+      return false;
     }
-  }
-  else if (ser_name_ == "binary") {
-    std::ifstream in(file_path,std::ios::binary);
-    std::string offset_path = file_path;
-    offset_path.append("_offset");
-    std::ifstream offset_in(offset_path,std::ios::binary);
-    std::size_t offset = 0;
-    std::size_t key_size = 0;
-    std::size_t value_size = 0;
-    if (in && offset_in) {
-      while (offset_in.peek() != EOF) {
-        offset_in.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
-        key.resize(key_size);
-        offset_in.read(&key[0], key_size);
-        offset_in.read(reinterpret_cast<char *>(&value_size), sizeof(value_size));
-        if (key == args[1]) {
-          value.resize(value_size);
-          in.seekg(offset,std::ios::beg);
-          in.read(&value[0], value_size);
-          RETURN_OK(value);
-        }
-        offset += value_size;
-      }
-      in.close();
-      offset_in.close();
-      RETURN_ERR("!key_not_found");
+    value = args[3];
+    return true;
+  });
+}
+
+void hash_table_partition::incr(response &_return, const arg_list &args) {
+  read_modify_write(_return, args, 1, [&args](response &ret, const std::string *current, std::string &value) {
+    int64_t delta, old_value = 0, new_value;
+    if (!parse_int64(args[2], delta)) {
+      ret = {"!args_error"};
+      return false;
     }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
+    if (current != nullptr && !parse_int64(*current, old_value)) {
+      ret = {"!not_a_number"};
+      return false;
     }
-  }
+    if (__builtin_add_overflow(old_value, delta, &new_value)) {
+      ret = {"!overflow"};
+      return false;
+    }
+    value = std::to_string(new_value);
+    return true;
+  });
 }
 
-void hash_table_partition::update_ls(response &_return, const arg_list &args) {
-  if (args.size() != 3) {
+void hash_table_partition::append(response &_return, const arg_list &args) {
+  read_modify_write(_return, args, 1, [&args](response &, const std::string *current, std::string &value) {
+    value = current != nullptr ? *current + args[2] : args[2];
+    return true;
+  });
+}
+
+void hash_table_partition::read_modify_write(response &_return,
+                                             const arg_list &args,
+                                             std::size_t num_args,
+                                             const rmw_function &compute) {
+  auto argc = num_args + 2;
+  if (!(args.size() == argc || (args.size() == argc + 3 && args[argc + 2] == "!redirected"))) {
     RETURN_ERR("!args_error");
   }
-  
-  std::unordered_map<std::string,std::string> ht;
-  std::string file_path, line, key, value;
-  int key_exist = 0;
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path,name());
-  if (ser_name_ == "csv") {
-    std::ifstream in(file_path);
-    if (in) {
-      while(getline(in,line)) {
-        int split_index = line.find(",");
-        key = line.substr(0,split_index);
-        if (key == args[1]) {
-          key_exist = 1;
-          value = args[2];
-          ht.insert({key,value});
-          continue;
-        }
-        value = line.substr(split_index+1);
-        ht.insert({key,value});
+  auto hash = hash_slot::get(args[1]);
+  bool redirected = args.size() == argc + 3 && in_import_slot_range(hash) && metadata() == "importing";
+  if (in_slot_range(hash) || redirected) {
+    bool exporting = !redirected && metadata_ == "exporting" && in_export_slot_range(hash);
+    BEGIN_CATCH_HANDLER;
+      bool found = it != block_.end();
+      std::string current = found ? to_string(it->second) : std::string();
+      if (exporting) {
+        // Only the importing partition writes the value, so a redirect that fails and is resent applies once
+        RETURN_ERR("!exporting", export_target_str_, std::to_string(found), current);
       }
-      in.close();
-    }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
-    }
-    if (key_exist == 1) {
-      std::ofstream out(file_path);
-      for (auto x: ht) {
-        out << (x.first) << "," << (x.second) << std::endl;
+      if (!found && redirected && static_cast<bool>(std::stoi(args[argc]))) {
+        // The key is not imported yet, apply the command to the value the exporting partition holds
+        found = true;
+        current = args[argc + 1];
       }
-      out.close();
-      RETURN_OK();
-    }
-    else {
-      RETURN_ERR("!key_not_found");
-    }
-  }
-  else if (ser_name_ == "binary") {
-    std::ifstream in(file_path,std::ios::binary);
-    std::string offset_path = file_path;
-    offset_path.append("_offset");
-    std::ifstream offset_in(offset_path,std::ios::binary);
-    std::size_t key_size = 0;
-    std::size_t value_size = 0;
-    if (in && offset_in) {
-      while (offset_in.peek() != EOF) {
-        offset_in.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
-        key.resize(key_size);
-        offset_in.read(&key[0], key_size);
-        offset_in.read(reinterpret_cast<char *>(&value_size), sizeof(value_size));
-        if (key == args[1]) {
-          key_exist = 1;
-          in.read(&value[0], value_size);
-          ht.insert({key,args[2]});
-          continue;
-        }
-        value.resize(value_size);
-        in.read(&value[0], value_size);
-        ht.insert({key,value});
+      std::string value;
+      if (!compute(_return, found ? &current : nullptr, value)) {
+        return;
       }
-      in.close();
-      offset_in.close();
-    }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
-    }
-    if (key_exist == 0) {
-      RETURN_ERR("!key_not_found");
-    }
-    std::ofstream out(file_path,std::ios::binary);
-    std::ofstream offset_out(offset_path,std::ios::binary);
-    for (auto x: ht) {
-      key_size = x.first.size();
-      value_size = x.second.size();
-      offset_out.write(reinterpret_cast<const char *>(&key_size), sizeof(size_t));
-      offset_out.write(reinterpret_cast<const char *>(x.first.data()), key_size);
-      offset_out.write(reinterpret_cast<const char *>(&value_size), sizeof(size_t));
-      out.write(reinterpret_cast<const char *>(x.second.data()), value_size);
-    }
-    out.close();
-    offset_out.close();
-    RETURN_OK();
+      bool stored = it != block_.end();
+      auto added = stored ? (value.size() > current.size() ? value.size() - current.size() : 0)
+                          : args[1].size() + value.size();
+      if (storage_size() + added > storage_capacity()) {
+        RETURN_ERR("!full");
+      }
+      if (stored) {
+        it->second = make_binary(value);
+      } else {
+        block_.emplace(make_entry(args[1], value));
+        if (remove_cache_.find(args[1]) != remove_cache_.end())
+          remove_cache_.erase(args[1]);
+      }
+      rmw_response(_return, args[0], value);
+      return;
+    END_CATCH_HANDLER;
+  }
+  RETURN_ERR("!block_moved");
+}
+
+void hash_table_partition::rmw_response(response &_return, const std::string &cmd_name, const std::string &value) {
+  if (cmd_name == "incr") {
+    RETURN_OK(value);
   }
+  if (cmd_name == "append") {
+    RETURN_OK(std::to_string(value.size()));
+  }
+  RETURN_OK();
+}
+
+void hash_table_partition::exists_ls(response &_return, const arg_list &args) {
+  run_ls(_return, args, ls_path());
+}
+
+void hash_table_partition::put_ls(response &_return, const arg_list &args) {
+  run_ls(_return, args, ls_path());
+}
+
+void hash_table_partition::upsert_ls(response &_return, const arg_list &args) {
+  run_ls(_return, args, ls_path());
+}
+
+void hash_table_partition::get_ls(response &_return, const arg_list &args) {
+  run_ls(_return, args, ls_path());
+}
+
+void hash_table_partition::update_ls(response &_return, const arg_list &args) {
+  run_ls(_return, args, ls_path());
 }
 
 void hash_table_partition::remove_ls(response &_return, const arg_list &args) {
-  if (args.size() != 2) {
+  run_ls(_return, args, ls_path());
+}
+
+void hash_table_partition::run_ls(response &_return, const arg_list &args, const std::string &path) {
+  auto cmd_id = command_id(args[0]);
+  bool has_value = cmd_id == hash_table_cmd_id::ht_put_ls || cmd_id == hash_table_cmd_id::ht_upsert_ls
+      || cmd_id == hash_table_cmd_id::ht_update_ls;
+  if (args.size() != (has_value ? 3 : 2)) {
     RETURN_ERR("!args_error");
   }
-  // Ordinary remove or buffered remove
-  std::unordered_map<std::string,std::string> ht;
-  std::string file_path, line, key, value;
-  int key_exist = 0;
-  file_path = directory_utils::remove_uri(backing_path());
-  directory_utils::push_path_element(file_path,name());
-  if (ser_name_ == "csv") {
-    std::ifstream in(file_path);
-    if (in) {
-      while(getline(in,line)) {
-        int split_index = line.find(",");
-        key = line.substr(0,split_index);
-        if (key == args[1]) {
-          key_exist = 1;
-          continue;
-        }
-        value = line.substr(split_index+1);
-        ht.insert({key,value});
-      }
-      in.close();
-    }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
-    }
-    if (key_exist == 1) {
-      std::ofstream out(file_path);
-      for (auto x: ht) {
-        out << (x.first) << "," << (x.second) << std::endl;
+  if (!open_ls_store(_return, path)) {
+    return;
+  }
+  switch (cmd_id) {
+    case hash_table_cmd_id::ht_exists_ls:
+      if (ls_store_->exists(args[1])) {
+        RETURN_OK();
       }
-      out.close();
-      RETURN_OK();
-    }
-    else {
       RETURN_ERR("!key_not_found");
-    }
-  }
-  else if (ser_name_ == "binary") {
-    std::ifstream in(file_path,std::ios::binary);
-    std::string offset_path = file_path;
-    offset_path.append("_offset");
-    std::ifstream offset_in(offset_path,std::ios::binary);
-    std::size_t key_size = 0;
-    std::size_t value_size = 0;
-    if (in && offset_in) {
-      while (offset_in.peek() != EOF) {
-        offset_in.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
-        key.resize(key_size);
-        offset_in.read(&key[0], key_size);
-        offset_in.read(reinterpret_cast<char *>(&value_size), sizeof(value_size));
-        if (key == args[1]) {
-          key_exist = 1;
-          in.read(&value[0], value_size);
-          continue;
-        }
-        value.resize(value_size);
-        in.read(&value[0], value_size);
-        ht.insert({key,value});
+    case hash_table_cmd_id::ht_get_ls: {
+      std::string value;
+      if (ls_store_->get(args[1], value)) {
+        RETURN_OK(value);
       }
-      in.close();
-      offset_in.close();
-    }
-    else {
-      RETURN_ERR("!hash_table_does_not_exist");
-    }
-    if (key_exist == 0) {
       RETURN_ERR("!key_not_found");
     }
-    std::ofstream out(file_path,std::ios::binary);
-    std::ofstream offset_out(offset_path,std::ios::binary);
-    for (auto x: ht) {
-      key_size = x.first.size();
-      value_size = x.second.size();
-      offset_out.write(reinterpret_cast<const char *>(&key_size), sizeof(size_t));
-      offset_out.write(reinterpret_cast<const char *>(x.first.data()), key_size);
-      offset_out.write(reinterpret_cast<const char *>(&value_size), sizeof(size_t));
-      out.write(reinterpret_cast<const char *>(x.second.data()), value_size);
-    }
-    out.close();
-    offset_out.close();
-    RETURN_OK();
+    case hash_table_cmd_id::ht_put_ls:
+      if (!ls_store_->put(args[1], args[2])) {
+        RETURN_ERR("!duplicate_key");
+      }
+      RETURN_OK();
+    case hash_table_cmd_id::ht_upsert_ls:ls_store_->upsert(args[1], args[2]);
+      RETURN_OK();
+    case hash_table_cmd_id::ht_update_ls:
+      if (!ls_store_->update(args[1], args[2])) {
+        RETURN_ERR("!key_not_found");
+      }
+      RETURN_OK();
+    case hash_table_cmd_id::ht_remove_ls:
+      if (!ls_store_->remove(args[1])) {
+        RETURN_ERR("!key_not_found");
+      }
+      RETURN_OK();
+    default:RETURN_ERR("!no_such_command");
   }
 }
 
+std::string hash_table_partition::ls_path() const {
+  auto file_path = directory_utils::remove_uri(backing_path());
+  directory_utils::push_path_element(file_path, name());
+  return file_path;
+}
+
+bool hash_table_partition::open_ls_store(response &_return, const std::string &path) {
+  if (ls_store_ == nullptr) {
+    _return = {"!unsupported_serializer"};
+    return false;
+  }
+  if (!ls_store_->open(path)) {
+    _return = {"!hash_table_does_not_exist"};
+    return false;
+  }
+  return true;
+}
+
 void hash_table_partition::scale_remove(response &_return, const arg_list &args) {
+  // Drop a whole slot range
+  if (args.size() == 4 && args[1] == "!slot_range") {
+    auto n_removed = block_.erase_slot_range(std::stoi(args[2]), std::stoi(args[3]));
+    RETURN_OK(std::to_string(n_removed));
+  }
   for (size_t i = 1; i < args.size(); ++i) {
     try {
       if (!block_.erase(make_temporary_binary(args[i]))) {
@@ -700,7 +555,7 @@ void hash_table_partition::scale_put(response &_return, const arg_list &args) {
       continue;
     }
     try {
-      if (!block_.emplace(make_binary(args[i]), make_binary(args[i + 1])).second) {
+      if (!block_.emplace(make_entry(args[i], args[i + 1])).second) {
         LOG(log_level::info) << "Unsuccessful scale put";
       }
     } catch (std::bad_alloc &e) {
@@ -718,19 +573,14 @@ void hash_table_partition::get_data_in_slot_range(response &_return, const arg_l
   auto slot_begin = std::stoi(args[1]);
   auto slot_end = std::stoi(args[2]);
   auto batch_size = std::stoull(args[3]);
-  for (const auto &entry: block_) {
-    auto slot = hash_slot::get(entry.first);
-    if (slot >= slot_begin && slot < slot_end) {
-      if (_return.empty())
-        _return.emplace_back("!ok");
-      _return.emplace_back(to_string(entry.first));
-      _return.emplace_back(to_string(entry.second));
-      n_items += 2;
-      if (n_items == static_cast<std::size_t>(batch_size)) {
-        return;
-      }
-    }
-  }
+  block_.visit_slot_range(slot_begin, slot_end, [&](const kv_pair_type &entry) {
+    if (_return.empty())
+      _return.emplace_back("!ok");
+    _return.emplace_back(to_string(entry.first));
+    _return.emplace_back(to_string(entry.second));
+    n_items += 2;
+    return n_items != static_cast<std::size_t>(batch_size);
+  });
   if (_return.empty()) {
     RETURN_ERR("!empty");
   }
@@ -807,50 +657,78 @@ void hash_table_partition::get_metadata(response &_return, const arg_list &args)
 
 void hash_table_partition::run_command(response &_return, const arg_list &args) {
   auto cmd_name = args[0];
-  switch (command_id(cmd_name)) {
-    case hash_table_cmd_id::ht_exists:exists(_return, args);
-      break;
-    case hash_table_cmd_id::ht_get:get(_return, args);
-      break;
-    case hash_table_cmd_id::ht_put:put(_return, args);
-      break;
-    case hash_table_cmd_id::ht_upsert:upsert(_return, args);
-      break;
-    case hash_table_cmd_id::ht_remove:remove(_return, args);
-      break;
-    case hash_table_cmd_id::ht_update:update(_return, args);
-      break;
-    case hash_table_cmd_id::ht_exists_ls:exists_ls(_return, args);
-      break;
-    case hash_table_cmd_id::ht_get_ls:get_ls(_return, args);
-      break;
-    case hash_table_cmd_id::ht_put_ls:put_ls(_return, args);
-      break;
-    case hash_table_cmd_id::ht_upsert_ls:upsert_ls(_return, args);
-      break;
-    case hash_table_cmd_id::ht_remove_ls:remove_ls(_return, args);
-      break;
-    case hash_table_cmd_id::ht_update_ls:update_ls(_return, args);
-      break;
-    case hash_table_cmd_id::ht_update_partition:update_partition(_return, args);;
-      break;
-    case hash_table_cmd_id::ht_get_storage_size:get_storage_size(_return, args);
-      break;
-    case hash_table_cmd_id::ht_get_metadata:get_metadata(_return, args);
-      break;
-    case hash_table_cmd_id::ht_get_range_data:get_data_in_slot_range(_return, args);
-      break;
-    case hash_table_cmd_id::ht_scale_put:scale_put(_return, args);
-      break;
-    case hash_table_cmd_id::ht_scale_remove:scale_remove(_return, args);
-      break;
-    default: {
-      _return.emplace_back("!no_such_command");
-      return;
+  {
+    // block_ is not thread-safe, and a read-modify-write must not interleave with other writes to its key
+    std::lock_guard<std::mutex> lock(command_lock_);
+    if (is_mutator(cmd_name) && snapshot_copy_.active()) {
+      changed_slots(args, [this](std::size_t begin, std::size_t end) {
+        snapshot_copy_.preserve(begin, end);
+      });
+    }
+    switch (command_id(cmd_name)) {
+      case hash_table_cmd_id::ht_exists:exists(_return, args);
+        break;
+      case hash_table_cmd_id::ht_get:get(_return, args);
+        break;
+      case hash_table_cmd_id::ht_put:put(_return, args);
+        break;
+      case hash_table_cmd_id::ht_upsert:upsert(_return, args);
+        break;
+      case hash_table_cmd_id::ht_remove:remove(_return, args);
+        break;
+      case hash_table_cmd_id::ht_update:update(_return, args);
+        break;
+      case hash_table_cmd_id::ht_exists_ls:exists_ls(_return, args);
+        break;
+      case hash_table_cmd_id::ht_get_ls:get_ls(_return, args);
+        break;
+      case hash_table_cmd_id::ht_put_ls:put_ls(_return, args);
+        break;
+      case hash_table_cmd_id::ht_upsert_ls:upsert_ls(_return, args);
+        break;
+      case hash_table_cmd_id::ht_remove_ls:remove_ls(_return, args);
+        break;
+      case hash_table_cmd_id::ht_update_ls:update_ls(_return, args);
+        break;
+      case hash_table_cmd_id::ht_update_partition:update_partition(_return, args);;
+        break;
+      case hash_table_cmd_id::ht_get_storage_size:get_storage_size(_return, args);
+        break;
+      case hash_table_cmd_id::ht_get_metadata:get_metadata(_return, args);
+        break;
+      case hash_table_cmd_id::ht_get_range_data:get_data_in_slot_range(_return, args);
+        break;
+      case hash_table_cmd_id::ht_scale_put:scale_put(_return, args);
+        break;
+      case hash_table_cmd_id::ht_scale_remove:scale_remove(_return, args);
+        break;
+      case hash_table_cmd_id::ht_mget:mget(_return, args);
+        break;
+      case hash_table_cmd_id::ht_mput:mput(_return, args);
+        break;
+      case hash_table_cmd_id::ht_mupsert:mupsert(_return, args);
+        break;
+      case hash_table_cmd_id::ht_mremove:mremove(_return, args);
+        break;
+      case hash_table_cmd_id::ht_cas:cas(_return, args);
+        break;
+      case hash_table_cmd_id::ht_incr:incr(_return, args);
+        break;
+      case hash_table_cmd_id::ht_append:append(_return, args);
+        break;
+      default: {
+        _return.emplace_back("!no_such_command");
+        return;
+      }
+    }
+    if (is_mutator(cmd_name)) {
+      dirty_ = true;
+      mark_dirty(args);
+      log_mutation(args);
     }
   }
-  if (is_mutator(cmd_name)) {
-    dirty_ = true;
+  if (replaying_log()) {
+    return;
   }
   if (auto_scale_ && is_mutator(cmd_name) && overload() && metadata_ != "exporting" && metadata_ != "importing"
       && is_tail() && !scaling_up_ && !scaling_down_) {
@@ -869,7 +747,7 @@ void hash_table_partition::run_command(response &_return, const arg_list &args)
       LOG(log_level::warn) << "Split slot range failed: " << e.what();
     }
   }
-  if (auto_scale_ && cmd_name == "remove" && underload() && metadata_ != "exporting" && metadata_ != "importing"
+  if (auto_scale_ && (cmd_name == "remove" || cmd_name == "mremove") && underload() && metadata_ != "exporting" && metadata_ != "importing"
       && name() != "0_65536" && is_tail() && !scaling_down_ && !scaling_up_) {
     LOG(log_level::info) << "Underloaded partition; storage = " << storage_size() << " capacity = "
                          << storage_capacity() << " slot range = (" << slot_begin() << ", " << slot_end() << ")";
@@ -887,6 +765,37 @@ void hash_table_partition::run_command(response &_return, const arg_list &args)
   }
 }
 
+bool hash_table_partition::run_command_async(const arg_list &args, std::function<void(const response &)> done) {
+  switch (command_id(args[0])) {
+    case hash_table_cmd_id::ht_exists_ls:
+    case hash_table_cmd_id::ht_get_ls:
+    case hash_table_cmd_id::ht_put_ls:
+    case hash_table_cmd_id::ht_upsert_ls:
+    case hash_table_cmd_id::ht_remove_ls:
+    case hash_table_cmd_id::ht_update_ls:break;
+    default:return false;
+  }
+  if (is_mutator(args[0])) {
+    // The next sync has to see the command even if it runs before the command reaches the disk
+    std::lock_guard<std::mutex> lock(command_lock_);
+    if (snapshot_copy_.active()) {
+      changed_slots(args, [this](std::size_t begin, std::size_t end) {
+        snapshot_copy_.preserve(begin, end);
+      });
+    }
+    dirty_ = true;
+    mark_dirty(args);
+  }
+  // The path is resolved here since update_partition renames the partition on this thread
+  auto path = ls_path();
+  ls_queue_.submit([this, args, path, done] {
+    response result;
+    run_ls(result, args, path);
+    done(result);
+  });
+  return true;
+}
+
 std::size_t hash_table_partition::size() const {
   return block_.size();
 }
@@ -900,30 +809,97 @@ bool hash_table_partition::is_dirty() const {
 }
 
 void hash_table_partition::load(const std::string &path) {
+  // Snapshots of the path by any partition must land before it is read
+  persistent::snapshot_writer::instance()->wait_all();
   auto remote = persistent::persistent_store::instance(path, ser_);
   auto decomposed = persistent::persistent_store::decompose_path(path);
+  // A base image replaced up to a crash is either finished or left untouched
+  remote->recover_base(decomposed.second);
+  if (decomposed.first == "local" && ls_store_ != nullptr) {
+    // Fold *_ls mutations into the file before reading it
+    ls_store_->flush(decomposed.second);
+  }
   remote->read<hash_table_type>(decomposed.second, block_);
+  std::uint64_t covered_segment = 0;
+  auto replayed = remote->replay_deltas(decomposed.second, [this](const persistent::delta &d) {
+    apply_delta(d);
+  }, &covered_segment);
+  deltas_.reset(path, replayed.first, replayed.second);
+  dirty_slots_.clear();
+  // Commands logged after the snapshot make the partition dirty again; those it holds are not replayed
+  covered_segment = std::max(covered_segment, remote->read_log_segment(decomposed.second));
+  replay_log([this](const arg_list &args) {
+    response result;
+    run_command(result, args);
+  }, covered_segment);
 }
 
-bool hash_table_partition::sync(const std::string &path) {
+bool hash_table_partition::snapshot(const std::string &path) {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mtx_);
+  auto synced = capture_snapshot(path);
+  // A base image is copied one hash slot at a time while commands run
+  finish_snapshot(&command_lock_);
+  return synced;
+}
+
+bool hash_table_partition::capture_snapshot(const std::string &path) {
+  freeze_guard freeze(*this);
+  if (!freeze.frozen()) {
+    LOG(log_level::warn) << "Commands on partition " << name() << " did not drain, skipping snapshot";
+    return false;
+  }
+  // The first sync to a path writes a base image, even if the data was not added through commands
+  if (snapshot_failed() || (!dirty_ && !block_.empty() && !deltas_.has_base(path))) {
+    dirty_ = true;
+    dirty_slots_.add_all();
+  }
   if (dirty_) {
-    auto remote = persistent::persistent_store::instance(path, ser_);
-    auto decomposed = persistent::persistent_store::decompose_path(path);
-    remote->write<hash_table_type>(block_, decomposed.second);
+    bool synced = true;
+    if (dirty_slots_.all()) {
+      snapshot_base(path);
+    } else if (dirty_slots_.empty()) {
+      synced = false;
+    } else {
+      auto d = std::make_shared<persistent::delta>(make_delta());
+      persistent::set_log_segment(*d, sealed_log_segment());
+      auto delta_bytes = persistent::delta_size(*d);
+      if (deltas_.can_append(path, delta_bytes, storage_size())) {
+        auto seq = deltas_.append(delta_bytes);
+        auto ser = ser_;
+        persist(delta_bytes, [ser, path, d, seq] {
+          auto remote = persistent::persistent_store::instance(path, ser);
+          auto decomposed = persistent::persistent_store::decompose_path(path);
+          remote->write_delta(*d, decomposed.second, seq);
+        });
+      } else {
+        snapshot_base(path);
+      }
+    }
+    dirty_slots_.clear();
     dirty_ = false;
-    return true;
+    return synced;
   }
   return false;
 }
 
+bool hash_table_partition::sync(const std::string &path) {
+  auto synced = snapshot(path);
+  wait_snapshots();
+  return synced;
+}
+
 bool hash_table_partition::dump(const std::string &path) {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mtx_);
+  wait_snapshots();
   bool flushed = false;
-  if (dirty_) {
-    auto remote = persistent::persistent_store::instance(path, ser_);
-    auto decomposed = persistent::persistent_store::decompose_path(path);
-    remote->write<hash_table_type>(block_, decomposed.second);
+  // The *_ls commands only read the base image, so fold deltas into it as well
+  if (dirty_ || deltas_.num_deltas() > 0) {
+    write_base(path);
     flushed = true;
   }
+  discard_log();
+  dirty_slots_.clear();
+  deltas_.clear();
   block_.clear();
   next_->reset("nil");
   path_ = "";
@@ -938,6 +914,143 @@ bool hash_table_partition::dump(const std::string &path) {
   return flushed;
 }
 
+void hash_table_partition::changed_slots(const arg_list &args,
+                                         const std::function<void(std::size_t, std::size_t)> &visit) {
+  switch (command_id(args[0])) {
+    case hash_table_cmd_id::ht_put:
+    case hash_table_cmd_id::ht_upsert:
+    case hash_table_cmd_id::ht_update:
+    case hash_table_cmd_id::ht_remove:
+    case hash_table_cmd_id::ht_cas:
+    case hash_table_cmd_id::ht_incr:
+    case hash_table_cmd_id::ht_append:
+      if (args.size() > 1) {
+        auto slot = static_cast<std::size_t>(hash_slot::get(args[1]));
+        visit(slot, slot + 1);
+      }
+      break;
+    case hash_table_cmd_id::ht_mput:
+    case hash_table_cmd_id::ht_mupsert:
+    case hash_table_cmd_id::ht_scale_put:
+      for (std::size_t i = 1; i < args.size(); i += 2) {
+        auto slot = static_cast<std::size_t>(hash_slot::get(args[i]));
+        visit(slot, slot + 1);
+      }
+      break;
+    case hash_table_cmd_id::ht_scale_remove:
+      if (args.size() == 4 && args[1] == "!slot_range") {
+        visit(static_cast<std::size_t>(std::max(std::stoi(args[2]), 0)),
+              static_cast<std::size_t>(std::max(std::stoi(args[3]), 0)));
+      } else {
+        for (std::size_t i = 1; i < args.size(); ++i) {
+          auto slot = static_cast<std::size_t>(hash_slot::get(args[i]));
+          visit(slot, slot + 1);
+        }
+      }
+      break;
+    case hash_table_cmd_id::ht_mremove:
+      for (std::size_t i = 1; i < args.size(); ++i) {
+        auto slot = static_cast<std::size_t>(hash_slot::get(args[i]));
+        visit(slot, slot + 1);
+      }
+      break;
+    default:
+      // The *_ls commands change the base image underneath the deltas and update_partition may drop
+      // buffered keys, so the next sync rewrites the base image
+      visit(0, std::numeric_limits<std::size_t>::max());
+      break;
+  }
+}
+
+void hash_table_partition::mark_dirty(const arg_list &args) {
+  changed_slots(args, [this](std::size_t begin, std::size_t end) {
+    if (end == std::numeric_limits<std::size_t>::max()) {
+      dirty_slots_.add_all();
+    } else {
+      dirty_slots_.add_range(begin, end);
+    }
+  });
+}
+
+void hash_table_partition::log_mutation(const arg_list &args) {
+  switch (command_id(args[0])) {
+    case hash_table_cmd_id::ht_put_ls:
+    case hash_table_cmd_id::ht_upsert_ls:
+    case hash_table_cmd_id::ht_remove_ls:
+    case hash_table_cmd_id::ht_update_ls:
+    case hash_table_cmd_id::ht_update_partition:
+      // The *_ls commands write the persistent store themselves, and partition updates are driven by
+      // the directory rather than by clients
+      break;
+    default:
+      // Only the tail syncs the partition, so only the tail logs it
+      if (is_tail()) {
+        log_command(args);
+      }
+      break;
+  }
+}
+
+persistent::delta hash_table_partition::make_delta() const {
+  persistent::delta d;
+  for (auto slot: dirty_slots_.units()) {
+    persistent::delta_record r{slot, {}};
+    auto s = static_cast<int32_t>(slot);
+    block_.visit_slot_range(s, s + 1, [&r](const kv_pair_type &entry) {
+      r.items.push_back(to_string(entry.first));
+      r.items.push_back(to_string(entry.second));
+      return true;
+    });
+    d.push_back(std::move(r));
+  }
+  return d;
+}
+
+void hash_table_partition::apply_delta(const persistent::delta &d) {
+  for (const auto &r: d) {
+    auto slot = static_cast<int32_t>(r.id);
+    block_.erase_slot_range(slot, slot + 1);
+    for (std::size_t i = 0; i + 1 < r.items.size(); i += 2) {
+      block_.emplace(make_entry(r.items[i], r.items[i + 1]));
+    }
+  }
+}
+
+void hash_table_partition::write_base(const std::string &path) {
+  auto remote = persistent::persistent_store::instance(path, ser_);
+  auto decomposed = persistent::persistent_store::decompose_path(path);
+  remote->write_base<hash_table_type>(block_, decomposed.second, sealed_log_segment());
+  if (decomposed.first == "local" && ls_store_ != nullptr) {
+    ls_store_->discard(decomposed.second);
+  }
+  deltas_.reset(path);
+}
+
+void hash_table_partition::snapshot_base(const std::string &path) {
+  auto snap = std::make_shared<data_snapshot<hash_table_type>>();
+  auto alloc = snap->build_allocator<uint8_t>();
+  snap->data.reset(new hash_table_type(block_.index_type()));
+  snap->data->reserve(block_.size());
+  deltas_.reset(path);
+  auto ser = ser_;
+  auto ls_store = ls_store_;
+  auto log_segment = sealed_log_segment();
+  start_snapshot(hash_slot::MAX, [this, snap, alloc](std::size_t slot) {
+    auto s = static_cast<int32_t>(slot);
+    block_.visit_slot_range(s, s + 1, [&snap, &alloc](const kv_pair_type &entry) {
+      snap->data->emplace(binary(to_string(entry.first), alloc), binary(to_string(entry.second), alloc));
+      return true;
+    });
+  }, storage_size(), [ser, path, snap, ls_store, log_segment] {
+    auto remote = persistent::persistent_store::instance(path, ser);
+    auto decomposed = persistent::persistent_store::decompose_path(path);
+    remote->write_base<hash_table_type>(*snap->data, decomposed.second, log_segment);
+    if (decomposed.first == "local" && ls_store != nullptr) {
+      ls_store->discard(decomposed.second);
+    }
+  });
+}
+
 void hash_table_partition::forward_all() {
   int64_t i = 0;
   for (const auto &entry: block_) {
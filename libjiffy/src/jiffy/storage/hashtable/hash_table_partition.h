@@ -1,11 +1,16 @@
 #ifndef JIFFY_KV_SERVICE_SHARD_H
 #define JIFFY_KV_SERVICE_SHARD_H
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <jiffy/utils/property_map.h>
 #include "jiffy/storage/serde/serde_all.h"
+#include "jiffy/storage/hashtable/hash_table_log_store.h"
 #include "jiffy/storage/partition.h"
 #include "jiffy/persistent/persistent_service.h"
+#include "jiffy/persistent/task_queue.h"
 #include "jiffy/storage/chain_module.h"
 #include "jiffy/storage/hashtable/hash_table_ops.h"
 #include "hash_table_defs.h"
@@ -196,6 +201,60 @@ class hash_table_partition : public chain_module {
    */
   void remove(response &_return, const arg_list &args);
 
+  /**
+   * @brief Get values for multiple keys
+   * Response is "!ok" followed by, for each key, the size of its get
+   * response and the get response itself
+   * @param _return Response
+   * @param args Arguments
+   */
+  void mget(response &_return, const arg_list &args);
+
+  /**
+   * @brief Insert multiple key value pairs, with per-key responses as in mget
+   * @param _return Response
+   * @param args Arguments
+   */
+  void mput(response &_return, const arg_list &args);
+
+  /**
+   * @brief Insert or update multiple key value pairs, with per-key responses as in mget
+   * @param _return Response
+   * @param args Arguments
+   */
+  void mupsert(response &_return, const arg_list &args);
+
+  /**
+   * @brief Remove multiple keys, with per-key responses as in mget
+   * @param _return Response
+   * @param args Arguments
+   */
+  void mremove(response &_return, const arg_list &args);
+
+  /**
+   * @brief Replace the value of a key only if it equals the expected value
+   * Response is "!ok" on success and "!cas_failed" with the current value otherwise
+   * @param _return Response
+   * @param args Arguments
+   */
+  void cas(response &_return, const arg_list &args);
+
+  /**
+   * @brief Add a delta to the decimal integer value of a key, treating a missing key as 0
+   * Response is "!ok" with the new value
+   * @param _return Response
+   * @param args Arguments
+   */
+  void incr(response &_return, const arg_list &args);
+
+  /**
+   * @brief Append a suffix to the value of a key, treating a missing key as empty
+   * Response is "!ok" with the new value size
+   * @param _return Response
+   * @param args Arguments
+   */
+  void append(response &_return, const arg_list &args);
+
  /**
    * @brief Check if hash map contains key
    * @param _return Response
@@ -240,6 +299,8 @@ class hash_table_partition : public chain_module {
 
   /**
    * @brief Remove key from hash table during scaling
+   * Arguments are either the keys to remove, or "!slot_range" followed by the
+   * begin and end slot to drop all keys in that slot range
    * @param _return Response
    * @param args Arguments
    */
@@ -300,6 +361,15 @@ class hash_table_partition : public chain_module {
    */
   void run_command(response &_return, const arg_list &args) override;
 
+  /**
+   * @brief Run the *_ls commands on a background task queue, since they wait for the disk
+   * The commands of the partition keep their order among themselves
+   * @param args Operation arguments
+   * @param done Called with the response on the task queue
+   * @return Bool value, true for the *_ls commands
+   */
+  bool run_command_async(const arg_list &args, std::function<void(const response &)> done) override;
+
   /**
    * @brief Atomically check dirty bit
    * @return Bool value, true if block is dirty
@@ -307,20 +377,31 @@ class hash_table_partition : public chain_module {
   bool is_dirty() const;
 
   /**
-   * @brief Load persistent data into the block, lock the block while doing this
+   * @brief Load persistent data into the block, replaying the deltas of the base image and then the
+   * write-ahead log, if hashtable.wal is set
    * @param path Persistent storage path
    */
   void load(const std::string &path) override;
 
   /**
-   * @brief If dirty, synchronize persistent storage and block
+   * @brief If dirty, capture the block and persist it on the snapshot writer
+   * Only the hash slots changed since the previous snapshot are written as a delta, unless the
+   * deltas outgrow hashtable.sync_max_deltas or hashtable.sync_delta_ratio
+   * @param path Persistent storage path
+   * @return Bool value, true if block successfully captured
+   */
+  bool snapshot(const std::string &path) override;
+
+  /**
+   * @brief If dirty, synchronize persistent storage and block, waiting for the snapshot to be written
    * @param path Persistent storage path
    * @return Bool value, true if block successfully synchronized
    */
   bool sync(const std::string &path) override;
 
   /**
-   * @brief Flush the block if dirty and clear the block
+   * @brief Flush the block as a single base image if dirty or extended by deltas, remove the write-ahead
+   * log and clear the block
    * @param path Persistent storage path
    * @return Bool value, true if block successfully dumped
    */
@@ -332,6 +413,104 @@ class hash_table_partition : public chain_module {
   void forward_all() override;
 
  private:
+  /* Computes the new value of a key from its current value, null if the key does not exist.
+   * Returns false with the response set if the value must not be written. */
+  typedef std::function<bool(response &, const std::string *, std::string &)> rmw_function;
+
+  /**
+   * @brief Run a read-modify-write command
+   * The partition exporting the key forwards its current value without changing it, and the importing
+   * partition applies the command to that value unless it already holds the key, so the command is
+   * written once even if the redirect is resent
+   * @param _return Response
+   * @param args Arguments
+   * @param num_args Number of command arguments after the key
+   * @param compute Function computing the new value
+   */
+  void read_modify_write(response &_return, const arg_list &args, std::size_t num_args, const rmw_function &compute);
+
+  /**
+   * @brief Build the response of a successful read-modify-write command
+   * @param _return Response
+   * @param cmd_name Command name
+   * @param value New value
+   */
+  static void rmw_response(response &_return, const std::string &cmd_name, const std::string &value);
+
+  /**
+   * @brief Visit the hash slots a mutator command changes
+   * @param args Command arguments
+   * @param visit Function called with each range of slots [begin, end) the command changes; the end is
+   * std::numeric_limits<std::size_t>::max() if the command may change any slot
+   */
+  void changed_slots(const arg_list &args, const std::function<void(std::size_t, std::size_t)> &visit);
+
+  /**
+   * @brief Mark the hash slots a mutator command touched dirty
+   * @param args Command arguments
+   */
+  void mark_dirty(const arg_list &args);
+
+  /**
+   * @brief Append a mutator command to the write-ahead log, unless its effect is persisted otherwise
+   * @param args Command arguments
+   */
+  void log_mutation(const arg_list &args);
+
+  /**
+   * @brief Collect the entries of the dirty hash slots
+   * @return Delta with one record per dirty hash slot, holding its keys and values in turn
+   */
+  persistent::delta make_delta() const;
+
+  /**
+   * @brief Replace the hash slots of a delta with its entries
+   * @param d Delta
+   */
+  void apply_delta(const persistent::delta &d);
+
+  /**
+   * @brief Write the whole block as the base image of a path and drop its deltas
+   * @param path Persistent storage path
+   */
+  void write_base(const std::string &path);
+
+  /**
+   * @brief Capture the block while frozen, starting a base image or persisting a delta
+   * @param path Persistent storage path
+   * @return Bool value, true if block successfully captured
+   */
+  bool capture_snapshot(const std::string &path);
+
+  /**
+   * @brief Start copying the block one hash slot at a time, to be persisted as the base image of a path
+   * @param path Persistent storage path
+   */
+  void snapshot_base(const std::string &path);
+
+  /**
+   * @brief Fetch the local path of the file the *_ls commands operate on
+   * @return File path
+   */
+  std::string ls_path() const;
+
+  /**
+   * @brief Open the log store on the file the *_ls commands operate on
+   * @param _return Response, set to the error if the store cannot be opened
+   * @param path File path
+   * @return Bool value, true if the store is open
+   */
+  bool open_ls_store(response &_return, const std::string &path);
+
+  /**
+   * @brief Run a *_ls command on the log store, without the command lock since the store does its own
+   * locking
+   * @param _return Response
+   * @param args Arguments
+   * @param path File the command operates on
+   */
+  void run_ls(response &_return, const arg_list &args, const std::string &path);
+
   /**
    * @brief Check if block is overloaded
    * @return Bool value, true if block size is over the high threshold capacity
@@ -358,15 +537,34 @@ class hash_table_partition : public chain_module {
     return binary(str, temporary_data_allocator_);
   }
 
-  /* Cuckoo hash map partition */
-  std::unordered_map<key_type, value_type, hash_type, equal_type> block_;
+  /**
+   * @brief Construct key and value binary strings for a new entry
+   * @param key Key
+   * @param value Value
+   * @return Key and value, in one allocation if hashtable.single_allocation is set
+   */
+  std::pair<binary, binary> make_entry(const std::string &key, const std::string &value) {
+    if (single_allocation_) {
+      return binary::make_pair(key, value, binary_allocator_);
+    }
+    return std::make_pair(make_binary(key), make_binary(value));
+  }
+
+  /* Hash table index, implementation selected by hashtable.index */
+  hash_table_type block_;
+
+  /* Store key and value of an entry in one allocation */
+  bool single_allocation_;
 
   /* Custom serializer/deserializer */
   std::shared_ptr<serde> ser_;
 
-  /* Name of format, either binary or csv */
+  /* Name of format: csv, binary, binary_lz4, binary_zstd or indexed */
   std::string ser_name_;
 
+  /* Log-structured engine for the *_ls commands, shared with snapshot jobs; null for compressed formats */
+  std::shared_ptr<hash_table_log_store> ls_store_;
+
   /* Low threshold */
   double threshold_lo_;
 
@@ -382,6 +580,12 @@ class hash_table_partition : public chain_module {
   /* Bool partition dirty bit */
   bool dirty_;
 
+  /* Hash slots changed since the previous sync */
+  persistent::dirty_set dirty_slots_;
+
+  /* Deltas extending the base image */
+  persistent::delta_log deltas_;
+
   /* Hash slot range */
   std::pair<int32_t, int32_t> slot_range_;
 
@@ -409,6 +613,9 @@ class hash_table_partition : public chain_module {
   /* Data update mutex, we want only one update function happen at a time */
   std::mutex update_lock_;
 
+  /* Command mutex, commands on the block run one at a time */
+  std::mutex command_lock_;
+
   /* Buffer remove cache */
   std::map<std::string, int> remove_cache_;
 
@@ -418,6 +625,8 @@ class hash_table_partition : public chain_module {
   /* Temporary data manager */
   block_memory_manager* temporary_data_manager_;
 
+  /* Runs the *_ls commands of the tail, declared last so that they finish before other members are destroyed */
+  persistent::task_queue ls_queue_;
 };
 
 }
@@ -0,0 +1,604 @@
+#ifndef JIFFY_OPEN_HASH_TABLE_H
+#define JIFFY_OPEN_HASH_TABLE_H
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace jiffy {
+namespace storage {
+
+namespace open_hash_table_detail {
+
+/* Control byte: 0b0xxxxxxx marks a full slot (low 7 bits are the tag), negative values mark free slots */
+typedef int8_t ctrl_t;
+
+/* Control byte for a slot that was never used */
+constexpr ctrl_t CTRL_EMPTY = -128;
+
+/* Control byte for a slot whose entry was erased (tombstone) */
+constexpr ctrl_t CTRL_DELETED = -2;
+
+/**
+ * @brief Check if control byte marks a full slot
+ * @param c Control byte
+ * @return Bool value, true if full
+ */
+inline bool is_full(ctrl_t c) {
+  return c >= 0;
+}
+
+/* Bit mask over the slots of a probe group, iterated from the lowest set position */
+class group_mask {
+ public:
+  group_mask(uint64_t mask, int shift) : mask_(mask), shift_(shift) {}
+
+  explicit operator bool() const {
+    return mask_ != 0;
+  }
+
+  size_t lowest() const {
+    return static_cast<size_t>(__builtin_ctzll(mask_)) >> shift_;
+  }
+
+  void clear_lowest() {
+    mask_ &= (mask_ - 1);
+  }
+
+ private:
+  /* Match bits */
+  uint64_t mask_;
+  /* Log2 of the number of bits per slot in the mask */
+  int shift_;
+};
+
+#if defined(__SSE2__)
+
+/* Probe group of 16 control bytes, matched with SSE2 byte compares */
+class probe_group {
+ public:
+  static constexpr size_t WIDTH = 16;
+
+  explicit probe_group(const ctrl_t *pos)
+      : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+  group_mask match(ctrl_t tag) const {
+    auto m = _mm_cmpeq_epi8(_mm_set1_epi8(tag), ctrl_);
+    return group_mask(static_cast<uint32_t>(_mm_movemask_epi8(m)), 0);
+  }
+
+  group_mask match_empty() const {
+    return match(CTRL_EMPTY);
+  }
+
+  group_mask match_free() const {
+    // Empty and deleted slots are exactly the ones with the sign bit set
+    return group_mask(static_cast<uint32_t>(_mm_movemask_epi8(ctrl_)), 0);
+  }
+
+ private:
+  __m128i ctrl_;
+};
+
+#else
+
+/* Probe group of 8 control bytes, matched with word-at-a-time bit tricks */
+class probe_group {
+ public:
+  static constexpr size_t WIDTH = 8;
+
+  explicit probe_group(const ctrl_t *pos) {
+    std::memcpy(&ctrl_, pos, sizeof(ctrl_));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    ctrl_ = __builtin_bswap64(ctrl_);
+#endif
+  }
+
+  group_mask match(ctrl_t tag) const {
+    // May report a false positive on a full slot next to a true match; callers compare keys anyway
+    auto x = ctrl_ ^ (LSBS * static_cast<uint8_t>(tag));
+    return group_mask((x - LSBS) & ~x & MSBS, 3);
+  }
+
+  group_mask match_empty() const {
+    // Empty (0x80) is the only control byte with bit 7 set and bit 1 clear
+    return group_mask((ctrl_ & (~ctrl_ << 6)) & MSBS, 3);
+  }
+
+  group_mask match_free() const {
+    return group_mask(ctrl_ & MSBS, 3);
+  }
+
+ private:
+  static constexpr uint64_t LSBS = 0x0101010101010101ULL;
+  static constexpr uint64_t MSBS = 0x8080808080808080ULL;
+  uint64_t ctrl_;
+};
+
+#endif
+
+}
+
+/**
+ * Open-addressing hash table with one control byte per slot (swiss table layout).
+ *
+ * Control bytes carry a 7-bit tag of the hash and are probed a group at a time,
+ * so most lookups touch a single control cache line and a single slot.
+ * The full hash is stored next to each entry so that tag collisions are rejected
+ * without reading the key, and growing never rehashes keys.
+ * The interface follows the subset of std::unordered_map used by the hash table partition.
+ */
+template<typename Key, typename Value, typename Hash, typename Equal>
+class open_hash_table {
+ public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef std::pair<const Key, Value> value_type;
+  typedef std::size_t size_type;
+
+ private:
+  typedef open_hash_table_detail::ctrl_t ctrl_t;
+  typedef open_hash_table_detail::probe_group probe_group;
+  typedef std::pair<Key, Value> mutable_value_type;
+
+  /* Slot storage, the entry is only constructed while the slot is full */
+  struct slot_type {
+    slot_type() {}
+    ~slot_type() {}
+
+    std::size_t hash;
+    union {
+      value_type value;
+      mutable_value_type mutable_value;
+    };
+  };
+
+  template<typename TableT, typename Ref, typename Ptr>
+  class basic_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename open_hash_table::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Ptr pointer;
+    typedef Ref reference;
+
+    basic_iterator() : table_(nullptr), idx_(0) {}
+
+    basic_iterator(TableT *table, size_t idx) : table_(table), idx_(idx) {}
+
+    template<typename OtherTableT, typename OtherRef, typename OtherPtr>
+    basic_iterator(const basic_iterator<OtherTableT, OtherRef, OtherPtr> &other)
+        : table_(other.table_), idx_(other.idx_) {}
+
+    Ref operator*() const {
+      return table_->slots_[idx_].value;
+    }
+
+    Ptr operator->() const {
+      return &table_->slots_[idx_].value;
+    }
+
+    basic_iterator &operator++() {
+      idx_ = table_->next_full(idx_ + 1);
+      return *this;
+    }
+
+    basic_iterator operator++(int) {
+      basic_iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const basic_iterator &other) const {
+      return idx_ == other.idx_;
+    }
+
+    bool operator!=(const basic_iterator &other) const {
+      return idx_ != other.idx_;
+    }
+
+   private:
+    template<typename, typename, typename> friend
+    class basic_iterator;
+    friend class open_hash_table;
+
+    /* Table being iterated */
+    TableT *table_;
+    /* Slot index, equal to the table capacity at the end */
+    size_t idx_;
+  };
+
+ public:
+  typedef basic_iterator<open_hash_table, value_type &, value_type *> iterator;
+  typedef basic_iterator<const open_hash_table, const value_type &, const value_type *> const_iterator;
+
+  /**
+   * @brief Constructor
+   * @param hash Hash function
+   * @param equal Key equality function
+   */
+  explicit open_hash_table(const Hash &hash = Hash(), const Equal &equal = Equal())
+      : ctrl_(nullptr),
+        slots_(nullptr),
+        capacity_(0),
+        size_(0),
+        growth_left_(0),
+        generation_(0),
+        hash_(hash),
+        equal_(equal) {}
+
+  open_hash_table(const open_hash_table &other)
+      : open_hash_table(other.hash_, other.equal_) {
+    reserve(other.size_);
+    for (const auto &e: other) {
+      emplace(e.first, e.second);
+    }
+  }
+
+  open_hash_table(open_hash_table &&other) noexcept
+      : open_hash_table(other.hash_, other.equal_) {
+    swap(other);
+  }
+
+  open_hash_table &operator=(open_hash_table other) {
+    swap(other);
+    return *this;
+  }
+
+  /**
+   * @brief Destructor
+   */
+  ~open_hash_table() {
+    destroy_all();
+    release(ctrl_, slots_);
+  }
+
+  /**
+   * @brief Swap contents with another table
+   * @param other Other table
+   */
+  void swap(open_hash_table &other) noexcept {
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(slots_, other.slots_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(growth_left_, other.growth_left_);
+    std::swap(generation_, other.generation_);
+    std::swap(hash_, other.hash_);
+    std::swap(equal_, other.equal_);
+  }
+
+  iterator begin() {
+    return iterator(this, next_full(0));
+  }
+
+  iterator end() {
+    return iterator(this, capacity_);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, next_full(0));
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, capacity_);
+  }
+
+  size_type size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /**
+   * @brief Fetch number of slots
+   * @return Number of slots
+   */
+  size_type capacity() const {
+    return capacity_;
+  }
+
+  /**
+   * @brief Fetch number of times entries were relocated
+   * Pointers to entries stay valid as long as the generation does not change
+   * @return Generation
+   */
+  size_type generation() const {
+    return generation_;
+  }
+
+  /**
+   * @brief Find entry by key
+   * @param key Key
+   * @return Iterator to the entry, end() if not found
+   */
+  template<typename K>
+  iterator find(const K &key) {
+    return iterator(this, find_index(key, hash_of(key)));
+  }
+
+  template<typename K>
+  const_iterator find(const K &key) const {
+    return const_iterator(this, find_index(key, hash_of(key)));
+  }
+
+  template<typename K>
+  size_type count(const K &key) const {
+    return find_index(key, hash_of(key)) != capacity_ ? 1 : 0;
+  }
+
+  template<typename K>
+  Value &at(const K &key) {
+    auto idx = find_index(key, hash_of(key));
+    if (idx == capacity_) {
+      throw std::out_of_range("open_hash_table::at");
+    }
+    return slots_[idx].value.second;
+  }
+
+  template<typename K>
+  const Value &at(const K &key) const {
+    auto idx = find_index(key, hash_of(key));
+    if (idx == capacity_) {
+      throw std::out_of_range("open_hash_table::at");
+    }
+    return slots_[idx].value.second;
+  }
+
+  /**
+   * @brief Insert entry if key does not exist
+   * @param key Key
+   * @param value Value
+   * @return Pair of iterator to the entry with this key and bool value, true if inserted
+   */
+  template<typename K, typename V>
+  std::pair<iterator, bool> emplace(K &&key, V &&value) {
+    auto hash = hash_of(key);
+    auto idx = find_index(key, hash);
+    if (idx != capacity_) {
+      return std::make_pair(iterator(this, idx), false);
+    }
+    idx = prepare_insert(hash);
+    new(&slots_[idx].mutable_value) mutable_value_type(std::forward<K>(key), std::forward<V>(value));
+    commit_insert(idx, hash);
+    return std::make_pair(iterator(this, idx), true);
+  }
+
+  template<typename K, typename V>
+  std::pair<iterator, bool> emplace(std::pair<K, V> &&entry) {
+    return emplace(std::move(entry.first), std::move(entry.second));
+  }
+
+  /**
+   * @brief Erase entry by key
+   * @param key Key
+   * @return Number of erased entries
+   */
+  template<typename K>
+  size_type erase(const K &key) {
+    auto idx = find_index(key, hash_of(key));
+    if (idx == capacity_) {
+      return 0;
+    }
+    erase_at(idx);
+    return 1;
+  }
+
+  /**
+   * @brief Erase entry at position
+   * @param pos Iterator to the entry
+   * @return Iterator to the following entry
+   */
+  iterator erase(const_iterator pos) {
+    erase_at(pos.idx_);
+    return iterator(this, next_full(pos.idx_ + 1));
+  }
+
+  iterator erase(iterator pos) {
+    return erase(const_iterator(pos));
+  }
+
+  /**
+   * @brief Remove all entries, keeping the allocated slots
+   */
+  void clear() {
+    destroy_all();
+    if (capacity_ != 0) {
+      std::memset(ctrl_, open_hash_table_detail::CTRL_EMPTY, capacity_ + probe_group::WIDTH);
+    }
+    size_ = 0;
+    growth_left_ = max_load(capacity_);
+  }
+
+  /**
+   * @brief Make room for a number of entries without further growth
+   * @param count Number of entries
+   */
+  void reserve(size_type count) {
+    if (count <= size_ + growth_left_) {
+      return;
+    }
+    size_t cap = probe_group::WIDTH;
+    while (max_load(cap) < count) {
+      cap <<= 1;
+    }
+    resize(cap);
+  }
+
+ private:
+  /**
+   * @brief Maximum number of entries for a capacity (7/8 load factor)
+   */
+  static size_t max_load(size_t capacity) {
+    return capacity - capacity / 8;
+  }
+
+  /**
+   * @brief Hash key and mix the result, so that both tag and probe start are well distributed
+   */
+  template<typename K>
+  std::size_t hash_of(const K &key) const {
+    return static_cast<std::size_t>(static_cast<uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ULL);
+  }
+
+  static ctrl_t tag_of(std::size_t hash) {
+    return static_cast<ctrl_t>(static_cast<uint64_t>(hash) >> 57);
+  }
+
+  template<typename K>
+  size_t find_index(const K &key, std::size_t hash) const {
+    if (capacity_ == 0) {
+      return capacity_;
+    }
+    auto mask = capacity_ - 1;
+    auto tag = tag_of(hash);
+    size_t offset = hash & mask;
+    size_t step = 0;
+    while (true) {
+      probe_group g(ctrl_ + offset);
+      for (auto m = g.match(tag); m; m.clear_lowest()) {
+        auto idx = (offset + m.lowest()) & mask;
+        if (slots_[idx].hash == hash && equal_(slots_[idx].value.first, key)) {
+          return idx;
+        }
+      }
+      if (g.match_empty()) {
+        return capacity_;
+      }
+      step += probe_group::WIDTH;
+      offset = (offset + step) & mask;
+    }
+  }
+
+  /**
+   * @brief Find first empty or deleted slot on the probe sequence of a hash
+   */
+  static size_t find_free(const ctrl_t *ctrl, size_t capacity, std::size_t hash) {
+    auto mask = capacity - 1;
+    size_t offset = hash & mask;
+    size_t step = 0;
+    while (true) {
+      probe_group g(ctrl + offset);
+      auto m = g.match_free();
+      if (m) {
+        return (offset + m.lowest()) & mask;
+      }
+      step += probe_group::WIDTH;
+      offset = (offset + step) & mask;
+    }
+  }
+
+  static void set_ctrl(ctrl_t *ctrl, size_t capacity, size_t idx, ctrl_t c) {
+    ctrl[idx] = c;
+    // The first group is mirrored past the end so that probing never wraps inside a group
+    if (idx < probe_group::WIDTH) {
+      ctrl[capacity + idx] = c;
+    }
+  }
+
+  size_t prepare_insert(std::size_t hash) {
+    if (capacity_ == 0) {
+      resize(probe_group::WIDTH);
+    }
+    auto idx = find_free(ctrl_, capacity_, hash);
+    if (growth_left_ == 0 && ctrl_[idx] != open_hash_table_detail::CTRL_DELETED) {
+      // Reclaim tombstones in place if they make up a large part of the table, otherwise double
+      resize(size_ * 2 <= max_load(capacity_) ? capacity_ : capacity_ * 2);
+      idx = find_free(ctrl_, capacity_, hash);
+    }
+    return idx;
+  }
+
+  void commit_insert(size_t idx, std::size_t hash) {
+    if (ctrl_[idx] == open_hash_table_detail::CTRL_EMPTY) {
+      --growth_left_;
+    }
+    slots_[idx].hash = hash;
+    set_ctrl(ctrl_, capacity_, idx, tag_of(hash));
+    ++size_;
+  }
+
+  void erase_at(size_t idx) {
+    slots_[idx].mutable_value.~mutable_value_type();
+    set_ctrl(ctrl_, capacity_, idx, open_hash_table_detail::CTRL_DELETED);
+    --size_;
+  }
+
+  size_t next_full(size_t idx) const {
+    while (idx < capacity_ && !open_hash_table_detail::is_full(ctrl_[idx])) {
+      ++idx;
+    }
+    return idx;
+  }
+
+  void resize(size_t new_capacity) {
+    auto new_ctrl = static_cast<ctrl_t *>(::operator new(new_capacity + probe_group::WIDTH));
+    slot_type *new_slots;
+    try {
+      new_slots = static_cast<slot_type *>(::operator new(new_capacity * sizeof(slot_type)));
+    } catch (...) {
+      ::operator delete(new_ctrl);
+      throw;
+    }
+    std::memset(new_ctrl, open_hash_table_detail::CTRL_EMPTY, new_capacity + probe_group::WIDTH);
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (open_hash_table_detail::is_full(ctrl_[i])) {
+        auto hash = slots_[i].hash;
+        auto idx = find_free(new_ctrl, new_capacity, hash);
+        new(&new_slots[idx].mutable_value) mutable_value_type(std::move(slots_[i].mutable_value));
+        slots_[i].mutable_value.~mutable_value_type();
+        new_slots[idx].hash = hash;
+        set_ctrl(new_ctrl, new_capacity, idx, tag_of(hash));
+      }
+    }
+    release(ctrl_, slots_);
+    ctrl_ = new_ctrl;
+    slots_ = new_slots;
+    capacity_ = new_capacity;
+    growth_left_ = max_load(new_capacity) - size_;
+    ++generation_;
+  }
+
+  void destroy_all() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (open_hash_table_detail::is_full(ctrl_[i])) {
+        slots_[i].mutable_value.~mutable_value_type();
+      }
+    }
+  }
+
+  static void release(ctrl_t *ctrl, slot_type *slots) {
+    ::operator delete(ctrl);
+    ::operator delete(slots);
+  }
+
+  /* Control bytes, capacity plus one mirrored group */
+  ctrl_t *ctrl_;
+  /* Slots */
+  slot_type *slots_;
+  /* Number of slots, zero or a power of two no smaller than the group width */
+  size_t capacity_;
+  /* Number of full slots */
+  size_t size_;
+  /* Number of empty slots that can still be filled before growing */
+  size_t growth_left_;
+  /* Number of resizes */
+  size_t generation_;
+  /* Hash function */
+  Hash hash_;
+  /* Key equality function */
+  Equal equal_;
+};
+
+}
+}
+
+#endif //JIFFY_OPEN_HASH_TABLE_H
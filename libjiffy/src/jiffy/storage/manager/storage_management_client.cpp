@@ -57,6 +57,14 @@ void storage_management_client::destroy_partition(int32_t block_id) {
   client_->destroy_partition(block_id);
 }
 
+void storage_management_client::freeze_partition(int32_t block_id) {
+  client_->freeze_partition(block_id);
+}
+
+void storage_management_client::thaw_partition(int32_t block_id) {
+  client_->thaw_partition(block_id);
+}
+
 std::string storage_management_client::path(int32_t block_id) {
   std::string path;
   client_->get_path(path, block_id);
@@ -75,6 +75,20 @@ class storage_management_client {
 
   void destroy_partition(int32_t block_id);
 
+  /**
+   * @brief Freeze partition
+   * @param block_id Block identifier
+   */
+
+  void freeze_partition(int32_t block_id);
+
+  /**
+   * @brief Thaw partition
+   * @param block_id Block identifier
+   */
+
+  void thaw_partition(int32_t block_id);
+
   /**
    * @brief Fetch block path
    * @param block_id Block identifier
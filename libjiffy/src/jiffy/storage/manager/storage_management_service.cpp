@@ -58,6 +58,38 @@ storage_management_service_destroy_partition_presult::~storage_management_servic
 }
 
 
+storage_management_service_freeze_partition_args::~storage_management_service_freeze_partition_args() throw() {
+}
+
+
+storage_management_service_freeze_partition_pargs::~storage_management_service_freeze_partition_pargs() throw() {
+}
+
+
+storage_management_service_freeze_partition_result::~storage_management_service_freeze_partition_result() throw() {
+}
+
+
+storage_management_service_freeze_partition_presult::~storage_management_service_freeze_partition_presult() throw() {
+}
+
+
+storage_management_service_thaw_partition_args::~storage_management_service_thaw_partition_args() throw() {
+}
+
+
+storage_management_service_thaw_partition_pargs::~storage_management_service_thaw_partition_pargs() throw() {
+}
+
+
+storage_management_service_thaw_partition_result::~storage_management_service_thaw_partition_result() throw() {
+}
+
+
+storage_management_service_thaw_partition_presult::~storage_management_service_thaw_partition_presult() throw() {
+}
+
+
 storage_management_service_get_path_args::~storage_management_service_get_path_args() throw() {
 }
 
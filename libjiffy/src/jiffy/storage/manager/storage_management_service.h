@@ -24,6 +24,8 @@ class storage_management_serviceIf {
   virtual void create_partition(const int32_t block_id, const std::string& partition_type, const std::string& backing_path, const std::string& partition_name, const std::string& partition_metadata, const std::map<std::string, std::string> & conf) = 0;
   virtual void setup_chain(const int32_t block_id, const std::string& path, const std::vector<std::string> & chain, const int32_t chain_role, const std::string& next_block_id) = 0;
   virtual void destroy_partition(const int32_t block_id) = 0;
+  virtual void freeze_partition(const int32_t block_id) = 0;
+  virtual void thaw_partition(const int32_t block_id) = 0;
   virtual void get_path(std::string& _return, const int32_t block_id) = 0;
   virtual void sync(const int32_t block_id, const std::string& backing_path) = 0;
   virtual void dump(const int32_t block_id, const std::string& backing_path) = 0;
@@ -71,6 +73,12 @@ class storage_management_serviceNull : virtual public storage_management_service
   void destroy_partition(const int32_t /* block_id */) {
     return;
   }
+  void freeze_partition(const int32_t /* block_id */) {
+    return;
+  }
+  void thaw_partition(const int32_t /* block_id */) {
+    return;
+  }
   void get_path(std::string& /* _return */, const int32_t /* block_id */) {
     return;
   }
@@ -495,6 +503,226 @@ class storage_management_service_destroy_partition_presult {
 
 };
 
+typedef struct _storage_management_service_freeze_partition_args__isset {
+  _storage_management_service_freeze_partition_args__isset() : block_id(false) {}
+  bool block_id :1;
+} _storage_management_service_freeze_partition_args__isset;
+
+class storage_management_service_freeze_partition_args {
+ public:
+
+  storage_management_service_freeze_partition_args(const storage_management_service_freeze_partition_args&);
+  storage_management_service_freeze_partition_args& operator=(const storage_management_service_freeze_partition_args&);
+  storage_management_service_freeze_partition_args() : block_id(0) {
+  }
+
+  virtual ~storage_management_service_freeze_partition_args() throw();
+  int32_t block_id;
+
+  _storage_management_service_freeze_partition_args__isset __isset;
+
+  void __set_block_id(const int32_t val);
+
+  bool operator == (const storage_management_service_freeze_partition_args & rhs) const
+  {
+    if (!(block_id == rhs.block_id))
+      return false;
+    return true;
+  }
+  bool operator != (const storage_management_service_freeze_partition_args &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const storage_management_service_freeze_partition_args & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+
+class storage_management_service_freeze_partition_pargs {
+ public:
+
+
+  virtual ~storage_management_service_freeze_partition_pargs() throw();
+  const int32_t* block_id;
+
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _storage_management_service_freeze_partition_result__isset {
+  _storage_management_service_freeze_partition_result__isset() : ex(false) {}
+  bool ex :1;
+} _storage_management_service_freeze_partition_result__isset;
+
+class storage_management_service_freeze_partition_result {
+ public:
+
+  storage_management_service_freeze_partition_result(const storage_management_service_freeze_partition_result&);
+  storage_management_service_freeze_partition_result& operator=(const storage_management_service_freeze_partition_result&);
+  storage_management_service_freeze_partition_result() {
+  }
+
+  virtual ~storage_management_service_freeze_partition_result() throw();
+  storage_management_exception ex;
+
+  _storage_management_service_freeze_partition_result__isset __isset;
+
+  void __set_ex(const storage_management_exception& val);
+
+  bool operator == (const storage_management_service_freeze_partition_result & rhs) const
+  {
+    if (!(ex == rhs.ex))
+      return false;
+    return true;
+  }
+  bool operator != (const storage_management_service_freeze_partition_result &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const storage_management_service_freeze_partition_result & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _storage_management_service_freeze_partition_presult__isset {
+  _storage_management_service_freeze_partition_presult__isset() : ex(false) {}
+  bool ex :1;
+} _storage_management_service_freeze_partition_presult__isset;
+
+class storage_management_service_freeze_partition_presult {
+ public:
+
+
+  virtual ~storage_management_service_freeze_partition_presult() throw();
+  storage_management_exception ex;
+
+  _storage_management_service_freeze_partition_presult__isset __isset;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+
+};
+
+typedef struct _storage_management_service_thaw_partition_args__isset {
+  _storage_management_service_thaw_partition_args__isset() : block_id(false) {}
+  bool block_id :1;
+} _storage_management_service_thaw_partition_args__isset;
+
+class storage_management_service_thaw_partition_args {
+ public:
+
+  storage_management_service_thaw_partition_args(const storage_management_service_thaw_partition_args&);
+  storage_management_service_thaw_partition_args& operator=(const storage_management_service_thaw_partition_args&);
+  storage_management_service_thaw_partition_args() : block_id(0) {
+  }
+
+  virtual ~storage_management_service_thaw_partition_args() throw();
+  int32_t block_id;
+
+  _storage_management_service_thaw_partition_args__isset __isset;
+
+  void __set_block_id(const int32_t val);
+
+  bool operator == (const storage_management_service_thaw_partition_args & rhs) const
+  {
+    if (!(block_id == rhs.block_id))
+      return false;
+    return true;
+  }
+  bool operator != (const storage_management_service_thaw_partition_args &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const storage_management_service_thaw_partition_args & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+
+class storage_management_service_thaw_partition_pargs {
+ public:
+
+
+  virtual ~storage_management_service_thaw_partition_pargs() throw();
+  const int32_t* block_id;
+
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _storage_management_service_thaw_partition_result__isset {
+  _storage_management_service_thaw_partition_result__isset() : ex(false) {}
+  bool ex :1;
+} _storage_management_service_thaw_partition_result__isset;
+
+class storage_management_service_thaw_partition_result {
+ public:
+
+  storage_management_service_thaw_partition_result(const storage_management_service_thaw_partition_result&);
+  storage_management_service_thaw_partition_result& operator=(const storage_management_service_thaw_partition_result&);
+  storage_management_service_thaw_partition_result() {
+  }
+
+  virtual ~storage_management_service_thaw_partition_result() throw();
+  storage_management_exception ex;
+
+  _storage_management_service_thaw_partition_result__isset __isset;
+
+  void __set_ex(const storage_management_exception& val);
+
+  bool operator == (const storage_management_service_thaw_partition_result & rhs) const
+  {
+    if (!(ex == rhs.ex))
+      return false;
+    return true;
+  }
+  bool operator != (const storage_management_service_thaw_partition_result &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const storage_management_service_thaw_partition_result & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _storage_management_service_thaw_partition_presult__isset {
+  _storage_management_service_thaw_partition_presult__isset() : ex(false) {}
+  bool ex :1;
+} _storage_management_service_thaw_partition_presult__isset;
+
+class storage_management_service_thaw_partition_presult {
+ public:
+
+
+  virtual ~storage_management_service_thaw_partition_presult() throw();
+  storage_management_exception ex;
+
+  _storage_management_service_thaw_partition_presult__isset __isset;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+
+};
+
 typedef struct _storage_management_service_get_path_args__isset {
   _storage_management_service_get_path_args__isset() : block_id(false) {}
   bool block_id :1;
@@ -1579,6 +1807,12 @@ class storage_management_serviceClientT : virtual public storage_management_serv
   void destroy_partition(const int32_t block_id);
   void send_destroy_partition(const int32_t block_id);
   void recv_destroy_partition();
+  void freeze_partition(const int32_t block_id);
+  void send_freeze_partition(const int32_t block_id);
+  void recv_freeze_partition();
+  void thaw_partition(const int32_t block_id);
+  void send_thaw_partition(const int32_t block_id);
+  void recv_thaw_partition();
   void get_path(std::string& _return, const int32_t block_id);
   void send_get_path(const int32_t block_id);
   void recv_get_path(std::string& _return);
@@ -1640,6 +1874,10 @@ class storage_management_serviceProcessorT : public ::apache::thrift::TDispatchP
   void process_setup_chain(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
   void process_destroy_partition(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
   void process_destroy_partition(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
+  void process_freeze_partition(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+  void process_freeze_partition(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
+  void process_thaw_partition(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+  void process_thaw_partition(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
   void process_get_path(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
   void process_get_path(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
   void process_sync(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
@@ -1670,6 +1908,12 @@ class storage_management_serviceProcessorT : public ::apache::thrift::TDispatchP
     processMap_["destroy_partition"] = ProcessFunctions(
       &storage_management_serviceProcessorT::process_destroy_partition,
       &storage_management_serviceProcessorT::process_destroy_partition);
+    processMap_["freeze_partition"] = ProcessFunctions(
+      &storage_management_serviceProcessorT::process_freeze_partition,
+      &storage_management_serviceProcessorT::process_freeze_partition);
+    processMap_["thaw_partition"] = ProcessFunctions(
+      &storage_management_serviceProcessorT::process_thaw_partition,
+      &storage_management_serviceProcessorT::process_thaw_partition);
     processMap_["get_path"] = ProcessFunctions(
       &storage_management_serviceProcessorT::process_get_path,
       &storage_management_serviceProcessorT::process_get_path);
@@ -1757,6 +2001,24 @@ class storage_management_serviceMultiface : virtual public storage_management_se
     ifaces_[i]->destroy_partition(block_id);
   }
 
+  void freeze_partition(const int32_t block_id) {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->freeze_partition(block_id);
+    }
+    ifaces_[i]->freeze_partition(block_id);
+  }
+
+  void thaw_partition(const int32_t block_id) {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->thaw_partition(block_id);
+    }
+    ifaces_[i]->thaw_partition(block_id);
+  }
+
   void get_path(std::string& _return, const int32_t block_id) {
     size_t sz = ifaces_.size();
     size_t i = 0;
@@ -1879,6 +2141,12 @@ class storage_management_serviceConcurrentClientT : virtual public storage_manag
   void destroy_partition(const int32_t block_id);
   int32_t send_destroy_partition(const int32_t block_id);
   void recv_destroy_partition(const int32_t seqid);
+  void freeze_partition(const int32_t block_id);
+  int32_t send_freeze_partition(const int32_t block_id);
+  void recv_freeze_partition(const int32_t seqid);
+  void thaw_partition(const int32_t block_id);
+  int32_t send_thaw_partition(const int32_t block_id);
+  void recv_thaw_partition(const int32_t seqid);
   void get_path(std::string& _return, const int32_t block_id);
   int32_t send_get_path(const int32_t block_id);
   void recv_get_path(std::string& _return, const int32_t seqid);
@@ -749,7 +749,7 @@ uint32_t storage_management_service_destroy_partition_presult::read(Protocol_* i
 
 
 template <class Protocol_>
-uint32_t storage_management_service_get_path_args::read(Protocol_* iprot) {
+uint32_t storage_management_service_freeze_partition_args::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -791,10 +791,10 @@ uint32_t storage_management_service_get_path_args::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_get_path_args::write(Protocol_* oprot) const {
+uint32_t storage_management_service_freeze_partition_args::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_get_path_args");
+  xfer += oprot->writeStructBegin("storage_management_service_freeze_partition_args");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32(this->block_id);
@@ -807,10 +807,10 @@ uint32_t storage_management_service_get_path_args::write(Protocol_* oprot) const
 
 
 template <class Protocol_>
-uint32_t storage_management_service_get_path_pargs::write(Protocol_* oprot) const {
+uint32_t storage_management_service_freeze_partition_pargs::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_get_path_pargs");
+  xfer += oprot->writeStructBegin("storage_management_service_freeze_partition_pargs");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32((*(this->block_id)));
@@ -823,7 +823,7 @@ uint32_t storage_management_service_get_path_pargs::write(Protocol_* oprot) cons
 
 
 template <class Protocol_>
-uint32_t storage_management_service_get_path_result::read(Protocol_* iprot) {
+uint32_t storage_management_service_freeze_partition_result::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -844,14 +844,6 @@ uint32_t storage_management_service_get_path_result::read(Protocol_* iprot) {
     }
     switch (fid)
     {
-      case 0:
-        if (ftype == ::apache::thrift::protocol::T_STRING) {
-          xfer += iprot->readString(this->success);
-          this->__isset.success = true;
-        } else {
-          xfer += iprot->skip(ftype);
-        }
-        break;
       case 1:
         if (ftype == ::apache::thrift::protocol::T_STRUCT) {
           xfer += this->ex.read(iprot);
@@ -873,17 +865,13 @@ uint32_t storage_management_service_get_path_result::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_get_path_result::write(Protocol_* oprot) const {
+uint32_t storage_management_service_freeze_partition_result::write(Protocol_* oprot) const {
 
   uint32_t xfer = 0;
 
-  xfer += oprot->writeStructBegin("storage_management_service_get_path_result");
+  xfer += oprot->writeStructBegin("storage_management_service_freeze_partition_result");
 
-  if (this->__isset.success) {
-    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_STRING, 0);
-    xfer += oprot->writeString(this->success);
-    xfer += oprot->writeFieldEnd();
-  } else if (this->__isset.ex) {
+  if (this->__isset.ex) {
     xfer += oprot->writeFieldBegin("ex", ::apache::thrift::protocol::T_STRUCT, 1);
     xfer += this->ex.write(oprot);
     xfer += oprot->writeFieldEnd();
@@ -895,7 +883,7 @@ uint32_t storage_management_service_get_path_result::write(Protocol_* oprot) con
 
 
 template <class Protocol_>
-uint32_t storage_management_service_get_path_presult::read(Protocol_* iprot) {
+uint32_t storage_management_service_freeze_partition_presult::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -916,14 +904,6 @@ uint32_t storage_management_service_get_path_presult::read(Protocol_* iprot) {
     }
     switch (fid)
     {
-      case 0:
-        if (ftype == ::apache::thrift::protocol::T_STRING) {
-          xfer += iprot->readString((*(this->success)));
-          this->__isset.success = true;
-        } else {
-          xfer += iprot->skip(ftype);
-        }
-        break;
       case 1:
         if (ftype == ::apache::thrift::protocol::T_STRUCT) {
           xfer += this->ex.read(iprot);
@@ -946,7 +926,7 @@ uint32_t storage_management_service_get_path_presult::read(Protocol_* iprot) {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_sync_args::read(Protocol_* iprot) {
+uint32_t storage_management_service_thaw_partition_args::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -975,14 +955,6 @@ uint32_t storage_management_service_sync_args::read(Protocol_* iprot) {
           xfer += iprot->skip(ftype);
         }
         break;
-      case 2:
-        if (ftype == ::apache::thrift::protocol::T_STRING) {
-          xfer += iprot->readString(this->backing_path);
-          this->__isset.backing_path = true;
-        } else {
-          xfer += iprot->skip(ftype);
-        }
-        break;
       default:
         xfer += iprot->skip(ftype);
         break;
@@ -996,19 +968,15 @@ uint32_t storage_management_service_sync_args::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_sync_args::write(Protocol_* oprot) const {
+uint32_t storage_management_service_thaw_partition_args::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_sync_args");
+  xfer += oprot->writeStructBegin("storage_management_service_thaw_partition_args");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32(this->block_id);
   xfer += oprot->writeFieldEnd();
 
-  xfer += oprot->writeFieldBegin("backing_path", ::apache::thrift::protocol::T_STRING, 2);
-  xfer += oprot->writeString(this->backing_path);
-  xfer += oprot->writeFieldEnd();
-
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -1016,19 +984,15 @@ uint32_t storage_management_service_sync_args::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_sync_pargs::write(Protocol_* oprot) const {
+uint32_t storage_management_service_thaw_partition_pargs::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_sync_pargs");
+  xfer += oprot->writeStructBegin("storage_management_service_thaw_partition_pargs");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32((*(this->block_id)));
   xfer += oprot->writeFieldEnd();
 
-  xfer += oprot->writeFieldBegin("backing_path", ::apache::thrift::protocol::T_STRING, 2);
-  xfer += oprot->writeString((*(this->backing_path)));
-  xfer += oprot->writeFieldEnd();
-
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -1036,7 +1000,7 @@ uint32_t storage_management_service_sync_pargs::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_sync_result::read(Protocol_* iprot) {
+uint32_t storage_management_service_thaw_partition_result::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1078,11 +1042,11 @@ uint32_t storage_management_service_sync_result::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_sync_result::write(Protocol_* oprot) const {
+uint32_t storage_management_service_thaw_partition_result::write(Protocol_* oprot) const {
 
   uint32_t xfer = 0;
 
-  xfer += oprot->writeStructBegin("storage_management_service_sync_result");
+  xfer += oprot->writeStructBegin("storage_management_service_thaw_partition_result");
 
   if (this->__isset.ex) {
     xfer += oprot->writeFieldBegin("ex", ::apache::thrift::protocol::T_STRUCT, 1);
@@ -1096,7 +1060,7 @@ uint32_t storage_management_service_sync_result::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_sync_presult::read(Protocol_* iprot) {
+uint32_t storage_management_service_thaw_partition_presult::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1139,7 +1103,7 @@ uint32_t storage_management_service_sync_presult::read(Protocol_* iprot) {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_dump_args::read(Protocol_* iprot) {
+uint32_t storage_management_service_get_path_args::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1168,14 +1132,6 @@ uint32_t storage_management_service_dump_args::read(Protocol_* iprot) {
           xfer += iprot->skip(ftype);
         }
         break;
-      case 2:
-        if (ftype == ::apache::thrift::protocol::T_STRING) {
-          xfer += iprot->readString(this->backing_path);
-          this->__isset.backing_path = true;
-        } else {
-          xfer += iprot->skip(ftype);
-        }
-        break;
       default:
         xfer += iprot->skip(ftype);
         break;
@@ -1189,19 +1145,15 @@ uint32_t storage_management_service_dump_args::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_dump_args::write(Protocol_* oprot) const {
+uint32_t storage_management_service_get_path_args::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_dump_args");
+  xfer += oprot->writeStructBegin("storage_management_service_get_path_args");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32(this->block_id);
   xfer += oprot->writeFieldEnd();
 
-  xfer += oprot->writeFieldBegin("backing_path", ::apache::thrift::protocol::T_STRING, 2);
-  xfer += oprot->writeString(this->backing_path);
-  xfer += oprot->writeFieldEnd();
-
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -1209,19 +1161,15 @@ uint32_t storage_management_service_dump_args::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_dump_pargs::write(Protocol_* oprot) const {
+uint32_t storage_management_service_get_path_pargs::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_dump_pargs");
+  xfer += oprot->writeStructBegin("storage_management_service_get_path_pargs");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32((*(this->block_id)));
   xfer += oprot->writeFieldEnd();
 
-  xfer += oprot->writeFieldBegin("backing_path", ::apache::thrift::protocol::T_STRING, 2);
-  xfer += oprot->writeString((*(this->backing_path)));
-  xfer += oprot->writeFieldEnd();
-
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -1229,7 +1177,7 @@ uint32_t storage_management_service_dump_pargs::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_dump_result::read(Protocol_* iprot) {
+uint32_t storage_management_service_get_path_result::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1250,6 +1198,14 @@ uint32_t storage_management_service_dump_result::read(Protocol_* iprot) {
     }
     switch (fid)
     {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_STRING) {
+          xfer += iprot->readString(this->success);
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
       case 1:
         if (ftype == ::apache::thrift::protocol::T_STRUCT) {
           xfer += this->ex.read(iprot);
@@ -1271,13 +1227,17 @@ uint32_t storage_management_service_dump_result::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_dump_result::write(Protocol_* oprot) const {
+uint32_t storage_management_service_get_path_result::write(Protocol_* oprot) const {
 
   uint32_t xfer = 0;
 
-  xfer += oprot->writeStructBegin("storage_management_service_dump_result");
+  xfer += oprot->writeStructBegin("storage_management_service_get_path_result");
 
-  if (this->__isset.ex) {
+  if (this->__isset.success) {
+    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_STRING, 0);
+    xfer += oprot->writeString(this->success);
+    xfer += oprot->writeFieldEnd();
+  } else if (this->__isset.ex) {
     xfer += oprot->writeFieldBegin("ex", ::apache::thrift::protocol::T_STRUCT, 1);
     xfer += this->ex.write(oprot);
     xfer += oprot->writeFieldEnd();
@@ -1289,7 +1249,7 @@ uint32_t storage_management_service_dump_result::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_dump_presult::read(Protocol_* iprot) {
+uint32_t storage_management_service_get_path_presult::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1310,6 +1270,14 @@ uint32_t storage_management_service_dump_presult::read(Protocol_* iprot) {
     }
     switch (fid)
     {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_STRING) {
+          xfer += iprot->readString((*(this->success)));
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
       case 1:
         if (ftype == ::apache::thrift::protocol::T_STRUCT) {
           xfer += this->ex.read(iprot);
@@ -1332,7 +1300,7 @@ uint32_t storage_management_service_dump_presult::read(Protocol_* iprot) {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_load_args::read(Protocol_* iprot) {
+uint32_t storage_management_service_sync_args::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1382,10 +1350,10 @@ uint32_t storage_management_service_load_args::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_load_args::write(Protocol_* oprot) const {
+uint32_t storage_management_service_sync_args::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_load_args");
+  xfer += oprot->writeStructBegin("storage_management_service_sync_args");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32(this->block_id);
@@ -1402,10 +1370,10 @@ uint32_t storage_management_service_load_args::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_load_pargs::write(Protocol_* oprot) const {
+uint32_t storage_management_service_sync_pargs::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_load_pargs");
+  xfer += oprot->writeStructBegin("storage_management_service_sync_pargs");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32((*(this->block_id)));
@@ -1422,7 +1390,7 @@ uint32_t storage_management_service_load_pargs::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_load_result::read(Protocol_* iprot) {
+uint32_t storage_management_service_sync_result::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1464,11 +1432,11 @@ uint32_t storage_management_service_load_result::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_load_result::write(Protocol_* oprot) const {
+uint32_t storage_management_service_sync_result::write(Protocol_* oprot) const {
 
   uint32_t xfer = 0;
 
-  xfer += oprot->writeStructBegin("storage_management_service_load_result");
+  xfer += oprot->writeStructBegin("storage_management_service_sync_result");
 
   if (this->__isset.ex) {
     xfer += oprot->writeFieldBegin("ex", ::apache::thrift::protocol::T_STRUCT, 1);
@@ -1482,7 +1450,7 @@ uint32_t storage_management_service_load_result::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_load_presult::read(Protocol_* iprot) {
+uint32_t storage_management_service_sync_presult::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1525,7 +1493,7 @@ uint32_t storage_management_service_load_presult::read(Protocol_* iprot) {
 
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_capacity_args::read(Protocol_* iprot) {
+uint32_t storage_management_service_dump_args::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1554,6 +1522,14 @@ uint32_t storage_management_service_storage_capacity_args::read(Protocol_* iprot
           xfer += iprot->skip(ftype);
         }
         break;
+      case 2:
+        if (ftype == ::apache::thrift::protocol::T_STRING) {
+          xfer += iprot->readString(this->backing_path);
+          this->__isset.backing_path = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
       default:
         xfer += iprot->skip(ftype);
         break;
@@ -1567,15 +1543,19 @@ uint32_t storage_management_service_storage_capacity_args::read(Protocol_* iprot
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_capacity_args::write(Protocol_* oprot) const {
+uint32_t storage_management_service_dump_args::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_storage_capacity_args");
+  xfer += oprot->writeStructBegin("storage_management_service_dump_args");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32(this->block_id);
   xfer += oprot->writeFieldEnd();
 
+  xfer += oprot->writeFieldBegin("backing_path", ::apache::thrift::protocol::T_STRING, 2);
+  xfer += oprot->writeString(this->backing_path);
+  xfer += oprot->writeFieldEnd();
+
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -1583,15 +1563,19 @@ uint32_t storage_management_service_storage_capacity_args::write(Protocol_* opro
 
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_capacity_pargs::write(Protocol_* oprot) const {
+uint32_t storage_management_service_dump_pargs::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_storage_capacity_pargs");
+  xfer += oprot->writeStructBegin("storage_management_service_dump_pargs");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32((*(this->block_id)));
   xfer += oprot->writeFieldEnd();
 
+  xfer += oprot->writeFieldBegin("backing_path", ::apache::thrift::protocol::T_STRING, 2);
+  xfer += oprot->writeString((*(this->backing_path)));
+  xfer += oprot->writeFieldEnd();
+
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -1599,7 +1583,7 @@ uint32_t storage_management_service_storage_capacity_pargs::write(Protocol_* opr
 
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_capacity_result::read(Protocol_* iprot) {
+uint32_t storage_management_service_dump_result::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1620,14 +1604,6 @@ uint32_t storage_management_service_storage_capacity_result::read(Protocol_* ipr
     }
     switch (fid)
     {
-      case 0:
-        if (ftype == ::apache::thrift::protocol::T_I64) {
-          xfer += iprot->readI64(this->success);
-          this->__isset.success = true;
-        } else {
-          xfer += iprot->skip(ftype);
-        }
-        break;
       case 1:
         if (ftype == ::apache::thrift::protocol::T_STRUCT) {
           xfer += this->ex.read(iprot);
@@ -1649,17 +1625,13 @@ uint32_t storage_management_service_storage_capacity_result::read(Protocol_* ipr
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_capacity_result::write(Protocol_* oprot) const {
+uint32_t storage_management_service_dump_result::write(Protocol_* oprot) const {
 
   uint32_t xfer = 0;
 
-  xfer += oprot->writeStructBegin("storage_management_service_storage_capacity_result");
+  xfer += oprot->writeStructBegin("storage_management_service_dump_result");
 
-  if (this->__isset.success) {
-    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_I64, 0);
-    xfer += oprot->writeI64(this->success);
-    xfer += oprot->writeFieldEnd();
-  } else if (this->__isset.ex) {
+  if (this->__isset.ex) {
     xfer += oprot->writeFieldBegin("ex", ::apache::thrift::protocol::T_STRUCT, 1);
     xfer += this->ex.write(oprot);
     xfer += oprot->writeFieldEnd();
@@ -1671,7 +1643,7 @@ uint32_t storage_management_service_storage_capacity_result::write(Protocol_* op
 
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_capacity_presult::read(Protocol_* iprot) {
+uint32_t storage_management_service_dump_presult::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1692,14 +1664,6 @@ uint32_t storage_management_service_storage_capacity_presult::read(Protocol_* ip
     }
     switch (fid)
     {
-      case 0:
-        if (ftype == ::apache::thrift::protocol::T_I64) {
-          xfer += iprot->readI64((*(this->success)));
-          this->__isset.success = true;
-        } else {
-          xfer += iprot->skip(ftype);
-        }
-        break;
       case 1:
         if (ftype == ::apache::thrift::protocol::T_STRUCT) {
           xfer += this->ex.read(iprot);
@@ -1722,7 +1686,7 @@ uint32_t storage_management_service_storage_capacity_presult::read(Protocol_* ip
 
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_size_args::read(Protocol_* iprot) {
+uint32_t storage_management_service_load_args::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1751,6 +1715,14 @@ uint32_t storage_management_service_storage_size_args::read(Protocol_* iprot) {
           xfer += iprot->skip(ftype);
         }
         break;
+      case 2:
+        if (ftype == ::apache::thrift::protocol::T_STRING) {
+          xfer += iprot->readString(this->backing_path);
+          this->__isset.backing_path = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
       default:
         xfer += iprot->skip(ftype);
         break;
@@ -1764,15 +1736,19 @@ uint32_t storage_management_service_storage_size_args::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_size_args::write(Protocol_* oprot) const {
+uint32_t storage_management_service_load_args::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_storage_size_args");
+  xfer += oprot->writeStructBegin("storage_management_service_load_args");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32(this->block_id);
   xfer += oprot->writeFieldEnd();
 
+  xfer += oprot->writeFieldBegin("backing_path", ::apache::thrift::protocol::T_STRING, 2);
+  xfer += oprot->writeString(this->backing_path);
+  xfer += oprot->writeFieldEnd();
+
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -1780,15 +1756,19 @@ uint32_t storage_management_service_storage_size_args::write(Protocol_* oprot) c
 
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_size_pargs::write(Protocol_* oprot) const {
+uint32_t storage_management_service_load_pargs::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_storage_size_pargs");
+  xfer += oprot->writeStructBegin("storage_management_service_load_pargs");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32((*(this->block_id)));
   xfer += oprot->writeFieldEnd();
 
+  xfer += oprot->writeFieldBegin("backing_path", ::apache::thrift::protocol::T_STRING, 2);
+  xfer += oprot->writeString((*(this->backing_path)));
+  xfer += oprot->writeFieldEnd();
+
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -1796,7 +1776,7 @@ uint32_t storage_management_service_storage_size_pargs::write(Protocol_* oprot)
 
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_size_result::read(Protocol_* iprot) {
+uint32_t storage_management_service_load_result::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1817,14 +1797,6 @@ uint32_t storage_management_service_storage_size_result::read(Protocol_* iprot)
     }
     switch (fid)
     {
-      case 0:
-        if (ftype == ::apache::thrift::protocol::T_I64) {
-          xfer += iprot->readI64(this->success);
-          this->__isset.success = true;
-        } else {
-          xfer += iprot->skip(ftype);
-        }
-        break;
       case 1:
         if (ftype == ::apache::thrift::protocol::T_STRUCT) {
           xfer += this->ex.read(iprot);
@@ -1846,17 +1818,13 @@ uint32_t storage_management_service_storage_size_result::read(Protocol_* iprot)
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_size_result::write(Protocol_* oprot) const {
+uint32_t storage_management_service_load_result::write(Protocol_* oprot) const {
 
   uint32_t xfer = 0;
 
-  xfer += oprot->writeStructBegin("storage_management_service_storage_size_result");
+  xfer += oprot->writeStructBegin("storage_management_service_load_result");
 
-  if (this->__isset.success) {
-    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_I64, 0);
-    xfer += oprot->writeI64(this->success);
-    xfer += oprot->writeFieldEnd();
-  } else if (this->__isset.ex) {
+  if (this->__isset.ex) {
     xfer += oprot->writeFieldBegin("ex", ::apache::thrift::protocol::T_STRUCT, 1);
     xfer += this->ex.write(oprot);
     xfer += oprot->writeFieldEnd();
@@ -1868,7 +1836,7 @@ uint32_t storage_management_service_storage_size_result::write(Protocol_* oprot)
 
 
 template <class Protocol_>
-uint32_t storage_management_service_storage_size_presult::read(Protocol_* iprot) {
+uint32_t storage_management_service_load_presult::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1889,14 +1857,6 @@ uint32_t storage_management_service_storage_size_presult::read(Protocol_* iprot)
     }
     switch (fid)
     {
-      case 0:
-        if (ftype == ::apache::thrift::protocol::T_I64) {
-          xfer += iprot->readI64((*(this->success)));
-          this->__isset.success = true;
-        } else {
-          xfer += iprot->skip(ftype);
-        }
-        break;
       case 1:
         if (ftype == ::apache::thrift::protocol::T_STRUCT) {
           xfer += this->ex.read(iprot);
@@ -1919,7 +1879,7 @@ uint32_t storage_management_service_storage_size_presult::read(Protocol_* iprot)
 
 
 template <class Protocol_>
-uint32_t storage_management_service_resend_pending_args::read(Protocol_* iprot) {
+uint32_t storage_management_service_storage_capacity_args::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1961,10 +1921,10 @@ uint32_t storage_management_service_resend_pending_args::read(Protocol_* iprot)
 }
 
 template <class Protocol_>
-uint32_t storage_management_service_resend_pending_args::write(Protocol_* oprot) const {
+uint32_t storage_management_service_storage_capacity_args::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_resend_pending_args");
+  xfer += oprot->writeStructBegin("storage_management_service_storage_capacity_args");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32(this->block_id);
@@ -1977,10 +1937,10 @@ uint32_t storage_management_service_resend_pending_args::write(Protocol_* oprot)
 
 
 template <class Protocol_>
-uint32_t storage_management_service_resend_pending_pargs::write(Protocol_* oprot) const {
+uint32_t storage_management_service_storage_capacity_pargs::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("storage_management_service_resend_pending_pargs");
+  xfer += oprot->writeStructBegin("storage_management_service_storage_capacity_pargs");
 
   xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
   xfer += oprot->writeI32((*(this->block_id)));
@@ -1993,7 +1953,7 @@ uint32_t storage_management_service_resend_pending_pargs::write(Protocol_* oprot
 
 
 template <class Protocol_>
-uint32_t storage_management_service_resend_pending_result::read(Protocol_* iprot) {
+uint32_t storage_management_service_storage_capacity_result::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -2014,8 +1974,402 @@ uint32_t storage_management_service_resend_pending_result::read(Protocol_* iprot
     }
     switch (fid)
     {
-      case 1:
-        if (ftype == ::apache::thrift::protocol::T_STRUCT) {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->success);
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_STRUCT) {
+          xfer += this->ex.read(iprot);
+          this->__isset.ex = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t storage_management_service_storage_capacity_result::write(Protocol_* oprot) const {
+
+  uint32_t xfer = 0;
+
+  xfer += oprot->writeStructBegin("storage_management_service_storage_capacity_result");
+
+  if (this->__isset.success) {
+    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_I64, 0);
+    xfer += oprot->writeI64(this->success);
+    xfer += oprot->writeFieldEnd();
+  } else if (this->__isset.ex) {
+    xfer += oprot->writeFieldBegin("ex", ::apache::thrift::protocol::T_STRUCT, 1);
+    xfer += this->ex.write(oprot);
+    xfer += oprot->writeFieldEnd();
+  }
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t storage_management_service_storage_capacity_presult::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64((*(this->success)));
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_STRUCT) {
+          xfer += this->ex.read(iprot);
+          this->__isset.ex = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t storage_management_service_storage_size_args::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->block_id);
+          this->__isset.block_id = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t storage_management_service_storage_size_args::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("storage_management_service_storage_size_args");
+
+  xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
+  xfer += oprot->writeI32(this->block_id);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t storage_management_service_storage_size_pargs::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("storage_management_service_storage_size_pargs");
+
+  xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
+  xfer += oprot->writeI32((*(this->block_id)));
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t storage_management_service_storage_size_result::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->success);
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_STRUCT) {
+          xfer += this->ex.read(iprot);
+          this->__isset.ex = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t storage_management_service_storage_size_result::write(Protocol_* oprot) const {
+
+  uint32_t xfer = 0;
+
+  xfer += oprot->writeStructBegin("storage_management_service_storage_size_result");
+
+  if (this->__isset.success) {
+    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_I64, 0);
+    xfer += oprot->writeI64(this->success);
+    xfer += oprot->writeFieldEnd();
+  } else if (this->__isset.ex) {
+    xfer += oprot->writeFieldBegin("ex", ::apache::thrift::protocol::T_STRUCT, 1);
+    xfer += this->ex.write(oprot);
+    xfer += oprot->writeFieldEnd();
+  }
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t storage_management_service_storage_size_presult::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64((*(this->success)));
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_STRUCT) {
+          xfer += this->ex.read(iprot);
+          this->__isset.ex = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t storage_management_service_resend_pending_args::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->block_id);
+          this->__isset.block_id = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t storage_management_service_resend_pending_args::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("storage_management_service_resend_pending_args");
+
+  xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
+  xfer += oprot->writeI32(this->block_id);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t storage_management_service_resend_pending_pargs::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("storage_management_service_resend_pending_pargs");
+
+  xfer += oprot->writeFieldBegin("block_id", ::apache::thrift::protocol::T_I32, 1);
+  xfer += oprot->writeI32((*(this->block_id)));
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t storage_management_service_resend_pending_result::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_STRUCT) {
           xfer += this->ex.read(iprot);
           this->__isset.ex = true;
         } else {
@@ -2508,7 +2862,129 @@ void storage_management_serviceClientT<Protocol_>::send_create_partition(const i
 }
 
 template <class Protocol_>
-void storage_management_serviceClientT<Protocol_>::recv_create_partition()
+void storage_management_serviceClientT<Protocol_>::recv_create_partition()
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("create_partition") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  storage_management_service_create_partition_presult result;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.ex) {
+    throw result.ex;
+  }
+  return;
+}
+
+template <class Protocol_>
+void storage_management_serviceClientT<Protocol_>::setup_chain(const int32_t block_id, const std::string& path, const std::vector<std::string> & chain, const int32_t chain_role, const std::string& next_block_id)
+{
+  send_setup_chain(block_id, path, chain, chain_role, next_block_id);
+  recv_setup_chain();
+}
+
+template <class Protocol_>
+void storage_management_serviceClientT<Protocol_>::send_setup_chain(const int32_t block_id, const std::string& path, const std::vector<std::string> & chain, const int32_t chain_role, const std::string& next_block_id)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  storage_management_service_setup_chain_pargs args;
+  args.block_id = &block_id;
+  args.path = &path;
+  args.chain = &chain;
+  args.chain_role = &chain_role;
+  args.next_block_id = &next_block_id;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+void storage_management_serviceClientT<Protocol_>::recv_setup_chain()
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("setup_chain") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  storage_management_service_setup_chain_presult result;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.ex) {
+    throw result.ex;
+  }
+  return;
+}
+
+template <class Protocol_>
+void storage_management_serviceClientT<Protocol_>::destroy_partition(const int32_t block_id)
+{
+  send_destroy_partition(block_id);
+  recv_destroy_partition();
+}
+
+template <class Protocol_>
+void storage_management_serviceClientT<Protocol_>::send_destroy_partition(const int32_t block_id)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  storage_management_service_destroy_partition_pargs args;
+  args.block_id = &block_id;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+void storage_management_serviceClientT<Protocol_>::recv_destroy_partition()
 {
 
   int32_t rseqid = 0;
@@ -2528,12 +3004,12 @@ void storage_management_serviceClientT<Protocol_>::recv_create_partition()
     this->iprot_->readMessageEnd();
     this->iprot_->getTransport()->readEnd();
   }
-  if (fname.compare("create_partition") != 0) {
+  if (fname.compare("destroy_partition") != 0) {
     this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
     this->iprot_->readMessageEnd();
     this->iprot_->getTransport()->readEnd();
   }
-  storage_management_service_create_partition_presult result;
+  storage_management_service_destroy_partition_presult result;
   result.read(this->iprot_);
   this->iprot_->readMessageEnd();
   this->iprot_->getTransport()->readEnd();
@@ -2545,24 +3021,20 @@ void storage_management_serviceClientT<Protocol_>::recv_create_partition()
 }
 
 template <class Protocol_>
-void storage_management_serviceClientT<Protocol_>::setup_chain(const int32_t block_id, const std::string& path, const std::vector<std::string> & chain, const int32_t chain_role, const std::string& next_block_id)
+void storage_management_serviceClientT<Protocol_>::freeze_partition(const int32_t block_id)
 {
-  send_setup_chain(block_id, path, chain, chain_role, next_block_id);
-  recv_setup_chain();
+  send_freeze_partition(block_id);
+  recv_freeze_partition();
 }
 
 template <class Protocol_>
-void storage_management_serviceClientT<Protocol_>::send_setup_chain(const int32_t block_id, const std::string& path, const std::vector<std::string> & chain, const int32_t chain_role, const std::string& next_block_id)
+void storage_management_serviceClientT<Protocol_>::send_freeze_partition(const int32_t block_id)
 {
   int32_t cseqid = 0;
-  this->oprot_->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_CALL, cseqid);
+  this->oprot_->writeMessageBegin("freeze_partition", ::apache::thrift::protocol::T_CALL, cseqid);
 
-  storage_management_service_setup_chain_pargs args;
+  storage_management_service_freeze_partition_pargs args;
   args.block_id = &block_id;
-  args.path = &path;
-  args.chain = &chain;
-  args.chain_role = &chain_role;
-  args.next_block_id = &next_block_id;
   args.write(this->oprot_);
 
   this->oprot_->writeMessageEnd();
@@ -2571,7 +3043,7 @@ void storage_management_serviceClientT<Protocol_>::send_setup_chain(const int32_
 }
 
 template <class Protocol_>
-void storage_management_serviceClientT<Protocol_>::recv_setup_chain()
+void storage_management_serviceClientT<Protocol_>::recv_freeze_partition()
 {
 
   int32_t rseqid = 0;
@@ -2591,12 +3063,12 @@ void storage_management_serviceClientT<Protocol_>::recv_setup_chain()
     this->iprot_->readMessageEnd();
     this->iprot_->getTransport()->readEnd();
   }
-  if (fname.compare("setup_chain") != 0) {
+  if (fname.compare("freeze_partition") != 0) {
     this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
     this->iprot_->readMessageEnd();
     this->iprot_->getTransport()->readEnd();
   }
-  storage_management_service_setup_chain_presult result;
+  storage_management_service_freeze_partition_presult result;
   result.read(this->iprot_);
   this->iprot_->readMessageEnd();
   this->iprot_->getTransport()->readEnd();
@@ -2608,19 +3080,19 @@ void storage_management_serviceClientT<Protocol_>::recv_setup_chain()
 }
 
 template <class Protocol_>
-void storage_management_serviceClientT<Protocol_>::destroy_partition(const int32_t block_id)
+void storage_management_serviceClientT<Protocol_>::thaw_partition(const int32_t block_id)
 {
-  send_destroy_partition(block_id);
-  recv_destroy_partition();
+  send_thaw_partition(block_id);
+  recv_thaw_partition();
 }
 
 template <class Protocol_>
-void storage_management_serviceClientT<Protocol_>::send_destroy_partition(const int32_t block_id)
+void storage_management_serviceClientT<Protocol_>::send_thaw_partition(const int32_t block_id)
 {
   int32_t cseqid = 0;
-  this->oprot_->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_CALL, cseqid);
+  this->oprot_->writeMessageBegin("thaw_partition", ::apache::thrift::protocol::T_CALL, cseqid);
 
-  storage_management_service_destroy_partition_pargs args;
+  storage_management_service_thaw_partition_pargs args;
   args.block_id = &block_id;
   args.write(this->oprot_);
 
@@ -2630,7 +3102,7 @@ void storage_management_serviceClientT<Protocol_>::send_destroy_partition(const
 }
 
 template <class Protocol_>
-void storage_management_serviceClientT<Protocol_>::recv_destroy_partition()
+void storage_management_serviceClientT<Protocol_>::recv_thaw_partition()
 {
 
   int32_t rseqid = 0;
@@ -2650,12 +3122,12 @@ void storage_management_serviceClientT<Protocol_>::recv_destroy_partition()
     this->iprot_->readMessageEnd();
     this->iprot_->getTransport()->readEnd();
   }
-  if (fname.compare("destroy_partition") != 0) {
+  if (fname.compare("thaw_partition") != 0) {
     this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
     this->iprot_->readMessageEnd();
     this->iprot_->getTransport()->readEnd();
   }
-  storage_management_service_destroy_partition_presult result;
+  storage_management_service_thaw_partition_presult result;
   result.read(this->iprot_);
   this->iprot_->readMessageEnd();
   this->iprot_->getTransport()->readEnd();
@@ -3258,40 +3730,268 @@ bool storage_management_serviceProcessorT<Protocol_>::dispatchCallTemplated(Prot
 }
 
 template <class Protocol_>
-void storage_management_serviceProcessorT<Protocol_>::process_create_partition(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+void storage_management_serviceProcessorT<Protocol_>::process_create_partition(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+{
+  void* ctx = NULL;
+  if (this->eventHandler_.get() != NULL) {
+    ctx = this->eventHandler_->getContext("storage_management_service.create_partition", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.create_partition");
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->preRead(ctx, "storage_management_service.create_partition");
+  }
+
+  storage_management_service_create_partition_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->postRead(ctx, "storage_management_service.create_partition", bytes);
+  }
+
+  storage_management_service_create_partition_result result;
+  try {
+    iface_->create_partition(args.block_id, args.partition_type, args.backing_path, args.partition_name, args.partition_metadata, args.conf);
+  } catch (storage_management_exception &ex) {
+    result.ex = ex;
+    result.__isset.ex = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != NULL) {
+      this->eventHandler_->handlerError(ctx, "storage_management_service.create_partition");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("create_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->preWrite(ctx, "storage_management_service.create_partition");
+  }
+
+  oprot->writeMessageBegin("create_partition", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->postWrite(ctx, "storage_management_service.create_partition", bytes);
+  }
+}
+
+template <class Protocol_>
+void storage_management_serviceProcessorT<Protocol_>::process_create_partition(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+{
+  void* ctx = NULL;
+  if (this->eventHandler_.get() != NULL) {
+    ctx = this->eventHandler_->getContext("storage_management_service.create_partition", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.create_partition");
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->preRead(ctx, "storage_management_service.create_partition");
+  }
+
+  storage_management_service_create_partition_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->postRead(ctx, "storage_management_service.create_partition", bytes);
+  }
+
+  storage_management_service_create_partition_result result;
+  try {
+    iface_->create_partition(args.block_id, args.partition_type, args.backing_path, args.partition_name, args.partition_metadata, args.conf);
+  } catch (storage_management_exception &ex) {
+    result.ex = ex;
+    result.__isset.ex = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != NULL) {
+      this->eventHandler_->handlerError(ctx, "storage_management_service.create_partition");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("create_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->preWrite(ctx, "storage_management_service.create_partition");
+  }
+
+  oprot->writeMessageBegin("create_partition", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->postWrite(ctx, "storage_management_service.create_partition", bytes);
+  }
+}
+
+template <class Protocol_>
+void storage_management_serviceProcessorT<Protocol_>::process_setup_chain(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+{
+  void* ctx = NULL;
+  if (this->eventHandler_.get() != NULL) {
+    ctx = this->eventHandler_->getContext("storage_management_service.setup_chain", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.setup_chain");
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->preRead(ctx, "storage_management_service.setup_chain");
+  }
+
+  storage_management_service_setup_chain_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->postRead(ctx, "storage_management_service.setup_chain", bytes);
+  }
+
+  storage_management_service_setup_chain_result result;
+  try {
+    iface_->setup_chain(args.block_id, args.path, args.chain, args.chain_role, args.next_block_id);
+  } catch (storage_management_exception &ex) {
+    result.ex = ex;
+    result.__isset.ex = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != NULL) {
+      this->eventHandler_->handlerError(ctx, "storage_management_service.setup_chain");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->preWrite(ctx, "storage_management_service.setup_chain");
+  }
+
+  oprot->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->postWrite(ctx, "storage_management_service.setup_chain", bytes);
+  }
+}
+
+template <class Protocol_>
+void storage_management_serviceProcessorT<Protocol_>::process_setup_chain(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+{
+  void* ctx = NULL;
+  if (this->eventHandler_.get() != NULL) {
+    ctx = this->eventHandler_->getContext("storage_management_service.setup_chain", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.setup_chain");
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->preRead(ctx, "storage_management_service.setup_chain");
+  }
+
+  storage_management_service_setup_chain_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->postRead(ctx, "storage_management_service.setup_chain", bytes);
+  }
+
+  storage_management_service_setup_chain_result result;
+  try {
+    iface_->setup_chain(args.block_id, args.path, args.chain, args.chain_role, args.next_block_id);
+  } catch (storage_management_exception &ex) {
+    result.ex = ex;
+    result.__isset.ex = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != NULL) {
+      this->eventHandler_->handlerError(ctx, "storage_management_service.setup_chain");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->preWrite(ctx, "storage_management_service.setup_chain");
+  }
+
+  oprot->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != NULL) {
+    this->eventHandler_->postWrite(ctx, "storage_management_service.setup_chain", bytes);
+  }
+}
+
+template <class Protocol_>
+void storage_management_serviceProcessorT<Protocol_>::process_destroy_partition(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
 {
   void* ctx = NULL;
   if (this->eventHandler_.get() != NULL) {
-    ctx = this->eventHandler_->getContext("storage_management_service.create_partition", callContext);
+    ctx = this->eventHandler_->getContext("storage_management_service.destroy_partition", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.create_partition");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.destroy_partition");
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preRead(ctx, "storage_management_service.create_partition");
+    this->eventHandler_->preRead(ctx, "storage_management_service.destroy_partition");
   }
 
-  storage_management_service_create_partition_args args;
+  storage_management_service_destroy_partition_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postRead(ctx, "storage_management_service.create_partition", bytes);
+    this->eventHandler_->postRead(ctx, "storage_management_service.destroy_partition", bytes);
   }
 
-  storage_management_service_create_partition_result result;
+  storage_management_service_destroy_partition_result result;
   try {
-    iface_->create_partition(args.block_id, args.partition_type, args.backing_path, args.partition_name, args.partition_metadata, args.conf);
+    iface_->destroy_partition(args.block_id);
   } catch (storage_management_exception &ex) {
     result.ex = ex;
     result.__isset.ex = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != NULL) {
-      this->eventHandler_->handlerError(ctx, "storage_management_service.create_partition");
+      this->eventHandler_->handlerError(ctx, "storage_management_service.destroy_partition");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("create_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -3300,55 +4000,55 @@ void storage_management_serviceProcessorT<Protocol_>::process_create_partition(i
   }
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preWrite(ctx, "storage_management_service.create_partition");
+    this->eventHandler_->preWrite(ctx, "storage_management_service.destroy_partition");
   }
 
-  oprot->writeMessageBegin("create_partition", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postWrite(ctx, "storage_management_service.create_partition", bytes);
+    this->eventHandler_->postWrite(ctx, "storage_management_service.destroy_partition", bytes);
   }
 }
 
 template <class Protocol_>
-void storage_management_serviceProcessorT<Protocol_>::process_create_partition(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+void storage_management_serviceProcessorT<Protocol_>::process_destroy_partition(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
 {
   void* ctx = NULL;
   if (this->eventHandler_.get() != NULL) {
-    ctx = this->eventHandler_->getContext("storage_management_service.create_partition", callContext);
+    ctx = this->eventHandler_->getContext("storage_management_service.destroy_partition", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.create_partition");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.destroy_partition");
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preRead(ctx, "storage_management_service.create_partition");
+    this->eventHandler_->preRead(ctx, "storage_management_service.destroy_partition");
   }
 
-  storage_management_service_create_partition_args args;
+  storage_management_service_destroy_partition_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postRead(ctx, "storage_management_service.create_partition", bytes);
+    this->eventHandler_->postRead(ctx, "storage_management_service.destroy_partition", bytes);
   }
 
-  storage_management_service_create_partition_result result;
+  storage_management_service_destroy_partition_result result;
   try {
-    iface_->create_partition(args.block_id, args.partition_type, args.backing_path, args.partition_name, args.partition_metadata, args.conf);
+    iface_->destroy_partition(args.block_id);
   } catch (storage_management_exception &ex) {
     result.ex = ex;
     result.__isset.ex = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != NULL) {
-      this->eventHandler_->handlerError(ctx, "storage_management_service.create_partition");
+      this->eventHandler_->handlerError(ctx, "storage_management_service.destroy_partition");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("create_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -3357,55 +4057,55 @@ void storage_management_serviceProcessorT<Protocol_>::process_create_partition(i
   }
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preWrite(ctx, "storage_management_service.create_partition");
+    this->eventHandler_->preWrite(ctx, "storage_management_service.destroy_partition");
   }
 
-  oprot->writeMessageBegin("create_partition", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postWrite(ctx, "storage_management_service.create_partition", bytes);
+    this->eventHandler_->postWrite(ctx, "storage_management_service.destroy_partition", bytes);
   }
 }
 
 template <class Protocol_>
-void storage_management_serviceProcessorT<Protocol_>::process_setup_chain(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+void storage_management_serviceProcessorT<Protocol_>::process_freeze_partition(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
 {
   void* ctx = NULL;
   if (this->eventHandler_.get() != NULL) {
-    ctx = this->eventHandler_->getContext("storage_management_service.setup_chain", callContext);
+    ctx = this->eventHandler_->getContext("storage_management_service.freeze_partition", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.setup_chain");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.freeze_partition");
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preRead(ctx, "storage_management_service.setup_chain");
+    this->eventHandler_->preRead(ctx, "storage_management_service.freeze_partition");
   }
 
-  storage_management_service_setup_chain_args args;
+  storage_management_service_freeze_partition_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postRead(ctx, "storage_management_service.setup_chain", bytes);
+    this->eventHandler_->postRead(ctx, "storage_management_service.freeze_partition", bytes);
   }
 
-  storage_management_service_setup_chain_result result;
+  storage_management_service_freeze_partition_result result;
   try {
-    iface_->setup_chain(args.block_id, args.path, args.chain, args.chain_role, args.next_block_id);
+    iface_->freeze_partition(args.block_id);
   } catch (storage_management_exception &ex) {
     result.ex = ex;
     result.__isset.ex = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != NULL) {
-      this->eventHandler_->handlerError(ctx, "storage_management_service.setup_chain");
+      this->eventHandler_->handlerError(ctx, "storage_management_service.freeze_partition");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("freeze_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -3414,55 +4114,55 @@ void storage_management_serviceProcessorT<Protocol_>::process_setup_chain(int32_
   }
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preWrite(ctx, "storage_management_service.setup_chain");
+    this->eventHandler_->preWrite(ctx, "storage_management_service.freeze_partition");
   }
 
-  oprot->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("freeze_partition", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postWrite(ctx, "storage_management_service.setup_chain", bytes);
+    this->eventHandler_->postWrite(ctx, "storage_management_service.freeze_partition", bytes);
   }
 }
 
 template <class Protocol_>
-void storage_management_serviceProcessorT<Protocol_>::process_setup_chain(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+void storage_management_serviceProcessorT<Protocol_>::process_freeze_partition(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
 {
   void* ctx = NULL;
   if (this->eventHandler_.get() != NULL) {
-    ctx = this->eventHandler_->getContext("storage_management_service.setup_chain", callContext);
+    ctx = this->eventHandler_->getContext("storage_management_service.freeze_partition", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.setup_chain");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.freeze_partition");
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preRead(ctx, "storage_management_service.setup_chain");
+    this->eventHandler_->preRead(ctx, "storage_management_service.freeze_partition");
   }
 
-  storage_management_service_setup_chain_args args;
+  storage_management_service_freeze_partition_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postRead(ctx, "storage_management_service.setup_chain", bytes);
+    this->eventHandler_->postRead(ctx, "storage_management_service.freeze_partition", bytes);
   }
 
-  storage_management_service_setup_chain_result result;
+  storage_management_service_freeze_partition_result result;
   try {
-    iface_->setup_chain(args.block_id, args.path, args.chain, args.chain_role, args.next_block_id);
+    iface_->freeze_partition(args.block_id);
   } catch (storage_management_exception &ex) {
     result.ex = ex;
     result.__isset.ex = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != NULL) {
-      this->eventHandler_->handlerError(ctx, "storage_management_service.setup_chain");
+      this->eventHandler_->handlerError(ctx, "storage_management_service.freeze_partition");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("freeze_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -3471,55 +4171,55 @@ void storage_management_serviceProcessorT<Protocol_>::process_setup_chain(int32_
   }
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preWrite(ctx, "storage_management_service.setup_chain");
+    this->eventHandler_->preWrite(ctx, "storage_management_service.freeze_partition");
   }
 
-  oprot->writeMessageBegin("setup_chain", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("freeze_partition", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postWrite(ctx, "storage_management_service.setup_chain", bytes);
+    this->eventHandler_->postWrite(ctx, "storage_management_service.freeze_partition", bytes);
   }
 }
 
 template <class Protocol_>
-void storage_management_serviceProcessorT<Protocol_>::process_destroy_partition(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+void storage_management_serviceProcessorT<Protocol_>::process_thaw_partition(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
 {
   void* ctx = NULL;
   if (this->eventHandler_.get() != NULL) {
-    ctx = this->eventHandler_->getContext("storage_management_service.destroy_partition", callContext);
+    ctx = this->eventHandler_->getContext("storage_management_service.thaw_partition", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.destroy_partition");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.thaw_partition");
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preRead(ctx, "storage_management_service.destroy_partition");
+    this->eventHandler_->preRead(ctx, "storage_management_service.thaw_partition");
   }
 
-  storage_management_service_destroy_partition_args args;
+  storage_management_service_thaw_partition_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postRead(ctx, "storage_management_service.destroy_partition", bytes);
+    this->eventHandler_->postRead(ctx, "storage_management_service.thaw_partition", bytes);
   }
 
-  storage_management_service_destroy_partition_result result;
+  storage_management_service_thaw_partition_result result;
   try {
-    iface_->destroy_partition(args.block_id);
+    iface_->thaw_partition(args.block_id);
   } catch (storage_management_exception &ex) {
     result.ex = ex;
     result.__isset.ex = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != NULL) {
-      this->eventHandler_->handlerError(ctx, "storage_management_service.destroy_partition");
+      this->eventHandler_->handlerError(ctx, "storage_management_service.thaw_partition");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("thaw_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -3528,55 +4228,55 @@ void storage_management_serviceProcessorT<Protocol_>::process_destroy_partition(
   }
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preWrite(ctx, "storage_management_service.destroy_partition");
+    this->eventHandler_->preWrite(ctx, "storage_management_service.thaw_partition");
   }
 
-  oprot->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("thaw_partition", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postWrite(ctx, "storage_management_service.destroy_partition", bytes);
+    this->eventHandler_->postWrite(ctx, "storage_management_service.thaw_partition", bytes);
   }
 }
 
 template <class Protocol_>
-void storage_management_serviceProcessorT<Protocol_>::process_destroy_partition(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+void storage_management_serviceProcessorT<Protocol_>::process_thaw_partition(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
 {
   void* ctx = NULL;
   if (this->eventHandler_.get() != NULL) {
-    ctx = this->eventHandler_->getContext("storage_management_service.destroy_partition", callContext);
+    ctx = this->eventHandler_->getContext("storage_management_service.thaw_partition", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.destroy_partition");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "storage_management_service.thaw_partition");
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preRead(ctx, "storage_management_service.destroy_partition");
+    this->eventHandler_->preRead(ctx, "storage_management_service.thaw_partition");
   }
 
-  storage_management_service_destroy_partition_args args;
+  storage_management_service_thaw_partition_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postRead(ctx, "storage_management_service.destroy_partition", bytes);
+    this->eventHandler_->postRead(ctx, "storage_management_service.thaw_partition", bytes);
   }
 
-  storage_management_service_destroy_partition_result result;
+  storage_management_service_thaw_partition_result result;
   try {
-    iface_->destroy_partition(args.block_id);
+    iface_->thaw_partition(args.block_id);
   } catch (storage_management_exception &ex) {
     result.ex = ex;
     result.__isset.ex = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != NULL) {
-      this->eventHandler_->handlerError(ctx, "storage_management_service.destroy_partition");
+      this->eventHandler_->handlerError(ctx, "storage_management_service.thaw_partition");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("thaw_partition", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -3585,17 +4285,17 @@ void storage_management_serviceProcessorT<Protocol_>::process_destroy_partition(
   }
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->preWrite(ctx, "storage_management_service.destroy_partition");
+    this->eventHandler_->preWrite(ctx, "storage_management_service.thaw_partition");
   }
 
-  oprot->writeMessageBegin("destroy_partition", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("thaw_partition", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != NULL) {
-    this->eventHandler_->postWrite(ctx, "storage_management_service.destroy_partition", bytes);
+    this->eventHandler_->postWrite(ctx, "storage_management_service.thaw_partition", bytes);
   }
 }
 
@@ -4903,6 +5603,176 @@ void storage_management_serviceConcurrentClientT<Protocol_>::recv_destroy_partit
   } // end while(true)
 }
 
+template <class Protocol_>
+void storage_management_serviceConcurrentClientT<Protocol_>::freeze_partition(const int32_t block_id)
+{
+  int32_t seqid = send_freeze_partition(block_id);
+  recv_freeze_partition(seqid);
+}
+
+template <class Protocol_>
+int32_t storage_management_serviceConcurrentClientT<Protocol_>::send_freeze_partition(const int32_t block_id)
+{
+  int32_t cseqid = this->sync_.generateSeqId();
+  ::apache::thrift::async::TConcurrentSendSentry sentry(&this->sync_);
+  this->oprot_->writeMessageBegin("freeze_partition", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  storage_management_service_freeze_partition_pargs args;
+  args.block_id = &block_id;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+
+  sentry.commit();
+  return cseqid;
+}
+
+template <class Protocol_>
+void storage_management_serviceConcurrentClientT<Protocol_>::recv_freeze_partition(const int32_t seqid)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  // the read mutex gets dropped and reacquired as part of waitForWork()
+  // The destructor of this sentry wakes up other clients
+  ::apache::thrift::async::TConcurrentRecvSentry sentry(&this->sync_, seqid);
+
+  while(true) {
+    if(!this->sync_.getPending(fname, mtype, rseqid)) {
+      this->iprot_->readMessageBegin(fname, mtype, rseqid);
+    }
+    if(seqid == rseqid) {
+      if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+        ::apache::thrift::TApplicationException x;
+        x.read(this->iprot_);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+        sentry.commit();
+        throw x;
+      }
+      if (mtype != ::apache::thrift::protocol::T_REPLY) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+      }
+      if (fname.compare("freeze_partition") != 0) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+
+        // in a bad state, don't commit
+        using ::apache::thrift::protocol::TProtocolException;
+        throw TProtocolException(TProtocolException::INVALID_DATA);
+      }
+      storage_management_service_freeze_partition_presult result;
+      result.read(this->iprot_);
+      this->iprot_->readMessageEnd();
+      this->iprot_->getTransport()->readEnd();
+
+      if (result.__isset.ex) {
+        sentry.commit();
+        throw result.ex;
+      }
+      sentry.commit();
+      return;
+    }
+    // seqid != rseqid
+    this->sync_.updatePending(fname, mtype, rseqid);
+
+    // this will temporarily unlock the readMutex, and let other clients get work done
+    this->sync_.waitForWork(seqid);
+  } // end while(true)
+}
+
+template <class Protocol_>
+void storage_management_serviceConcurrentClientT<Protocol_>::thaw_partition(const int32_t block_id)
+{
+  int32_t seqid = send_thaw_partition(block_id);
+  recv_thaw_partition(seqid);
+}
+
+template <class Protocol_>
+int32_t storage_management_serviceConcurrentClientT<Protocol_>::send_thaw_partition(const int32_t block_id)
+{
+  int32_t cseqid = this->sync_.generateSeqId();
+  ::apache::thrift::async::TConcurrentSendSentry sentry(&this->sync_);
+  this->oprot_->writeMessageBegin("thaw_partition", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  storage_management_service_thaw_partition_pargs args;
+  args.block_id = &block_id;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+
+  sentry.commit();
+  return cseqid;
+}
+
+template <class Protocol_>
+void storage_management_serviceConcurrentClientT<Protocol_>::recv_thaw_partition(const int32_t seqid)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  // the read mutex gets dropped and reacquired as part of waitForWork()
+  // The destructor of this sentry wakes up other clients
+  ::apache::thrift::async::TConcurrentRecvSentry sentry(&this->sync_, seqid);
+
+  while(true) {
+    if(!this->sync_.getPending(fname, mtype, rseqid)) {
+      this->iprot_->readMessageBegin(fname, mtype, rseqid);
+    }
+    if(seqid == rseqid) {
+      if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+        ::apache::thrift::TApplicationException x;
+        x.read(this->iprot_);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+        sentry.commit();
+        throw x;
+      }
+      if (mtype != ::apache::thrift::protocol::T_REPLY) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+      }
+      if (fname.compare("thaw_partition") != 0) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+
+        // in a bad state, don't commit
+        using ::apache::thrift::protocol::TProtocolException;
+        throw TProtocolException(TProtocolException::INVALID_DATA);
+      }
+      storage_management_service_thaw_partition_presult result;
+      result.read(this->iprot_);
+      this->iprot_->readMessageEnd();
+      this->iprot_->getTransport()->readEnd();
+
+      if (result.__isset.ex) {
+        sentry.commit();
+        throw result.ex;
+      }
+      sentry.commit();
+      return;
+    }
+    // seqid != rseqid
+    this->sync_.updatePending(fname, mtype, rseqid);
+
+    // this will temporarily unlock the readMutex, and let other clients get work done
+    this->sync_.waitForWork(seqid);
+  } // end while(true)
+}
+
 template <class Protocol_>
 void storage_management_serviceConcurrentClientT<Protocol_>::get_path(std::string& _return, const int32_t block_id)
 {
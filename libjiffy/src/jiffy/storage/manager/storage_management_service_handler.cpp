@@ -45,6 +45,24 @@ void storage_management_service_handler::destroy_partition(int32_t block_id) {
   }
 }
 
+void storage_management_service_handler::freeze_partition(int32_t block_id) {
+  try {
+    if (!blocks_.at(static_cast<std::size_t>(block_id))->impl()->freeze()) {
+      throw std::runtime_error("Commands on block " + std::to_string(block_id) + " did not drain");
+    }
+  } catch (std::exception &e) {
+    throw make_exception(e);
+  }
+}
+
+void storage_management_service_handler::thaw_partition(int32_t block_id) {
+  try {
+    blocks_.at(static_cast<std::size_t>(block_id))->impl()->thaw();
+  } catch (std::exception &e) {
+    throw make_exception(e);
+  }
+}
+
 void storage_management_service_handler::get_path(std::string &_return, const int32_t block_id) {
   try {
     _return = blocks_.at(static_cast<std::size_t>(block_id))->impl()->path();
@@ -63,7 +81,8 @@ void storage_management_service_handler::dump(int32_t block_id, const std::strin
 
 void storage_management_service_handler::sync(int32_t block_id, const std::string &backing_path) {
   try {
-    blocks_.at(static_cast<std::size_t>(block_id))->impl()->sync(backing_path);
+    // Persisted in the background, so that the partition keeps serving commands
+    blocks_.at(static_cast<std::size_t>(block_id))->impl()->snapshot(backing_path);
   } catch (std::exception &e) {
     throw make_exception(e);
   }
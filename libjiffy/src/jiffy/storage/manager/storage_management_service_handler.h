@@ -53,6 +53,20 @@ class storage_management_service_handler : public storage_management_serviceIf {
 
   void destroy_partition(int32_t block_id) override;
 
+  /**
+   * @brief Freeze partition, commands wait until it thaws
+   * @param block_id Block identifier
+   */
+
+  void freeze_partition(int32_t block_id) override;
+
+  /**
+   * @brief Thaw partition
+   * @param block_id Block identifier
+   */
+
+  void thaw_partition(int32_t block_id) override;
+
   /**
    * @brief Get block path
    * @param _return Block path
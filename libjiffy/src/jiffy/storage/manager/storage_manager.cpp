@@ -39,6 +39,20 @@ void storage_manager::destroy_partition(const std::string &block_name) {
   client.destroy_partition(bid.id);
 }
 
+void storage_manager::freeze_partition(const std::string &block_name) {
+  auto bid = block_id_parser::parse(block_name);
+  storage_management_client client(bid.host, bid.management_port);
+  LOG(log_level::info) << "freeze on " << bid.host << ":" << bid.management_port;
+  client.freeze_partition(bid.id);
+}
+
+void storage_manager::thaw_partition(const std::string &block_name) {
+  auto bid = block_id_parser::parse(block_name);
+  storage_management_client client(bid.host, bid.management_port);
+  LOG(log_level::info) << "thaw on " << bid.host << ":" << bid.management_port;
+  client.thaw_partition(bid.id);
+}
+
 std::string storage_manager::path(const std::string &block_name) {
   auto bid = block_id_parser::parse(block_name);
   storage_management_client client(bid.host, bid.management_port);
@@ -38,6 +38,18 @@ class storage_manager : public storage_management_ops {
    */
   void destroy_partition(const std::string &block_name) override;
 
+  /**
+   * @brief Freeze partition, commands wait until it thaws
+   * @param block_name Block name
+   */
+  void freeze_partition(const std::string &block_name) override;
+
+  /**
+   * @brief Thaw partition
+   * @param block_name Block name
+   */
+  void thaw_partition(const std::string &block_name) override;
+
   /**
    * @brief Fetch block path
    * @param block_name Block name
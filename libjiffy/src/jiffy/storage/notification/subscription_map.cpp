@@ -8,6 +8,7 @@ subscription_map::subscription_map() = default;
 
 void subscription_map::add_subscriptions(const std::vector<std::string> &ops,
                                          const std::shared_ptr<notification_response_client>& client) {
+  std::lock_guard<std::mutex> lock(mtx_);
   for (const auto &op: ops)
     subs_[op].insert(client);
   client->control(response_type::subscribe, ops, "");
@@ -16,6 +17,7 @@ void subscription_map::add_subscriptions(const std::vector<std::string> &ops,
 void subscription_map::remove_subscriptions(const std::vector<std::string> &ops,
                                             const std::shared_ptr<notification_response_client>& client,
                                             bool inform) {
+  std::lock_guard<std::mutex> lock(mtx_);
   for (const auto &op: ops) {
     auto &clients = subs_[op];
     auto it = clients.find(client);
@@ -31,18 +33,23 @@ void subscription_map::remove_subscriptions(const std::vector<std::string> &ops,
 
 void subscription_map::notify(const std::string &op, const std::string &msg) {
   if (op == "default_partition") return;
-  for (const auto &client: subs_[op]) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = subs_.find(op);
+  if (it == subs_.end()) return;
+  for (const auto &client: it->second) {
     client->notification(op, msg);
   }
 }
 
 void subscription_map::clear() {
+  std::lock_guard<std::mutex> lock(mtx_);
   subs_.clear();
 }
 
 // TODO fix this function so that we could let the
 // subscribed blocks know whenever the partition is destroyed
 void subscription_map::end_connections() {
+  std::lock_guard<std::mutex> lock(mtx_);
   for (const auto &sub: subs_) {
     for (const auto &client: sub.second) {
       client->notification("error", "!block_moved");
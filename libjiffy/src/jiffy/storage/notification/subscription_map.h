@@ -63,6 +63,9 @@ class subscription_map {
  private:
   /* Subscription map */
   std::map<std::string, std::set<std::shared_ptr<notification_response_client>>> subs_{};
+
+  /* Mutex, commands completing on I/O engine threads notify concurrently */
+  std::mutex mtx_;
 };
 
 }
@@ -13,10 +13,21 @@ partition::partition(block_memory_manager *manager,
       backing_path_(backing_path),
       supported_commands_(supported_commands),
       manager_(manager),
-      binary_allocator_(build_allocator<uint8_t>()) {
+      binary_allocator_(build_allocator<uint8_t>()),
+      snapshot_status_(std::make_shared<persistent::snapshot_status>()) {
   default_ = supported_commands_.empty();
 }
 
+void partition::run_command_view(response_view &_return, const arg_list &args) {
+  response result;
+  run_command(result, args);
+  _return = std::move(result);
+}
+
+bool partition::run_command_async(const arg_list &, std::function<void(const response &)>) {
+  return false;
+}
+
 void partition::path(const std::string &path) {
   path_ = path;
 }
@@ -96,6 +107,251 @@ binary partition::make_binary(const std::string &str) {
   return binary(str, binary_allocator_);
 }
 
+bool partition::snapshot(const std::string &path) {
+  return sync(path);
+}
+
+void partition::wait_snapshots() {
+  persistent::snapshot_writer::instance()->wait(snapshot_status_->last_ticket());
+  auto error = snapshot_status_->take_error();
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+void partition::persist(std::size_t bytes, persistent::snapshot_writer::job_type job) {
+  persistent::snapshot_writer::instance()->submit(snapshot_status_, bytes, seal_log(std::move(job)));
+}
+
+void partition::start_snapshot(std::size_t num_units,
+                               snapshot_copy::copy_function copy,
+                               std::size_t bytes,
+                               persistent::snapshot_writer::job_type job) {
+  snapshot_job_ = seal_log(std::move(job));
+  snapshot_bytes_ = bytes;
+  snapshot_copy_.start(num_units, std::move(copy));
+}
+
+void partition::finish_snapshot(std::mutex *lock) {
+  if (!snapshot_job_) {
+    return;
+  }
+  bool copied = true;
+  while (copied) {
+    if (lock != nullptr) {
+      std::lock_guard<std::mutex> guard(*lock);
+      copied = snapshot_copy_.copy_next();
+    } else {
+      copied = snapshot_copy_.copy_next();
+    }
+  }
+  persistent::snapshot_writer::instance()->submit(snapshot_status_, snapshot_bytes_, std::move(snapshot_job_));
+  snapshot_job_ = nullptr;
+}
+
+persistent::snapshot_writer::job_type partition::seal_log(persistent::snapshot_writer::job_type job) {
+  std::unique_lock<std::mutex> log_lock(log_mtx_);
+  if (log_ != nullptr) {
+    // The partition is frozen, so the sealed segments hold exactly the commands the snapshot captured
+    auto segment = log_->rotate();
+    auto dir = persistent::write_ahead_log::directory();
+    auto name = log_->name();
+    job = [job, dir, name, segment] {
+      job();
+      persistent::write_ahead_log::truncate(dir, name, segment);
+    };
+    if (name != log_name()) {
+      // Renamed partitions log under their new name from here on
+      log_.reset();
+    }
+  }
+  return job;
+}
+
+std::uint64_t partition::sealed_log_segment() {
+  std::lock_guard<std::mutex> log_lock(log_mtx_);
+  return log_ == nullptr ? 0 : log_->segment();
+}
+
+bool partition::snapshot_failed() {
+  return snapshot_status_->take_failure();
+}
+
+/* Write-ahead log sequence number of the command the thread ran last, and the partition it ran on */
+static thread_local std::pair<const partition *, std::uint64_t> last_log_lsn(nullptr, 0);
+
+std::uint64_t partition::take_log_lsn() {
+  auto lsn = last_log_lsn.first == this ? last_log_lsn.second : 0;
+  last_log_lsn = std::make_pair(nullptr, 0);
+  return lsn;
+}
+
+void partition::when_logged(std::uint64_t lsn, persistent::write_ahead_log::callback_type callback) {
+  std::shared_ptr<persistent::write_ahead_log> log;
+  {
+    std::lock_guard<std::mutex> log_lock(log_mtx_);
+    log = log_;
+  }
+  // The callback may run right away, so it runs without the lock held
+  log->when_durable(lsn, std::move(callback));
+}
+
+void partition::wait_logged(std::uint64_t lsn) {
+  std::shared_ptr<persistent::write_ahead_log> log;
+  {
+    std::lock_guard<std::mutex> log_lock(log_mtx_);
+    log = log_;
+  }
+  log->wait_durable(lsn);
+}
+
+void partition::log_mode(const std::string &mode) {
+  if (mode != "none" && mode != "async" && mode != "sync") {
+    throw std::invalid_argument("No such write-ahead log mode " + mode);
+  }
+  log_mode_ = mode;
+}
+
+void partition::log_command(const arg_list &args) {
+  if (log_mode_ == "none" || replaying_log_) {
+    return;
+  }
+  std::uint64_t lsn;
+  {
+    // Commands on different I/O threads may be the first to log
+    std::lock_guard<std::mutex> log_lock(log_mtx_);
+    if (log_ == nullptr) {
+      log_ = std::make_shared<persistent::write_ahead_log>(persistent::write_ahead_log::directory(), log_name());
+    }
+    lsn = log_->append(args);
+  }
+  if (log_mode_ == "sync") {
+    last_log_lsn = std::make_pair(this, lsn);
+  }
+}
+
+std::size_t partition::replay_log(const std::function<void(const arg_list &)> &apply,
+                                  std::uint64_t covered_segment) {
+  if (log_mode_ == "none") {
+    return 0;
+  }
+  std::shared_ptr<persistent::write_ahead_log> log;
+  {
+    std::lock_guard<std::mutex> log_lock(log_mtx_);
+    // Records of the current instance become part of the log that is replayed
+    log_.reset();
+    // New segments stay above the covered ones, which a later load would skip
+    log_ = std::make_shared<persistent::write_ahead_log>(persistent::write_ahead_log::directory(), log_name(),
+                                                         covered_segment + 1);
+    log = log_;
+  }
+  replaying_log_ = true;
+  try {
+    auto num_records = log->replay(apply, covered_segment);
+    replaying_log_ = false;
+    return num_records;
+  } catch (...) {
+    replaying_log_ = false;
+    throw;
+  }
+}
+
+bool partition::replaying_log() const {
+  return replaying_log_;
+}
+
+void partition::discard_log() {
+  std::shared_ptr<persistent::write_ahead_log> log;
+  {
+    std::lock_guard<std::mutex> log_lock(log_mtx_);
+    log.swap(log_);
+  }
+  if (log != nullptr) {
+    log->remove();
+  } else if (log_mode_ != "none") {
+    persistent::write_ahead_log(persistent::write_ahead_log::directory(), log_name()).remove();
+  }
+}
+
+void partition::close_log() {
+  std::shared_ptr<persistent::write_ahead_log> log;
+  {
+    std::lock_guard<std::mutex> log_lock(log_mtx_);
+    log.swap(log_);
+  }
+  // Closed once the lock is released, since closing runs the callbacks of the last records
+}
+
+std::string partition::log_name() const {
+  // Identifies the partition across restarts: a recovered partition has the same file path and name
+  return path_ + ":" + name_;
+}
+
+bool partition::freeze(std::chrono::milliseconds timeout, std::chrono::milliseconds lease) {
+  std::unique_lock<std::mutex> lock(freeze_mtx_);
+  ++num_freezes_;
+  freeze_expiry_ = std::max(freeze_expiry_, std::chrono::steady_clock::now() + lease);
+  if (!freeze_cv_.wait_for(lock, timeout, [this] { return num_commands_ == 0; })) {
+    if (num_freezes_ > 0) {
+      --num_freezes_;
+    }
+    freeze_cv_.notify_all();
+    return false;
+  }
+  return true;
+}
+
+void partition::thaw() {
+  std::lock_guard<std::mutex> lock(freeze_mtx_);
+  if (num_freezes_ > 0 && --num_freezes_ == 0) {
+    freeze_cv_.notify_all();
+  }
+}
+
+partition::command_guard::command_guard(partition &p) : partition_(p) {
+  std::unique_lock<std::mutex> lock(partition_.freeze_mtx_);
+  while (partition_.num_freezes_ > 0) {
+    partition_.freeze_cv_.wait_until(lock, partition_.freeze_expiry_);
+    if (partition_.num_freezes_ > 0 && std::chrono::steady_clock::now() >= partition_.freeze_expiry_) {
+      LOG(log_level::warn) << "Partition freeze expired before it was thawed, resuming commands";
+      partition_.num_freezes_ = 0;
+      partition_.freeze_cv_.notify_all();
+    }
+  }
+  ++partition_.num_commands_;
+}
+
+partition::command_guard::~command_guard() {
+  std::lock_guard<std::mutex> lock(partition_.freeze_mtx_);
+  if (--partition_.num_commands_ == 0) {
+    partition_.freeze_cv_.notify_all();
+  }
+}
+
+partition::freeze_guard::freeze_guard(partition &p) : partition_(p), frozen_(p.freeze()) {}
+
+partition::freeze_guard::~freeze_guard() {
+  if (frozen_) {
+    partition_.thaw();
+  }
+}
+
+bool partition::freeze_guard::frozen() const {
+  return frozen_;
+}
+
+partition::borrow_guard::borrow_guard(partition &p) : partition_(p) {
+  partition_.num_borrowers_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+partition::borrow_guard::~borrow_guard() {
+  partition_.num_borrowers_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+bool partition::sole_borrower() const {
+  return num_borrowers_.load(std::memory_order_acquire) == 1;
+}
+
 
 }
 }
\ No newline at end of file
@@ -1,6 +1,12 @@
 #ifndef JIFFY_BLOCK_H
 #define JIFFY_BLOCK_H
 
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 #include <string>
@@ -13,8 +19,12 @@
 #include "jiffy/storage/notification/subscription_map.h"
 #include "jiffy/storage/service/block_response_client_map.h"
 #include "jiffy/storage/command.h"
+#include "jiffy/storage/response_view.h"
+#include "jiffy/storage/snapshot_copy.h"
 #include "jiffy/storage/block_memory_manager.h"
 #include "jiffy/storage/block_memory_allocator.h"
+#include "jiffy/persistent/snapshot_writer.h"
+#include "jiffy/persistent/write_ahead_log.h"
 #include "jiffy/utils/logger.h"
 
 #define RETURN(...)           \
@@ -32,6 +42,32 @@ using namespace utils;
 typedef std::vector<std::string> arg_list;
 typedef std::vector<std::string> response;
 
+/**
+ * @brief Copy of partition data captured for a background snapshot.
+ * The copy is allocated from memory of its own, so that it neither counts against the partition
+ * capacity nor depends on the partition once captured.
+ * @tparam T Data type
+ */
+template<typename T>
+struct data_snapshot {
+  data_snapshot() : manager(std::numeric_limits<std::size_t>::max()) {}
+
+  /**
+   * @brief Build an allocator for the copy
+   * @tparam U Type of data
+   * @return Allocator
+   */
+  template<typename U>
+  block_memory_allocator<U> build_allocator() {
+    return block_memory_allocator<U>(&manager);
+  }
+
+  /* Memory of the copy */
+  block_memory_manager manager;
+  /* Copy, declared after its memory so that it is destroyed first */
+  std::unique_ptr<T> data;
+};
+
 /* Partition class */
 class partition {
  public:
@@ -68,6 +104,24 @@ class partition {
    */
   virtual void run_command(response &_return, const arg_list &args) = 0;
 
+  /**
+   * @brief Run a command on a block, borrowing payloads from partition memory where possible
+   * Borrowed elements are only valid until the next command runs on the block; the default
+   * implementation copies the response of run_command()
+   * @param _return Return value
+   * @param args Operation arguments
+   */
+  virtual void run_command_view(response_view &_return, const arg_list &args);
+
+  /**
+   * @brief Run a command that completes asynchronously, e.g. once its disk I/O finishes
+   * The default implementation runs no command asynchronously
+   * @param args Operation arguments
+   * @param done Called with the response once the command completes, possibly on another thread
+   * @return Bool value, false if the command does not run asynchronously, in which case done is not called
+   */
+  virtual bool run_command_async(const arg_list &args, std::function<void(const response &)> done);
+
   /**
    * @brief Set block path
    * @param path Block path
@@ -157,6 +211,90 @@ class partition {
    */
   virtual bool dump(const std::string &path) = 0;
 
+  /**
+   * @brief Capture partition data and persist it on the snapshot writer, without waiting for the write.
+   * The default implementation syncs on the calling thread.
+   * @param path Persistent store path to write to.
+   * @return True if data was captured, false otherwise.
+   */
+  virtual bool snapshot(const std::string &path);
+
+  /**
+   * @brief Wait for the snapshots of the partition persisted so far
+   * Rethrows the error of a failed snapshot
+   */
+  void wait_snapshots();
+
+  /**
+   * @brief Freeze the partition: commands that have not started yet wait until it thaws.
+   * Freezes nest; every successful freeze must be matched by a thaw. A freeze that is not thawed
+   * within its lease expires, so that a lost coordinator cannot stall the partition.
+   * @param timeout Time to wait for running commands to complete
+   * @param lease Time after which the freeze expires
+   * @return Bool value, false if running commands did not complete in time, in which case the partition is not frozen
+   */
+  bool freeze(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000),
+              std::chrono::milliseconds lease = std::chrono::milliseconds(10000));
+
+  /**
+   * @brief Undo a freeze
+   */
+  void thaw();
+
+  /**
+   * @brief Marks a command running for as long as it lives, waiting first while the partition is frozen
+   */
+  class command_guard {
+   public:
+    explicit command_guard(partition &p);
+    ~command_guard();
+    command_guard(const command_guard &) = delete;
+    command_guard &operator=(const command_guard &) = delete;
+   private:
+    partition &partition_;
+  };
+
+  /**
+   * @brief Freezes the partition for as long as it lives, e.g. while capturing a snapshot
+   */
+  class freeze_guard {
+   public:
+    explicit freeze_guard(partition &p);
+    ~freeze_guard();
+    freeze_guard(const freeze_guard &) = delete;
+    freeze_guard &operator=(const freeze_guard &) = delete;
+
+    /**
+     * @brief Check if the freeze succeeded
+     * @return Bool value, false if running commands did not complete in time
+     */
+    bool frozen() const;
+   private:
+    partition &partition_;
+    bool frozen_;
+  };
+
+  /**
+   * @brief Marks a request whose response may borrow partition memory for as long as it lives; the
+   * response must be sent before the guard goes away
+   */
+  class borrow_guard {
+   public:
+    explicit borrow_guard(partition &p);
+    ~borrow_guard();
+    borrow_guard(const borrow_guard &) = delete;
+    borrow_guard &operator=(const borrow_guard &) = delete;
+   private:
+    partition &partition_;
+  };
+
+  /**
+   * @brief Check if the calling request, which must hold a borrow guard, is the only one whose response
+   * may borrow partition memory, so that memory read by earlier requests can be freed
+   * @return Bool value, true if no other request holds a borrow guard
+   */
+  bool sole_borrower() const;
+
   /**
    * @brief Get the storage capacity of the partition.
    * @return The storage capacity of the partition.
@@ -206,6 +344,26 @@ class partition {
    */
   void notify(const arg_list & args);
 
+  /**
+   * @brief Fetch and clear the write-ahead log sequence number of the command the calling thread ran
+   * last on the partition
+   * @return Sequence number, 0 unless the command has to be durable before it is acknowledged
+   */
+  std::uint64_t take_log_lsn();
+
+  /**
+   * @brief Run a callback once a write-ahead log record is durable, possibly on another thread
+   * @param lsn Sequence number returned by take_log_lsn()
+   * @param callback Callback
+   */
+  void when_logged(std::uint64_t lsn, persistent::write_ahead_log::callback_type callback);
+
+  /**
+   * @brief Wait for a write-ahead log record to be durable
+   * @param lsn Sequence number returned by take_log_lsn()
+   */
+  void wait_logged(std::uint64_t lsn);
+
  protected:
   /**
    * @brief Construct binary string
@@ -214,6 +372,93 @@ class partition {
    */
   binary make_binary(const std::string &str);
 
+  /**
+   * @brief Hand a snapshot job of the partition to the snapshot writer
+   * @param bytes Number of bytes the job writes
+   * @param job Job, must only hold data it owns since it may run after the partition is destroyed
+   */
+  void persist(std::size_t bytes, persistent::snapshot_writer::job_type job);
+
+  /**
+   * @brief Start a snapshot whose data is copied one unit at a time; the partition must be frozen.
+   * The write-ahead log is sealed now, and finish_snapshot() hands the job to the snapshot writer once
+   * every unit is copied
+   * @param num_units Number of units
+   * @param copy Function copying a unit into the data the job persists
+   * @param bytes Number of bytes the job writes
+   * @param job Job, must only hold data it owns since it may run after the partition is destroyed
+   */
+  void start_snapshot(std::size_t num_units,
+                      snapshot_copy::copy_function copy,
+                      std::size_t bytes,
+                      persistent::snapshot_writer::job_type job);
+
+  /**
+   * @brief Copy the units of the started snapshot still pending while commands run, then persist it
+   * @param lock Mutex serializing commands on the data, held while copying each unit; null if a unit
+   * can be copied while commands change other units
+   */
+  void finish_snapshot(std::mutex *lock = nullptr);
+
+  /**
+   * @brief Fetch the last write-ahead log segment whose commands a snapshot taken now holds, i.e. the
+   * segment the next persist() or start_snapshot() seals; the partition must be frozen
+   * @return Segment number, 0 without a log
+   */
+  std::uint64_t sealed_log_segment();
+
+  /**
+   * @brief Check if a snapshot job failed since the previous check; the persistent store may then miss
+   * a delta, so the next snapshot has to write a full image
+   * @return Bool value, true if a snapshot job failed
+   */
+  bool snapshot_failed();
+
+  /**
+   * @brief Set the write-ahead log mode: none, async to log commands without waiting for them to be
+   * durable, or sync to acknowledge commands only once durable
+   * @param mode Mode
+   */
+  void log_mode(const std::string &mode);
+
+  /**
+   * @brief Append a mutator command to the write-ahead log, if enabled; commands replayed from the log
+   * are not logged again
+   * @param args Command arguments
+   */
+  void log_command(const arg_list &args);
+
+  /**
+   * @brief Replay the write-ahead log left by a previous instance of the partition, after loading its
+   * snapshot
+   * @param apply Called with each logged command
+   * @param covered_segment Last log segment whose commands the snapshot holds, as recorded by the
+   * snapshot; these segments are skipped
+   * @return Number of replayed commands
+   */
+  std::size_t replay_log(const std::function<void(const arg_list &)> &apply, std::uint64_t covered_segment = 0);
+
+  /**
+   * @brief Check if commands are being replayed from the write-ahead log
+   * @return Bool value, true while replaying
+   */
+  bool replaying_log() const;
+
+  /**
+   * @brief Remove the write-ahead log, once the partition data was written out in full
+   */
+  void discard_log();
+
+  /**
+   * @brief Close the write-ahead log, making its records durable; must be called before members that
+   * durable callbacks use are destroyed
+   */
+  void close_log();
+
+  /* Data of the started snapshot, copied one unit at a time */
+  snapshot_copy snapshot_copy_;
+  /* Mutex serializing snapshots and dumps, so that a snapshot is persisted before the next one starts */
+  std::mutex snapshot_mtx_;
   /* Partition backing_path */
   std::string backing_path_;
   /* Partition name */
@@ -234,6 +479,47 @@ class partition {
   allocator<uint8_t> binary_allocator_;
   /* Atomic bool to indicate that the partition is a default one */
   std::atomic<bool> default_{};
+
+ private:
+  /**
+   * @brief Seal the write-ahead log segments a snapshot taken now holds; the partition must be frozen
+   * @param job Snapshot job
+   * @return Job that also truncates the sealed segments once it has run
+   */
+  persistent::snapshot_writer::job_type seal_log(persistent::snapshot_writer::job_type job);
+
+  /* Outcome of the snapshot jobs, shared with the jobs */
+  std::shared_ptr<persistent::snapshot_status> snapshot_status_;
+  /* Job of the started snapshot */
+  persistent::snapshot_writer::job_type snapshot_job_;
+  /* Number of bytes the job of the started snapshot writes */
+  std::size_t snapshot_bytes_{0};
+  /* Mutex guarding the freeze state */
+  std::mutex freeze_mtx_;
+  /* Signalled when the partition thaws or a command completes */
+  std::condition_variable freeze_cv_;
+  /* Number of active freezes */
+  std::size_t num_freezes_{0};
+  /* Number of running commands */
+  std::size_t num_commands_{0};
+  /* Number of requests whose response may borrow partition memory */
+  std::atomic<std::size_t> num_borrowers_{0};
+  /* Expiry of the active freezes */
+  std::chrono::steady_clock::time_point freeze_expiry_;
+  /* Write-ahead log mode */
+  std::string log_mode_{"none"};
+  /* Mutex guarding the write-ahead log pointer */
+  std::mutex log_mtx_;
+  /* Write-ahead log, opened on the first logged command; shared with threads waiting on it */
+  std::shared_ptr<persistent::write_ahead_log> log_;
+  /* Bool value, true while replaying the write-ahead log */
+  bool replaying_log_{false};
+
+  /**
+   * @brief Fetch the name of the write-ahead log of the partition
+   * @return Log name
+   */
+  std::string log_name() const;
 };
 
 }
@@ -0,0 +1,239 @@
+#ifndef JIFFY_RESPONSE_VIEW_H
+#define JIFFY_RESPONSE_VIEW_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+#include "jiffy/storage/types/binary.h"
+
+namespace jiffy {
+namespace storage {
+
+/* Pointer and length of bytes borrowed from partition memory */
+struct byte_span {
+  const char *data;
+  std::size_t size;
+};
+
+/**
+ * @brief Borrow bytes from partition memory
+ * @param data Data pointer
+ * @param size Data size
+ * @return Byte span
+ */
+inline byte_span borrow(const char *data, std::size_t size) {
+  return byte_span{data, size};
+}
+
+/**
+ * @brief Borrow the bytes of a binary
+ * @param bin Binary
+ * @return Byte span
+ */
+inline byte_span borrow(const binary &bin) {
+  return byte_span{reinterpret_cast<const char *>(bin.data()), bin.size()};
+}
+
+inline bool operator==(const byte_span &span, const std::string &str) {
+  return span.size == str.size() && std::char_traits<char>::compare(span.data, str.data(), span.size) == 0;
+}
+
+/* Response element, either an owned string or bytes borrowed from partition memory */
+class response_element {
+ public:
+  response_element(std::string str) : owned_(std::move(str)), span_{nullptr, 0}, borrowed_(false) {}
+
+  response_element(const char *str) : owned_(str), span_{nullptr, 0}, borrowed_(false) {}
+
+  response_element(byte_span span) : span_(span), borrowed_(true) {}
+
+  /**
+   * @brief Fetch element data
+   * @return Data pointer
+   */
+  const char *data() const {
+    return borrowed_ ? span_.data : owned_.data();
+  }
+
+  /**
+   * @brief Fetch element size
+   * @return Size
+   */
+  std::size_t size() const {
+    return borrowed_ ? span_.size : owned_.size();
+  }
+
+  /**
+   * @brief Check if element is borrowed from partition memory
+   * @return True if borrowed
+   */
+  bool borrowed() const {
+    return borrowed_;
+  }
+
+  /**
+   * @brief Copy element into a string
+   * @return String
+   */
+  std::string str() const {
+    return borrowed_ ? std::string(span_.data, span_.size) : owned_;
+  }
+
+  /**
+   * @brief Copy borrowed bytes so the element no longer references partition memory
+   */
+  void own() {
+    if (borrowed_) {
+      owned_.assign(span_.data, span_.size);
+      borrowed_ = false;
+    }
+  }
+
+  bool operator==(const std::string &other) const {
+    return size() == other.size() && std::char_traits<char>::compare(data(), other.data(), size()) == 0;
+  }
+
+  bool operator!=(const std::string &other) const {
+    return !(*this == other);
+  }
+
+ private:
+  /* Owned string */
+  std::string owned_;
+  /* Borrowed bytes */
+  byte_span span_;
+  /* True if the element is borrowed */
+  bool borrowed_;
+};
+
+/*
+ * Response that can reference payloads in partition memory instead of copying them, so that
+ * they are copied once, straight into the transport. The response is sent after the partition's
+ * command guard is released, so only data that cannot change or be freed once written (sealed
+ * file, fifo and shared log regions) may be borrowed; mutable data such as hash table values must
+ * be owned. Dequeued fifo extents are only freed while no other request holds a borrow guard of
+ * the partition.
+ */
+class response_view {
+ public:
+  typedef std::vector<response_element>::const_iterator const_iterator;
+
+  response_view() = default;
+
+  response_view(std::initializer_list<response_element> elements) : elements_(elements) {}
+
+  explicit response_view(const std::vector<std::string> &resp) {
+    *this = resp;
+  }
+
+  explicit response_view(std::vector<std::string> &&resp) {
+    *this = std::move(resp);
+  }
+
+  response_view &operator=(std::initializer_list<response_element> elements) {
+    elements_.assign(elements);
+    return *this;
+  }
+
+  response_view &operator=(const std::vector<std::string> &resp) {
+    elements_.clear();
+    elements_.reserve(resp.size());
+    for (const auto &e: resp) {
+      elements_.emplace_back(e);
+    }
+    return *this;
+  }
+
+  response_view &operator=(std::vector<std::string> &&resp) {
+    elements_.clear();
+    elements_.reserve(resp.size());
+    for (auto &e: resp) {
+      elements_.emplace_back(std::move(e));
+    }
+    resp.clear();
+    return *this;
+  }
+
+  /**
+   * @brief Add element
+   * @param element Element
+   */
+  void push_back(response_element element) {
+    elements_.push_back(std::move(element));
+  }
+
+  /**
+   * @brief Construct element in place
+   * @param args Element constructor arguments
+   */
+  template<typename... Args>
+  void emplace_back(Args &&... args) {
+    elements_.emplace_back(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Fetch element
+   * @param i Element index
+   * @return Element
+   */
+  const response_element &operator[](std::size_t i) const {
+    return elements_[i];
+  }
+
+  /**
+   * @brief Fetch number of elements
+   * @return Number of elements
+   */
+  std::size_t size() const {
+    return elements_.size();
+  }
+
+  /**
+   * @brief Check if response is empty
+   * @return True if empty
+   */
+  bool empty() const {
+    return elements_.empty();
+  }
+
+  const_iterator begin() const {
+    return elements_.begin();
+  }
+
+  const_iterator end() const {
+    return elements_.end();
+  }
+
+  /**
+   * @brief Copy all borrowed elements so the response no longer references partition memory
+   */
+  void own() {
+    for (auto &e: elements_) {
+      e.own();
+    }
+  }
+
+  /**
+   * @brief Copy response into a vector of strings
+   * @return Response
+   */
+  std::vector<std::string> to_response() const {
+    std::vector<std::string> out;
+    out.reserve(elements_.size());
+    for (const auto &e: elements_) {
+      out.push_back(e.str());
+    }
+    return out;
+  }
+
+ private:
+  /* Response elements */
+  std::vector<response_element> elements_;
+};
+
+}
+}
+
+#endif //JIFFY_RESPONSE_VIEW_H
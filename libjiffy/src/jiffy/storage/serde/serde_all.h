@@ -6,10 +6,19 @@
 #include "jiffy/storage/fifoqueue/fifo_queue_defs.h"
 #include "jiffy/storage/shared_log/shared_log_defs.h"
 #include "jiffy/storage/types/binary.h"
+#include "jiffy/persistent/async_stream.h"
+#include "jiffy/persistent/compression.h"
+#include "jiffy/persistent/indexed_file.h"
+#include "jiffy/persistent/mapped_file.h"
 #include "jiffy/utils/logger.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <vector>
 
 using namespace jiffy::utils;
 
@@ -65,6 +74,17 @@ class serde {
     return binary(str, allocator_);
   }
 
+  /**
+   * @brief Make a byte range binary
+   * @param data Bytes
+   * @param size Number of bytes
+   * @return Binary string
+   */
+
+  binary make_binary(const char *data, std::size_t size) {
+    return binary(reinterpret_cast<const uint8_t *>(data), size, allocator_);
+  }
+
  private:
 
   /**
@@ -271,7 +291,7 @@ class csv_serde_impl : public serde {
 
   template<typename DataType>
   std::size_t serialize_impl(const DataType &table, const std::string &out_path) {
-    std::ofstream out(out_path, std::ios::out);
+    persistent::async_ofstream out(out_path);
     for (auto e: table) {
       out << to_string(e.first) << "," << to_string(e.second)
           << "\n";
@@ -290,7 +310,7 @@ class csv_serde_impl : public serde {
    */
 
   std::size_t serialize_impl(const fifo_queue_type &table, const std::string &out_path) {
-    std::ofstream out(out_path, std::ios::out);
+    persistent::async_ofstream out(out_path);
     for (auto e = table.begin(); e != table.end(); e++) {
       out << *e << "\n";
     }
@@ -308,7 +328,7 @@ class csv_serde_impl : public serde {
    */
 
   std::size_t serialize_impl(const file_type &table, const std::string &out_path) {
-    std::ofstream out(out_path, std::ios::out);
+    persistent::async_ofstream out(out_path);
     out << std::string(table.data(), table.size()) << "\n";
     out.flush();
     auto sz = out.tellp();
@@ -336,7 +356,7 @@ class csv_serde_impl : public serde {
 
   template<typename DataType>
   std::size_t deserialize_impl(DataType &data, const std::string &in_path) {
-    std::ifstream in(in_path);
+    persistent::async_ifstream in(in_path);
     while (!in.eof()) {
       std::string line;
       std::getline(in, line, '\n');
@@ -358,7 +378,7 @@ class csv_serde_impl : public serde {
    */
 
   std::size_t deserialize_impl(fifo_queue_type &data, const std::string &in_path) {
-    std::ifstream in(in_path);
+    persistent::async_ifstream in(in_path);
     while (!in.eof()) {
       std::string line;
       std::getline(in, line, '\n');
@@ -379,7 +399,7 @@ class csv_serde_impl : public serde {
    */
 
   std::size_t deserialize_impl(file_type &data, const std::string &in_path) {
-    std::ifstream in(in_path);
+    persistent::async_ifstream in(in_path);
     std::size_t offset = 0;
     while (!in.eof()) {
       std::string line;
@@ -450,12 +470,51 @@ class binary_serde_impl : public serde {
  public:
   /**
    * @brief Constructor
+   * @param allocator Allocator for deserialized data
+   * @param codec Codec compressing the files in independent chunks, null to write raw files
    */
-  explicit binary_serde_impl(const block_memory_allocator<uint8_t> &allocator) : serde(allocator) {}
+  explicit binary_serde_impl(const block_memory_allocator<uint8_t> &allocator,
+                             std::shared_ptr<persistent::codec> codec = nullptr)
+      : serde(allocator), codec_(std::move(codec)) {}
 
   ~binary_serde_impl() override = default;
 
  protected:
+  /**
+   * @brief Open an output stream for one of the files of an image, the file is closed when the stream is destroyed
+   * @param path File path
+   * @return Output stream
+   */
+  std::unique_ptr<std::ostream> open_output(const std::string &path) {
+    if (codec_ != nullptr) {
+      return std::unique_ptr<std::ostream>(new persistent::compressed_ofstream(path, codec_));
+    }
+    return std::unique_ptr<std::ostream>(new persistent::async_ofstream(path));
+  }
+
+  /**
+   * @brief Open an input stream for one of the files of an image
+   * @param path File path
+   * @return Input stream
+   */
+  std::unique_ptr<std::istream> open_input(const std::string &path) {
+    if (codec_ != nullptr) {
+      return std::unique_ptr<std::istream>(new persistent::compressed_ifstream(path));
+    }
+    return std::unique_ptr<std::istream>(new persistent::async_ifstream(path));
+  }
+
+  /* Minimum number of records decoded by each loader thread */
+  static const std::size_t RECORDS_PER_THREAD = 65536;
+
+  /* Key value record located in mapped files */
+  struct record {
+    const char *key;
+    std::size_t key_size;
+    const char *value;
+    std::size_t value_size;
+  };
+
   /**
    * @brief Binary serialization
    * @param table Hash table
@@ -465,23 +524,23 @@ class binary_serde_impl : public serde {
 
   template<typename Datatype>
   size_t serialize_impl(const Datatype &table, const std::string &out_path) {
-    std::ofstream out(out_path, std::ios::binary);
+    auto out = open_output(out_path);
     std::string offset_out_path = out_path;
     offset_out_path.append("_offset");
-    std::ofstream offset_out(offset_out_path, std::ios::binary);
+    auto offset_out = open_output(offset_out_path);
     for (const auto &e: table) {
       std::size_t key_size = e.first.size();
       std::size_t value_size = e.second.size();
-      offset_out.write(reinterpret_cast<const char *>(&key_size), sizeof(size_t));
-      offset_out.write(reinterpret_cast<const char *>(e.first.data()), key_size);
-      offset_out.write(reinterpret_cast<const char *>(&value_size), sizeof(size_t));
-      out.write(reinterpret_cast<const char *>(e.second.data()), value_size);
+      offset_out->write(reinterpret_cast<const char *>(&key_size), sizeof(size_t));
+      offset_out->write(reinterpret_cast<const char *>(e.first.data()), key_size);
+      offset_out->write(reinterpret_cast<const char *>(&value_size), sizeof(size_t));
+      out->write(reinterpret_cast<const char *>(e.second.data()), value_size);
     }
-    out.flush();
-    offset_out.flush();
-    auto sz = out.tellp();
-    out.close();
-    offset_out.close();
+    out->flush();
+    offset_out->flush();
+    auto sz = out->tellp();
+    out.reset();
+    offset_out.reset();
     return static_cast<std::size_t>(sz);
   }
 
@@ -493,20 +552,20 @@ class binary_serde_impl : public serde {
    */
 
   size_t serialize_impl(const fifo_queue_type &table, const std::string &out_path) {
-    std::ofstream out(out_path, std::ios::binary);
+    auto out = open_output(out_path);
     std::string offset_out_path = out_path;
     offset_out_path.append("_offset");
-    std::ofstream offset_out(offset_out_path, std::ios::binary);
+    auto offset_out = open_output(offset_out_path);
     for (auto e = table.begin(); e != table.end(); e++) {
       std::size_t msg_size = (*e).size();
-      offset_out.write(reinterpret_cast<const char *>(&msg_size), sizeof(size_t));
-      out.write(reinterpret_cast<const char *>((*e).data()), msg_size);
+      offset_out->write(reinterpret_cast<const char *>(&msg_size), sizeof(size_t));
+      out->write(reinterpret_cast<const char *>((*e).data()), msg_size);
     }
-    out.flush();
-    offset_out.flush();
-    offset_out.close();
-    auto sz = out.tellp();
-    out.close();
+    out->flush();
+    offset_out->flush();
+    offset_out.reset();
+    auto sz = out->tellp();
+    out.reset();
     return static_cast<std::size_t>(sz);
   }
 
@@ -518,12 +577,12 @@ class binary_serde_impl : public serde {
    */
 
   size_t serialize_impl(const file_type &table, const std::string &out_path) {
-    std::ofstream out(out_path, std::ios::binary);
+    auto out = open_output(out_path);
     std::size_t msg_size = table.size();
-    out.write(reinterpret_cast<const char *>(table.data()), msg_size);
-    out.flush();
-    auto sz = out.tellp();
-    out.close();
+    out->write(reinterpret_cast<const char *>(table.data()), msg_size);
+    out->flush();
+    auto sz = out->tellp();
+    out.reset();
     return static_cast<std::size_t>(sz);
   }
 
@@ -538,14 +597,14 @@ class binary_serde_impl : public serde {
     std::vector<std::vector<int>> log_info = table.log_info;
     std::size_t seq_no = table.seq_no;
 
-    std::ofstream out(out_path, std::ios::binary);
+    auto out = open_output(out_path);
     std::string offset_out_path = out_path;
     offset_out_path.append("_offset");
-    std::ofstream offset_out(offset_out_path, std::ios::binary);
+    auto offset_out = open_output(offset_out_path);
 
-    out.write(reinterpret_cast<const char *>(&seq_no), sizeof(size_t));
+    out->write(reinterpret_cast<const char *>(&seq_no), sizeof(size_t));
     std::size_t log_info_size = log_info.size();
-    out.write(reinterpret_cast<const char *>(&log_info_size), sizeof(size_t));
+    out->write(reinterpret_cast<const char *>(&log_info_size), sizeof(size_t));
     for (size_t i = 0; i < log_info.size(); ++i) {
 
       auto info_set = log_info[i];
@@ -556,29 +615,29 @@ class binary_serde_impl : public serde {
 
       std::size_t data_size = info_set[1];
 
-      offset_out.write(reinterpret_cast<const char *>(&i), sizeof(size_t));
-      offset_out.write(reinterpret_cast<const char *>(&num_args), sizeof(size_t));
-      offset_out.write(reinterpret_cast<const char *>(&data_size), sizeof(size_t));
+      offset_out->write(reinterpret_cast<const char *>(&i), sizeof(size_t));
+      offset_out->write(reinterpret_cast<const char *>(&num_args), sizeof(size_t));
+      offset_out->write(reinterpret_cast<const char *>(&data_size), sizeof(size_t));
 
       for (size_t j = 2; j < info_set.size(); j++) {
         size_t stream_size = info_set[j];
         std::string stream =
             (*table.block).read(static_cast<std::size_t>(temp_offset), static_cast<std::size_t>(info_set[j])).second;
 
-        offset_out.write(reinterpret_cast<const char *>(&stream_size), sizeof(size_t));
-        out.write(reinterpret_cast<const char *>(stream.data()), stream_size);
+        offset_out->write(reinterpret_cast<const char *>(&stream_size), sizeof(size_t));
+        out->write(reinterpret_cast<const char *>(stream.data()), stream_size);
         temp_offset += info_set[j];
       }
       std::string
           data = (*table.block).read(static_cast<std::size_t>(temp_offset), static_cast<std::size_t>(data_size)).second;
-      out.write(reinterpret_cast<const char *>(data.data()), data_size);
+      out->write(reinterpret_cast<const char *>(data.data()), data_size);
 
     }
-    out.flush();
-    offset_out.flush();
-    auto sz = out.tellp();
-    out.close();
-    offset_out.close();
+    out->flush();
+    offset_out->flush();
+    auto sz = out->tellp();
+    out.reset();
+    offset_out.reset();
     return static_cast<std::size_t>(sz);
   }
 
@@ -591,26 +650,111 @@ class binary_serde_impl : public serde {
 
   template<typename DataType>
   size_t deserialize_impl(DataType &table, const std::string &in_path) {
-    std::ifstream in(in_path, std::ios::binary);
-    std::string offset_in_path = in_path;
-    offset_in_path.append("_offset");
-    std::ifstream offset_in(offset_in_path, std::ios::binary);
-    while (in.peek() != EOF && offset_in.peek() != EOF) {
-      std::size_t key_size;
-      offset_in.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
-      std::string key;
-      key.resize(key_size);
-      offset_in.read(&key[0], key_size);
-      std::size_t value_size;
-      offset_in.read(reinterpret_cast<char *>(&value_size), sizeof(value_size));
-      std::string value;
-      value.resize(value_size);
-      in.read(&value[0], value_size);
-      table.emplace(std::make_pair(make_binary(key), make_binary(value)));
+    if (codec_ != nullptr) {
+      persistent::compressed_ifstream in(in_path);
+      persistent::compressed_ifstream offset_in(in_path + "_offset");
+      if (!in || !offset_in) {
+        return 0;
+      }
+      return load_records(table, in.data(), in.size(), offset_in.data(), offset_in.size());
+    }
+    persistent::mapped_file in(in_path);
+    persistent::mapped_file offset_in(in_path + "_offset");
+    if (!in.is_open() || !offset_in.is_open()) {
+      return 0;
+    }
+    return load_records(table, in.data(), in.size(), offset_in.data(), offset_in.size());
+  }
+
+  /**
+   * @brief Load hash table records from the contents of the data and offset files
+   * @param table Hash table
+   * @param data Data file contents
+   * @param data_size Data file size
+   * @param offsets Offset file contents
+   * @param offsets_size Offset file size
+   * @return Number of value bytes loaded
+   */
+
+  template<typename DataType>
+  size_t load_records(DataType &table, const char *data, std::size_t data_size, const char *offsets,
+                      std::size_t offsets_size) {
+    // One pass over the offset file counts the records, so that the index is sized once, and locates
+    // every value; a truncated trailing record ends the table
+    std::vector<record> records;
+    const char *pos = offsets;
+    const char *end = pos + offsets_size;
+    std::size_t value_offset = 0;
+    while (static_cast<std::size_t>(end - pos) >= sizeof(std::size_t)) {
+      record r{};
+      std::memcpy(&r.key_size, pos, sizeof(std::size_t));
+      pos += sizeof(std::size_t);
+      if (static_cast<std::size_t>(end - pos) < sizeof(std::size_t) || static_cast<std::size_t>(end - pos) - sizeof(std::size_t) < r.key_size) {
+        break;
+      }
+      r.key = pos;
+      pos += r.key_size;
+      std::memcpy(&r.value_size, pos, sizeof(std::size_t));
+      pos += sizeof(std::size_t);
+      if (r.value_size > data_size - value_offset) {
+        break;
+      }
+      r.value = data + value_offset;
+      value_offset += r.value_size;
+      records.push_back(r);
+    }
+    load_parsed(table, records);
+    return value_offset;
+  }
+
+  /**
+   * @brief Copy located hash table records into the table
+   * @param table Hash table
+   * @param records Records, inserted in order
+   */
+
+  template<typename DataType>
+  void load_parsed(DataType &table, const std::vector<record> &records) {
+    table.reserve(table.size() + records.size());
+
+    // Copying records into partition memory runs on several threads, the index is filled in file order
+    auto num_threads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1U),
+                                             (records.size() + RECORDS_PER_THREAD - 1) / RECORDS_PER_THREAD);
+    num_threads = std::max<std::size_t>(num_threads, 1);
+    auto chunk = (records.size() + num_threads - 1) / num_threads;
+    std::vector<std::vector<std::pair<binary, binary>>> entries(num_threads);
+    std::vector<std::exception_ptr> errors(num_threads);
+    auto decode = [&](std::size_t t) {
+      try {
+        auto begin = std::min(t * chunk, records.size());
+        auto stop = std::min(begin + chunk, records.size());
+        entries[t].reserve(stop - begin);
+        for (auto i = begin; i < stop; ++i) {
+          const auto &r = records[i];
+          entries[t].emplace_back(make_binary(r.key, r.key_size), make_binary(r.value, r.value_size));
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    };
+    std::vector<std::thread> workers;
+    for (std::size_t t = 1; t < num_threads; ++t) {
+      workers.emplace_back(decode, t);
+    }
+    decode(0);
+    for (auto &w: workers) {
+      w.join();
+    }
+    for (const auto &e: errors) {
+      if (e != nullptr) {
+        std::rethrow_exception(e);
+      }
+    }
+    for (auto &part: entries) {
+      for (auto &e: part) {
+        table.emplace(std::move(e.first), std::move(e.second));
+      }
     }
-    auto sz = in.tellg();
-    in.close();
-    return static_cast<std::size_t>(sz);
   }
 
   /**
@@ -621,21 +765,21 @@ class binary_serde_impl : public serde {
    */
 
   size_t deserialize_impl(fifo_queue_type &table, const std::string &in_path) {
-    std::ifstream in(in_path, std::ios::binary);
+    auto in = open_input(in_path);
     std::string offset_in_path = in_path;
     offset_in_path.append("_offset");
-    std::ifstream offset_in(offset_in_path, std::ios::binary);
-    while (in.peek() != EOF && offset_in.peek() != EOF) {
+    auto offset_in = open_input(offset_in_path);
+    while (in->peek() != EOF && offset_in->peek() != EOF) {
       std::size_t msg_size;
-      offset_in.read(reinterpret_cast<char *>(&msg_size), sizeof(msg_size));
+      offset_in->read(reinterpret_cast<char *>(&msg_size), sizeof(msg_size));
       std::string msg;
       msg.resize(msg_size);
-      in.read(&msg[0], msg_size);
+      in->read(&msg[0], msg_size);
       table.push_back(msg);
     }
-    auto sz = in.tellg();
-    offset_in.close();
-    in.close();
+    auto sz = in->tellg();
+    offset_in.reset();
+    in.reset();
     return static_cast<std::size_t>(sz);
   }
 
@@ -647,14 +791,14 @@ class binary_serde_impl : public serde {
    */
 
   size_t deserialize_impl(file_type &table, const std::string &in_path) {
-    std::ifstream in(in_path, std::ios::binary);
+    auto in = open_input(in_path);
     std::size_t msg_size = table.size();
     std::string msg;
     msg.resize(msg_size);
-    in.read(&msg[0], msg_size);
+    in->read(&msg[0], msg_size);
     table.write(msg, 0);
-    auto sz = in.tellg();
-    in.close();
+    auto sz = in->tellg();
+    in.reset();
     return static_cast<std::size_t>(sz);
   }
 
@@ -666,46 +810,49 @@ class binary_serde_impl : public serde {
    */
 
   size_t deserialize_impl(shared_log_serde_type &table, const std::string &in_path) {
-    std::ifstream in(in_path, std::ios::binary);
+    auto in = open_input(in_path);
     std::string offset_in_path = in_path;
     offset_in_path.append("_offset");
-    std::ifstream offset_in(offset_in_path, std::ios::binary);
+    auto offset_in = open_input(offset_in_path);
     std::vector<std::vector<int>> log_info;
 
     std::size_t seq_no;
-    in.read(reinterpret_cast<char *>(&seq_no), sizeof(seq_no));
+    in->read(reinterpret_cast<char *>(&seq_no), sizeof(seq_no));
     table.seq_no = seq_no;
 
     std::size_t log_size;
-    in.read(reinterpret_cast<char *>(&log_size), sizeof(log_size));
+    in->read(reinterpret_cast<char *>(&log_size), sizeof(log_size));
 
     std::size_t temp_offset = 0;
 
-    while (in.peek() != EOF && offset_in.peek() != EOF) {
+    while (in->peek() != EOF && offset_in->peek() != EOF) {
       std::size_t log_position;
-      offset_in.read(reinterpret_cast<char *>(&log_position), sizeof(log_position));
+      offset_in->read(reinterpret_cast<char *>(&log_position), sizeof(log_position));
       while (log_position > log_info.size()) {
         std::vector<int> info_set = {-1, 0};
         log_info.push_back(info_set);
       }
       std::size_t num_args;
-      offset_in.read(reinterpret_cast<char *>(&num_args), sizeof(num_args));
+      offset_in->read(reinterpret_cast<char *>(&num_args), sizeof(num_args));
       std::size_t data_size;
-      offset_in.read(reinterpret_cast<char *>(&data_size), sizeof(data_size));
+      offset_in->read(reinterpret_cast<char *>(&data_size), sizeof(data_size));
+      std::vector<int> info_set = {static_cast<int>(temp_offset), static_cast<int>(data_size)};
       for (size_t i = 0; i < num_args - 1; ++i) {
         std::size_t stream_size;
-        offset_in.read(reinterpret_cast<char *>(&stream_size), sizeof(stream_size));
+        offset_in->read(reinterpret_cast<char *>(&stream_size), sizeof(stream_size));
+        info_set.push_back(static_cast<int>(stream_size));
         std::string stream;
         stream.resize(stream_size);
-        in.read(&stream[0], stream_size);
+        in->read(&stream[0], stream_size);
         (*table.block).write(stream, temp_offset);
         temp_offset += stream.size();
       }
       std::string data;
       data.resize(data_size);
-      in.read(&data[0], data_size);
+      in->read(&data[0], data_size);
       (*table.block).write(data, temp_offset);
       temp_offset += data.size();
+      log_info.push_back(info_set);
     }
 
     while (log_info.size() < log_size) {
@@ -714,15 +861,239 @@ class binary_serde_impl : public serde {
     }
     table.log_info = log_info;
 
-    auto sz = in.tellg();
-    in.close();
-    offset_in.close();
+    auto sz = in->tellg();
+    in.reset();
+    offset_in.reset();
     return static_cast<std::size_t>(sz);
   }
+
+ private:
+  /* Codec, null for raw files */
+  std::shared_ptr<persistent::codec> codec_;
 };
 
 using binary_serde = derived<binary_serde_impl>;
 
+/* Indexed serializer/deserializer class
+ * Writes each data structure as one indexed file with checksums, see persistent::indexed_file
+ */
+class indexed_serde_impl : public binary_serde_impl {
+ public:
+  /**
+   * @brief Constructor
+   * @param allocator Allocator for deserialized data
+   */
+  explicit indexed_serde_impl(const block_memory_allocator<uint8_t> &allocator) : binary_serde_impl(allocator) {}
+
+  ~indexed_serde_impl() override = default;
+
+ protected:
+  /**
+   * @brief Indexed serialization, records are indexed in key order
+   * @param table Hash table
+   * @param out_path Output file path
+   * @return Data section size
+   */
+
+  template<typename Datatype>
+  size_t serialize_impl(const Datatype &table, const std::string &out_path) {
+    persistent::indexed_file_writer out(out_path, persistent::indexed_layout::hash_table, true);
+    for (const auto &e: table) {
+      out.add(reinterpret_cast<const char *>(e.first.data()), e.first.size(),
+              reinterpret_cast<const char *>(e.second.data()), e.second.size());
+    }
+    auto sz = out.data_size();
+    out.close();
+    return static_cast<std::size_t>(sz);
+  }
+
+  /**
+   * @brief Indexed serialization, one record without key per message
+   * @param table Fifo queue
+   * @param out_path Output file path
+   * @return Data section size
+   */
+
+  size_t serialize_impl(const fifo_queue_type &table, const std::string &out_path) {
+    persistent::indexed_file_writer out(out_path, persistent::indexed_layout::fifo_queue, false);
+    for (auto e = table.begin(); e != table.end(); e++) {
+      auto msg = *e;
+      out.add(nullptr, 0, msg.data(), msg.size());
+    }
+    auto sz = out.data_size();
+    out.close();
+    return static_cast<std::size_t>(sz);
+  }
+
+  /**
+   * @brief Indexed serialization, one record holding the file contents
+   * @param table File
+   * @param out_path Output file path
+   * @return Data section size
+   */
+
+  size_t serialize_impl(const file_type &table, const std::string &out_path) {
+    persistent::indexed_file_writer out(out_path, persistent::indexed_layout::file, false);
+    out.add(nullptr, 0, reinterpret_cast<const char *>(table.data()), table.size());
+    auto sz = out.data_size();
+    out.close();
+    return static_cast<std::size_t>(sz);
+  }
+
+  /**
+   * @brief Indexed serialization, one record per log entry; the key holds the log position, the data size
+   * and the stream sizes, the value holds the streams followed by the data
+   * @param table Shared_log
+   * @param out_path Output file path
+   * @return Data section size
+   */
+
+  size_t serialize_impl(const shared_log_serde_type &table, const std::string &out_path) {
+    persistent::indexed_file_writer out(out_path, persistent::indexed_layout::shared_log, false);
+    out.set_aux(0, table.seq_no);
+    out.set_aux(1, table.log_info.size());
+    std::vector<std::uint64_t> meta;
+    for (std::size_t i = 0; i < table.log_info.size(); ++i) {
+      const auto &info_set = table.log_info[i];
+      if (info_set[0] == -1) continue;
+      meta.assign({i, static_cast<std::uint64_t>(info_set[1])});
+      std::size_t entry_size = static_cast<std::size_t>(info_set[1]);
+      for (std::size_t j = 2; j < info_set.size(); j++) {
+        meta.push_back(static_cast<std::uint64_t>(info_set[j]));
+        entry_size += static_cast<std::size_t>(info_set[j]);
+      }
+      // Streams and data are stored contiguously in the block
+      auto value = (*table.block).read(static_cast<std::size_t>(info_set[0]), entry_size).second;
+      out.add(reinterpret_cast<const char *>(meta.data()), meta.size() * sizeof(std::uint64_t),
+              value.data(), value.size());
+    }
+    auto sz = out.data_size();
+    out.close();
+    return static_cast<std::size_t>(sz);
+  }
+
+  /**
+   * @brief Indexed deserialization, verifies the checksums and copies records on several threads
+   * @param table Hash table
+   * @param in_path Input file path
+   * @return Data section size
+   */
+
+  template<typename DataType>
+  size_t deserialize_impl(DataType &table, const std::string &in_path) {
+    persistent::indexed_file in(in_path, true);
+    if (!in.is_open()) {
+      return 0;
+    }
+    check_layout(in, persistent::indexed_layout::hash_table);
+    in.verify();
+    std::vector<record> records(in.num_records());
+    for (std::size_t i = 0; i < records.size(); ++i) {
+      auto r = in.get(i);
+      records[i] = record{r.key, r.key_size, r.value, r.value_size};
+    }
+    load_parsed(table, records);
+    return static_cast<std::size_t>(in.data_size());
+  }
+
+  /**
+   * @brief Indexed deserialization
+   * @param table Fifo queue
+   * @param in_path Input file path
+   * @return Data section size
+   */
+
+  size_t deserialize_impl(fifo_queue_type &table, const std::string &in_path) {
+    persistent::indexed_file in(in_path, true);
+    if (!in.is_open()) {
+      return 0;
+    }
+    check_layout(in, persistent::indexed_layout::fifo_queue);
+    for (std::size_t i = 0; i < in.num_records(); ++i) {
+      auto r = in.get(i);
+      table.push_back(std::string(r.value, r.value_size));
+    }
+    return static_cast<std::size_t>(in.data_size());
+  }
+
+  /**
+   * @brief Indexed deserialization
+   * @param table File
+   * @param in_path Input file path
+   * @return Data section size
+   */
+
+  size_t deserialize_impl(file_type &table, const std::string &in_path) {
+    persistent::indexed_file in(in_path, true);
+    if (!in.is_open()) {
+      return 0;
+    }
+    check_layout(in, persistent::indexed_layout::file);
+    if (in.num_records() > 0) {
+      auto r = in.get(0);
+      table.write(std::string(r.value, std::min(r.value_size, table.size())), 0);
+    }
+    return static_cast<std::size_t>(in.data_size());
+  }
+
+  /**
+   * @brief Indexed deserialization
+   * @param table Shared_log
+   * @param in_path Input file path
+   * @return Data section size
+   */
+
+  size_t deserialize_impl(shared_log_serde_type &table, const std::string &in_path) {
+    persistent::indexed_file in(in_path, true);
+    if (!in.is_open()) {
+      return 0;
+    }
+    check_layout(in, persistent::indexed_layout::shared_log);
+    table.seq_no = static_cast<std::size_t>(in.aux(0));
+    std::vector<std::vector<int>> log_info;
+    std::size_t temp_offset = 0;
+    std::vector<std::uint64_t> meta;
+    for (std::size_t i = 0; i < in.num_records(); ++i) {
+      auto r = in.get(i);
+      meta.resize(r.key_size / sizeof(std::uint64_t));
+      std::memcpy(meta.data(), r.key, meta.size() * sizeof(std::uint64_t));
+      if (meta.size() < 2) {
+        throw std::runtime_error("Corrupt log entry " + std::to_string(i) + " in " + in_path);
+      }
+      while (meta[0] > log_info.size()) {
+        log_info.push_back({-1, 0});
+      }
+      std::vector<int> info_set = {static_cast<int>(temp_offset), static_cast<int>(meta[1])};
+      for (std::size_t j = 2; j < meta.size(); ++j) {
+        info_set.push_back(static_cast<int>(meta[j]));
+      }
+      (*table.block).write(std::string(r.value, r.value_size), temp_offset);
+      temp_offset += r.value_size;
+      log_info.push_back(info_set);
+    }
+    while (log_info.size() < in.aux(1)) {
+      log_info.push_back({-1, 0});
+    }
+    table.log_info = log_info;
+    return static_cast<std::size_t>(in.data_size());
+  }
+
+ private:
+  /**
+   * @brief Check that a file holds the expected data structure
+   * @param in Indexed file
+   * @param layout Expected layout
+   */
+  static void check_layout(const persistent::indexed_file &in, persistent::indexed_layout layout) {
+    if (in.layout() != layout) {
+      throw std::runtime_error("Indexed file holds layout " + std::to_string(static_cast<std::uint32_t>(in.layout()))
+                                   + ", expected " + std::to_string(static_cast<std::uint32_t>(layout)));
+    }
+  }
+};
+
+using indexed_serde = derived<indexed_serde_impl>;
+
 }
 }
 
@@ -0,0 +1,630 @@
+#include "block_data_server.h"
+#include "block_request_handler.h"
+#include "jiffy/utils/logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+#include <thrift/transport/TTransportException.h>
+#include <thrift/transport/TVirtualTransport.h>
+
+namespace jiffy {
+namespace storage {
+
+using namespace ::apache::thrift;
+using namespace ::apache::thrift::protocol;
+using namespace ::apache::thrift::transport;
+using namespace ::apache::thrift::server;
+using namespace utils;
+
+/* Binary protocol reading frames in place */
+typedef TBinaryProtocolT<TMemoryBuffer> frame_protocol;
+
+/* Event loop running on the current thread, if any */
+static thread_local block_data_loop *current_loop = nullptr;
+
+/**
+ * @brief Output side of a connection, shared by the responses written from the event loop and the ones
+ * written from other threads, e.g. by the tail of a chain or by notifications.
+ *
+ * Frames flushed on the connection's event loop are buffered until the loop has processed all its
+ * ready connections, and then sent with a single system call; frames flushed from other threads are
+ * sent right away. Output the socket does not accept is sent by the event loop once the socket is
+ * writable again.
+ */
+class connection_output : public TVirtualTransport<connection_output>,
+                          public std::enable_shared_from_this<connection_output> {
+ public:
+  /**
+   * @brief Constructor
+   * @param fd Socket file descriptor
+   * @param epoll_fd Event loop epoll file descriptor
+   * @param loop Event loop
+   */
+  connection_output(int fd, int epoll_fd, block_data_loop *loop)
+      : fd_(fd), epoll_fd_(epoll_fd), loop_(loop), sent_(0), closed_(false), deferred_(false), armed_(false) {}
+
+  bool isOpen() override {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return !closed_;
+  }
+
+  /**
+   * @brief Append data to the output buffer
+   * @param buf Data
+   * @param len Data length
+   */
+  void write(const uint8_t *buf, uint32_t len) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (closed_) {
+      throw TTransportException(TTransportException::NOT_OPEN, "Connection closed");
+    }
+    buf_.insert(buf_.end(), buf, buf + len);
+  }
+
+  /**
+   * @brief Send the output buffer, or defer sending it to the end of the event loop iteration when
+   * called on the connection's event loop
+   */
+  void flush() override;
+
+  /**
+   * @brief Send as much of the output buffer as the socket accepts, waiting for the socket to become
+   * writable for the rest
+   */
+  void send_pending() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    deferred_ = false;
+    if (!closed_) {
+      send_locked();
+    }
+  }
+
+  /**
+   * @brief Close the socket, dropping any output not sent yet
+   */
+  void close() override {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!closed_) {
+      closed_ = true;
+      ::close(fd_);
+      buf_.clear();
+      sent_ = 0;
+    }
+  }
+
+ private:
+  /**
+   * @brief Send the output buffer, with the lock held
+   */
+  void send_locked() {
+    while (sent_ < buf_.size()) {
+      auto n = ::send(fd_, buf_.data() + sent_, buf_.size() - sent_, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (n > 0) {
+        sent_ += static_cast<std::size_t>(n);
+      } else if (n < 0 && errno == EINTR) {
+        continue;
+      } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        arm(true);
+        return;
+      } else {
+        // The event loop sees the error on the socket and closes the connection
+        LOG(log_level::warn) << "Could not send response: " << std::strerror(errno);
+        buf_.clear();
+        sent_ = 0;
+        return;
+      }
+    }
+    buf_.clear();
+    sent_ = 0;
+    arm(false);
+  }
+
+  /**
+   * @brief Set whether the event loop should wait for the socket to become writable
+   * @param writable True to wait for the socket to become writable
+   */
+  void arm(bool writable) {
+    if (armed_ == writable) {
+      return;
+    }
+    epoll_event ev{};
+    ev.events = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.fd = fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd_, &ev);
+    armed_ = writable;
+  }
+
+  /* Socket file descriptor */
+  int fd_;
+  /* Event loop epoll file descriptor */
+  int epoll_fd_;
+  /* Event loop */
+  block_data_loop *loop_;
+  /* Mutex */
+  std::mutex mtx_;
+  /* Output buffer */
+  std::vector<uint8_t> buf_;
+  /* Number of bytes of the output buffer already sent */
+  std::size_t sent_;
+  /* Bool for connection closed */
+  bool closed_;
+  /* Bool for output deferred to the end of the event loop iteration */
+  bool deferred_;
+  /* Bool for waiting for the socket to become writable */
+  bool armed_;
+};
+
+/**
+ * @brief Connection state owned by an event loop
+ */
+struct block_data_connection {
+  /* Output side of the connection */
+  std::shared_ptr<connection_output> output;
+  /* Input buffer, reused across reads */
+  std::vector<uint8_t> in;
+  /* Number of bytes in the input buffer */
+  std::size_t in_len{0};
+  /* Buffer observing the frame being processed */
+  std::shared_ptr<TMemoryBuffer> frame;
+  /* Protocol reading the frame being processed */
+  std::shared_ptr<frame_protocol> iprot;
+  /* Protocol writing replies of the generated processor */
+  std::shared_ptr<TProtocol> oprot;
+  /* Request handler, released along with the processor */
+  block_request_handler *handler{nullptr};
+  /* Generated processor, for requests other than command and chain requests */
+  std::shared_ptr<block_request_serviceProcessor> processor;
+  /* Message name, reused across requests */
+  std::string name;
+  /* Sequence identifier of the request being processed */
+  sequence_id seq;
+  /* Block identifier of the request being processed */
+  int32_t block_id{0};
+  /* Arguments of the request being processed, whose strings keep their capacity across requests */
+  std::vector<std::string> args;
+};
+
+/**
+ * @brief Event loop serving the connections accepted on its own listening socket
+ */
+class block_data_loop {
+ public:
+  /**
+   * @brief Constructor
+   * @param handler_factory Handler factory
+   * @param port Port
+   */
+  block_data_loop(std::shared_ptr<block_request_handler_factory> handler_factory, int port)
+      : handler_factory_(std::move(handler_factory)), listen_fd_(-1), epoll_fd_(-1), event_fd_(-1) {
+    listen_fd_ = listen(port);
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || event_fd_ < 0) {
+      auto err = errno;
+      close_fds();
+      throw TTransportException(TTransportException::NOT_OPEN, "Could not create event loop", err);
+    }
+    add(listen_fd_);
+    add(event_fd_);
+  }
+
+  /**
+   * @brief Destructor
+   */
+  ~block_data_loop() {
+    close_fds();
+  }
+
+  /**
+   * @brief Run the event loop until stopped
+   */
+  void run() {
+    current_loop = this;
+    std::vector<epoll_event> events(256);
+    bool stopped = false;
+    while (!stopped) {
+      int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        LOG(log_level::error) << "Event loop failed: " << std::strerror(errno);
+        break;
+      }
+      for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == event_fd_) {
+          stopped = true;
+        } else if (fd == listen_fd_) {
+          accept_connections();
+        } else {
+          handle_event(fd, events[i].events);
+        }
+      }
+      // Send all responses produced in this iteration, one system call per connection
+      for (auto &output : deferred_) {
+        output->send_pending();
+      }
+      deferred_.clear();
+    }
+    while (!connections_.empty()) {
+      close_connection(connections_.begin()->first);
+    }
+    current_loop = nullptr;
+  }
+
+  /**
+   * @brief Stop the event loop, from any thread
+   */
+  void stop() {
+    uint64_t one = 1;
+    if (::write(event_fd_, &one, sizeof(one)) < 0) {
+      LOG(log_level::warn) << "Could not stop event loop: " << std::strerror(errno);
+    }
+  }
+
+  /**
+   * @brief Defer sending a connection's output to the end of the current iteration
+   * @param output Output side of the connection
+   */
+  void defer(std::shared_ptr<connection_output> output) {
+    deferred_.push_back(std::move(output));
+  }
+
+ private:
+  /**
+   * @brief Open a listening socket sharing the port with the other event loops
+   * @param port Port
+   * @return Socket file descriptor
+   */
+  static int listen(int port) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_ADDRCONFIG;
+    addrinfo *res = nullptr;
+    auto port_str = std::to_string(port);
+    int err = getaddrinfo(nullptr, port_str.c_str(), &hints, &res);
+    if (err != 0) {
+      throw TTransportException(TTransportException::NOT_OPEN,
+                                std::string("Could not resolve listening address: ") + gai_strerror(err));
+    }
+    // Prefer IPv6, which accepts IPv4 connections as well
+    addrinfo *addr = res;
+    for (auto it = res; it != nullptr; it = it->ai_next) {
+      if (it->ai_family == AF_INET6) {
+        addr = it;
+        break;
+      }
+    }
+    int fd = socket(addr->ai_family, addr->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, addr->ai_protocol);
+    if (fd < 0) {
+      err = errno;
+      freeaddrinfo(res);
+      throw TTransportException(TTransportException::NOT_OPEN, "Could not create listening socket", err);
+    }
+    int one = 1, zero = 0;
+    if (addr->ai_family == AF_INET6) {
+      setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0
+        || bind(fd, addr->ai_addr, addr->ai_addrlen) != 0
+        || ::listen(fd, 1024) != 0) {
+      err = errno;
+      ::close(fd);
+      freeaddrinfo(res);
+      throw TTransportException(TTransportException::NOT_OPEN,
+                                "Could not listen on port " + port_str, err);
+    }
+    freeaddrinfo(res);
+    return fd;
+  }
+
+  /**
+   * @brief Watch a file descriptor for input
+   * @param fd File descriptor
+   */
+  void add(int fd) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      throw TTransportException(TTransportException::UNKNOWN, "Could not watch file descriptor", errno);
+    }
+  }
+
+  /**
+   * @brief Close the event loop's file descriptors
+   */
+  void close_fds() {
+    for (auto fd : {listen_fd_, epoll_fd_, event_fd_}) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+    listen_fd_ = epoll_fd_ = event_fd_ = -1;
+  }
+
+  /**
+   * @brief Accept all pending connections
+   */
+  void accept_connections() {
+    while (true) {
+      int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          LOG(log_level::warn) << "Could not accept connection: " << std::strerror(errno);
+        }
+        return;
+      }
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      try {
+        add(fd);
+      } catch (TTransportException &e) {
+        LOG(log_level::warn) << e.what();
+        ::close(fd);
+        continue;
+      }
+      LOG(log_level::trace) << "Incoming connection on socket " << fd;
+
+      auto conn = std::unique_ptr<block_data_connection>(new block_data_connection);
+      conn->output = std::make_shared<connection_output>(fd, epoll_fd_, this);
+      conn->frame = std::make_shared<TMemoryBuffer>();
+      conn->iprot = std::make_shared<frame_protocol>(conn->frame);
+      conn->oprot = std::make_shared<TBinaryProtocol>(std::make_shared<TFramedTransport>(conn->output));
+      auto prot = std::make_shared<TBinaryProtocol>(std::make_shared<TFramedTransport>(conn->output));
+      conn->handler = handler_factory_->create_handler(prot);
+      auto factory = handler_factory_;
+      std::shared_ptr<block_request_serviceIf> iface(conn->handler, [factory](block_request_serviceIf *handler) {
+        factory->releaseHandler(handler);
+      });
+      conn->processor = std::make_shared<block_request_serviceProcessor>(iface);
+      connections_[fd] = std::move(conn);
+    }
+  }
+
+  /**
+   * @brief Handle readiness of a connection
+   * @param fd Socket file descriptor
+   * @param events Ready events
+   */
+  void handle_event(int fd, uint32_t events) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+      return;
+    }
+    auto &conn = *it->second;
+    if (events & EPOLLOUT) {
+      conn.output->send_pending();
+    }
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+      bool open;
+      try {
+        open = read_frames(conn, fd);
+      } catch (std::exception &e) {
+        LOG(log_level::warn) << "Closing connection: " << e.what();
+        open = false;
+      }
+      if (!open) {
+        close_connection(fd);
+      }
+    }
+  }
+
+  /**
+   * @brief Read from a connection and process the complete frames read
+   * @param conn Connection
+   * @param fd Socket file descriptor
+   * @return True if the connection is still open
+   */
+  bool read_frames(block_data_connection &conn, int fd) {
+    static const std::size_t READ_SIZE = 65536;
+    if (conn.in.size() - conn.in_len < READ_SIZE) {
+      conn.in.resize(std::max(conn.in.size() * 2, conn.in_len + READ_SIZE));
+    }
+    auto n = ::recv(fd, conn.in.data() + conn.in_len, conn.in.size() - conn.in_len, 0);
+    if (n == 0) {
+      return false;
+    }
+    if (n < 0) {
+      return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    conn.in_len += static_cast<std::size_t>(n);
+
+    std::size_t pos = 0;
+    while (conn.in_len - pos >= sizeof(uint32_t)) {
+      uint32_t frame_size;
+      std::memcpy(&frame_size, conn.in.data() + pos, sizeof(frame_size));
+      frame_size = ntohl(frame_size);
+      if (frame_size > block_data_server::MAX_FRAME_SIZE) {
+        LOG(log_level::warn) << "Frame of " << frame_size << " bytes exceeds maximum frame size";
+        return false;
+      }
+      std::size_t frame_end = pos + sizeof(uint32_t) + frame_size;
+      if (frame_end > conn.in_len) {
+        // Make room for the rest of the frame, so that it is read with as few calls as possible
+        if (conn.in.size() < frame_end - pos) {
+          conn.in.resize(frame_end - pos);
+        }
+        break;
+      }
+      process(conn, conn.in.data() + pos + sizeof(uint32_t), frame_size);
+      pos = frame_end;
+    }
+    if (pos > 0) {
+      std::memmove(conn.in.data(), conn.in.data() + pos, conn.in_len - pos);
+      conn.in_len -= pos;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Process a frame; command and chain requests are decoded into the connection's reused
+   * argument list and passed to the handler directly, other requests go through the generated processor
+   * @param conn Connection
+   * @param data Frame data
+   * @param len Frame length
+   */
+  void process(block_data_connection &conn, uint8_t *data, uint32_t len) {
+    auto &iprot = *conn.iprot;
+    conn.frame->resetBuffer(data, len);
+    TMessageType type;
+    int32_t seqid;
+    iprot.readMessageBegin(conn.name, type, seqid);
+    bool command = conn.name == "command_request";
+    if (type == T_ONEWAY && (command || conn.name == "chain_request")) {
+      read_request(conn);
+      iprot.readMessageEnd();
+      try {
+        if (command) {
+          conn.handler->command_request(conn.seq, conn.block_id, conn.args);
+        } else {
+          conn.handler->chain_request(conn.seq, conn.block_id, conn.args);
+        }
+      } catch (std::exception &e) {
+        // As for the generated processor, exceptions of one way calls are not sent back
+        LOG(log_level::error) << "Error in " << conn.name << ": " << e.what();
+      }
+      return;
+    }
+    conn.frame->resetBuffer(data, len);
+    conn.processor->process(conn.iprot, conn.oprot, nullptr);
+  }
+
+  /**
+   * @brief Read the arguments of a command or chain request
+   * @param conn Connection
+   */
+  static void read_request(block_data_connection &conn) {
+    auto &iprot = *conn.iprot;
+    std::string fname;
+    TType ftype;
+    int16_t fid;
+    iprot.readStructBegin(fname);
+    while (true) {
+      iprot.readFieldBegin(fname, ftype, fid);
+      if (ftype == T_STOP) {
+        break;
+      }
+      if (fid == 1 && ftype == T_STRUCT) {
+        conn.seq.read(&iprot);
+      } else if (fid == 2 && ftype == T_I32) {
+        iprot.readI32(conn.block_id);
+      } else if (fid == 3 && ftype == T_LIST) {
+        TType etype;
+        uint32_t size;
+        iprot.readListBegin(etype, size);
+        // Unlike the generated reader, resize without clearing so that strings keep their capacity
+        conn.args.resize(size);
+        for (auto &arg : conn.args) {
+          iprot.readBinary(arg);
+        }
+        iprot.readListEnd();
+      } else {
+        iprot.skip(ftype);
+      }
+      iprot.readFieldEnd();
+    }
+    iprot.readStructEnd();
+  }
+
+  /**
+   * @brief Close a connection and release its handler
+   * @param fd Socket file descriptor
+   */
+  void close_connection(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+      return;
+    }
+    LOG(log_level::trace) << "Closing connection on socket " << fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    it->second->output->close();
+    connections_.erase(it);
+  }
+
+  /* Handler factory */
+  std::shared_ptr<block_request_handler_factory> handler_factory_;
+  /* Listening socket file descriptor */
+  int listen_fd_;
+  /* Epoll file descriptor */
+  int epoll_fd_;
+  /* Event file descriptor, signalled to stop the loop */
+  int event_fd_;
+  /* Connections by socket file descriptor */
+  std::unordered_map<int, std::unique_ptr<block_data_connection>> connections_;
+  /* Connections whose output is sent at the end of the current iteration */
+  std::vector<std::shared_ptr<connection_output>> deferred_;
+};
+
+void connection_output::flush() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (closed_) {
+    throw TTransportException(TTransportException::NOT_OPEN, "Connection closed");
+  }
+  if (current_loop == loop_) {
+    if (!deferred_) {
+      deferred_ = true;
+      loop_->defer(shared_from_this());
+    }
+    return;
+  }
+  if (!armed_) {
+    send_locked();
+  }
+}
+
+block_data_server::block_data_server(std::vector<std::shared_ptr<block>> &blocks, int port, std::size_t num_threads)
+    : TServer(std::shared_ptr<TProcessorFactory>()),
+      handler_factory_(std::make_shared<block_request_handler_factory>(blocks)),
+      port_(port) {
+  for (std::size_t i = 0; i < std::max<std::size_t>(num_threads, 1); ++i) {
+    loops_.emplace_back(new block_data_loop(handler_factory_, port_));
+  }
+}
+
+block_data_server::~block_data_server() = default;
+
+void block_data_server::serve() {
+  LOG(log_level::info) << "Serving block requests on port " << port_ << " with " << loops_.size() << " event loops";
+  if (eventHandler_) {
+    eventHandler_->preServe();
+  }
+  for (std::size_t i = 1; i < loops_.size(); ++i) {
+    threads_.emplace_back([this, i] { loops_[i]->run(); });
+  }
+  loops_[0]->run();
+  for (auto &t : threads_) {
+    if (t.joinable()) {
+      t.join();
+    }
+  }
+  threads_.clear();
+}
+
+void block_data_server::stop() {
+  for (auto &loop : loops_) {
+    loop->stop();
+  }
+}
+
+}
+}
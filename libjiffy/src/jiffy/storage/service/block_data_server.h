@@ -0,0 +1,69 @@
+#ifndef JIFFY_BLOCK_DATA_SERVER_H
+#define JIFFY_BLOCK_DATA_SERVER_H
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include <thrift/server/TServer.h>
+#include "block_request_handler_factory.h"
+
+namespace jiffy {
+namespace storage {
+
+class block_data_loop;
+
+/**
+ * @brief Data plane server for block requests.
+ *
+ * Speaks the framed binary thrift protocol of the block request service, so clients and chain
+ * replicas are unchanged, but replaces the generic thrift server runtime with epoll event loops built
+ * for the request path: each loop owns a listening socket bound with SO_REUSEPORT, so the kernel
+ * spreads connections over the loops without a shared acceptor; frames are parsed in place from a
+ * per-connection input buffer that is reused across reads; command and chain requests are decoded
+ * into per-connection argument lists whose strings keep their capacity across requests; and
+ * responses produced while a loop processes its ready connections are sent with one system call per
+ * connection at the end of the iteration. Other calls go through the thrift generated processor.
+ */
+class block_data_server : public apache::thrift::server::TServer {
+ public:
+  /* Maximum frame size, as for the thrift non-blocking server */
+  static const std::size_t MAX_FRAME_SIZE = 256 * 1024 * 1024;
+
+  /**
+   * @brief Constructor
+   * @param blocks Data blocks
+   * @param port Port
+   * @param num_threads Number of event loops, each running on its own thread
+   */
+  block_data_server(std::vector<std::shared_ptr<block>> &blocks, int port, std::size_t num_threads);
+
+  /**
+   * @brief Destructor
+   */
+  ~block_data_server() override;
+
+  /**
+   * @brief Serve connections until stopped, running the first event loop on the calling thread
+   */
+  void serve() override;
+
+  /**
+   * @brief Stop all event loops
+   */
+  void stop() override;
+
+ private:
+  /* Handler factory, shared by all event loops */
+  std::shared_ptr<block_request_handler_factory> handler_factory_;
+  /* Port */
+  int port_;
+  /* Event loops */
+  std::vector<std::unique_ptr<block_data_loop>> loops_;
+  /* Threads of the event loops other than the first */
+  std::vector<std::thread> threads_;
+};
+
+}
+}
+
+#endif //JIFFY_BLOCK_DATA_SERVER_H
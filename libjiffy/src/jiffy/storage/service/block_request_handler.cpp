@@ -51,8 +51,16 @@ void block_request_handler::chain_request(const sequence_id &seq,
 void block_request_handler::run_command(std::vector<std::string> &_return,
                                         const int32_t block_id,
                                         const std::vector<std::string> &args) {
-  blocks_[static_cast<std::size_t>(block_id)]->impl()->run_command(_return, args);
-  blocks_[static_cast<std::size_t>(block_id)]->impl()->notify(args);
+  auto impl = blocks_[static_cast<std::size_t>(block_id)]->impl();
+  {
+    partition::command_guard guard(*impl);
+    impl->run_command(_return, args);
+    auto lsn = impl->take_log_lsn();
+    if (lsn != 0) {
+      impl->wait_logged(lsn);
+    }
+  }
+  impl->notify(args);
 }
 
 void block_request_handler::subscribe(int32_t block_id,
@@ -26,7 +26,11 @@ block_request_serviceIf *block_request_handler_factory::getHandler(const ::apach
   LOG(log_level::trace) << "Incoming connection from " << sock->getSocketInfo();
   auto transport = std::make_shared<TFramedTransport>(conn_info.transport);
   std::shared_ptr<TProtocol> protocol(new TBinaryProtocol(transport));
-  return new block_request_handler(protocol, client_id_gen_, blocks_);
+  return create_handler(protocol);
+}
+
+block_request_handler *block_request_handler_factory::create_handler(std::shared_ptr<TProtocol> protocol) {
+  return new block_request_handler(std::move(protocol), client_id_gen_, blocks_);
 }
 
 void block_request_handler_factory::releaseHandler(block_request_serviceIf *handler) {
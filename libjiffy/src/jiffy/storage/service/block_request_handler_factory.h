@@ -6,6 +6,9 @@
 
 namespace jiffy {
 namespace storage {
+
+class block_request_handler;
+
 /* Block request handler factory */
 class block_request_handler_factory : public block_request_serviceIfFactory {
  public:
@@ -24,6 +27,14 @@ class block_request_handler_factory : public block_request_serviceIfFactory {
 
   block_request_serviceIf *getHandler(const ::apache::thrift::TConnectionInfo &connInfo) override;
 
+  /**
+   * @brief Create block request handler responding on a protocol
+   * @param protocol Protocol the handler writes responses to
+   * @return Block request handler, to be released with releaseHandler
+   */
+
+  block_request_handler *create_handler(std::shared_ptr<::apache::thrift::protocol::TProtocol> protocol);
+
   /**
    * @brief Release handler
    * Remove the registered client from the block response client list
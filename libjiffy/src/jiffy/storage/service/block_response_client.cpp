@@ -9,11 +9,40 @@ namespace jiffy {
 namespace storage {
 
 block_response_client::block_response_client(std::shared_ptr<TProtocol> protocol)
-    : client_(std::make_shared<thrift_client>(protocol)) {}
+    : client_(std::make_shared<thrift_client>(protocol)),
+      binary_protocol_(dynamic_cast<TBinaryProtocol *>(protocol.get()) != nullptr) {}
 
 void block_response_client::response(const sequence_id &seq, const std::vector<std::string> &result) {
   client_->response(seq, result);
 }
 
+void block_response_client::response(const sequence_id &seq, const response_view &result) {
+  auto oprot = client_->getOutputProtocol();
+  oprot->writeMessageBegin("response", T_ONEWAY, 0);
+  oprot->writeStructBegin("block_response_service_response_pargs");
+  oprot->writeFieldBegin("seq", T_STRUCT, 1);
+  seq.write(oprot.get());
+  oprot->writeFieldEnd();
+  oprot->writeFieldBegin("result", T_LIST, 2);
+  oprot->writeListBegin(T_STRING, static_cast<uint32_t>(result.size()));
+  for (const auto &element: result) {
+    if (binary_protocol_) {
+      // Binary protocol strings are a length prefix followed by the raw bytes
+      oprot->writeI32(static_cast<int32_t>(element.size()));
+      oprot->getTransport()->write(reinterpret_cast<const uint8_t *>(element.data()),
+                                   static_cast<uint32_t>(element.size()));
+    } else {
+      oprot->writeBinary(element.str());
+    }
+  }
+  oprot->writeListEnd();
+  oprot->writeFieldEnd();
+  oprot->writeFieldStop();
+  oprot->writeStructEnd();
+  oprot->writeMessageEnd();
+  oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+}
+
 }
 }
@@ -3,6 +3,7 @@
 
 #include <thrift/transport/TSocket.h>
 #include "block_response_service.h"
+#include "jiffy/storage/response_view.h"
 
 namespace jiffy {
 namespace storage {
@@ -26,9 +27,21 @@ class block_response_client {
 
   void response(const sequence_id &seq, const std::vector<std::string> &result);
 
+  /**
+   * @brief Response without intermediate copies
+   * Serializes the same message as the thrift generated client, but writes each result element
+   * straight from its (possibly borrowed) buffer into the transport.
+   * @param seq Sequence identifier
+   * @param result Operation result
+   */
+
+  void response(const sequence_id &seq, const response_view &result);
+
  private:
   /* Block response service client */
   std::shared_ptr<thrift_client> client_{};
+  /* True if the output protocol is the thrift binary protocol */
+  bool binary_protocol_;
 };
 
 }
@@ -27,6 +27,16 @@ void block_response_client_map::respond_client(const sequence_id &seq, const std
     LOG(log_level::warn) << "Cannot respond to client since client id " << seq.client_id << " is not registered...";
 }
 
+void block_response_client_map::respond_client(const sequence_id &seq, const response_view &result) {
+  if (seq.client_id == -1)
+    return;
+  bool found = clients_.update_fn(seq.client_id, [&](std::shared_ptr<block_response_client> &client) {
+    client->response(seq, result);
+  });
+  if (!found)
+    LOG(log_level::warn) << "Cannot respond to client since client id " << seq.client_id << " is not registered...";
+}
+
 void block_response_client_map::clear() {
   clients_.clear();
 }
@@ -38,7 +48,7 @@ void block_response_client_map::send_failure() {
   fail.__set_client_id(-2);
   for (const auto &x : clients_.lock_table()) {
     try {
-      x.second->response(fail, {});
+      x.second->response(fail, std::vector<std::string>());
     } catch (std::exception &e) {
       continue;
     }
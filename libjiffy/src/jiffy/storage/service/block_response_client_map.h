@@ -43,6 +43,14 @@ class block_response_client_map {
 
   void respond_client(const sequence_id &seq, const std::vector<std::string> &result);
 
+  /**
+   * @brief Respond to the client, writing borrowed payloads directly to the transport
+   * @param seq Request sequence identifier
+   * @param result Request result
+   */
+
+  void respond_client(const sequence_id &seq, const response_view &result);
+
   /**
    * @brief Clear the map
    */
@@ -1,4 +1,5 @@
 #include "block_server.h"
+#include "block_data_server.h"
 #include "block_request_handler_factory.h"
 #include "jiffy/utils/logger.h"
 
@@ -17,7 +18,17 @@ using namespace ::apache::thrift::server;
 using namespace ::apache::thrift::concurrency;
 using namespace utils;
 
-std::shared_ptr<TServer> block_server::create(std::vector<std::shared_ptr<block>> &blocks, int port, size_t num_threads) {
+std::shared_ptr<TServer> block_server::create(std::vector<std::shared_ptr<block>> &blocks,
+                                              int port,
+                                              size_t num_threads,
+                                              const std::string &engine) {
+  if (engine == "epoll") {
+    LOG(log_level::info) << "Creating data plane server";
+    return std::make_shared<block_data_server>(blocks, port, num_threads);
+  }
+  if (engine != "thrift") {
+    throw std::invalid_argument("Unknown block server engine: " + engine);
+  }
   LOG(log_level::info) << "Creating non-blocking server";
   auto clone_factory = std::make_shared<block_request_handler_factory>(blocks);
   auto proc_factory = std::make_shared<block_request_serviceProcessorFactory>(clone_factory);
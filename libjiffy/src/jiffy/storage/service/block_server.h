@@ -17,11 +17,16 @@ class block_server {
   /**
    * @brief Create block server
    * @param blocks Data blocks
-   * @param address Socket address
    * @param port Socket port
+   * @param num_threads Number of I/O threads
+   * @param engine Server engine, "thrift" for the thrift non-blocking server or "epoll" for the data
+   * plane server
    * @return Block server
    */
-  static server_ptr create(std::vector<block_ptr> &blocks, int port, size_t num_threads = 1);
+  static server_ptr create(std::vector<block_ptr> &blocks,
+                           int port,
+                           size_t num_threads = 1,
+                           const std::string &engine = "thrift");
 };
 
 }
@@ -1,4 +1,5 @@
 #include "shared_log_block.h"
+#include <algorithm>
 #include "jiffy/utils/logger.h"
 #include <iostream>
 
@@ -6,42 +7,45 @@ namespace jiffy {
 namespace storage {
 using namespace utils;
 
-shared_log_block::shared_log_block(std::size_t max_size, block_memory_allocator<char> alloc) : alloc_(alloc), max_(max_size) {
-  data_ = alloc_.allocate(max_);
+shared_log_block::shared_log_block(std::size_t max_size, block_memory_allocator<char> alloc)
+    : region_(std::make_shared<extent_region>(max_size, alloc.manager())), max_(max_size) {
+  data_ = region_->data();
 }
 
-shared_log_block::~shared_log_block() {
-  alloc_.deallocate(data_, max_);
-}
+shared_log_block::~shared_log_block() = default;
 
 shared_log_block::shared_log_block(const shared_log_block &other) {
-  alloc_ = other.alloc_;
+  region_ = other.region_;
   max_ = other.max_;
   data_ = other.data_;
 }
 
 shared_log_block &shared_log_block::operator=(const shared_log_block &other) {
-  alloc_ = other.alloc_;
+  region_ = other.region_;
   max_ = other.max_;
   data_ = other.data_;
   return *this;
 }
 
 bool shared_log_block::operator==(const shared_log_block &other) const {
-  return data_ == other.data_ && alloc_ == other.alloc_ && max_ == other.max_;
+  return region_ == other.region_ && max_ == other.max_;
 }
 
 std::pair<bool, std::string> shared_log_block::write(const std::string &data, std::size_t offset) {
-  auto len = data.size();
-  std::memcpy(data_ + offset, data.c_str(), len);
+  region_->write(offset, data.data(), data.size());
   return std::make_pair(true, std::string("!success"));
 }
 
 const std::pair<bool, std::string> shared_log_block::read(std::size_t offset, std::size_t size) const {
+  auto span = read_span(offset, size).second;
+  return std::make_pair(true, std::string(span.data, span.size));
+}
+
+const std::pair<bool, byte_span> shared_log_block::read_span(std::size_t offset, std::size_t size) const {
   if (offset >= max_) {
     throw std::invalid_argument("Read offset exceeds partition capacity");
   }
-  return std::make_pair(true, std::string(data_ + offset, size));
+  return std::make_pair(true, borrow(data_ + offset, std::min(size, max_ - offset)));
 }
 
 std::size_t shared_log_block::size() const {
@@ -49,14 +53,24 @@ std::size_t shared_log_block::size() const {
 }
 
 void shared_log_block::clear() {
-  for (std::size_t i = 0; i < max_; i++) {
-    data_[i] = 0;
-  }
+  region_->clear();
+}
+
+void shared_log_block::release(std::size_t offset, std::size_t size) {
+  region_->release(offset, size);
 }
 
 char *shared_log_block::data() const {
   return data_;
 }
 
+std::size_t shared_log_block::committed() const {
+  return region_->committed();
+}
+
+void shared_log_block::copy_from(const shared_log_block &other, std::size_t offset, std::size_t size) {
+  region_->copy_from(*other.region_, offset, size);
+}
+
 }
 }
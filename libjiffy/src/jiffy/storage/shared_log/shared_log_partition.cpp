@@ -4,6 +4,7 @@
 #include "jiffy/storage/shared_log/shared_log_ops.h"
 #include "jiffy/auto_scaling/auto_scaling_client.h"
 #include <jiffy/utils/directory_utils.h>
+#include <algorithm>
 #include <thread>
 #include <iostream>
 
@@ -25,12 +26,22 @@ shared_log_partition::shared_log_partition(block_memory_manager *manager,
       partition_(manager->mb_capacity(), build_allocator<char>()),
       scaling_up_(false),
       dirty_(false),
+      synced_entries_(0),
+      sync_base_(true),
+      deltas_(conf.get_as<std::size_t>("shared_log.sync_max_deltas", 16),
+              conf.get_as<double>("shared_log.sync_delta_ratio", 0.5)),
       block_allocated_(false),
       auto_scaling_host_(auto_scaling_host),
       auto_scaling_port_(auto_scaling_port) {
   auto ser_name_ = conf.get("shared_log.serializer", "binary");
   if (ser_name_ == "binary") {
     ser_ = std::make_shared<binary_serde>(binary_allocator_);
+  } else if (ser_name_ == "binary_lz4") {
+    ser_ = std::make_shared<binary_serde>(binary_allocator_, persistent::codec::make("lz4"));
+  } else if (ser_name_ == "binary_zstd") {
+    ser_ = std::make_shared<binary_serde>(binary_allocator_, persistent::codec::make("zstd"));
+  } else if (ser_name_ == "indexed") {
+    ser_ = std::make_shared<indexed_serde>(binary_allocator_);
   } else {
     throw std::invalid_argument("No such serializer/deserializer " + ser_name_);
   }
@@ -41,18 +52,22 @@ void shared_log_partition::write(response &_return, const arg_list &args) {
   if (args.size() < 4) {
     RETURN_ERR("!args_error");
   }
-  auto position = std::stoi(args[1]);
+  append_entry(std::stoi(args[1]), args[2], std::vector<std::string>(args.begin() + 3, args.end()));
+  RETURN_OK();
+
+}
+
+void shared_log_partition::append_entry(int position, const std::string &data, const std::vector<std::string> &streams) {
   if (log_info_.size() == 0) {
     seq_no_ = position;
   }
-  auto data = args[2];
   std::string logical_stream = "";
   std::vector<int> info_set;
   info_set.push_back(int(starting_offset_));
   info_set.push_back(int(data.size()));
-  for (std::size_t i = 3; i < args.size(); i++) {
-    logical_stream += args[i];
-    info_set.push_back(int(args[i].size()));
+  for (const auto &stream: streams) {
+    logical_stream += stream;
+    info_set.push_back(int(stream.size()));
   }
   log_info_.push_back(info_set);
   std::string writing_content = logical_stream + data;
@@ -61,11 +76,15 @@ void shared_log_partition::write(response &_return, const arg_list &args) {
     throw std::logic_error("Write failed");
   }
   starting_offset_ += writing_content.size();
-  RETURN_OK();
-
 }
 
 void shared_log_partition::scan(response &_return, const arg_list &args) {
+  response_view view;
+  scan(view, args);
+  _return = view.to_response();
+}
+
+void shared_log_partition::scan(response_view &_return, const arg_list &args) {
   if (args.size() < 4) {
     RETURN_ERR("!args_error");
   }
@@ -76,9 +95,9 @@ void shared_log_partition::scan(response &_return, const arg_list &args) {
   for (std::size_t i = 3; i < args.size(); i++) {
     logical_streams.push_back(args[i]);
   }
-  std::vector<std::string> ret = {"!ok"};
+  response_view ret = {"!ok"};
   if (log_info_.size() == 0) {
-    _return = ret;
+    _return = std::move(ret);
     return;
   }
   if (start_pos < 0 || static_cast<size_t>(start_pos) >= log_info_.size() || end_pos < 0 || end_pos < start_pos)
@@ -99,14 +118,14 @@ void shared_log_partition::scan(response &_return, const arg_list &args) {
       std::vector<std::string>::iterator it;
       it = find(logical_streams.begin(), logical_streams.end(), stream);
       if (it != logical_streams.end()) {
-        auto data = partition_.read(static_cast<std::size_t>(info_set[0] + stream_size),
-                                    static_cast<std::size_t>(data_size)).second;
+        auto data = partition_.read_span(static_cast<std::size_t>(info_set[0] + stream_size),
+                                         static_cast<std::size_t>(data_size)).second;
         ret.push_back(data);
         break;
       }
     }
   }
-  _return = ret;
+  _return = std::move(ret);
 
 }
 
@@ -127,10 +146,21 @@ void shared_log_partition::trim(response &_return, const arg_list &args) {
     auto info_set = log_info_[i];
     if (info_set[0] == -1) continue;
     log_info_[i][0] = -1; // make the log entry invalid
+    sync_base_ = true;
     for (std::size_t j = 1; j < info_set.size(); j++) {
       trimmed_length += info_set[j];
     }
   }
+  // Entries are laid out in log order, so the memory below the oldest entry left is no longer read
+  auto live_offset = starting_offset_;
+  for (const auto &info_set: log_info_) {
+    if (info_set[0] != -1) {
+      live_offset = info_set[0];
+      break;
+    }
+  }
+  snapshot_copy_.preserve_bytes(0, static_cast<std::size_t>(live_offset), extent_region::EXTENT_SIZE);
+  partition_.release(0, static_cast<std::size_t>(live_offset));
 
   RETURN_OK(std::to_string(trimmed_length));
 }
@@ -140,6 +170,7 @@ void shared_log_partition::update_partition(response &_return, const arg_list &a
     block_allocated_ = true;
     allocated_blocks_.insert(allocated_blocks_.end(), args.begin() + 1, args.end());
   }
+  sync_base_ = true;
   RETURN_OK();
 }
 
@@ -173,6 +204,15 @@ void shared_log_partition::get_storage_capacity(response &_return, const arg_lis
   RETURN_OK(std::to_string(manager_->mb_capacity()));
 }
 
+void shared_log_partition::run_command_view(response_view &_return, const arg_list &args) {
+  switch (command_id(args[0])) {
+    case shared_log_cmd_id::shared_log_scan:scan(_return, args);
+      break;
+    default:partition::run_command_view(_return, args);
+      break;
+  }
+}
+
 void shared_log_partition::run_command(response &_return, const arg_list &args) {
   auto cmd_name = args[0];
   switch (command_id(cmd_name)) {
@@ -208,34 +248,101 @@ bool shared_log_partition::is_dirty() const {
 }
 
 void shared_log_partition::load(const std::string &path) {
+  // Snapshots of the path by any partition must land before it is read
+  persistent::snapshot_writer::instance()->wait_all();
   auto remote = persistent::persistent_store::instance(path, ser_);
   auto decomposed = persistent::persistent_store::decompose_path(path);
-  shared_log_serde_type triple = {&partition_, log_info_, seq_no_};
+  // A base image replaced up to a crash is either finished or left untouched
+  remote->recover_base(decomposed.second);
+  shared_log_serde_type triple = {&partition_, {}, 0};
   remote->read<shared_log_serde_type>(decomposed.second, triple);
+  log_info_ = std::move(triple.log_info);
+  seq_no_ = triple.seq_no;
+  // The base image packs the live entries back to back
+  starting_offset_ = 0;
+  for (const auto &info_set: log_info_) {
+    if (info_set[0] == -1) continue;
+    int end_offset = info_set[0];
+    for (std::size_t j = 1; j < info_set.size(); j++) {
+      end_offset += info_set[j];
+    }
+    starting_offset_ = std::max(starting_offset_, end_offset);
+  }
+  auto replayed = remote->replay_deltas(decomposed.second, [this](const persistent::delta &d) {
+    apply_delta(d);
+  });
+  deltas_.reset(path, replayed.first, replayed.second);
+  synced_entries_ = log_info_.size();
+  sync_base_ = false;
 }
 
-bool shared_log_partition::sync(const std::string &path) {
+bool shared_log_partition::snapshot(const std::string &path) {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mtx_);
+  auto synced = capture_snapshot(path);
+  // A base image is copied one extent at a time while commands append to the log
+  finish_snapshot();
+  return synced;
+}
+
+bool shared_log_partition::capture_snapshot(const std::string &path) {
+  freeze_guard freeze(*this);
+  if (!freeze.frozen()) {
+    LOG(log_level::warn) << "Commands on partition " << name() << " did not drain, skipping snapshot";
+    return false;
+  }
+  if (snapshot_failed()) {
+    dirty_ = true;
+    sync_base_ = true;
+  }
   if (dirty_) {
-    auto remote = persistent::persistent_store::instance(path, ser_);
-    auto decomposed = persistent::persistent_store::decompose_path(path);
-    shared_log_serde_type triple = {&partition_, log_info_, seq_no_};
-    remote->write<shared_log_serde_type>(triple, decomposed.second);
+    bool synced = true;
+    if (sync_base_) {
+      snapshot_base(path);
+    } else if (log_info_.size() == synced_entries_) {
+      synced = false;
+    } else {
+      auto d = std::make_shared<persistent::delta>(make_delta());
+      auto delta_bytes = persistent::delta_size(*d);
+      if (deltas_.can_append(path, delta_bytes, static_cast<std::size_t>(starting_offset_))) {
+        auto seq = deltas_.append(delta_bytes);
+        auto ser = ser_;
+        persist(delta_bytes, [ser, path, d, seq] {
+          auto remote = persistent::persistent_store::instance(path, ser);
+          auto decomposed = persistent::persistent_store::decompose_path(path);
+          remote->write_delta(*d, decomposed.second, seq);
+        });
+        synced_entries_ = log_info_.size();
+      } else {
+        snapshot_base(path);
+      }
+    }
     dirty_ = false;
-    return true;
+    return synced;
   }
   return false;
 }
 
+bool shared_log_partition::sync(const std::string &path) {
+  auto synced = snapshot(path);
+  wait_snapshots();
+  return synced;
+}
+
 bool shared_log_partition::dump(const std::string &path) {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mtx_);
+  wait_snapshots();
   bool flushed = false;
-  if (dirty_) {
-    auto remote = persistent::persistent_store::instance(path, ser_);
-    auto decomposed = persistent::persistent_store::decompose_path(path);
-    shared_log_serde_type triple = {&partition_, log_info_, seq_no_};
-    remote->write<shared_log_serde_type>(triple, decomposed.second);
+  if (dirty_ || deltas_.num_deltas() > 0) {
+    write_base(path);
     flushed = true;
   }
   partition_.clear();
+  log_info_.clear();
+  seq_no_ = 0;
+  starting_offset_ = 0;
+  synced_entries_ = 0;
+  sync_base_ = true;
+  deltas_.clear();
   next_->reset("nil");
   path_ = "";
   sub_map_.clear();
@@ -246,6 +353,68 @@ bool shared_log_partition::dump(const std::string &path) {
   return flushed;
 }
 
+persistent::delta shared_log_partition::make_delta() const {
+  persistent::delta d;
+  for (auto i = synced_entries_; i < log_info_.size(); i++) {
+    const auto &info_set = log_info_[i];
+    persistent::delta_record r{static_cast<std::uint64_t>(seq_no_ + static_cast<int>(i)), {}};
+    auto offset = static_cast<std::size_t>(info_set[0]);
+    std::vector<std::string> streams;
+    for (std::size_t j = 2; j < info_set.size(); j++) {
+      streams.push_back(partition_.read(offset, static_cast<std::size_t>(info_set[j])).second);
+      offset += info_set[j];
+    }
+    r.items.push_back(partition_.read(offset, static_cast<std::size_t>(info_set[1])).second);
+    r.items.insert(r.items.end(), streams.begin(), streams.end());
+    d.push_back(std::move(r));
+  }
+  return d;
+}
+
+void shared_log_partition::apply_delta(const persistent::delta &d) {
+  for (const auto &r: d) {
+    auto position = static_cast<int>(r.id);
+    if ((!log_info_.empty() && position != seq_no_ + static_cast<int>(log_info_.size())) || r.items.empty()) {
+      throw std::runtime_error("Shared log delta does not extend the base image");
+    }
+    append_entry(position, r.items[0],
+                 std::vector<std::string>(r.items.begin() + 1, r.items.end()));
+  }
+}
+
+void shared_log_partition::write_base(const std::string &path) {
+  auto remote = persistent::persistent_store::instance(path, ser_);
+  auto decomposed = persistent::persistent_store::decompose_path(path);
+  shared_log_serde_type triple = {&partition_, log_info_, seq_no_};
+  remote->write_base<shared_log_serde_type>(triple, decomposed.second);
+  deltas_.reset(path);
+  synced_entries_ = log_info_.size();
+  sync_base_ = false;
+}
+
+void shared_log_partition::snapshot_base(const std::string &path) {
+  auto snap = std::make_shared<data_snapshot<shared_log_block>>();
+  snap->data.reset(new shared_log_block(partition_.size(), snap->build_allocator<char>()));
+  // Entries live below the starting offset
+  auto size = static_cast<std::size_t>(starting_offset_);
+  auto log_info = log_info_;
+  auto seq_no = seq_no_;
+  deltas_.reset(path);
+  synced_entries_ = log_info_.size();
+  sync_base_ = false;
+  auto ser = ser_;
+  auto extent_size = extent_region::EXTENT_SIZE;
+  start_snapshot((size + extent_size - 1) / extent_size, [this, snap, size, extent_size](std::size_t extent) {
+    auto offset = extent * extent_size;
+    snap->data->copy_from(partition_, offset, min(extent_size, size - offset));
+  }, size, [ser, path, snap, log_info, seq_no] {
+    auto remote = persistent::persistent_store::instance(path, ser);
+    auto decomposed = persistent::persistent_store::decompose_path(path);
+    shared_log_serde_type triple = {snap->data.get(), log_info, seq_no};
+    remote->write_base<shared_log_serde_type>(triple, decomposed.second);
+  });
+}
+
 void shared_log_partition::forward_all() {
   std::vector<std::string> result;
   run_command_on_next(result, {"write", std::string(partition_.data(), partition_.size())});
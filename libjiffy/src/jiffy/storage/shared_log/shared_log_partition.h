@@ -60,6 +60,13 @@ class shared_log_partition : public chain_module {
    */
   void scan(response &_return, const arg_list &args);
 
+  /**
+   * @brief Read data from the shared_log, borrowing it from partition memory
+   * @param _return Response
+   * @param args Arguments
+   */
+  void scan(response_view &_return, const arg_list &args);
+
   /**
    * @brief Trim data from the shared_log
    * @param _return Response
@@ -102,6 +109,13 @@ class shared_log_partition : public chain_module {
    */
   void run_command(response &_return, const arg_list &args) override;
 
+  /**
+   * @brief Run command on shared_log partition, borrowing scanned data from partition memory
+   * @param _return Response
+   * @param args Arguments
+   */
+  void run_command_view(response_view &_return, const arg_list &args) override;
+
   /**
    * @brief Atomically check dirty bit
    * @return Bool value, true if block is dirty
@@ -109,20 +123,29 @@ class shared_log_partition : public chain_module {
   bool is_dirty() const;
 
   /**
-   * @brief Load persistent data into the block
+   * @brief Load persistent data into the block, replaying the deltas of the base image
    * @param path Persistent storage path
    */
   void load(const std::string &path) override;
 
   /**
-   * @brief If dirty, synchronize persistent storage and block
+   * @brief If dirty, capture the block and persist it on the snapshot writer
+   * Only the entries written since the previous snapshot are written as a delta, unless the log was
+   * trimmed or the deltas outgrow shared_log.sync_max_deltas or shared_log.sync_delta_ratio
+   * @param path Persistent storage path
+   * @return Bool value, true if block successfully captured
+   */
+  bool snapshot(const std::string &path) override;
+
+  /**
+   * @brief If dirty, synchronize persistent storage and block, waiting for the snapshot to be written
    * @param path Persistent storage path
    * @return Bool value, true if block successfully synchronized
    */
   bool sync(const std::string &path) override;
 
   /**
-   * @brief Flush the block if dirty and clear the block
+   * @brief Flush the block as a single base image if dirty or extended by deltas and clear the block
    * @param path Persistent storage path
    * @return Bool value, true if block successfully dumped
    */
@@ -138,6 +161,46 @@ class shared_log_partition : public chain_module {
 
  private:
 
+  /**
+   * @brief Append a log entry at the end of the partition
+   * @param position Seq no. of the entry
+   * @param data Entry data
+   * @param streams Logical streams of the entry
+   */
+  void append_entry(int position, const std::string &data, const std::vector<std::string> &streams);
+
+  /**
+   * @brief Collect the log entries written since the previous sync
+   * @return Delta with one record per entry, identified by its seq no. and holding its data and streams
+   */
+  persistent::delta make_delta() const;
+
+  /**
+   * @brief Append the log entries of a delta
+   * @param d Delta
+   */
+  void apply_delta(const persistent::delta &d);
+
+  /**
+   * @brief Write the whole block as the base image of a path and drop its deltas
+   * @param path Persistent storage path
+   */
+  void write_base(const std::string &path);
+
+  /**
+   * @brief Capture the log while frozen, starting a base image or persisting a delta
+   * @param path Persistent storage path
+   * @return Bool value, true if log successfully captured
+   */
+  bool capture_snapshot(const std::string &path);
+
+  /**
+   * @brief Start copying the log one extent at a time, to be persisted as the base image of a path;
+   * writes only append past the copied bytes, so only trimming the log has to preserve them
+   * @param path Persistent storage path
+   */
+  void snapshot_base(const std::string &path);
+
   /* Shared log partition */
   shared_log_type partition_;
 
@@ -153,6 +216,15 @@ class shared_log_partition : public chain_module {
   /* Partition dirty bit */
   bool dirty_;
 
+  /* Number of log entries up to the previous sync, later entries go to the next delta */
+  std::size_t synced_entries_;
+
+  /* Bool value, true if the next sync rewrites the base image */
+  bool sync_base_;
+
+  /* Deltas extending the base image */
+  persistent::delta_log deltas_;
+
   /* Bool to indicate if block is successfully allocated */
   bool block_allocated_;
 
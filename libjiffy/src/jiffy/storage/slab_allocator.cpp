@@ -0,0 +1,310 @@
+#ifdef MEMKIND_IN_USE
+  #include <memkind.h>
+#else
+  #include <jemalloc/jemalloc.h>
+#endif
+#include <algorithm>
+#include <iterator>
+#include "slab_allocator.h"
+
+namespace jiffy {
+namespace storage {
+
+constexpr std::size_t slab_allocator::CHUNK_SIZE;
+constexpr std::size_t slab_allocator::MAX_SLAB_SIZE;
+constexpr std::size_t slab_allocator::NUM_CLASSES;
+
+namespace {
+
+/* Number of thread cache entries above which entries of destroyed allocators are dropped */
+constexpr std::size_t MIN_SWEEP_ENTRIES = 16;
+
+std::atomic<uint64_t> next_allocator_id(1);
+
+/**
+ * @brief Number of objects moved between a thread cache and the shared free list at once
+ * @param cls Size class index
+ * @return Batch size
+ */
+std::size_t batch_size(std::size_t cls) {
+  return std::min<std::size_t>(64, std::max<std::size_t>(4, 16384 / slab_allocator::class_size(cls)));
+}
+
+}
+
+/* Free lists of one thread, one entry per allocator the thread used */
+struct slab_thread_cache {
+  typedef slab_allocator::free_object free_object;
+
+  struct entry {
+    uint64_t id{0};
+    uint64_t generation{0};
+    std::shared_ptr<slab_allocator::owner_state> owner;
+    free_object *heads[slab_allocator::NUM_CLASSES]{};
+    std::size_t counts[slab_allocator::NUM_CLASSES]{};
+
+    void clear() {
+      std::fill(std::begin(heads), std::end(heads), nullptr);
+      std::fill(std::begin(counts), std::end(counts), 0);
+    }
+  };
+
+  ~slab_thread_cache() {
+    for (auto &e : entries) {
+      flush(e.second);
+    }
+  }
+
+  /**
+   * @brief Fetch the entry of an allocator, dropping objects of released chunks
+   * @param alloc Allocator
+   * @return Entry
+   */
+  entry &get(slab_allocator *alloc) {
+    if (last == nullptr || last->id != alloc->id_) {
+      auto it = entries.find(alloc->id_);
+      if (it == entries.end()) {
+        if (entries.size() >= sweep_entries) {
+          sweep();
+          sweep_entries = std::max(MIN_SWEEP_ENTRIES, 2 * entries.size());
+        }
+        it = entries.emplace(alloc->id_, entry()).first;
+        it->second.id = alloc->id_;
+        it->second.owner = alloc->owner_;
+        it->second.generation = alloc->generation_.load(std::memory_order_acquire);
+      }
+      last = &it->second;
+    }
+    auto generation = alloc->generation_.load(std::memory_order_acquire);
+    if (last->generation != generation) {
+      last->clear();
+      last->generation = generation;
+    }
+    return *last;
+  }
+
+  /**
+   * @brief Return all objects of an entry to its allocator if it is still alive
+   * @param e Entry
+   */
+  static void flush(entry &e) {
+    std::lock_guard<std::mutex> lock(e.owner->mtx);
+    if (e.owner->allocator != nullptr) {
+      for (std::size_t cls = 0; cls < slab_allocator::NUM_CLASSES; ++cls) {
+        if (e.heads[cls] == nullptr) continue;
+        auto tail = e.heads[cls];
+        while (tail->next != nullptr) tail = tail->next;
+        e.owner->allocator->put(cls, e.heads[cls], tail, e.counts[cls], e.generation);
+      }
+    }
+    e.clear();
+  }
+
+  /**
+   * @brief Drop the entries of destroyed allocators, their objects were freed with the chunks
+   */
+  void sweep() {
+    for (auto it = entries.begin(); it != entries.end();) {
+      bool alive;
+      {
+        std::lock_guard<std::mutex> lock(it->second.owner->mtx);
+        alive = it->second.owner->allocator != nullptr;
+      }
+      it = alive ? std::next(it) : entries.erase(it);
+    }
+    last = nullptr;
+  }
+
+  /* Entries keyed by allocator identifier */
+  std::unordered_map<uint64_t, entry> entries;
+  /* Entry used last, entries keep their address until erased */
+  entry *last{nullptr};
+  /* Number of entries at which the next new entry sweeps */
+  std::size_t sweep_entries{MIN_SWEEP_ENTRIES};
+};
+
+static thread_local slab_thread_cache thread_cache;
+
+slab_allocator::slab_allocator(const std::string &memory_mode, void *mem_kind)
+    : id_(next_allocator_id.fetch_add(1)),
+      generation_(0),
+      owner_(std::make_shared<owner_state>()),
+      memory_mode_(memory_mode),
+      mem_kind_(mem_kind) {
+  owner_->allocator = this;
+}
+
+slab_allocator::~slab_allocator() {
+  {
+    // Waits for threads handing objects back, later flushes drop their objects
+    std::lock_guard<std::mutex> lock(owner_->mtx);
+    owner_->allocator = nullptr;
+  }
+  release();
+}
+
+void *slab_allocator::allocate(std::size_t size) {
+  auto cls = size_class(size);
+  auto &e = thread_cache.get(this);
+  if (e.heads[cls] == nullptr) {
+    e.counts[cls] = fetch(cls, batch_size(cls), e.heads[cls]);
+    if (e.counts[cls] == 0) {
+      return nullptr;
+    }
+  }
+  auto obj = e.heads[cls];
+  e.heads[cls] = obj->next;
+  --e.counts[cls];
+  return obj;
+}
+
+void slab_allocator::deallocate(void *ptr, std::size_t size) {
+  auto cls = size_class(size);
+  auto &e = thread_cache.get(this);
+  auto obj = static_cast<free_object *>(ptr);
+  obj->next = e.heads[cls];
+  e.heads[cls] = obj;
+  auto batch = batch_size(cls);
+  if (++e.counts[cls] > 2 * batch) {
+    // Keep one batch cached and hand the rest back
+    auto tail = e.heads[cls];
+    for (std::size_t i = 1; i < batch; ++i) tail = tail->next;
+    auto head = e.heads[cls];
+    e.heads[cls] = tail->next;
+    tail->next = nullptr;
+    e.counts[cls] -= batch;
+    put(cls, head, tail, batch, e.generation);
+  }
+}
+
+std::size_t slab_allocator::allocation_size(const void *ptr) const {
+  auto chunk = reinterpret_cast<uintptr_t>(ptr) & ~(static_cast<uintptr_t>(CHUNK_SIZE) - 1);
+  std::lock_guard<std::mutex> lock(chunk_mtx_);
+  auto it = chunk_class_.find(chunk);
+  return it == chunk_class_.end() ? 0 : class_size(it->second);
+}
+
+void slab_allocator::release() {
+  // Bump the generation first, so that objects handed back from now on are dropped
+  generation_.fetch_add(1, std::memory_order_acq_rel);
+  for (auto &c : classes_) {
+    std::lock_guard<std::mutex> lock(c.mtx);
+    c.free_list = nullptr;
+    c.free_count = 0;
+    c.bump = c.bump_end = nullptr;
+  }
+  std::vector<char *> chunks;
+  {
+    std::lock_guard<std::mutex> lock(chunk_mtx_);
+    chunks.swap(chunks_);
+    chunk_class_.clear();
+  }
+  for (auto chunk : chunks) {
+    free_chunk(chunk);
+  }
+}
+
+std::size_t slab_allocator::reserved() const {
+  std::lock_guard<std::mutex> lock(chunk_mtx_);
+  return chunks_.size() * CHUNK_SIZE;
+}
+
+std::size_t slab_allocator::size_class(std::size_t size) {
+  if (size <= 128) {
+    return size == 0 ? 0 : (size - 1) >> 4;
+  }
+  // Four classes per power of two above 128 bytes
+  auto s = size - 1;
+  std::size_t lg = 63 - __builtin_clzll(s);
+  return 8 + (lg - 7) * 4 + ((s >> (lg - 2)) & 3);
+}
+
+std::size_t slab_allocator::class_size(std::size_t cls) {
+  if (cls < 8) {
+    return (cls + 1) << 4;
+  }
+  std::size_t base = std::size_t(128) << ((cls - 8) / 4);
+  return base + ((cls - 8) % 4 + 1) * (base / 4);
+}
+
+std::size_t slab_allocator::fetch(std::size_t cls, std::size_t count, free_object *&head) {
+  auto &c = classes_[cls];
+  std::lock_guard<std::mutex> lock(c.mtx);
+  std::size_t n = 0;
+  head = nullptr;
+  while (n < count && c.free_list != nullptr) {
+    auto obj = c.free_list;
+    c.free_list = obj->next;
+    obj->next = head;
+    head = obj;
+    ++n;
+  }
+  c.free_count -= n;
+  if (n > 0) {
+    return n;
+  }
+  auto size = class_size(cls);
+  if (c.bump == c.bump_end) {
+    c.bump = new_chunk(cls);
+    if (c.bump == nullptr) {
+      c.bump_end = nullptr;
+      return 0;
+    }
+    c.bump_end = c.bump + (CHUNK_SIZE / size) * size;
+  }
+  while (n < count && c.bump != c.bump_end) {
+    auto obj = reinterpret_cast<free_object *>(c.bump);
+    c.bump += size;
+    obj->next = head;
+    head = obj;
+    ++n;
+  }
+  return n;
+}
+
+void slab_allocator::put(std::size_t cls,
+                         free_object *head,
+                         free_object *tail,
+                         std::size_t count,
+                         uint64_t generation) {
+  auto &c = classes_[cls];
+  std::lock_guard<std::mutex> lock(c.mtx);
+  if (generation != generation_.load(std::memory_order_acquire)) {
+    return;
+  }
+  tail->next = c.free_list;
+  c.free_list = head;
+  c.free_count += count;
+}
+
+char *slab_allocator::new_chunk(std::size_t cls) {
+  #ifdef MEMKIND_IN_USE
+    auto kind = memory_mode_ == "DRAM" ? MEMKIND_DEFAULT : (struct memkind *) mem_kind_;
+    void *ptr = nullptr;
+    if (memkind_posix_memalign(kind, &ptr, CHUNK_SIZE, CHUNK_SIZE) != 0) {
+      return nullptr;
+    }
+  #else
+    auto ptr = mallocx(CHUNK_SIZE, MALLOCX_ALIGN(CHUNK_SIZE));
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+  #endif
+  auto chunk = static_cast<char *>(ptr);
+  std::lock_guard<std::mutex> lock(chunk_mtx_);
+  chunks_.push_back(chunk);
+  chunk_class_.emplace(reinterpret_cast<uintptr_t>(chunk), static_cast<uint8_t>(cls));
+  return chunk;
+}
+
+void slab_allocator::free_chunk(char *chunk) {
+  #ifdef MEMKIND_IN_USE
+    auto kind = memory_mode_ == "DRAM" ? MEMKIND_DEFAULT : (struct memkind *) mem_kind_;
+    memkind_free(kind, chunk);
+  #else
+    free(chunk);
+  #endif
+}
+
+}
+}
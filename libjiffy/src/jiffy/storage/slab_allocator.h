@@ -0,0 +1,177 @@
+#ifndef JIFFY_SLAB_ALLOCATOR_H
+#define JIFFY_SLAB_ALLOCATOR_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace jiffy {
+namespace storage {
+
+/**
+ * @brief Size-class slab allocator owned by a single memory block.
+ *
+ * Small allocations are rounded up to one of a fixed set of size classes and carved out of large,
+ * chunk-aligned chunks; every chunk serves exactly one size class. Freed objects go to a per-thread
+ * free list first and are returned to the shared per-class free list in batches, so the common
+ * allocate/free path takes no locks. Since the allocator owns all of its chunks, releasing the
+ * whole block only frees the chunks, independent of the number of objects carved from them.
+ *
+ * Allocations larger than the largest size class bypass the slabs.
+ */
+class slab_allocator {
+ public:
+  /* Chunk size and alignment */
+  static constexpr std::size_t CHUNK_SIZE = 256 * 1024;
+  /* Largest size served from the slabs */
+  static constexpr std::size_t MAX_SLAB_SIZE = 4096;
+  /* Number of size classes */
+  static constexpr std::size_t NUM_CLASSES = 28;
+
+  /**
+   * @brief Constructor
+   * @param memory_mode Memory mode
+   * @param mem_kind Memory kind
+   */
+  explicit slab_allocator(const std::string &memory_mode = "DRAM", void *mem_kind = nullptr);
+
+  /**
+   * @brief Destructor, releases all chunks
+   */
+  ~slab_allocator();
+
+  slab_allocator(const slab_allocator &) = delete;
+  slab_allocator &operator=(const slab_allocator &) = delete;
+
+  /**
+   * @brief Allocate memory from the size class that fits size
+   * @param size Number of bytes, at most MAX_SLAB_SIZE
+   * @return Pointer to allocated memory, null if a new chunk could not be allocated
+   */
+  void *allocate(std::size_t size);
+
+  /**
+   * @brief Return memory to its size class
+   * @param ptr Pointer to memory allocated with size
+   * @param size Number of bytes requested at allocation
+   */
+  void deallocate(void *ptr, std::size_t size);
+
+  /**
+   * @brief Fetch the size class a pointer was allocated from
+   * @param ptr Pointer
+   * @return Size class size, 0 if the pointer was not allocated from a chunk of this allocator
+   */
+  std::size_t allocation_size(const void *ptr) const;
+
+  /**
+   * @brief Release all chunks at once
+   * All memory handed out before the release becomes invalid.
+   */
+  void release();
+
+  /**
+   * @brief Fetch number of bytes held in chunks
+   * @return Number of bytes held in chunks
+   */
+  std::size_t reserved() const;
+
+  /**
+   * @brief Fetch the size class index for a size
+   * @param size Number of bytes, at most MAX_SLAB_SIZE
+   * @return Size class index
+   */
+  static std::size_t size_class(std::size_t size);
+
+  /**
+   * @brief Fetch the size of a size class
+   * @param cls Size class index
+   * @return Size class size
+   */
+  static std::size_t class_size(std::size_t cls);
+
+ private:
+  friend struct slab_thread_cache;
+
+  /* Singly linked list of free objects, the link is stored in the object itself */
+  struct free_object {
+    free_object *next;
+  };
+
+  /* Reference to the allocator that thread caches hold, cleared when the allocator is destroyed */
+  struct owner_state {
+    std::mutex mtx;
+    slab_allocator *allocator{nullptr};
+  };
+
+  /* Shared state of one size class */
+  struct size_class_state {
+    std::mutex mtx;
+    free_object *free_list{nullptr};
+    std::size_t free_count{0};
+    char *bump{nullptr};
+    char *bump_end{nullptr};
+  };
+
+  /**
+   * @brief Move up to count objects of a size class into a list
+   * @param cls Size class index
+   * @param count Maximum number of objects
+   * @param head List head
+   * @return Number of objects moved, 0 if a new chunk could not be allocated
+   */
+  std::size_t fetch(std::size_t cls, std::size_t count, free_object *&head);
+
+  /**
+   * @brief Return a list of objects to a size class, unless the allocator was released since
+   * @param cls Size class index
+   * @param head List head
+   * @param tail List tail
+   * @param count Number of objects
+   * @param generation Generation the objects were allocated in
+   */
+  void put(std::size_t cls, free_object *head, free_object *tail, std::size_t count, uint64_t generation);
+
+  /**
+   * @brief Allocate chunk for a size class
+   * @param cls Size class index
+   * @return Chunk, null on failure
+   */
+  char *new_chunk(std::size_t cls);
+
+  /**
+   * @brief Free chunk
+   * @param chunk Chunk
+   */
+  void free_chunk(char *chunk);
+
+  /* Allocator identifier, unique over the process lifetime */
+  const uint64_t id_;
+  /* Incremented on every release so thread caches drop objects of freed chunks */
+  std::atomic<uint64_t> generation_;
+  /* Owner reference handed to thread caches */
+  std::shared_ptr<owner_state> owner_;
+  /* Size classes */
+  std::array<size_class_state, NUM_CLASSES> classes_;
+  /* Chunk mutex */
+  mutable std::mutex chunk_mtx_;
+  /* Chunks */
+  std::vector<char *> chunks_;
+  /* Size class of each chunk, keyed by chunk address */
+  std::unordered_map<uintptr_t, uint8_t> chunk_class_;
+  /* Memory mode */
+  std::string memory_mode_;
+  /* Memory kind */
+  void *mem_kind_;
+};
+
+}
+}
+
+#endif //JIFFY_SLAB_ALLOCATOR_H
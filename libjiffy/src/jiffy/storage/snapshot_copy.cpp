@@ -0,0 +1,71 @@
+#include <algorithm>
+#include "snapshot_copy.h"
+
+namespace jiffy {
+namespace storage {
+
+void snapshot_copy::start(std::size_t num_units, copy_function copy) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  pending_.assign(num_units, true);
+  next_ = 0;
+  copy_ = std::move(copy);
+  num_pending_.store(num_units, std::memory_order_release);
+  if (num_units == 0) {
+    copy_ = nullptr;
+  }
+}
+
+void snapshot_copy::preserve(std::size_t begin, std::size_t end) {
+  if (num_pending_.load(std::memory_order_acquire) == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mtx_);
+  end = std::min(end, pending_.size());
+  for (auto unit = begin; unit < end && num_pending_.load(std::memory_order_relaxed) > 0; ++unit) {
+    copy_unit(unit);
+  }
+}
+
+void snapshot_copy::preserve_bytes(std::size_t offset, std::size_t len, std::size_t unit_size) {
+  if (len > 0) {
+    preserve(offset / unit_size, (offset + len + unit_size - 1) / unit_size);
+  }
+}
+
+void snapshot_copy::preserve_all() {
+  while (copy_next()) {}
+}
+
+bool snapshot_copy::copy_next() {
+  if (num_pending_.load(std::memory_order_acquire) == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mtx_);
+  while (next_ < pending_.size() && !pending_[next_]) {
+    ++next_;
+  }
+  if (next_ == pending_.size()) {
+    return false;
+  }
+  copy_unit(next_);
+  return true;
+}
+
+bool snapshot_copy::active() const {
+  return num_pending_.load(std::memory_order_acquire) > 0;
+}
+
+void snapshot_copy::copy_unit(std::size_t unit) {
+  if (!pending_[unit]) {
+    return;
+  }
+  copy_(unit);
+  pending_[unit] = false;
+  if (num_pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    // Drop the function so that the copy it refers to is only held by the snapshot job
+    copy_ = nullptr;
+  }
+}
+
+}
+}
@@ -0,0 +1,91 @@
+#ifndef JIFFY_SNAPSHOT_COPY_H
+#define JIFFY_SNAPSHOT_COPY_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace jiffy {
+namespace storage {
+
+/**
+ * @brief Copy of partition data taken one unit (hash slot, region extent) at a time.
+ *
+ * Starting a copy only marks every unit pending, so a snapshot freezes the partition for as long as it
+ * takes to capture its metadata rather than for a full copy. The snapshot then copies the pending units
+ * one by one while commands run. A command that is about to change a unit preserves it first, copying it
+ * if it is still pending, so that the copy holds the data as of the freeze.
+ */
+class snapshot_copy {
+ public:
+  /* Copies a unit */
+  typedef std::function<void(std::size_t)> copy_function;
+
+  snapshot_copy() = default;
+  snapshot_copy(const snapshot_copy &) = delete;
+  snapshot_copy &operator=(const snapshot_copy &) = delete;
+
+  /**
+   * @brief Start a copy; the partition must be frozen and no copy may be in progress
+   * @param num_units Number of units
+   * @param copy Function copying a unit
+   */
+  void start(std::size_t num_units, copy_function copy);
+
+  /**
+   * @brief Copy the pending units in [begin, end) before a command changes them
+   * @param begin Begin unit
+   * @param end End unit, clamped to the number of units
+   */
+  void preserve(std::size_t begin, std::size_t end);
+
+  /**
+   * @brief Copy the pending units overlapping a byte range before a command changes it
+   * @param offset Range offset
+   * @param len Range length
+   * @param unit_size Number of bytes per unit
+   */
+  void preserve_bytes(std::size_t offset, std::size_t len, std::size_t unit_size);
+
+  /**
+   * @brief Copy all pending units before a command changes them
+   */
+  void preserve_all();
+
+  /**
+   * @brief Copy the next pending unit
+   * @return Bool value, false if no unit was pending
+   */
+  bool copy_next();
+
+  /**
+   * @brief Check if a copy is in progress
+   * @return Bool value, true if units are pending
+   */
+  bool active() const;
+
+ private:
+  /**
+   * @brief Copy a unit if it is pending; the mutex must be held
+   * @param unit Unit
+   */
+  void copy_unit(std::size_t unit);
+
+  /* Mutex serializing unit copies */
+  std::mutex mtx_;
+  /* Pending flag of each unit */
+  std::vector<bool> pending_;
+  /* Number of pending units, read without the mutex by commands when no copy is in progress */
+  std::atomic<std::size_t> num_pending_{0};
+  /* Lowest unit that may be pending */
+  std::size_t next_{0};
+  /* Function copying a unit */
+  copy_function copy_;
+};
+
+}
+}
+
+#endif //JIFFY_SNAPSHOT_COPY_H
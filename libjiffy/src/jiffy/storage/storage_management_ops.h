@@ -29,6 +29,10 @@ class storage_management_ops {
 
   virtual void destroy_partition(const std::string &block_id) = 0;
 
+  virtual void freeze_partition(const std::string &block_id) = 0;
+
+  virtual void thaw_partition(const std::string &block_id) = 0;
+
   virtual std::string path(const std::string &block_id) = 0;
 
   virtual void load(const std::string &block_id, const std::string &backing_path) = 0;
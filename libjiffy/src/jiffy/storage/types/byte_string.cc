@@ -52,130 +52,189 @@ std::string immutable_byte_string::to_string() const {
   return str;
 }
 
+constexpr size_t byte_string::INLINE_CAPACITY;
+constexpr uint8_t byte_string::HEAP_TAG;
+constexpr uint8_t byte_string::VIEW_TAG;
+
 byte_string::byte_string(const binary_allocator &allocator)
-    : size_(0),
-      allocator_(allocator),
-      data_(allocator_.allocate(size_)) {
+    : allocator_(allocator) {
+  set_empty();
 }
 
 byte_string::byte_string(const std::string &str, const binary_allocator &allocator)
-    : size_(str.length()),
-      allocator_(allocator) {
-  data_ = allocator_.allocate(size_);
-  memcpy(data_, str.c_str(), str.length());
+    : allocator_(allocator) {
+  init(reinterpret_cast<const uint8_t *>(str.data()), str.length());
+}
+
+byte_string::byte_string(const uint8_t *data, size_t size, const binary_allocator &allocator)
+    : allocator_(allocator) {
+  init(data, size);
 }
 
 byte_string::byte_string(const byte_string &other)
-    : size_(other.size_),
-      allocator_(other.allocator_),
-      data_(allocator_.allocate(size_)) {
-  memcpy(data_, other.data_, size_);
+    : allocator_(other.allocator_) {
+  init(other.data(), other.size());
 }
 
 byte_string::byte_string(byte_string &&other)
-    : size_(other.size_),
-      allocator_(other.allocator_),
-      data_(other.data_) {
-  other.size_ = 0;
-  other.data_ = nullptr;
+    : allocator_(other.allocator_),
+      rep_(other.rep_) {
+  other.set_empty();
 }
 
 byte_string::~byte_string() {
-  allocator_.deallocate(data_, size_);
+  release();
 }
 
 uint8_t &byte_string::operator[](size_t idx) {
-  return data_[idx];
+  return data()[idx];
 }
 
 uint8_t byte_string::operator[](size_t idx) const {
-  return data_[idx];
+  return data()[idx];
 }
 
 bool byte_string::operator<(const byte_string &other) const {
-  return memcmp(data_, other.data_, std::min(size_, other.size_)) < 0;
+  return memcmp(data(), other.data(), std::min(size(), other.size())) < 0;
 }
 
 bool byte_string::operator<=(const byte_string &other) const {
-  return memcmp(data_, other.data_, std::min(size_, other.size_)) <= 0;
+  return memcmp(data(), other.data(), std::min(size(), other.size())) <= 0;
 }
 
 bool byte_string::operator>(const byte_string &other) const {
-  return memcmp(data_, other.data_, std::min(size_, other.size_)) > 0;
+  return memcmp(data(), other.data(), std::min(size(), other.size())) > 0;
 }
 
 bool byte_string::operator>=(const byte_string &other) const {
-  return memcmp(data_, other.data_, std::min(size_, other.size_)) >= 0;
+  return memcmp(data(), other.data(), std::min(size(), other.size())) >= 0;
 }
 
 bool byte_string::operator==(const byte_string &other) const {
-  return memcmp(data_, other.data_, std::min(size_, other.size_)) == 0;
+  return memcmp(data(), other.data(), std::min(size(), other.size())) == 0;
 }
 
 bool byte_string::operator!=(const byte_string &other) const {
-  return memcmp(data_, other.data_, std::min(size_, other.size_)) != 0;
+  return memcmp(data(), other.data(), std::min(size(), other.size())) != 0;
 }
 
 byte_string &byte_string::operator++() {
-  int64_t idx = static_cast<int64_t>(size_ - 1);
-  while (data_[idx] == UINT8_MAX) {
-    data_[idx] = 0;
+  auto bytes = data();
+  int64_t idx = static_cast<int64_t>(size() - 1);
+  while (bytes[idx] == UINT8_MAX) {
+    bytes[idx] = 0;
     idx--;
   }
   if (idx >= 0)
-    data_[idx]++;
+    bytes[idx]++;
   return *this;
 }
 
 byte_string &byte_string::operator--() {
-  int64_t idx = static_cast<int64_t>(size_ - 1);
-  while (data_[idx] == 0) {
-    data_[idx] = UINT8_MAX;
+  auto bytes = data();
+  int64_t idx = static_cast<int64_t>(size() - 1);
+  while (bytes[idx] == 0) {
+    bytes[idx] = UINT8_MAX;
     idx--;
   }
   if (idx >= 0)
-    data_[idx]--;
+    bytes[idx]--;
   return *this;
 }
 
 byte_string &byte_string::operator=(const byte_string &other) {
-  size_ = other.size_;
-  allocator_ = other.allocator_;
-  data_ = allocator_.allocate(size_);
-  memcpy(data_, other.data_, size_);
+  if (this != &other) {
+    release();
+    set_empty();
+    allocator_ = other.allocator_;
+    init(other.data(), other.size());
+  }
   return *this;
 }
 
 immutable_byte_string byte_string::copy() const {
-  return immutable_byte_string(data_, size_);
+  return immutable_byte_string(data(), size());
 }
 
 uint8_t *byte_string::data() const {
-  return data_;
+  return is_inline() ? const_cast<uint8_t *>(rep_.bytes) : rep_.heap.data;
 }
 
 size_t byte_string::size() const {
-  return size_;
+  return is_inline() ? tag() : rep_.heap.size;
+}
+
+bool byte_string::is_inline() const {
+  return tag() <= INLINE_CAPACITY;
 }
 
 std::string byte_string::to_string() const {
+  auto bytes = data();
   std::string str = "{";
   size_t i;
-  for (i = 0; i < size_ - 1; i++) {
-    str += std::to_string(data_[i]) + ", ";
+  for (i = 0; i < size() - 1; i++) {
+    str += std::to_string(bytes[i]) + ", ";
   }
-  str += std::to_string(data_[i]) + "}";
+  str += std::to_string(bytes[i]) + "}";
   return str;
 }
 
 byte_string &byte_string::operator=(byte_string &&other) {
-  size_ = other.size_;
-  allocator_ = other.allocator_;
-  data_ = other.data_;
-  other.size_ = 0;
-  other.data_ = nullptr;
+  if (this != &other) {
+    release();
+    allocator_ = other.allocator_;
+    rep_ = other.rep_;
+    other.set_empty();
+  }
   return *this;
 }
 
+std::pair<byte_string, byte_string> byte_string::make_pair(const std::string &key,
+                                                           const std::string &value,
+                                                           const binary_allocator &allocator) {
+  if (key.size() <= INLINE_CAPACITY || value.size() <= INLINE_CAPACITY || value.size() > UINT32_MAX) {
+    return std::make_pair(byte_string(key, allocator), byte_string(value, allocator));
+  }
+  byte_string k(allocator), v(allocator);
+  auto data = k.allocator_.allocate(key.size() + value.size());
+  memcpy(data, key.data(), key.size());
+  memcpy(data + key.size(), value.data(), value.size());
+  k.set_heap(data, key.size(), static_cast<uint32_t>(value.size()), HEAP_TAG);
+  v.set_heap(data + key.size(), value.size(), 0, VIEW_TAG);
+  return std::make_pair(std::move(k), std::move(v));
+}
+
+uint8_t byte_string::tag() const {
+  return rep_.bytes[INLINE_CAPACITY];
+}
+
+void byte_string::init(const uint8_t *data, size_t size) {
+  if (size <= INLINE_CAPACITY) {
+    if (size > 0)
+      memcpy(rep_.bytes, data, size);
+    rep_.bytes[INLINE_CAPACITY] = static_cast<uint8_t>(size);
+  } else {
+    auto ptr = allocator_.allocate(size);
+    memcpy(ptr, data, size);
+    set_heap(ptr, size, 0, HEAP_TAG);
+  }
+}
+
+void byte_string::set_heap(uint8_t *data, size_t size, uint32_t tail, uint8_t tag) {
+  rep_.heap = heap_rep{data, size, tail};
+  // The tag lives in the padding of heap_rep, so it is written last
+  rep_.bytes[INLINE_CAPACITY] = tag;
+}
+
+void byte_string::set_empty() {
+  rep_.bytes[INLINE_CAPACITY] = 0;
+}
+
+void byte_string::release() {
+  if (tag() == HEAP_TAG) {
+    allocator_.deallocate(rep_.heap.data, rep_.heap.size + rep_.heap.tail);
+  }
+}
+
 }
 }
\ No newline at end of file
@@ -236,6 +236,14 @@ class byte_string {
    */
   byte_string(const std::string &str, const binary_allocator &allocator);
 
+  /**
+   * Constructs a byte_string from a sequence of bytes
+   * @param data Pointer to the bytes to copy from
+   * @param size Number of bytes
+   * @param allocator Allocator
+   */
+  byte_string(const uint8_t *data, size_t size, const binary_allocator &allocator);
+
   /**
    * Constructs a byte_string from another byte_string
    * @param other A reference to the other byte_string to copy from
@@ -367,14 +375,14 @@ class byte_string {
   inline T as() const {
     T val;
 #if JIFFY_ENDIANNESS == JIFFY_BIG_ENDIAN
-    val = *reinterpret_cast<T *>(data_);
+    val = *reinterpret_cast<T *>(data());
 #elif JIFFY_ENDIANNESS == JIFFY_LITTLE_ENDIAN
-    val = jiffy::utils::byte_utils::reverse_as<T>(data_, size_);
+    val = jiffy::utils::byte_utils::reverse_as<T>(data(), size());
 #else
     if (jiffy::utils::byte_utils::is_big_endian()) {
-      val = *reinterpret_cast<T*>(data_);
+      val = *reinterpret_cast<T*>(data());
     } else {
-      val = jiffy::utils::byte_utils::reverse_as<T>(data_, size_);
+      val = jiffy::utils::byte_utils::reverse_as<T>(data(), size());
     }
 #endif
     return val;
@@ -390,6 +398,27 @@ class byte_string {
 
   size_t size() const;
 
+  /**
+   * Checks if the bytes are stored inline in the byte_string object
+   * @return True if no allocation backs the byte_string
+   */
+  bool is_inline() const;
+
+  /**
+   * Constructs a key and a value byte_string backed by one contiguous
+   * allocation owned by the key. The value borrows the tail of the key's
+   * allocation, so it must not outlive the key; copies of the value own
+   * their data. Strings short enough to be stored inline are not
+   * co-allocated.
+   * @param key Key bytes
+   * @param value Value bytes
+   * @param allocator Allocator for the shared allocation
+   * @return Key and value byte_strings
+   */
+  static std::pair<byte_string, byte_string> make_pair(const std::string &key,
+                                                       const std::string &value,
+                                                       const binary_allocator &allocator);
+
   /**
    * Formats the data into a readable form
    * @return A string representation of the data
@@ -397,9 +426,35 @@ class byte_string {
   std::string to_string() const;
 
  private:
-  size_t size_;
+  /* Maximum number of bytes stored inline */
+  static constexpr size_t INLINE_CAPACITY = 23;
+  /* Tag for byte_strings that own an out of line allocation */
+  static constexpr uint8_t HEAP_TAG = 0xFF;
+  /* Tag for byte_strings that borrow the tail of a co-allocated key */
+  static constexpr uint8_t VIEW_TAG = 0xFE;
+
+  /* Out of line representation */
+  struct heap_rep {
+    uint8_t *data;
+    size_t size;
+    /* Bytes allocated after data for a co-allocated value */
+    uint32_t tail;
+  };
+
+  /* The last byte holds the inline size, or a tag for out of line representations */
+  union rep {
+    heap_rep heap;
+    uint8_t bytes[INLINE_CAPACITY + 1];
+  };
+
+  uint8_t tag() const;
+  void init(const uint8_t *data, size_t size);
+  void set_heap(uint8_t *data, size_t size, uint32_t tail, uint8_t tag);
+  void set_empty();
+  void release();
+
   binary_allocator allocator_;
-  uint8_t *data_;
+  rep rep_;
 };
 
 }
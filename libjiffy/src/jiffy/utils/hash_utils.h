@@ -0,0 +1,113 @@
+#ifndef JIFFY_HASH_UTILS_H
+#define JIFFY_HASH_UTILS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace jiffy {
+namespace utils {
+
+/* Hash utility class */
+class hash_utils {
+ public:
+  /**
+   * @brief 64-bit hash of a byte sequence (wyhash construction)
+   * Inputs up to 16 bytes are read with at most four overlapping loads; longer
+   * inputs are consumed 48 bytes at a time in three independent multiply-mix lanes.
+   * @param data Data
+   * @param len Data length
+   * @param seed Seed
+   * @return Hash value
+   */
+  static uint64_t hash64(const void *data, std::size_t len, uint64_t seed = 0) {
+    auto p = static_cast<const uint8_t *>(data);
+    seed ^= mix(seed ^ SECRET0, SECRET1);
+    uint64_t a, b;
+    if (len <= 16) {
+      if (len >= 4) {
+        a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+        b = (read32(p + len - 4) << 32) | read32(p + len - 4 - ((len >> 3) << 2));
+      } else if (len > 0) {
+        a = (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+        b = 0;
+      } else {
+        a = b = 0;
+      }
+    } else {
+      std::size_t i = len;
+      if (i > 48) {
+        uint64_t seed1 = seed, seed2 = seed;
+        do {
+          seed = mix(read64(p) ^ SECRET1, read64(p + 8) ^ seed);
+          seed1 = mix(read64(p + 16) ^ SECRET2, read64(p + 24) ^ seed1);
+          seed2 = mix(read64(p + 32) ^ SECRET3, read64(p + 40) ^ seed2);
+          p += 48;
+          i -= 48;
+        } while (i > 48);
+        seed ^= seed1 ^ seed2;
+      }
+      while (i > 16) {
+        seed = mix(read64(p) ^ SECRET1, read64(p + 8) ^ seed);
+        i -= 16;
+        p += 16;
+      }
+      a = read64(p + i - 16);
+      b = read64(p + i - 8);
+    }
+    a ^= SECRET1;
+    b ^= seed;
+    multiply(a, b);
+    return mix(a ^ SECRET0 ^ len, b ^ SECRET1);
+  }
+
+ private:
+  /**
+   * @brief Full 64x64 -> 128 bit multiply, low half in a and high half in b
+   */
+  static void multiply(uint64_t &a, uint64_t &b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = a;
+    r *= b;
+    a = static_cast<uint64_t>(r);
+    b = static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    a = lo;
+    b = hi;
+#endif
+  }
+
+  static uint64_t mix(uint64_t a, uint64_t b) {
+    multiply(a, b);
+    return a ^ b;
+  }
+
+  static uint64_t read64(const uint8_t *p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  static uint64_t read32(const uint8_t *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  /* Mixing constants */
+  static constexpr uint64_t SECRET0 = 0x2d358dccaa6c78a5ULL;
+  static constexpr uint64_t SECRET1 = 0x8bb84b93962eacc9ULL;
+  static constexpr uint64_t SECRET2 = 0x4b33a62ed433d4a3ULL;
+  static constexpr uint64_t SECRET3 = 0x4d5a2da51de1aa47ULL;
+};
+
+}
+}
+
+#endif //JIFFY_HASH_UTILS_H
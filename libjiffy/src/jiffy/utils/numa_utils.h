@@ -0,0 +1,220 @@
+#ifndef JIFFY_NUMA_UTILS_H
+#define JIFFY_NUMA_UTILS_H
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace jiffy {
+namespace utils {
+
+/**
+ * @brief NUMA topology and placement, through sysfs and the memory policy system calls, so that
+ * no NUMA library is needed. On hosts without NUMA support every call is a no-op.
+ */
+class numa_utils {
+ public:
+  /* Memory policies, as defined by the kernel */
+  static const int MPOL_DEFAULT_POLICY = 0;
+  static const int MPOL_PREFERRED_POLICY = 1;
+  /* Flag looking up the policy of an address rather than of the calling thread */
+  static const int MPOL_F_ADDR_FLAG = 2;
+  /* Number of nodes in the masks read from the kernel */
+  static const std::size_t MAX_NODES = 1024;
+
+  /**
+   * @brief Fetch the online NUMA nodes
+   * @return Node identifiers, a single node 0 if the host does not expose NUMA topology
+   */
+  static inline std::vector<int> nodes() {
+    auto nodes = parse_list(read_line("/sys/devices/system/node/online"));
+    if (nodes.empty()) {
+      nodes.push_back(0);
+    }
+    return nodes;
+  }
+
+  /**
+   * @brief Fetch the CPUs of a NUMA node
+   * @param node Node identifier
+   * @return CPU identifiers, empty if the node is unknown
+   */
+  static inline std::vector<int> node_cpus(int node) {
+    return parse_list(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+  }
+
+  /**
+   * @brief Pin the calling thread to the CPUs of a NUMA node; threads it creates afterwards inherit
+   * the affinity
+   * @param node Node identifier
+   * @return 0 on success, an error number otherwise
+   */
+  static inline int set_self_node_affinity(int node) {
+    auto cpus = node_cpus(node);
+    if (cpus.empty()) {
+      return EINVAL;
+    }
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (auto cpu: cpus) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &cpuset);
+      }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+  }
+
+  /**
+   * @brief Prefer a NUMA node for the pages of a memory range that are not faulted in yet
+   * @param addr Page aligned start of the range
+   * @param len Range length
+   * @param node Node identifier
+   * @return 0 on success, an error number otherwise
+   */
+  static inline int bind_memory(void *addr, std::size_t len, int node) {
+    std::vector<unsigned long> mask;
+    auto maxnode = node_mask(node, mask);
+    if (syscall(SYS_mbind, addr, len, MPOL_PREFERRED_POLICY, mask.data(), maxnode, 0) != 0) {
+      return errno;
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Fetch the NUMA node preferred for the pages of a memory range
+   * @param addr Address within the range
+   * @return Node identifier, -1 if the range has no preferred node
+   */
+  static inline int preferred_node(void *addr) {
+    const std::size_t bits = sizeof(unsigned long) * CHAR_BIT;
+    std::vector<unsigned long> mask(MAX_NODES / bits, 0);
+    int mode = -1;
+    if (syscall(SYS_get_mempolicy, &mode, mask.data(), MAX_NODES, addr, MPOL_F_ADDR_FLAG) != 0
+        || mode != MPOL_PREFERRED_POLICY) {
+      return -1;
+    }
+    for (std::size_t node = 0; node < MAX_NODES; ++node) {
+      if ((mask[node / bits] >> (node % bits)) & 1UL) {
+        return static_cast<int>(node);
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Prefer a NUMA node for the memory the calling thread faults in
+   * @param node Node identifier, negative to restore the default policy
+   * @return 0 on success, an error number otherwise
+   */
+  static inline int set_self_preferred_node(int node) {
+    long ret;
+    if (node < 0) {
+      ret = syscall(SYS_set_mempolicy, MPOL_DEFAULT_POLICY, nullptr, 0);
+    } else {
+      std::vector<unsigned long> mask;
+      auto maxnode = node_mask(node, mask);
+      ret = syscall(SYS_set_mempolicy, MPOL_PREFERRED_POLICY, mask.data(), maxnode);
+    }
+    return ret != 0 ? errno : 0;
+  }
+
+ private:
+  /**
+   * @brief Build the node mask of a single node
+   * @param node Node identifier
+   * @param mask Node mask
+   * @return Maximum node number to pass along with the mask
+   */
+  static inline unsigned long node_mask(int node, std::vector<unsigned long> &mask) {
+    const std::size_t bits = sizeof(unsigned long) * CHAR_BIT;
+    mask.assign(static_cast<std::size_t>(node) / bits + 1, 0);
+    mask[static_cast<std::size_t>(node) / bits] |= 1UL << (static_cast<std::size_t>(node) % bits);
+    // The kernel ignores the last bit of the mask
+    return mask.size() * bits + 1;
+  }
+
+  /**
+   * @brief Read the first line of a file
+   * @param path File path
+   * @return First line, empty if the file cannot be read
+   */
+  static inline std::string read_line(const std::string &path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+  }
+
+  /**
+   * @brief Parse a sysfs list, e.g. "0-3,8-11"
+   * @param list List
+   * @return List elements
+   */
+  static inline std::vector<int> parse_list(const std::string &list) {
+    std::vector<int> elements;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+      if (range.empty()) {
+        continue;
+      }
+      auto dash = range.find('-');
+      try {
+        auto first = std::stoi(range.substr(0, dash));
+        auto last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (auto i = first; i <= last; ++i) {
+          elements.push_back(i);
+        }
+      } catch (std::exception &) {
+        return {};
+      }
+    }
+    return elements;
+  }
+};
+
+/**
+ * @brief Prefers a NUMA node for the memory the calling thread faults in, until it goes out of scope
+ */
+class numa_node_scope {
+ public:
+  /**
+   * @brief Constructor
+   * @param node Node identifier, negative to leave the policy unchanged
+   */
+  explicit numa_node_scope(int node) : node_(node) {
+    if (node_ >= 0) {
+      numa_utils::set_self_preferred_node(node_);
+    }
+  }
+
+  /**
+   * @brief Destructor, restores the default policy
+   */
+  ~numa_node_scope() {
+    if (node_ >= 0) {
+      numa_utils::set_self_preferred_node(-1);
+    }
+  }
+
+  numa_node_scope(const numa_node_scope &) = delete;
+  numa_node_scope &operator=(const numa_node_scope &) = delete;
+
+ private:
+  /* Node identifier */
+  int node_;
+};
+
+}
+}
+
+#endif /* JIFFY_NUMA_UTILS_H */
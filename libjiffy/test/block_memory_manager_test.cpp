@@ -0,0 +1,186 @@
+#include "catch.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "jiffy/storage/block_memory_manager.h"
+#include "jiffy/utils/numa_utils.h"
+
+using namespace ::jiffy::storage;
+using namespace ::jiffy::utils;
+
+TEST_CASE("block_memory_manager_capacity_test", "[malloc][free]") {
+  for (auto allocator: {"default", "slab", "arena"}) {
+    block_memory_manager manager(100 * 64, "DRAM", nullptr, allocator);
+    std::vector<std::thread> threads;
+    std::vector<std::vector<void *>> allocated(8);
+    std::atomic<bool> overshot(false);
+    for (std::size_t i = 0; i < allocated.size(); ++i) {
+      threads.emplace_back([&manager, &allocated, &overshot, i] {
+        void *ptr;
+        while ((ptr = manager.mb_malloc(64)) != nullptr) {
+          allocated[i].push_back(ptr);
+          if (manager.mb_used() > manager.mb_capacity()) {
+            overshot = true;
+          }
+        }
+      });
+    }
+    for (auto &t: threads) {
+      t.join();
+    }
+    REQUIRE_FALSE(overshot.load());
+    // Concurrent allocations fill the capacity exactly, without overshooting it
+    std::size_t num_allocated = 0;
+    for (const auto &ptrs: allocated) {
+      num_allocated += ptrs.size();
+    }
+    REQUIRE(num_allocated == 100);
+    REQUIRE(manager.mb_used() == manager.mb_capacity());
+    REQUIRE(manager.mb_malloc(1) == nullptr);
+    for (const auto &ptrs: allocated) {
+      for (auto ptr: ptrs) {
+        manager.mb_free(ptr, 64);
+      }
+    }
+    REQUIRE(manager.mb_used() == 0);
+  }
+}
+
+TEST_CASE("block_memory_manager_arena_test", "[malloc][free][release]") {
+  block_memory_manager manager(134217728, "DRAM", nullptr, "arena");
+  block_memory_manager other(134217728, "DRAM", nullptr, "arena");
+  std::vector<void *> ptrs;
+  for (std::size_t i = 0; i < 1000; ++i) {
+    ptrs.push_back(manager.mb_malloc(100 + i));
+    REQUIRE(ptrs.back() != nullptr);
+  }
+  auto other_ptr = other.mb_malloc(1000);
+  REQUIRE(other_ptr != nullptr);
+  auto used = manager.mb_used();
+  REQUIRE(used >= 1000 * 100);
+
+  auto stats = manager.mb_stats();
+  REQUIRE(stats.used == used);
+  REQUIRE(stats.active >= stats.used);
+  REQUIRE(stats.fragmentation() >= 0.0);
+  REQUIRE(stats.fragmentation() < 1.0);
+
+  // Freeing every other object leaves holes in the pages of the arena
+  for (std::size_t i = 0; i < ptrs.size(); i += 2) {
+    manager.mb_free(ptrs[i]);
+  }
+  REQUIRE(manager.mb_used() < used);
+  REQUIRE(manager.mb_stats().fragmentation() > stats.fragmentation());
+
+  // Releasing the arena drops the remaining objects at once, and only those of this block
+  manager.mb_release();
+  REQUIRE(manager.mb_used() == 0);
+  REQUIRE(manager.mb_stats().active == 0);
+  REQUIRE(other.mb_used() >= 1000);
+  other.mb_free(other_ptr, 1000);
+  REQUIRE(other.mb_used() == 0);
+
+  // The arena serves new allocations after the release
+  auto ptr = manager.mb_malloc(100);
+  REQUIRE(ptr != nullptr);
+  manager.mb_free(ptr, 100);
+  REQUIRE(manager.mb_used() == 0);
+}
+
+TEST_CASE("block_memory_manager_begin_release_test", "[malloc][free][release]") {
+  for (auto allocator: {"slab", "arena"}) {
+    block_memory_manager manager(134217728, "DRAM", nullptr, allocator);
+    std::vector<void *> ptrs;
+    for (std::size_t i = 0; i < 100; ++i) {
+      ptrs.push_back(manager.mb_malloc(64));
+      REQUIRE(ptrs.back() != nullptr);
+    }
+
+    // Frees while marked for release are only accounted
+    manager.mb_begin_release();
+    for (std::size_t i = 0; i < 50; ++i) {
+      manager.mb_free(ptrs[i], 64);
+    }
+    REQUIRE(manager.mb_used() == 50 * 64);
+    manager.mb_cancel_release();
+    for (std::size_t i = 50; i < 100; ++i) {
+      manager.mb_free(ptrs[i], 64);
+    }
+    REQUIRE(manager.mb_used() == 0);
+
+    manager.mb_begin_release();
+    auto ptr = manager.mb_malloc(64);
+    REQUIRE(ptr != nullptr);
+    manager.mb_free(ptr);
+    manager.mb_release();
+    REQUIRE(manager.mb_used() == 0);
+    REQUIRE(manager.mb_stats().active == 0);
+    REQUIRE(manager.mb_reserved() == 0);
+
+    // The release clears the mark
+    ptr = manager.mb_malloc(64);
+    REQUIRE(ptr != nullptr);
+    manager.mb_free(ptr, 64);
+    REQUIRE(manager.mb_used() == 0);
+  }
+}
+
+TEST_CASE("block_memory_manager_huge_pages_test", "[malloc][free]") {
+  REQUIRE_THROWS_AS(block_memory_manager(134217728, "DRAM", nullptr, "default", "huge"), std::invalid_argument);
+  for (auto huge_pages: {"transparent", "explicit"}) {
+    block_memory_manager manager(8 * block_memory_manager::HUGE_PAGE_SIZE, "DRAM", nullptr, "default", huge_pages);
+    auto size = 4 * block_memory_manager::HUGE_PAGE_SIZE + 1;
+    auto region = static_cast<char *>(manager.mb_malloc(size));
+    REQUIRE(region != nullptr);
+    REQUIRE(reinterpret_cast<uintptr_t>(region) % block_memory_manager::HUGE_PAGE_SIZE == 0);
+    REQUIRE(manager.mb_used() == size);
+    region[0] = 'a';
+    region[size - 1] = 'b';
+    REQUIRE(manager.mb_malloc(4 * block_memory_manager::HUGE_PAGE_SIZE) == nullptr);
+
+    // Small allocations still come from the allocator
+    auto small = manager.mb_malloc(100);
+    REQUIRE(small != nullptr);
+    manager.mb_free(small, 100);
+    small = manager.mb_malloc(128);
+    manager.mb_free(small);
+    REQUIRE(manager.mb_used() == size);
+    manager.mb_free(region, size);
+    REQUIRE(manager.mb_used() == 0);
+
+    // Unsized frees skip the regions while none is mapped
+    small = manager.mb_malloc(128);
+    manager.mb_free(small);
+    REQUIRE(manager.mb_used() == 0);
+
+    region = static_cast<char *>(manager.mb_malloc(block_memory_manager::HUGE_PAGE_SIZE));
+    REQUIRE(region != nullptr);
+    manager.mb_free(region);
+    REQUIRE(manager.mb_used() == 0);
+  }
+}
+
+TEST_CASE("block_memory_manager_numa_test", "[malloc][free]") {
+  auto nodes = numa_utils::nodes();
+  REQUIRE_FALSE(nodes.empty());
+  REQUIRE_FALSE(numa_utils::node_cpus(nodes.front()).empty());
+
+  block_memory_manager manager(4 * block_memory_manager::HUGE_PAGE_SIZE, "DRAM", nullptr, "default", "none",
+                               nodes.back());
+  REQUIRE(manager.mb_numa_node() == nodes.back());
+  auto region = static_cast<char *>(manager.mb_map(4 * block_memory_manager::HUGE_PAGE_SIZE));
+  REQUIRE(region != nullptr);
+  region[0] = 'a';
+  region[4 * block_memory_manager::HUGE_PAGE_SIZE - 1] = 'b';
+  manager.mb_unmap(region, 4 * block_memory_manager::HUGE_PAGE_SIZE);
+  REQUIRE(manager.mb_used() == 0);
+
+  // The dedicated arena of the block binds the extents it allocates to the node
+  block_memory_manager arena_manager(4 * block_memory_manager::HUGE_PAGE_SIZE, "DRAM", nullptr, "arena", "none",
+                                     nodes.back());
+  auto object = arena_manager.mb_malloc(1048576);
+  REQUIRE(object != nullptr);
+  REQUIRE(numa_utils::preferred_node(object) == nodes.back());
+  arena_manager.mb_free(object);
+  REQUIRE(arena_manager.mb_used() == 0);
+}
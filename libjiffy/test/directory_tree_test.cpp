@@ -207,6 +207,25 @@ TEST_CASE("path_sync_test", "[file][dir]") {
   REQUIRE(sm->COMMANDS[5] == "sync:0:local://tmp/0");
 }
 
+TEST_CASE("path_consistent_sync_test", "[file][sync]") {
+  auto alloc = std::make_shared<dummy_block_allocator>(4);
+  auto sm = std::make_shared<dummy_storage_manager>();
+  directory_tree tree(alloc, sm);
+  REQUIRE_NOTHROW(tree.create("/sandbox/abcdef/example/a", "testtype", "local://tmp", 2, 1, 0, perms::all(),
+                              {"0", "1"}, {"", ""}));
+  sm->COMMANDS.clear();
+
+  // All partitions are frozen before any is captured, and thawed once all are
+  REQUIRE_NOTHROW(tree.sync("/sandbox/abcdef/example/a", "local://tmp"));
+  REQUIRE(sm->COMMANDS.size() == 6);
+  REQUIRE(sm->COMMANDS[0] == "freeze_partition:0");
+  REQUIRE(sm->COMMANDS[1] == "freeze_partition:1");
+  REQUIRE(sm->COMMANDS[2].find("sync:0:") == 0);
+  REQUIRE(sm->COMMANDS[3].find("sync:1:") == 0);
+  REQUIRE(sm->COMMANDS[4] == "thaw_partition:0");
+  REQUIRE(sm->COMMANDS[5] == "thaw_partition:1");
+}
+
 TEST_CASE("rename_test", "[file][dir]") {
   auto alloc = std::make_shared<dummy_block_allocator>(4);
   auto sm = std::make_shared<dummy_storage_manager>();
@@ -0,0 +1,176 @@
+#include "catch.hpp"
+#include <string>
+#include "jiffy/storage/extent_region.h"
+#include "jiffy/storage/file/file_block.h"
+#include "jiffy/storage/fifoqueue/string_array.h"
+
+using namespace ::jiffy::storage;
+
+TEST_CASE("extent_region_commit_test", "[write][commit]") {
+  const auto extent = extent_region::EXTENT_SIZE;
+  block_memory_manager manager(4 * extent + 100);
+  extent_region region(4 * extent + 100, &manager);
+  REQUIRE(region.size() == 4 * extent + 100);
+  REQUIRE(region.committed() == 0);
+  REQUIRE(manager.mb_used() == 0);
+
+  // Only the extents written to are committed, the rest reads as zeros
+  std::string data(100, 'a');
+  region.write(2 * extent - 50, data.data(), data.size());
+  REQUIRE(region.committed() == 2 * extent);
+  REQUIRE(manager.mb_used() == 2 * extent);
+  REQUIRE(std::string(region.data() + 2 * extent - 50, 100) == data);
+  REQUIRE(region.data()[0] == 0);
+  REQUIRE(region.data()[3 * extent] == 0);
+
+  // The partial last extent accounts for its size only
+  region.write(4 * extent + 99, "b", 1);
+  REQUIRE(region.committed() == 2 * extent + 100);
+
+  // Zeros do not commit extents, and zeroing a whole extent releases it
+  std::string zeros(extent, '\0');
+  region.write(3 * extent, zeros.data(), zeros.size());
+  REQUIRE(region.committed() == 2 * extent + 100);
+  region.write(2 * extent, zeros.data(), zeros.size());
+  REQUIRE(region.committed() == extent + 100);
+  REQUIRE(region.data()[2 * extent] == 0);
+  REQUIRE(region.data()[2 * extent - 1] == 'a');
+
+  REQUIRE_THROWS_AS(region.write(4 * extent + 100, "c", 1), std::invalid_argument);
+}
+
+TEST_CASE("extent_region_release_test", "[write][release][clear]") {
+  const auto extent = extent_region::EXTENT_SIZE;
+  block_memory_manager manager(4 * extent);
+  extent_region region(4 * extent, &manager);
+  std::string data(4 * extent, 'a');
+  region.write(0, data.data(), data.size());
+  REQUIRE(region.committed() == 4 * extent);
+
+  // Only whole extents within the range are released
+  region.release(extent / 2, 2 * extent);
+  REQUIRE(region.committed() == 3 * extent);
+  REQUIRE(region.data()[extent / 2] == 'a');
+  REQUIRE(region.data()[extent] == 0);
+  REQUIRE(region.data()[2 * extent] == 'a');
+
+  region.clear();
+  REQUIRE(region.committed() == 0);
+  REQUIRE(manager.mb_used() == 0);
+  REQUIRE(region.data()[0] == 0);
+  REQUIRE(region.data()[4 * extent - 1] == 0);
+}
+
+TEST_CASE("extent_region_overflow_test", "[write][commit]") {
+  const auto extent = extent_region::EXTENT_SIZE;
+  block_memory_manager manager(4 * extent);
+  extent_region region(4 * extent, &manager);
+  auto ptr = manager.mb_malloc(2 * extent);
+  REQUIRE(ptr != nullptr);
+  region.write(0, "a", 1);
+  region.write(extent, "a", 1);
+  REQUIRE_THROWS_AS(region.write(2 * extent, "a", 1), memory_block_overflow);
+  REQUIRE(region.committed() == 2 * extent);
+  manager.mb_free(ptr, 2 * extent);
+  region.write(2 * extent, "a", 1);
+  REQUIRE(region.committed() == 3 * extent);
+}
+
+TEST_CASE("extent_region_copy_test", "[write][copy]") {
+  const auto extent = extent_region::EXTENT_SIZE;
+  block_memory_manager manager(4 * extent);
+  extent_region region(4 * extent, &manager);
+  region.write(extent + 1, "abc", 3);
+  region.write(3 * extent, "def", 3);
+
+  block_memory_manager copy_manager(4 * extent);
+  extent_region copy(4 * extent, &copy_manager);
+  copy.write(0, "xyz", 3);
+  copy.copy_from(region, 3 * extent);
+  REQUIRE(std::string(copy.data() + extent + 1, 3) == "abc");
+  REQUIRE(std::string(copy.data(), 3) == std::string(3, '\0'));
+  REQUIRE(copy.data()[3 * extent] == 0);
+  REQUIRE(copy.committed() == 2 * extent);
+}
+
+TEST_CASE("extent_region_copy_range_test", "[write][copy]") {
+  const auto extent = extent_region::EXTENT_SIZE;
+  block_memory_manager manager(4 * extent);
+  extent_region region(4 * extent, &manager);
+  region.write(extent - 1, "abc", 3);
+  region.write(3 * extent, "def", 3);
+
+  block_memory_manager copy_manager(4 * extent);
+  extent_region copy(4 * extent, &copy_manager);
+  copy.copy_from(region, extent, extent);
+  REQUIRE(copy.committed() == extent);
+  REQUIRE(copy.data()[extent - 1] == 0);
+  REQUIRE(std::string(copy.data() + extent, 2) == "bc");
+  copy.copy_from(region, 0, extent);
+  copy.copy_from(region, 3 * extent, 3);
+  REQUIRE(copy.committed() == 3 * extent);
+  REQUIRE(std::string(copy.data() + extent - 1, 3) == "abc");
+  REQUIRE(std::string(copy.data() + 3 * extent, 3) == "def");
+}
+
+TEST_CASE("extent_region_block_test", "[write][clear]") {
+  const auto extent = extent_region::EXTENT_SIZE;
+  block_memory_manager manager(4 * extent);
+  {
+    file_block file(manager.mb_capacity(), block_memory_allocator<char>(&manager));
+    REQUIRE(manager.mb_used() == 0);
+    file.write(std::string(100, 'a'), 3 * extent);
+    REQUIRE(manager.mb_used() == extent);
+    REQUIRE(file.read(3 * extent, 100).second == std::string(100, 'a'));
+    REQUIRE(file.read(0, 100).second == std::string(100, '\0'));
+    file.clear();
+    REQUIRE(manager.mb_used() == 0);
+    REQUIRE(file.read(3 * extent, 100).second == std::string(100, '\0'));
+  }
+  {
+    string_array queue(manager.mb_capacity(), block_memory_allocator<char>(&manager));
+    std::string item(extent, 'a');
+    REQUIRE(queue.push_back(item).first);
+    REQUIRE(queue.push_back(item).first);
+    REQUIRE(manager.mb_used() == 3 * extent);
+    REQUIRE(queue.at(0).second == item);
+    queue.clear();
+    REQUIRE(manager.mb_used() == 0);
+    REQUIRE(queue.empty());
+  }
+  REQUIRE(manager.mb_used() == 0);
+}
+
+TEST_CASE("extent_region_string_array_release_test", "[write][release]") {
+  const auto extent = extent_region::EXTENT_SIZE;
+  block_memory_manager manager(4 * extent);
+  string_array queue(manager.mb_capacity(), block_memory_allocator<char>(&manager));
+  std::size_t item_size = extent / 4 - string_array::METADATA_LEN;
+  for (char c = 'a'; c < 'a' + 12; ++c) {
+    REQUIRE(queue.push_back(std::string(item_size, c)).first);
+  }
+  REQUIRE(manager.mb_used() == 3 * extent);
+
+  // Dropping strings within the first extent keeps it
+  queue.release_before(extent / 2);
+  REQUIRE(manager.mb_used() == 3 * extent);
+  REQUIRE(queue.begin_offset() == extent / 2);
+  REQUIRE(*queue.begin() == std::string(item_size, 'c'));
+
+  // Dropping strings up to the middle of the third extent releases the first two
+  queue.release_before(2 * extent + extent / 4);
+  REQUIRE(manager.mb_used() == extent);
+  REQUIRE(queue.at(2 * extent + extent / 4).second == std::string(item_size, 'j'));
+  std::string remaining;
+  for (auto it = queue.begin(); it != queue.end(); it++) {
+    remaining += (*it)[0];
+  }
+  REQUIRE(remaining == "jkl");
+
+  // Dropping every string leaves nothing to iterate over
+  queue.release_before(queue.size());
+  REQUIRE(manager.mb_used() == 0);
+  REQUIRE(queue.begin() == queue.end());
+  queue.clear();
+  REQUIRE(queue.begin_offset() == 0);
+}
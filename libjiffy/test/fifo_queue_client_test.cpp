@@ -10,10 +10,12 @@
 #include "jiffy/storage/fifoqueue/fifo_queue_partition.h"
 #include "jiffy/storage/service/block_server.h"
 #include "jiffy/storage/client/fifo_queue_client.h"
+#include "jiffy/auto_scaling/auto_scaling_server.h"
 
 
 using namespace ::jiffy::storage;
 using namespace ::jiffy::directory;
+using namespace ::jiffy::auto_scaling;
 using namespace ::apache::thrift::transport;
 
 #define NUM_BLOCKS 1
@@ -21,6 +23,7 @@ using namespace ::apache::thrift::transport;
 #define DIRECTORY_SERVICE_PORT 9090
 #define STORAGE_SERVICE_PORT 9091
 #define STORAGE_MANAGEMENT_PORT 9092
+#define AUTO_SCALING_SERVICE_PORT 9095
 
 TEST_CASE("fifo_queue_client_enqueue_dequeue_test", "[enqueue][dequeue]") {
   auto alloc = std::make_shared<sequential_block_allocator>();
@@ -218,3 +221,77 @@ TEST_CASE("fifo_queue_client_enqueue_in_rate_out_rate_dequeue_test", "[enqueue][
     dir_serve_thread.join();
   }
 }
+
+TEST_CASE("fifo_queue_client_pipelined_enqueue_test", "[enqueue][dequeue]") {
+  auto alloc = std::make_shared<sequential_block_allocator>();
+  auto block_names = test_utils::init_block_names(50, STORAGE_SERVICE_PORT, STORAGE_MANAGEMENT_PORT);
+  alloc->add_blocks(block_names);
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  auto blocks = test_utils::init_fifo_queue_blocks(block_names, memory_mode, mem_kind, 100000);
+
+  auto storage_server = block_server::create(blocks, STORAGE_SERVICE_PORT);
+  std::thread storage_serve_thread([&storage_server] { storage_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_SERVICE_PORT);
+
+  auto mgmt_server = storage_management_server::create(blocks, HOST, STORAGE_MANAGEMENT_PORT);
+  std::thread mgmt_serve_thread([&mgmt_server] { mgmt_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_MANAGEMENT_PORT);
+
+  auto as_server = auto_scaling_server::create(HOST, DIRECTORY_SERVICE_PORT, HOST, AUTO_SCALING_SERVICE_PORT);
+  std::thread auto_scaling_thread([&as_server] { as_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, AUTO_SCALING_SERVICE_PORT);
+
+  auto sm = std::make_shared<storage_manager>();
+  auto tree = std::make_shared<directory_tree>(alloc, sm);
+
+  auto dir_server = directory_server::create(tree, HOST, DIRECTORY_SERVICE_PORT);
+  std::thread dir_serve_thread([&dir_server] { dir_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, DIRECTORY_SERVICE_PORT);
+
+  data_status status = tree->create("/sandbox/file.txt", "fifoqueue", "/tmp", NUM_BLOCKS, 1, 0, perms::all(),
+                                    {"0"}, {"regular"}, {});
+
+  fifo_queue_client client(tree, "/sandbox/file.txt", status);
+  client.set_pipeline_depth(8);
+
+  // Items span several partitions, so partitions are sealed with enqueues in flight; the rejected
+  // ones are drained and enqueueing resumes after the redirected item
+  auto item = [](std::size_t i) { return std::string(1000, static_cast<char>('a' + i % 26)) + std::to_string(i); };
+  std::vector<std::string> items;
+  for (std::size_t i = 0; i < 1000; ++i) {
+    items.push_back(item(i));
+  }
+  REQUIRE_NOTHROW(client.pipelined_enqueue(items));
+  REQUIRE(tree->dstatus("/sandbox/file.txt").data_blocks().size() > 1);
+  REQUIRE(client.length() == 1000);
+
+  // Plain enqueues continue after the pipelined ones
+  for (std::size_t i = 1000; i < 1100; ++i) {
+    REQUIRE_NOTHROW(client.enqueue(item(i)));
+  }
+  for (std::size_t i = 0; i < 1100; ++i) {
+    REQUIRE(client.front() == item(i));
+    REQUIRE_NOTHROW(client.dequeue());
+  }
+  REQUIRE_THROWS_AS(client.dequeue(), std::logic_error);
+
+  as_server->stop();
+  if (auto_scaling_thread.joinable()) {
+    auto_scaling_thread.join();
+  }
+
+  storage_server->stop();
+  if (storage_serve_thread.joinable()) {
+    storage_serve_thread.join();
+  }
+
+  mgmt_server->stop();
+  if (mgmt_serve_thread.joinable()) {
+    mgmt_serve_thread.join();
+  }
+  dir_server->stop();
+  if (dir_serve_thread.joinable()) {
+    dir_serve_thread.join();
+  }
+}
@@ -95,3 +95,76 @@ TEST_CASE("fifo_queue_local_enqueue_read_dequeue_binary_test", "[enqueue][dequeu
   }
   remove("/tmp/0");
 }
+
+TEST_CASE("fifo_queue_local_segment_batch_reopen_test", "[enqueue][dequeue][read_next][load]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  for (const auto &serializer: {"csv", "binary"}) {
+    property_map conf;
+    conf.set("fifoqueue.serializer", serializer);
+    conf.set("fifoqueue.ls_segment_size", "64");
+    {
+      fifo_queue_partition block(&manager, "local://tmp", "0", "regular", conf);
+      for (std::size_t i = 0; i < 100; ++i) {
+        response resp;
+        REQUIRE_NOTHROW(block.run_command(resp, {"enqueue", std::to_string(i)}));
+        REQUIRE(resp[0] == "!ok");
+      }
+      REQUIRE(block.sync("local://tmp/0"));
+
+      // Batched enqueue spanning many segments
+      std::vector<std::string> args{"enqueue_ls"};
+      for (std::size_t i = 100; i < 1000; ++i) {
+        args.push_back(std::to_string(i));
+      }
+      response resp;
+      REQUIRE_NOTHROW(block.enqueue_ls(resp, args));
+      REQUIRE(resp[0] == "!ok");
+
+      resp.clear();
+      REQUIRE_NOTHROW(block.read_next_ls(resp, {"read_next_ls", "3"}));
+      REQUIRE(resp == response({"!ok", "0", "1", "2"}));
+
+      resp.clear();
+      REQUIRE_NOTHROW(block.dequeue_ls(resp, {"dequeue_ls", "300"}));
+      REQUIRE(resp.size() == 301);
+      REQUIRE(resp[0] == "!ok");
+      REQUIRE(resp[1] == "0");
+      REQUIRE(resp[300] == "299");
+
+      // Reads do not go back before the head
+      resp.clear();
+      REQUIRE_NOTHROW(block.read_next_ls(resp, {"read_next_ls"}));
+      REQUIRE(resp == response({"!ok", "300"}));
+    }
+
+    // The head cursor survives reopening the queue
+    {
+      fifo_queue_partition block(&manager, "local://tmp", "0", "regular", conf);
+      response resp;
+      REQUIRE_NOTHROW(block.dequeue_ls(resp, {"dequeue_ls"}));
+      REQUIRE(resp == response({"!ok", "300"}));
+    }
+
+    // Loading folds the segments into the file
+    {
+      fifo_queue_partition block(&manager, "local://tmp", "0", "regular", conf);
+      block.load("local://tmp/0");
+      for (std::size_t i = 301; i < 1000; ++i) {
+        response resp;
+        block.run_command(resp, {"dequeue"});
+        REQUIRE(resp[0] == "!ok");
+        REQUIRE(resp[1] == std::to_string(i));
+      }
+      response resp;
+      REQUIRE_NOTHROW(block.dequeue_ls(resp, {"dequeue_ls", "10"}));
+      REQUIRE(resp.size() == 11);
+      REQUIRE(resp[1] == "301");
+    }
+    remove("/tmp/0");
+    remove("/tmp/0_offset");
+    fifo_queue_segment_store(serializer, 64).discard("/tmp/0");
+  }
+}
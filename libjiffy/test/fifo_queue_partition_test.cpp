@@ -4,6 +4,7 @@
 #include "jiffy/storage/fifoqueue/fifo_queue_partition.h"
 #include <vector>
 #include <string>
+#include <fstream>
 
 using namespace ::jiffy::storage;
 using namespace ::jiffy::persistent;
@@ -36,6 +37,76 @@ TEST_CASE("fifo_queue_enqueue_dequeue_test", "[enqueue][dequeue]") {
   }
 }
 
+TEST_CASE("fifo_queue_dequeue_view_test", "[enqueue][dequeue]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  fifo_queue_partition block(&manager);
+
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.enqueue(resp, {"enqueue", std::to_string(i)}));
+    REQUIRE(resp[0] == "!ok");
+  }
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response_view resp1, resp2;
+    REQUIRE_NOTHROW(block.run_command_view(resp1, {"read_next"}));
+    REQUIRE(resp1[0] == "!ok");
+    REQUIRE(resp1[1] == std::to_string(i));
+    REQUIRE_NOTHROW(block.run_command_view(resp2, {"dequeue"}));
+    REQUIRE(resp2[0] == "!ok");
+    REQUIRE(resp2[1].borrowed());
+    REQUIRE(resp2[1] == std::to_string(i));
+  }
+  response_view resp;
+  REQUIRE_NOTHROW(block.run_command_view(resp, {"dequeue"}));
+  REQUIRE(resp[0] == "!msg_not_found");
+}
+
+TEST_CASE("fifo_queue_dequeue_release_test", "[enqueue][dequeue]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  fifo_queue_partition block(&manager);
+
+  const auto extent = extent_region::EXTENT_SIZE;
+  std::size_t item_size = extent / 4 - string_array::METADATA_LEN;
+  for (std::size_t i = 0; i < 12; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.enqueue(resp, {"enqueue", std::string(item_size, 'a' + i)}));
+    REQUIRE(resp[0] == "!ok");
+  }
+  auto used = manager.mb_used();
+  for (std::size_t i = 0; i < 12; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.dequeue(resp, {"dequeue"}));
+    REQUIRE(resp[0] == "!ok");
+    REQUIRE(resp[1] == std::string(item_size, 'a' + i));
+  }
+  if (memory_mode == "DRAM") {
+    // The extents before the last message are released, it may still be borrowed by its response
+    REQUIRE(manager.mb_used() == used - 2 * extent);
+  }
+
+  // Responses still borrowing dequeued messages keep their extents
+  for (std::size_t i = 0; i < 8; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.enqueue(resp, {"enqueue", std::string(item_size, 'a' + i)}));
+  }
+  used = manager.mb_used();
+  {
+    partition::borrow_guard other(block);
+    for (std::size_t i = 0; i < 8; ++i) {
+      response resp;
+      REQUIRE_NOTHROW(block.dequeue(resp, {"dequeue"}));
+      REQUIRE(resp[1] == std::string(item_size, 'a' + i));
+    }
+    REQUIRE(manager.mb_used() == used);
+  }
+}
+
 TEST_CASE("fifo_queue_enqueue_clear_dequeue_test", "[enqueue][dequeue]") {
   
   std::string memory_mode = getenv("JIFFY_TEST_MODE");
@@ -106,6 +177,7 @@ TEST_CASE("fifo_queue_storage_size_test", "[put][size][storage_size][reset]") {
 }
 
 TEST_CASE("fifo_queue_flush_load_test", "[enqueue][sync][reset][load][dequeue]") {
+  temp_directory dir;
   
   std::string memory_mode = getenv("JIFFY_TEST_MODE");
   void* mem_kind = test_utils::init_kind();
@@ -118,10 +190,10 @@ TEST_CASE("fifo_queue_flush_load_test", "[enqueue][sync][reset][load][dequeue]")
     REQUIRE(res.front() == "!ok");
   }
   REQUIRE(block.is_dirty());
-  REQUIRE(block.sync("local://tmp/test"));
+  REQUIRE(block.sync(dir.local_path("test")));
   REQUIRE(!block.is_dirty());
-  REQUIRE_FALSE(block.sync("local://tmp/test"));
-  REQUIRE_NOTHROW(block.load("local://tmp/test"));
+  REQUIRE_FALSE(block.sync(dir.local_path("test")));
+  REQUIRE_NOTHROW(block.load(dir.local_path("test")));
   for (std::size_t i = 0; i < 1000; ++i) {
     response resp1, resp2;
     REQUIRE_NOTHROW(block.front(resp1, {"front"}));
@@ -132,5 +204,38 @@ TEST_CASE("fifo_queue_flush_load_test", "[enqueue][sync][reset][load][dequeue]")
   }
 }
 
+TEST_CASE("fifo_queue_delta_sync_load_test", "[enqueue][dequeue][sync][load]") {
+  temp_directory dir;
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  fifo_queue_partition block(&manager);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    std::vector<std::string> res;
+    block.run_command(res, {"enqueue", std::to_string(i)});
+    REQUIRE(res.front() == "!ok");
+  }
+  REQUIRE(block.sync(dir.local_path("test")));
+  std::vector<std::string> res;
+  block.run_command(res, {"dequeue"});
+  REQUIRE_FALSE(block.sync(dir.local_path("test")));
+  for (std::size_t i = 1000; i < 1010; ++i) {
+    block.run_command(res, {"enqueue", std::to_string(i)});
+    REQUIRE(res.front() == "!ok");
+  }
+  REQUIRE(block.sync(dir.local_path("test")));
+  REQUIRE(std::ifstream(dir.path("test_delta_1")).good());
+
+  fifo_queue_partition loaded(&manager);
+  REQUIRE_NOTHROW(loaded.load(dir.local_path("test")));
+  for (std::size_t i = 0; i < 1010; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(loaded.dequeue(resp, {"dequeue"}));
+    REQUIRE(resp[0] == "!ok");
+    REQUIRE(resp[1] == std::to_string(i));
+  }
+}
+
 
 
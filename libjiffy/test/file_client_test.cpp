@@ -145,6 +145,78 @@ TEST_CASE("file_client_concurrent_write_read_seek_test", "[write][read][seek]")
   REQUIRE(buffer.substr(4096, 4096) == std::string(4096, 'y'));
 
 
+  as_server->stop();
+  if (auto_scaling_thread.joinable()) {
+    auto_scaling_thread.join();
+  }
+
+  storage_server->stop();
+  if (storage_serve_thread.joinable()) {
+    storage_serve_thread.join();
+  }
+
+  mgmt_server->stop();
+  if (mgmt_serve_thread.joinable()) {
+    mgmt_serve_thread.join();
+  }
+
+  dir_server->stop();
+  if (dir_serve_thread.joinable()) {
+    dir_serve_thread.join();
+  }
+}
+
+TEST_CASE("file_client_pipelined_write_test", "[write][read][seek]") {
+  auto alloc = std::make_shared<sequential_block_allocator>();
+  auto block_names = test_utils::init_block_names(20, STORAGE_SERVICE_PORT, STORAGE_MANAGEMENT_PORT);
+  alloc->add_blocks(block_names);
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  auto blocks = test_utils::init_file_blocks(block_names, memory_mode, mem_kind, BLOCK_SIZE);
+  auto storage_server = block_server::create(blocks, STORAGE_SERVICE_PORT);
+  std::thread storage_serve_thread([&storage_server] { storage_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_SERVICE_PORT);
+
+  auto mgmt_server = storage_management_server::create(blocks, HOST, STORAGE_MANAGEMENT_PORT);
+  std::thread mgmt_serve_thread([&mgmt_server] { mgmt_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_MANAGEMENT_PORT);
+
+  auto as_server = auto_scaling_server::create(HOST, DIRECTORY_SERVICE_PORT, HOST, AUTO_SCALING_SERVICE_PORT);
+  std::thread auto_scaling_thread([&as_server] { as_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, AUTO_SCALING_SERVICE_PORT);
+
+  auto sm = std::make_shared<storage_manager>();
+  auto t = std::make_shared<directory_tree>(alloc, sm);
+
+  auto dir_server = directory_server::create(t, HOST, DIRECTORY_SERVICE_PORT);
+  std::thread dir_serve_thread([&dir_server] { dir_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, DIRECTORY_SERVICE_PORT);
+
+  auto status = t->create("/sandbox/scale_up.txt", "file", "/tmp", 5, 1, 0, perms::all(), {"0", "1", "2", "3", "4"}, {"regular", "regular", "regular", "regular", "regular"}, {});
+
+  file_client client(t, "/sandbox/scale_up.txt", status);
+  client.set_pipeline_depth(4);
+
+  // Pieces larger and smaller than a partition, so that writes in flight span partitions
+  std::vector<std::string> data{std::string(1000, 'x'), std::string(3000, 'y'), std::string(500, 'z')};
+  REQUIRE(client.pipelined_write(data) == 4500);
+  std::vector<std::string> small;
+  std::string expected_small;
+  for (std::size_t i = 0; i < 100; ++i) {
+    small.push_back(std::to_string(i));
+    expected_small += std::to_string(i);
+  }
+  REQUIRE(client.pipelined_write(small) == static_cast<int>(expected_small.size()));
+
+  REQUIRE_NOTHROW(client.seek(0));
+  std::string buffer;
+  auto total = 4500 + static_cast<int>(expected_small.size());
+  REQUIRE(client.read(buffer, total) == total);
+  REQUIRE(buffer.substr(0, 1000) == std::string(1000, 'x'));
+  REQUIRE(buffer.substr(1000, 3000) == std::string(3000, 'y'));
+  REQUIRE(buffer.substr(4000, 500) == std::string(500, 'z'));
+  REQUIRE(buffer.substr(4500) == expected_small);
+
   as_server->stop();
   if (auto_scaling_thread.joinable()) {
     auto_scaling_thread.join();
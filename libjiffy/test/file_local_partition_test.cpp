@@ -105,3 +105,40 @@ TEST_CASE("file_ls_write_read_binary_test", "[write][read]") {
   remove("/tmp/0");
 }
 
+TEST_CASE("file_ls_binary_data_test", "[write][read]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  property_map conf;
+  conf.set("file.serializer", "binary");
+  file_partition block(&manager, "local://tmp", "0", "regular", conf);
+
+  response resp;
+  REQUIRE_NOTHROW(block.read_ls(resp, {"read_ls", "0", "1"}));
+  REQUIRE(resp[0] == "!file_does_not_exist");
+
+  resp.clear();
+  REQUIRE_NOTHROW(block.run_command(resp, {"write", "header", "0"}));
+  REQUIRE(block.dump("local://tmp/0"));
+
+  // Data is returned as is, including NUL bytes
+  std::string data("a\0b\0c", 5);
+  resp.clear();
+  REQUIRE_NOTHROW(block.write_ls(resp, {"write_ls", data, "6"}));
+  REQUIRE(resp[0] == "!ok");
+  resp.clear();
+  REQUIRE_NOTHROW(block.read_ls(resp, {"read_ls", "0", "11"}));
+  REQUIRE(resp == response({"!ok", "header" + data}));
+
+  // Reads past the end of the file are cut short
+  resp.clear();
+  REQUIRE_NOTHROW(block.read_ls(resp, {"read_ls", "6", "100"}));
+  REQUIRE(resp == response({"!ok", data}));
+
+  // Writes return the cache blocks they touch
+  resp.clear();
+  REQUIRE_NOTHROW(block.write_ls(resp, {"write_ls", "XY", "4", "4", "11"}));
+  REQUIRE(resp == response({"!ok", std::string("XYa\0", 4)}));
+  remove("/tmp/0");
+}
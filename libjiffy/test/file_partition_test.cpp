@@ -4,6 +4,7 @@
 #include "jiffy/storage/file/file_partition.h"
 #include <vector>
 #include <string>
+#include <fstream>
 
 using namespace ::jiffy::storage;
 using namespace ::jiffy::persistent;
@@ -34,6 +35,23 @@ TEST_CASE("file_write_read_test", "[write][read]") {
   REQUIRE(resp[1] == std::string(std::to_string(1).size(), 0));
 }
 
+TEST_CASE("file_read_view_test", "[write][read]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  file_partition block(&manager);
+  std::string data(1024 * 1024, 'x');
+  response resp;
+  REQUIRE_NOTHROW(block.write(resp, {"write", data, "0"}));
+  REQUIRE(resp[0] == "!ok");
+  response_view view;
+  REQUIRE_NOTHROW(block.run_command_view(view, {"read", "0", std::to_string(data.size())}));
+  REQUIRE(view[0] == "!ok");
+  REQUIRE(view[1].borrowed());
+  REQUIRE(view[1] == data);
+}
+
 TEST_CASE("file_write_clear_read_test", "[write][read]") {
   std::string memory_mode = getenv("JIFFY_TEST_MODE");
   void* mem_kind = test_utils::init_kind();
@@ -80,6 +98,7 @@ TEST_CASE("file_storage_size_test", "[put][size][storage_size][reset]") {
 }
 
 TEST_CASE("file_flush_load_test", "[write][sync][reset][load][read]") {
+  temp_directory dir;
   std::string memory_mode = getenv("JIFFY_TEST_MODE");
   void* mem_kind = test_utils::init_kind();
   size_t capacity = 134217728;
@@ -93,10 +112,10 @@ TEST_CASE("file_flush_load_test", "[write][sync][reset][load][read]") {
     REQUIRE(res.front() == "!ok");
   }
   REQUIRE(block.is_dirty());
-  REQUIRE(block.sync("local://tmp/test"));
+  REQUIRE(block.sync(dir.local_path("test")));
   REQUIRE(!block.is_dirty());
-  REQUIRE_FALSE(block.sync("local://tmp/test"));
-  REQUIRE_NOTHROW(block.load("local://tmp/test"));
+  REQUIRE_FALSE(block.sync(dir.local_path("test")));
+  REQUIRE_NOTHROW(block.load(dir.local_path("test")));
   int read_pos = 0;
   for (std::size_t i = 0; i < 1000; ++i) {
     response resp;
@@ -107,5 +126,31 @@ TEST_CASE("file_flush_load_test", "[write][sync][reset][load][read]") {
   }
 }
 
+TEST_CASE("file_delta_sync_load_test", "[write][sync][load][read]") {
+  temp_directory dir;
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  jiffy::utils::property_map conf;
+  conf.set("file.sync_page_size", "64");
+  file_partition block(&manager, "local://tmp", "0", "regular", conf);
+  std::vector<std::string> res;
+  block.run_command(res, {"write", std::string(4096, 'a'), "0"});
+  REQUIRE(res.front() == "!ok");
+  REQUIRE(block.sync(dir.local_path("test")));
+  block.run_command(res, {"write", std::string(100, 'b'), "1000"});
+  REQUIRE(res.front() == "!ok");
+  REQUIRE(block.sync(dir.local_path("test")));
+  REQUIRE(std::ifstream(dir.path("test_delta_1")).good());
+
+  file_partition loaded(&manager, "local://tmp", "0", "regular", conf);
+  REQUIRE_NOTHROW(loaded.load(dir.local_path("test")));
+  response resp;
+  REQUIRE_NOTHROW(loaded.read(resp, {"read", "0", "4096"}));
+  REQUIRE(resp[0] == "!ok");
+  REQUIRE(resp[1] == std::string(1000, 'a') + std::string(100, 'b') + std::string(2996, 'a'));
+}
+
 
 
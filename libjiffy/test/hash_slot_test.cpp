@@ -0,0 +1,50 @@
+#include "catch.hpp"
+#include <random>
+#include <vector>
+#include "jiffy/storage/hashtable/hash_slot.h"
+#include "jiffy/storage/hashtable/hash_table_defs.h"
+
+using namespace ::jiffy::storage;
+
+TEST_CASE("hash_slot_crc16_check_value_test", "[crc16]") {
+  REQUIRE(hash_slot::crc16_bytewise("123456789", 9) == 0x31C3);
+  REQUIRE(hash_slot::crc16_slice8("123456789", 9) == 0x31C3);
+  REQUIRE(hash_slot::crc16_clmul("123456789", 9) == 0x31C3);
+  REQUIRE(hash_slot::crc16("123456789", 9) == 0x31C3);
+  REQUIRE(hash_slot::crc16("", 0) == 0);
+}
+
+TEST_CASE("hash_slot_crc16_implementations_test", "[crc16]") {
+  std::mt19937 gen(42);
+  std::vector<char> buf(4096);
+  for (auto &c : buf) c = static_cast<char>(gen());
+  for (std::size_t len = 0; len <= 2048; ++len) {
+    std::size_t off = gen() % 64;
+    auto expected = hash_slot::crc16_bytewise(buf.data() + off, len);
+    REQUIRE(hash_slot::crc16_slice8(buf.data() + off, len) == expected);
+    REQUIRE(hash_slot::crc16(buf.data() + off, len) == expected);
+    if (hash_slot::clmul_supported()) {
+      REQUIRE(hash_slot::crc16_clmul(buf.data() + off, len) == expected);
+    }
+  }
+}
+
+TEST_CASE("hash_slot_get_test", "[get]") {
+  block_memory_manager manager;
+  binary_allocator allocator(&manager);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    std::string key = "key" + std::to_string(i) + std::string(i % 100, 'x');
+    auto expected = hash_slot::crc16_bytewise(key.data(), key.size());
+    REQUIRE(hash_slot::get(key) == expected);
+    REQUIRE(hash_slot::get(binary(key, allocator)) == expected);
+  }
+}
+
+TEST_CASE("hash_type_test", "[hash]") {
+  hash_type hash;
+  std::string a = "some key", b = "some key", c = "some kex";
+  REQUIRE(hash(a) == hash(b));
+  REQUIRE(hash(a) != hash(c));
+  REQUIRE(hash(std::string()) == hash(std::string()));
+  REQUIRE(hash(std::string(100, 'a')) != hash(std::string(101, 'a')));
+}
@@ -175,3 +175,229 @@ TEST_CASE("hash_table_client_put_remove_get_test", "[put][remove][get]") {
   }
 }
 
+
+TEST_CASE("hash_table_client_batch_test", "[mput][mget][mupsert][mremove]") {
+  auto alloc = std::make_shared<sequential_block_allocator>();
+  auto block_names = test_utils::init_block_names(NUM_BLOCKS, STORAGE_SERVICE_PORT, STORAGE_MANAGEMENT_PORT);
+  alloc->add_blocks(block_names);
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  auto blocks = test_utils::init_hash_table_blocks(block_names, memory_mode, mem_kind, 134217728, 0, 1);
+  auto storage_server = block_server::create(blocks, STORAGE_SERVICE_PORT);
+  std::thread storage_serve_thread([&storage_server] { storage_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_SERVICE_PORT);
+
+  auto mgmt_server = storage_management_server::create(blocks, HOST, STORAGE_MANAGEMENT_PORT);
+  std::thread mgmt_serve_thread([&mgmt_server] { mgmt_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_MANAGEMENT_PORT);
+
+  auto sm = std::make_shared<storage_manager>();
+  auto tree = std::make_shared<directory_tree>(alloc, sm);
+  data_status status = tree->create("/sandbox/file.txt", "hashtable", "/tmp", NUM_BLOCKS, 1, 0, 0,
+      {"0_21845", "21845_43690", "43690_65536"}, {"regular", "regular", "regular"});
+
+  hash_table_client client(tree, "/sandbox/file.txt", status);
+  std::vector<std::string> keys, values, new_values, values_out;
+  for (std::size_t i = 0; i < 1000; ++i) {
+    keys.push_back(std::to_string(i));
+    values.push_back(std::to_string(i));
+    new_values.push_back(std::to_string(i + 1000));
+  }
+  auto status_put = client.mput(keys, values);
+  REQUIRE(status_put.size() == keys.size());
+  for (const auto &s: status_put) {
+    REQUIRE(s == "!ok");
+  }
+  for (const auto &s: client.mput(keys, values)) {
+    REQUIRE(s == "!duplicate_key");
+  }
+  auto status_get = client.mget(keys, values_out);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    REQUIRE(status_get[i] == "!ok");
+    REQUIRE(values_out[i] == values[i]);
+  }
+  for (const auto &s: client.mupsert(keys, new_values)) {
+    REQUIRE(s == "!ok");
+  }
+  status_get = client.mget(keys, values_out);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    REQUIRE(status_get[i] == "!ok");
+    REQUIRE(values_out[i] == new_values[i]);
+  }
+  for (const auto &s: client.mremove(keys)) {
+    REQUIRE(s == "!ok");
+  }
+  for (const auto &s: client.mget(keys, values_out)) {
+    REQUIRE(s == "!key_not_found");
+  }
+  REQUIRE_THROWS_AS(client.mput(keys, {}), std::invalid_argument);
+
+  storage_server->stop();
+  if (storage_serve_thread.joinable()) {
+    storage_serve_thread.join();
+  }
+
+  mgmt_server->stop();
+  if (mgmt_serve_thread.joinable()) {
+    mgmt_serve_thread.join();
+  }
+}
+
+TEST_CASE("hash_table_client_pipelined_test", "[pipelined_put][pipelined_get][pipelined_remove]") {
+  auto alloc = std::make_shared<sequential_block_allocator>();
+  auto block_names = test_utils::init_block_names(NUM_BLOCKS, STORAGE_SERVICE_PORT, STORAGE_MANAGEMENT_PORT);
+  alloc->add_blocks(block_names);
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  auto blocks = test_utils::init_hash_table_blocks(block_names, memory_mode, mem_kind, 134217728, 0, 1);
+  auto storage_server = block_server::create(blocks, STORAGE_SERVICE_PORT);
+  std::thread storage_serve_thread([&storage_server] { storage_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_SERVICE_PORT);
+
+  auto mgmt_server = storage_management_server::create(blocks, HOST, STORAGE_MANAGEMENT_PORT);
+  std::thread mgmt_serve_thread([&mgmt_server] { mgmt_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_MANAGEMENT_PORT);
+
+  auto sm = std::make_shared<storage_manager>();
+  auto tree = std::make_shared<directory_tree>(alloc, sm);
+  data_status status = tree->create("/sandbox/file.txt", "hashtable", "/tmp", NUM_BLOCKS, 1, 0, 0,
+      {"0_21845", "21845_43690", "43690_65536"}, {"regular", "regular", "regular"});
+
+  hash_table_client client(tree, "/sandbox/file.txt", status);
+  client.set_pipeline_depth(8);
+  REQUIRE(client.pipeline_depth() == 8);
+  std::vector<std::string> keys, values, values_out;
+  for (std::size_t i = 0; i < 1000; ++i) {
+    keys.push_back(std::to_string(i));
+    values.push_back(std::to_string(i));
+  }
+  for (const auto &s: client.pipelined_put(keys, values)) {
+    REQUIRE(s == "!ok");
+  }
+  for (const auto &s: client.pipelined_put(keys, values)) {
+    REQUIRE(s == "!duplicate_key");
+  }
+  auto status_get = client.pipelined_get(keys, values_out);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    REQUIRE(status_get[i] == "!ok");
+    REQUIRE(values_out[i] == values[i]);
+  }
+  // Single key commands still work once pipelined ones are done
+  REQUIRE(client.get("0") == "0");
+  for (const auto &s: client.pipelined_remove(keys)) {
+    REQUIRE(s == "!ok");
+  }
+  for (const auto &s: client.pipelined_get(keys, values_out)) {
+    REQUIRE(s == "!key_not_found");
+  }
+  REQUIRE_THROWS_AS(client.pipelined_put(keys, {}), std::invalid_argument);
+
+  storage_server->stop();
+  if (storage_serve_thread.joinable()) {
+    storage_serve_thread.join();
+  }
+
+  mgmt_server->stop();
+  if (mgmt_serve_thread.joinable()) {
+    mgmt_serve_thread.join();
+  }
+}
+
+TEST_CASE("hash_table_client_read_modify_write_test", "[cas][incr][append]") {
+  auto alloc = std::make_shared<sequential_block_allocator>();
+  auto block_names = test_utils::init_block_names(NUM_BLOCKS, STORAGE_SERVICE_PORT, STORAGE_MANAGEMENT_PORT);
+  alloc->add_blocks(block_names);
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  auto blocks = test_utils::init_hash_table_blocks(block_names, memory_mode, mem_kind, 134217728, 0, 1);
+  auto storage_server = block_server::create(blocks, STORAGE_SERVICE_PORT);
+  std::thread storage_serve_thread([&storage_server] { storage_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_SERVICE_PORT);
+
+  auto mgmt_server = storage_management_server::create(blocks, HOST, STORAGE_MANAGEMENT_PORT);
+  std::thread mgmt_serve_thread([&mgmt_server] { mgmt_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_MANAGEMENT_PORT);
+
+  auto sm = std::make_shared<storage_manager>();
+  auto tree = std::make_shared<directory_tree>(alloc, sm);
+  data_status status = tree->create("/sandbox/file.txt", "hashtable", "/tmp", NUM_BLOCKS, 1, 0, 0,
+      {"0_21845", "21845_43690", "43690_65536"}, {"regular", "regular", "regular"});
+
+  hash_table_client client(tree, "/sandbox/file.txt", status);
+  REQUIRE_THROWS_AS(client.cas("key", "a", "b"), std::logic_error);
+  REQUIRE_NOTHROW(client.put("key", "a"));
+  REQUIRE_FALSE(client.cas("key", "b", "c"));
+  REQUIRE(client.cas("key", "a", "c"));
+  REQUIRE(client.get("key") == "c");
+  REQUIRE(client.append("key", "de") == 3);
+  REQUIRE(client.get("key") == "cde");
+  REQUIRE_THROWS_AS(client.incr("key"), std::logic_error);
+
+  // Concurrent increments are not lost
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 4; ++t) {
+    workers.emplace_back([&tree, &status] {
+      hash_table_client worker_client(tree, "/sandbox/file.txt", status);
+      for (int i = 0; i < 100; ++i) {
+        worker_client.incr("counter");
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+  REQUIRE(client.incr("counter", 0) == 400);
+  REQUIRE(client.get("counter") == "400");
+
+  storage_server->stop();
+  if (storage_serve_thread.joinable()) {
+    storage_serve_thread.join();
+  }
+
+  mgmt_server->stop();
+  if (mgmt_serve_thread.joinable()) {
+    mgmt_serve_thread.join();
+  }
+}
+
+TEST_CASE("hash_table_client_epoll_server_test", "[put][get]") {
+  auto alloc = std::make_shared<sequential_block_allocator>();
+  auto block_names = test_utils::init_block_names(NUM_BLOCKS, STORAGE_SERVICE_PORT, STORAGE_MANAGEMENT_PORT);
+  alloc->add_blocks(block_names);
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  auto blocks = test_utils::init_hash_table_blocks(block_names, memory_mode, mem_kind, 134217728, 0, 1);
+  auto storage_server = block_server::create(blocks, STORAGE_SERVICE_PORT, 2, "epoll");
+  std::thread storage_serve_thread([&storage_server] { storage_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_SERVICE_PORT);
+
+  auto mgmt_server = storage_management_server::create(blocks, HOST, STORAGE_MANAGEMENT_PORT);
+  std::thread mgmt_serve_thread([&mgmt_server] { mgmt_server->serve(); });
+  test_utils::wait_till_server_ready(HOST, STORAGE_MANAGEMENT_PORT);
+
+  auto sm = std::make_shared<storage_manager>();
+  auto tree = std::make_shared<directory_tree>(alloc, sm);
+  data_status status = tree->create("/sandbox/file.txt", "hashtable", "/tmp", NUM_BLOCKS, 1, 0, 0,
+      {"0_21845", "21845_43690", "43690_65536"}, {"regular", "regular", "regular"});
+
+  hash_table_client client(tree, "/sandbox/file.txt", status);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    REQUIRE_NOTHROW(client.put(std::to_string(i), std::to_string(i)));
+  }
+  for (std::size_t i = 0; i < 1000; ++i) {
+    REQUIRE(client.get(std::to_string(i)) == std::to_string(i));
+  }
+  for (std::size_t i = 1000; i < 2000; ++i) {
+    REQUIRE_THROWS_AS(client.get(std::to_string(i)), std::logic_error);
+  }
+
+  storage_server->stop();
+  if (storage_serve_thread.joinable()) {
+    storage_serve_thread.join();
+  }
+
+  mgmt_server->stop();
+  if (mgmt_serve_thread.joinable()) {
+    mgmt_serve_thread.join();
+  }
+}
@@ -1,4 +1,6 @@
 #include "catch.hpp"
+#include <future>
+#include <mutex>
 #include "jiffy/storage/hashtable/hash_slot.h"
 #include "jiffy/storage/hashtable/hash_table_ops.h"
 #include "jiffy/storage/hashtable/hash_table_partition.h"
@@ -420,4 +422,122 @@ TEST_CASE("hash_table_ls_put_remove_get_binary_test", "[put][update][get]") {
     REQUIRE(resp[0] == "!key_not_found");
   }
   remove("/tmp/0_65536");
-}
\ No newline at end of file
+}
+
+TEST_CASE("hash_table_ls_log_replay_compaction_test", "[put][upsert][remove][get][load]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  for (const auto &serializer: {"csv", "binary", "indexed"}) {
+    property_map conf;
+    conf.set("hashtable.serializer", serializer);
+    conf.set("hashtable.ls_compaction_ratio", "0.3");
+    conf.set("hashtable.ls_compaction_min_bytes", "0");
+    {
+      hash_table_partition block(&manager, "local://tmp", "0_65536", "regular", conf);
+      for (std::size_t i = 0; i < 500; ++i) {
+        response resp;
+        REQUIRE_NOTHROW(block.run_command(resp, {"put", std::to_string(i), std::to_string(i)}));
+        REQUIRE(resp[0] == "!ok");
+      }
+      REQUIRE(block.dump("local://tmp/0_65536"));
+
+      // Overwrite every key several times so that compaction runs in the background
+      for (std::size_t round = 0; round < 10; ++round) {
+        for (std::size_t i = 0; i < 1000; ++i) {
+          response resp;
+          REQUIRE_NOTHROW(block.upsert_ls(resp, {"upsert_ls", std::to_string(i), std::to_string(i + round)}));
+          REQUIRE(resp[0] == "!ok");
+        }
+      }
+      for (std::size_t i = 0; i < 500; ++i) {
+        response resp;
+        REQUIRE_NOTHROW(block.remove_ls(resp, {"remove_ls", std::to_string(i)}));
+        REQUIRE(resp[0] == "!ok");
+      }
+      for (std::size_t i = 0; i < 1000; ++i) {
+        response resp;
+        REQUIRE_NOTHROW(block.get_ls(resp, {"get_ls", std::to_string(i)}));
+        if (i < 500) {
+          REQUIRE(resp[0] == "!key_not_found");
+        } else {
+          REQUIRE(resp[0] == "!ok");
+          REQUIRE(resp[1] == std::to_string(i + 9));
+        }
+      }
+    }
+
+    // A new partition replays the log left behind
+    {
+      hash_table_partition block(&manager, "local://tmp", "0_65536", "regular", conf);
+      for (std::size_t i = 0; i < 1000; ++i) {
+        response resp;
+        REQUIRE_NOTHROW(block.exists_ls(resp, {"exists_ls", std::to_string(i)}));
+        REQUIRE(resp[0] == (i < 500 ? "!key_not_found" : "!ok"));
+      }
+      response resp;
+      REQUIRE_NOTHROW(block.update_ls(resp, {"update_ls", "999", "updated"}));
+      REQUIRE(resp[0] == "!ok");
+    }
+
+    // Loading folds the log into the file
+    {
+      hash_table_partition block(&manager, "local://tmp", "0_65536", "regular", conf);
+      block.load("local://tmp/0_65536");
+      REQUIRE(block.size() == 500);
+      for (std::size_t i = 500; i < 1000; ++i) {
+        response resp;
+        block.run_command(resp, {"get", std::to_string(i)});
+        REQUIRE(resp[0] == "!ok");
+        REQUIRE(resp[1] == (i == 999 ? "updated" : std::to_string(i + 9)));
+      }
+    }
+    remove("/tmp/0_65536");
+    remove("/tmp/0_65536_offset");
+    remove("/tmp/0_65536_log");
+  }
+}
+
+TEST_CASE("hash_table_ls_async_test", "[put][get]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  property_map conf;
+  conf.set("hashtable.serializer", "csv");
+  hash_table_partition block(&manager, "local://tmp", "0_65536", "regular", conf);
+  response resp;
+  block.run_command(resp, {"put", "0", "0"});
+  REQUIRE(block.dump("local://tmp/0_65536"));
+
+  // The commands run off the calling thread, in order
+  std::mutex mtx;
+  std::vector<response> results;
+  auto record = [&mtx, &results](const response &result) {
+    std::lock_guard<std::mutex> lock(mtx);
+    results.push_back(result);
+  };
+  for (std::size_t i = 1; i < 100; ++i) {
+    REQUIRE(block.run_command_async({"put_ls", std::to_string(i), std::to_string(i)}, record));
+  }
+  REQUIRE(block.is_dirty());
+  for (std::size_t i = 0; i < 100; ++i) {
+    REQUIRE(block.run_command_async({"get_ls", std::to_string(i)}, record));
+  }
+  std::promise<response> last;
+  REQUIRE(block.run_command_async({"remove_ls", "0"}, [&last](const response &result) {
+    last.set_value(result);
+  }));
+  REQUIRE(last.get_future().get()[0] == "!ok");
+  REQUIRE(results.size() == 199);
+  for (std::size_t i = 0; i < 99; ++i) {
+    REQUIRE(results[i][0] == "!ok");
+  }
+  for (std::size_t i = 0; i < 100; ++i) {
+    REQUIRE(results[99 + i] == response({"!ok", std::to_string(i)}));
+  }
+  REQUIRE_FALSE(block.run_command_async({"get", "0"}, record));
+  remove("/tmp/0_65536");
+  remove("/tmp/0_65536_log");
+}
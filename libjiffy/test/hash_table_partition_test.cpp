@@ -3,6 +3,10 @@
 #include "jiffy/storage/hashtable/hash_slot.h"
 #include "jiffy/storage/hashtable/hash_table_ops.h"
 #include "jiffy/storage/hashtable/hash_table_partition.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
 
 using namespace ::jiffy::storage;
 using namespace ::jiffy::persistent;
@@ -32,6 +36,31 @@ TEST_CASE("hash_table_put_get_test", "[put][get]") {
 }
 
 
+TEST_CASE("hash_table_get_view_test", "[put][get]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  hash_table_partition block(&manager);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.put(resp, {"put", std::to_string(i), std::string(i, 'v')}));
+    REQUIRE(resp[0] == "!ok");
+  }
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response_view resp;
+    REQUIRE_NOTHROW(block.run_command_view(resp, {"get", std::to_string(i)}));
+    REQUIRE(resp[0] == "!ok");
+    REQUIRE_FALSE(resp[1].borrowed());
+    REQUIRE(resp[1] == std::string(i, 'v'));
+  }
+  response_view resp;
+  REQUIRE_NOTHROW(block.run_command_view(resp, {"get", "1000"}));
+  REQUIRE(resp[0] == "!key_not_found");
+  REQUIRE_NOTHROW(block.run_command_view(resp, {"exists", "1"}));
+  REQUIRE(resp[0] == "!ok");
+}
+
 TEST_CASE("hash_table_put_update_get_test", "[put][update][get]") {
   std::string memory_mode = getenv("JIFFY_TEST_MODE");
   void* mem_kind = test_utils::init_kind();
@@ -175,6 +204,7 @@ TEST_CASE("hash_table_storage_size_test", "[put][size][storage_size][reset]") {
 }
 
 TEST_CASE("hash_table_flush_load_test", "[put][sync][reset][load][get]") {
+  temp_directory dir;
   std::string memory_mode = getenv("JIFFY_TEST_MODE");
   void* mem_kind = test_utils::init_kind();
   size_t capacity = 134217728;
@@ -186,14 +216,468 @@ TEST_CASE("hash_table_flush_load_test", "[put][sync][reset][load][get]") {
     REQUIRE(res.front() == "!ok");
   }
   REQUIRE(block.is_dirty());
-  REQUIRE(block.sync("local://tmp/test"));
+  REQUIRE(block.sync(dir.local_path("test")));
   REQUIRE(!block.is_dirty());
-  REQUIRE_FALSE(block.sync("local://tmp/test"));
-  REQUIRE_NOTHROW(block.load("local://tmp/test"));
+  REQUIRE_FALSE(block.sync(dir.local_path("test")));
+  REQUIRE_NOTHROW(block.load(dir.local_path("test")));
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.get(resp, {"get", std::to_string(i)}));
+    REQUIRE(resp[0] == "!ok");
+    REQUIRE(resp[1] == std::to_string(i));
+  }
+}
+
+TEST_CASE("hash_table_delta_sync_load_test", "[put][update][remove][sync][load][get]") {
+  temp_directory dir;
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  hash_table_partition block(&manager);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    std::vector<std::string> res;
+    block.run_command(res, {"put", std::to_string(i), std::to_string(i)});
+    REQUIRE(res.front() == "!ok");
+  }
+  REQUIRE(block.sync(dir.local_path("test")));
+  REQUIRE_FALSE(std::ifstream(dir.path("test_delta_1")).good());
+  for (std::size_t i = 0; i < 10; ++i) {
+    std::vector<std::string> res;
+    block.run_command(res, {"update", std::to_string(i), std::to_string(i + 1000)});
+    REQUIRE(res.front() == "!ok");
+    block.run_command(res, {"remove", std::to_string(i + 10)});
+    REQUIRE(res.front() == "!ok");
+  }
+  REQUIRE(block.sync(dir.local_path("test")));
+  REQUIRE(std::ifstream(dir.path("test_delta_1")).good());
+
+  hash_table_partition loaded(&manager);
+  REQUIRE_NOTHROW(loaded.load(dir.local_path("test")));
+  REQUIRE(loaded.size() == 990);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(loaded.get(resp, {"get", std::to_string(i)}));
+    if (i < 10) {
+      REQUIRE(resp[1] == std::to_string(i + 1000));
+    } else if (i < 20) {
+      REQUIRE(resp[0] == "!key_not_found");
+    } else {
+      REQUIRE(resp[1] == std::to_string(i));
+    }
+  }
+
+  // A full rewrite drops the deltas of the previous base image
+  std::vector<std::string> res;
+  block.run_command(res, {"put", "new_key", "new_value"});
+  REQUIRE(block.dump(dir.local_path("test")));
+  REQUIRE_FALSE(std::ifstream(dir.path("test_delta_1")).good());
+}
+
+TEST_CASE("hash_table_snapshot_test", "[put][update][snapshot][load][get]") {
+  temp_directory dir;
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  hash_table_partition block(&manager);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    std::vector<std::string> res;
+    block.run_command(res, {"put", std::to_string(i), std::to_string(i)});
+    REQUIRE(res.front() == "!ok");
+  }
+  // Updates after the snapshot is captured do not leak into it
+  REQUIRE(block.snapshot(dir.local_path("test_snapshot")));
+  for (std::size_t i = 0; i < 1000; ++i) {
+    std::vector<std::string> res;
+    block.run_command(res, {"update", std::to_string(i), std::to_string(i + 1000)});
+    REQUIRE(res.front() == "!ok");
+  }
+  REQUIRE_NOTHROW(block.wait_snapshots());
+
+  hash_table_partition loaded(&manager);
+  REQUIRE_NOTHROW(loaded.load(dir.local_path("test_snapshot")));
+  REQUIRE(loaded.size() == 1000);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(loaded.get(resp, {"get", std::to_string(i)}));
+    REQUIRE(resp[1] == std::to_string(i));
+  }
+}
+
+TEST_CASE("hash_table_write_ahead_log_test", "[put][update][sync][load][get]") {
+  temp_directory dir;
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  property_map conf;
+  conf.set("hashtable.wal", "sync");
+  {
+    hash_table_partition block(&manager, "local://tmp", "0_65536", "regular", conf);
+    for (std::size_t i = 0; i < 1000; ++i) {
+      std::vector<std::string> res;
+      block.run_command(res, {"put", std::to_string(i), std::to_string(i)});
+      REQUIRE(res.front() == "!ok");
+      auto lsn = block.take_log_lsn();
+      REQUIRE(lsn == i + 1);
+      block.wait_logged(lsn);
+    }
+    REQUIRE(block.sync(dir.local_path("test_wal")));
+    for (std::size_t i = 0; i < 10; ++i) {
+      std::vector<std::string> res;
+      block.run_command(res, {"update", std::to_string(i), std::to_string(i + 1000)});
+      REQUIRE(res.front() == "!ok");
+      block.wait_logged(block.take_log_lsn());
+    }
+    std::vector<std::string> res;
+    block.run_command(res, {"get", "0"});
+    REQUIRE(block.take_log_lsn() == 0);
+    REQUIRE_NOTHROW(block.wait_snapshots());
+    // The partition goes away without a final dump, as in a crash
+  }
+
+  hash_table_partition loaded(&manager, "local://tmp", "0_65536", "regular", conf);
+  REQUIRE_NOTHROW(loaded.load(dir.local_path("test_wal")));
+  REQUIRE(loaded.size() == 1000);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(loaded.get(resp, {"get", std::to_string(i)}));
+    REQUIRE(resp[1] == std::to_string(i < 10 ? i + 1000 : i));
+  }
+  // Replayed commands are not logged again
+  REQUIRE(loaded.take_log_lsn() == 0);
+
+  // A full rewrite removes the log
+  REQUIRE(loaded.dump(dir.local_path("test_wal")));
+  hash_table_partition reloaded(&manager, "local://tmp", "0_65536", "regular", conf);
+  REQUIRE_NOTHROW(reloaded.load(dir.local_path("test_wal")));
+  REQUIRE(reloaded.size() == 1000);
+  response resp;
+  REQUIRE_NOTHROW(reloaded.get(resp, {"get", "0"}));
+  REQUIRE(resp[1] == "1000");
+}
+
+TEST_CASE("hash_table_freeze_test", "[freeze][thaw]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  hash_table_partition block(&manager);
+
+  // Commands wait while the partition is frozen
+  REQUIRE(block.freeze());
+  std::atomic<bool> done(false);
+  std::thread command([&] {
+    partition::command_guard guard(block);
+    done = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  REQUIRE_FALSE(done);
+  block.thaw();
+  command.join();
+  REQUIRE(done);
+
+  // A freeze fails if running commands do not complete in time
+  {
+    partition::command_guard guard(block);
+    REQUIRE_FALSE(block.freeze(std::chrono::milliseconds(10)));
+  }
+  REQUIRE(block.freeze(std::chrono::milliseconds(10)));
+  block.thaw();
+
+  // A freeze that is never thawed expires
+  REQUIRE(block.freeze(std::chrono::milliseconds(10), std::chrono::milliseconds(100)));
+  partition::command_guard guard(block);
+}
+
+TEST_CASE("hash_table_open_addressing_index_test", "[put][update][remove][get]") {
+  temp_directory dir;
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  jiffy::utils::property_map conf;
+  conf.set("hashtable.index", "open_addressing");
+  hash_table_partition block(&manager, "local://tmp", "0_65536", "regular", conf);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.put(resp, {"put", std::to_string(i), std::to_string(i)}));
+    REQUIRE(resp[0] == "!ok");
+  }
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.put(resp, {"put", std::to_string(i), std::to_string(i)}));
+    REQUIRE(resp[0] == "!duplicate_key");
+  }
+  for (std::size_t i = 0; i < 1000; i += 2) {
+    response resp;
+    REQUIRE_NOTHROW(block.update(resp, {"update", std::to_string(i), std::to_string(i + 1000)}));
+    REQUIRE(resp[0] == "!ok");
+  }
+  for (std::size_t i = 1; i < 1000; i += 2) {
+    response resp;
+    REQUIRE_NOTHROW(block.remove(resp, {"remove", std::to_string(i)}));
+    REQUIRE(resp[0] == "!ok");
+  }
+  REQUIRE(block.size() == 500);
   for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.get(resp, {"get", std::to_string(i)}));
+    if (i % 2 == 0) {
+      REQUIRE(resp[0] == "!ok");
+      REQUIRE(resp[1] == std::to_string(i + 1000));
+    } else {
+      REQUIRE(resp[0] == "!key_not_found");
+    }
+  }
+  REQUIRE(block.sync(dir.local_path("test")));
+  REQUIRE_NOTHROW(block.load(dir.local_path("test")));
+  for (std::size_t i = 0; i < 1000; i += 2) {
     response resp;
     REQUIRE_NOTHROW(block.get(resp, {"get", std::to_string(i)}));
     REQUIRE(resp[0] == "!ok");
+    REQUIRE(resp[1] == std::to_string(i + 1000));
+  }
+
+  jiffy::utils::property_map bad_conf;
+  bad_conf.set("hashtable.index", "no_such_index");
+  REQUIRE_THROWS_AS(hash_table_partition(&manager, "local://tmp", "0_65536", "regular", bad_conf),
+                    std::invalid_argument);
+}
+
+TEST_CASE("hash_table_single_allocation_test", "[put][update][remove][get]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  jiffy::utils::property_map conf;
+  conf.set("hashtable.single_allocation", "true");
+  hash_table_partition block(&manager, "local://tmp", "0_65536", "regular", conf);
+  auto used = manager.mb_used();
+  auto long_key = [](std::size_t i) { return std::string(32, 'k') + std::to_string(i); };
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.put(resp, {"put", long_key(i), std::string(64, 'v') + std::to_string(i)}));
+    REQUIRE(resp[0] == "!ok");
+    REQUIRE_NOTHROW(block.put(resp, {"put", std::to_string(i), std::to_string(i)}));
+    REQUIRE(resp[0] == "!ok");
+  }
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.get(resp, {"get", long_key(i)}));
+    REQUIRE(resp[1] == std::string(64, 'v') + std::to_string(i));
+    REQUIRE_NOTHROW(block.get(resp, {"get", std::to_string(i)}));
     REQUIRE(resp[1] == std::to_string(i));
   }
+  for (std::size_t i = 0; i < 1000; i += 2) {
+    response resp;
+    REQUIRE_NOTHROW(block.update(resp, {"update", long_key(i), std::to_string(i + 1000)}));
+    REQUIRE(resp[0] == "!ok");
+  }
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.get(resp, {"get", long_key(i)}));
+    REQUIRE(resp[1] == (i % 2 == 0 ? std::to_string(i + 1000) : std::string(64, 'v') + std::to_string(i)));
+  }
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.remove(resp, {"remove", long_key(i)}));
+    REQUIRE(resp[0] == "!ok");
+    REQUIRE_NOTHROW(block.remove(resp, {"remove", std::to_string(i)}));
+    REQUIRE(resp[0] == "!ok");
+  }
+  REQUIRE(manager.mb_used() == used);
+}
+
+TEST_CASE("hash_table_batch_test", "[mput][mget][mupsert][mremove]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  hash_table_partition block(&manager);
+  std::vector<std::string> put_args{"mput"}, get_args{"mget"}, upsert_args{"mupsert"}, remove_args{"mremove"};
+  for (std::size_t i = 0; i < 100; ++i) {
+    put_args.push_back(std::to_string(i));
+    put_args.push_back(std::to_string(i));
+    upsert_args.push_back(std::to_string(i));
+    upsert_args.push_back(std::to_string(i + 100));
+    get_args.push_back(std::to_string(i));
+    remove_args.push_back(std::to_string(i));
+  }
+  response resp;
+  block.run_command(resp, put_args);
+  REQUIRE(resp.size() == 1 + 2 * 100);
+  for (std::size_t i = 0; i < 100; ++i) {
+    REQUIRE(resp[1 + 2 * i] == "1");
+    REQUIRE(resp[2 + 2 * i] == "!ok");
+  }
+  REQUIRE(block.is_dirty());
+  resp.clear();
+  block.run_command(resp, {"mput", "0", "0", "new", "new"});
+  REQUIRE(resp == response({"!ok", "1", "!duplicate_key", "1", "!ok"}));
+  resp.clear();
+  block.run_command(resp, upsert_args);
+  REQUIRE(resp[0] == "!ok");
+  resp.clear();
+  block.run_command(resp, get_args);
+  REQUIRE(resp.size() == 1 + 3 * 100);
+  for (std::size_t i = 0; i < 100; ++i) {
+    REQUIRE(resp[1 + 3 * i] == "2");
+    REQUIRE(resp[2 + 3 * i] == "!ok");
+    REQUIRE(resp[3 + 3 * i] == std::to_string(i + 100));
+  }
+  resp.clear();
+  block.run_command(resp, remove_args);
+  REQUIRE(resp[0] == "!ok");
+  REQUIRE(block.size() == 1);
+  resp.clear();
+  block.run_command(resp, {"mget", "0", "new"});
+  REQUIRE(resp == response({"!ok", "1", "!key_not_found", "2", "!ok", "new"}));
+  resp.clear();
+  block.run_command(resp, {"mput", "0"});
+  REQUIRE(resp[0] == "!args_error");
+}
+
+TEST_CASE("hash_table_read_modify_write_test", "[cas][incr][append]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  hash_table_partition block(&manager);
+  response resp;
+  block.run_command(resp, {"cas", "key", "a", "b"});
+  REQUIRE(resp == response({"!key_not_found"}));
+  resp.clear();
+  block.run_command(resp, {"put", "key", "a"});
+  REQUIRE(resp[0] == "!ok");
+  resp.clear();
+  block.run_command(resp, {"cas", "key", "x", "b"});
+  REQUIRE(resp == response({"!cas_failed", "a"}));
+  resp.clear();
+  block.run_command(resp, {"cas", "key", "a", "b"});
+  REQUIRE(resp == response({"!ok"}));
+  resp.clear();
+  block.run_command(resp, {"append", "key", "cd"});
+  REQUIRE(resp == response({"!ok", "3"}));
+  resp.clear();
+  block.run_command(resp, {"append", "new_key", "cd"});
+  REQUIRE(resp == response({"!ok", "2"}));
+  resp.clear();
+  block.run_command(resp, {"get", "key"});
+  REQUIRE(resp == response({"!ok", "bcd"}));
+  resp.clear();
+  block.run_command(resp, {"incr", "counter", "5"});
+  REQUIRE(resp == response({"!ok", "5"}));
+  resp.clear();
+  block.run_command(resp, {"incr", "counter", "-7"});
+  REQUIRE(resp == response({"!ok", "-2"}));
+  resp.clear();
+  block.run_command(resp, {"incr", "key", "1"});
+  REQUIRE(resp == response({"!not_a_number"}));
+  resp.clear();
+  block.run_command(resp, {"incr", "counter", "1x"});
+  REQUIRE(resp == response({"!args_error"}));
+  resp.clear();
+  block.run_command(resp, {"put", "max", "9223372036854775807"});
+  resp.clear();
+  block.run_command(resp, {"incr", "max", "1"});
+  REQUIRE(resp == response({"!overflow"}));
+  resp.clear();
+  block.run_command(resp, {"get", "counter"});
+  REQUIRE(resp == response({"!ok", "-2"}));
+  REQUIRE(block.is_dirty());
+}
+
+TEST_CASE("hash_table_read_modify_write_redirect_test", "[cas][incr][append]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  hash_table_partition source(&manager);
+  hash_table_partition target(&manager, "local://tmp", "65536_65537", "importing");
+  response resp;
+  source.run_command(resp, {"put", "counter", "1"});
+  REQUIRE(resp[0] == "!ok");
+  source.metadata("exporting");
+  source.export_slot_range(0, 65536);
+  source.export_target("target");
+  target.import_slot_range(0, 65536);
+
+  // The exporting partition forwards its value unchanged, the importing partition applies the command
+  resp.clear();
+  source.run_command(resp, {"incr", "counter", "2"});
+  REQUIRE(resp == response({"!exporting", "target", "1", "1"}));
+  resp.clear();
+  source.run_command(resp, {"incr", "counter", "2"});
+  REQUIRE(resp == response({"!exporting", "target", "1", "1"}));
+  resp.clear();
+  target.run_command(resp, {"incr", "counter", "2", "1", "1", "!redirected"});
+  REQUIRE(resp == response({"!ok", "3"}));
+  resp.clear();
+  target.run_command(resp, {"get", "counter", "!redirected"});
+  REQUIRE(resp == response({"!ok", "3"}));
+
+  // Once the importing partition holds the key, the forwarded value is ignored
+  resp.clear();
+  target.run_command(resp, {"incr", "counter", "2", "1", "1", "!redirected"});
+  REQUIRE(resp == response({"!ok", "5"}));
+  resp.clear();
+  target.run_command(resp, {"cas", "counter", "1", "4", "1", "1", "!redirected"});
+  REQUIRE(resp == response({"!cas_failed", "5"}));
+
+  // Keys missing from the exporting partition are handled by the importing partition
+  resp.clear();
+  source.run_command(resp, {"append", "log", "a"});
+  REQUIRE(resp == response({"!exporting", "target", "0", ""}));
+  resp.clear();
+  target.run_command(resp, {"append", "log", "a", "0", "", "!redirected"});
+  REQUIRE(resp == response({"!ok", "1"}));
+  resp.clear();
+  target.run_command(resp, {"append", "log", "b", "0", "", "!redirected"});
+  REQUIRE(resp == response({"!ok", "2"}));
+  resp.clear();
+  target.run_command(resp, {"get", "log", "!redirected"});
+  REQUIRE(resp == response({"!ok", "ab"}));
+  resp.clear();
+  source.run_command(resp, {"get", "log"});
+  REQUIRE(resp == response({"!exporting", "target"}));
+}
+
+TEST_CASE("hash_table_slot_range_test", "[put][get_range_data][scale_remove]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  hash_table_partition block(&manager);
+  std::size_t n_in_range = 0;
+  for (std::size_t i = 0; i < 1000; ++i) {
+    response resp;
+    REQUIRE_NOTHROW(block.put(resp, {"put", std::to_string(i), std::to_string(i)}));
+    REQUIRE(resp[0] == "!ok");
+    if (hash_slot::get(std::to_string(i)) < 32768) {
+      n_in_range++;
+    }
+  }
+  response resp;
+  block.run_command(resp, {"get_range_data", "0", "32768", "100"});
+  REQUIRE(resp[0] == "!ok");
+  REQUIRE(resp.size() == 101);
+  for (std::size_t i = 1; i < resp.size(); i += 2) {
+    REQUIRE(hash_slot::get(resp[i]) < 32768);
+    REQUIRE(resp[i] == resp[i + 1]);
+  }
+  resp.clear();
+  block.run_command(resp, {"scale_remove", "!slot_range", "0", "32768"});
+  REQUIRE(resp[0] == "!ok");
+  REQUIRE(resp[1] == std::to_string(n_in_range));
+  REQUIRE(block.size() == 1000 - n_in_range);
+  resp.clear();
+  block.run_command(resp, {"get_range_data", "0", "32768", "100"});
+  REQUIRE(resp[0] == "!empty");
+  for (std::size_t i = 0; i < 1000; ++i) {
+    resp.clear();
+    REQUIRE_NOTHROW(block.get(resp, {"get", std::to_string(i)}));
+    REQUIRE(resp[0] == (hash_slot::get(std::to_string(i)) < 32768 ? "!key_not_found" : "!ok"));
+  }
 }
@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "jiffy/persistent/crc32c.h"
+#include "jiffy/persistent/indexed_file.h"
+
+using namespace ::jiffy::persistent;
+
+TEST_CASE("crc32c_test", "[checksum]") {
+  std::string check = "123456789";
+  REQUIRE(crc32c(0, check.data(), check.size()) == 0xe3069283);
+  // Extending a checksum matches checksumming the concatenation
+  REQUIRE(crc32c(crc32c(0, check.data(), 4), check.data() + 4, 5) == 0xe3069283);
+  std::string zeros(32, '\0');
+  REQUIRE(crc32c(0, zeros.data(), zeros.size()) == 0x8a9136aa);
+}
+
+TEST_CASE("indexed_file_write_find_test", "[write][read]") {
+  {
+    // Small chunks so that records span several of them
+    indexed_file_writer out("/tmp/indexed_file_test", indexed_layout::hash_table, true, 1024);
+    REQUIRE(out.is_open());
+    out.set_aux(1, 42);
+    for (int i = 999; i >= 0; --i) {
+      auto key = "key" + std::to_string(i);
+      auto value = std::string(static_cast<std::size_t>(i % 100), 'v') + std::to_string(i);
+      out.add(key.data(), key.size(), value.data(), value.size());
+    }
+    out.add("", 0, "empty", 5);
+    REQUIRE(out.close());
+  }
+  indexed_file in("/tmp/indexed_file_test");
+  REQUIRE(in.is_open());
+  REQUIRE(in.layout() == indexed_layout::hash_table);
+  REQUIRE(in.sorted());
+  REQUIRE(in.num_records() == 1001);
+  REQUIRE(in.aux(1) == 42);
+  for (int i = 0; i < 1000; ++i) {
+    auto r = in.find("key" + std::to_string(i));
+    REQUIRE(r == static_cast<std::size_t>(999 - i));
+    auto rec = in.get(r);
+    REQUIRE(std::string(rec.key, rec.key_size) == "key" + std::to_string(i));
+    REQUIRE(std::string(rec.value, rec.value_size) == std::string(static_cast<std::size_t>(i % 100), 'v') + std::to_string(i));
+  }
+  REQUIRE(in.find("") == 1000);
+  REQUIRE(in.find("key") == indexed_file::npos);
+  REQUIRE(in.find("key1000") == indexed_file::npos);
+  REQUIRE(in.find("zzz") == indexed_file::npos);
+  REQUIRE_NOTHROW(in.verify());
+  std::remove("/tmp/indexed_file_test");
+  REQUIRE_FALSE(indexed_file("/tmp/indexed_file_test").is_open());
+}
+
+TEST_CASE("indexed_file_corruption_test", "[read]") {
+  {
+    indexed_file_writer out("/tmp/indexed_file_test", indexed_layout::fifo_queue, false, 1024);
+    for (int i = 0; i < 100; ++i) {
+      std::string value(1024, static_cast<char>('a' + i % 26));
+      out.add(nullptr, 0, value.data(), value.size());
+    }
+    REQUIRE(out.close());
+  }
+  // Flip a byte of the last record
+  {
+    std::fstream f("/tmp/indexed_file_test", std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(static_cast<std::streamoff>(sizeof(indexed_file_header) + 99 * 1024 + 10));
+    f.put('!');
+  }
+  indexed_file in("/tmp/indexed_file_test");
+  REQUIRE_FALSE(in.sorted());
+  REQUIRE_THROWS_AS(in.find("key"), std::logic_error);
+  // Only the damaged chunk fails its checksum
+  for (std::size_t i = 0; i < 99; ++i) {
+    REQUIRE(in.get(i).value[0] == static_cast<char>('a' + i % 26));
+  }
+  REQUIRE_THROWS_AS(in.get(99), std::runtime_error);
+  REQUIRE_THROWS_AS(in.verify(), std::runtime_error);
+
+  // A file whose header was never written is rejected
+  {
+    indexed_file_writer out("/tmp/indexed_file_test", indexed_layout::file, false);
+    std::string value(4096, 'x');
+    out.add(nullptr, 0, value.data(), value.size());
+    REQUIRE_THROWS_AS(indexed_file("/tmp/indexed_file_test"), std::runtime_error);
+  }
+  std::remove("/tmp/indexed_file_test");
+}
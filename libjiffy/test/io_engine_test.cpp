@@ -0,0 +1,158 @@
+#include "catch.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "jiffy/persistent/async_stream.h"
+#include "jiffy/persistent/io_engine.h"
+#include "jiffy/storage/file/local_file.h"
+
+using namespace ::jiffy::persistent;
+using namespace ::jiffy::storage;
+
+TEST_CASE("io_engine_read_write_test", "[io]") {
+  for (const auto &name: {"thread_pool", "io_uring"}) {
+    auto engine = io_engine::create(name);
+    int fd = ::open("/tmp/io_engine_test", O_RDWR | O_CREAT | O_TRUNC, 0644);
+    REQUIRE(fd >= 0);
+
+    // One batch of writes at distinct offsets
+    std::vector<std::string> blocks;
+    for (int i = 0; i < 100; ++i) {
+      blocks.emplace_back(4096, static_cast<char>('a' + i % 26));
+    }
+    std::atomic<int> num_done(0);
+    std::atomic<int> num_failed(0);
+    std::vector<io_request> batch;
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+      batch.push_back(io_request{io_op::write, fd, &blocks[i][0], blocks[i].size(), i * 4096, [&](std::int64_t n) {
+        if (n != 4096) {
+          ++num_failed;
+        }
+        ++num_done;
+      }});
+    }
+    engine->submit(batch);
+    while (num_done < 100) {
+      std::this_thread::yield();
+    }
+    REQUIRE(num_failed == 0);
+
+    std::string data(4096, '\0');
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+      REQUIRE(engine->run(io_op::read, fd, &data[0], data.size(), i * 4096) == 4096);
+      REQUIRE(data == blocks[i]);
+    }
+
+    // Reads past the end of the file are cut short
+    REQUIRE(engine->run(io_op::read, fd, &data[0], data.size(), 100 * 4096 - 10) == 10);
+    REQUIRE(engine->run(io_op::read, fd, &data[0], data.size(), 100 * 4096) == 0);
+    ::close(fd);
+
+    // Failures return -errno
+    REQUIRE(engine->run(io_op::read, fd, &data[0], data.size(), 0) == -EBADF);
+    std::remove("/tmp/io_engine_test");
+  }
+}
+
+TEST_CASE("io_engine_callback_exception_test", "[io]") {
+  for (const auto &name: {"thread_pool", "io_uring"}) {
+    auto engine = io_engine::create(name, 1);
+    int fd = ::open("/tmp/io_engine_test", O_RDWR | O_CREAT | O_TRUNC, 0644);
+    REQUIRE(fd >= 0);
+    std::string block(4096, 'x');
+    std::atomic<int> num_done(0);
+    std::vector<io_request> batch;
+    for (std::size_t i = 0; i < 10; ++i) {
+      batch.push_back(io_request{io_op::write, fd, &block[0], block.size(), i * 4096, [&](std::int64_t) {
+        ++num_done;
+        throw std::runtime_error("client disconnected");
+      }});
+    }
+    engine->submit(batch);
+    while (num_done < 10) {
+      std::this_thread::yield();
+    }
+    // The engine keeps serving requests after callbacks throw
+    REQUIRE(engine->run(io_op::read, fd, &block[0], block.size(), 0) == 4096);
+    ::close(fd);
+    std::remove("/tmp/io_engine_test");
+  }
+}
+
+TEST_CASE("async_stream_test", "[io]") {
+  std::string data;
+  for (std::size_t i = 0; data.size() < (7UL << 19); ++i) {
+    data += std::to_string(i) + ",";
+  }
+  {
+    async_ofstream out("/tmp/async_stream_test");
+    REQUIRE(out.good());
+    // Small writes fill chunks, a large write spans several
+    out.write(data.data(), 100);
+    out << data.substr(100, 10);
+    out.write(data.data() + 110, data.size() - 110);
+    out.flush();
+    REQUIRE(out.good());
+    REQUIRE(static_cast<std::size_t>(out.tellp()) == data.size());
+    out.close();
+    REQUIRE(out.good());
+  }
+  {
+    async_ifstream in("/tmp/async_stream_test");
+    REQUIRE(in.good());
+    std::string read_data(data.size(), '\0');
+    in.read(&read_data[0], 5);
+    REQUIRE(in.tellg() == 5);
+    in.read(&read_data[5], data.size() - 5);
+    REQUIRE(read_data == data);
+    REQUIRE(in.peek() == EOF);
+  }
+  {
+    async_ifstream in("/tmp/async_stream_test_missing");
+    REQUIRE(in.fail());
+    REQUIRE(in.peek() == EOF);
+  }
+  std::remove("/tmp/async_stream_test");
+}
+
+TEST_CASE("local_file_ordering_test", "[io]") {
+  {
+    std::ofstream out("/tmp/local_file_test");
+  }
+  local_file file;
+  std::atomic<int> num_done(0);
+  std::atomic<int> num_failed(0);
+  std::vector<std::string> reads(100);
+  // Reads queued behind overlapping writes see the written data
+  for (int i = 0; i < 100; ++i) {
+    file.write("/tmp/local_file_test", 0, std::to_string(i), [&](int error) {
+      if (error != 0) {
+        ++num_failed;
+      }
+      ++num_done;
+    });
+    file.read("/tmp/local_file_test", 0, std::to_string(i).size(), [&, i](int error, std::string &data) {
+      if (error != 0) {
+        ++num_failed;
+      }
+      reads[i] = data;
+      ++num_done;
+    });
+  }
+  file.close();
+  REQUIRE(num_done == 200);
+  REQUIRE(num_failed == 0);
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE(reads[i] == std::to_string(i));
+  }
+  std::string data;
+  REQUIRE_FALSE(file.read("/tmp/local_file_test_missing", 0, 1, data));
+  std::remove("/tmp/local_file_test");
+}
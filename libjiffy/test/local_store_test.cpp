@@ -52,3 +52,169 @@ TEST_CASE("local_read_test", "[read]") {
   REQUIRE(table.at(bkey) == bval);
   std::remove("/tmp/a.txt");
 }
+
+TEST_CASE("local_binary_read_test", "[read]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  block_memory_allocator<uint8_t> binary_allocator(&manager);
+  auto ser = std::make_shared<binary_serde>(binary_allocator);
+  local_store store(ser);
+  // Enough records for the load to be split across threads
+  const std::size_t num_keys = 200000;
+  hash_table_type table;
+  for (std::size_t i = 0; i < num_keys; ++i) {
+    table.emplace(make_binary("key" + std::to_string(i), binary_allocator),
+                  make_binary("value" + std::to_string(i), binary_allocator));
+  }
+  table.emplace(make_binary("empty", binary_allocator), make_binary("", binary_allocator));
+  REQUIRE_NOTHROW(store.write(table, "/tmp/b.bin"));
+
+  hash_table_type loaded;
+  REQUIRE_NOTHROW(store.read("/tmp/b.bin", loaded));
+  REQUIRE(loaded.size() == num_keys + 1);
+  for (std::size_t i = 0; i < num_keys; ++i) {
+    REQUIRE(loaded.at(make_binary("key" + std::to_string(i), binary_allocator))
+                == make_binary("value" + std::to_string(i), binary_allocator));
+  }
+  REQUIRE(loaded.at(make_binary("empty", binary_allocator)).size() == 0);
+  std::remove("/tmp/b.bin");
+  std::remove("/tmp/b.bin_offset");
+}
+
+TEST_CASE("local_binary_truncated_read_test", "[read]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  block_memory_allocator<uint8_t> binary_allocator(&manager);
+  auto ser = std::make_shared<binary_serde>(binary_allocator);
+  local_store store(ser);
+  hash_table_type table;
+  table.emplace(make_binary("key", binary_allocator), make_binary("value", binary_allocator));
+  REQUIRE_NOTHROW(store.write(table, "/tmp/c.bin"));
+  {
+    // A record cut short by a crash is dropped
+    std::ofstream offset_out("/tmp/c.bin_offset", std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+    std::size_t key_size = 16;
+    offset_out.write(reinterpret_cast<const char *>(&key_size), sizeof(key_size));
+    offset_out.write("partial", 7);
+  }
+  hash_table_type loaded;
+  REQUIRE_NOTHROW(store.read("/tmp/c.bin", loaded));
+  REQUIRE(loaded.size() == 1);
+  REQUIRE(loaded.at(make_binary("key", binary_allocator)) == make_binary("value", binary_allocator));
+  std::remove("/tmp/c.bin");
+  std::remove("/tmp/c.bin_offset");
+}
+
+#ifdef COMPRESSION_IN_USE
+TEST_CASE("local_compressed_hash_table_test", "[write][read]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  block_memory_allocator<uint8_t> binary_allocator(&manager);
+  // Spans several compressed chunks
+  const std::size_t num_keys = 20000;
+  hash_table_type table;
+  for (std::size_t i = 0; i < num_keys; ++i) {
+    table.emplace(make_binary("key" + std::to_string(i), binary_allocator),
+                  make_binary(std::string(100, static_cast<char>('a' + i % 26)), binary_allocator));
+  }
+  for (const std::string name: {"lz4", "zstd"}) {
+    auto ser = std::make_shared<binary_serde>(binary_allocator, codec::make(name));
+    local_store store(ser);
+    REQUIRE_NOTHROW(store.write(table, "/tmp/d.bin"));
+    hash_table_type loaded;
+    REQUIRE_NOTHROW(store.read("/tmp/d.bin", loaded));
+    REQUIRE(loaded.size() == num_keys);
+    for (std::size_t i = 0; i < num_keys; ++i) {
+      REQUIRE(loaded.at(make_binary("key" + std::to_string(i), binary_allocator))
+                  == make_binary(std::string(100, static_cast<char>('a' + i % 26)), binary_allocator));
+    }
+    // The repetitive values compress well
+    std::ifstream in("/tmp/d.bin", std::ifstream::binary | std::ifstream::ate);
+    REQUIRE(static_cast<std::size_t>(in.tellg()) < num_keys * 100);
+  }
+  std::remove("/tmp/d.bin");
+  std::remove("/tmp/d.bin_offset");
+}
+
+TEST_CASE("local_compressed_fifo_queue_test", "[write][read]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  block_memory_allocator<uint8_t> binary_allocator(&manager);
+  block_memory_allocator<char> allocator(&manager);
+  fifo_queue_type queue(16777216, allocator);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    queue.push_back("message" + std::to_string(i));
+  }
+  auto ser = std::make_shared<binary_serde>(binary_allocator, codec::make("lz4"));
+  local_store store(ser);
+  REQUIRE_NOTHROW(store.write(queue, "/tmp/e.bin"));
+  fifo_queue_type loaded(16777216, allocator);
+  REQUIRE_NOTHROW(store.read("/tmp/e.bin", loaded));
+  auto it = loaded.begin();
+  for (std::size_t i = 0; i < 1000; ++i, it++) {
+    REQUIRE(*it == "message" + std::to_string(i));
+  }
+  REQUIRE(it == loaded.end());
+  std::remove("/tmp/e.bin");
+  std::remove("/tmp/e.bin_offset");
+}
+#endif
+
+TEST_CASE("local_indexed_test", "[write][read]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void* mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  block_memory_allocator<uint8_t> binary_allocator(&manager);
+  block_memory_allocator<char> allocator(&manager);
+  auto ser = std::make_shared<indexed_serde>(binary_allocator);
+  local_store store(ser);
+
+  hash_table_type table;
+  for (std::size_t i = 0; i < 20000; ++i) {
+    table.emplace(make_binary("key" + std::to_string(i), binary_allocator),
+                  make_binary("value" + std::to_string(i), binary_allocator));
+  }
+  REQUIRE_NOTHROW(store.write(table, "/tmp/f.bin"));
+  hash_table_type loaded_table;
+  REQUIRE_NOTHROW(store.read("/tmp/f.bin", loaded_table));
+  REQUIRE(loaded_table.size() == 20000);
+  for (std::size_t i = 0; i < 20000; ++i) {
+    REQUIRE(loaded_table.at(make_binary("key" + std::to_string(i), binary_allocator))
+                == make_binary("value" + std::to_string(i), binary_allocator));
+  }
+  // Point lookups without loading the table
+  indexed_file image("/tmp/f.bin");
+  REQUIRE(image.num_records() == 20000);
+  auto i = image.find("key4242");
+  REQUIRE(i != indexed_file::npos);
+  REQUIRE(std::string(image.get(i).value, image.get(i).value_size) == "value4242");
+  REQUIRE(image.find("key20000") == indexed_file::npos);
+
+  fifo_queue_type queue(16777216, allocator);
+  for (std::size_t j = 0; j < 1000; ++j) {
+    queue.push_back("message" + std::to_string(j));
+  }
+  REQUIRE_NOTHROW(store.write(queue, "/tmp/f.bin"));
+  fifo_queue_type loaded_queue(16777216, allocator);
+  REQUIRE_NOTHROW(store.read("/tmp/f.bin", loaded_queue));
+  auto it = loaded_queue.begin();
+  for (std::size_t j = 0; j < 1000; ++j, it++) {
+    REQUIRE(*it == "message" + std::to_string(j));
+  }
+  REQUIRE(it == loaded_queue.end());
+
+  // A hash table image is not read as a queue
+  REQUIRE_NOTHROW(store.write(table, "/tmp/f.bin"));
+  fifo_queue_type mismatched(16777216, allocator);
+  REQUIRE_THROWS_AS(store.read("/tmp/f.bin", mismatched), std::runtime_error);
+  std::remove("/tmp/f.bin");
+}
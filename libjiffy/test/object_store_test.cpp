@@ -0,0 +1,180 @@
+#include <catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "jiffy/persistent/object_store.h"
+#include "jiffy/persistent/persistent_service.h"
+#include "test_utils.h"
+#include "jiffy/storage/serde/serde_all.h"
+
+using namespace ::jiffy::persistent;
+using namespace ::jiffy::storage;
+
+TEST_CASE("object_transfer_multipart_test", "[write][read]") {
+  auto client = std::make_shared<fs_object_client>("/tmp/object_store_test");
+  object_transfer transfer(client, 4096, 4);
+
+  std::string data;
+  for (int i = 0; data.size() < 4096 * 10 + 100; ++i) {
+    data += std::to_string(i) + ",";
+  }
+  {
+    std::ofstream out("/tmp/object_transfer_src", std::ios::binary);
+    out.write(data.data(), data.size());
+  }
+  REQUIRE(transfer.upload("/tmp/object_transfer_src", "bucket", "dir/object") == data.size());
+  REQUIRE(client->num_parts_uploaded() == 11);
+  std::uint64_t size = 0;
+  REQUIRE(client->head_object("bucket", "dir/object", size));
+  REQUIRE(size == data.size());
+
+  REQUIRE(transfer.download("bucket", "dir/object", "/tmp/object_transfer_dst"));
+  REQUIRE(client->num_range_reads() == 11);
+  std::ifstream in("/tmp/object_transfer_dst", std::ios::binary);
+  std::string copy((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  REQUIRE(copy == data);
+
+  // Small files are stored with a single request
+  std::string small = "small";
+  {
+    std::ofstream out("/tmp/object_transfer_src", std::ios::binary | std::ios::trunc);
+    out.write(small.data(), small.size());
+  }
+  REQUIRE(transfer.upload("/tmp/object_transfer_src", "bucket", "small") == small.size());
+  REQUIRE(client->num_parts_uploaded() == 11);
+  REQUIRE(transfer.download("bucket", "small", "/tmp/object_transfer_dst"));
+  char buf[5];
+  client->get_range("bucket", "small", 0, sizeof(buf), buf);
+  REQUIRE(std::string(buf, sizeof(buf)) == small);
+
+  REQUIRE_FALSE(transfer.download("bucket", "missing", "/tmp/object_transfer_dst"));
+  REQUIRE_THROWS_AS(client->get_range("bucket", "small", 4, 2, buf), std::runtime_error);
+
+  client->delete_object("bucket", "dir/object");
+  client->delete_object("bucket", "small");
+  REQUIRE_FALSE(client->head_object("bucket", "small", size));
+  std::remove("/tmp/object_transfer_src");
+  std::remove("/tmp/object_transfer_dst");
+}
+
+TEST_CASE("object_store_read_write_test", "[write][read]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void *mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  block_memory_allocator<uint8_t> binary_allocator(&manager);
+  auto client = std::make_shared<fs_object_client>("/tmp/object_store_test");
+
+  hash_table_type table;
+  for (std::size_t i = 0; i < 1000; ++i) {
+    table.emplace(binary("key" + std::to_string(i), binary_allocator),
+                  binary(std::string(i % 64, 'v') + std::to_string(i), binary_allocator));
+  }
+
+  for (auto ser_name: {"csv", "binary", "indexed"}) {
+    std::shared_ptr<serde> ser;
+    if (std::string(ser_name) == "csv") {
+      ser = std::make_shared<csv_serde>(binary_allocator);
+    } else if (std::string(ser_name) == "binary") {
+      ser = std::make_shared<binary_serde>(binary_allocator);
+    } else {
+      ser = std::make_shared<indexed_serde>(binary_allocator);
+    }
+    // Small parts, so that images are transferred as several parts
+    object_store store(ser, client, "s3", 4096, 4);
+    REQUIRE(store.URI() == "s3");
+    REQUIRE_NOTHROW(store.write(table, "/bucket/partition"));
+
+    delta d;
+    d.push_back(delta_record{7, {"key1000", "new"}});
+    d.push_back(delta_record{9, {}});
+    REQUIRE_NOTHROW(store.write_delta(d, "/bucket/partition", 1));
+
+    hash_table_type loaded;
+    REQUIRE_NOTHROW(store.read("/bucket/partition", loaded));
+    REQUIRE(loaded.size() == table.size());
+    for (const auto &e: table) {
+      REQUIRE(loaded.at(e.first) == e.second);
+    }
+    std::size_t num_deltas = 0;
+    REQUIRE(store.replay_deltas("/bucket/partition", [&](const delta &r) {
+      REQUIRE(r.size() == 2);
+      REQUIRE(r[0].id == 7);
+      REQUIRE(r[0].items[1] == "new");
+      REQUIRE(r[1].items.empty());
+      ++num_deltas;
+    }).first == 1);
+    REQUIRE(num_deltas == 1);
+    store.remove_deltas("/bucket/partition");
+    REQUIRE(store.replay_deltas("/bucket/partition", [](const delta &) {}).first == 0);
+
+    hash_table_type missing;
+    REQUIRE_THROWS_AS(store.read("/bucket/missing", missing), std::runtime_error);
+  }
+  client->delete_object("bucket", "partition");
+  client->delete_object("bucket", "partition_offset");
+}
+
+TEST_CASE("base_image_replace_test", "[write][read]") {
+  std::string memory_mode = getenv("JIFFY_TEST_MODE");
+  void *mem_kind = test_utils::init_kind();
+  size_t capacity = 134217728;
+  block_memory_manager manager(capacity, memory_mode, mem_kind);
+  block_memory_allocator<uint8_t> binary_allocator(&manager);
+  auto ser = std::make_shared<binary_serde>(binary_allocator);
+  auto client = std::make_shared<fs_object_client>("/tmp/object_store_test");
+
+  hash_table_type old_table, new_table;
+  old_table.emplace(binary("key", binary_allocator), binary("old", binary_allocator));
+  new_table.emplace(binary("key", binary_allocator), binary("new", binary_allocator));
+  delta d;
+  d.push_back(delta_record{1, {"key", "delta"}});
+
+  std::vector<std::pair<std::shared_ptr<persistent_service>, std::string>> stores = {
+      {std::make_shared<local_store>(ser), "/tmp/base_image_replace_test/partition"},
+      {std::make_shared<object_store>(ser, client, "s3", 4096, 4), "/bucket/replaced"}};
+  for (auto &s: stores) {
+    auto &store = s.first;
+    auto &path = s.second;
+    store->write(old_table, path);
+    store->write_delta(d, path, 1);
+    REQUIRE_FALSE(store->recover_base(path));
+    REQUIRE(store->replay_deltas(path, [](const delta &) {}).first == 1);
+
+    // A crash once the new image is staged leaves the old image and its deltas in place
+    store->write(new_table, persistent_service::staged_base_path(path));
+    hash_table_type loaded;
+    store->read(path, loaded);
+    REQUIRE(loaded.at(binary("key", binary_allocator)) == binary("old", binary_allocator));
+    REQUIRE(store->recover_base(path));
+    REQUIRE(store->replay_deltas(path, [](const delta &) {}).first == 0);
+    loaded.clear();
+    store->read(path, loaded);
+    REQUIRE(loaded.at(binary("key", binary_allocator)) == binary("new", binary_allocator));
+    REQUIRE_FALSE(store->recover_base(path));
+
+    // Deltas and base images record the last write-ahead log segment they hold
+    auto marked = d;
+    set_log_segment(marked, 3);
+    store->write_delta(marked, path, 1);
+    std::uint64_t log_segment = 0;
+    REQUIRE(store->replay_deltas(path, [](const delta &r) { REQUIRE(r.size() == 1); }, &log_segment).first == 1);
+    REQUIRE(log_segment == 3);
+    REQUIRE(store->read_log_segment(path) == 0);
+    REQUIRE_NOTHROW(store->write_base(old_table, path, 4));
+    REQUIRE(store->read_log_segment(path) == 4);
+    REQUIRE(store->replay_deltas(path, [](const delta &) {}, &log_segment).first == 0);
+    REQUIRE(log_segment == 0);
+    REQUIRE_FALSE(store->recover_base(path));
+    loaded.clear();
+    store->read(path, loaded);
+    REQUIRE(loaded.at(binary("key", binary_allocator)) == binary("old", binary_allocator));
+  }
+  client->delete_object("bucket", "replaced");
+  client->delete_object("bucket", "replaced_offset");
+  client->delete_object("bucket", "replaced_wal");
+  std::remove("/tmp/base_image_replace_test/partition");
+  std::remove("/tmp/base_image_replace_test/partition_offset");
+  std::remove("/tmp/base_image_replace_test/partition_wal");
+}
@@ -1,8 +1,10 @@
 #include "catch.hpp"
+#include "test_utils.h"
 #include "jiffy/storage/shared_log/shared_log_defs.h"
 #include "jiffy/storage/shared_log/shared_log_partition.h"
 #include <vector>
 #include <string>
+#include <fstream>
 
 using namespace ::jiffy::storage;
 using namespace ::jiffy::persistent;
@@ -55,6 +57,7 @@ TEST_CASE("shared_log_write_trim_scan_test", "[write][trim][scan]") {
 }
 
 TEST_CASE("shared_log_flush_load_test", "[write][sync][reset][load][scan]") {
+  temp_directory dir;
   block_memory_manager manager;
   shared_log_partition block(&manager);
   std::size_t offset = 0;
@@ -64,14 +67,40 @@ TEST_CASE("shared_log_flush_load_test", "[write][sync][reset][load][scan]") {
     REQUIRE(res.front() == "!ok");
   }
   REQUIRE(block.is_dirty());
-  REQUIRE(block.sync("local://tmp/test"));
+  REQUIRE(block.sync(dir.local_path("test")));
   REQUIRE(!block.is_dirty());
-  REQUIRE_FALSE(block.sync("local://tmp/test"));
-  REQUIRE_NOTHROW(block.load("local://tmp/test"));
+  REQUIRE_FALSE(block.sync(dir.local_path("test")));
+  REQUIRE_NOTHROW(block.load(dir.local_path("test")));
   for (std::size_t start_pos = 0; start_pos < 8; ++start_pos) {
     response resp;
     REQUIRE_NOTHROW(block.scan(resp, {"scan", std::to_string(start_pos), std::to_string(start_pos + 2), std::to_string(start_pos)+"_stream"}));
     REQUIRE(resp[0] == "!ok");
     REQUIRE(resp[1] == std::to_string(start_pos)+"_data");
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("shared_log_delta_sync_load_test", "[write][sync][load][scan]") {
+  temp_directory dir;
+  block_memory_manager manager;
+  shared_log_partition block(&manager);
+  for (std::size_t i = 0; i < 10; ++i) {
+    std::vector<std::string> res;
+    block.run_command(res, {"write", std::to_string(i), std::to_string(i) + "_data", std::to_string(i) + "_stream"});
+    REQUIRE(res.front() == "!ok");
+  }
+  REQUIRE(block.sync(dir.local_path("test")));
+  std::vector<std::string> res;
+  block.run_command(res, {"write", "10", "10_data", "10_stream"});
+  REQUIRE(res.front() == "!ok");
+  REQUIRE(block.sync(dir.local_path("test")));
+  REQUIRE(std::ifstream(dir.path("test_delta_1")).good());
+
+  shared_log_partition loaded(&manager);
+  REQUIRE_NOTHROW(loaded.load(dir.local_path("test")));
+  for (std::size_t pos = 0; pos <= 10; ++pos) {
+    response resp;
+    REQUIRE_NOTHROW(loaded.scan(resp, {"scan", std::to_string(pos), std::to_string(pos), std::to_string(pos) + "_stream"}));
+    REQUIRE(resp[0] == "!ok");
+    REQUIRE(resp[1] == std::to_string(pos) + "_data");
+  }
+}
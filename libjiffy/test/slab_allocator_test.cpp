@@ -0,0 +1,113 @@
+#include "catch.hpp"
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "jiffy/storage/block_memory_manager.h"
+#include "jiffy/storage/slab_allocator.h"
+
+using namespace ::jiffy::storage;
+
+TEST_CASE("slab_allocator_size_class_test", "[slab]") {
+  REQUIRE(slab_allocator::class_size(0) == 16);
+  REQUIRE(slab_allocator::class_size(slab_allocator::NUM_CLASSES - 1) == slab_allocator::MAX_SLAB_SIZE);
+  for (std::size_t size = 1; size <= slab_allocator::MAX_SLAB_SIZE; ++size) {
+    auto cls = slab_allocator::size_class(size);
+    REQUIRE(cls < slab_allocator::NUM_CLASSES);
+    REQUIRE(slab_allocator::class_size(cls) >= size);
+    if (cls > 0) {
+      REQUIRE(slab_allocator::class_size(cls - 1) < size);
+    }
+  }
+}
+
+TEST_CASE("slab_allocator_alloc_free_test", "[slab]") {
+  slab_allocator slab;
+  std::vector<std::pair<char *, std::size_t>> ptrs;
+  for (std::size_t i = 0; i < 10000; ++i) {
+    auto size = 1 + (i * 37) % slab_allocator::MAX_SLAB_SIZE;
+    auto ptr = static_cast<char *>(slab.allocate(size));
+    REQUIRE(ptr != nullptr);
+    REQUIRE(slab.allocation_size(ptr) == slab_allocator::class_size(slab_allocator::size_class(size)));
+    std::memset(ptr, static_cast<int>(i), size);
+    ptrs.emplace_back(ptr, size);
+  }
+  for (std::size_t i = 0; i < ptrs.size(); ++i) {
+    REQUIRE(ptrs[i].first[ptrs[i].second - 1] == static_cast<char>(i));
+  }
+  auto reserved = slab.reserved();
+  for (const auto &p : ptrs) {
+    slab.deallocate(p.first, p.second);
+  }
+  // Freed objects are reused
+  for (const auto &p : ptrs) {
+    REQUIRE(slab.allocate(p.second) != nullptr);
+  }
+  REQUIRE(slab.reserved() == reserved);
+  int x;
+  REQUIRE(slab.allocation_size(&x) == 0);
+  slab.release();
+  REQUIRE(slab.reserved() == 0);
+}
+
+TEST_CASE("slab_allocator_cross_thread_free_test", "[slab]") {
+  slab_allocator slab;
+  std::vector<void *> ptrs;
+  for (std::size_t i = 0; i < 4096; ++i) {
+    ptrs.push_back(slab.allocate(64));
+  }
+  std::thread t([&slab, &ptrs] {
+    for (auto ptr : ptrs) {
+      slab.deallocate(ptr, 64);
+    }
+  });
+  t.join();
+  auto reserved = slab.reserved();
+  for (std::size_t i = 0; i < 4096; ++i) {
+    REQUIRE(slab.allocate(64) != nullptr);
+  }
+  REQUIRE(slab.reserved() == reserved);
+}
+
+TEST_CASE("slab_allocator_many_allocators_test", "[slab]") {
+  // More allocators than a thread used to cache at once, interleaved and destroyed in between
+  std::vector<std::unique_ptr<slab_allocator>> slabs;
+  for (std::size_t i = 0; i < 64; ++i) {
+    slabs.emplace_back(new slab_allocator());
+  }
+  for (std::size_t round = 0; round < 4; ++round) {
+    for (auto &slab : slabs) {
+      std::vector<void *> ptrs;
+      for (std::size_t i = 0; i < 1024; ++i) {
+        ptrs.push_back(slab->allocate(64));
+        REQUIRE(ptrs.back() != nullptr);
+      }
+      for (auto ptr : ptrs) {
+        slab->deallocate(ptr, 64);
+      }
+    }
+    for (auto &slab : slabs) {
+      REQUIRE(slab->reserved() == slab_allocator::CHUNK_SIZE);
+    }
+    slabs[round].reset(new slab_allocator());
+  }
+}
+
+TEST_CASE("block_memory_manager_slab_accounting_test", "[slab]") {
+  block_memory_manager manager(134217728, "DRAM", nullptr, "slab");
+  auto small_size = slab_allocator::class_size(slab_allocator::size_class(100));
+  auto small = manager.mb_malloc(100);
+  auto large = manager.mb_malloc(10000);
+  REQUIRE(manager.mb_used() == small_size + 10000);
+  REQUIRE(manager.mb_reserved() == slab_allocator::CHUNK_SIZE);
+  manager.mb_free(small, 100);
+  manager.mb_free(large, 10000);
+  REQUIRE(manager.mb_used() == 0);
+  // Frees without a size account for the same size class
+  manager.mb_free(manager.mb_malloc(100));
+  REQUIRE(manager.mb_used() == 0);
+  manager.mb_release();
+  REQUIRE(manager.mb_reserved() == 0);
+  REQUIRE(manager.mb_malloc(100) != nullptr);
+  REQUIRE(manager.mb_used() == small_size);
+}
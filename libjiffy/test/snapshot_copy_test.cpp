@@ -0,0 +1,40 @@
+#include "catch.hpp"
+#include <vector>
+#include "jiffy/storage/snapshot_copy.h"
+
+using namespace ::jiffy::storage;
+
+TEST_CASE("snapshot_copy_preserve_test", "[snapshot]") {
+  snapshot_copy copy;
+  std::vector<int> copies(8, 0);
+  REQUIRE_FALSE(copy.active());
+  copy.start(copies.size(), [&copies](std::size_t unit) { ++copies[unit]; });
+  REQUIRE(copy.active());
+
+  copy.preserve(2, 4);
+  copy.preserve(3, 100);
+  copy.preserve_bytes(10, 1, 8);
+  REQUIRE(copies == std::vector<int>({0, 1, 1, 1, 1, 1, 1, 1}));
+  REQUIRE(copy.active());
+
+  REQUIRE(copy.copy_next());
+  REQUIRE_FALSE(copy.active());
+  REQUIRE_FALSE(copy.copy_next());
+  copy.preserve_all();
+  REQUIRE(copies == std::vector<int>(8, 1));
+}
+
+TEST_CASE("snapshot_copy_copy_next_test", "[snapshot]") {
+  snapshot_copy copy;
+  std::vector<std::size_t> order;
+  copy.start(4, [&order](std::size_t unit) { order.push_back(unit); });
+  copy.preserve(2, 3);
+  while (copy.copy_next()) {}
+  REQUIRE(order == std::vector<std::size_t>({2, 0, 1, 3}));
+  REQUIRE_FALSE(copy.active());
+
+  copy.start(0, [&order](std::size_t unit) { order.push_back(unit); });
+  REQUIRE_FALSE(copy.active());
+  copy.preserve_all();
+  REQUIRE(order.size() == 4);
+}
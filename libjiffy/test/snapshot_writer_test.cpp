@@ -0,0 +1,75 @@
+#include "catch.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "jiffy/persistent/snapshot_writer.h"
+
+using namespace ::jiffy::persistent;
+
+TEST_CASE("snapshot_writer_order_test", "[snapshot]") {
+  snapshot_writer writer;
+  auto status = std::make_shared<snapshot_status>();
+  std::mutex mtx;
+  std::vector<int> order;
+  std::uint64_t ticket = 0;
+  for (int i = 0; i < 100; ++i) {
+    ticket = writer.submit(status, 0, [&mtx, &order, i] {
+      std::lock_guard<std::mutex> lock(mtx);
+      order.push_back(i);
+    });
+  }
+  REQUIRE(status->last_ticket() == ticket);
+  writer.wait(ticket);
+  REQUIRE(order.size() == 100);
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE(order[i] == i);
+  }
+  REQUIRE(status->take_error() == nullptr);
+  REQUIRE_FALSE(status->take_failure());
+}
+
+TEST_CASE("snapshot_writer_failure_test", "[snapshot]") {
+  snapshot_writer writer;
+  auto status = std::make_shared<snapshot_status>();
+  std::atomic<bool> ran(false);
+  writer.submit(status, 0, [] { throw std::runtime_error("write failed"); });
+  // A failed job does not stop the jobs after it
+  writer.submit(status, 0, [&ran] { ran = true; });
+  writer.wait_all();
+  REQUIRE(ran);
+
+  auto error = status->take_error();
+  REQUIRE(error != nullptr);
+  REQUIRE_THROWS_AS(std::rethrow_exception(error), std::runtime_error);
+  REQUIRE(status->take_error() == nullptr);
+  REQUIRE(status->take_failure());
+  REQUIRE_FALSE(status->take_failure());
+}
+
+TEST_CASE("snapshot_writer_rate_limit_test", "[snapshot]") {
+  snapshot_writer writer(1024 * 1024);
+  auto status = std::make_shared<snapshot_status>();
+  auto start = std::chrono::steady_clock::now();
+  // The first job starts right away, each later one waits for the bytes of the one before
+  for (int i = 0; i < 5; ++i) {
+    writer.submit(status, 64 * 1024, [] {});
+  }
+  writer.wait_all();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  REQUIRE(elapsed >= std::chrono::milliseconds(240));
+}
+
+TEST_CASE("snapshot_writer_flush_test", "[snapshot]") {
+  std::atomic<int> num_done(0);
+  {
+    snapshot_writer writer(1);
+    auto status = std::make_shared<snapshot_status>();
+    for (int i = 0; i < 10; ++i) {
+      writer.submit(status, 1024, [&num_done] { ++num_done; });
+    }
+  }
+  // Queued jobs run at full speed once the writer is destroyed
+  REQUIRE(num_done == 10);
+}
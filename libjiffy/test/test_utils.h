@@ -5,6 +5,10 @@
 #include <vector>
 #include <iostream>
 #include <limits.h>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <ftw.h>
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/TSocket.h>
 #include "jiffy/storage/storage_management_ops.h"
@@ -47,6 +51,14 @@ class dummy_storage_manager : public jiffy::storage::storage_management_ops {
     COMMANDS.push_back("destroy_partition:" + block_name);
   }
 
+  void freeze_partition(const std::string &block_name) override {
+    COMMANDS.push_back("freeze_partition:" + block_name);
+  }
+
+  void thaw_partition(const std::string &block_name) override {
+    COMMANDS.push_back("thaw_partition:" + block_name);
+  }
+
   std::string path(const std::string &block_id) override {
     COMMANDS.push_back("path:" + block_id);
     return "";
@@ -190,6 +202,51 @@ class dummy_block_allocator : public jiffy::directory::block_allocator {
   std::size_t num_free_{};
 };
 
+/* Fresh directory under /tmp, removed with everything in it when the object goes out of scope */
+class temp_directory {
+ public:
+  temp_directory() {
+    char path[] = "/tmp/jiffy_test_XXXXXX";
+    if (mkdtemp(path) == nullptr) {
+      throw std::runtime_error("Could not create temporary directory");
+    }
+    path_ = path;
+  }
+
+  ~temp_directory() {
+    nftw(path_.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+  }
+
+  temp_directory(const temp_directory &) = delete;
+  temp_directory &operator=(const temp_directory &) = delete;
+
+  /**
+   * Fetch the path of a file in the directory
+   * @param name File name
+   * @return File path
+   */
+  std::string path(const std::string &name) const {
+    return path_ + "/" + name;
+  }
+
+  /**
+   * Fetch the persistent storage path of a file in the directory
+   * @param name File name
+   * @return Persistent storage path
+   */
+  std::string local_path(const std::string &name) const {
+    return "local:/" + path(name);
+  }
+
+ private:
+  static int remove_entry(const char *path, const struct stat *, int, struct FTW *) {
+    return std::remove(path);
+  }
+
+  /* Directory path */
+  std::string path_;
+};
+
 class test_utils {
  public:
   static void wait_till_server_ready(const std::string &host, int port) {
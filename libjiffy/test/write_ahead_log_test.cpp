@@ -0,0 +1,177 @@
+#include "catch.hpp"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "jiffy/persistent/write_ahead_log.h"
+
+using namespace ::jiffy::persistent;
+
+static const std::string WAL_TEST_DIR = "/tmp/write_ahead_log_test";
+
+static std::vector<write_ahead_log::record_type> replay_all(write_ahead_log &log) {
+  std::vector<write_ahead_log::record_type> records;
+  log.replay([&records](const write_ahead_log::record_type &r) { records.push_back(r); });
+  return records;
+}
+
+TEST_CASE("write_ahead_log_append_replay_test", "[append][replay]") {
+  {
+    write_ahead_log log(WAL_TEST_DIR, "local://tmp:0_65536");
+    REQUIRE(log.name() == "local://tmp:0_65536");
+    std::uint64_t lsn = 0;
+    for (std::size_t i = 0; i < 100; ++i) {
+      lsn = log.append({"put", std::to_string(i), std::string(i, 'v')});
+      REQUIRE(lsn == i + 1);
+    }
+    log.wait_durable(lsn);
+    REQUIRE(log.append({"remove", "0"}) == 101);
+    REQUIRE(log.append({}) == 102);
+  }
+
+  {
+    write_ahead_log log(WAL_TEST_DIR, "local://tmp:0_65536");
+    auto records = replay_all(log);
+    REQUIRE(records.size() == 102);
+    for (std::size_t i = 0; i < 100; ++i) {
+      REQUIRE(records[i] == write_ahead_log::record_type({"put", std::to_string(i), std::string(i, 'v')}));
+    }
+    REQUIRE(records[100] == write_ahead_log::record_type({"remove", "0"}));
+    REQUIRE(records[101].empty());
+
+    // Records of this instance are only replayed by the next one
+    log.wait_durable(log.append({"put", "a", "b"}));
+    REQUIRE(replay_all(log).size() == 102);
+  }
+
+  {
+    write_ahead_log log(WAL_TEST_DIR, "local://tmp:0_65536");
+    REQUIRE(replay_all(log).size() == 103);
+    // Logs with other names are not replayed
+    write_ahead_log other(WAL_TEST_DIR, "local://tmp:65536_131072");
+    REQUIRE(replay_all(other).empty());
+    log.remove();
+  }
+
+  write_ahead_log log(WAL_TEST_DIR, "local://tmp:0_65536");
+  REQUIRE(replay_all(log).empty());
+}
+
+TEST_CASE("write_ahead_log_when_durable_test", "[append][flush]") {
+  write_ahead_log log(WAL_TEST_DIR, "when_durable");
+  std::atomic<std::size_t> num_durable(0);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    auto lsn = log.append({"put", std::to_string(i), std::to_string(i)});
+    log.when_durable(lsn, [&num_durable] { ++num_durable; });
+  }
+  log.flush();
+  REQUIRE(num_durable.load() == 1000);
+
+  // Callbacks for durable records run at once
+  bool called = false;
+  log.when_durable(1000, [&called] { called = true; });
+  REQUIRE(called);
+
+  // Removing the log releases waiters
+  auto lsn = log.append({"put", "a", "b"});
+  log.remove();
+  log.wait_durable(lsn);
+  called = false;
+  log.when_durable(lsn, [&called] { called = true; });
+  REQUIRE(called);
+}
+
+TEST_CASE("write_ahead_log_rotate_truncate_test", "[rotate][truncate]") {
+  {
+    write_ahead_log log(WAL_TEST_DIR, "rotate");
+    log.append({"put", "1", "1"});
+    auto sealed = log.rotate();
+    log.wait_durable(log.append({"put", "2", "2"}));
+    // A snapshot taken at the rotation holds the first record
+    write_ahead_log::truncate(WAL_TEST_DIR, "rotate", sealed);
+  }
+  write_ahead_log log(WAL_TEST_DIR, "rotate");
+  auto records = replay_all(log);
+  REQUIRE(records.size() == 1);
+  REQUIRE(records[0] == write_ahead_log::record_type({"put", "2", "2"}));
+  log.remove();
+}
+
+TEST_CASE("write_ahead_log_torn_record_test", "[replay]") {
+  std::string first_segment;
+  {
+    write_ahead_log log(WAL_TEST_DIR, "torn");
+    log.append({"put", "1", "1"});
+    log.wait_durable(log.append({"put", "2", "2"}));
+    log.rotate();
+    log.wait_durable(log.append({"put", "3", "3"}));
+    first_segment = WAL_TEST_DIR + "/torn.wal.1";
+  }
+  {
+    // A crash in the middle of a write leaves part of a record behind
+    std::ofstream out(first_segment, std::ios::binary | std::ios::app);
+    std::uint32_t size = 64;
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    out.write("partial", 7);
+  }
+  {
+    write_ahead_log log(WAL_TEST_DIR, "torn");
+    auto records = replay_all(log);
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[1] == write_ahead_log::record_type({"put", "2", "2"}));
+  }
+  {
+    // The torn record and the records after it were discarded
+    write_ahead_log log(WAL_TEST_DIR, "torn");
+    REQUIRE(replay_all(log).size() == 2);
+    log.remove();
+  }
+}
+
+TEST_CASE("write_ahead_log_covered_segment_test", "[rotate][replay]") {
+  std::uint64_t sealed;
+  {
+    write_ahead_log log(WAL_TEST_DIR, "covered");
+    log.append({"put", "1", "1"});
+    sealed = log.rotate();
+    log.wait_durable(log.append({"put", "2", "2"}));
+    // A crash after the snapshot landed, before it truncated the log
+  }
+  {
+    write_ahead_log log(WAL_TEST_DIR, "covered", sealed + 1);
+    std::vector<write_ahead_log::record_type> records;
+    log.replay([&records](const write_ahead_log::record_type &r) { records.push_back(r); }, sealed);
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0] == write_ahead_log::record_type({"put", "2", "2"}));
+    log.remove();
+  }
+  // Segments of a log whose segments were all removed stay above the covered ones
+  write_ahead_log log(WAL_TEST_DIR, "covered", sealed + 5);
+  REQUIRE(log.segment() == sealed + 5);
+  log.remove();
+}
+
+TEST_CASE("write_ahead_log_callback_exception_test", "[append][flush]") {
+  write_ahead_log log(WAL_TEST_DIR, "callback_exception");
+  std::atomic<std::size_t> num_durable(0);
+  for (std::size_t i = 0; i < 10; ++i) {
+    auto lsn = log.append({"put", std::to_string(i), std::to_string(i)});
+    try {
+      log.when_durable(lsn, [i, &num_durable] {
+        ++num_durable;
+        if (i % 2 == 0) {
+          throw std::runtime_error("callback failed");
+        }
+      });
+    } catch (std::runtime_error &) {
+      // Callbacks of records that are durable already run, and throw, on the calling thread
+    }
+  }
+  log.flush();
+  REQUIRE(num_durable.load() == 10);
+  // The flusher keeps running
+  log.wait_durable(log.append({"put", "a", "b"}));
+  log.remove();
+}
@@ -5,9 +5,14 @@
 #include <jiffy/storage/manager/storage_management_server.h>
 #include <jiffy/auto_scaling/auto_scaling_server.h>
 #include <jiffy/storage/service/block_server.h>
+#include <jiffy/persistent/io_engine.h>
+#include <jiffy/persistent/object_store.h>
+#include <jiffy/persistent/snapshot_writer.h>
+#include <jiffy/persistent/write_ahead_log.h>
 #include <jiffy/utils/signal_handling.h>
 #include <jiffy/utils/logger.h>
 #include <jiffy/utils/mem_utils.h>
+#include <jiffy/utils/numa_utils.h>
 #include <boost/program_options.hpp>
 #include <ifaddrs.h>
 #include "server_storage_tracker.h"
@@ -76,6 +81,22 @@ int main(int argc, char **argv) {
   std::size_t block_capacity = 134217728;
   double blk_thresh_lo = 0.25;
   double blk_thresh_hi = 0.75;
+  std::string blk_allocator = "default";
+  std::string blk_huge_pages = "none";
+  bool blk_numa_aware = false;
+  std::string server_engine = "thrift";
+  std::size_t server_num_threads = 1;
+  std::string io_engine = "auto";
+  std::size_t io_num_threads = 4;
+  std::size_t io_queue_depth = 256;
+  std::size_t snapshot_rate_limit = 0;
+  std::string object_store_endpoint = "";
+  std::size_t object_store_part_size = 8388608;
+  std::size_t object_store_num_threads = 8;
+  std::string object_store_staging_dir = "/tmp";
+  std::string wal_dir = "/tmp/jiffy_wal";
+  std::size_t wal_fsync_delay_us = 0;
+  std::size_t wal_fsync_batch_bytes = 1048576;
   std::string storage_trace = "";
   try {
     namespace po = boost::program_options;
@@ -107,7 +128,23 @@ int main(int argc, char **argv) {
          po::value<size_t>(&num_block_groups)->default_value(std::thread::hardware_concurrency() / 2))
         ("storage.block.capacity", po::value<size_t>(&block_capacity)->default_value(134217728))
         ("storage.block.capacity_threshold_lo", po::value<double>(&blk_thresh_lo)->default_value(0.25))
-        ("storage.block.capacity_threshold_hi", po::value<double>(&blk_thresh_hi)->default_value(0.75));
+        ("storage.block.capacity_threshold_hi", po::value<double>(&blk_thresh_hi)->default_value(0.75))
+        ("storage.block.allocator", po::value<std::string>(&blk_allocator)->default_value("default"))
+        ("storage.block.huge_pages", po::value<std::string>(&blk_huge_pages)->default_value("none"))
+        ("storage.block.numa_aware", po::value<bool>(&blk_numa_aware)->default_value(false))
+        ("storage.server.engine", po::value<std::string>(&server_engine)->default_value("thrift"))
+        ("storage.server.num_threads", po::value<size_t>(&server_num_threads)->default_value(1))
+        ("storage.io.engine", po::value<std::string>(&io_engine)->default_value("auto"))
+        ("storage.io.num_threads", po::value<size_t>(&io_num_threads)->default_value(4))
+        ("storage.io.queue_depth", po::value<size_t>(&io_queue_depth)->default_value(256))
+        ("storage.snapshot.rate_limit", po::value<size_t>(&snapshot_rate_limit)->default_value(0))
+        ("storage.object_store.endpoint", po::value<std::string>(&object_store_endpoint)->default_value(""))
+        ("storage.object_store.part_size", po::value<size_t>(&object_store_part_size)->default_value(8388608))
+        ("storage.object_store.num_threads", po::value<size_t>(&object_store_num_threads)->default_value(8))
+        ("storage.object_store.staging_dir", po::value<std::string>(&object_store_staging_dir)->default_value("/tmp"))
+        ("storage.wal.dir", po::value<std::string>(&wal_dir)->default_value("/tmp/jiffy_wal"))
+        ("storage.wal.fsync_delay_us", po::value<size_t>(&wal_fsync_delay_us)->default_value(0))
+        ("storage.wal.fsync_batch_bytes", po::value<size_t>(&wal_fsync_batch_bytes)->default_value(1048576));
 
     po::options_description cmdline_options, env_options;
     cmdline_options.add(generic).add(hidden);
@@ -168,6 +205,22 @@ int main(int argc, char **argv) {
     LOG(log_level::info) << "storage.block.capacity: " << block_capacity;
     LOG(log_level::info) << "storage.block.capacity_threshold_lo: " << blk_thresh_lo;
     LOG(log_level::info) << "storage.block.capacity_threshold_hi: " << blk_thresh_hi;
+    LOG(log_level::info) << "storage.block.allocator: " << blk_allocator;
+    LOG(log_level::info) << "storage.block.huge_pages: " << blk_huge_pages;
+    LOG(log_level::info) << "storage.block.numa_aware: " << blk_numa_aware;
+    LOG(log_level::info) << "storage.server.engine: " << server_engine;
+    LOG(log_level::info) << "storage.server.num_threads: " << server_num_threads;
+    LOG(log_level::info) << "storage.io.engine: " << io_engine;
+    LOG(log_level::info) << "storage.io.num_threads: " << io_num_threads;
+    LOG(log_level::info) << "storage.io.queue_depth: " << io_queue_depth;
+    LOG(log_level::info) << "storage.snapshot.rate_limit: " << snapshot_rate_limit;
+    LOG(log_level::info) << "storage.object_store.endpoint: " << object_store_endpoint;
+    LOG(log_level::info) << "storage.object_store.part_size: " << object_store_part_size;
+    LOG(log_level::info) << "storage.object_store.num_threads: " << object_store_num_threads;
+    LOG(log_level::info) << "storage.object_store.staging_dir: " << object_store_staging_dir;
+    LOG(log_level::info) << "storage.wal.dir: " << wal_dir;
+    LOG(log_level::info) << "storage.wal.fsync_delay_us: " << wal_fsync_delay_us;
+    LOG(log_level::info) << "storage.wal.fsync_batch_bytes: " << wal_fsync_batch_bytes;
     LOG(log_level::info) << "directory.host: " << dir_host;
     LOG(log_level::info) << "directory.service_port: " << dir_port;
     LOG(log_level::info) << "directory.block_port: " << block_port;
@@ -194,6 +247,34 @@ int main(int argc, char **argv) {
     block_ids.push_back(block_id_parser::make(hostname, service_port + i % num_block_groups, mgmt_port, i));
   }
 
+  try {
+    ::jiffy::persistent::io_engine::configure(io_engine, io_num_threads, io_queue_depth);
+    LOG(log_level::info) << "I/O engine: " << ::jiffy::persistent::io_engine::instance()->name();
+    ::jiffy::persistent::snapshot_writer::configure(snapshot_rate_limit);
+    ::jiffy::persistent::object_client::configure(object_store_endpoint,
+                                                  object_store_part_size,
+                                                  object_store_num_threads,
+                                                  object_store_staging_dir);
+    ::jiffy::persistent::write_ahead_log::configure(wal_dir, wal_fsync_delay_us, wal_fsync_batch_bytes);
+  } catch (std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  // Each block group is bound to a NUMA node, round-robin over the nodes
+  std::vector<int> group_nodes(num_block_groups, -1);
+  if (blk_numa_aware) {
+    auto nodes = numa_utils::nodes();
+    if (nodes.size() > 1) {
+      for (size_t i = 0; i < num_block_groups; ++i) {
+        group_nodes[i] = nodes[i % nodes.size()];
+      }
+      LOG(log_level::info) << "Binding " << num_block_groups << " block groups to " << nodes.size() << " NUMA nodes";
+    } else {
+      LOG(log_level::info) << "Single NUMA node, block groups are not bound";
+    }
+  }
+
   std::vector<std::shared_ptr<block>> blocks;
   blocks.resize(num_blocks);
 
@@ -201,7 +282,15 @@ int main(int argc, char **argv) {
 
   for (size_t i = 0; i < blocks.size(); ++i) {
     blocks[i] =
-        std::make_shared<block>(block_ids[i], block_capacity, memory_mode, mem_kind, address, auto_scaling_port);
+        std::make_shared<block>(block_ids[i],
+                                block_capacity,
+                                memory_mode,
+                                mem_kind,
+                                address,
+                                auto_scaling_port,
+                                blk_allocator,
+                                blk_huge_pages,
+                                group_nodes[i % num_block_groups]);
   }
   LOG(log_level::info) << "Created " << blocks.size() << " blocks";
 
@@ -251,9 +340,13 @@ int main(int argc, char **argv) {
     auto block_group = std::vector < std::shared_ptr < block >> ();
     for (size_t j = i; j < num_blocks; j += num_block_groups)
       block_group.push_back(blocks[j]);
-    storage_server[i] = block_server::create(block_group, service_port + i);
+    storage_server[i] = block_server::create(block_group, service_port + i, server_num_threads, server_engine);
     storage_serve_thread[i] =
-        std::thread([&storage_exception, &storage_server, &failing_thread, &failure_condition, i] {
+        std::thread([&storage_exception, &storage_server, &failing_thread, &failure_condition, &group_nodes, i] {
+          // The server's I/O threads are created by this thread and inherit its affinity
+          if (group_nodes[i] >= 0 && numa_utils::set_self_node_affinity(group_nodes[i]) != 0) {
+            LOG(log_level::warn) << "Could not pin block group " << i << " to NUMA node " << group_nodes[i];
+          }
           try {
             storage_server[i]->serve();
           } catch (...) {
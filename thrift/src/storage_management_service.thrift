@@ -15,6 +15,12 @@ service storage_management_service {
   void destroy_partition(1: i32 block_id)
       throws (1: storage_management_exception ex),
 
+  void freeze_partition(1: i32 block_id)
+      throws (1: storage_management_exception ex),
+
+  void thaw_partition(1: i32 block_id)
+      throws (1: storage_management_exception ex),
+
   string get_path(1: i32 block_id)
     throws (1: storage_management_exception ex),
 